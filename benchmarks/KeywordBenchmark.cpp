@@ -0,0 +1,108 @@
+// Keyword recognition: the original uppercase-copy + substring search
+// against the RadKeywords lookup used by RadFileReader.
+#include "io/RadKeywords.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace OpenRadiossGUI;
+
+namespace {
+
+// Verbatim copy of the previous RadFileReader::determineSection
+int LegacyDetermineSection(const std::string& line) {
+    std::string upperLine = line;
+    std::transform(upperLine.begin(), upperLine.end(), upperLine.begin(), ::toupper);
+    
+    if (upperLine.find("/TITLE") != std::string::npos) return 1;
+    if (upperLine.find("/NODE") != std::string::npos) return 2;
+    if (upperLine.find("/CNODE") != std::string::npos) return 2;
+    if (upperLine.find("/BRICK") != std::string::npos) return 3;
+    if (upperLine.find("/HEXA") != std::string::npos) return 3;
+    if (upperLine.find("/TETRA4") != std::string::npos) return 3;
+    if (upperLine.find("/TETRA10") != std::string::npos) return 3;
+    if (upperLine.find("/SHELL") != std::string::npos) return 3;
+    if (upperLine.find("/SH3N") != std::string::npos) return 3;
+    if (upperLine.find("/QUAD") != std::string::npos) return 3;
+    if (upperLine.find("/TRIA") != std::string::npos) return 3;
+    if (upperLine.find("/MAT") != std::string::npos) return 4;
+    if (upperLine.find("/PROP") != std::string::npos) return 5;
+    if (upperLine.find("/PART") != std::string::npos) return 5;
+    if (upperLine.find("/LOAD") != std::string::npos) return 6;
+    if (upperLine.find("/CLOAD") != std::string::npos) return 6;
+    if (upperLine.find("/PLOAD") != std::string::npos) return 6;
+    if (upperLine.find("/BCS") != std::string::npos) return 7;
+    if (upperLine.find("/SPC") != std::string::npos) return 7;
+    if (upperLine.find("/IMPVEL") != std::string::npos) return 7;
+    
+    return 0;
+}
+
+int DispatchDetermineSection(std::string_view line) {
+    KeywordPath path;
+    if (!parseKeywordPath(line, path)) return 0;
+    return path.info ? static_cast<int>(path.info->section) + 1 : 0;
+}
+
+// Deck-like mix: one keyword line per 1000 data lines
+std::vector<std::string> MakeLines() {
+    static const char* keywords[] = {"/NODE", "/SHELL/1", "/MAT/LAW2/3", "/PROP/SHELL/1",
+                                     "/BRICK/2", "/SH3N/4", "/END"};
+    std::vector<std::string> lines;
+    char buffer[128];
+    for (int i = 0; i < 70000; ++i) {
+        if (i % 1000 == 0) {
+            lines.push_back(keywords[(i / 1000) % 7]);
+        } else if (i % 2 == 0) {
+            std::snprintf(buffer, sizeof(buffer), "%10d%20.10e%20.10e%20.10e", i, i * 0.5,
+                          i * -0.25, i * 0.125);
+            lines.push_back(buffer);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%10d%10d%10d%10d%10d", i, i + 1, i + 2,
+                          i + 3, i + 4);
+            lines.push_back(buffer);
+        }
+    }
+    return lines;
+}
+
+void BM_LegacyDetermineSection(benchmark::State& state) {
+    std::vector<std::string> lines = MakeLines();
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            benchmark::DoNotOptimize(LegacyDetermineSection(line));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_LegacyDetermineSection);
+
+void BM_KeywordDispatch(benchmark::State& state) {
+    std::vector<std::string> lines = MakeLines();
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            benchmark::DoNotOptimize(DispatchDetermineSection(line));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_KeywordDispatch);
+
+// Keyword lines only, to show the lookup itself
+void BM_KeywordLookup(benchmark::State& state) {
+    static const char* names[] = {"NODE", "shell", "MAT", "PROP", "BRICK", "SH3N", "END"};
+    for (auto _ : state) {
+        for (const char* name : names) {
+            benchmark::DoNotOptimize(findKeyword(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 7);
+}
+BENCHMARK(BM_KeywordLookup);
+
+} // namespace
+
+BENCHMARK_MAIN();
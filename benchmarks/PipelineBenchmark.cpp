@@ -0,0 +1,167 @@
+// Deck pipeline on synthetic shell, brick and tetra decks (SyntheticDeck.h):
+// reading, with its parse and validation phases on their own, writing,
+// solid skin extraction and quality metrics. Sizes are element counts,
+// --elements=N[,N...] replacing the defaults.
+#include "SyntheticDeck.h"
+#include "core/MeshQuality.h"
+#include "core/Model.h"
+#include "core/SolidSkin.h"
+#include "io/RadFileReader.h"
+#include "io/RadFileWriter.h"
+#include "utils/Logger.h"
+#include "utils/Profiler.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+size_t GetFileSize(const std::string& path) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
+
+// What the last scope of this name took, in seconds
+double GetScopeSeconds(const char* name) {
+    for (const ProfileSeries& series : Profiler::Get().GetSeries()) {
+        if (series.kind == ProfileSeries::Kind::CPU && series.name == name) {
+            return series.last * 1e-3;
+        }
+    }
+    return 0.0;
+}
+
+// loadFile as a whole, or only one of its phases, timed by its profiler
+// scope, when phase is set
+void ReadDeck(benchmark::State& state, const SyntheticDeckSpec& spec, const char* phase) {
+    const std::string path = GetSyntheticDeck(spec);
+    if (path.empty()) {
+        state.SkipWithError("Cannot write the synthetic deck");
+        return;
+    }
+    
+    size_t elements = 0;
+    for (auto _ : state) {
+        auto reader = std::make_unique<OpenRadiossGUI::RadFileReader>();
+        if (!reader->loadFile(path)) {
+            state.SkipWithError(reader->getLastError().c_str());
+            return;
+        }
+        elements = reader->getElementCount();
+        if (phase) {
+            state.SetIterationTime(GetScopeSeconds(phase));
+        }
+        state.PauseTiming();
+        reader.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * elements);
+    state.SetBytesProcessed(state.iterations() * GetFileSize(path));
+}
+
+void WriteDeck(benchmark::State& state, const SyntheticDeckSpec& spec) {
+    Model* model = GetSyntheticModel(spec);
+    if (!model) {
+        state.SkipWithError("Cannot load the synthetic deck");
+        return;
+    }
+    
+    const std::string path = GetSyntheticDeck(spec) + ".written";
+    for (auto _ : state) {
+        RadFileWriter writer(model);
+        if (!writer.Write(path)) {
+            state.SkipWithError("Cannot write the deck");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * model->GetElementCount());
+    state.SetBytesProcessed(state.iterations() * GetFileSize(path));
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+void BuildSkin(benchmark::State& state, const SyntheticDeckSpec& spec) {
+    const Model* model = GetSyntheticModel(spec);
+    if (!model) {
+        state.SkipWithError("Cannot load the synthetic deck");
+        return;
+    }
+    
+    size_t faces = 0;
+    for (auto _ : state) {
+        SolidSkin skin;
+        skin.Build(*model);
+        faces = skin.GetFaces().size();
+        benchmark::DoNotOptimize(faces);
+    }
+    state.SetItemsProcessed(state.iterations() * model->GetElementCount());
+    state.counters["faces"] = static_cast<double>(faces);
+}
+
+void EvaluateQuality(benchmark::State& state, const SyntheticDeckSpec& spec) {
+    const Model* model = GetSyntheticModel(spec);
+    if (!model) {
+        state.SkipWithError("Cannot load the synthetic deck");
+        return;
+    }
+    
+    MeshQuality quality;
+    for (auto _ : state) {
+        quality.Evaluate(*model);
+        benchmark::DoNotOptimize(quality.GetEvaluatedCount());
+    }
+    state.SetItemsProcessed(state.iterations() * model->GetElementCount());
+}
+
+void RegisterSuites(const std::vector<size_t>& counts) {
+    for (SyntheticMesh mesh : {SyntheticMesh::SHELL, SyntheticMesh::BRICK, SyntheticMesh::TETRA}) {
+        for (size_t count : counts) {
+            SyntheticDeckSpec spec;
+            spec.mesh = mesh;
+            spec.elements = count;
+            const std::string suffix = std::string("/") + GetSyntheticMeshName(mesh) + "/" + std::to_string(count);
+            auto add = [&](const std::string& name, auto fn) {
+                return benchmark::RegisterBenchmark((name + suffix).c_str(),
+                                                    [spec, fn](benchmark::State& state) { fn(state, spec); })
+                    ->Unit(benchmark::kMillisecond);
+            };
+            
+            add("RadFileReader/Load", [](benchmark::State& state, const SyntheticDeckSpec& s) {
+                ReadDeck(state, s, nullptr);
+            })->UseRealTime();
+            add("RadFileReader/Parse", [](benchmark::State& state, const SyntheticDeckSpec& s) {
+                ReadDeck(state, s, "RadFileReader::parseFile");
+            })->UseManualTime();
+            add("RadFileReader/Validate", [](benchmark::State& state, const SyntheticDeckSpec& s) {
+                ReadDeck(state, s, "RadFileReader::validateData");
+            })->UseManualTime();
+            add("RadFileWriter/Write", WriteDeck)->UseRealTime();
+            if (mesh != SyntheticMesh::SHELL) {
+                add("SolidSkin/Build", BuildSkin)->UseRealTime();
+            }
+            add("MeshQuality/Evaluate", EvaluateQuality)->UseRealTime();
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Logger::Init();
+    Logger::SetLevel(LogLevel::WARN);
+    
+    RegisterSuites(TakeElementCounts(argc, argv, {250000, 1000000}));
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,24 @@
+// Writes a synthetic deck, the same one the benchmarks read:
+//   rad_generator <shell|brick|tetra> <elements> <output.rad> [parts] [seed]
+#include "SyntheticDeck.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv) {
+    SyntheticDeckSpec spec;
+    if (argc < 4 || !ParseSyntheticMesh(argv[1], spec.mesh)) {
+        std::fprintf(stderr, "Usage: %s <shell|brick|tetra> <elements> <output.rad> [parts] [seed]\n", argv[0]);
+        return 1;
+    }
+    spec.elements = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 4) spec.parts = std::atoi(argv[4]);
+    if (argc > 5) spec.seed = std::strtoull(argv[5], nullptr, 10);
+    
+    std::string error;
+    if (!WriteSyntheticDeck(argv[3], spec, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Display side on synthetic decks (SyntheticDeck.h): building mesh
+// geometry, on the CPU and with its upload, and whole frames drawn
+// headless into a 1920x1080 framebuffer. GL suites need a GPU that EGL can
+// reach and are skipped without one; run from the repository root, where
+// shaders/ is. Sizes as in the pipeline benchmark: --elements=N[,N...].
+#include "SyntheticDeck.h"
+#include "core/Model.h"
+#include "core/SolidSkin.h"
+#include "rendering/Camera.h"
+#include "rendering/HeadlessContext.h"
+#include "rendering/Mesh.h"
+#include "rendering/Renderer.h"
+#include "utils/Logger.h"
+#include "utils/Profiler.h"
+#include <GL/glew.h>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kFrameWidth = 1920;
+constexpr int kFrameHeight = 1080;
+constexpr int kWarmupFrames = 8;   // Shader compiles, first uploads and timer queries settle
+
+HeadlessContext* g_Context = nullptr;
+
+double GetCounter(const char* name) {
+    for (const ProfileSeries& series : Profiler::Get().GetSeries()) {
+        if (series.kind == ProfileSeries::Kind::COUNTER && series.name == name) {
+            return series.last;
+        }
+    }
+    return 0.0;
+}
+
+// Color and depth renderbuffers, as BatchRenderer draws into
+class FrameTarget {
+public:
+    FrameTarget(int width, int height) {
+        glGenFramebuffers(1, &m_Framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+        glGenRenderbuffers(2, m_Renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_Renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_Renderbuffers[0]);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_Renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_Renderbuffers[1]);
+        m_Complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    
+    ~FrameTarget() {
+        glDeleteRenderbuffers(2, m_Renderbuffers);
+        glDeleteFramebuffers(1, &m_Framebuffer);
+    }
+    
+    FrameTarget(const FrameTarget&) = delete;
+    FrameTarget& operator=(const FrameTarget&) = delete;
+    
+    unsigned int GetFramebuffer() const { return m_Framebuffer; }
+    bool IsComplete() const { return m_Complete; }
+
+private:
+    unsigned int m_Framebuffer = 0;
+    unsigned int m_Renderbuffers[2] = {};
+    bool m_Complete = false;
+};
+
+// The geometry BuildFromModel uploads, without a context
+void AppendGeometry(benchmark::State& state, const SyntheticDeckSpec& spec) {
+    const Model* model = GetSyntheticModel(spec);
+    if (!model) {
+        state.SkipWithError("Cannot load the synthetic deck");
+        return;
+    }
+    SolidSkin skin;
+    skin.Build(*model);
+    skin.GetFaces();
+    
+    size_t bytes = 0;
+    for (auto _ : state) {
+        MeshData data;
+        Mesh::AppendNodes(*model, data);
+        Mesh::AppendElements(*model, 0, model->GetElementCount(), 0, data);
+        Mesh::AppendSkin(*model, skin, data);
+        bytes = data.GetByteSize();
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * model->GetElementCount());
+    state.counters["mb"] = static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void BuildMesh(benchmark::State& state, const SyntheticDeckSpec& spec) {
+    if (!g_Context) {
+        state.SkipWithError("No headless OpenGL context");
+        return;
+    }
+    Model* model = GetSyntheticModel(spec);
+    if (!model) {
+        state.SkipWithError("Cannot load the synthetic deck");
+        return;
+    }
+    SolidSkin skin;
+    skin.Build(*model);
+    skin.GetFaces();
+    
+    Mesh mesh;
+    for (auto _ : state) {
+        mesh.BuildFromModel(model, MeshLayout::SHARED_NODES, &skin);
+        glFinish();
+    }
+    state.SetItemsProcessed(state.iterations() * model->GetElementCount());
+    state.counters["gpu_mb"] = static_cast<double>(mesh.GetGpuBytes()) / (1024.0 * 1024.0);
+}
+
+// Frames as the GUI or the batch renderer draws them, each waited for
+void RenderFrames(benchmark::State& state, const SyntheticDeckSpec& spec) {
+    if (!g_Context) {
+        state.SkipWithError("No headless OpenGL context");
+        return;
+    }
+    Model* model = GetSyntheticModel(spec);
+    if (!model) {
+        state.SkipWithError("Cannot load the synthetic deck");
+        return;
+    }
+    
+    FrameTarget target(kFrameWidth, kFrameHeight);
+    if (!target.IsComplete()) {
+        state.SkipWithError("Incomplete framebuffer");
+        return;
+    }
+    std::unique_ptr<Renderer> renderer;
+    try {
+        renderer = std::make_unique<Renderer>(nullptr);
+    } catch (const std::exception& e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+    renderer->SetRenderTarget(target.GetFramebuffer(), kFrameWidth, kFrameHeight);
+    renderer->UpdateMesh(model);
+    renderer->GetCamera()->SetOrbit(-45.0f, 30.0f, renderer->GetCamera()->GetDistance());
+    
+    auto frame = [&]() {
+        renderer->BeginFrame();
+        renderer->RenderModel(model);
+        renderer->PresentScene();
+        renderer->EndFrame();
+        glFinish();
+    };
+    for (int i = 0; i < kWarmupFrames; ++i) {
+        frame();
+    }
+    for (auto _ : state) {
+        frame();
+    }
+    state.SetItemsProcessed(state.iterations() * model->GetElementCount());
+    state.counters["triangles"] = GetCounter("Triangles");
+    state.counters["draw_calls"] = GetCounter("Draw calls");
+    renderer.reset();
+}
+
+void RegisterSuites(const std::vector<size_t>& counts) {
+    for (SyntheticMesh mesh : {SyntheticMesh::SHELL, SyntheticMesh::BRICK, SyntheticMesh::TETRA}) {
+        for (size_t count : counts) {
+            SyntheticDeckSpec spec;
+            spec.mesh = mesh;
+            spec.elements = count;
+            const std::string suffix = std::string("/") + GetSyntheticMeshName(mesh) + "/" + std::to_string(count);
+            auto add = [&](const std::string& name, auto fn) {
+                return benchmark::RegisterBenchmark((name + suffix).c_str(),
+                                                    [spec, fn](benchmark::State& state) { fn(state, spec); })
+                    ->Unit(benchmark::kMillisecond)
+                    ->UseRealTime();
+            };
+            
+            add("Mesh/AppendGeometry", AppendGeometry);
+            add("Mesh/BuildFromModel", BuildMesh);
+            add("Renderer/Frame", RenderFrames);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Logger::Init();
+    Logger::SetLevel(LogLevel::WARN);
+    
+    HeadlessContext context;
+    if (context.Create()) {
+        g_Context = &context;
+    } else {
+        std::fprintf(stderr, "No headless context, GL suites are skipped: %s\n", context.GetError().c_str());
+    }
+    
+    RegisterSuites(TakeElementCounts(argc, argv, {250000, 1000000}));
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    
+    g_Context = nullptr;
+    context.Destroy();
+    Logger::Shutdown();
+    return 0;
+}
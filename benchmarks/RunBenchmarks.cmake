@@ -0,0 +1,61 @@
+# Runs the benchmarks for the benchmark_results target, each writing its
+# results as google-benchmark JSON to RESULTS_DIR/<commit>/<benchmark>.json
+# with the commit in the JSON context. A tree with local changes is
+# <commit>-dirty. Compare two runs with
+#   benchmarks/compare_results.py <results>/<old> <results>/<new>
+#
+# BENCHMARKS and DECK_BENCHMARKS are executables separated by '|'; the deck
+# ones also take ELEMENTS, when set, as --elements.
+cmake_minimum_required(VERSION 3.16)
+
+string(REPLACE "|" ";" BENCHMARKS "${BENCHMARKS}")
+string(REPLACE "|" ";" DECK_BENCHMARKS "${DECK_BENCHMARKS}")
+if(NOT REPETITIONS)
+    set(REPETITIONS 1)
+endif()
+
+execute_process(
+    COMMAND git rev-parse --short=12 HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE COMMIT
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    RESULT_VARIABLE GIT_RESULT
+    ERROR_QUIET
+)
+if(NOT GIT_RESULT EQUAL 0 OR COMMIT STREQUAL "")
+    set(COMMIT unknown)
+else()
+    execute_process(
+        COMMAND git status --porcelain --untracked-files=no
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE CHANGES
+        ERROR_QUIET
+    )
+    if(NOT CHANGES STREQUAL "")
+        string(APPEND COMMIT "-dirty")
+    endif()
+endif()
+
+set(OUTPUT_DIR ${RESULTS_DIR}/${COMMIT})
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+foreach(BENCHMARK ${BENCHMARKS} ${DECK_BENCHMARKS})
+    get_filename_component(NAME ${BENCHMARK} NAME_WE)
+    set(ARGS
+        --benchmark_out=${OUTPUT_DIR}/${NAME}.json
+        --benchmark_out_format=json
+        --benchmark_context=commit=${COMMIT}
+        --benchmark_repetitions=${REPETITIONS}
+    )
+    if(ELEMENTS AND BENCHMARK IN_LIST DECK_BENCHMARKS)
+        list(APPEND ARGS --elements=${ELEMENTS})
+    endif()
+
+    message(STATUS "Running ${NAME}")
+    execute_process(COMMAND ${BENCHMARK} ${ARGS} RESULT_VARIABLE RESULT)
+    if(NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "${NAME} failed: ${RESULT}")
+    endif()
+endforeach()
+
+message(STATUS "Results in ${OUTPUT_DIR}")
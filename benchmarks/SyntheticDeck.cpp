@@ -0,0 +1,336 @@
+#include "SyntheticDeck.h"
+#include "core/Model.h"
+#include "io/FileManager.h"
+#include "io/RadFileReader.h"
+#include "io/RecordWriter.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Part of the cached file names: bump it whenever the output changes, so
+// results from different commits never come from different decks
+constexpr int kGeneratorVersion = 1;
+
+constexpr double kCellSize = 2.0;        // mm
+constexpr double kDistortion = 0.15;     // Of a cell, on every node coordinate
+constexpr uint64_t kGapOdds = 64;        // One ID in this many starts a gap
+constexpr uint64_t kMaxGap = 32;
+
+// Tetrahedra of a hexahedral cell around its 0-6 diagonal, all positively
+// oriented, so neighbouring cells share their face diagonals
+const int kCellTetra[6][4] = {
+    {0, 1, 2, 6}, {0, 2, 3, 6}, {0, 3, 7, 6}, {0, 7, 4, 6}, {0, 4, 5, 6}, {0, 5, 1, 6},
+};
+
+// splitmix64: the same numbers on every platform, which the standard
+// distributions do not promise
+uint64_t Mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t Random(uint64_t seed, uint64_t stream, uint64_t index) {
+    return Mix(Mix(seed ^ (stream << 56)) ^ index);
+}
+
+// In [-1, 1)
+double Signed(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+// Cells of the block and how its nodes and elements are numbered. Shells
+// are one layer of nx by ny quads (nz == 0); solids are nx by ny by nz
+// hexahedra, or six tetrahedra each. Parts are runs of rows (shells) or
+// layers (solids), so every part is one run of elements.
+struct Block {
+    SyntheticMesh mesh;
+    size_t nx = 0, ny = 0, nz = 0;
+    size_t perCell = 1;
+    int parts = 1;
+    
+    size_t Rows() const { return nz ? nz : ny; }
+    size_t CellsPerRow() const { return nz ? nx * ny : nx; }
+    size_t CellCount() const { return Rows() * CellsPerRow(); }
+    size_t ElementCount() const { return CellCount() * perCell; }
+    size_t NodeCount() const { return (nx + 1) * (ny + 1) * (nz ? nz + 1 : 1); }
+    
+    // First element of a part; part == parts gives the end
+    size_t PartBegin(int part) const {
+        const size_t row = (static_cast<size_t>(part) * Rows() + parts - 1) / parts;
+        return row * CellsPerRow() * perCell;
+    }
+    
+    size_t Node(size_t i, size_t j, size_t k) const { return (k * (ny + 1) + j) * (nx + 1) + i; }
+};
+
+Block MakeBlock(const SyntheticDeckSpec& spec) {
+    Block block;
+    block.mesh = spec.mesh;
+    const size_t elements = std::max<size_t>(spec.elements, 1);
+    if (spec.mesh == SyntheticMesh::SHELL) {
+        // A panel twice as long as it is wide
+        block.nx = static_cast<size_t>(std::ceil(std::sqrt(2.0 * elements)));
+        block.ny = (elements + block.nx - 1) / block.nx;
+    } else {
+        block.perCell = spec.mesh == SyntheticMesh::TETRA ? 6 : 1;
+        const size_t cells = (elements + block.perCell - 1) / block.perCell;
+        block.nx = std::max<size_t>(static_cast<size_t>(std::cbrt(static_cast<double>(cells))), 1);
+        block.ny = block.nx;
+        block.nz = (cells + block.nx * block.ny - 1) / (block.nx * block.ny);
+    }
+    block.parts = static_cast<int>(std::clamp<size_t>(static_cast<size_t>(std::max(spec.parts, 1)), 1,
+                                                      block.Rows()));
+    return block;
+}
+
+// count IDs from first, now and then skipping a few, as renumbered decks do
+std::vector<int> MakeIds(size_t count, long long first, uint64_t seed, uint64_t stream, bool& fits) {
+    std::vector<int> ids(count);
+    long long id = first;
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t bits = Random(seed, stream, i);
+        if (bits % kGapOdds == 0) {
+            id += 1 + static_cast<long long>((bits >> 32) % kMaxGap);
+        }
+        fits = fits && id <= INT_MAX;
+        ids[i] = static_cast<int>(id++);
+    }
+    return ids;
+}
+
+void AppendLine(RecordBuffer& text, const char* line) {
+    text.Append(line);
+    text.Append('\n');
+}
+
+} // namespace
+
+const char* GetSyntheticMeshName(SyntheticMesh mesh) {
+    switch (mesh) {
+        case SyntheticMesh::SHELL: return "shell";
+        case SyntheticMesh::BRICK: return "brick";
+        case SyntheticMesh::TETRA: return "tetra";
+    }
+    return "shell";
+}
+
+bool ParseSyntheticMesh(const std::string& name, SyntheticMesh& mesh) {
+    for (SyntheticMesh candidate : {SyntheticMesh::SHELL, SyntheticMesh::BRICK, SyntheticMesh::TETRA}) {
+        if (name == GetSyntheticMeshName(candidate)) {
+            mesh = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WriteSyntheticDeck(const std::string& path, const SyntheticDeckSpec& spec, std::string& error) {
+    const Block block = MakeBlock(spec);
+    const bool shell = spec.mesh == SyntheticMesh::SHELL;
+    
+    bool fits = true;
+    const std::vector<int> nodeIds = MakeIds(block.NodeCount(), 1, spec.seed, 0, fits);
+    
+    // Each part numbers its elements from a round number of its own
+    size_t largestPart = 0;
+    for (int part = 0; part < block.parts; ++part) {
+        largestPart = std::max(largestPart, block.PartBegin(part + 1) - block.PartBegin(part));
+    }
+    long long range = 10;
+    while (range < static_cast<long long>(largestPart) * 2) {
+        range *= 10;
+    }
+    std::vector<int> elementIds;
+    elementIds.reserve(block.ElementCount());
+    for (int part = 0; part < block.parts; ++part) {
+        std::vector<int> ids = MakeIds(block.PartBegin(part + 1) - block.PartBegin(part), (part + 1) * range + 1,
+                                       spec.seed, static_cast<uint64_t>(part) + 1, fits);
+        elementIds.insert(elementIds.end(), ids.begin(), ids.end());
+    }
+    if (!fits) {
+        error = "IDs do not fit in 32 bits; use fewer elements or parts";
+        return false;
+    }
+    
+    RecordWriter writer;
+    if (!writer.Open(path)) {
+        error = "Cannot create " + path;
+        return false;
+    }
+    
+    char line[160];
+    RecordBuffer& text = writer.Text();
+    AppendLine(text, "#RADIOSS STARTER");
+    std::snprintf(line, sizeof(line), "# Synthetic %s deck v%d: %zu elements, %zu nodes, %d parts, seed %llu",
+                  GetSyntheticMeshName(spec.mesh), kGeneratorVersion, block.ElementCount(), block.NodeCount(),
+                  block.parts, static_cast<unsigned long long>(spec.seed));
+    AppendLine(text, line);
+    AppendLine(text, "/BEGIN");
+    AppendLine(text, "/TITLE");
+    std::snprintf(line, sizeof(line), "Synthetic %s mesh", GetSyntheticMeshName(spec.mesh));
+    AppendLine(text, line);
+    
+    // Shells are a cylindrical panel, solids a sheared block
+    const double lengthY = kCellSize * static_cast<double>(block.ny);
+    AppendLine(text, "/NODE");
+    writer.WriteRecords(nodeIds.size(), [&](size_t n, RecordBuffer& out) {
+        const size_t i = n % (block.nx + 1);
+        const size_t j = (n / (block.nx + 1)) % (block.ny + 1);
+        const size_t k = n / ((block.nx + 1) * (block.ny + 1));
+        double x = kCellSize * (i + kDistortion * Signed(Random(spec.seed, 10, n)));
+        double y = kCellSize * (j + kDistortion * Signed(Random(spec.seed, 11, n)));
+        double z = kCellSize * (k + kDistortion * Signed(Random(spec.seed, 12, n)));
+        if (shell) {
+            z += 0.15 * lengthY * std::sin(3.14159265358979 * y / lengthY);
+        } else {
+            x += 0.1 * z;
+        }
+        out.AppendInt(nodeIds[n], 10);
+        out.AppendScientific(x, 10, 20);
+        out.AppendScientific(y, 10, 20);
+        out.AppendScientific(z, 10, 20);
+        out.Append('\n');
+    });
+    
+    const char* keyword = shell ? "SHELL" : spec.mesh == SyntheticMesh::BRICK ? "BRICK" : "TETRA4";
+    for (int part = 0; part < block.parts; ++part) {
+        const size_t first = block.PartBegin(part);
+        std::snprintf(line, sizeof(line), "/%s/%d", keyword, part + 1);
+        AppendLine(text, line);
+        writer.WriteRecords(block.PartBegin(part + 1) - first, [&](size_t index, RecordBuffer& out) {
+            const size_t e = first + index;
+            const size_t cell = e / block.perCell;
+            const size_t i = cell % block.nx;
+            const size_t j = (cell / block.nx) % block.ny;
+            const size_t k = shell ? 0 : cell / (block.nx * block.ny);
+            size_t corners[8] = {
+                block.Node(i, j, k), block.Node(i + 1, j, k), block.Node(i + 1, j + 1, k), block.Node(i, j + 1, k),
+                0, 0, 0, 0,
+            };
+            if (!shell) {
+                for (int c = 0; c < 4; ++c) {
+                    corners[c + 4] = corners[c] + (block.nx + 1) * (block.ny + 1);
+                }
+            }
+            
+            out.AppendInt(elementIds[e], 10);
+            out.AppendInt(1, 10);
+            out.AppendInt(part + 1, 10);
+            if (spec.mesh == SyntheticMesh::TETRA) {
+                for (int c : kCellTetra[e % 6]) {
+                    out.AppendInt(nodeIds[corners[c]], 10);
+                }
+            } else {
+                for (int c = 0; c < (shell ? 4 : 8); ++c) {
+                    out.AppendInt(nodeIds[corners[c]], 10);
+                }
+            }
+            out.Append('\n');
+        });
+    }
+    
+    AppendLine(text, "/MAT/LAW1");
+    AppendLine(text, "         1      LAW1       rho    7.85E-9     young   210000.0        nu        0.3");
+    for (int part = 0; part < block.parts; ++part) {
+        AppendLine(text, shell ? "/PROP/SHELL" : "/PROP/SOLID");
+        if (shell) {
+            std::snprintf(line, sizeof(line), "%10d%10s%10s%10.3f", part + 1, "SHELL", "Thick", 1.0 + 0.25 * (part % 4));
+        } else {
+            std::snprintf(line, sizeof(line), "%10d%10s", part + 1, "SOLID");
+        }
+        AppendLine(text, line);
+    }
+    AppendLine(text, "/END");
+    
+    if (!writer.Close()) {
+        error = "Failed while writing " + path;
+        return false;
+    }
+    return true;
+}
+
+std::string GetSyntheticDeck(const SyntheticDeckSpec& spec) {
+    std::error_code ec;
+    const fs::path directory = fs::temp_directory_path(ec) / "openradioss_benchmarks";
+    fs::create_directories(directory, ec);
+    
+    char name[128];
+    std::snprintf(name, sizeof(name), "%s_%zu_p%d_s%llu_v%d.rad", GetSyntheticMeshName(spec.mesh), spec.elements,
+                  spec.parts, static_cast<unsigned long long>(spec.seed), kGeneratorVersion);
+    const fs::path path = directory / name;
+    if (fs::exists(path, ec)) {
+        return path.string();
+    }
+    
+    // Written aside and renamed, so an interrupted run leaves no partial deck
+    std::string error;
+    const fs::path partial = directory / (std::string(name) + ".partial");
+    if (!WriteSyntheticDeck(partial.string(), spec, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        fs::remove(partial, ec);
+        return std::string();
+    }
+    fs::rename(partial, path, ec);
+    return ec ? std::string() : path.string();
+}
+
+Model* GetSyntheticModel(const SyntheticDeckSpec& spec) {
+    static std::string s_Path;
+    static std::unique_ptr<Model> s_Model;
+    const std::string path = GetSyntheticDeck(spec);
+    if (path.empty()) {
+        return nullptr;
+    }
+    if (path == s_Path) {
+        return s_Model.get();
+    }
+    
+    s_Path.clear();
+    s_Model = std::make_unique<Model>();
+    OpenRadiossGUI::RadFileReader reader;
+    if (!reader.loadFile(path)) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), reader.getLastError().c_str());
+        return nullptr;
+    }
+    FileManager::AddNodes(reader.getNodes(), *s_Model);
+    FileManager::AddElements(reader.getElements(), 0, reader.getElementCount(), *s_Model);
+    FileManager::AddMaterials(reader, *s_Model);
+    s_Model->BuildLookups();
+    s_Model->CalculateBounds();
+    s_Path = path;
+    return s_Model.get();
+}
+
+std::vector<size_t> TakeElementCounts(int& argc, char** argv, const std::vector<size_t>& fallback) {
+    static const char kFlag[] = "--elements=";
+    std::vector<size_t> counts;
+    int kept = 1;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strncmp(argv[a], kFlag, sizeof(kFlag) - 1) != 0) {
+            argv[kept++] = argv[a];
+            continue;
+        }
+        for (const char* p = argv[a] + sizeof(kFlag) - 1; *p;) {
+            char* end = nullptr;
+            const unsigned long long count = std::strtoull(p, &end, 10);
+            if (end == p) break;
+            if (count > 0) counts.push_back(static_cast<size_t>(count));
+            p = *end == ',' ? end + 1 : end;
+        }
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+    return counts.empty() ? fallback : counts;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Model;
+
+enum class SyntheticMesh { SHELL, BRICK, TETRA };
+
+// A structured block meshed the way a preprocessor would leave it: curved,
+// slightly distorted cells split into parts, one element block and
+// property per part. Node and element IDs climb with gaps, as decks that
+// were remeshed and renumbered have, and element IDs start a new range in
+// every part. Fields are I10 and 20-wide scientific, as RadFileWriter
+// writes them. The same spec always gives the same bytes.
+struct SyntheticDeckSpec {
+    SyntheticMesh mesh = SyntheticMesh::SHELL;
+    size_t elements = 1000000;   // At least; the grid rounds up
+    int parts = 8;
+    uint64_t seed = 1;
+};
+
+const char* GetSyntheticMeshName(SyntheticMesh mesh);
+bool ParseSyntheticMesh(const std::string& name, SyntheticMesh& mesh);
+
+bool WriteSyntheticDeck(const std::string& path, const SyntheticDeckSpec& spec, std::string& error);
+
+// Path of the deck under the temporary directory, written on first use and
+// reused by later runs; empty when it cannot be written
+std::string GetSyntheticDeck(const SyntheticDeckSpec& spec);
+
+// The deck read into a model with its lookups built, as the loader leaves
+// it; null when it cannot be read. Only the model last asked for is kept,
+// so suites registered deck by deck read each deck once.
+Model* GetSyntheticModel(const SyntheticDeckSpec& spec);
+
+// Takes "--elements=N[,N...]" out of the command line, leaving the rest for
+// google-benchmark; fallback when it is not there
+std::vector<size_t> TakeElementCounts(int& argc, char** argv, const std::vector<size_t>& fallback);
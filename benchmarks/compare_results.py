@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Compares two google-benchmark JSON results, as benchmark_results writes
+them: each argument is a JSON file or a directory of them. Repeated runs are
+compared by their median. Exits with 1 when any benchmark in both got slower
+than the threshold allows, so a CI job can fail on it.
+
+    compare_results.py build/benchmark_results/<old> build/benchmark_results/<new>
+"""
+import argparse
+import json
+import os
+import sys
+
+UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    """Benchmark name -> time in nanoseconds"""
+    files = [path]
+    if os.path.isdir(path):
+        files = sorted(os.path.join(path, name) for name in os.listdir(path) if name.endswith(".json"))
+
+    times = {}
+    for name in files:
+        with open(name) as f:
+            results = json.load(f)
+        medians = {}
+        for run in results.get("benchmarks", []):
+            if run.get("error_occurred"):
+                continue
+            key = run.get("run_name", run["name"])
+            time = run["real_time"] * UNITS.get(run.get("time_unit", "ns"), 1.0)
+            if run.get("run_type") == "aggregate":
+                if run.get("aggregate_name") == "median":
+                    medians[key] = time
+            else:
+                times.setdefault(key, time)
+        times.update(medians)
+    return times
+
+
+def format_time(ns):
+    for unit in ("s", "ms", "us"):
+        if ns >= UNITS[unit]:
+            return "%.3f %s" % (ns / UNITS[unit], unit)
+    return "%.1f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="slowdown that counts as a regression, as a fraction (default 0.10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    contender = load(args.contender)
+    names = [name for name in baseline if name in contender]
+    if not names:
+        print("No benchmarks in common")
+        return 1
+
+    width = max(len(name) for name in names)
+    regressions = 0
+    for name in names:
+        change = contender[name] / baseline[name] - 1.0 if baseline[name] > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            mark = "  faster"
+        print("%-*s %12s %12s %+8.1f%%%s" % (width, name, format_time(baseline[name]),
+                                            format_time(contender[name]), change * 100.0, mark))
+
+    for name in sorted(set(baseline) ^ set(contender)):
+        print("%-*s only in %s" % (width, name, "baseline" if name in baseline else "contender"))
+
+    if regressions:
+        print("%d of %d benchmarks slower by more than %.0f%%" % (regressions, len(names), args.threshold * 100.0))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,9 +1,41 @@
 #version 330 core
+flat in uint vPrimitiveBase;
 out vec4 FragColor;
 
 uniform vec3 color;
+uniform bool usePartTable;   // Lines of hidden parts are dropped; points have no parts
+uniform vec3 highlightColor;
+
+// Part look-up (PartTable): the element a primitive came from, through
+// the mesh's tags, and that element's part and material slots; the
+// material slot's top bit marks a highlighted element
+uniform usamplerBuffer primitiveElements;
+uniform usamplerBuffer elementSlots;
+uniform samplerBuffer partColors;       // Colour, visibility in alpha
+
+const uint kHighlightBit = 0x80000000u;
+
+// Slots of the primitive's element; false for edges between parts and
+// while no table is built
+bool FindSlots(out uvec2 slots)
+{
+    uint element = texelFetch(primitiveElements, int(vPrimitiveBase + uint(gl_PrimitiveID))).r;
+    if (element >= uint(textureSize(elementSlots))) {
+        return false;
+    }
+    slots = texelFetch(elementSlots, int(element)).rg;
+    return true;
+}
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
-}
\ No newline at end of file
+    uvec2 slots;
+    if (!usePartTable || !FindSlots(slots)) {
+        FragColor = vec4(color, 1.0);
+        return;
+    }
+    if (texelFetch(partColors, int(slots.x)).a < 0.5) {
+        discard;
+    }
+    FragColor = vec4((slots.y & kHighlightBit) != 0u ? highlightColor : color, 1.0);
+}
@@ -1,11 +1,36 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 3) in vec3 aDisplacement;   // Zero unless an animation is playing
+layout (location = 4) in uint aPrimitiveBase;  // First primitive of the draw (Mesh)
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame camera and light, shared by every program (FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;   // The light sits at the camera
+    vec4 lightColor;
+    float displacementScale;
+    vec4 clipPlanes[6];    // Kept where dot(plane, vec4(position, 1)) >= 0
+};
+
+flat out uint vPrimitiveBase;
+
+// Distances to the user clipping planes, in world space
+void SetClipDistances(vec3 position)
+{
+    vec4 p = vec4(position, 1.0);
+    gl_ClipDistance[0] = dot(clipPlanes[0], p);
+    gl_ClipDistance[1] = dot(clipPlanes[1], p);
+    gl_ClipDistance[2] = dot(clipPlanes[2], p);
+    gl_ClipDistance[3] = dot(clipPlanes[3], p);
+    gl_ClipDistance[4] = dot(clipPlanes[4], p);
+    gl_ClipDistance[5] = dot(clipPlanes[5], p);
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vPrimitiveBase = aPrimitiveBase;
+    vec3 position = aPos + displacementScale * aDisplacement;
+    gl_Position = projection * view * vec4(position, 1.0);
+    SetClipDistances(position);
 }
@@ -0,0 +1,27 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+
+// Per-frame camera and light, shared by every program (FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;   // The light sits at the camera
+    vec4 lightColor;
+    float displacementScale;
+    vec4 clipPlanes[6];    // Kept where dot(plane, vec4(position, 1)) >= 0
+};
+
+uniform vec3 capColor;
+uniform vec3 capNormal;
+
+void main()
+{
+    // Lit like the solid pass, from the side the camera is on
+    vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
+    vec3 norm = dot(capNormal, viewDir) < 0.0 ? -capNormal : capNormal;
+    float diff = max(dot(norm, viewDir), 0.0);
+    vec3 result = (0.3 + diff) * lightColor.rgb * capColor;
+    FragColor = vec4(result, 1.0);
+}
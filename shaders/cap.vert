@@ -0,0 +1,41 @@
+#version 330 core
+
+// Per-frame camera and light, shared by every program (FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;   // The light sits at the camera
+    vec4 lightColor;
+    float displacementScale;
+    vec4 clipPlanes[6];    // Kept where dot(plane, vec4(position, 1)) >= 0
+};
+
+// Section cap: a quad on one clipping plane, covering the model, drawn
+// as a strip of four without attributes; the stencil keeps what lies
+// inside solids
+uniform vec3 capOrigin;
+uniform vec3 capAxisU;   // Half the quad's extent along the plane
+uniform vec3 capAxisV;
+
+out vec3 FragPos;
+
+// Distances to the user clipping planes, in world space
+void SetClipDistances(vec3 position)
+{
+    vec4 p = vec4(position, 1.0);
+    gl_ClipDistance[0] = dot(clipPlanes[0], p);
+    gl_ClipDistance[1] = dot(clipPlanes[1], p);
+    gl_ClipDistance[2] = dot(clipPlanes[2], p);
+    gl_ClipDistance[3] = dot(clipPlanes[3], p);
+    gl_ClipDistance[4] = dot(clipPlanes[4], p);
+    gl_ClipDistance[5] = dot(clipPlanes[5], p);
+}
+
+void main()
+{
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    vec3 position = capOrigin + corner.x * capAxisU + corner.y * capAxisV;
+    FragPos = position;
+    gl_Position = projection * view * vec4(position, 1.0);
+    SetClipDistances(position);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+out float NodeValue;
+
+// Element values averaged to nodes (ContourPlot): one fragment per node,
+// rowLength nodes to a row, gathering over the node's elements through
+// the adjacency (CSR, like NodeAdjacency). Elements without a value (NaN)
+// are left out; a node with none of them gets NaN.
+uniform samplerBuffer elementValues;
+uniform usamplerBuffer adjacencyOffsets;   // Node count + 1
+uniform usamplerBuffer adjacencyEntries;   // Element indices
+uniform int nodeCount;
+uniform int rowLength;
+
+void main()
+{
+    int node = int(gl_FragCoord.y) * rowLength + int(gl_FragCoord.x);
+    float sum = 0.0;
+    int count = 0;
+    if (node < nodeCount) {
+        int first = int(texelFetch(adjacencyOffsets, node).r);
+        int last = int(texelFetch(adjacencyOffsets, node + 1).r);
+        for (int i = first; i < last; ++i) {
+            float value = texelFetch(elementValues, int(texelFetch(adjacencyEntries, i).r)).r;
+            if (!isnan(value)) {
+                sum += value;
+                ++count;
+            }
+        }
+    }
+    NodeValue = count > 0 ? sum / float(count) : uintBitsToFloat(0x7FC00000u);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+// Histogram of the values over their range (ContourPlot): one point per
+// value, drawn onto its bin of a one-row target that blending adds into.
+// Values without one (NaN) are moved outside the clip volume.
+uniform samplerBuffer values;
+uniform sampler2D range;   // The reduction's 1x1 result
+uniform int binCount;
+
+void main()
+{
+    float value = texelFetch(values, gl_VertexID).r;
+    vec2 limits = texelFetch(range, ivec2(0), 0).rg;
+    gl_PointSize = 1.0;
+    if (isnan(value) || limits.x > limits.y) {
+        gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+        return;
+    }
+    float t = limits.y > limits.x ? (value - limits.x) / (limits.y - limits.x) : 0.0;
+    float bin = min(floor(t * float(binCount)), float(binCount - 1));
+    gl_Position = vec4((bin + 0.5) / float(binCount) * 2.0 - 1.0, 0.0, 0.0, 1.0);
+}
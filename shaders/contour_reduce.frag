@@ -0,0 +1,43 @@
+#version 330 core
+out vec2 Range;   // Min and max; min > max when nothing had a value
+
+// One step of the min/max reduction (ContourPlot). The first step reads
+// kValuesPerTexel consecutive values per fragment, rowLength fragments to
+// a row; each later one an 8x8 block of the step before, down to 1x1.
+uniform bool firstStep;
+uniform samplerBuffer values;
+uniform int valueCount;
+uniform int rowLength;
+uniform sampler2D previous;
+
+const int kValuesPerTexel = 64;
+const int kBlockSize = 8;
+const float kEmpty = 3.0e38;
+
+void main()
+{
+    vec2 range = vec2(kEmpty, -kEmpty);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if (firstStep) {
+        int first = (texel.y * rowLength + texel.x) * kValuesPerTexel;
+        int last = min(first + kValuesPerTexel, valueCount);
+        for (int i = first; i < last; ++i) {
+            float value = texelFetch(values, i).r;
+            if (!isnan(value)) {
+                range = vec2(min(range.x, value), max(range.y, value));
+            }
+        }
+    } else {
+        ivec2 size = textureSize(previous, 0);
+        for (int y = 0; y < kBlockSize; ++y) {
+            for (int x = 0; x < kBlockSize; ++x) {
+                ivec2 source = texel * kBlockSize + ivec2(x, y);
+                if (source.x < size.x && source.y < size.y) {
+                    vec2 block = texelFetch(previous, source, 0).rg;
+                    range = vec2(min(range.x, block.x), max(range.y, block.y));
+                }
+            }
+        }
+    }
+    Range = range;
+}
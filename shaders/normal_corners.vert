@@ -0,0 +1,46 @@
+#version 330 core
+
+// One point per triangle corner: the face normals around the corner's
+// node within the feature angle of its own face, summed, reversing those
+// wound the other way; packed like NormalGenerator::PackNormal
+flat out uvec2 cornerNormal;
+
+uniform usamplerBuffer triangleIndices;
+uniform usamplerBuffer adjacencyOffsets;   // Node to triangle CSR
+uniform usamplerBuffer adjacencyEntries;
+uniform samplerBuffer faceNormals;
+uniform float cosFeature;
+
+uvec2 PackNormal(vec3 normal)
+{
+    uvec3 q = uvec3(round((clamp(normal, -1.0, 1.0) * 0.5 + 0.5) * 65535.0));
+    return uvec2(q.x | (q.y << 16), q.z);
+}
+
+void main()
+{
+    int triangle = gl_VertexID / 3;
+    vec3 own = texelFetch(faceNormals, triangle).xyz;
+    float ownLength = length(own);
+    if (ownLength == 0.0) {
+        cornerNormal = uvec2(0u);
+        return;
+    }
+    own /= ownLength;
+    
+    int node = int(texelFetch(triangleIndices, gl_VertexID).r);
+    int first = int(texelFetch(adjacencyOffsets, node).r);
+    int last = int(texelFetch(adjacencyOffsets, node + 1).r);
+    vec3 sum = vec3(0.0);
+    for (int e = first; e < last; ++e) {
+        vec3 normal = texelFetch(faceNormals, int(texelFetch(adjacencyEntries, e).r)).xyz;
+        float normalLength = length(normal);
+        float cosine = normalLength > 0.0 ? dot(normal, own) / normalLength : 0.0;
+        if (abs(cosine) >= cosFeature) {
+            sum += cosine >= 0.0 ? normal : -normal;
+        }
+    }
+    
+    // Coarse triangles may meet no full-detail face close enough
+    cornerNormal = PackNormal(dot(sum, sum) > 0.0 ? normalize(sum) : own);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+// One point per triangle: its face normal, twice its area long, captured
+// by transform feedback (NormalGenerator)
+out vec4 faceNormal;
+
+uniform usamplerBuffer triangleIndices;
+uniform samplerBuffer nodePositions;
+
+vec3 Corner(int k)
+{
+    int node = int(texelFetch(triangleIndices, 3 * gl_VertexID + k).r);
+    return texelFetch(nodePositions, node).xyz;
+}
+
+void main()
+{
+    vec3 a = Corner(0);
+    faceNormal = vec4(cross(Corner(1) - a, Corner(2) - a), 0.0);
+}
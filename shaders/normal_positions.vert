@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in vec3 aDisplacement;   // Zero unless an animation is playing
+
+// Displaced node position, captured per node (NormalGenerator)
+out vec4 position;
+
+uniform float scale;
+
+void main()
+{
+    position = vec4(aPos + scale * aDisplacement, 1.0);
+}
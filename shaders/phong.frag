@@ -1,34 +1,138 @@
-version 330 core
+#version 330 core
 out vec4 FragColor;
 
-in vec3 FragPos;
-in vec3 Normal;
-in vec2 TexCoords;
+in Surface {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    flat uint vPrimitiveBase;
+    float vNodeValue;
+};
+
+// Per-frame camera and light, shared by every program (FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;   // The light sits at the camera
+    vec4 lightColor;
+    float displacementScale;
+    vec4 clipPlanes[6];    // Kept where dot(plane, vec4(position, 1)) >= 0
+};
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
 uniform vec3 objectColor;
-uniform vec3 viewPos;
+uniform int colorMode;   // 0 objectColor, 1 by part, 2 by material, 3 fringes
+uniform vec3 highlightColor;
+
+// Part look-up (PartTable): the element a primitive came from, through
+// the mesh's tags, and that element's part and material slots; the
+// material slot's top bit marks a highlighted element
+uniform usamplerBuffer primitiveElements;
+uniform usamplerBuffer elementSlots;
+uniform samplerBuffer partColors;       // Colour, visibility in alpha
+uniform samplerBuffer materialColors;
+
+const uint kHighlightBit = 0x80000000u;
+
+// Fringes (ContourPlot): the element's value, or its nodes' averages
+// interpolated, placed in the range and coloured through the colormap,
+// in discrete bands unless contourBands is 0. The range is the state's,
+// as reduced on the GPU, unless contourAutoRange is off.
+uniform samplerBuffer elementValues;   // Size zero without values
+uniform sampler2D contourRange;
+uniform sampler1D colormap;
+uniform bool contourNodal;
+uniform bool contourAutoRange;
+uniform vec2 contourLimits;
+uniform int contourBands;
+
+const vec3 kNoValueColor = vec3(0.5);
+
+// Model element index of the primitive; past the tables for edges
+// between parts
+uint FindElement()
+{
+    return texelFetch(primitiveElements, int(vPrimitiveBase + uint(gl_PrimitiveID))).r;
+}
+
+// Slots of the element; false for edges between parts and while no table
+// is built
+bool FindSlots(uint element, out uvec2 slots)
+{
+    if (element >= uint(textureSize(elementSlots))) {
+        return false;
+    }
+    slots = texelFetch(elementSlots, int(element)).rg;
+    return true;
+}
+
+vec3 ContourColor(uint element)
+{
+    if (element >= uint(textureSize(elementValues))) {
+        return kNoValueColor;
+    }
+    float value = contourNodal ? vNodeValue : texelFetch(elementValues, int(element)).r;
+    vec2 limits = contourAutoRange ? texelFetch(contourRange, ivec2(0), 0).rg : contourLimits;
+    if (isnan(value) || limits.x > limits.y) {
+        return kNoValueColor;
+    }
+    float t = limits.y > limits.x ? clamp((value - limits.x) / (limits.y - limits.x), 0.0, 1.0) : 0.5;
+    if (contourBands > 0) {
+        float bands = float(contourBands);
+        t = (min(floor(t * bands), bands - 1.0) + 0.5) / bands;
+    }
+    return texture(colormap, t).rgb;
+}
 
 void main()
 {
+    vec3 surfaceColor = objectColor;
+    uint element = FindElement();
+    uvec2 slots;
+    bool highlighted = false;
+    if (FindSlots(element, slots)) {
+        vec4 part = texelFetch(partColors, int(slots.x));
+        if (part.a < 0.5) {
+            discard;
+        }
+        highlighted = (slots.y & kHighlightBit) != 0u;
+        if (colorMode == 1) {
+            surfaceColor = part.rgb;
+        } else if (colorMode == 2) {
+            surfaceColor = texelFetch(materialColors, int(slots.y & ~kHighlightBit)).rgb;
+        }
+    }
+    if (colorMode == 3) {
+        surfaceColor = ContourColor(element);
+    }
+    if (highlighted) {
+        surfaceColor = highlightColor;
+    }
+    
+    vec3 light = lightColor.rgb;
+    
     // Ambient
     float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * light;
     
     // Diffuse
-    vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    // Without smooth normals, use the face's from the derivatives; shells
+    // are lit from either side, so normals turn towards the viewer
+    vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
+    vec3 norm = dot(Normal, Normal) > 0.0 ? normalize(Normal)
+                                          : normalize(cross(dFdx(FragPos), dFdy(FragPos)));
+    if (dot(norm, viewDir) < 0.0) {
+        norm = -norm;
+    }
+    vec3 lightDir = normalize(cameraPosition.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * light;
     
     // Specular
     float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * lightColor;
+    vec3 specular = specularStrength * spec * light;
     
-    vec3 result = (ambient + diffuse + specular) * objectColor;
+    vec3 result = (ambient + diffuse + specular) * surfaceColor;
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
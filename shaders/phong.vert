@@ -2,20 +2,53 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec3 aDisplacement;   // Zero unless an animation is playing
+layout (location = 4) in uint aPrimitiveBase;  // First primitive of the draw (Mesh)
 
-out vec3 FragPos;
-out vec3 Normal;
-out vec2 TexCoords;
+// Through phong.geom, which gives triangles their corner normals
+out Surface {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    flat uint vPrimitiveBase;
+    float vNodeValue;
+} surface;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame camera and light, shared by every program (FrameUniforms)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;   // The light sits at the camera
+    vec4 lightColor;
+    float displacementScale;
+    vec4 clipPlanes[6];    // Kept where dot(plane, vec4(position, 1)) >= 0
+};
+
+// Node values for nodal fringes (ContourPlot); meshes draw shared-node
+// geometry, so the vertex number is the node index
+uniform samplerBuffer nodeValues;
+
+// Distances to the user clipping planes, in world space
+void SetClipDistances(vec3 position)
+{
+    vec4 p = vec4(position, 1.0);
+    gl_ClipDistance[0] = dot(clipPlanes[0], p);
+    gl_ClipDistance[1] = dot(clipPlanes[1], p);
+    gl_ClipDistance[2] = dot(clipPlanes[2], p);
+    gl_ClipDistance[3] = dot(clipPlanes[3], p);
+    gl_ClipDistance[4] = dot(clipPlanes[4], p);
+    gl_ClipDistance[5] = dot(clipPlanes[5], p);
+}
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoords = aTexCoords;
+    vec3 position = aPos + displacementScale * aDisplacement;
+    surface.FragPos = position;   // Meshes are built in world space
+    surface.Normal = aNormal;
+    surface.TexCoords = aTexCoords;
+    surface.vPrimitiveBase = aPrimitiveBase;
+    surface.vNodeValue = texelFetch(nodeValues, gl_VertexID).r;
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = projection * view * vec4(position, 1.0);
+    SetClipDistances(position);
 }
\ No newline at end of file
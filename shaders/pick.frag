@@ -0,0 +1,41 @@
+#version 330 core
+flat in uint vIndex;
+flat in uint vPrimitiveBase;
+
+// Triangle numbers go to red and node indices to green, both plus one so
+// zero means nothing; the pass masks the channel it does not write
+out uvec2 pickId;
+
+uniform bool pickNodes;
+
+// Part look-up (PartTable): the element a primitive came from, through
+// the mesh's tags, and that element's part and material slots
+uniform usamplerBuffer primitiveElements;
+uniform usamplerBuffer elementSlots;
+uniform samplerBuffer partColors;       // Colour, visibility in alpha
+
+// Slots of the primitive's element; false for edges between parts and
+// while no table is built
+bool FindSlots(out uvec2 slots)
+{
+    uint element = texelFetch(primitiveElements, int(vPrimitiveBase + uint(gl_PrimitiveID))).r;
+    if (element >= uint(textureSize(elementSlots))) {
+        return false;
+    }
+    slots = texelFetch(elementSlots, int(element)).rg;
+    return true;
+}
+
+void main()
+{
+    if (pickNodes) {
+        pickId = uvec2(0u, vIndex + 1u);
+    } else {
+        // Hidden parts cannot be picked, nor hide what is behind them
+        uvec2 slots;
+        if (FindSlots(slots) && texelFetch(partColors, int(slots.x)).a < 0.5) {
+            discard;
+        }
+        pickId = uvec2(vPrimitiveBase + uint(gl_PrimitiveID) + 1u, 0u);
+    }
+}
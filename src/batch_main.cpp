@@ -0,0 +1,40 @@
+// Headless batch rendering: draws the views of a job file into PNGs on a
+// GPU without a display. Usage: OpenRadiossGUIBatch <job.json>
+#include "core/BatchRenderer.h"
+#include "rendering/HeadlessContext.h"
+#include "utils/Logger.h"
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <job.json>" << std::endl;
+        return 2;
+    }
+    
+    Logger::Init();
+    
+    BatchJob job;
+    std::string error;
+    if (!BatchJob::Load(argv[1], job, error)) {
+        LOG_ERROR("Cannot read job {}: {}", argv[1], error);
+        Logger::Shutdown();
+        return 2;
+    }
+    
+    HeadlessContext context;
+    if (!context.Create()) {
+        LOG_ERROR("Cannot create a headless context: {}", context.GetError());
+        Logger::Shutdown();
+        return 1;
+    }
+    
+    bool succeeded;
+    {
+        BatchRenderer batch;
+        succeeded = batch.Run(job);
+    }
+    context.Destroy();
+    
+    Logger::Shutdown();
+    return succeeded ? 0 : 1;
+}
@@ -1,13 +1,68 @@
 // src/core/Application.cpp
 #include "core/Application.h"
 #include "core/Model.h"
+#include "core/ModelLoader.h"
+#include "core/ModelHistory.h"
+#include "core/MeshQuality.h"
+#include "core/NodeMerger.h"
 #include "rendering/Renderer.h"
+#include "rendering/Camera.h"
+#include "rendering/AnimationStream.h"
+#include "rendering/Picker.h"
+#include "rendering/ProgramCache.h"
+#include "rendering/GpuTimer.h"
 #include "gui/GuiManager.h"
 #include "io/FileManager.h"
+#include "io/ResultReader.h"
+#include "io/ResultCache.h"
+#include "solver/DomainPartitioner.h"
+#include "solver/JobManager.h"
 #include "solver/SolverInterface.h"
+#include "solver/TimeStepEstimator.h"
+#include "utils/Config.h"
 #include "utils/Logger.h"
+#include "utils/Profiler.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iterator>
+
+namespace {
+
+constexpr const char* kSettingsPath = "resources/config/default_settings.json";
+
+// Frame pacing. ImGui lays out a change over a couple of frames, so input
+// is followed by a few; an idle loop still wakes now and then, and a frame
+// after a long wait does not advance playback by all of it.
+constexpr int kSettleFrames = 3;
+constexpr double kIdleTimeout = 0.5;
+constexpr float kMaxFrameTime = 0.1f;
+
+// GPU upload allowed per frame while a model streams in. Small enough to
+// keep the frame well under 33 ms on integrated GPUs.
+constexpr size_t kUploadBudgetPerFrame = 4 * 1024 * 1024;
+
+// Picking, in framebuffer pixels: how far from the cursor hovering and
+// clicks reach, how far the cursor may move for a press to stay a click,
+// and the spacing of lasso points
+constexpr int kPickRadius = 3;
+constexpr float kClickTolerance = 3.0f;
+constexpr float kLassoSpacing = 4.0f;
+
+void Redraw(GLFWwindow* window) {
+    static_cast<Application*>(glfwGetWindowUserPointer(window))->RequestRedraw();
+}
+
+std::vector<int> MergeIds(const std::vector<int>& a, const std::vector<int>& b) {
+    std::vector<int> merged;
+    merged.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged));
+    return merged;
+}
+
+} // namespace
 
 Application::Application() 
     : m_Running(false), m_LastFrameTime(0.0f) {
@@ -26,12 +81,24 @@ void Application::Initialize() {
         throw std::runtime_error("Failed to initialize GLFW");
     }
     
+    Config config;
+    if (!config.Load(kSettingsPath)) {
+        LOG_WARN("Using default settings: {}", config.GetError());
+    }
+    
+    Logger::SetLevel(Logger::ParseLevel(config.GetString("logging.level", "info"), LogLevel::INFO));
+    const std::string logFile = config.GetString("logging.file", "");
+    if (!logFile.empty() && !Logger::AddFileSink(logFile)) {
+        LOG_WARN("Cannot open log file: {}", logFile);
+    }
+    
     // Create window with OpenGL context
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     
-    GLFWwindow* window = glfwCreateWindow(1600, 900, 
+    GLFWwindow* window = glfwCreateWindow(config.GetInt("application.window.width", 1600),
+        config.GetInt("application.window.height", 900),
         "OpenRadioss Pre-Processor", nullptr, nullptr);
     
     if (!window) {
@@ -40,13 +107,33 @@ void Application::Initialize() {
     }
     
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(config.GetBool("application.window.vsync", true) ? 1 : 0);
     
     // Initialize components
+    ProgramCache::SetDirectory(config.GetString("renderer.shaderCache", ProgramCache::GetDirectory()));
     m_Model = std::make_unique<Model>();
     m_Renderer = std::make_unique<Renderer>(window);
     m_GuiManager = std::make_unique<GuiManager>(window, this);
     m_FileManager = std::make_unique<FileManager>(m_Model.get());
     m_SolverInterface = std::make_unique<SolverInterface>();
+    m_JobManager = std::make_unique<JobManager>();
+    m_Decomposition = std::make_unique<DecompositionPreview>();
+    m_Quality = std::make_unique<MeshQuality>();
+    m_ModelLoader = std::make_unique<ModelLoader>();
+    m_History = std::make_unique<ModelHistory>();
+    
+    RenderSettings& settings = m_Renderer->GetSettings();
+    settings.interactiveScale = static_cast<float>(
+        config.GetNumber("renderer.interactiveScale", settings.interactiveScale));
+    
+    // Edits arrive as whole transactions; the mesh is rebuilt once per frame at most
+    m_Model->AddChangeListener([this](const ModelChange&) {
+        m_MeshOutdated = true;
+        RequestRedraw();
+        if (!m_RestoringHistory) {
+            m_History->Record(*m_Model);
+        }
+    });
     
     // Setup callbacks
     m_GuiManager->SetFileOpenCallback(
@@ -55,37 +142,122 @@ void Application::Initialize() {
     m_GuiManager->SetFileSaveCallback(
         [this](const std::string& path) { SaveFile(path); });
     
+    // The machine share runs may take; 0 cores is all of them
+    JobBudget budget = m_JobManager->GetBudget();
+    const int cores = config.GetInt("solver.cores", 0);
+    budget.cores = cores > 0 ? cores : budget.cores;
+    budget.memoryGB = config.GetNumber("solver.memoryGB", budget.memoryGB);
+    m_JobManager->SetBudget(budget);
+    
     m_GuiManager->SetSolverRunCallback(
-        [this]() { 
-            SolverConfig config;
-            config.inputFile = m_FileManager->GetCurrentFile();
-            config.numProcessors = 4;
-            m_SolverInterface->SetConfig(config);
-            m_SolverInterface->RunSolverAsync();
+        [this](const JobSpec& settings) { 
+            JobSpec spec = settings;
+            spec.config.inputFile = m_FileManager->GetCurrentFile();
+            if (spec.name.empty()) {
+                spec.name = std::filesystem::path(spec.config.inputFile).stem().string();
+            }
+            if (JobId id = m_JobManager->Submit(spec)) {
+                m_ShownJob = id;
+            }
         });
     
+    m_JobManager->SetWakeCallback([this]() { WakeFromWorker(); });
+    
+    // Before the GUI's callbacks, which chain to these
+    InstallCallbacks(window);
+    
     // Initialize GUI
     m_GuiManager->Initialize();
+    RequestRedraw();
     
     LOG_INFO("Application initialized successfully");
 }
 
+void Application::InstallCallbacks(GLFWwindow* window) {
+    glfwSetWindowUserPointer(window, this);
+    
+    // Any input may change what the GUI shows
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int, int, int, int) { Redraw(w); });
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { Redraw(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { Redraw(w); });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { Redraw(w); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow* w, int) { Redraw(w); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int) { Redraw(w); });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, int, int) { Redraw(w); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { Redraw(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double yoffset) {
+        Application* app = static_cast<Application*>(glfwGetWindowUserPointer(w));
+        if (!app->m_GuiManager->WantsMouse()) {
+            app->m_Renderer->GetCamera()->ProcessMouseScroll(static_cast<float>(yoffset));
+        }
+        app->RequestRedraw();
+    });
+}
+
+SolverInterface* Application::GetSolverInterface() {
+    SolverInterface* solver = m_JobManager->GetSolver(m_ShownJob);
+    return solver ? solver : m_SolverInterface.get();
+}
+
+void Application::StartDecompositionPreview(const std::vector<int>& rankCounts) {
+    m_Decomposition->Start(*m_Model, rankCounts, [this]() { WakeFromWorker(); });
+}
+
+void Application::WakeFromWorker() {
+    // Solvers and workers report from their own threads, so they only
+    // wake the loop, once until the loop has seen it
+    if (!m_SolverChanged.exchange(true)) {
+        glfwPostEmptyEvent();
+    }
+}
+
+void Application::RequestRedraw() {
+    m_RedrawFrames = kSettleFrames;
+}
+
+bool Application::NeedsFrame() const {
+    return m_RedrawFrames > 0 || m_MeshOutdated || m_ModelLoader->IsLoading() || m_Renderer->IsBusy();
+}
+
 void Application::Run() {
     m_Running = true;
     
     auto lastTime = std::chrono::high_resolution_clock::now();
     
     while (m_Running && !glfwWindowShouldClose(m_Renderer->GetWindow())) {
+        // Sleeps until input while nothing changes; the solver and loader
+        // post an event when they have news
+        if (NeedsFrame()) {
+            glfwPollEvents();
+        } else {
+            glfwWaitEventsTimeout(kIdleTimeout);
+        }
+        if (m_SolverChanged.exchange(false)) {
+            RequestRedraw();
+        }
+        
         auto currentTime = std::chrono::high_resolution_clock::now();
-        float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
+        float deltaTime = std::min(std::chrono::duration<float>(currentTime - lastTime).count(), kMaxFrameTime);
         lastTime = currentTime;
         
+        // A pass that draws nothing is not a frame; BeginFrame drops what it timed
+        Profiler& profiler = Profiler::Get();
+        profiler.BeginFrame();
         ProcessInput();
         Update(deltaTime);
+        if (!NeedsFrame()) {
+            continue;
+        }
         Render();
         
-        glfwSwapBuffers(m_Renderer->GetWindow());
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("SwapBuffers");
+            glfwSwapBuffers(m_Renderer->GetWindow());
+        }
+        profiler.EndFrame();
+        if (m_RedrawFrames > 0) {
+            --m_RedrawFrames;
+        }
     }
 }
 
@@ -95,44 +267,342 @@ void Application::ProcessInput() {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         m_Running = false;
     }
+    
+    // Ctrl+Z / Ctrl+Y, once per press
+    bool control = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS ||
+                   glfwGetKey(window, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS;
+    bool undoKey = control && glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS;
+    bool redoKey = control && glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS;
+    if (undoKey && !m_UndoKeyDown) {
+        Undo();
+    }
+    if (redoKey && !m_RedoKeyDown) {
+        Redo();
+    }
+    m_UndoKeyDown = undoKey;
+    m_RedoKeyDown = redoKey;
+    
+    ProcessCamera();
+    ProcessPicking();
+}
+
+void Application::ProcessCamera() {
+    GLFWwindow* window = m_Renderer->GetWindow();
+    double cursorX = 0.0, cursorY = 0.0;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    glm::vec2 cursor(static_cast<float>(cursorX), static_cast<float>(cursorY));
+    
+    bool orbit = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS ||
+                 glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS;
+    if (orbit && !m_Orbiting && !m_GuiManager->WantsMouse()) {
+        m_Orbiting = true;
+        m_Renderer->SetInteractive(true);
+    } else if (orbit && m_Orbiting && cursor != m_OrbitCursor) {
+        glm::vec2 delta = cursor - m_OrbitCursor;
+        m_Renderer->GetCamera()->ProcessMouseMovement(delta.x, -delta.y);
+        RequestRedraw();
+    } else if (!orbit && m_Orbiting) {
+        // The drag ended: one more frame at full resolution
+        m_Orbiting = false;
+        m_Renderer->SetInteractive(false);
+        RequestRedraw();
+    }
+    m_OrbitCursor = cursor;
+}
+
+void Application::ProcessPicking() {
+    GLFWwindow* window = m_Renderer->GetWindow();
+    if (m_GuiManager->WantsMouse() || m_Renderer->IsStreaming() || m_Orbiting) {
+        m_Dragging = false;
+        return;
+    }
+    
+    // Cursor positions are in window coordinates, picks in framebuffer pixels
+    int windowWidth = 0, windowHeight = 0, width = 0, height = 0;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    glfwGetFramebufferSize(window, &width, &height);
+    if (windowWidth <= 0 || windowHeight <= 0) {
+        return;
+    }
+    double cursorX = 0.0, cursorY = 0.0;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    glm::vec2 cursor(static_cast<float>(cursorX * width / windowWidth),
+                     static_cast<float>(cursorY * height / windowHeight));
+    
+    bool pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    bool lasso = glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS ||
+                 glfwGetKey(window, GLFW_KEY_RIGHT_ALT) == GLFW_PRESS;
+    if (pressed && !m_Dragging) {
+        m_Dragging = true;
+        m_DragStart = cursor;
+        m_Lasso.assign(1, cursor);
+    } else if (pressed) {
+        glm::vec2 step = cursor - m_Lasso.back();
+        if (lasso && std::sqrt(step.x * step.x + step.y * step.y) >= kLassoSpacing) {
+            m_Lasso.push_back(cursor);
+        }
+    } else if (m_Dragging) {
+        m_Dragging = false;
+        glm::vec2 low = glm::min(m_DragStart, cursor);
+        glm::vec2 high = glm::max(m_DragStart, cursor);
+        
+        PickRegion region;
+        m_SelectNearest = high.x - low.x < kClickTolerance && high.y - low.y < kClickTolerance;
+        if (m_SelectNearest) {
+            low = cursor - glm::vec2(static_cast<float>(kPickRadius));
+            high = cursor + glm::vec2(static_cast<float>(kPickRadius + 1));
+        } else if (lasso && m_Lasso.size() >= 3) {
+            region.lasso = m_Lasso;
+            for (const glm::vec2& point : m_Lasso) {
+                low = glm::min(low, point);
+                high = glm::max(high, point);
+            }
+        }
+        region.x = static_cast<int>(std::floor(low.x));
+        region.y = static_cast<int>(std::floor(low.y));
+        region.width = static_cast<int>(std::ceil(high.x)) - region.x;
+        region.height = static_cast<int>(std::ceil(high.y)) - region.y;
+        m_SelectPick = m_Renderer->RequestPick(region);
+        m_SelectAdds = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+                       glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+    }
+    
+    // Hovering follows the cursor; a newer hover replaces one still waiting
+    if (!m_Dragging && cursor != m_LastCursor) {
+        PickRegion region;
+        region.x = static_cast<int>(cursor.x) - kPickRadius;
+        region.y = static_cast<int>(cursor.y) - kPickRadius;
+        region.width = region.height = 2 * kPickRadius + 1;
+        region.transient = true;
+        m_HoverPick = m_Renderer->RequestPick(region);
+    }
+    m_LastCursor = cursor;
+}
+
+void Application::UpdatePicking() {
+    PickResult result;
+    while (m_Renderer->TakePick(*m_Model, result)) {
+        RequestRedraw();
+        Selection picked;
+        if (result.request == m_HoverPick || m_SelectNearest) {
+            // The single entity nearest the cursor, a node before the face it is on
+            if (result.hasCentreNode) {
+                picked.nodeIds.push_back(result.centreNodeId);
+            } else if (result.hasCentreElement) {
+                picked.elementIds.push_back(result.centreElementId);
+            }
+        } else {
+            picked.elementIds = std::move(result.elementIds);
+            picked.nodeIds = std::move(result.nodeIds);
+        }
+        
+        if (result.request == m_HoverPick) {
+            m_Hover = std::move(picked);
+        } else if (result.request == m_SelectPick) {
+            if (m_SelectAdds) {
+                m_Selection.elementIds = MergeIds(m_Selection.elementIds, picked.elementIds);
+                m_Selection.nodeIds = MergeIds(m_Selection.nodeIds, picked.nodeIds);
+            } else {
+                m_Selection = std::move(picked);
+            }
+            LOG_INFO("Selection: {} elements, {} nodes", m_Selection.elementIds.size(),
+                     m_Selection.nodeIds.size());
+            UpdateHighlight();
+        }
+    }
+}
+
+void Application::SelectElements(std::vector<int> elementIds) {
+    std::sort(elementIds.begin(), elementIds.end());
+    elementIds.erase(std::unique(elementIds.begin(), elementIds.end()), elementIds.end());
+    m_Selection.Clear();
+    m_Selection.elementIds = std::move(elementIds);
+    UpdateHighlight();
+    RequestRedraw();
+}
+
+void Application::UpdateHighlight() {
+    m_Renderer->SetHighlightedElements(m_Model.get(), m_Selection.elementIds);
+}
+
+void Application::EstimateTimeSteps() {
+    m_TimeSteps = std::make_unique<TimeStepReport>(TimeStepEstimator::Estimate(*m_Model));
+}
+
+NodeMergeResult Application::MergeNodes(float tolerance) {
+    if (m_ModelLoader->IsLoading()) {
+        return NodeMergeResult();
+    }
+    NodeMergeResult result = NodeMerger::Merge(*m_Model, tolerance);
+    if (result.removedNodes > 0) {
+        // Picked nodes may be gone
+        m_Selection.nodeIds.clear();
+        m_Hover.Clear();
+    }
+    return result;
+}
+
+bool Application::Undo() {
+    if (m_ModelLoader->IsLoading()) {
+        return false;
+    }
+    m_RestoringHistory = true;
+    bool undone = m_History->Undo(*m_Model);
+    m_RestoringHistory = false;
+    return undone;
+}
+
+bool Application::Redo() {
+    if (m_ModelLoader->IsLoading()) {
+        return false;
+    }
+    m_RestoringHistory = true;
+    bool redone = m_History->Redo(*m_Model);
+    m_RestoringHistory = false;
+    return redone;
 }
 
 void Application::Update(float deltaTime) {
+    PROFILE_SCOPE("Application::Update");
+    UpdateLoading();
+    UpdatePicking();
+    if (m_MeshOutdated && !m_Renderer->IsStreaming()) {
+        m_Renderer->RefreshMesh(m_Model.get());
+        m_MeshOutdated = false;
+    }
     m_Renderer->Update(deltaTime);
     
-    // Update solver status if running
-    if (m_SolverInterface->GetStatus() == SolverStatus::RUNNING) {
-        // Status updates handled by callbacks
+    // Collects finished runs and starts queued ones as cores free up
+    m_JobManager->Update();
+    if (m_Decomposition->Poll()) {
+        RequestRedraw();
     }
 }
 
 void Application::Render() {
+    PROFILE_SCOPE("Application::Render");
     m_Renderer->BeginFrame();
     
     // Render 3D scene
     m_Renderer->RenderModel(m_Model.get());
+    m_Renderer->PresentScene();
     
     // Render GUI
-    m_GuiManager->BeginFrame();
-    m_GuiManager->DrawMenuBar();
-    m_GuiManager->DrawToolBar();
-    m_GuiManager->DrawPropertyPanel();
-    m_GuiManager->DrawStatusBar();
-    m_GuiManager->DrawSolverDialog();
-    m_GuiManager->EndFrame();
+    {
+        PROFILE_SCOPE("GuiManager");
+        GpuTimer::Pass pass(m_Renderer->GetGpuTimer(), "GUI");
+        m_GuiManager->BeginFrame();
+        m_GuiManager->DrawMenuBar();
+        m_GuiManager->DrawToolBar();
+        m_GuiManager->DrawPropertyPanel();
+        m_GuiManager->DrawStatusBar();
+        m_GuiManager->DrawSolverDialog();
+        m_GuiManager->DrawLoadingDialog();
+        m_GuiManager->DrawContourPanel();
+        m_GuiManager->DrawSectionPanel();
+        m_GuiManager->DrawSolverLog();
+        m_GuiManager->DrawSolverProgress();
+        m_GuiManager->DrawJobManager();
+        m_GuiManager->DrawDecompositionPreview();
+        m_GuiManager->DrawTimeStepCheck();
+        m_GuiManager->DrawMeshQuality();
+        m_GuiManager->DrawMergeNodes();
+        m_GuiManager->DrawApplicationLog();
+        m_GuiManager->DrawStatistics();
+        m_GuiManager->EndFrame();
+    }
     
     m_Renderer->EndFrame();
 }
 
 void Application::LoadFile(const std::string& filepath) {
+    std::string root;
+    int state = 0;
+    if (ResultReader::ParseStateName(std::filesystem::path(filepath).filename().string(), root, state)) {
+        LoadResults(filepath);
+        return;
+    }
+    
+    // An engine listing of an earlier run, shown as its progress charts
+    if (std::filesystem::path(filepath).extension() == ".out") {
+        if (!m_SolverInterface->GetTelemetry().LoadListing(filepath, 0.0)) {
+            LOG_ERROR("Cannot read listing: {}", filepath);
+        } else {
+            m_ShownJob = 0;
+            m_GuiManager->ShowSolverProgress();
+        }
+        return;
+    }
     LOG_INFO("Loading file: {}", filepath);
     
-    try {
-        m_FileManager->LoadRadFile(filepath);
-        m_Renderer->UpdateMesh(m_Model.get());
-        LOG_INFO("File loaded successfully");
-    } catch (const std::exception& e) {
-        LOG_ERROR("Failed to load file: {}", e.what());
+    // Parsing runs on the loader thread; UpdateLoading picks up the results
+    m_ModelLoader->Start(filepath);
+    m_Renderer->BeginStreaming();
+}
+
+void Application::LoadResults(const std::string& filepath) {
+    LOG_INFO("Loading results: {}", filepath);
+    
+    // States are matched to the open model and decoded as playback reaches them
+    auto reader = std::make_shared<ResultReader>();
+    if (!reader->Open(filepath, *m_Model)) {
+        LOG_ERROR("Failed to load results: {}", reader->GetError());
+        return;
+    }
+    m_Results = std::make_shared<ResultCache>(std::move(reader));
+    m_Renderer->SetAnimation(std::make_unique<ResultDisplacementSource>(m_Results));
+    m_Renderer->SetContourResults(m_Results);
+}
+
+void Application::UpdateLoading() {
+    if (!m_Renderer->IsStreaming()) {
+        return;
+    }
+    
+    // Read the status first: geometry published before it is then in the queue
+    LoadStatus status = m_ModelLoader->GetStatus();
+    
+    glm::vec3 center;
+    float radius;
+    if (m_ModelLoader->TakeBounds(center, radius)) {
+        m_Renderer->GetCamera()->FitToBounds(center, radius);
+    }
+    
+    MeshData data;
+    if (m_ModelLoader->TakeMeshData(data)) {
+        m_Renderer->AppendMeshData(std::move(data));
+    }
+    m_Renderer->ContinueUpload(kUploadBudgetPerFrame);
+    
+    switch (status) {
+        case LoadStatus::FINISHED:
+            if (!m_Renderer->HasPendingUpload() && m_ModelLoader->TakeModel(*m_Model)) {
+                m_FileManager->SetCurrentFile(m_ModelLoader->GetFilePath());
+                m_History->Reset(*m_Model);
+                m_Selection.Clear();
+                m_Hover.Clear();
+                m_TimeSteps.reset();
+                m_Quality->Clear();
+                m_Renderer->FinishStreaming();
+                UpdateHighlight();
+                m_Results.reset();
+                m_Renderer->SetContourResults(nullptr);
+                m_Renderer->SetAnimation(m_Model->HasNodeKinematics()
+                    ? std::make_unique<StaticDisplacementSource>(m_Model->GetNodeDisplacements())
+                    : nullptr);
+                LOG_INFO("File loaded successfully");
+            }
+            break;
+        case LoadStatus::FAILED:
+            LOG_ERROR("Failed to load file: {}", m_ModelLoader->GetError());
+            m_Renderer->CancelStreaming();
+            break;
+        case LoadStatus::CANCELLED:
+            LOG_INFO("Loading cancelled");
+            m_Renderer->CancelStreaming();
+            break;
+        default:
+            break;
     }
 }
 
@@ -150,6 +620,9 @@ void Application::SaveFile(const std::string& filepath) {
 void Application::Shutdown() {
     LOG_INFO("Shutting down application...");
     
+    m_ModelLoader.reset();
+    m_JobManager.reset();
+    m_Decomposition.reset();
     m_GuiManager->Shutdown();
     m_Renderer->Shutdown();
     
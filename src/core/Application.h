@@ -1,12 +1,34 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
+#include <glm/glm.hpp>
 
 class Model;
 class Renderer;
 class GuiManager;
 class FileManager;
 class SolverInterface;
+class JobManager;
+class DecompositionPreview;
+class MeshQuality;
+struct TimeStepReport;
+struct NodeMergeResult;
+class ModelLoader;
+class ModelHistory;
+class ResultCache;
+struct GLFWwindow;
+
+// Model entities by ID, each list sorted
+struct Selection {
+    std::vector<int> elementIds;
+    std::vector<int> nodeIds;
+    
+    void Clear() { elementIds.clear(); nodeIds.clear(); }
+    bool Empty() const { return elementIds.empty() && nodeIds.empty(); }
+};
 
 class Application {
 public:
@@ -15,26 +37,109 @@ public:
     
     void Run();
     void LoadFile(const std::string& filepath);
+    void LoadResults(const std::string& filepath);
     void SaveFile(const std::string& filepath);
     void Shutdown();
     
     // Getters
     Model* GetModel() { return m_Model.get(); }
     Renderer* GetRenderer() { return m_Renderer.get(); }
+    ModelLoader* GetModelLoader() { return m_ModelLoader.get(); }
+    ResultCache* GetResults() { return m_Results.get(); }
+    JobManager* GetJobManager() { return m_JobManager.get(); }
+    
+    // Run whose output and progress the solver windows show: a job's, or
+    // with none chosen, or once its output is released, the last listing
+    // opened
+    SolverInterface* GetSolverInterface();
+    uint64_t GetShownJob() const { return m_ShownJob; }
+    void ShowJob(uint64_t id) { m_ShownJob = id; }
+    
+    // Balance of the open model over each rank count, worked out in the
+    // background
+    DecompositionPreview* GetDecompositionPreview() { return m_Decomposition.get(); }
+    void StartDecompositionPreview(const std::vector<int>& rankCounts);
+    
+    // Click picks what is under the cursor, dragging selects a box, and
+    // dragging with Alt a lasso; Shift adds to the selection
+    const Selection& GetSelection() const { return m_Selection; }
+    const Selection& GetHover() const { return m_Hover; }
+    void SelectElements(std::vector<int> elementIds);   // Replaces the selection
+    
+    // Stable step of each element of the open model, as of the last
+    // estimate; null until one is made or once another model is opened
+    const TimeStepReport* GetTimeStepReport() const { return m_TimeSteps.get(); }
+    void EstimateTimeSteps();
+    
+    // Quality of the open model's elements, empty until it is evaluated
+    MeshQuality* GetMeshQuality() { return m_Quality.get(); }
+    
+    // Model edits, one step per committed change
+    bool Undo();
+    bool Redo();
+    
+    // Equivalences the nodes within tolerance of each other
+    NodeMergeResult MergeNodes(float tolerance);
+    
+    // Frames are drawn only when something changed. Input, edits, loading,
+    // playback and picks are seen by the loop; anything else that changes
+    // what is shown asks for a redraw.
+    void RequestRedraw();
     
 private:
     void Initialize();
+    void InstallCallbacks(GLFWwindow* window);
+    bool NeedsFrame() const;
+    void WakeFromWorker();   // Any thread
     void Update(float deltaTime);
     void Render();
     void ProcessInput();
+    void ProcessCamera();
+    void UpdateLoading();
+    void ProcessPicking();
+    void UpdatePicking();
+    void UpdateHighlight();   // Draws the selected elements highlighted
     
 private:
     std::unique_ptr<Model> m_Model;
     std::unique_ptr<Renderer> m_Renderer;
     std::unique_ptr<GuiManager> m_GuiManager;
     std::unique_ptr<FileManager> m_FileManager;
-    std::unique_ptr<SolverInterface> m_SolverInterface;
+    std::unique_ptr<SolverInterface> m_SolverInterface;   // Holds opened listings; runs go through the jobs
+    std::unique_ptr<JobManager> m_JobManager;
+    std::unique_ptr<DecompositionPreview> m_Decomposition;
+    std::unique_ptr<TimeStepReport> m_TimeSteps;
+    std::unique_ptr<MeshQuality> m_Quality;
+    uint64_t m_ShownJob = 0;
+    std::unique_ptr<ModelLoader> m_ModelLoader;
+    std::unique_ptr<ModelHistory> m_History;
+    std::shared_ptr<ResultCache> m_Results;   // Shared with the animation
     
     bool m_Running;
+    bool m_MeshOutdated = false;
+    bool m_RestoringHistory = false;   // Restores are not recorded as edits
+    bool m_UndoKeyDown = false;
+    bool m_RedoKeyDown = false;
+    
+    // Frames still owed, and solver output or worker results since the
+    // last one, which arrive on other threads
+    int m_RedrawFrames = 0;
+    std::atomic<bool> m_SolverChanged{false};
+    
+    // Orbiting with the right or middle button draws interactive frames
+    bool m_Orbiting = false;
+    glm::vec2 m_OrbitCursor = glm::vec2(0.0f);
+    
+    // Picks in flight, by request number, and what they found
+    uint64_t m_HoverPick = 0;
+    uint64_t m_SelectPick = 0;
+    bool m_SelectAdds = false;
+    bool m_SelectNearest = false;   // A click keeps only what is nearest the cursor
+    bool m_Dragging = false;
+    glm::vec2 m_DragStart = glm::vec2(0.0f);
+    glm::vec2 m_LastCursor = glm::vec2(-1.0f);
+    std::vector<glm::vec2> m_Lasso;
+    Selection m_Selection;
+    Selection m_Hover;
     float m_LastFrameTime;
 };
\ No newline at end of file
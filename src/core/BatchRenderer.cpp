@@ -0,0 +1,405 @@
+#include "core/BatchRenderer.h"
+#include "core/ModelLoader.h"
+#include "io/ImageWriter.h"
+#include "io/ResultCache.h"
+#include "io/ResultReader.h"
+#include "rendering/AnimationStream.h"
+#include "rendering/Camera.h"
+#include "utils/Config.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// How long a result state may take to decode before the job gives up
+constexpr auto kStateTimeout = std::chrono::seconds(60);
+
+std::string ResolvePath(const std::filesystem::path& base, const std::string& path) {
+    if (path.empty()) {
+        return path;
+    }
+    std::filesystem::path resolved(path);
+    return resolved.is_absolute() ? path : (base / resolved).string();
+}
+
+void LoadSettings(const Config& config, RenderSettings& settings) {
+    const std::string prefix = "settings.";
+    settings.showNodes = config.GetBool(prefix + "showNodes", settings.showNodes);
+    settings.showWireframe = config.GetBool(prefix + "showWireframe", settings.showWireframe);
+    settings.showSolid = config.GetBool(prefix + "showSolid", settings.showSolid);
+    settings.enableLighting = config.GetBool(prefix + "enableLighting", settings.enableLighting);
+    settings.levelOfDetail = config.GetBool(prefix + "levelOfDetail", settings.levelOfDetail);
+    settings.smoothShading = config.GetBool(prefix + "smoothShading", settings.smoothShading);
+    settings.featureAngle = float(config.GetNumber(prefix + "featureAngle", settings.featureAngle));
+    
+    std::string colorMode = config.GetString(prefix + "colorMode", "");
+    if (colorMode == "single") {
+        settings.colorMode = ColorMode::SINGLE;
+    } else if (colorMode == "part") {
+        settings.colorMode = ColorMode::PART;
+    } else if (colorMode == "material") {
+        settings.colorMode = ColorMode::MATERIAL;
+    } else if (colorMode == "contour") {
+        settings.colorMode = ColorMode::CONTOUR;
+    }
+    
+    ContourSettings& contour = settings.contour;
+    contour.field = config.GetInt(prefix + "contour.field", contour.field);
+    contour.nodal = config.GetBool(prefix + "contour.nodal", contour.nodal);
+    contour.bands = config.GetInt(prefix + "contour.bands", contour.bands);
+    std::string colormap = config.GetString(prefix + "contour.colormap", "");
+    if (colormap == "rainbow") {
+        contour.colormap = Colormap::RAINBOW;
+    } else if (colormap == "viridis") {
+        contour.colormap = Colormap::VIRIDIS;
+    } else if (colormap == "coolwarm") {
+        contour.colormap = Colormap::COOL_WARM;
+    } else if (colormap == "grayscale") {
+        contour.colormap = Colormap::GRAYSCALE;
+    }
+    if (config.GetArraySize(prefix + "contour.range") == 2) {
+        contour.autoRange = false;
+        contour.rangeMin = float(config.GetNumber(prefix + "contour.range.0", contour.rangeMin));
+        contour.rangeMax = float(config.GetNumber(prefix + "contour.range.1", contour.rangeMax));
+    }
+    
+    settings.backgroundColor = config.GetVec3(prefix + "backgroundColor", settings.backgroundColor);
+    settings.nodeColor = config.GetVec3(prefix + "nodeColor", settings.nodeColor);
+    settings.wireframeColor = config.GetVec3(prefix + "wireframeColor", settings.wireframeColor);
+    settings.solidColor = config.GetVec3(prefix + "solidColor", settings.solidColor);
+    settings.nodeSize = float(config.GetNumber(prefix + "nodeSize", settings.nodeSize));
+    settings.lineWidth = float(config.GetNumber(prefix + "lineWidth", settings.lineWidth));
+    settings.displacementScale = float(config.GetNumber(prefix + "displacementScale",
+                                                        settings.displacementScale));
+    
+    // Section planes as {"normal": [x, y, z], "offset": d}
+    const size_t planeCount = std::min<size_t>(config.GetArraySize(prefix + "clipPlanes"), kMaxClipPlanes);
+    for (size_t i = 0; i < planeCount; ++i) {
+        const std::string key = prefix + "clipPlanes." + std::to_string(i) + ".";
+        ClipPlane& plane = settings.clipPlanes[i];
+        plane.enabled = config.GetBool(key + "enabled", true);
+        plane.normal = config.GetVec3(key + "normal", plane.normal);
+        plane.offset = float(config.GetNumber(key + "offset", plane.offset));
+    }
+    settings.capSections = config.GetBool(prefix + "capSections", settings.capSections);
+    settings.capColor = config.GetVec3(prefix + "capColor", settings.capColor);
+}
+
+} // namespace
+
+bool BatchJob::Load(const std::string& filepath, BatchJob& job, std::string& error) {
+    Config config;
+    if (!config.Load(filepath)) {
+        error = config.GetError();
+        return false;
+    }
+    
+    std::filesystem::path base = std::filesystem::path(filepath).parent_path();
+    job = BatchJob();
+    job.deckPath = ResolvePath(base, config.GetString("deck", ""));
+    job.resultPath = ResolvePath(base, config.GetString("results", ""));
+    job.outputDir = ResolvePath(base, config.GetString("output", "."));
+    job.width = config.GetInt("width", job.width);
+    job.height = config.GetInt("height", job.height);
+    if (job.deckPath.empty()) {
+        error = "Job has no deck";
+        return false;
+    }
+    if (job.width <= 0 || job.height <= 0) {
+        error = "Job image size must be positive";
+        return false;
+    }
+    
+    size_t stateCount = config.GetArraySize("states");
+    for (size_t i = 0; i < stateCount; ++i) {
+        int state = config.GetInt("states." + std::to_string(i), -1);
+        if (state < 0) {
+            error = "Job states must be non-negative integers";
+            return false;
+        }
+        job.states.push_back(size_t(state));
+    }
+    
+    LoadSettings(config, job.settings);
+    job.contourField = config.GetString("settings.contour.field", "");
+    
+    size_t viewCount = config.GetArraySize("views");
+    for (size_t i = 0; i < viewCount; ++i) {
+        std::string prefix = "views." + std::to_string(i) + ".";
+        BatchView view;
+        view.name = config.GetString(prefix + "name", "view" + std::to_string(i));
+        view.yaw = float(config.GetNumber(prefix + "yaw", view.yaw));
+        view.pitch = float(config.GetNumber(prefix + "pitch", view.pitch));
+        view.zoom = float(config.GetNumber(prefix + "zoom", view.zoom));
+        job.views.push_back(view);
+    }
+    if (job.views.empty()) {
+        BatchView front;
+        front.name = "front";
+        job.views.push_back(front);
+    }
+    return true;
+}
+
+BatchRenderer::BatchRenderer() = default;
+
+BatchRenderer::~BatchRenderer() {
+    CollectEncodes(0);
+    DestroyTargets();
+}
+
+bool BatchRenderer::Run(const BatchJob& job) {
+    auto start = std::chrono::steady_clock::now();
+    m_Width = job.width;
+    m_Height = job.height;
+    m_ImagesWritten = 0;
+    m_Failures = 0;
+    
+    if (!LoadModel(job.deckPath)) {
+        return false;
+    }
+    
+    std::error_code created;
+    std::filesystem::create_directories(job.outputDir, created);
+    if (created) {
+        LOG_ERROR("Cannot create output directory {}: {}", job.outputDir, created.message());
+        return false;
+    }
+    
+    try {
+        CreateTargets();
+        m_Renderer = std::make_unique<Renderer>(nullptr);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Cannot set up rendering: {}", e.what());
+        return false;
+    }
+    m_Renderer->SetSettings(job.settings);
+    m_Renderer->UpdateMesh(&m_Model);
+    float fitDistance = m_Renderer->GetCamera()->GetDistance();
+    
+    // Result states are shown in order, each drawn from every view
+    std::vector<size_t> states = job.states;
+    if (!job.resultPath.empty()) {
+        auto reader = std::make_shared<ResultReader>();
+        if (!reader->Open(job.resultPath, m_Model)) {
+            LOG_ERROR("Failed to load results: {}", reader->GetError());
+            return false;
+        }
+        if (!job.contourField.empty()) {
+            const std::vector<std::string>& fields = reader->GetElementScalarNames();
+            auto found = std::find(fields.begin(), fields.end(), job.contourField);
+            if (found == fields.end()) {
+                LOG_ERROR("Results have no field {}", job.contourField);
+                return false;
+            }
+            m_Renderer->GetSettings().contour.field = static_cast<int>(found - fields.begin());
+        }
+        m_Results = std::make_shared<ResultCache>(std::move(reader));
+        m_Renderer->SetAnimation(std::make_unique<ResultDisplacementSource>(m_Results));
+        m_Renderer->SetContourResults(m_Results);
+        m_Renderer->GetAnimation()->Pause();
+        if (states.empty()) {
+            for (size_t state = 0; state < m_Results->GetStateCount(); ++state) {
+                states.push_back(state);
+            }
+        }
+    }
+    
+    std::filesystem::path output(job.outputDir);
+    auto render = [&](const std::string& suffix) {
+        for (const BatchView& view : job.views) {
+            RenderView(view, fitDistance, (output / (view.name + suffix + ".png")).string());
+        }
+    };
+    if (m_Results) {
+        for (size_t state : states) {
+            if (!ShowState(state)) {
+                ++m_Failures;
+                continue;
+            }
+            char suffix[32];
+            std::snprintf(suffix, sizeof(suffix), "_%04zu", state);
+            render(suffix);
+        }
+    } else {
+        render("");
+    }
+    
+    for (int i = 0; i < kTargetCount; ++i) {
+        FinishReadback(m_Targets[(m_NextTarget + i) % kTargetCount]);
+    }
+    CollectEncodes(0);
+    
+    m_Renderer.reset();
+    m_Results.reset();
+    DestroyTargets();
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Batch wrote {} images to {} in {} s", m_ImagesWritten, job.outputDir, seconds);
+    if (m_Failures > 0) {
+        LOG_ERROR("Batch had {} failures", m_Failures);
+    }
+    return m_Failures == 0;
+}
+
+bool BatchRenderer::LoadModel(const std::string& deckPath) {
+    LOG_INFO("Loading file: {}", deckPath);
+    
+    // The loader streams geometry for display; batch runs only need the
+    // finished model, so the stream is drained and dropped
+    ModelLoader loader;
+    loader.Start(deckPath);
+    MeshData data;
+    while (loader.IsLoading()) {
+        while (loader.TakeMeshData(data)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    while (loader.TakeMeshData(data)) {
+    }
+    if (!loader.TakeModel(m_Model)) {
+        LOG_ERROR("Failed to load file: {}", loader.GetError());
+        return false;
+    }
+    return true;
+}
+
+bool BatchRenderer::ShowState(size_t state) {
+    AnimationStream* animation = m_Renderer->GetAnimation();
+    if (state >= animation->GetFrameCount()) {
+        LOG_ERROR("State {} is past the last of {} states", state, animation->GetFrameCount());
+        return false;
+    }
+    
+    // Decoding runs on the stream's thread; Update binds it once uploaded
+    animation->Seek(state);
+    auto deadline = std::chrono::steady_clock::now() + kStateTimeout;
+    while (true) {
+        m_Renderer->Update(0.0f);
+        if (animation->GetCurrentFrame() == state) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            LOG_ERROR("State {} could not be read", state);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void BatchRenderer::RenderView(const BatchView& view, float fitDistance, const std::string& path) {
+    // The target comes round again after kTargetCount frames, by which time
+    // its readback has long finished
+    Target& target = m_Targets[m_NextTarget];
+    m_NextTarget = (m_NextTarget + 1) % kTargetCount;
+    FinishReadback(target);
+    
+    m_Renderer->SetRenderTarget(target.framebuffer, m_Width, m_Height);
+    m_Renderer->GetCamera()->SetOrbit(view.yaw, view.pitch, fitDistance * view.zoom);
+    m_Renderer->BeginFrame();
+    m_Renderer->RenderModel(&m_Model);
+    m_Renderer->PresentScene();
+    m_Renderer->EndFrame();
+    
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, target.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    target.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    target.path = path;
+    glFlush();
+}
+
+void BatchRenderer::FinishReadback(Target& target) {
+    if (!target.fence) {
+        return;
+    }
+    GLsync fence = static_cast<GLsync>(target.fence);
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    target.fence = nullptr;
+    
+    size_t bytes = size_t(m_Width) * size_t(m_Height) * 4;
+    auto pixels = std::make_shared<std::vector<uint8_t>>(bytes);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, target.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(bytes), GL_MAP_READ_BIT);
+    if (!mapped) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        LOG_ERROR("Cannot read back {}", target.path);
+        ++m_Failures;
+        return;
+    }
+    std::memcpy(pixels->data(), mapped, bytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    // Encoders are bounded so pending images cannot pile up in memory
+    CollectEncodes(ThreadPool::GetGlobal().GetThreadCount() * 2);
+    int width = m_Width, height = m_Height;
+    std::string path = target.path;
+    m_Encodes.push_back(ThreadPool::GetGlobal().Submit([pixels, width, height, path]() {
+        return ImageWriter::WritePNG(path, width, height, pixels->data(), true);
+    }));
+}
+
+void BatchRenderer::CollectEncodes(size_t maxPending) {
+    while (m_Encodes.size() > maxPending) {
+        if (m_Encodes.front().get()) {
+            ++m_ImagesWritten;
+        } else {
+            ++m_Failures;
+        }
+        m_Encodes.pop_front();
+    }
+}
+
+void BatchRenderer::CreateTargets() {
+    for (Target& target : m_Targets) {
+        glGenFramebuffers(1, &target.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        
+        glGenRenderbuffers(1, &target.color);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_Width, m_Height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+        
+        glGenRenderbuffers(1, &target.depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_Width, m_Height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+        
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            throw std::runtime_error("Incomplete batch framebuffer");
+        }
+        
+        glGenBuffers(1, &target.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, target.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(m_Width) * m_Height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_NextTarget = 0;
+}
+
+void BatchRenderer::DestroyTargets() {
+    for (Target& target : m_Targets) {
+        if (target.fence) glDeleteSync(static_cast<GLsync>(target.fence));
+        if (target.buffer) glDeleteBuffers(1, &target.buffer);
+        if (target.depth) glDeleteRenderbuffers(1, &target.depth);
+        if (target.color) glDeleteRenderbuffers(1, &target.color);
+        if (target.framebuffer) glDeleteFramebuffers(1, &target.framebuffer);
+        target = Target();
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "core/Model.h"
+#include "rendering/Renderer.h"
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ResultCache;
+
+// A camera around the model's centre, as the GUI orbits it
+struct BatchView {
+    std::string name;          // Output file stem
+    float yaw = -90.0f;        // Degrees, like Camera
+    float pitch = 0.0f;
+    float zoom = 1.0f;         // Distance relative to fitting the model
+};
+
+// What a batch run renders, read from a JSON job file:
+//
+//   { "deck": "crash_0000.rad", "results": "crashA001", "states": [0, 10, 20],
+//     "output": "renders", "width": 1920, "height": 1080,
+//     "settings": { "showSolid": true, "colorMode": "part", ... },
+//     "views": [ { "name": "iso", "yaw": -45, "pitch": 30, "zoom": 1.0 } ] }
+//
+// Paths are relative to the job file. Without results the deck is drawn
+// undeformed; without states every state of the results is drawn.
+// Settings use RenderSettings' names, colours as [r, g, b]. Fringes take
+// "colorMode": "contour" and a "contour" object: "field" (name or index),
+// "nodal", "bands", "colormap" (rainbow, viridis, coolwarm, grayscale) and
+// an optional fixed "range": [min, max].
+struct BatchJob {
+    std::string deckPath;
+    std::string resultPath;
+    std::vector<size_t> states;
+    std::string outputDir;
+    int width = 1920;
+    int height = 1080;
+    RenderSettings settings;
+    std::string contourField;   // By name, resolved once the results are open
+    std::vector<BatchView> views;
+    
+    static bool Load(const std::string& filepath, BatchJob& job, std::string& error);
+};
+
+// Renders a job into PNG files without a window, in a context made current
+// by the caller (HeadlessContext). The deck is parsed and meshed once and
+// every view of every state is drawn from the same GPU buffers; states are
+// the outer loop so each is decoded once.
+//
+// Views are drawn back to back into a ring of kTargetCount framebuffers.
+// Each frame's pixels are read back into a pixel buffer behind a fence and
+// only mapped when its target comes round again, by which time the GPU is
+// done with it; PNG encoding runs on the thread pool. The render thread
+// therefore never waits on a readback or an encoder while the GPU has work.
+class BatchRenderer {
+public:
+    static constexpr int kTargetCount = 3;
+    
+    BatchRenderer();
+    ~BatchRenderer();
+    
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+    
+    // False when the deck or results cannot be read or an image fails;
+    // the reasons are logged
+    bool Run(const BatchJob& job);
+    size_t GetImagesWritten() const { return m_ImagesWritten; }
+
+private:
+    struct Target {
+        unsigned int framebuffer = 0;
+        unsigned int color = 0;      // Renderbuffers
+        unsigned int depth = 0;
+        unsigned int buffer = 0;     // Pixel pack buffer
+        void* fence = nullptr;       // GLsync after the readback
+        std::string path;            // Image the readback is for
+    };
+    
+    bool LoadModel(const std::string& deckPath);
+    bool ShowState(size_t state);
+    void RenderView(const BatchView& view, float fitDistance, const std::string& path);
+    void CreateTargets();
+    void DestroyTargets();
+    void FinishReadback(Target& target);
+    void CollectEncodes(size_t maxPending);
+
+private:
+    Model m_Model;
+    std::unique_ptr<Renderer> m_Renderer;
+    std::shared_ptr<ResultCache> m_Results;
+    int m_Width = 0;
+    int m_Height = 0;
+    
+    Target m_Targets[kTargetCount];
+    int m_NextTarget = 0;
+    std::deque<std::future<bool>> m_Encodes;
+    size_t m_ImagesWritten = 0;
+    size_t m_Failures = 0;
+};
@@ -0,0 +1,296 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+// Column of values held in reference-counted chunks of at most kChunkSize
+// entries. Copying a column copies its chunk table, not the values, and a
+// write to a chunk that another copy still holds clones that chunk first,
+// so copies cost a few bytes per chunk and drift apart one chunk at a time.
+// Columns describing the same entities keep their chunk boundaries in step
+// (see NodeArrays and ElementArrays), so a chunk index names the same
+// entities in each. Reads are safe from any number of threads; writes need
+// the column to themselves.
+template<typename T>
+class ChunkedColumn {
+public:
+    static constexpr size_t kChunkSize = 1u << 16;
+    using value_type = T;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *m_Value; }
+        pointer operator->() const { return m_Value; }
+        const_iterator& operator++() {
+            ++m_Index;
+            if (++m_Value == m_ChunkEnd) {
+                Enter(m_Chunk + 1);
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const { return m_Index == other.m_Index; }
+        bool operator!=(const const_iterator& other) const { return m_Index != other.m_Index; }
+
+    private:
+        friend class ChunkedColumn;
+
+        const_iterator(const ChunkedColumn* column, size_t index) : m_Column(column), m_Index(index) {
+            if (index < column->size()) {
+                m_Chunk = column->FindChunk(index);
+                const T* data = column->GetChunkData(m_Chunk);
+                m_Value = data + (index - column->m_Offsets[m_Chunk]);
+                m_ChunkEnd = data + column->GetChunkSize(m_Chunk);
+            }
+        }
+
+        // Empty chunks are stepped over
+        void Enter(size_t chunk) {
+            while (chunk < m_Column->GetChunkCount() && m_Column->GetChunkSize(chunk) == 0) {
+                ++chunk;
+            }
+            m_Chunk = chunk;
+            if (chunk < m_Column->GetChunkCount()) {
+                m_Value = m_Column->GetChunkData(chunk);
+                m_ChunkEnd = m_Value + m_Column->GetChunkSize(chunk);
+            }
+        }
+
+        const ChunkedColumn* m_Column = nullptr;
+        size_t m_Index = 0;
+        size_t m_Chunk = 0;
+        const T* m_Value = nullptr;
+        const T* m_ChunkEnd = nullptr;
+    };
+
+    size_t size() const { return m_Offsets.back(); }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return std::max(m_Reserved, size()); }
+
+    const T& operator[](size_t index) const {
+        size_t chunk = FindChunk(index);
+        return (*m_Chunks[chunk])[index - m_Offsets[chunk]];
+    }
+    const T& back() const { return (*this)[size() - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    // Chunk holding index, which must be below size(). A page table gives
+    // the chunk at the start of each page, so this is a lookup and, where
+    // removals left chunks shorter than a page, a short forward scan.
+    size_t FindChunk(size_t index) const {
+        size_t chunk = m_Pages[index >> kPageShift];
+        while (m_Offsets[chunk + 1] <= index) {
+            ++chunk;
+        }
+        return chunk;
+    }
+
+    size_t GetChunkCount() const { return m_Chunks.size(); }
+    size_t GetChunkOffset(size_t chunk) const { return m_Offsets[chunk]; }
+    size_t GetChunkSize(size_t chunk) const { return m_Offsets[chunk + 1] - m_Offsets[chunk]; }
+    const T* GetChunkData(size_t chunk) const { return m_Chunks[chunk]->data(); }
+
+    // True when both columns hold the very same chunk, so its values match
+    bool SharesChunk(size_t chunk, const ChunkedColumn& other, size_t otherChunk) const {
+        return m_Chunks[chunk] == other.m_Chunks[otherChunk];
+    }
+    const void* GetChunkKey(size_t chunk) const { return m_Chunks[chunk].get(); }
+
+    // fn(const T* data, size_t count, size_t first) over the contiguous runs
+    // of entries [first, last)
+    template<typename Fn>
+    void ForEachSpan(size_t first, size_t last, Fn&& fn) const {
+        last = std::min(last, size());
+        if (first >= last) {
+            return;
+        }
+        for (size_t chunk = FindChunk(first); chunk < m_Chunks.size() && m_Offsets[chunk] < last; ++chunk) {
+            size_t begin = std::max(first, m_Offsets[chunk]);
+            size_t end = std::min(last, m_Offsets[chunk + 1]);
+            if (begin < end) {
+                fn(m_Chunks[chunk]->data() + (begin - m_Offsets[chunk]), end - begin, begin);
+            }
+        }
+    }
+    template<typename Fn>
+    void ForEachSpan(Fn&& fn) const {
+        ForEachSpan(0, size(), std::forward<Fn>(fn));
+    }
+
+    void CopyTo(std::vector<T>& out) const {
+        out.clear();
+        out.reserve(size());
+        ForEachSpan([&](const T* data, size_t count, size_t) { out.insert(out.end(), data, data + count); });
+    }
+
+    // The chunk tables alone are what a copy of the column costs
+    size_t GetTableBytes() const {
+        return m_Chunks.capacity() * sizeof(m_Chunks[0]) + m_Offsets.capacity() * sizeof(size_t) +
+               m_Pages.capacity() * sizeof(uint32_t);
+    }
+    size_t GetMemoryBytes() const {
+        size_t bytes = GetTableBytes();
+        for (const auto& chunk : m_Chunks) {
+            bytes += chunk->capacity() * sizeof(T);
+        }
+        return bytes;
+    }
+
+    // Writing. Appends open a new chunk once the last one is full.
+    void push_back(const T& value) {
+        if (m_Chunks.empty() || m_Chunks.back()->size() >= kChunkSize) {
+            AddChunk();
+        } else {
+            Unshare(m_Chunks.size() - 1);
+        }
+        m_Chunks.back()->push_back(value);
+        Grow(1);
+    }
+
+    // For columns whose chunks follow another column's: the run goes to a
+    // new chunk when newChunk is set, even if it is empty
+    void Append(const T* data, size_t count, bool newChunk) {
+        if (m_Chunks.empty() || newChunk) {
+            AddChunk();
+        } else {
+            Unshare(m_Chunks.size() - 1);
+        }
+        m_Chunks.back()->insert(m_Chunks.back()->end(), data, data + count);
+        Grow(count);
+    }
+
+    void assign(const std::vector<T>& values) {
+        clear();
+        for (size_t first = 0; first < values.size(); first += kChunkSize) {
+            size_t count = std::min(kChunkSize, values.size() - first);
+            Append(values.data() + first, count, true);
+        }
+    }
+
+    void reserve(size_t count) {
+        m_Reserved = std::max(m_Reserved, count);
+        m_Chunks.reserve(count / kChunkSize + 1);
+        m_Offsets.reserve(count / kChunkSize + 2);
+        m_Pages.reserve((count >> kPageShift) + 1);
+    }
+
+    void clear() {
+        m_Chunks = std::vector<std::shared_ptr<std::vector<T>>>();
+        m_Offsets.assign(1, 0);
+        m_Pages = std::vector<uint32_t>();
+        m_Reserved = 0;
+    }
+
+    // Drops the entries marked in removed; those past its end are kept.
+    // Only chunks holding a marked entry are rewritten and the ones left
+    // empty are dropped, so columns in step stay in step.
+    void Remove(const std::vector<char>& removed) {
+        std::vector<char> erased(m_Chunks.size(), 0);
+        for (size_t chunk = 0; chunk < m_Chunks.size(); ++chunk) {
+            size_t first = m_Offsets[chunk];
+            size_t last = std::min(m_Offsets[chunk + 1], removed.size());
+            if (first >= last || std::find(removed.begin() + first, removed.begin() + last, 1) ==
+                                     removed.begin() + last) {
+                continue;
+            }
+            std::vector<T> kept;
+            kept.reserve(GetChunkSize(chunk));
+            for (size_t i = first; i < m_Offsets[chunk + 1]; ++i) {
+                if (i >= removed.size() || !removed[i]) {
+                    kept.push_back((*m_Chunks[chunk])[i - first]);
+                }
+            }
+            erased[chunk] = kept.empty();
+            ReplaceChunk(chunk, std::move(kept));
+        }
+        EraseChunks(erased);
+        Reindex();
+    }
+
+    // The chunk's values, to change in place; cloned first while shared
+    T* MutableChunk(size_t chunk) {
+        Unshare(chunk);
+        return m_Chunks[chunk]->data();
+    }
+    void Set(size_t index, const T& value) {
+        size_t chunk = FindChunk(index);
+        MutableChunk(chunk)[index - m_Offsets[chunk]] = value;
+    }
+
+    // Structural edits for the arrays, which keep their columns in step.
+    // Each leaves the lookup stale until Reindex.
+    void ReplaceChunk(size_t chunk, std::vector<T>&& values) {
+        m_Chunks[chunk] = std::make_shared<std::vector<T>>(std::move(values));
+    }
+    void EraseChunks(const std::vector<char>& erased) {
+        size_t kept = 0;
+        for (size_t chunk = 0; chunk < m_Chunks.size(); ++chunk) {
+            if (chunk >= erased.size() || !erased[chunk]) {
+                m_Chunks[kept++] = std::move(m_Chunks[chunk]);
+            }
+        }
+        m_Chunks.resize(kept);
+    }
+    void Reindex() {
+        m_Offsets.resize(m_Chunks.size() + 1);
+        m_Offsets[0] = 0;
+        for (size_t chunk = 0; chunk < m_Chunks.size(); ++chunk) {
+            m_Offsets[chunk + 1] = m_Offsets[chunk] + m_Chunks[chunk]->size();
+        }
+        m_Pages.resize((size() + kPageSize - 1) >> kPageShift);
+        size_t chunk = 0;
+        for (size_t page = 0; page < m_Pages.size(); ++page) {
+            while (m_Offsets[chunk + 1] <= (page << kPageShift)) {
+                ++chunk;
+            }
+            m_Pages[page] = static_cast<uint32_t>(chunk);
+        }
+    }
+
+private:
+    static constexpr size_t kPageShift = 12;
+    static constexpr size_t kPageSize = size_t(1) << kPageShift;
+
+    void AddChunk() {
+        m_Chunks.push_back(std::make_shared<std::vector<T>>());
+        m_Offsets.push_back(m_Offsets.back());
+    }
+
+    void Unshare(size_t chunk) {
+        if (m_Chunks[chunk].use_count() > 1) {
+            m_Chunks[chunk] = std::make_shared<std::vector<T>>(*m_Chunks[chunk]);
+        }
+    }
+
+    // Appended entries are in the last chunk, and so are the pages they start
+    void Grow(size_t count) {
+        size_t before = m_Offsets.back();
+        m_Offsets.back() += count;
+        for (size_t page = (before + kPageSize - 1) >> kPageShift; (page << kPageShift) < size(); ++page) {
+            m_Pages.push_back(static_cast<uint32_t>(m_Chunks.size() - 1));
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<std::vector<T>>> m_Chunks;
+    std::vector<size_t> m_Offsets = std::vector<size_t>(1, 0);   // Chunk starts, then size()
+    std::vector<uint32_t> m_Pages;       // Chunk at the start of each page
+    size_t m_Reserved = 0;
+};
@@ -1,4 +1,5 @@
 #include "core/Element.h"
+#include <algorithm>
 
 ElementType Element::StringToType(const std::string& typeStr) {
     if (typeStr == "SH3N") return ElementType::SHELL3;
@@ -33,3 +34,161 @@ int Element::GetNodeCount(ElementType type) {
         default: return 0;
     }
 }
+
+void ElementArrays::Reserve(size_t elementCount, size_t nodeIdCount) {
+    ids.reserve(elementCount);
+    materialIds.reserve(elementCount);
+    propertyIds.reserve(elementCount);
+    thickness.reserve(elementCount);
+    nodeIds.reserve(nodeIdCount);
+}
+
+void ElementArrays::Append(const ElementView& element) {
+    int nodeCount = static_cast<int>(element.nodeIds.size());
+    if (blocks.empty() || blocks.back().type != element.type ||
+        blocks.back().nodesPerElement != nodeCount) {
+        ElementBlock block;
+        block.type = element.type;
+        block.nodesPerElement = nodeCount;
+        block.firstElement = ids.size();
+        block.firstNodeId = nodeIds.size();
+        blocks.push_back(block);
+    }
+    ++blocks.back().elementCount;
+    
+    size_t chunkCount = ids.GetChunkCount();
+    ids.push_back(element.id);
+    materialIds.push_back(element.materialId);
+    propertyIds.push_back(element.propertyId);
+    thickness.push_back(element.thickness);
+    nodeIds.Append(element.nodeIds.data(), element.nodeIds.size(), ids.GetChunkCount() != chunkCount);
+}
+
+void ElementArrays::Compact(const std::vector<char>& removed) {
+    std::vector<char> touched(ids.GetChunkCount(), 0);
+    for (size_t i = 0; i < removed.size() && i < ids.size(); ++i) {
+        if (removed[i]) {
+            touched[ids.FindChunk(i)] = 1;
+        }
+    }
+    
+    std::vector<ElementBlock> oldBlocks = std::move(blocks);
+    blocks = std::vector<ElementBlock>();
+    bool hasIndices = HasNodeIndices();
+    
+    // Only chunks holding a removed element are rewritten; the rest stay
+    // shared with any snapshot. nodeIndices is flat and compacts in place,
+    // since kept entries only ever move towards the front.
+    std::vector<int> chunkIds, chunkMaterials, chunkProperties, chunkNodeIds;
+    std::vector<float> chunkThickness;
+    std::vector<char> erased(ids.GetChunkCount(), 0);
+    size_t chunk = 0;
+    size_t chunkEnd = ids.GetChunkCount() > 0 ? ids.GetChunkSize(0) : 0;
+    auto finishChunk = [&]() {
+        if (!touched[chunk]) {
+            return;
+        }
+        erased[chunk] = chunkIds.empty();
+        ids.ReplaceChunk(chunk, std::move(chunkIds));
+        materialIds.ReplaceChunk(chunk, std::move(chunkMaterials));
+        propertyIds.ReplaceChunk(chunk, std::move(chunkProperties));
+        thickness.ReplaceChunk(chunk, std::move(chunkThickness));
+        nodeIds.ReplaceChunk(chunk, std::move(chunkNodeIds));
+        chunkIds = chunkMaterials = chunkProperties = chunkNodeIds = std::vector<int>();
+        chunkThickness = std::vector<float>();
+    };
+    
+    size_t kept = 0;
+    size_t keptNodeIds = 0;
+    for (const ElementBlock& block : oldBlocks) {
+        size_t stride = static_cast<size_t>(block.nodesPerElement);
+        for (size_t i = block.firstElement; i < block.EndElement(); ++i) {
+            while (i >= chunkEnd) {
+                finishChunk();
+                ++chunk;
+                chunkEnd += ids.GetChunkSize(chunk);
+            }
+            if (i < removed.size() && removed[i]) {
+                continue;
+            }
+            
+            // Removing a whole block can join its neighbours into one
+            if (blocks.empty() || blocks.back().type != block.type ||
+                blocks.back().nodesPerElement != block.nodesPerElement) {
+                ElementBlock keptBlock = block;
+                keptBlock.firstElement = kept;
+                keptBlock.elementCount = 0;
+                keptBlock.firstNodeId = keptNodeIds;
+                blocks.push_back(keptBlock);
+            }
+            ++blocks.back().elementCount;
+            
+            size_t from = block.firstNodeId + (i - block.firstElement) * stride;
+            if (touched[chunk]) {
+                size_t local = i - ids.GetChunkOffset(chunk);
+                chunkIds.push_back(ids.GetChunkData(chunk)[local]);
+                chunkMaterials.push_back(materialIds.GetChunkData(chunk)[local]);
+                chunkProperties.push_back(propertyIds.GetChunkData(chunk)[local]);
+                chunkThickness.push_back(thickness.GetChunkData(chunk)[local]);
+                const int* source = nodeIds.GetChunkData(chunk) + (from - nodeIds.GetChunkOffset(chunk));
+                chunkNodeIds.insert(chunkNodeIds.end(), source, source + stride);
+            }
+            if (hasIndices && from != keptNodeIds) {
+                std::copy(nodeIndices.begin() + from, nodeIndices.begin() + from + stride,
+                          nodeIndices.begin() + keptNodeIds);
+            }
+            ++kept;
+            keptNodeIds += stride;
+        }
+    }
+    if (chunk < touched.size()) {
+        finishChunk();
+    }
+    
+    ids.EraseChunks(erased);
+    materialIds.EraseChunks(erased);
+    propertyIds.EraseChunks(erased);
+    thickness.EraseChunks(erased);
+    nodeIds.EraseChunks(erased);
+    ids.Reindex();
+    materialIds.Reindex();
+    propertyIds.Reindex();
+    thickness.Reindex();
+    nodeIds.Reindex();
+    if (hasIndices) {
+        nodeIndices.resize(keptNodeIds);
+    }
+}
+
+size_t ElementArrays::FindBlock(size_t index) const {
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), index,
+        [](size_t value, const ElementBlock& block) { return value < block.firstElement; });
+    return static_cast<size_t>(it - blocks.begin()) - 1;
+}
+
+size_t ElementArrays::NodeIdOffset(const std::vector<ElementBlock>& blocks, size_t index,
+                                  size_t nodeIdCount) {
+    if (blocks.empty() || index >= blocks.back().EndElement()) {
+        return nodeIdCount;
+    }
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), index,
+        [](size_t value, const ElementBlock& block) { return value < block.firstElement; });
+    const ElementBlock& block = *(it - 1);
+    return block.firstNodeId + (index - block.firstElement) * static_cast<size_t>(block.nodesPerElement);
+}
+
+ElementView ElementArrays::View(const ElementBlock& block, size_t index) const {
+    ElementView view;
+    view.id = ids[index];
+    view.type = block.type;
+    view.materialId = materialIds[index];
+    view.propertyId = propertyIds[index];
+    view.thickness = thickness[index];
+    size_t stride = static_cast<size_t>(block.nodesPerElement);
+    size_t firstNodeId = block.firstNodeId + (index - block.firstElement) * stride;
+    view.nodeIds = NodeIdSpan(GetNodeIdData(index, firstNodeId), stride);
+    if (HasNodeIndices()) {
+        view.nodeIndices = nodeIndices.data() + firstNodeId;
+    }
+    return view;
+}
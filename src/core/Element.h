@@ -1,4 +1,8 @@
 #pragma once
+#include "ChunkedColumn.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -12,6 +16,8 @@ enum class ElementType {
     SPRING1     // Spring
 };
 
+// A single element as passed into Model. Model itself keeps element data in
+// ElementArrays, so this record is only built where a whole element is needed.
 struct Element {
     int id;
     ElementType type;
@@ -20,10 +26,163 @@ struct Element {
     int propertyId;
     float thickness;  // For shells
     
-    Element() : id(0), type(ElementType::UNKNOWN), 
+    Element() : id(0), type(ElementType::UNKNOWN),
                 materialId(0), propertyId(0), thickness(0.0f) {}
     
     static ElementType StringToType(const std::string& typeStr);
     static std::string TypeToString(ElementType type);
     static int GetNodeCount(ElementType type);
-};
\ No newline at end of file
+};
+
+// Read-only run of node IDs, shaped like std::span so it drops into range
+// loops and indexing where a std::vector<int> was used before
+struct NodeIdSpan {
+    const int* ids = nullptr;
+    size_t count = 0;
+    
+    NodeIdSpan() = default;
+    NodeIdSpan(const int* data, size_t size) : ids(data), count(size) {}
+    NodeIdSpan(const std::vector<int>& values) : ids(values.data()), count(values.size()) {}
+    
+    const int* begin() const { return ids; }
+    const int* end() const { return ids + count; }
+    const int* data() const { return ids; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    int operator[](size_t i) const { return ids[i]; }
+};
+
+// An element seen through the model's arrays. Cheap to copy; nodeIds points
+// into the model and stays valid until the model is next modified.
+struct ElementView {
+    int id = 0;
+    ElementType type = ElementType::UNKNOWN;
+    int materialId = 0;
+    int propertyId = 0;
+    float thickness = 0.0f;
+    NodeIdSpan nodeIds;
+    
+    // Node array index per entry of nodeIds (ElementArrays::kMissingNode for
+    // undefined nodes), or null while the model's references are unresolved
+    const uint32_t* nodeIndices = nullptr;
+    
+    ElementView() = default;
+    ElementView(const Element& element)
+        : id(element.id), type(element.type), materialId(element.materialId),
+          propertyId(element.propertyId), thickness(element.thickness),
+          nodeIds(element.nodeIds) {}
+};
+
+// Consecutive elements sharing a type and node count. Their connectivity is
+// one slice of ElementArrays::nodeIds with a fixed stride.
+struct ElementBlock {
+    ElementType type = ElementType::UNKNOWN;
+    int nodesPerElement = 0;
+    size_t firstElement = 0;   // Index of the block's first element
+    size_t elementCount = 0;
+    size_t firstNodeId = 0;    // Offset of its connectivity in nodeIds
+    
+    size_t EndElement() const { return firstElement + elementCount; }
+};
+
+// Column storage for a model's elements. Connectivity is a single array
+// addressed through the block table (block-compressed CSR): elements keep
+// their insertion order, and a new block only starts where the type or node
+// count changes, which in a deck means once per element keyword.
+//
+// The definition columns are chunked in step (see ChunkedColumn): chunk k
+// of nodeIds holds the connectivity of the elements in chunk k of the
+// others, so an element's node IDs never straddle two chunks. Offsets into
+// nodeIds, as in the block table, count across chunks.
+struct ElementArrays {
+    static constexpr uint32_t kMissingNode = UINT32_MAX;
+    
+    ChunkedColumn<int> ids;
+    ChunkedColumn<int> materialIds;
+    ChunkedColumn<int> propertyIds;
+    ChunkedColumn<float> thickness;
+    ChunkedColumn<int> nodeIds;
+    std::vector<ElementBlock> blocks;
+    
+    // nodeIds renumbered to node array indices; valid while it matches
+    // nodeIds in size, which Model maintains. Derived, so kept flat.
+    std::vector<uint32_t> nodeIndices;
+    
+    size_t Size() const { return ids.size(); }
+    bool HasNodeIndices() const { return nodeIndices.size() == nodeIds.size(); }
+    
+    void Reserve(size_t elementCount, size_t nodeIdCount);
+    void Append(const ElementView& element);
+    
+    // Drops the elements whose entry in removed is set, in one pass;
+    // elements past the end of removed are kept
+    void Compact(const std::vector<char>& removed);
+    
+    // Block holding element index; index must be below Size()
+    size_t FindBlock(size_t index) const;
+    
+    // Where element index's node IDs start in nodeIds; index may be Size()
+    size_t NodeIdOffset(size_t index) const { return NodeIdOffset(blocks, index, nodeIds.size()); }
+    static size_t NodeIdOffset(const std::vector<ElementBlock>& blocks, size_t index,
+                               size_t nodeIdCount);
+    ElementView View(size_t index) const { return View(blocks[FindBlock(index)], index); }
+    ElementView View(const ElementBlock& block, size_t index) const;
+    
+    // Node IDs of element index, whose connectivity starts at nodeIdOffset
+    const int* GetNodeIdData(size_t index, size_t nodeIdOffset) const {
+        size_t chunk = ids.FindChunk(index);
+        return nodeIds.GetChunkData(chunk) + (nodeIdOffset - nodeIds.GetChunkOffset(chunk));
+    }
+    
+    // True when chunk k of every definition column is also other's chunk j
+    bool SharesChunk(size_t k, const ElementArrays& other, size_t j) const {
+        return ids.SharesChunk(k, other.ids, j) && materialIds.SharesChunk(k, other.materialIds, j) &&
+               propertyIds.SharesChunk(k, other.propertyIds, j) &&
+               thickness.SharesChunk(k, other.thickness, j) && nodeIds.SharesChunk(k, other.nodeIds, j);
+    }
+    
+    // Calls fn(index, view) for elements [first, last), walking the block
+    // table and the chunks once instead of searching them per element
+    template<typename Fn>
+    void ForEach(size_t first, size_t last, Fn&& fn) const {
+        last = std::min(last, Size());
+        if (first >= last) {
+            return;
+        }
+        const bool resolved = HasNodeIndices();
+        size_t b = FindBlock(first);
+        size_t chunk = ids.FindChunk(first);
+        for (size_t i = first; i < last;) {
+            while (ids.GetChunkOffset(chunk) + ids.GetChunkSize(chunk) <= i) {
+                ++chunk;
+            }
+            while (blocks[b].EndElement() <= i) {
+                ++b;
+            }
+            const ElementBlock& block = blocks[b];
+            const size_t chunkFirst = ids.GetChunkOffset(chunk);
+            const size_t end = std::min({last, chunkFirst + ids.GetChunkSize(chunk), block.EndElement()});
+            const size_t stride = static_cast<size_t>(block.nodesPerElement);
+            const int* chunkIds = ids.GetChunkData(chunk);
+            const int* chunkMaterials = materialIds.GetChunkData(chunk);
+            const int* chunkProperties = propertyIds.GetChunkData(chunk);
+            const float* chunkThickness = thickness.GetChunkData(chunk);
+            const int* chunkNodeIds = nodeIds.GetChunkData(chunk);
+            const size_t nodeIdFirst = nodeIds.GetChunkOffset(chunk);
+            
+            ElementView view;
+            view.type = block.type;
+            for (; i < end; ++i) {
+                size_t local = i - chunkFirst;
+                size_t offset = block.firstNodeId + (i - block.firstElement) * stride;
+                view.id = chunkIds[local];
+                view.materialId = chunkMaterials[local];
+                view.propertyId = chunkProperties[local];
+                view.thickness = chunkThickness[local];
+                view.nodeIds = NodeIdSpan(chunkNodeIds + (offset - nodeIdFirst), stride);
+                view.nodeIndices = resolved ? nodeIndices.data() + offset : nullptr;
+                fn(i, view);
+            }
+        }
+    }
+};
@@ -0,0 +1,263 @@
+#include "core/IdIndex.h"
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+namespace {
+
+// Below this span the dense form is used whatever the fill ratio
+constexpr int64_t kMinDenseSpan = 4096;
+
+// Dense slots cost 4 bytes per ID in the span against 16 per range, so a
+// quarter-full span is already no larger than the sparsest range table
+constexpr int64_t kDenseSpanPerId = 4;
+
+int64_t DenseLimit(size_t count) {
+    return std::max(kMinDenseSpan, kDenseSpanPerId * static_cast<int64_t>(count));
+}
+
+} // namespace
+
+void IdIndex::Insert(int id, size_t index) {
+    if (m_Mode == Mode::DENSE) {
+        if (InsertDense(id, index)) {
+            return;
+        }
+        ConvertToRanges();
+    }
+    if (m_Mode == Mode::RANGES) {
+        if (InsertRange(id, index)) {
+            return;
+        }
+        ConvertToHash();
+    }
+
+    auto result = m_Map.insert_or_assign(id, index);
+    m_Count += result.second;
+}
+
+size_t IdIndex::Find(int id) const {
+    switch (m_Mode) {
+        case Mode::DENSE: {
+            int64_t offset = static_cast<int64_t>(id) - m_Base;
+            if (offset < 0 || offset >= static_cast<int64_t>(m_Slots.size())) {
+                return kNotFound;
+            }
+            uint32_t slot = m_Slots[static_cast<size_t>(offset)];
+            return slot != kEmptySlot ? slot : kNotFound;
+        }
+        case Mode::RANGES: {
+            auto it = std::upper_bound(m_Ranges.begin(), m_Ranges.end(), id,
+                [](int value, const Range& range) { return value < range.firstId; });
+            if (it == m_Ranges.begin()) {
+                return kNotFound;
+            }
+            --it;
+            int64_t offset = static_cast<int64_t>(id) - it->firstId;
+            return offset < it->count ? it->firstIndex + static_cast<size_t>(offset) : kNotFound;
+        }
+        case Mode::HASH: {
+            auto it = m_Map.find(id);
+            return it != m_Map.end() ? it->second : kNotFound;
+        }
+    }
+    return kNotFound;
+}
+
+bool IdIndex::Erase(int id, size_t index) {
+    switch (m_Mode) {
+        case Mode::DENSE: {
+            int64_t offset = static_cast<int64_t>(id) - m_Base;
+            if (offset >= 0 && offset < static_cast<int64_t>(m_Slots.size()) &&
+                m_Slots[static_cast<size_t>(offset)] == index) {
+                m_Slots[static_cast<size_t>(offset)] = kEmptySlot;
+                --m_Count;
+            }
+            return true;
+        }
+        case Mode::RANGES:
+            return false;
+        case Mode::HASH: {
+            auto it = m_Map.find(id);
+            if (it != m_Map.end() && it->second == index) {
+                m_Map.erase(it);
+                --m_Count;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void IdIndex::Build(const std::vector<int>& ids) {
+    BuildFrom(ids);
+}
+
+void IdIndex::Build(const ChunkedColumn<int>& ids) {
+    BuildFrom(ids);
+}
+
+template<typename Ids>
+void IdIndex::BuildFrom(const Ids& ids) {
+    Clear();
+    if (ids.empty()) {
+        return;
+    }
+
+    auto [lowest, highest] = std::minmax_element(ids.begin(), ids.end());
+    int64_t span = static_cast<int64_t>(*highest) - *lowest + 1;
+    if (span <= DenseLimit(ids.size()) && ids.size() < kEmptySlot) {
+        m_Base = *lowest;
+        m_Slots.assign(static_cast<size_t>(span), kEmptySlot);
+        uint32_t i = 0;
+        for (int id : ids) {
+            uint32_t& slot = m_Slots[static_cast<size_t>(id - static_cast<int64_t>(m_Base))];
+            m_Count += slot == kEmptySlot;
+            slot = i++;
+        }
+        return;
+    }
+
+    m_Mode = Mode::RANGES;
+    if (std::is_sorted(ids.begin(), ids.end()) &&
+        std::adjacent_find(ids.begin(), ids.end()) == ids.end()) {
+        size_t i = 0;
+        for (int id : ids) {
+            InsertRange(id, i++);
+        }
+        return;
+    }
+
+    // Unordered IDs: sort (id, index) pairs and keep the last index per ID
+    std::vector<std::pair<int, size_t>> pairs;
+    pairs.reserve(ids.size());
+    for (int id : ids) {
+        pairs.emplace_back(id, pairs.size());
+    }
+    std::sort(pairs.begin(), pairs.end());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i + 1 < pairs.size() && pairs[i + 1].first == pairs[i].first) {
+            continue;
+        }
+        InsertRange(pairs[i].first, pairs[i].second);
+    }
+    m_Ranges.shrink_to_fit();
+}
+
+void IdIndex::Clear() {
+    m_Mode = Mode::DENSE;
+    m_Count = 0;
+    m_Base = 0;
+    m_Slots = std::vector<uint32_t>();
+    m_Ranges = std::vector<Range>();
+    m_Map = std::unordered_map<int, size_t>();
+}
+
+void IdIndex::Reserve(size_t count) {
+    // Dense IDs need about one slot each; other IDs convert away from
+    // DENSE early and release the reservation
+    if (m_Mode == Mode::DENSE) {
+        m_Slots.reserve(count);
+    } else if (m_Mode == Mode::HASH) {
+        m_Map.reserve(count);
+    }
+}
+
+size_t IdIndex::GetMemoryBytes() const {
+    size_t bytes = m_Slots.capacity() * sizeof(uint32_t) + m_Ranges.capacity() * sizeof(Range);
+    // Typical node-based hash map: one allocation per entry plus the buckets
+    bytes += m_Map.size() * (sizeof(std::pair<const int, size_t>) + 2 * sizeof(void*)) +
+             m_Map.bucket_count() * sizeof(void*);
+    return bytes;
+}
+
+const char* IdIndex::ModeToString(Mode mode) {
+    switch (mode) {
+        case Mode::DENSE: return "dense";
+        case Mode::RANGES: return "ranges";
+        case Mode::HASH: return "hash";
+    }
+    return "unknown";
+}
+
+bool IdIndex::InsertDense(int id, size_t index) {
+    if (index >= kEmptySlot) {
+        return false;
+    }
+    if (m_Slots.empty()) {
+        m_Base = id;
+        m_Slots.push_back(static_cast<uint32_t>(index));
+        m_Count = 1;
+        return true;
+    }
+
+    int64_t offset = static_cast<int64_t>(id) - m_Base;
+    int64_t size = static_cast<int64_t>(m_Slots.size());
+    if (offset >= 0 && offset < size) {
+        uint32_t& slot = m_Slots[static_cast<size_t>(offset)];
+        m_Count += slot == kEmptySlot;
+        slot = static_cast<uint32_t>(index);
+        return true;
+    }
+
+    int64_t span = offset < 0 ? size - offset : offset + 1;
+    int64_t limit = DenseLimit(m_Count + 1);
+    if (span > limit) {
+        return false;
+    }
+
+    if (offset >= 0) {
+        m_Slots.resize(static_cast<size_t>(offset + 1), kEmptySlot);
+    } else {
+        // Leave room below, so descending IDs do not shift the slots each time
+        int64_t grow = std::min(std::max(-offset, size), limit - size);
+        grow = std::min(grow, static_cast<int64_t>(m_Base) - INT_MIN);
+        m_Slots.insert(m_Slots.begin(), static_cast<size_t>(grow), kEmptySlot);
+        m_Base = static_cast<int>(m_Base - grow);
+        offset += grow;
+    }
+    m_Slots[static_cast<size_t>(offset)] = static_cast<uint32_t>(index);
+    ++m_Count;
+    return true;
+}
+
+bool IdIndex::InsertRange(int id, size_t index) {
+    if (!m_Ranges.empty()) {
+        Range& last = m_Ranges.back();
+        int64_t lastId = static_cast<int64_t>(last.firstId) + last.count - 1;
+        if (id <= lastId) {
+            return false;
+        }
+        if (id == lastId + 1 && index == last.firstIndex + last.count && last.count < UINT32_MAX) {
+            ++last.count;
+            ++m_Count;
+            return true;
+        }
+    }
+    m_Ranges.push_back({id, 1, index});
+    ++m_Count;
+    return true;
+}
+
+void IdIndex::ConvertToRanges() {
+    std::vector<uint32_t> slots = std::move(m_Slots);
+    m_Slots = std::vector<uint32_t>();
+    m_Mode = Mode::RANGES;
+    m_Count = 0;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i] != kEmptySlot) {
+            InsertRange(static_cast<int>(m_Base + static_cast<int64_t>(i)), slots[i]);
+        }
+    }
+}
+
+void IdIndex::ConvertToHash() {
+    m_Map.reserve(m_Count * 2);
+    for (const Range& range : m_Ranges) {
+        for (uint32_t k = 0; k < range.count; ++k) {
+            m_Map.emplace(range.firstId + static_cast<int>(k), range.firstIndex + k);
+        }
+    }
+    m_Ranges = std::vector<Range>();
+    m_Mode = Mode::HASH;
+}
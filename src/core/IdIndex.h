@@ -0,0 +1,72 @@
+#pragma once
+#include "ChunkedColumn.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Maps entity IDs to their index in the model's arrays. Radioss IDs are
+// mostly dense or come in a few dense ranges, so the index picks the
+// cheapest form that fits the IDs it has seen:
+//   DENSE  - one slot per ID between the lowest and highest, for IDs that
+//            fill at least a quarter of their span
+//   RANGES - sorted runs of consecutive IDs with consecutive indices,
+//            found by binary search; any ascending ID sequence fits
+//   HASH   - an unordered_map, only once IDs arrive out of order
+// Inserting may move the index to a later form. Build starts over from a
+// complete ID array and picks DENSE or RANGES whatever the insertion order.
+// As with the maps this replaces, a repeated ID refers to its last index.
+class IdIndex {
+public:
+    enum class Mode {
+        DENSE,
+        RANGES,
+        HASH
+    };
+
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+    void Insert(int id, size_t index);
+    size_t Find(int id) const;
+    bool Contains(int id) const { return Find(id) != kNotFound; }
+
+    // Drops id while it still maps to index. RANGES cannot split a run, so
+    // it returns false there and leaves the index as it was.
+    bool Erase(int id, size_t index);
+
+    // Replaces the contents with ids[i] -> i
+    void Build(const std::vector<int>& ids);
+    void Build(const ChunkedColumn<int>& ids);
+    void Clear();
+    void Reserve(size_t count);
+
+    Mode GetMode() const { return m_Mode; }
+    size_t Size() const { return m_Count; }
+    size_t GetMemoryBytes() const;
+    static const char* ModeToString(Mode mode);
+
+private:
+    struct Range {
+        int firstId;
+        uint32_t count;
+        size_t firstIndex;
+    };
+
+    static constexpr uint32_t kEmptySlot = UINT32_MAX;
+
+    template<typename Ids>
+    void BuildFrom(const Ids& ids);
+    bool InsertDense(int id, size_t index);
+    bool InsertRange(int id, size_t index);
+    void ConvertToRanges();
+    void ConvertToHash();
+
+private:
+    Mode m_Mode = Mode::DENSE;
+    size_t m_Count = 0;
+
+    int m_Base = 0;                     // DENSE: ID of m_Slots[0]
+    std::vector<uint32_t> m_Slots;      // DENSE: index per ID, kEmptySlot for gaps
+    std::vector<Range> m_Ranges;        // RANGES: sorted by firstId, disjoint
+    std::unordered_map<int, size_t> m_Map;  // HASH
+};
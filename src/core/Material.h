@@ -1,5 +1,7 @@
 #pragma once
+#include "ParameterTable.h"
 #include <string>
+#include <string_view>
 
 enum class MaterialType {
     ELASTIC,
@@ -13,23 +15,42 @@ struct Material {
     int id;
     std::string name;
     MaterialType type;
-    
-    // Common properties
-    float density;
-    float youngModulus;
-    float poissonRatio;
-    
-    // Plastic properties
-    float yieldStress;
-    float tangentModulus;
-    
-    // Johnson-Cook parameters
-    float jc_A, jc_B, jc_n, jc_C, jc_m;
-    float jc_D1, jc_D2, jc_D3, jc_D4, jc_D5;
-    
-    Material() : id(0), type(MaterialType::ELASTIC),
-                 density(0.0f), youngModulus(0.0f), poissonRatio(0.0f),
-                 yieldStress(0.0f), tangentModulus(0.0f),
-                 jc_A(0.0f), jc_B(0.0f), jc_n(0.0f), jc_C(0.0f), jc_m(0.0f),
-                 jc_D1(0.0f), jc_D2(0.0f), jc_D3(0.0f), jc_D4(0.0f), jc_D5(0.0f) {}
+
+    // Law parameters by schema slot, e.g. Param::RHO or Param::JC_A
+    ParameterTable parameters;
+
+    Material() : id(0), type(MaterialType::ELASTIC), parameters(SchemaFor(type)) {}
+
+    // Radioss law each type is written as
+    static const char* LawFor(MaterialType type) {
+        switch (type) {
+            case MaterialType::ELASTIC:      return "LAW1";
+            case MaterialType::PLASTIC:      return "LAW36";
+            case MaterialType::JOHNSON_COOK: return "LAW2";
+            case MaterialType::COMPOSITE:    return "LAW25";
+            case MaterialType::HYPERELASTIC: return "LAW42";
+        }
+        return "LAW1";
+    }
+
+    static MaterialType TypeFromLaw(std::string_view law) {
+        const std::string_view type = ParameterSchema::ForType(law).GetType();
+        if (type == "LAW36") return MaterialType::PLASTIC;
+        if (type == "LAW2") return MaterialType::JOHNSON_COOK;
+        if (type == "LAW25") return MaterialType::COMPOSITE;
+        if (type == "LAW42") return MaterialType::HYPERELASTIC;
+        return MaterialType::ELASTIC;
+    }
+
+    static const ParameterSchema& SchemaFor(MaterialType type) {
+        return ParameterSchema::ForType(LawFor(type));
+    }
+
+    // Changes the law, keeping the values the new schema has room for
+    void SetType(MaterialType newType) {
+        ParameterTable converted(SchemaFor(newType));
+        parameters.ForEach([&](ParameterKey key, double value) { converted.Set(key, value); });
+        type = newType;
+        parameters = std::move(converted);
+    }
 };
@@ -0,0 +1,525 @@
+#include "MeshQuality.h"
+#include "Model.h"
+#include "utils/Lanes.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+constexpr size_t kParallelGrain = 1u << 14;
+constexpr float kRadiansToDegrees = 57.29578f;
+constexpr float kNoValue = std::numeric_limits<float>::quiet_NaN();
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// Corner scaled Jacobians of the ideal triangle and tetrahedron, which
+// are scaled to 1 like the square and the cube
+constexpr float kTriangleJacobianScale = 1.1547005f;   // 1 / sin 60
+constexpr float kTetraJacobianScale = 1.4142136f;      // sqrt 2
+
+using Lanes::Vec3;
+
+// What the kernels leave for the scalar pass to turn into degrees
+template<typename T>
+struct Metrics {
+    T aspect;
+    T warpCos;     // Cosine between the halves' normals
+    T skewSin;     // Cosine between the midlines, the sine of the skew
+    T jacobian;
+    T minLength;
+};
+
+template<typename T>
+T LengthSquared(const Vec3<T>& v) {
+    return Dot(v, v);
+}
+
+// Cosine between the normals of the two triangles either diagonal splits
+// a quad into; the smaller of the two
+template<typename T>
+T QuadWarpCos(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c, const Vec3<T>& d) {
+    const Vec3<T> n1 = Cross(b - a, c - a);
+    const Vec3<T> n2 = Cross(c - a, d - a);
+    const Vec3<T> n3 = Cross(c - b, d - b);
+    const Vec3<T> n4 = Cross(d - b, a - b);
+    const T cos1 = Dot(n1, n2) / Lanes::Sqrt(LengthSquared(n1) * LengthSquared(n2));
+    const T cos2 = Dot(n3, n4) / Lanes::Sqrt(LengthSquared(n3) * LengthSquared(n4));
+    return Lanes::Min(cos1, cos2);
+}
+
+template<typename T>
+T QuadSkewSin(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c, const Vec3<T>& d) {
+    const Vec3<T> m1 = (b + c) - (a + d);
+    const Vec3<T> m2 = (c + d) - (a + b);
+    return Lanes::Abs(Dot(m1, m2)) / Lanes::Sqrt(LengthSquared(m1) * LengthSquared(m2));
+}
+
+// Largest cosine between a median and the side it halves
+template<typename T>
+T TriangleSkewSin(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c) {
+    T skew = Lanes::Traits<T>::Splat(0.0f);
+    const Vec3<T> corners[3] = {a, b, c};
+    for (size_t k = 0; k < 3; ++k) {
+        const Vec3<T>& p = corners[k];
+        const Vec3<T>& q = corners[(k + 1) % 3];
+        const Vec3<T>& r = corners[(k + 2) % 3];
+        const Vec3<T> median = (q + r) - (p + p);
+        const Vec3<T> side = r - q;
+        skew = Lanes::Max(skew, Lanes::Abs(Dot(median, side)) /
+                                Lanes::Sqrt(LengthSquared(median) * LengthSquared(side)));
+    }
+    return skew;
+}
+
+// Corner sine of a triangle, scaled to 1 for the equilateral one
+template<typename T>
+T TriangleJacobian(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c) {
+    const Vec3<T> ab = b - a;
+    const Vec3<T> bc = c - b;
+    const Vec3<T> ca = a - c;
+    const T twiceArea = Lanes::Length(Cross(ab, ca));
+    const T lab = LengthSquared(ab);
+    const T lbc = LengthSquared(bc);
+    const T lca = LengthSquared(ca);
+    const T largest = Lanes::Max(Lanes::Max(lab * lbc, lbc * lca), lca * lab);
+    return Lanes::Min(twiceArea / Lanes::Sqrt(largest) * kTriangleJacobianScale, Lanes::Traits<T>::Splat(1.0f));
+}
+
+template<typename T>
+void EdgeRange(const Vec3<T>* p, const int (*edges)[2], size_t count, T& shortest, T& longest) {
+    shortest = LengthSquared(p[edges[0][1]] - p[edges[0][0]]);
+    longest = shortest;
+    for (size_t e = 1; e < count; ++e) {
+        const T length = LengthSquared(p[edges[e][1]] - p[edges[e][0]]);
+        shortest = Lanes::Min(shortest, length);
+        longest = Lanes::Max(longest, length);
+    }
+}
+
+constexpr int kTriangleEdges[3][2] = {{0, 1}, {1, 2}, {2, 0}};
+constexpr int kQuadEdges[4][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}};
+constexpr int kTetraEdges[6][2] = {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {1, 3}, {2, 3}};
+constexpr int kHexaEdges[12][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6},
+                                   {6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+constexpr int kHexaFaces[6][4] = {{0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 5, 4},
+                                  {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+constexpr int kTetraFaces[4][3] = {{0, 1, 2}, {0, 1, 3}, {1, 2, 3}, {2, 0, 3}};
+
+// Neighbours of each hexahedron corner, in right-handed order
+constexpr int kHexaCorners[8][3] = {{1, 3, 4}, {2, 0, 5}, {3, 1, 6}, {0, 2, 7},
+                                    {7, 5, 0}, {4, 6, 1}, {5, 7, 2}, {6, 4, 3}};
+
+// Every metric of each lane's element in one pass over its corners
+template<typename T>
+Metrics<T> Measure(ElementType type, const float* x, const float* y, const float* z, const uint32_t* nodes,
+                   size_t stride) {
+    using Traits = Lanes::Traits<T>;
+    Vec3<T> p[8];
+    const size_t count = static_cast<size_t>(Element::GetNodeCount(type));
+    for (size_t k = 0; k < count && k < 8; ++k) {
+        p[k] = Vec3<T>::Gather(x, y, z, nodes, stride, k);
+    }
+    
+    Metrics<T> m;
+    m.warpCos = Traits::Splat(1.0f);
+    m.skewSin = Traits::Splat(0.0f);
+    m.jacobian = Traits::Splat(1.0f);
+    T shortest, longest;
+    switch (type) {
+        case ElementType::SHELL3:
+            EdgeRange(p, kTriangleEdges, 3, shortest, longest);
+            m.skewSin = TriangleSkewSin(p[0], p[1], p[2]);
+            m.jacobian = TriangleJacobian(p[0], p[1], p[2]);
+            break;
+        case ElementType::SHELL4: {
+            EdgeRange(p, kQuadEdges, 4, shortest, longest);
+            m.warpCos = QuadWarpCos(p[0], p[1], p[2], p[3]);
+            m.skewSin = QuadSkewSin(p[0], p[1], p[2], p[3]);
+            
+            // Corners against the mean normal, from the diagonals
+            const Vec3<T> normal = Cross(p[2] - p[0], p[3] - p[1]);
+            const T normalLength = Lanes::Length(normal);
+            for (size_t k = 0; k < 4; ++k) {
+                const Vec3<T> a = p[(k + 1) % 4] - p[k];
+                const Vec3<T> b = p[(k + 3) % 4] - p[k];
+                const T corner = Dot(Cross(a, b), normal) /
+                                 (normalLength * Lanes::Sqrt(LengthSquared(a) * LengthSquared(b)));
+                m.jacobian = Lanes::Min(m.jacobian, corner);
+            }
+            break;
+        }
+        case ElementType::TETRA4: {
+            EdgeRange(p, kTetraEdges, 6, shortest, longest);
+            for (const auto& face : kTetraFaces) {
+                m.skewSin = Lanes::Max(m.skewSin, TriangleSkewSin(p[face[0]], p[face[1]], p[face[2]]));
+            }
+            // Every corner shares the signed volume; the one with the
+            // longest edges has the smallest Jacobian
+            const T volume = Dot(p[1] - p[0], Cross(p[2] - p[0], p[3] - p[0]));
+            const T l01 = LengthSquared(p[1] - p[0]), l02 = LengthSquared(p[2] - p[0]);
+            const T l03 = LengthSquared(p[3] - p[0]), l12 = LengthSquared(p[2] - p[1]);
+            const T l13 = LengthSquared(p[3] - p[1]), l23 = LengthSquared(p[3] - p[2]);
+            T largest = Lanes::Max(l01 * l02 * l03, l01 * l12 * l13);
+            largest = Lanes::Max(largest, Lanes::Max(l02 * l12 * l23, l03 * l13 * l23));
+            m.jacobian = volume / Lanes::Sqrt(largest) * kTetraJacobianScale;
+            break;
+        }
+        case ElementType::HEXA8: {
+            EdgeRange(p, kHexaEdges, 12, shortest, longest);
+            for (const auto& face : kHexaFaces) {
+                const Vec3<T>& a = p[face[0]];
+                const Vec3<T>& b = p[face[1]];
+                const Vec3<T>& c = p[face[2]];
+                const Vec3<T>& d = p[face[3]];
+                m.warpCos = Lanes::Min(m.warpCos, QuadWarpCos(a, b, c, d));
+                m.skewSin = Lanes::Max(m.skewSin, QuadSkewSin(a, b, c, d));
+            }
+            for (size_t k = 0; k < 8; ++k) {
+                const Vec3<T> a = p[kHexaCorners[k][0]] - p[k];
+                const Vec3<T> b = p[kHexaCorners[k][1]] - p[k];
+                const Vec3<T> c = p[kHexaCorners[k][2]] - p[k];
+                const T corner = Dot(Cross(a, b), c) /
+                                 Lanes::Sqrt(LengthSquared(a) * LengthSquared(b) * LengthSquared(c));
+                m.jacobian = Lanes::Min(m.jacobian, corner);
+            }
+            break;
+        }
+        case ElementType::BEAM2:
+            shortest = longest = LengthSquared(p[1] - p[0]);
+            break;
+        default:
+            shortest = longest = Traits::Splat(0.0f);
+            break;
+    }
+    m.minLength = Lanes::Sqrt(shortest);
+    m.aspect = Lanes::Sqrt(longest / shortest);
+    return m;
+}
+
+bool HasMissingNode(const uint32_t* nodes, size_t count) {
+    return std::find(nodes, nodes + count, ElementArrays::kMissingNode) != nodes + count;
+}
+
+bool IsMeasured(ElementType type) {
+    return type != ElementType::SPRING1 && type != ElementType::UNKNOWN;
+}
+
+} // namespace
+
+const char* MeshQuality::GetName(QualityMetric metric) {
+    switch (metric) {
+        case QualityMetric::ASPECT:     return "Aspect ratio";
+        case QualityMetric::WARPAGE:    return "Warpage";
+        case QualityMetric::SKEW:       return "Skew";
+        case QualityMetric::JACOBIAN:   return "Jacobian";
+        case QualityMetric::MIN_LENGTH: return "Min length";
+        default:                        return "Unknown";
+    }
+}
+
+bool MeshQuality::IsLowerWorse(QualityMetric metric) {
+    return metric == QualityMetric::JACOBIAN || metric == QualityMetric::MIN_LENGTH;
+}
+
+void MeshQuality::Evaluate(const Model& model) {
+    auto start = std::chrono::steady_clock::now();
+    const ElementArrays& arrays = model.GetElementArrays();
+    m_ElementCount = arrays.Size();
+    m_NodeCount = model.GetNodeCount();
+    for (std::vector<float>& values : m_Values) {
+        values.assign(m_ElementCount, kNoValue);
+    }
+    
+    // Each part's elements as runs within blocks, for EvaluatePart
+    m_PartRanges.clear();
+    std::vector<Range> all;
+    for (size_t b = 0; b < arrays.blocks.size(); ++b) {
+        const ElementBlock& block = arrays.blocks[b];
+        all.push_back({b, block.firstElement, block.EndElement()});
+        for (size_t i = block.firstElement; i < block.EndElement(); ++i) {
+            std::vector<Range>& ranges = m_PartRanges[arrays.propertyIds[i]];
+            if (!ranges.empty() && ranges.back().block == b && ranges.back().end == i) {
+                ++ranges.back().end;
+            } else {
+                ranges.push_back({b, i, i + 1});
+            }
+        }
+    }
+    
+    UpdateColumns(model, nullptr);
+    EvaluateRanges(model, all);
+    BuildHistograms();
+    m_Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Mesh quality of {} elements in {:.3f} s", m_ElementCount, m_Seconds);
+}
+
+void MeshQuality::EvaluatePart(const Model& model, int partId) {
+    if (m_ElementCount != model.GetElementCount() || m_NodeCount != model.GetNodeCount()) {
+        Evaluate(model);
+        return;
+    }
+    auto it = m_PartRanges.find(partId);
+    if (it == m_PartRanges.end()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    UpdateColumns(model, &it->second);
+    EvaluateRanges(model, it->second);
+    BuildHistograms();
+    m_Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void MeshQuality::Clear() {
+    for (std::vector<float>& values : m_Values) {
+        values.clear();
+    }
+    for (QualityHistogram& histogram : m_Histograms) {
+        histogram = QualityHistogram();
+    }
+    m_X.clear();
+    m_Y.clear();
+    m_Z.clear();
+    m_PartRanges.clear();
+    m_ElementCount = 0;
+    m_NodeCount = 0;
+    m_Evaluated = 0;
+}
+
+void MeshQuality::SetThresholds(const QualityThresholds& thresholds) {
+    m_Thresholds = thresholds;
+    BuildHistograms();
+}
+
+bool MeshQuality::Fails(QualityMetric metric, float value) const {
+    const float limit = m_Thresholds.Get(metric);
+    if (std::isnan(value)) {
+        return false;
+    }
+    return IsLowerWorse(metric) ? value < limit : value > limit;
+}
+
+std::vector<int> MeshQuality::Select(const Model& model, QualityMetric metric) const {
+    std::vector<int> ids;
+    const std::vector<float>& values = GetValues(metric);
+    const ChunkedColumn<int>& elementIds = model.GetElementIds();
+    for (size_t i = 0; i < values.size() && i < elementIds.size(); ++i) {
+        if (Fails(metric, values[i])) {
+            ids.push_back(elementIds[i]);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<int> MeshQuality::SelectFailing(const Model& model) const {
+    std::vector<int> ids;
+    const ChunkedColumn<int>& elementIds = model.GetElementIds();
+    for (size_t i = 0; i < m_ElementCount && i < elementIds.size(); ++i) {
+        for (size_t m = 0; m < kMetricCount; ++m) {
+            if (Fails(static_cast<QualityMetric>(m), m_Values[m][i])) {
+                ids.push_back(elementIds[i]);
+                break;
+            }
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void MeshQuality::UpdateColumns(const Model& model, const std::vector<Range>* ranges) {
+    const ChunkedColumn<glm::vec3>& positions = model.GetNodePositions();
+    if (!ranges) {
+        m_X.resize(positions.size());
+        m_Y.resize(positions.size());
+        m_Z.resize(positions.size());
+        ThreadPool::GetGlobal().ParallelFor(positions.size(), kParallelGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                m_X[i] = positions[i].x;
+                m_Y[i] = positions[i].y;
+                m_Z[i] = positions[i].z;
+            }
+        });
+        return;
+    }
+    
+    // Only the part's own nodes; shared ones are written with the same value
+    // more than once, so this stays on one thread
+    for (const Range& range : *ranges) {
+        model.ForEachElement(range.begin, range.end, [&](size_t, const ElementView& element) {
+            for (size_t k = 0; k < element.nodeIds.size(); ++k) {
+                size_t index = element.nodeIndices ? element.nodeIndices[k] : model.FindNodeIndex(element.nodeIds[k]);
+                if (index != ElementArrays::kMissingNode && index != Model::kInvalidIndex) {
+                    m_X[index] = positions[index].x;
+                    m_Y[index] = positions[index].y;
+                    m_Z[index] = positions[index].z;
+                }
+            }
+        });
+    }
+}
+
+void MeshQuality::EvaluateRanges(const Model& model, const std::vector<Range>& ranges) {
+    const ElementArrays& arrays = model.GetElementArrays();
+    
+    // Unresolved references are looked up once, up front
+    std::vector<uint32_t> resolved;
+    const uint32_t* nodeIndices = arrays.nodeIndices.data();
+    if (!arrays.HasNodeIndices()) {
+        resolved.resize(arrays.nodeIds.size());
+        ThreadPool::GetGlobal().ParallelFor(resolved.size(), kParallelGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                size_t index = model.FindNodeIndex(arrays.nodeIds[i]);
+                resolved[i] = index != Model::kInvalidIndex ? static_cast<uint32_t>(index)
+                                                            : ElementArrays::kMissingNode;
+            }
+        });
+        nodeIndices = resolved.data();
+    }
+    
+    float* aspect = m_Values[Slot(QualityMetric::ASPECT)].data();
+    float* warpage = m_Values[Slot(QualityMetric::WARPAGE)].data();
+    float* skew = m_Values[Slot(QualityMetric::SKEW)].data();
+    float* jacobian = m_Values[Slot(QualityMetric::JACOBIAN)].data();
+    float* minLength = m_Values[Slot(QualityMetric::MIN_LENGTH)].data();
+    
+    for (const Range& range : ranges) {
+        const ElementBlock& block = arrays.blocks[range.block];
+        const size_t stride = static_cast<size_t>(block.nodesPerElement);
+        if (!IsMeasured(block.type) || stride < static_cast<size_t>(Element::GetNodeCount(block.type))) {
+            continue;
+        }
+        const uint32_t* nodes = nodeIndices + block.firstNodeId;
+        
+        ThreadPool::GetGlobal().ParallelFor(range.end - range.begin, kParallelGrain, [&](size_t begin, size_t end) {
+            begin += range.begin - block.firstElement;
+            end += range.begin - block.firstElement;
+            const size_t first = block.firstElement;
+            
+            // Raw kernel output, turned into degrees and cleaned up below
+            auto store = [&](size_t i, const Metrics<float>& m) {
+                aspect[first + i] = m.aspect;
+                warpage[first + i] = m.warpCos;
+                skew[first + i] = m.skewSin;
+                jacobian[first + i] = m.jacobian;
+                minLength[first + i] = m.minLength;
+            };
+            auto measureOne = [&](size_t i) {
+                const uint32_t* element = nodes + i * stride;
+                if (HasMissingNode(element, stride)) {
+                    store(i, {kNoValue, kNoValue, kNoValue, kNoValue, kNoValue});
+                    return;
+                }
+                store(i, Measure<float>(block.type, m_X.data(), m_Y.data(), m_Z.data(), element, stride));
+            };
+            
+            size_t i = begin;
+#ifdef LANES_HAS_SSE2
+            using Traits = Lanes::Traits<Lanes::Float4>;
+            for (; i + Traits::kWidth <= end; i += Traits::kWidth) {
+                const uint32_t* batch = nodes + i * stride;
+                if (HasMissingNode(batch, Traits::kWidth * stride)) {
+                    for (size_t k = i; k < i + Traits::kWidth; ++k) {
+                        measureOne(k);
+                    }
+                    continue;
+                }
+                const Metrics<Lanes::Float4> m = Measure<Lanes::Float4>(block.type, m_X.data(), m_Y.data(),
+                                                                        m_Z.data(), batch, stride);
+                Traits::Store(aspect + first + i, m.aspect);
+                Traits::Store(warpage + first + i, m.warpCos);
+                Traits::Store(skew + first + i, m.skewSin);
+                Traits::Store(jacobian + first + i, m.jacobian);
+                Traits::Store(minLength + first + i, m.minLength);
+            }
+#endif
+            for (; i < end; ++i) {
+                measureOne(i);
+            }
+            
+            // Collapsed elements come out as zero over zero and are given
+            // the worst value of each metric
+            for (size_t k = first + begin; k < first + end; ++k) {
+                if (std::isnan(minLength[k])) {
+                    continue;   // Undefined nodes
+                }
+                aspect[k] = std::isnan(aspect[k]) ? kInfinity : aspect[k];
+                warpage[k] = std::isnan(warpage[k]) ? 180.0f
+                                                    : std::acos(std::clamp(warpage[k], -1.0f, 1.0f)) * kRadiansToDegrees;
+                skew[k] = std::isnan(skew[k]) ? 90.0f
+                                              : std::asin(std::clamp(skew[k], 0.0f, 1.0f)) * kRadiansToDegrees;
+                jacobian[k] = std::isnan(jacobian[k]) ? 0.0f : jacobian[k];
+            }
+        });
+    }
+}
+
+void MeshQuality::BuildHistograms() {
+    std::mutex mutex;
+    m_Evaluated = 0;
+    for (size_t m = 0; m < kMetricCount; ++m) {
+        const QualityMetric metric = static_cast<QualityMetric>(m);
+        const std::vector<float>& values = m_Values[m];
+        QualityHistogram& histogram = m_Histograms[m];
+        histogram = QualityHistogram();
+        histogram.bins.assign(kHistogramBins, 0.0f);
+        
+        // Range of the finite values first, then the counts
+        float low = kInfinity;
+        float high = -kInfinity;
+        size_t evaluated = 0;
+        ThreadPool::GetGlobal().ParallelFor(values.size(), kParallelGrain, [&](size_t begin, size_t end) {
+            float localLow = kInfinity;
+            float localHigh = -kInfinity;
+            size_t localEvaluated = 0;
+            size_t localFailing = 0;
+            size_t localUnbounded = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const float value = values[i];
+                if (std::isnan(value)) {
+                    continue;
+                }
+                ++localEvaluated;
+                localFailing += Fails(metric, value) ? 1 : 0;
+                if (std::isinf(value)) {
+                    ++localUnbounded;
+                    continue;
+                }
+                localLow = std::min(localLow, value);
+                localHigh = std::max(localHigh, value);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            low = std::min(low, localLow);
+            high = std::max(high, localHigh);
+            evaluated += localEvaluated;
+            histogram.failing += localFailing;
+            histogram.unbounded += localUnbounded;
+        });
+        m_Evaluated = std::max(m_Evaluated, evaluated);
+        if (low > high) {
+            continue;
+        }
+        histogram.low = low;
+        histogram.high = high > low ? high : low + 1.0f;
+        
+        const float scale = kHistogramBins / (histogram.high - histogram.low);
+        ThreadPool::GetGlobal().ParallelFor(values.size(), kParallelGrain, [&](size_t begin, size_t end) {
+            std::vector<float> bins(kHistogramBins, 0.0f);
+            for (size_t i = begin; i < end; ++i) {
+                const float value = values[i];
+                if (std::isnan(value)) {
+                    continue;
+                }
+                const float bin = std::isinf(value) ? kHistogramBins - 1.0f : (value - histogram.low) * scale;
+                bins[std::min(static_cast<size_t>(std::max(bin, 0.0f)), kHistogramBins - 1)] += 1.0f;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t b = 0; b < kHistogramBins; ++b) {
+                histogram.bins[b] += bins[b];
+            }
+        });
+    }
+}
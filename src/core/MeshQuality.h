@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class Model;
+
+enum class QualityMetric {
+    ASPECT,       // Longest edge over the shortest
+    WARPAGE,      // Degrees between the halves of a quad, either way it is split
+    SKEW,         // Degrees the midlines (medians for triangles) are off square
+    JACOBIAN,     // Smallest scaled corner Jacobian; 1 for an ideal shape
+    MIN_LENGTH,   // Shortest edge
+    COUNT
+};
+
+// Limits an element fails beyond: above them, or for JACOBIAN and
+// MIN_LENGTH below them. A zero MIN_LENGTH fails nothing.
+struct QualityThresholds {
+    std::array<float, static_cast<size_t>(QualityMetric::COUNT)> limits = {5.0f, 10.0f, 60.0f, 0.6f, 0.0f};
+    
+    float Get(QualityMetric metric) const { return limits[static_cast<size_t>(metric)]; }
+    void Set(QualityMetric metric, float value) { limits[static_cast<size_t>(metric)] = value; }
+};
+
+struct QualityHistogram {
+    std::vector<float> bins;   // Element counts, evenly over [low, high]
+    float low = 0.0f;
+    float high = 0.0f;
+    size_t failing = 0;        // Against the thresholds in use
+    size_t unbounded = 0;      // Infinite aspects, counted in the last bin
+};
+
+// Mesh quality of every element of a model, one metric per column, for a
+// QA gate over large decks. Each block of the element arrays is evaluated
+// in parallel on the global pool, all metrics in one pass per element and
+// four elements at a time where SSE2 is there, out of coordinate columns
+// gathered once. The metrics of a part can be evaluated again on their
+// own once only its nodes have moved.
+class MeshQuality {
+public:
+    static constexpr size_t kMetricCount = static_cast<size_t>(QualityMetric::COUNT);
+    static constexpr size_t kHistogramBins = 64;
+    
+    static const char* GetName(QualityMetric metric);
+    static bool IsLowerWorse(QualityMetric metric);
+    
+    // All elements; springs, unknown types and elements with undefined
+    // nodes get no value (NaN)
+    void Evaluate(const Model& model);
+    
+    // Elements of one part (property ID). Falls back to Evaluate when the
+    // model's elements or nodes have been added or removed since.
+    void EvaluatePart(const Model& model, int partId);
+    
+    void Clear();
+    bool IsEmpty() const { return m_ElementCount == 0; }
+    
+    // Failing counts follow the new limits; the values stay
+    void SetThresholds(const QualityThresholds& thresholds);
+    const QualityThresholds& GetThresholds() const { return m_Thresholds; }
+    
+    const std::vector<float>& GetValues(QualityMetric metric) const { return m_Values[Slot(metric)]; }
+    const QualityHistogram& GetHistogram(QualityMetric metric) const { return m_Histograms[Slot(metric)]; }
+    bool Fails(QualityMetric metric, float value) const;
+    
+    // Sorted IDs of the elements failing one metric, or any
+    std::vector<int> Select(const Model& model, QualityMetric metric) const;
+    std::vector<int> SelectFailing(const Model& model) const;
+    
+    size_t GetElementCount() const { return m_ElementCount; }
+    size_t GetEvaluatedCount() const { return m_Evaluated; }
+    double GetSeconds() const { return m_Seconds; }   // Of the last evaluation
+
+private:
+    // Elements [begin, end) of one block
+    struct Range {
+        size_t block;
+        size_t begin;
+        size_t end;
+    };
+    
+    static size_t Slot(QualityMetric metric) { return static_cast<size_t>(metric); }
+    
+    // All nodes, or with ranges only those of their elements
+    void UpdateColumns(const Model& model, const std::vector<Range>* ranges);
+    void EvaluateRanges(const Model& model, const std::vector<Range>& ranges);
+    void BuildHistograms();
+
+private:
+    std::array<std::vector<float>, kMetricCount> m_Values;
+    std::array<QualityHistogram, kMetricCount> m_Histograms;
+    QualityThresholds m_Thresholds;
+    
+    // Node coordinates as of the last evaluation, and where each part's
+    // elements lie
+    std::vector<float> m_X, m_Y, m_Z;
+    std::unordered_map<int, std::vector<Range>> m_PartRanges;
+    
+    size_t m_ElementCount = 0;
+    size_t m_NodeCount = 0;
+    size_t m_Evaluated = 0;
+    double m_Seconds = 0.0;
+};
@@ -1,115 +1,862 @@
 #include "core/Model.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <limits>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t kUnmapped = NodeAdjacency::kMissing;
+static_assert(kUnmapped == ElementArrays::kMissingNode, "node maps double as node indices");
+
+std::vector<int> GetMaterialIds(const std::vector<Material>& materials) {
+    std::vector<int> ids(materials.size());
+    for (size_t i = 0; i < materials.size(); ++i) {
+        ids[i] = materials[i].id;
+    }
+    return ids;
+}
+
+// Where two versions of the same arrays differ: [oldFirst, oldEnd) of one
+// against [newFirst, newEnd) of the other, in chunks or in entries. Between
+// runs both versions hold the very same chunks.
+struct Run {
+    size_t oldFirst;
+    size_t oldEnd;
+    size_t newFirst;
+    size_t newEnd;
+};
+
+// Chunks never change order, so matching them is one pass over from's
+// chunk table with a lookup into to's. Runs of empty chunks are left out.
+template<typename Arrays>
+std::vector<Run> DiffChunks(const Arrays& from, const Arrays& to) {
+    const size_t fromCount = from.ids.GetChunkCount();
+    const size_t toCount = to.ids.GetChunkCount();
+    std::unordered_map<const void*, size_t> positions;
+    positions.reserve(toCount);
+    for (size_t j = 0; j < toCount; ++j) {
+        positions.emplace(to.ids.GetChunkKey(j), j);
+    }
+    
+    std::vector<Run> runs;
+    auto push = [&](const Run& run) {
+        if (from.ids.GetChunkOffset(run.oldFirst) != from.ids.GetChunkOffset(run.oldEnd) ||
+            to.ids.GetChunkOffset(run.newFirst) != to.ids.GetChunkOffset(run.newEnd)) {
+            runs.push_back(run);
+        }
+    };
+    size_t i = 0;
+    size_t j = 0;
+    for (size_t k = 0; k < fromCount; ++k) {
+        auto it = positions.find(from.ids.GetChunkKey(k));
+        if (it == positions.end() || it->second < j || !from.SharesChunk(k, to, it->second)) {
+            continue;
+        }
+        push({i, k, j, it->second});
+        i = k + 1;
+        j = it->second + 1;
+    }
+    push({i, fromCount, j, toCount});
+    return runs;
+}
+
+// Chunk runs as entry runs of a column
+template<typename T>
+std::vector<Run> ToEntries(const std::vector<Run>& runs, const ChunkedColumn<T>& from,
+                           const ChunkedColumn<T>& to) {
+    std::vector<Run> entries;
+    entries.reserve(runs.size());
+    for (const Run& run : runs) {
+        entries.push_back({from.GetChunkOffset(run.oldFirst), from.GetChunkOffset(run.oldEnd),
+                           to.GetChunkOffset(run.newFirst), to.GetChunkOffset(run.newEnd)});
+    }
+    return entries;
+}
+
+// Old index to new for every entry of from: entries between runs follow
+// their chunk, entries of a run map to kUnmapped unless keepIds is set and
+// the run's IDs are the same on both sides. Empty when no entry moves.
+std::vector<uint32_t> MapEntries(const std::vector<Run>& runs, const ChunkedColumn<int>& from,
+                                 const ChunkedColumn<int>& to, bool keepIds) {
+    std::vector<char> kept(runs.size(), 0);
+    bool identity = true;
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const Run& run = runs[r];
+        if (keepIds && run.oldEnd - run.oldFirst == run.newEnd - run.newFirst) {
+            kept[r] = 1;
+            for (size_t i = run.oldFirst; i < run.oldEnd && kept[r]; ++i) {
+                kept[r] = from[i] == to[run.newFirst + (i - run.oldFirst)];
+            }
+        }
+        bool inPlace = run.oldFirst == run.oldEnd || (kept[r] && run.oldFirst == run.newFirst);
+        identity = identity && inPlace && (run.oldEnd == from.size() || run.oldEnd == run.newEnd);
+    }
+    if (identity) {
+        return {};
+    }
+    
+    std::vector<uint32_t> map(from.size());
+    size_t oldIndex = 0;
+    size_t newIndex = 0;
+    for (size_t r = 0; r <= runs.size(); ++r) {
+        size_t matchedEnd = r < runs.size() ? runs[r].oldFirst : from.size();
+        while (oldIndex < matchedEnd) {
+            map[oldIndex++] = static_cast<uint32_t>(newIndex++);
+        }
+        if (r < runs.size()) {
+            for (size_t i = runs[r].oldFirst; i < runs[r].oldEnd; ++i) {
+                map[i] = kept[r] ? static_cast<uint32_t>(runs[r].newFirst + (i - runs[r].oldFirst)) : kUnmapped;
+            }
+            oldIndex = runs[r].oldEnd;
+            newIndex = runs[r].newEnd;
+        }
+    }
+    return map;
+}
+
+// Brings an index of from's IDs to to's, given their entry runs: erases
+// the IDs of the old runs, inserts those of the new ones and renumbers the
+// entries a run shifted. RANGES cannot erase, and a repeated ID has to
+// fall back to an earlier index, so both rebuild instead.
+void PatchIdIndex(IdIndex& index, const ChunkedColumn<int>& from, const ChunkedColumn<int>& to,
+                  const std::vector<Run>& runs) {
+    bool patch = index.Size() == from.size();
+    for (size_t r = 0; r < runs.size() && patch; ++r) {
+        from.ForEachSpan(runs[r].oldFirst, runs[r].oldEnd, [&](const int* ids, size_t count, size_t first) {
+            for (size_t k = 0; k < count && patch; ++k) {
+                patch = index.Erase(ids[k], first + k);
+            }
+        });
+    }
+    if (patch) {
+        auto insert = [&](size_t first, size_t last) {
+            to.ForEachSpan(first, last, [&](const int* ids, size_t count, size_t offset) {
+                for (size_t k = 0; k < count; ++k) {
+                    index.Insert(ids[k], offset + k);
+                }
+            });
+        };
+        for (size_t r = 0; r < runs.size(); ++r) {
+            insert(runs[r].newFirst, runs[r].newEnd);
+            if (runs[r].newEnd != runs[r].oldEnd) {
+                insert(runs[r].newEnd, r + 1 < runs.size() ? runs[r + 1].newFirst : to.size());
+            }
+        }
+        patch = index.Size() == to.size();
+    }
+    if (!patch) {
+        index.Build(to);
+    }
+}
+
+} // namespace
 
 Model::Model() 
     : m_MinBounds(0.0f), m_MaxBounds(0.0f) {
 }
 
 void Model::AddNode(const Node& node) {
-    m_NodeIdToIndex[node.id] = m_Nodes.size();
-    m_Nodes.push_back(node);
+    bool kinematics = HasNodeKinematics();
+    AddNode(node.id, node.position, node.GetFixity());
+    if (kinematics) {
+        m_Nodes.displacements.back() = node.displacement;
+        m_Nodes.velocities.back() = node.velocity;
+        m_Nodes.accelerations.back() = node.acceleration;
+    }
+}
+
+void Model::AddNode(int nodeId, const glm::vec3& position, uint8_t fixity) {
+    // A new node can take over references that named no node, or, with a
+    // repeated ID, those of the earlier definition; rebuild on next use then
+    if (m_Adjacency.IsBuilt()) {
+        if (m_Adjacency.GetUnresolvedCount() > 0 || m_NodeIndex.Contains(nodeId)) {
+            m_Adjacency.Clear();
+        } else {
+            m_Adjacency.AddNodes(1);
+        }
+    }
+    
+    m_NodeIndex.Insert(nodeId, m_Nodes.Size());
+    InvalidateNodeIndices();
+    if (m_EditDepth > 0) {
+        ++m_PendingChange.nodesAdded;
+    }
+    m_Nodes.PushBack(nodeId, position, fixity);
+    if (!m_Nodes.displacements.empty()) {
+        m_Nodes.displacements.emplace_back(0.0f);
+        m_Nodes.velocities.emplace_back(0.0f);
+        m_Nodes.accelerations.emplace_back(0.0f);
+    }
 }
 
 void Model::RemoveNode(int nodeId) {
-    auto it = m_NodeIdToIndex.find(nodeId);
-    if (it != m_NodeIdToIndex.end()) {
-        size_t index = it->second;
-        m_Nodes.erase(m_Nodes.begin() + index);
-        m_NodeIdToIndex.erase(it);
-        
-        // Update indices
-        for (auto& pair : m_NodeIdToIndex) {
-            if (pair.second > index) {
-                pair.second--;
+    size_t index = FindNodeIndex(nodeId);
+    if (index == kInvalidIndex) {
+        return;
+    }
+    
+    BeginEdit();
+    if (m_RemovedNodes.size() <= index) {
+        m_RemovedNodes.resize(m_Nodes.Size(), 0);
+    }
+    m_RemovedNodes[index] = 1;
+    ++m_PendingChange.nodesRemoved;
+    CommitEdit();
+}
+
+void Model::RemoveNodes(const std::vector<int>& nodeIds) {
+    BeginEdit();
+    for (int nodeId : nodeIds) {
+        RemoveNode(nodeId);
+    }
+    CommitEdit();
+}
+
+size_t Model::MergeNodes(const std::vector<uint32_t>& targets) {
+    if (targets.size() != m_Nodes.Size()) {
+        LOG_ERROR("Node merge has {} targets for {} nodes", targets.size(), m_Nodes.Size());
+        return 0;
+    }
+    if (!m_Elements.HasNodeIndices()) {
+        ResolveNodeIndices(m_Elements.nodeIndices);
+    }
+    
+    // Connectivity first, chunk by chunk: only chunks with a rewritten
+    // reference are cloned away from any snapshot holding them
+    ElementArrays& elements = m_Elements;
+    std::atomic<size_t> rewritten{0};
+    ThreadPool::GetGlobal().ParallelFor(elements.nodeIds.GetChunkCount(), 1, [&](size_t first, size_t last) {
+        size_t count = 0;
+        for (size_t chunk = first; chunk < last; ++chunk) {
+            const size_t begin = elements.nodeIds.GetChunkOffset(chunk);
+            const size_t end = begin + elements.nodeIds.GetChunkSize(chunk);
+            int* nodeIds = nullptr;
+            for (size_t k = begin; k < end; ++k) {
+                const uint32_t node = elements.nodeIndices[k];
+                if (node != ElementArrays::kMissingNode && targets[node] != node) {
+                    if (!nodeIds) {
+                        nodeIds = elements.nodeIds.MutableChunk(chunk);
+                    }
+                    elements.nodeIndices[k] = targets[node];
+                    nodeIds[k - begin] = m_Nodes.ids[targets[node]];
+                    ++count;
+                }
             }
         }
+        rewritten += count;
+    });
+    
+    BeginEdit();
+    m_RemovedNodes.resize(m_Nodes.Size(), 0);
+    for (size_t n = 0; n < targets.size(); ++n) {
+        if (targets[n] != n && !m_RemovedNodes[n]) {
+            m_RemovedNodes[n] = 1;
+            ++m_PendingChange.nodesRemoved;
+        }
+    }
+    if (rewritten > 0) {
+        m_Adjacency.Clear();   // Rows moved between nodes; rebuilt when next asked for
+    }
+    CommitEdit();
+    return rewritten.load();
+}
+
+size_t Model::FindNodeIndex(int nodeId) const {
+    size_t index = m_NodeIndex.Find(nodeId);
+    if (index < m_RemovedNodes.size() && m_RemovedNodes[index]) {
+        return kInvalidIndex;
     }
+    return index;
 }
 
-Node* Model::GetNode(int nodeId) {
-    auto it = m_NodeIdToIndex.find(nodeId);
-    if (it != m_NodeIdToIndex.end()) {
-        return &m_Nodes[it->second];
+Node Model::GetNode(size_t index) const {
+    Node node(m_Nodes.ids[index], m_Nodes.positions[index]);
+    uint8_t fixity = m_Nodes.fixity[index];
+    node.fixedX = (fixity & FIXED_X) != 0;
+    node.fixedY = (fixity & FIXED_Y) != 0;
+    node.fixedZ = (fixity & FIXED_Z) != 0;
+    if (HasNodeKinematics()) {
+        node.displacement = m_Nodes.displacements[index];
+        node.velocity = m_Nodes.velocities[index];
+        node.acceleration = m_Nodes.accelerations[index];
     }
-    return nullptr;
+    return node;
 }
 
-void Model::AddElement(const Element& element) {
-    m_ElementIdToIndex[element.id] = m_Elements.size();
-    m_Elements.push_back(element);
+const glm::vec3* Model::FindNodePosition(int nodeId) const {
+    size_t index = FindNodeIndex(nodeId);
+    return index != kInvalidIndex ? &m_Nodes.positions[index] : nullptr;
 }
 
-void Model::RemoveElement(int elementId) {
-    auto it = m_ElementIdToIndex.find(elementId);
-    if (it != m_ElementIdToIndex.end()) {
-        size_t index = it->second;
-        m_Elements.erase(m_Elements.begin() + index);
-        m_ElementIdToIndex.erase(it);
-        
-        // Update indices
-        for (auto& pair : m_ElementIdToIndex) {
-            if (pair.second > index) {
-                pair.second--;
-            }
+void Model::ReserveNodes(size_t count) {
+    // Geometric growth keeps repeated calls linear while a file streams in
+    if (count > m_Nodes.ids.capacity()) {
+        count = std::max(count, m_Nodes.ids.capacity() * 2);
+        m_Nodes.ids.reserve(count);
+        m_Nodes.positions.reserve(count);
+        m_Nodes.fixity.reserve(count);
+        m_NodeIndex.Reserve(count);
+    }
+}
+
+void Model::AllocateNodeKinematics() {
+    m_Nodes.displacements.assign(m_Nodes.Size(), glm::vec3(0.0f));
+    m_Nodes.velocities.assign(m_Nodes.Size(), glm::vec3(0.0f));
+    m_Nodes.accelerations.assign(m_Nodes.Size(), glm::vec3(0.0f));
+}
+
+void Model::ReleaseNodeKinematics() {
+    m_Nodes.displacements = std::vector<glm::vec3>();
+    m_Nodes.velocities = std::vector<glm::vec3>();
+    m_Nodes.accelerations = std::vector<glm::vec3>();
+}
+
+void Model::AddElement(const ElementView& element) {
+    bool resolved = m_Elements.HasNodeIndices();
+    size_t elementIndex = m_Elements.Size();
+    m_ElementIndex.Insert(element.id, elementIndex);
+    m_Elements.Append(element);
+    if (m_EditDepth > 0) {
+        ++m_PendingChange.elementsAdded;
+    }
+    
+    // Nodes normally come first, so references resolve as elements arrive
+    size_t count = element.nodeIds.size();
+    if (resolved) {
+        for (int nodeId : element.nodeIds) {
+            size_t index = FindNodeIndex(nodeId);
+            m_Elements.nodeIndices.push_back(index != kInvalidIndex
+                ? static_cast<uint32_t>(index) : ElementArrays::kMissingNode);
+        }
+        m_Adjacency.AddElement(static_cast<uint32_t>(elementIndex),
+                               m_Elements.nodeIndices.data() + m_Elements.nodeIndices.size() - count,
+                               count);
+    } else if (m_Adjacency.IsBuilt()) {
+        uint32_t local[8];
+        std::vector<uint32_t> spill(count > 8 ? count : 0);
+        uint32_t* indices = count > 8 ? spill.data() : local;
+        for (size_t k = 0; k < count; ++k) {
+            size_t index = FindNodeIndex(element.nodeIds[k]);
+            indices[k] = index != kInvalidIndex ? static_cast<uint32_t>(index) : ElementArrays::kMissingNode;
         }
+        m_Adjacency.AddElement(static_cast<uint32_t>(elementIndex), indices, count);
+    }
+}
+
+void Model::RemoveElement(int elementId) {
+    size_t index = FindElementIndex(elementId);
+    if (index == kInvalidIndex) {
+        return;
+    }
+    
+    BeginEdit();
+    if (m_RemovedElements.size() <= index) {
+        m_RemovedElements.resize(m_Elements.Size(), 0);
+    }
+    m_RemovedElements[index] = 1;
+    ++m_PendingChange.elementsRemoved;
+    CommitEdit();
+}
+
+void Model::RemoveElements(const std::vector<int>& elementIds) {
+    BeginEdit();
+    for (int elementId : elementIds) {
+        RemoveElement(elementId);
     }
+    CommitEdit();
 }
 
-Element* Model::GetElement(int elementId) {
-    auto it = m_ElementIdToIndex.find(elementId);
-    if (it != m_ElementIdToIndex.end()) {
-        return &m_Elements[it->second];
+size_t Model::FindElementIndex(int elementId) const {
+    size_t index = m_ElementIndex.Find(elementId);
+    if (index < m_RemovedElements.size() && m_RemovedElements[index]) {
+        return kInvalidIndex;
     }
-    return nullptr;
+    return index;
+}
+
+void Model::ReserveElements(size_t count, size_t nodeIdCount) {
+    // Without a connectivity size, assume quads: the common shell case
+    if (nodeIdCount == 0) {
+        nodeIdCount = count * 4;
+    }
+    if (count > m_Elements.ids.capacity()) {
+        count = std::max(count, m_Elements.ids.capacity() * 2);
+        m_ElementIndex.Reserve(count);
+    } else {
+        count = m_Elements.ids.capacity();
+    }
+    if (nodeIdCount > m_Elements.nodeIds.capacity()) {
+        nodeIdCount = std::max(nodeIdCount, m_Elements.nodeIds.capacity() * 2);
+    }
+    m_Elements.Reserve(count, nodeIdCount);
 }
 
 void Model::AddMaterial(const Material& material) {
-    m_MaterialIdToIndex[material.id] = m_Materials.size();
+    m_MaterialIndex.Insert(material.id, m_Materials.size());
+    m_SharedMaterials.reset();
+    if (m_EditDepth > 0) {
+        ++m_PendingChange.materialsAdded;
+    }
     m_Materials.push_back(material);
 }
 
-Material* Model::GetMaterial(int materialId) {
-    auto it = m_MaterialIdToIndex.find(materialId);
-    if (it != m_MaterialIdToIndex.end()) {
-        return &m_Materials[it->second];
+bool Model::UpdateMaterial(const Material& material) {
+    size_t index = m_MaterialIndex.Find(material.id);
+    if (index == kInvalidIndex) {
+        return false;
     }
-    return nullptr;
+    m_Materials[index] = material;
+    m_SharedMaterials.reset();
+    return true;
+}
+
+const Material* Model::GetMaterial(int materialId) const {
+    size_t index = m_MaterialIndex.Find(materialId);
+    return index != kInvalidIndex ? &m_Materials[index] : nullptr;
 }
 
 void Model::CalculateBounds() {
-    if (m_Nodes.empty()) {
+    if (m_Nodes.positions.empty()) {
         m_MinBounds = m_MaxBounds = glm::vec3(0.0f);
         return;
     }
     
-    m_MinBounds = glm::vec3(std::numeric_limits<float>::max());
-    m_MaxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+    // Walk each chunk of positions as a flat float array in blocks of 12
+    // (four xyz triples), so lane k always holds component k % 3 and the
+    // loop vectorizes without shuffles
+    float lo[12], hi[12];
+    const glm::vec3& first = m_Nodes.positions[0];
+    for (int k = 0; k < 12; ++k) {
+        lo[k] = first[k % 3];
+        hi[k] = first[k % 3];
+    }
+    m_Nodes.positions.ForEachSpan([&](const glm::vec3* positions, size_t n, size_t) {
+        const float* values = &positions[0].x;
+        size_t count = n * 3;
+        size_t blocked = count - count % 12;
+        for (size_t i = 0; i < blocked; i += 12) {
+            for (int k = 0; k < 12; ++k) {
+                lo[k] = std::min(lo[k], values[i + k]);
+                hi[k] = std::max(hi[k], values[i + k]);
+            }
+        }
+        for (size_t i = blocked; i < count; ++i) {
+            lo[i % 3] = std::min(lo[i % 3], values[i]);
+            hi[i % 3] = std::max(hi[i % 3], values[i]);
+        }
+    });
     
-    for (const auto& node : m_Nodes) {
-        m_MinBounds = glm::min(m_MinBounds, node.position);
-        m_MaxBounds = glm::max(m_MaxBounds, node.position);
+    for (int c = 0; c < 3; ++c) {
+        float minValue = lo[c];
+        float maxValue = hi[c];
+        for (int k = c + 3; k < 12; k += 3) {
+            minValue = std::min(minValue, lo[k]);
+            maxValue = std::max(maxValue, hi[k]);
+        }
+        m_MinBounds[c] = minValue;
+        m_MaxBounds[c] = maxValue;
     }
 }
 
 float Model::GetBoundingRadius() const {
     glm::vec3 center = GetCenter();
-    float maxDist = 0.0f;
+    float maxDistSq = 0.0f;
     
-    for (const auto& node : m_Nodes) {
-        float dist = glm::length(node.position - center);
-        maxDist = std::max(maxDist, dist);
+    for (const glm::vec3& position : m_Nodes.positions) {
+        glm::vec3 d = position - center;
+        maxDistSq = std::max(maxDistSq, d.x * d.x + d.y * d.y + d.z * d.z);
     }
     
-    return maxDist;
+    return std::sqrt(maxDistSq);
 }
 
 void Model::Clear() {
-    m_Nodes.clear();
-    m_Elements.clear();
+    m_Nodes = NodeArrays();
+    m_Elements = ElementArrays();
     m_Materials.clear();
-    m_NodeIdToIndex.clear();
-    m_ElementIdToIndex.clear();
-    m_MaterialIdToIndex.clear();
+    m_NodeIndex.Clear();
+    m_ElementIndex.Clear();
+    m_MaterialIndex.Clear();
+    m_Adjacency.Clear();
+    m_RemovedNodes.clear();
+    m_RemovedElements.clear();
     m_MinBounds = m_MaxBounds = glm::vec3(0.0f);
+    m_SharedMaterials.reset();
+}
+
+void Model::Assign(NodeArrays&& nodes, ElementArrays&& elements,
+                   std::vector<Material>&& materials) {
+    m_Nodes = std::move(nodes);
+    m_Elements = std::move(elements);
+    m_Materials = std::move(materials);
+    m_RemovedNodes.clear();
+    m_RemovedElements.clear();
+    m_NodeIndex.Build(m_Nodes.ids);
+    m_ElementIndex.Build(m_Elements.ids);
+    m_MaterialIndex.Build(GetMaterialIds(m_Materials));
+    m_Adjacency.Clear();
+    m_SharedMaterials.reset();
+    
+    m_Elements.nodeIndices.clear();
+    BuildLookups();
+    CalculateBounds();
+}
+
+size_t Model::BuildLookups() {
+    auto compact = [](IdIndex& index, const ChunkedColumn<int>& ids) {
+        if (index.GetMode() == IdIndex::Mode::HASH) {
+            index.Build(ids);
+        }
+    };
+    compact(m_NodeIndex, m_Nodes.ids);
+    compact(m_ElementIndex, m_Elements.ids);
+    if (m_MaterialIndex.GetMode() == IdIndex::Mode::HASH) {
+        m_MaterialIndex.Build(GetMaterialIds(m_Materials));
+    }
+    
+    size_t missing = 0;
+    if (m_Elements.HasNodeIndices()) {
+        const std::vector<uint32_t>& nodeIndices = m_Elements.nodeIndices;
+        missing = static_cast<size_t>(std::count(nodeIndices.begin(), nodeIndices.end(),
+                                                 ElementArrays::kMissingNode));
+    } else {
+        missing = ResolveNodeIndices(m_Elements.nodeIndices);
+    }
+    
+    LOG_DEBUG("Model lookups: nodes {} ({} KB), elements {} ({} KB)",
+              IdIndex::ModeToString(m_NodeIndex.GetMode()), m_NodeIndex.GetMemoryBytes() / 1024,
+              IdIndex::ModeToString(m_ElementIndex.GetMode()), m_ElementIndex.GetMemoryBytes() / 1024);
+    return missing;
+}
+
+size_t Model::ResolveNodeIndices(std::vector<uint32_t>& nodeIndices) const {
+    const ChunkedColumn<int>& nodeIds = m_Elements.nodeIds;
+    nodeIndices.resize(nodeIds.size());
+    
+    std::atomic<size_t> missing{0};
+    ThreadPool::GetGlobal().ParallelFor(nodeIds.size(), 1u << 16, [&](size_t begin, size_t end) {
+        size_t count = 0;
+        nodeIds.ForEachSpan(begin, end, [&](const int* ids, size_t n, size_t first) {
+            for (size_t k = 0; k < n; ++k) {
+                size_t index = FindNodeIndex(ids[k]);
+                nodeIndices[first + k] = index != kInvalidIndex
+                    ? static_cast<uint32_t>(index) : ElementArrays::kMissingNode;
+                count += index == kInvalidIndex;
+            }
+        });
+        missing += count;
+    });
+    return missing.load();
+}
+
+const NodeAdjacency& Model::GetNodeAdjacency() const {
+    if (m_Adjacency.IsBuilt()) {
+        m_Adjacency.Flush();
+    } else if (m_Elements.HasNodeIndices()) {
+        m_Adjacency.Build(m_Elements, m_Elements.nodeIndices, m_Nodes.Size());
+    } else {
+        std::vector<uint32_t> nodeIndices;
+        ResolveNodeIndices(nodeIndices);
+        m_Adjacency.Build(m_Elements, nodeIndices, m_Nodes.Size());
+    }
+    return m_Adjacency;
+}
+
+void Model::InvalidateNodeIndices() {
+    // Any node change may move an index or define a missing node
+    if (!m_Elements.nodeIds.empty()) {
+        m_Elements.nodeIndices = std::vector<uint32_t>();
+    }
+}
+
+void Model::BeginEdit() {
+    if (m_EditDepth++ == 0) {
+        m_PendingChange = ModelChange();
+    }
+}
+
+void Model::CommitEdit() {
+    if (m_EditDepth == 0 || --m_EditDepth > 0) {
+        return;
+    }
+    
+    if (!m_RemovedNodes.empty()) {
+        CompactNodes();
+    }
+    if (!m_RemovedElements.empty()) {
+        CompactElements();
+    }
+    if (m_PendingChange.NodesChanged()) {
+        // Node indices moved; re-resolve connectivity while at it
+        BuildLookups();
+        CalculateBounds();
+    }
+    
+    ModelChange change = m_PendingChange;
+    m_PendingChange = ModelChange();
+    if (!change.Empty()) {
+        NotifyListeners(change);
+    }
+}
+
+void Model::NotifyListeners(const ModelChange& change) {
+    // A copy, so listeners may unregister while being called
+    auto listeners = m_Listeners.entries;
+    for (const auto& entry : listeners) {
+        entry.second(change);
+    }
+}
+
+int Model::AddChangeListener(ModelChangeListener listener) {
+    int handle = m_Listeners.nextHandle++;
+    m_Listeners.entries.emplace_back(handle, std::move(listener));
+    return handle;
+}
+
+void Model::RemoveChangeListener(int handle) {
+    auto& entries = m_Listeners.entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [handle](const auto& entry) { return entry.first == handle; }),
+                  entries.end());
+}
+
+void Model::CompactNodes() {
+    std::vector<char> removed = std::move(m_RemovedNodes);
+    m_RemovedNodes = std::vector<char>();
+    
+    // Marks past the end of removed belong to nodes added during the edit.
+    // The definition columns rewrite only the chunks that lose a node.
+    m_Nodes.ids.Remove(removed);
+    m_Nodes.positions.Remove(removed);
+    m_Nodes.fixity.Remove(removed);
+    auto compact = [&removed](std::vector<glm::vec3>& values) {
+        size_t kept = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i < removed.size() && removed[i]) {
+                continue;
+            }
+            if (kept != i) {
+                values[kept] = std::move(values[i]);
+            }
+            ++kept;
+        }
+        values.erase(values.begin() + kept, values.end());
+    };
+    compact(m_Nodes.displacements);
+    compact(m_Nodes.velocities);
+    compact(m_Nodes.accelerations);
+    
+    m_NodeIndex.Build(m_Nodes.ids);
+    m_Adjacency.RemoveNodes(removed);
+    InvalidateNodeIndices();
+}
+
+void Model::CompactElements() {
+    std::vector<char> removed = std::move(m_RemovedElements);
+    m_RemovedElements = std::vector<char>();
+    
+    m_Elements.Compact(removed);
+    m_ElementIndex.Build(m_Elements.ids);
+    m_Adjacency.RemoveElements(removed);
+}
+
+std::shared_ptr<const ModelSnapshot> Model::TakeSnapshot() {
+    auto snapshot = std::make_shared<ModelSnapshot>();
+    NodeArrays& nodes = snapshot->m_Nodes;
+    nodes.ids = m_Nodes.ids;
+    nodes.positions = m_Nodes.positions;
+    nodes.fixity = m_Nodes.fixity;
+    ElementArrays& elements = snapshot->m_Elements;
+    elements.ids = m_Elements.ids;
+    elements.materialIds = m_Elements.materialIds;
+    elements.propertyIds = m_Elements.propertyIds;
+    elements.thickness = m_Elements.thickness;
+    elements.nodeIds = m_Elements.nodeIds;
+    elements.blocks = m_Elements.blocks;
+    
+    size_t copied = nodes.ids.GetTableBytes() + nodes.positions.GetTableBytes() +
+                    nodes.fixity.GetTableBytes() + elements.ids.GetTableBytes() +
+                    elements.materialIds.GetTableBytes() + elements.propertyIds.GetTableBytes() +
+                    elements.thickness.GetTableBytes() + elements.nodeIds.GetTableBytes() +
+                    elements.blocks.capacity() * sizeof(ElementBlock);
+    if (!m_SharedMaterials) {
+        m_SharedMaterials = std::make_shared<const std::vector<Material>>(m_Materials);
+        copied += m_Materials.size() * sizeof(Material);
+    }
+    snapshot->m_Materials = m_SharedMaterials;
+    snapshot->m_CopiedBytes = copied;
+    
+    LOG_DEBUG("Model snapshot: {} nodes, {} elements, {} KB copied",
+              snapshot->GetNodeCount(), snapshot->GetElementCount(), copied / 1024);
+    return snapshot;
+}
+
+void Model::Restore(const std::shared_ptr<const ModelSnapshot>& snapshot) {
+    if (!snapshot) {
+        return;
+    }
+    if (m_EditDepth > 0) {
+        LOG_ERROR("Model snapshot restored during an edit; ignored");
+        return;
+    }
+    
+    ReleaseNodeKinematics();
+    ModelChange change;
+    const NodeArrays& nodes = snapshot->m_Nodes;
+    const ElementArrays& elements = snapshot->m_Elements;
+    const bool resolved = m_Elements.HasNodeIndices();
+    if (!resolved) {
+        m_Adjacency.Clear();
+    }
+    
+    // Nodes: only the runs of chunks the snapshot does not share change.
+    // nodeMap takes old node indices to new ones, and is empty while every
+    // node keeps its index and ID.
+    std::vector<Run> nodeRuns = ToEntries(DiffChunks(m_Nodes, nodes), m_Nodes.ids, nodes.ids);
+    std::vector<uint32_t> nodeMap;
+    if (!nodeRuns.empty()) {
+        nodeMap = MapEntries(nodeRuns, m_Nodes.ids, nodes.ids, true);
+        PatchIdIndex(m_NodeIndex, m_Nodes.ids, nodes.ids, nodeRuns);
+        for (const Run& run : nodeRuns) {
+            change.nodesRemoved += run.oldEnd - run.oldFirst;
+            change.nodesAdded += run.newEnd - run.newFirst;
+        }
+        m_Nodes.ids = nodes.ids;
+        m_Nodes.positions = nodes.positions;
+        m_Nodes.fixity = nodes.fixity;
+        if (!nodeMap.empty()) {
+            m_Adjacency.RemapNodes(nodeMap, m_Nodes.Size());
+        }
+    }
+    
+    // Elements likewise; the chunks of their connectivity are in step, so
+    // the same chunk runs give the connectivity runs
+    std::vector<Run> elementChunks = DiffChunks(m_Elements, elements);
+    std::vector<Run> elementRuns = ToEntries(elementChunks, m_Elements.ids, elements.ids);
+    std::vector<Run> connectivityRuns = ToEntries(elementChunks, m_Elements.nodeIds, elements.nodeIds);
+    if (!elementRuns.empty()) {
+        std::vector<uint32_t> elementMap = MapEntries(elementRuns, m_Elements.ids, elements.ids, false);
+        PatchIdIndex(m_ElementIndex, m_Elements.ids, elements.ids, elementRuns);
+        if (!elementMap.empty()) {
+            m_Adjacency.RenumberElements(elementMap);
+        }
+        for (const Run& run : elementRuns) {
+            change.elementsRemoved += run.oldEnd - run.oldFirst;
+            change.elementsAdded += run.newEnd - run.newFirst;
+        }
+    }
+    
+    // Node indices of shared connectivity carry over through nodeMap, in
+    // place while every run keeps its size; the runs themselves, and any
+    // reference a node change left missing, are resolved by ID
+    const bool nodesMoved = !nodeMap.empty();
+    if (resolved && (nodesMoved || !elementRuns.empty())) {
+        bool inPlace = true;
+        for (const Run& run : connectivityRuns) {
+            inPlace = inPlace && run.oldEnd - run.oldFirst == run.newEnd - run.newFirst;
+        }
+        std::vector<uint32_t> previous = std::move(m_Elements.nodeIndices);
+        std::vector<uint32_t>& indices = m_Elements.nodeIndices;
+        if (inPlace) {
+            indices = std::move(previous);
+        } else {
+            indices.resize(elements.nodeIds.size());
+        }
+        auto carry = [&](size_t from, size_t to, size_t count) {
+            if (!inPlace) {
+                std::copy(previous.begin() + from, previous.begin() + from + count, indices.begin() + to);
+            }
+            if (nodesMoved) {
+                for (size_t k = to; k < to + count; ++k) {
+                    indices[k] = indices[k] != kUnmapped ? nodeMap[indices[k]] : kUnmapped;
+                }
+            }
+        };
+        size_t from = 0;
+        size_t to = 0;
+        for (const Run& run : connectivityRuns) {
+            carry(from, to, run.oldFirst - from);
+            std::fill(indices.begin() + run.newFirst, indices.begin() + run.newEnd, kUnmapped);
+            from = run.oldEnd;
+            to = run.newEnd;
+        }
+        carry(from, to, indices.size() - to);
+    }
+    
+    m_Elements.ids = elements.ids;
+    m_Elements.materialIds = elements.materialIds;
+    m_Elements.propertyIds = elements.propertyIds;
+    m_Elements.thickness = elements.thickness;
+    m_Elements.nodeIds = elements.nodeIds;
+    m_Elements.blocks = elements.blocks;
+    
+    if (!resolved) {
+        ResolveNodeIndices(m_Elements.nodeIndices);
+    } else if (nodesMoved || !elementRuns.empty()) {
+        // New elements resolve every reference; with nodes renumbered, kept
+        // elements retry the references that are missing
+        std::vector<uint32_t>& indices = m_Elements.nodeIndices;
+        auto resolve = [&](size_t first, size_t last, bool added) {
+            if (first >= last) {
+                return;
+            }
+            for (size_t b = m_Elements.FindBlock(first); b < m_Elements.blocks.size() &&
+                                                         m_Elements.blocks[b].firstElement < last; ++b) {
+                const ElementBlock& block = m_Elements.blocks[b];
+                const size_t stride = static_cast<size_t>(block.nodesPerElement);
+                for (size_t i = std::max(first, block.firstElement); i < std::min(last, block.EndElement()); ++i) {
+                    const size_t offset = block.firstNodeId + (i - block.firstElement) * stride;
+                    const int* nodeIds = m_Elements.GetNodeIdData(i, offset);
+                    for (size_t k = 0; k < stride; ++k) {
+                        if (indices[offset + k] != kUnmapped) {
+                            continue;
+                        }
+                        size_t index = FindNodeIndex(nodeIds[k]);
+                        if (index != kInvalidIndex) {
+                            indices[offset + k] = static_cast<uint32_t>(index);
+                            if (!added) {
+                                m_Adjacency.AddElement(static_cast<uint32_t>(i), &indices[offset + k], 1);
+                            }
+                        }
+                    }
+                    if (added) {
+                        m_Adjacency.AddElement(static_cast<uint32_t>(i), &indices[offset], stride);
+                    }
+                }
+            }
+        };
+        size_t next = 0;
+        for (const Run& run : elementRuns) {
+            if (nodesMoved) {
+                resolve(next, run.newFirst, false);
+            }
+            resolve(run.newFirst, run.newEnd, true);
+            next = run.newEnd;
+        }
+        if (nodesMoved) {
+            resolve(next, m_Elements.Size(), false);
+        }
+        if (m_Adjacency.IsBuilt()) {
+            m_Adjacency.SetUnresolvedCount(static_cast<size_t>(
+                std::count(indices.begin(), indices.end(), ElementArrays::kMissingNode)));
+        }
+    }
+    if (!nodeRuns.empty()) {
+        CalculateBounds();
+    }
+    
+    if (snapshot->m_Materials != m_SharedMaterials) {
+        m_Materials = *snapshot->m_Materials;
+        m_MaterialIndex.Build(GetMaterialIds(m_Materials));
+        m_SharedMaterials = snapshot->m_Materials;
+        change.materialsAdded += m_Materials.size();
+    }
+    
+    if (!change.Empty()) {
+        NotifyListeners(change);
+    }
 }
@@ -2,31 +2,99 @@
 #include "Node.h"
 #include "Element.h"
 #include "Material.h"
+#include "IdIndex.h"
+#include "NodeAdjacency.h"
+#include "ModelSnapshot.h"
+#include <functional>
 #include <vector>
-#include <unordered_map>
 #include <memory>
+#include <utility>
 #include <glm/glm.hpp>
 
+// What one committed edit did, passed to change listeners
+struct ModelChange {
+    size_t nodesAdded = 0;
+    size_t nodesRemoved = 0;
+    size_t elementsAdded = 0;
+    size_t elementsRemoved = 0;
+    size_t materialsAdded = 0;
+    
+    bool NodesChanged() const { return nodesAdded || nodesRemoved; }
+    bool ElementsChanged() const { return elementsAdded || elementsRemoved; }
+    bool Empty() const { return !NodesChanged() && !ElementsChanged() && !materialsAdded; }
+};
+
+using ModelChangeListener = std::function<void(const ModelChange&)>;
+
 class Model {
 public:
     Model();
     ~Model() = default;
     
-    // Node operations
+    Model(const Model&) = default;
+    Model& operator=(const Model&) = default;
+    Model(Model&&) = default;
+    Model& operator=(Model&&) = default;
+    
+    static constexpr size_t kInvalidIndex = IdIndex::kNotFound;
+    
+    // Node operations. Nodes live in separate arrays (see NodeArrays) and are
+    // addressed by index; FindNodeIndex maps an id to that index.
     void AddNode(const Node& node);
+    void AddNode(int nodeId, const glm::vec3& position, uint8_t fixity = FIXED_NONE);
     void RemoveNode(int nodeId);
-    Node* GetNode(int nodeId);
-    const std::vector<Node>& GetNodes() const { return m_Nodes; }
+    size_t FindNodeIndex(int nodeId) const;
+    bool HasNode(int nodeId) const { return FindNodeIndex(nodeId) != kInvalidIndex; }
+    Node GetNode(size_t index) const;
+    void ReserveNodes(size_t count);
+    
+    const NodeArrays& GetNodeArrays() const { return m_Nodes; }
+    const ChunkedColumn<int>& GetNodeIds() const { return m_Nodes.ids; }
+    const ChunkedColumn<glm::vec3>& GetNodePositions() const { return m_Nodes.positions; }
+    const ChunkedColumn<uint8_t>& GetNodeFixity() const { return m_Nodes.fixity; }
+    const glm::vec3* FindNodePosition(int nodeId) const;
     
-    // Element operations
-    void AddElement(const Element& element);
+    // Kinematic results are only allocated once results are loaded
+    bool HasNodeKinematics() const { return m_Nodes.HasKinematics(); }
+    void AllocateNodeKinematics();
+    void ReleaseNodeKinematics();
+    std::vector<glm::vec3>& GetNodeDisplacements() { return m_Nodes.displacements; }
+    std::vector<glm::vec3>& GetNodeVelocities() { return m_Nodes.velocities; }
+    std::vector<glm::vec3>& GetNodeAccelerations() { return m_Nodes.accelerations; }
+    const std::vector<glm::vec3>& GetNodeDisplacements() const { return m_Nodes.displacements; }
+    const std::vector<glm::vec3>& GetNodeVelocities() const { return m_Nodes.velocities; }
+    const std::vector<glm::vec3>& GetNodeAccelerations() const { return m_Nodes.accelerations; }
+    
+    // Element operations. Elements live in ElementArrays and are read
+    // through ElementView; iterate with ForEachElement rather than by index
+    // to stream block by block.
+    void AddElement(const ElementView& element);
     void RemoveElement(int elementId);
-    Element* GetElement(int elementId);
-    const std::vector<Element>& GetElements() const { return m_Elements; }
+    size_t FindElementIndex(int elementId) const;
+    bool HasElement(int elementId) const { return FindElementIndex(elementId) != kInvalidIndex; }
+    ElementView GetElement(size_t index) const { return m_Elements.View(index); }
+    void ReserveElements(size_t count, size_t nodeIdCount = 0);
+    
+    const ElementArrays& GetElementArrays() const { return m_Elements; }
+    const std::vector<ElementBlock>& GetElementBlocks() const { return m_Elements.blocks; }
+    const ChunkedColumn<int>& GetElementIds() const { return m_Elements.ids; }
+    
+    // fn(size_t index, const ElementView& element) for elements [first, last)
+    template<typename Fn>
+    void ForEachElement(size_t first, size_t last, Fn&& fn) const {
+        m_Elements.ForEach(first, last, std::forward<Fn>(fn));
+    }
+    template<typename Fn>
+    void ForEachElement(Fn&& fn) const {
+        m_Elements.ForEach(0, m_Elements.Size(), std::forward<Fn>(fn));
+    }
     
     // Material operations
+    // Materials are changed only through UpdateMaterial, which replaces the
+    // one with the same ID; it returns false when there is none
     void AddMaterial(const Material& material);
-    Material* GetMaterial(int materialId);
+    bool UpdateMaterial(const Material& material);
+    const Material* GetMaterial(int materialId) const;
     const std::vector<Material>& GetMaterials() const { return m_Materials; }  // THIS WAS MISSING
     
     // Model properties
@@ -39,20 +107,97 @@ public:
     // Clear model
     void Clear();
     
+    // Replaces the whole model at once, e.g. from a cached snapshot, and
+    // builds its lookups
+    void Assign(NodeArrays&& nodes, ElementArrays&& elements,
+                std::vector<Material>&& materials);
+    
+    // One pass once a model is complete: rebuilds ID indices that fell back
+    // to hashing and renumbers element connectivity to node indices, so
+    // ElementView::nodeIndices is set and hot loops skip ID lookups. Returns
+    // the number of element node references that name no node.
+    size_t BuildLookups();
+    
+    // Elements using each node, built on first use and then updated by every
+    // change instead of rebuilt. During an edit it still lists removed
+    // elements until the commit. The first call after a change may merge
+    // pending updates, so it must not race other calls or changes.
+    const NodeAdjacency& GetNodeAdjacency() const;
+    
     // Statistics
-    size_t GetNodeCount() const { return m_Nodes.size(); }
-    size_t GetElementCount() const { return m_Elements.size(); }
+    size_t GetNodeCount() const { return m_Nodes.Size(); }
+    size_t GetElementCount() const { return m_Elements.Size(); }
     size_t GetMaterialCount() const { return m_Materials.size(); }
     
+    // Bulk edits. Between BeginEdit and the matching CommitEdit (calls
+    // nest), removals only mark entries: they stop being found by ID but
+    // stay in the arrays, so iteration still sees them. The outermost commit
+    // compacts every array and rebuilds the ID indices in one linear pass,
+    // updates the bounds and notifies the listeners once. Removing outside
+    // an edit is a single-entry edit of its own.
+    void BeginEdit();
+    void CommitEdit();
+    bool IsEditing() const { return m_EditDepth > 0; }
+    void RemoveNodes(const std::vector<int>& nodeIds);
+    void RemoveElements(const std::vector<int>& elementIds);
+    
+    // Points every element reference to node index i at targets[i] in one
+    // parallel pass over the connectivity, then removes each node that
+    // does not target itself. Targets must target themselves. Returns the
+    // number of references rewritten.
+    size_t MergeNodes(const std::vector<uint32_t>& targets);
+    
+    // Snapshots for undo and for background readers. The model's columns
+    // are chunked and copy-on-write, so TakeSnapshot copies chunk tables
+    // only and later edits clone just the chunks they write. Restore
+    // matches the snapshot's chunks against the live ones and replaces only
+    // the runs that differ, patching the ID indices, node indices and
+    // adjacency for those runs; it is one change to listeners and drops
+    // kinematic results. Call both outside an edit.
+    std::shared_ptr<const ModelSnapshot> TakeSnapshot();
+    void Restore(const std::shared_ptr<const ModelSnapshot>& snapshot);
+    
+    // Called after each commit that changed something. Listeners stay with
+    // this object: copying or moving a model carries its data, not them.
+    int AddChangeListener(ModelChangeListener listener);
+    void RemoveChangeListener(int handle);
+    
 private:
-    std::vector<Node> m_Nodes;
-    std::vector<Element> m_Elements;
+    struct ChangeListeners {
+        ChangeListeners() = default;
+        ChangeListeners(const ChangeListeners&) {}
+        ChangeListeners& operator=(const ChangeListeners&) { return *this; }
+        
+        std::vector<std::pair<int, ModelChangeListener>> entries;
+        int nextHandle = 1;
+    };
+    
+    size_t ResolveNodeIndices(std::vector<uint32_t>& nodeIndices) const;
+    void NotifyListeners(const ModelChange& change);
+    void InvalidateNodeIndices();
+    void CompactNodes();
+    void CompactElements();
+    
+private:
+    NodeArrays m_Nodes;
+    ElementArrays m_Elements;
     std::vector<Material> m_Materials;
     
-    std::unordered_map<int, size_t> m_NodeIdToIndex;
-    std::unordered_map<int, size_t> m_ElementIdToIndex;
-    std::unordered_map<int, size_t> m_MaterialIdToIndex;
+    IdIndex m_NodeIndex;
+    IdIndex m_ElementIndex;
+    IdIndex m_MaterialIndex;
+    mutable NodeAdjacency m_Adjacency;
     
     glm::vec3 m_MinBounds;
     glm::vec3 m_MaxBounds;
+    
+    // Pending edit: removal marks by array index, and what to report
+    int m_EditDepth = 0;
+    std::vector<char> m_RemovedNodes;
+    std::vector<char> m_RemovedElements;
+    ModelChange m_PendingChange;
+    ChangeListeners m_Listeners;
+    
+    // The materials as last snapshot or restored, while they still match
+    std::shared_ptr<const std::vector<Material>> m_SharedMaterials;
 };
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "core/ModelHistory.h"
+#include "core/Model.h"
+#include "utils/Logger.h"
+#include <algorithm>
+
+ModelHistory::ModelHistory(size_t maxSteps)
+    : m_MaxSteps(std::max<size_t>(maxSteps, 1)) {
+}
+
+void ModelHistory::Reset(Model& model) {
+    Clear();
+    Record(model);
+}
+
+void ModelHistory::Record(Model& model) {
+    if (!m_Steps.empty()) {
+        m_Steps.resize(m_Current + 1);
+    }
+    m_Steps.push_back(model.TakeSnapshot());
+    if (m_Steps.size() > m_MaxSteps + 1) {
+        m_Steps.erase(m_Steps.begin());
+    }
+    m_Current = m_Steps.size() - 1;
+}
+
+bool ModelHistory::Undo(Model& model) {
+    if (!CanUndo()) {
+        return false;
+    }
+    model.Restore(m_Steps[--m_Current]);
+    LOG_DEBUG("Undo: step {} of {}", m_Current, m_Steps.size() - 1);
+    return true;
+}
+
+bool ModelHistory::Redo(Model& model) {
+    if (!CanRedo()) {
+        return false;
+    }
+    model.Restore(m_Steps[++m_Current]);
+    LOG_DEBUG("Redo: step {} of {}", m_Current, m_Steps.size() - 1);
+    return true;
+}
+
+void ModelHistory::Clear() {
+    m_Steps.clear();
+    m_Current = 0;
+}
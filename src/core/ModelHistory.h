@@ -0,0 +1,36 @@
+#pragma once
+#include "ModelSnapshot.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class Model;
+
+// Undo and redo over model snapshots. Reset on a new model, record after
+// each committed edit; consecutive snapshots share their unchanged chunks,
+// so a long history costs little more than the edits themselves.
+class ModelHistory {
+public:
+    explicit ModelHistory(size_t maxSteps = 100);
+    
+    // Starts over with the model as it is now
+    void Reset(Model& model);
+    
+    // Snapshots the model as the newest step, dropping any redo steps and
+    // the oldest step once there are more than maxSteps
+    void Record(Model& model);
+    
+    // Return false when there is nothing to undo or redo
+    bool Undo(Model& model);
+    bool Redo(Model& model);
+    
+    bool CanUndo() const { return m_Current > 0; }
+    bool CanRedo() const { return m_Current + 1 < m_Steps.size(); }
+    size_t GetStepCount() const { return m_Steps.size(); }
+    void Clear();
+    
+private:
+    std::vector<std::shared_ptr<const ModelSnapshot>> m_Steps;
+    size_t m_Current = 0;
+    size_t m_MaxSteps;
+};
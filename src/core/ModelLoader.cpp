@@ -0,0 +1,238 @@
+#include "core/ModelLoader.h"
+#include "core/SolidSkin.h"
+#include "io/FileManager.h"
+#include "io/ModelCache.h"
+#include "utils/Logger.h"
+#include "utils/Profiler.h"
+
+ModelLoader::ModelLoader()
+    : m_Status(LoadStatus::IDLE), m_Center(0.0f), m_Radius(0.0f), m_HasBounds(false) {
+}
+
+ModelLoader::~ModelLoader() {
+    Cancel();
+    Join();
+}
+
+void ModelLoader::Start(const std::string& filepath) {
+    Cancel();
+    Join();
+    
+    m_FilePath = filepath;
+    m_Progress.bytesTotal = 0;
+    m_Progress.bytesParsed = 0;
+    m_Progress.nodesParsed = 0;
+    m_Progress.elementsParsed = 0;
+    m_Progress.cancelRequested = false;
+    
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingData.Clear();
+        m_Model.Clear();
+        m_Error.clear();
+        m_HasBounds = false;
+    }
+    
+    m_Status = LoadStatus::LOADING;
+    m_Thread = std::thread(&ModelLoader::Run, this);
+}
+
+void ModelLoader::Cancel() {
+    if (IsLoading()) {
+        m_Progress.cancelRequested = true;
+    }
+}
+
+void ModelLoader::Join() {
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+}
+
+std::string ModelLoader::GetError() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Error;
+}
+
+float ModelLoader::GetProgress() const {
+    size_t total = GetBytesTotal();
+    if (total == 0) return 0.0f;
+    return static_cast<float>(GetBytesParsed()) / static_cast<float>(total);
+}
+
+bool ModelLoader::TakeMeshData(MeshData& data) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_PendingData.Empty()) return false;
+    
+    data.Clear();
+    data.Append(std::move(m_PendingData));
+    return true;
+}
+
+bool ModelLoader::TakeBounds(glm::vec3& center, float& radius) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_HasBounds) return false;
+    
+    center = m_Center;
+    radius = m_Radius;
+    m_HasBounds = false;
+    return true;
+}
+
+bool ModelLoader::TakeModel(Model& model) {
+    if (GetStatus() != LoadStatus::FINISHED) return false;
+    
+    Join();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    model = std::move(m_Model);
+    m_Model = Model();
+    m_Status = LoadStatus::IDLE;
+    return true;
+}
+
+void ModelLoader::Publish(MeshData&& data) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_PendingData.Append(std::move(data));
+}
+
+void ModelLoader::Run() {
+    PROFILE_SCOPE("ModelLoader::Run");
+    std::vector<DeckFile> files;
+    std::string error;
+    if (!DeckAssembler::FindIncludeTree(m_FilePath, files, error)) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Error = error;
+        }
+        m_Status = LoadStatus::FAILED;
+        return;
+    }
+    if (files.size() > 1) {
+        RunAssembled(files);
+        return;
+    }
+    
+    if (RunFromCache()) {
+        return;
+    }
+    
+    OpenRadiossGUI::RadFileReader reader;
+    reader.setProgress(&m_Progress);
+    
+    // Only this thread touches the model until the status says FINISHED
+    Model model;
+    unsigned int vertexCount = 0;
+    
+    reader.setNodesReadyCallback([&](const std::vector<OpenRadiossGUI::Node>& nodes) {
+        FileManager::AddNodes(nodes, model);
+        model.CalculateBounds();
+        
+        MeshData data;
+        Mesh::AppendNodes(model, data);
+        Publish(std::move(data));
+        
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Center = model.GetCenter();
+        m_Radius = model.GetBoundingRadius();
+        m_HasBounds = true;
+    });
+    
+    reader.setElementsReadyCallback([&](const std::vector<OpenRadiossGUI::Element>& elements,
+                                        size_t first, size_t count) {
+        size_t firstElement = model.GetElementCount();
+        FileManager::AddElements(elements, first, count, model);
+        
+        MeshData data;
+        Mesh::AppendElements(model, firstElement, count, vertexCount, data);
+        vertexCount += static_cast<unsigned int>(data.vertices.size());
+        Publish(std::move(data));
+    });
+    
+    bool loaded = reader.loadFile(m_FilePath);
+    
+    if (loaded) {
+        FileManager::AddMaterials(reader, model);
+        model.BuildLookups();
+        
+        // Solid faces are only known to be exterior once every element is in
+        SolidSkin skin;
+        skin.Build(model);
+        MeshData data;
+        Mesh::AppendSkin(model, skin, data);
+        Publish(std::move(data));
+        
+        {
+            PROFILE_SCOPE("ModelCache::Save");
+            ModelCache::Save(m_FilePath, model);
+        }
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Model = std::move(model);
+        m_Status = LoadStatus::FINISHED;
+    } else if (m_Progress.cancelRequested) {
+        m_Status = LoadStatus::CANCELLED;
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Error = reader.getLastError();
+        }
+        m_Status = LoadStatus::FAILED;
+    }
+}
+
+bool ModelLoader::RunFromCache() {
+    Model model;
+    {
+        PROFILE_SCOPE("ModelCache::Load");
+        if (!ModelCache::Load(m_FilePath, model)) {
+            return false;
+        }
+    }
+    
+    Finish(std::move(model));
+    return true;
+}
+
+void ModelLoader::RunAssembled(const std::vector<DeckFile>& files) {
+    DeckAssembler assembler;
+    assembler.SetProgress(&m_Progress);
+    
+    Model model;
+    bool loaded = false;
+    {
+        PROFILE_SCOPE("DeckAssembler::Load");
+        loaded = assembler.Load(files, model);
+    }
+    if (loaded) {
+        Finish(std::move(model));
+    } else if (m_Progress.cancelRequested) {
+        m_Status = LoadStatus::CANCELLED;
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Error = assembler.GetError();
+        }
+        m_Status = LoadStatus::FAILED;
+    }
+}
+
+void ModelLoader::Finish(Model&& model) {
+    PROFILE_SCOPE("ModelLoader::Finish");
+    // Everything is available at once; the render thread still uploads in slices
+    MeshData data;
+    Mesh::AppendNodes(model, data);
+    Mesh::AppendElements(model, 0, model.GetElementCount(), 0, data);
+    SolidSkin skin;
+    skin.Build(model);
+    Mesh::AppendSkin(model, skin, data);
+    Publish(std::move(data));
+    
+    m_Progress.nodesParsed = model.GetNodeCount();
+    m_Progress.elementsParsed = model.GetElementCount();
+    
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Center = model.GetCenter();
+    m_Radius = model.GetBoundingRadius();
+    m_HasBounds = true;
+    m_Model = std::move(model);
+    m_Status = LoadStatus::FINISHED;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "core/Model.h"
+#include "io/DeckAssembler.h"
+#include "io/RadFileReader.h"
+#include "rendering/Mesh.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class LoadStatus {
+    IDLE,
+    LOADING,
+    FINISHED,
+    FAILED,
+    CANCELLED
+};
+
+// Loads a RAD deck on a worker thread into a model of its own. Geometry is
+// published as it is parsed (nodes first, then element batches) so the render
+// thread can display the deck before loading completes. Decks with includes
+// are assembled file by file and published once merged.
+class ModelLoader {
+public:
+    ModelLoader();
+    ~ModelLoader();
+    
+    ModelLoader(const ModelLoader&) = delete;
+    ModelLoader& operator=(const ModelLoader&) = delete;
+    
+    // Starts loading, cancelling any load still in progress
+    void Start(const std::string& filepath);
+    void Cancel();
+    
+    LoadStatus GetStatus() const { return m_Status.load(); }
+    bool IsLoading() const { return GetStatus() == LoadStatus::LOADING; }
+    const std::string& GetFilePath() const { return m_FilePath; }
+    std::string GetError() const;
+    
+    // Progress, readable from any thread
+    size_t GetBytesTotal() const { return m_Progress.bytesTotal.load(); }
+    size_t GetBytesParsed() const { return m_Progress.bytesParsed.load(); }
+    size_t GetNodesParsed() const { return m_Progress.nodesParsed.load(); }
+    size_t GetElementsParsed() const { return m_Progress.elementsParsed.load(); }
+    float GetProgress() const;
+    
+    // Render thread side. TakeMeshData hands over the geometry published since
+    // the last call; TakeBounds reports the node bounds once, when known.
+    bool TakeMeshData(MeshData& data);
+    bool TakeBounds(glm::vec3& center, float& radius);
+    
+    // Moves the loaded model out once the status is FINISHED
+    bool TakeModel(Model& model);
+    
+private:
+    void Run();
+    bool RunFromCache();
+    void RunAssembled(const std::vector<DeckFile>& files);
+    void Finish(Model&& model);
+    void Publish(MeshData&& data);
+    void Join();
+    
+private:
+    std::thread m_Thread;
+    std::atomic<LoadStatus> m_Status;
+    OpenRadiossGUI::LoadProgress m_Progress;
+    std::string m_FilePath;
+    
+    // Guarded by m_Mutex
+    mutable std::mutex m_Mutex;
+    MeshData m_PendingData;
+    Model m_Model;
+    std::string m_Error;
+    glm::vec3 m_Center;
+    float m_Radius;
+    bool m_HasBounds;
+};
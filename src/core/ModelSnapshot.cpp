@@ -0,0 +1,5 @@
+#include "core/ModelSnapshot.h"
+
+size_t ModelSnapshot::GetConnectivityOffset(size_t elementIndex) const {
+    return m_Elements.NodeIdOffset(elementIndex);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Node.h"
+#include "Element.h"
+#include "Material.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+// The definition of a model at one point in time: nodes, elements and
+// materials, but not kinematic results. Created by Model::TakeSnapshot,
+// which copies the model's chunk tables and not its values: the model
+// clones a chunk before writing to one a snapshot holds, so a snapshot per
+// edit costs what the edit touched. Snapshots never change, so background
+// threads (exporters, solver staging) can read one while the model is
+// edited.
+class ModelSnapshot {
+public:
+    size_t GetNodeCount() const { return m_Nodes.Size(); }
+    size_t GetElementCount() const { return m_Elements.Size(); }
+
+    const ChunkedColumn<int>& GetNodeIds() const { return m_Nodes.ids; }
+    const ChunkedColumn<glm::vec3>& GetNodePositions() const { return m_Nodes.positions; }
+    const ChunkedColumn<uint8_t>& GetNodeFixity() const { return m_Nodes.fixity; }
+
+    const ChunkedColumn<int>& GetElementIds() const { return m_Elements.ids; }
+    const ChunkedColumn<int>& GetElementMaterialIds() const { return m_Elements.materialIds; }
+    const ChunkedColumn<int>& GetElementPropertyIds() const { return m_Elements.propertyIds; }
+    const ChunkedColumn<float>& GetElementThickness() const { return m_Elements.thickness; }
+    const ChunkedColumn<int>& GetConnectivity() const { return m_Elements.nodeIds; }
+    const std::vector<ElementBlock>& GetElementBlocks() const { return m_Elements.blocks; }
+
+    const std::vector<Material>& GetMaterials() const { return *m_Materials; }
+
+    // Bytes this snapshot holds of its own: chunk tables, the block table
+    // and any materials it did not share
+    size_t GetCopiedBytes() const { return m_CopiedBytes; }
+
+    // Offset of an element's connectivity; index may equal the element count
+    size_t GetConnectivityOffset(size_t elementIndex) const;
+
+private:
+    friend class Model;
+
+    // Definition columns only: no kinematics and no node indices
+    NodeArrays m_Nodes;
+    ElementArrays m_Elements;
+
+    std::shared_ptr<const std::vector<Material>> m_Materials;
+    size_t m_CopiedBytes = 0;
+};
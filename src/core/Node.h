@@ -1,6 +1,19 @@
 #pragma once
+#include "ChunkedColumn.h"
+#include <cstdint>
+#include <vector>
 #include <glm/glm.hpp>
 
+// Boundary condition bits stored per node
+enum NodeFixity : uint8_t {
+    FIXED_NONE = 0,
+    FIXED_X = 1 << 0,
+    FIXED_Y = 1 << 1,
+    FIXED_Z = 1 << 2
+};
+
+// A single node as passed in and out of Model. Model itself keeps node data
+// in NodeArrays, so this record is only built where a whole node is needed.
 struct Node {
     int id;
     glm::vec3 position;
@@ -19,4 +32,39 @@ struct Node {
     Node(int nodeId, const glm::vec3& pos) 
         : id(nodeId), position(pos), displacement(0.0f),
           velocity(0.0f), acceleration(0.0f) {}
-};
\ No newline at end of file
+    
+    uint8_t GetFixity() const {
+        return static_cast<uint8_t>((fixedX ? FIXED_X : 0) | (fixedY ? FIXED_Y : 0) |
+                                    (fixedZ ? FIXED_Z : 0));
+    }
+};
+
+// Column storage for a model's nodes: one array per field, all indexed
+// alike. The definition columns are chunked, with their chunks in step, so
+// snapshots share them (see ChunkedColumn). The kinematic arrays are plain
+// results, empty until results are attached, so a model fresh from a deck
+// carries only ids, positions and fixity.
+struct NodeArrays {
+    ChunkedColumn<int> ids;
+    ChunkedColumn<glm::vec3> positions;
+    ChunkedColumn<uint8_t> fixity;      // NodeFixity bits
+    
+    std::vector<glm::vec3> displacements;
+    std::vector<glm::vec3> velocities;
+    std::vector<glm::vec3> accelerations;
+    
+    size_t Size() const { return ids.size(); }
+    bool HasKinematics() const { return displacements.size() == ids.size() && !ids.empty(); }
+    
+    void PushBack(int id, const glm::vec3& position, uint8_t fixityBits) {
+        ids.push_back(id);
+        positions.push_back(position);
+        fixity.push_back(fixityBits);
+    }
+    
+    // True when chunk k of every definition column is also other's chunk j
+    bool SharesChunk(size_t k, const NodeArrays& other, size_t j) const {
+        return ids.SharesChunk(k, other.ids, j) && positions.SharesChunk(k, other.positions, j) &&
+               fixity.SharesChunk(k, other.fixity, j);
+    }
+};
@@ -0,0 +1,317 @@
+#include "core/NodeAdjacency.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+constexpr size_t kGrainSize = 1u << 14;
+
+// Calls fn(elementIndex, nodeIndex) for every reference of elements
+// [first, last), walking the block table once
+template<typename Fn>
+void ForEachReference(const ElementArrays& elements, const std::vector<uint32_t>& nodeIndices,
+                      size_t first, size_t last, Fn&& fn) {
+    if (first >= last) {
+        return;
+    }
+    const std::vector<ElementBlock>& blocks = elements.blocks;
+    for (size_t b = elements.FindBlock(first); b < blocks.size() && blocks[b].firstElement < last; ++b) {
+        const ElementBlock& block = blocks[b];
+        size_t stride = static_cast<size_t>(block.nodesPerElement);
+        size_t end = std::min(last, block.EndElement());
+        for (size_t i = std::max(first, block.firstElement); i < end; ++i) {
+            const uint32_t* refs = nodeIndices.data() + block.firstNodeId +
+                                   (i - block.firstElement) * stride;
+            for (size_t k = 0; k < stride; ++k) {
+                fn(i, refs[k]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void NodeAdjacency::Build(const ElementArrays& elements, const std::vector<uint32_t>& nodeIndices,
+                          size_t nodeCount) {
+    Clear();
+    m_Built = true;
+    m_Offsets.assign(nodeCount + 1, 0);
+
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const size_t elementCount = elements.Size();
+
+    // Counting sort: count references per node, turn the counts into row
+    // offsets, then scatter through per-row atomic cursors
+    std::vector<std::atomic<size_t>> cursors(nodeCount);
+    std::atomic<size_t> unresolved{0};
+    pool.ParallelFor(elementCount, kGrainSize, [&](size_t first, size_t last) {
+        size_t missing = 0;
+        ForEachReference(elements, nodeIndices, first, last, [&](size_t, uint32_t node) {
+            if (node < nodeCount) {
+                cursors[node].fetch_add(1, std::memory_order_relaxed);
+            } else {
+                ++missing;
+            }
+        });
+        unresolved += missing;
+    });
+
+    for (size_t n = 0; n < nodeCount; ++n) {
+        size_t count = cursors[n].load(std::memory_order_relaxed);
+        cursors[n].store(m_Offsets[n], std::memory_order_relaxed);
+        m_Offsets[n + 1] = m_Offsets[n] + count;
+    }
+
+    m_Entries.resize(m_Offsets[nodeCount]);
+    pool.ParallelFor(elementCount, kGrainSize, [&](size_t first, size_t last) {
+        ForEachReference(elements, nodeIndices, first, last, [&](size_t element, uint32_t node) {
+            if (node < nodeCount) {
+                size_t slot = cursors[node].fetch_add(1, std::memory_order_relaxed);
+                m_Entries[slot] = static_cast<uint32_t>(element);
+            }
+        });
+    });
+
+    // Scatter order depends on timing; sorting the short rows removes that
+    std::atomic<bool> duplicates{false};
+    pool.ParallelFor(nodeCount, kGrainSize, [&](size_t first, size_t last) {
+        bool found = false;
+        for (size_t n = first; n < last; ++n) {
+            auto begin = m_Entries.begin() + m_Offsets[n];
+            auto end = m_Entries.begin() + m_Offsets[n + 1];
+            std::sort(begin, end);
+            found = found || std::adjacent_find(begin, end) != end;
+        }
+        if (found) {
+            duplicates = true;
+        }
+    });
+    if (duplicates) {
+        RemoveDuplicates();
+    }
+
+    m_Unresolved = unresolved.load();
+    LOG_DEBUG("Node adjacency: {} nodes, {} entries ({} KB)", nodeCount, m_Entries.size(),
+              GetMemoryBytes() / 1024);
+}
+
+void NodeAdjacency::Clear() {
+    m_Built = false;
+    m_Offsets = std::vector<size_t>();
+    m_Entries = std::vector<uint32_t>();
+    m_Pending = std::vector<std::pair<uint32_t, uint32_t>>();
+    m_Unresolved = 0;
+}
+
+void NodeAdjacency::AddNodes(size_t count) {
+    if (m_Built) {
+        m_Offsets.insert(m_Offsets.end(), count, m_Offsets.back());
+    }
+}
+
+void NodeAdjacency::AddElement(uint32_t elementIndex, const uint32_t* nodeIndices, size_t count) {
+    if (!m_Built) {
+        return;
+    }
+    size_t nodeCount = GetNodeCount();
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t node = nodeIndices[k];
+        if (node >= nodeCount) {
+            ++m_Unresolved;
+        } else if (std::find(nodeIndices, nodeIndices + k, node) == nodeIndices + k) {
+            m_Pending.emplace_back(node, elementIndex);
+        }
+    }
+}
+
+void NodeAdjacency::Flush() {
+    if (m_Pending.empty()) {
+        return;
+    }
+
+    // Drop references the rows already hold, so each row grows by exactly
+    // its share of the log
+    std::sort(m_Pending.begin(), m_Pending.end());
+    m_Pending.erase(std::unique(m_Pending.begin(), m_Pending.end()), m_Pending.end());
+    m_Pending.erase(std::remove_if(m_Pending.begin(), m_Pending.end(), [this](const auto& entry) {
+        auto begin = m_Entries.begin() + m_Offsets[entry.first];
+        auto end = m_Entries.begin() + m_Offsets[entry.first + 1];
+        return std::binary_search(begin, end, entry.second);
+    }), m_Pending.end());
+
+    // Rows shift back from the last one, each merged with its log entries
+    // from the back, which never overtakes the entries still to be read;
+    // rows in front of the lowest touched node stay where they are. Logged
+    // elements usually have the highest indices and just go at the end.
+    m_Entries.resize(m_Entries.size() + m_Pending.size());
+    size_t write = m_Entries.size();
+    size_t p = m_Pending.size();
+    for (size_t n = GetNodeCount(); n-- > 0 && p > 0;) {
+        size_t begin = m_Offsets[n];
+        size_t read = m_Offsets[n + 1];
+        m_Offsets[n + 1] = write;
+        while (p > 0 && m_Pending[p - 1].first == n) {
+            uint32_t element = m_Pending[p - 1].second;
+            if (read > begin && m_Entries[read - 1] > element) {
+                m_Entries[--write] = m_Entries[--read];
+            } else {
+                m_Entries[--write] = element;
+                --p;
+            }
+        }
+        if (write != read) {
+            std::move_backward(m_Entries.begin() + begin, m_Entries.begin() + read,
+                               m_Entries.begin() + write);
+        }
+        write -= read - begin;
+    }
+    m_Pending.clear();
+}
+
+void NodeAdjacency::RemoveNodes(const std::vector<char>& removed) {
+    if (!m_Built) {
+        return;
+    }
+    Flush();
+
+    // Rows only ever move towards the front, so this works in place
+    size_t nodeCount = GetNodeCount();
+    size_t keptNodes = 0;
+    size_t write = 0;
+    for (size_t n = 0; n < nodeCount; ++n) {
+        size_t begin = m_Offsets[n];
+        size_t end = m_Offsets[n + 1];
+        if (n < removed.size() && removed[n]) {
+            // The elements of a removed node now reference a missing one
+            m_Unresolved += end - begin;
+            continue;
+        }
+        m_Offsets[keptNodes++] = write;
+        std::move(m_Entries.begin() + begin, m_Entries.begin() + end, m_Entries.begin() + write);
+        write += end - begin;
+    }
+    m_Offsets[keptNodes] = write;
+    m_Offsets.resize(keptNodes + 1);
+    m_Entries.resize(write);
+}
+
+void NodeAdjacency::RemoveElements(const std::vector<char>& removed) {
+    if (!m_Built) {
+        return;
+    }
+    Flush();
+
+    // Removal keeps the order of the rest, so rows stay sorted after
+    // renumbering; elements past the end of removed are kept
+    std::vector<uint32_t> renumber(removed.size());
+    uint32_t kept = 0;
+    for (size_t i = 0; i < removed.size(); ++i) {
+        renumber[i] = removed[i] ? kMissing : kept++;
+    }
+    const uint32_t shift = static_cast<uint32_t>(removed.size()) - kept;
+
+    size_t nodeCount = GetNodeCount();
+    size_t write = 0;
+    for (size_t n = 0; n < nodeCount; ++n) {
+        size_t begin = m_Offsets[n];
+        size_t end = m_Offsets[n + 1];
+        m_Offsets[n] = write;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t element = m_Entries[i];
+            uint32_t mapped = element < renumber.size() ? renumber[element] : element - shift;
+            if (mapped != kMissing) {
+                m_Entries[write++] = mapped;
+            }
+        }
+    }
+    m_Offsets[nodeCount] = write;
+    m_Entries.resize(write);
+}
+
+void NodeAdjacency::RemapNodes(const std::vector<uint32_t>& oldToNew, size_t newCount) {
+    if (!m_Built) {
+        return;
+    }
+    Flush();
+
+    // Kept rows keep their order, so their entries stay one block: dropped
+    // rows close up in a forward pass, then inserted rows open up in a
+    // backward one
+    size_t nodeCount = GetNodeCount();
+    std::vector<uint32_t> target;
+    target.reserve(nodeCount);
+    size_t write = 0;
+    for (size_t n = 0; n < nodeCount; ++n) {
+        size_t begin = m_Offsets[n];
+        size_t end = m_Offsets[n + 1];
+        if (n < oldToNew.size() && oldToNew[n] == kMissing) {
+            continue;
+        }
+        m_Offsets[target.size()] = write;
+        target.push_back(n < oldToNew.size() ? oldToNew[n] : static_cast<uint32_t>(n));
+        std::move(m_Entries.begin() + begin, m_Entries.begin() + end, m_Entries.begin() + write);
+        write += end - begin;
+    }
+    m_Offsets[target.size()] = write;
+    m_Entries.resize(write);
+
+    std::vector<size_t> offsets(newCount + 1, write);
+    size_t row = newCount;
+    for (size_t k = target.size(); k-- > 0;) {
+        while (row > target[k] + 1) {
+            offsets[--row] = m_Offsets[k + 1];
+        }
+        offsets[--row] = m_Offsets[k];
+    }
+    while (row > 0) {
+        offsets[--row] = 0;
+    }
+    m_Offsets = std::move(offsets);
+}
+
+void NodeAdjacency::RenumberElements(const std::vector<uint32_t>& oldToNew) {
+    if (!m_Built) {
+        return;
+    }
+    Flush();
+
+    size_t nodeCount = GetNodeCount();
+    size_t write = 0;
+    for (size_t n = 0; n < nodeCount; ++n) {
+        size_t begin = m_Offsets[n];
+        size_t end = m_Offsets[n + 1];
+        m_Offsets[n] = write;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t mapped = m_Entries[i] < oldToNew.size() ? oldToNew[m_Entries[i]] : kMissing;
+            if (mapped != kMissing) {
+                m_Entries[write++] = mapped;
+            }
+        }
+    }
+    m_Offsets[nodeCount] = write;
+    m_Entries.resize(write);
+}
+
+size_t NodeAdjacency::GetMemoryBytes() const {
+    return m_Offsets.capacity() * sizeof(size_t) + m_Entries.capacity() * sizeof(uint32_t) +
+           m_Pending.capacity() * sizeof(std::pair<uint32_t, uint32_t>);
+}
+
+void NodeAdjacency::RemoveDuplicates() {
+    size_t nodeCount = GetNodeCount();
+    size_t write = 0;
+    for (size_t n = 0; n < nodeCount; ++n) {
+        size_t begin = m_Offsets[n];
+        size_t end = m_Offsets[n + 1];
+        m_Offsets[n] = write;
+        for (size_t i = begin; i < end; ++i) {
+            if (i == begin || m_Entries[i] != m_Entries[i - 1]) {
+                m_Entries[write++] = m_Entries[i];
+            }
+        }
+    }
+    m_Offsets[nodeCount] = write;
+    m_Entries.resize(write);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Element.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Read-only run of element indices, shaped like NodeIdSpan
+struct ElementIndexSpan {
+    const uint32_t* indices = nullptr;
+    size_t count = 0;
+
+    const uint32_t* begin() const { return indices; }
+    const uint32_t* end() const { return indices + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    uint32_t operator[](size_t i) const { return indices[i]; }
+};
+
+// Inverse connectivity: which elements use each node, by array index. The
+// elements of node n are entries [offsets[n], offsets[n + 1]) (CSR), in
+// ascending order and each listed once even where an element repeats a
+// node, as collapsed quads do. References to undefined nodes are left out.
+//
+// Model keeps one of these up to date as it changes: added references go
+// to a short log that is merged in on the next query, and compactions and
+// renumberings filter the arrays in one pass, so edits never repeat the
+// full build.
+class NodeAdjacency {
+public:
+    // Counting sort over the connectivity, in parallel. nodeIndices is the
+    // connectivity renumbered to node indices (ElementArrays::nodeIndices).
+    void Build(const ElementArrays& elements, const std::vector<uint32_t>& nodeIndices,
+               size_t nodeCount);
+    void Clear();
+    bool IsBuilt() const { return m_Built; }
+
+    // Incremental updates, mirroring the model's arrays. AddElement may
+    // name any element index, not only the next one.
+    void AddNodes(size_t count);
+    void AddElement(uint32_t elementIndex, const uint32_t* nodeIndices, size_t count);
+    void RemoveNodes(const std::vector<char>& removed);
+    void RemoveElements(const std::vector<char>& removed);
+
+    // Moves row n to oldToNew[n] among newCount rows; kMissing drops it.
+    // Kept rows must keep their order, as they do when arrays are patched.
+    static constexpr uint32_t kMissing = UINT32_MAX;
+    void RemapNodes(const std::vector<uint32_t>& oldToNew, size_t newCount);
+
+    // Renumbers element e to oldToNew[e], or drops it at kMissing; the
+    // mapping must keep the order of the elements it keeps
+    void RenumberElements(const std::vector<uint32_t>& oldToNew);
+
+    // Merges logged additions into their rows; queries need an empty log
+    void Flush();
+    bool HasPending() const { return !m_Pending.empty(); }
+
+    ElementIndexSpan GetElements(size_t nodeIndex) const {
+        return {m_Entries.data() + m_Offsets[nodeIndex], m_Offsets[nodeIndex + 1] - m_Offsets[nodeIndex]};
+    }
+    size_t GetNodeCount() const { return m_Offsets.empty() ? 0 : m_Offsets.size() - 1; }
+    const std::vector<size_t>& GetOffsets() const { return m_Offsets; }
+    const std::vector<uint32_t>& GetEntries() const { return m_Entries; }
+
+    // References that named no node; a node added later could resolve them
+    size_t GetUnresolvedCount() const { return m_Unresolved; }
+    void SetUnresolvedCount(size_t count) { m_Unresolved = count; }
+    size_t GetMemoryBytes() const;
+
+private:
+    void RemoveDuplicates();
+
+private:
+    bool m_Built = false;
+    std::vector<size_t> m_Offsets;     // Node count + 1 entries
+    std::vector<uint32_t> m_Entries;   // Element indices, row by row
+    std::vector<std::pair<uint32_t, uint32_t>> m_Pending;  // (node, element) appended
+    size_t m_Unresolved = 0;
+};
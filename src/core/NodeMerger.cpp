@@ -0,0 +1,61 @@
+#include "core/NodeMerger.h"
+#include "core/Model.h"
+#include "core/SpatialGrid.h"
+#include "utils/Logger.h"
+#include <chrono>
+
+namespace {
+
+uint32_t FindRoot(std::vector<uint32_t>& parents, uint32_t node) {
+    while (parents[node] != node) {
+        parents[node] = parents[parents[node]];   // Path halving
+        node = parents[node];
+    }
+    return node;
+}
+
+} // namespace
+
+std::vector<uint32_t> NodeMerger::FindTargets(const Model& model, float tolerance, size_t* pairs) {
+    const ChunkedColumn<glm::vec3>& positions = model.GetNodePositions();
+    std::vector<uint32_t> targets(positions.size());
+    for (size_t n = 0; n < targets.size(); ++n) {
+        targets[n] = static_cast<uint32_t>(n);
+    }
+    
+    SpatialGrid grid;
+    grid.Build(positions);
+    std::vector<std::pair<uint32_t, uint32_t>> found = grid.FindPairs(tolerance);
+    if (pairs) {
+        *pairs = found.size();
+    }
+    
+    // Union by lower index, so each root is its group's first node
+    for (const auto& pair : found) {
+        uint32_t a = FindRoot(targets, pair.first);
+        uint32_t b = FindRoot(targets, pair.second);
+        if (a != b) {
+            targets[std::max(a, b)] = std::min(a, b);
+        }
+    }
+    for (size_t n = 0; n < targets.size(); ++n) {
+        targets[n] = FindRoot(targets, static_cast<uint32_t>(n));
+    }
+    return targets;
+}
+
+NodeMergeResult NodeMerger::Merge(Model& model, float tolerance) {
+    auto start = std::chrono::steady_clock::now();
+    NodeMergeResult result;
+    std::vector<uint32_t> targets = FindTargets(model, tolerance, &result.pairs);
+    for (size_t n = 0; n < targets.size(); ++n) {
+        result.removedNodes += targets[n] != n ? 1 : 0;
+    }
+    if (result.removedNodes > 0) {
+        result.references = model.MergeNodes(targets);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Merged {} nodes within {} ({} references) in {:.2f} s", result.removedNodes, tolerance,
+             result.references, result.seconds);
+    return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+struct NodeMergeResult {
+    size_t pairs = 0;          // Node pairs within the tolerance
+    size_t removedNodes = 0;
+    size_t references = 0;     // Element references rewritten
+    double seconds = 0.0;
+};
+
+// Equivalencing of coincident nodes. Pairs within the tolerance come from
+// a spatial grid over the node positions and are chained into groups, so
+// nodes a little more than the tolerance apart still merge through one
+// between them. Each group keeps its first node.
+class NodeMerger {
+public:
+    // Node index each node merges into; itself where it is kept
+    static std::vector<uint32_t> FindTargets(const Model& model, float tolerance, size_t* pairs = nullptr);
+    
+    // Finds the groups and rewrites the model's connectivity to them as
+    // one edit
+    static NodeMergeResult Merge(Model& model, float tolerance);
+};
@@ -0,0 +1,195 @@
+#include "core/ParameterTable.h"
+#include <algorithm>
+#include <bitset>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+// Deck spelling of each built-in key, in Param order
+const char* const kBuiltinNames[] = {
+    "RHO", "E", "NU", "SIGMA_Y", "E_TAN",
+    "A", "B", "N", "C", "M",
+    "D1", "D2", "D3", "D4", "D5",
+    "E1", "E2", "G12", "NU12",
+    "MU", "ALPHA",
+    "THICK", "N_INT",
+    "AREA", "IYY", "IZZ"
+};
+static_assert(sizeof(kBuiltinNames) / sizeof(kBuiltinNames[0]) == static_cast<size_t>(Param::COUNT),
+              "every built-in parameter needs a name");
+
+// Other spellings found in decks and older files
+const std::pair<const char*, Param> kAliases[] = {
+    {"rho", Param::RHO}, {"density", Param::RHO},
+    {"young", Param::E}, {"youngModulus", Param::E},
+    {"nu", Param::NU}, {"poisson", Param::NU},
+    {"Thick", Param::THICK}, {"thickness", Param::THICK}
+};
+
+// Names live in a deque so views of them stay valid while it grows
+class SymbolTable {
+public:
+    SymbolTable() {
+        for (const char* name : kBuiltinNames) {
+            Add(name);
+        }
+        for (const auto& alias : kAliases) {
+            m_Keys.emplace(alias.first, ToKey(alias.second));
+        }
+    }
+
+    ParameterKey Find(std::string_view name) const {
+        auto it = m_Keys.find(name);
+        return it != m_Keys.end() ? it->second : ParameterSymbols::kNoKey;
+    }
+
+    ParameterKey Add(std::string_view name) {
+        ParameterKey key = static_cast<ParameterKey>(m_Names.size());
+        m_Names.emplace_back(name);
+        m_Keys.emplace(m_Names.back(), key);
+        return key;
+    }
+
+    mutable std::shared_mutex m_Mutex;
+    std::deque<std::string> m_Names;
+    std::unordered_map<std::string_view, ParameterKey> m_Keys;
+};
+
+SymbolTable& Symbols() {
+    static SymbolTable table;
+    return table;
+}
+
+struct SchemaAlias {
+    const char* keyword;
+    const char* type;
+};
+
+// Radioss keyword names of the laws that have a schema
+const SchemaAlias kSchemaAliases[] = {
+    {"ELAST", "LAW1"}, {"PLAS_JOHNS", "LAW2"}, {"JOHN_COOK", "LAW2"},
+    {"COMPSH", "LAW25"}, {"PLAS_TAB", "LAW36"}, {"OGDEN", "LAW42"}
+};
+
+const std::vector<ParameterSchema>& Schemas() {
+    static const std::vector<ParameterSchema> schemas = {
+        {"LAW1", {Param::RHO, Param::E, Param::NU}},
+        {"LAW2", {Param::RHO, Param::E, Param::NU, Param::JC_A, Param::JC_B, Param::JC_N,
+                  Param::JC_C, Param::JC_M, Param::JC_D1, Param::JC_D2, Param::JC_D3,
+                  Param::JC_D4, Param::JC_D5}},
+        {"LAW25", {Param::RHO, Param::E1, Param::E2, Param::NU12, Param::G12}},
+        {"LAW36", {Param::RHO, Param::E, Param::NU, Param::SIGMA_Y, Param::E_TAN}},
+        {"LAW42", {Param::RHO, Param::NU, Param::MU, Param::ALPHA}},
+        {"SHELL", {Param::THICK, Param::N_INT}},
+        {"BEAM", {Param::AREA, Param::IYY, Param::IZZ}}
+    };
+    return schemas;
+}
+
+} // namespace
+
+ParameterKey ParameterSymbols::Intern(std::string_view name) {
+    SymbolTable& table = Symbols();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.m_Mutex);
+        ParameterKey key = table.Find(name);
+        if (key != kNoKey) {
+            return key;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(table.m_Mutex);
+    ParameterKey key = table.Find(name);
+    return key != kNoKey ? key : table.Add(name);
+}
+
+ParameterKey ParameterSymbols::Find(std::string_view name) {
+    SymbolTable& table = Symbols();
+    std::shared_lock<std::shared_mutex> lock(table.m_Mutex);
+    return table.Find(name);
+}
+
+std::string_view ParameterSymbols::Name(ParameterKey key) {
+    SymbolTable& table = Symbols();
+    std::shared_lock<std::shared_mutex> lock(table.m_Mutex);
+    return key < table.m_Names.size() ? std::string_view(table.m_Names[key]) : std::string_view();
+}
+
+size_t ParameterSymbols::Size() {
+    SymbolTable& table = Symbols();
+    std::shared_lock<std::shared_mutex> lock(table.m_Mutex);
+    return table.m_Names.size();
+}
+
+ParameterSchema::ParameterSchema(std::string type, std::vector<Param> params)
+    : m_Type(std::move(type)) {
+    params.resize(std::min(params.size(), kMaxSlots));
+    for (Param param : params) {
+        ParameterKey key = ToKey(param);
+        if (key >= m_SlotByKey.size()) {
+            m_SlotByKey.resize(key + 1, -1);
+        }
+        m_SlotByKey[key] = static_cast<int8_t>(m_Keys.size());
+        m_Keys.push_back(key);
+    }
+}
+
+const ParameterSchema& ParameterSchema::ForType(std::string_view type) {
+    for (const SchemaAlias& alias : kSchemaAliases) {
+        if (type == alias.keyword) {
+            type = alias.type;
+            break;
+        }
+    }
+    for (const ParameterSchema& schema : Schemas()) {
+        if (schema.GetType() == type) {
+            return schema;
+        }
+    }
+    return Empty();
+}
+
+const ParameterSchema& ParameterSchema::Empty() {
+    static const ParameterSchema schema("", {});
+    return schema;
+}
+
+void ParameterTable::Set(ParameterKey key, double value) {
+    int slot = m_Schema->FindSlot(key);
+    if (slot >= 0) {
+        if (m_Values.empty()) {
+            m_Values.assign(m_Schema->GetSlotCount(), 0.0);
+        }
+        m_Values[slot] = value;
+        m_SetSlots |= uint64_t(1) << slot;
+        return;
+    }
+
+    for (auto& entry : m_Overflow) {
+        if (entry.first == key) {
+            entry.second = value;
+            return;
+        }
+    }
+    m_Overflow.emplace_back(key, value);
+}
+
+const double* ParameterTable::Find(ParameterKey key) const {
+    int slot = m_Schema->FindSlot(key);
+    if (slot >= 0) {
+        return (m_SetSlots & (uint64_t(1) << slot)) ? &m_Values[slot] : nullptr;
+    }
+    for (const auto& entry : m_Overflow) {
+        if (entry.first == key) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+size_t ParameterTable::Size() const {
+    return std::bitset<64>(m_SetSlots).count() + m_Overflow.size();
+}
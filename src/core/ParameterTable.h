@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Interned parameter name. Keys are process-wide, so a name is stored once
+// however many cards use it; they are not stable across runs except for
+// the built-in ones below, which are interned first in this order.
+using ParameterKey = uint32_t;
+
+enum class Param : ParameterKey {
+    RHO,        // Density
+    E,          // Young's modulus
+    NU,         // Poisson's ratio
+    SIGMA_Y,    // Yield stress
+    E_TAN,      // Tangent modulus
+    JC_A,       // Johnson-Cook yield, hardening, exponent, rate, thermal
+    JC_B,
+    JC_N,
+    JC_C,
+    JC_M,
+    JC_D1,      // Johnson-Cook damage
+    JC_D2,
+    JC_D3,
+    JC_D4,
+    JC_D5,
+    E1,         // Orthotropic moduli
+    E2,
+    G12,
+    NU12,
+    MU,         // Hyperelastic shear modulus and exponent
+    ALPHA,
+    THICK,      // Shell thickness
+    N_INT,      // Through-thickness integration points
+    AREA,       // Beam section
+    IYY,
+    IZZ,
+    COUNT
+};
+
+class ParameterSymbols {
+public:
+    static constexpr ParameterKey kNoKey = UINT32_MAX;
+
+    // Key for name, adding it when new. Common spellings such as "density"
+    // for RHO resolve to the built-in key. Safe to call from any thread.
+    static ParameterKey Intern(std::string_view name);
+    static ParameterKey Find(std::string_view name);
+    static std::string_view Name(ParameterKey key);
+    static size_t Size();
+};
+
+inline ParameterKey ToKey(Param param) { return static_cast<ParameterKey>(param); }
+
+// Ordered built-in parameters of one card type (a material law or a
+// property type). A table stores those values in a flat array by slot;
+// other parameters of the card go to a short overflow list.
+class ParameterSchema {
+public:
+    static constexpr size_t kMaxSlots = 64;
+
+    ParameterSchema(std::string type, std::vector<Param> params);
+
+    // Schema for a card type such as "LAW2" or "SHELL"; unknown types get
+    // the empty schema, so all of their values overflow
+    static const ParameterSchema& ForType(std::string_view type);
+    static const ParameterSchema& Empty();
+
+    const std::string& GetType() const { return m_Type; }
+    size_t GetSlotCount() const { return m_Keys.size(); }
+    ParameterKey GetKey(size_t slot) const { return m_Keys[slot]; }
+    int FindSlot(ParameterKey key) const {
+        return key < m_SlotByKey.size() ? m_SlotByKey[key] : -1;
+    }
+
+private:
+    std::string m_Type;
+    std::vector<ParameterKey> m_Keys;
+    std::vector<int8_t> m_SlotByKey;   // Indexed by built-in key
+};
+
+// Parameter values of one card
+class ParameterTable {
+public:
+    ParameterTable() : m_Schema(&ParameterSchema::Empty()) {}
+    explicit ParameterTable(const ParameterSchema& schema) : m_Schema(&schema) {}
+
+    const ParameterSchema& GetSchema() const { return *m_Schema; }
+
+    void Set(ParameterKey key, double value);
+    void Set(Param param, double value) { Set(ToKey(param), value); }
+    void Set(std::string_view name, double value) { Set(ParameterSymbols::Intern(name), value); }
+
+    const double* Find(ParameterKey key) const;
+    const double* Find(Param param) const { return Find(ToKey(param)); }
+    bool Has(Param param) const { return Find(param) != nullptr; }
+    double Get(Param param, double fallback = 0.0) const {
+        const double* value = Find(param);
+        return value ? *value : fallback;
+    }
+
+    size_t Size() const;
+    bool Empty() const { return m_SetSlots == 0 && m_Overflow.empty(); }
+
+    // fn(ParameterKey, double): schema slots in order, then overflow values
+    // in the order they were set
+    template<typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (size_t slot = 0; slot < m_Values.size(); ++slot) {
+            if (m_SetSlots & (uint64_t(1) << slot)) {
+                fn(m_Schema->GetKey(slot), m_Values[slot]);
+            }
+        }
+        for (const auto& entry : m_Overflow) {
+            fn(entry.first, entry.second);
+        }
+    }
+
+private:
+    const ParameterSchema* m_Schema;
+    std::vector<double> m_Values;   // By slot, allocated on first set
+    uint64_t m_SetSlots = 0;        // Bit per slot holding a value
+    std::vector<std::pair<ParameterKey, double>> m_Overflow;
+};
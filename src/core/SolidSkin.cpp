@@ -0,0 +1,345 @@
+#include "core/SolidSkin.h"
+#include "core/Model.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include "utils/Profiler.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+constexpr uint32_t kNoNode = std::numeric_limits<uint32_t>::max();
+constexpr size_t kGrainSize = 1u << 14;
+
+constexpr SolidFaceLayout kTetraFaces = {
+    4, {3, 3, 3, 3},
+    {{0, 2, 1}, {0, 1, 3}, {1, 2, 3}, {0, 3, 2}}
+};
+
+constexpr SolidFaceLayout kHexaFaces = {
+    6, {4, 4, 4, 4, 4, 4},
+    {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}}
+};
+
+size_t PartitionOf(const uint32_t* key) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (int k = 0; k < 4; ++k) {
+        hash = (hash ^ key[k]) * 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+    return static_cast<size_t>(hash % SolidSkin::kPartitionCount);
+}
+
+// Drops repeated corners (collapsed faces), keeping the order
+int RemoveRepeatedCorners(uint32_t* nodes, int count) {
+    int kept = 0;
+    for (int k = 0; k < count; ++k) {
+        if (kept == 0 || nodes[k] != nodes[kept - 1]) {
+            nodes[kept++] = nodes[k];
+        }
+    }
+    if (kept > 1 && nodes[kept - 1] == nodes[0]) {
+        --kept;
+    }
+    return kept;
+}
+
+// Fixed networks for the 3 or 4 corners of a face; std::sort on the key
+// makes GCC warn about bounds it cannot prove
+void SortCorners(uint32_t* key, int count) {
+    auto order = [key](int i, int j) {
+        if (key[j] < key[i]) {
+            std::swap(key[i], key[j]);
+        }
+    };
+    if (count == 4) {
+        order(0, 1);
+        order(2, 3);
+        order(0, 2);
+        order(1, 3);
+        order(1, 2);
+    } else {
+        order(0, 1);
+        order(1, 2);
+        order(0, 1);
+    }
+}
+
+bool ResolveNodes(const Model& model, const ElementView& element, uint32_t* indices) {
+    for (size_t k = 0; k < element.nodeIds.size(); ++k) {
+        if (element.nodeIndices) {
+            indices[k] = element.nodeIndices[k];
+        } else {
+            size_t index = model.FindNodeIndex(element.nodeIds[k]);
+            indices[k] = index != Model::kInvalidIndex ? static_cast<uint32_t>(index) : kNoNode;
+        }
+        if (indices[k] == kNoNode) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const SolidFaceLayout* SolidFaceLayout::ForType(ElementType type) {
+    switch (type) {
+        case ElementType::TETRA4: return &kTetraFaces;
+        case ElementType::HEXA8: return &kHexaFaces;
+        default: return nullptr;
+    }
+}
+
+bool SolidSkin::FaceRef::operator<(const FaceRef& other) const {
+    for (int k = 0; k < 4; ++k) {
+        if (key[k] != other.key[k]) {
+            return key[k] < other.key[k];
+        }
+    }
+    return element != other.element ? element < other.element : face < other.face;
+}
+
+bool SolidSkin::FaceRef::SameKey(const FaceRef& other) const {
+    return std::equal(key, key + 4, other.key);
+}
+
+void SolidSkin::Build(const Model& model) {
+    PROFILE_SCOPE("SolidSkin::Build");
+    Clear();
+    m_Built = true;
+    AppendReferences(model, 0, model.GetElementCount());
+    m_ElementCount = model.GetElementCount();
+    LOG_DEBUG("Solid skin: {} exterior faces ({} KB)", GetFaces().size(), GetMemoryBytes() / 1024);
+}
+
+void SolidSkin::Clear() {
+    m_Built = false;
+    m_ElementCount = 0;
+    for (std::vector<FaceRef>& partition : m_Partitions) {
+        partition = std::vector<FaceRef>();
+    }
+    m_Hidden = std::vector<char>();
+    m_Faces = std::vector<SkinFace>();
+    m_FacesDirty = false;
+}
+
+void SolidSkin::AddElements(const Model& model) {
+    if (!m_Built) {
+        return;
+    }
+    size_t count = model.GetElementCount();
+    if (count > m_ElementCount) {
+        AppendReferences(model, m_ElementCount, count);
+        m_ElementCount = count;
+        if (!m_Hidden.empty()) {
+            m_Hidden.resize(count, 0);
+        }
+    }
+}
+
+void SolidSkin::RemoveElements(const std::vector<char>& removed) {
+    if (!m_Built) {
+        return;
+    }
+    
+    // Same renumbering as the model's compaction, which keeps the order of
+    // the rest, so every partition stays sorted
+    std::vector<uint32_t> renumber(std::min(removed.size(), m_ElementCount));
+    uint32_t kept = 0;
+    for (size_t i = 0; i < renumber.size(); ++i) {
+        renumber[i] = removed[i] ? kNoNode : kept++;
+    }
+    const uint32_t shift = static_cast<uint32_t>(renumber.size()) - kept;
+    
+    ThreadPool::GetGlobal().ParallelFor(kPartitionCount, 1, [&](size_t first, size_t last) {
+        for (size_t p = first; p < last; ++p) {
+            std::vector<FaceRef>& partition = m_Partitions[p];
+            size_t write = 0;
+            for (FaceRef ref : partition) {
+                uint32_t mapped = ref.element < renumber.size() ? renumber[ref.element]
+                                                                : ref.element - shift;
+                if (mapped != kNoNode) {
+                    ref.element = mapped;
+                    partition[write++] = ref;
+                }
+            }
+            partition.resize(write);
+        }
+    });
+    
+    if (!m_Hidden.empty()) {
+        size_t write = 0;
+        for (size_t i = 0; i < m_Hidden.size(); ++i) {
+            if (i >= removed.size() || !removed[i]) {
+                m_Hidden[write++] = m_Hidden[i];
+            }
+        }
+        m_Hidden.resize(write);
+    }
+    m_ElementCount -= shift;
+    m_FacesDirty = true;
+}
+
+void SolidSkin::SetElementsHidden(const std::vector<uint32_t>& elementIndices, bool hidden) {
+    if (elementIndices.empty()) {
+        return;
+    }
+    if (m_Hidden.empty()) {
+        if (!hidden) {
+            return;
+        }
+        m_Hidden.assign(m_ElementCount, 0);
+    }
+    for (uint32_t element : elementIndices) {
+        if (element < m_Hidden.size()) {
+            m_Hidden[element] = hidden ? 1 : 0;
+        }
+    }
+    m_FacesDirty = true;
+}
+
+void SolidSkin::SetPartHidden(const Model& model, int partId, bool hidden) {
+    const ChunkedColumn<int>& partIds = model.GetElementArrays().propertyIds;
+    std::vector<uint32_t> elements;
+    for (size_t i = 0; i < std::min(partIds.size(), m_ElementCount); ++i) {
+        if (partIds[i] == partId) {
+            elements.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    SetElementsHidden(elements, hidden);
+}
+
+const std::vector<SkinFace>& SolidSkin::GetFaces() const {
+    if (!m_FacesDirty) {
+        return m_Faces;
+    }
+    
+    // A run of equal keys is one face; it is exterior when exactly one of
+    // its references is to a visible element
+    std::vector<SkinFace> found[kPartitionCount];
+    ThreadPool::GetGlobal().ParallelFor(kPartitionCount, 1, [&](size_t first, size_t last) {
+        for (size_t p = first; p < last; ++p) {
+            const std::vector<FaceRef>& partition = m_Partitions[p];
+            for (size_t begin = 0; begin < partition.size();) {
+                size_t end = begin + 1;
+                while (end < partition.size() && partition[end].SameKey(partition[begin])) {
+                    ++end;
+                }
+                const FaceRef* visible = nullptr;
+                size_t visibleCount = 0;
+                for (size_t r = begin; r < end; ++r) {
+                    if (!IsHidden(partition[r].element)) {
+                        visible = &partition[r];
+                        ++visibleCount;
+                    }
+                }
+                if (visibleCount == 1) {
+                    found[p].push_back({visible->element, visible->face, visible->corners});
+                }
+                begin = end;
+            }
+        }
+    });
+    
+    size_t total = 0;
+    for (const auto& faces : found) {
+        total += faces.size();
+    }
+    m_Faces.clear();
+    m_Faces.reserve(total);
+    for (const auto& faces : found) {
+        m_Faces.insert(m_Faces.end(), faces.begin(), faces.end());
+    }
+    m_FacesDirty = false;
+    return m_Faces;
+}
+
+int SolidSkin::GetFaceNodes(const Model& model, const SkinFace& face, uint32_t* nodes) {
+    ElementView element = model.GetElement(face.element);
+    const SolidFaceLayout* layout = SolidFaceLayout::ForType(element.type);
+    uint32_t indices[8];
+    if (!layout || element.nodeIds.size() > 8 || !ResolveNodes(model, element, indices)) {
+        return 0;
+    }
+    int size = layout->faceSizes[face.face];
+    for (int k = 0; k < size; ++k) {
+        nodes[k] = indices[layout->faces[face.face][k]];
+    }
+    return RemoveRepeatedCorners(nodes, size);
+}
+
+size_t SolidSkin::GetMemoryBytes() const {
+    size_t bytes = m_Hidden.capacity() + m_Faces.capacity() * sizeof(SkinFace);
+    for (const auto& partition : m_Partitions) {
+        bytes += partition.capacity() * sizeof(FaceRef);
+    }
+    return bytes;
+}
+
+void SolidSkin::AppendReferences(const Model& model, size_t first, size_t last) {
+    if (first >= last) {
+        return;
+    }
+    
+    // Each range hashes its faces into buckets of its own; partitions then
+    // gather their buckets and sort them independently
+    using Buckets = std::vector<std::vector<FaceRef>>;
+    std::vector<Buckets> ranges;
+    std::mutex rangesMutex;
+    
+    ThreadPool::GetGlobal().ParallelFor(last - first, kGrainSize, [&](size_t begin, size_t end) {
+        Buckets buckets(kPartitionCount);
+        uint32_t indices[8];
+        model.ForEachElement(first + begin, first + end, [&](size_t i, const ElementView& element) {
+            const SolidFaceLayout* layout = SolidFaceLayout::ForType(element.type);
+            if (!layout || static_cast<int>(element.nodeIds.size()) != Element::GetNodeCount(element.type) ||
+                !ResolveNodes(model, element, indices)) {
+                return;
+            }
+            for (int f = 0; f < layout->faceCount; ++f) {
+                FaceRef ref;
+                int size = layout->faceSizes[f];
+                for (int k = 0; k < size; ++k) {
+                    ref.key[k] = indices[layout->faces[f][k]];
+                }
+                int corners = RemoveRepeatedCorners(ref.key, size);
+                if (corners < 3) {
+                    continue;   // Collapsed to an edge or a point
+                }
+                
+                SortCorners(ref.key, corners);
+                corners = static_cast<int>(std::unique(ref.key, ref.key + corners) - ref.key);
+                if (corners < 3) {
+                    continue;
+                }
+                std::fill(ref.key + corners, ref.key + 4, kNoNode);
+                ref.element = static_cast<uint32_t>(i);
+                ref.face = static_cast<uint8_t>(f);
+                ref.corners = static_cast<uint8_t>(corners);
+                buckets[PartitionOf(ref.key)].push_back(ref);
+            }
+        });
+        
+        std::lock_guard<std::mutex> lock(rangesMutex);
+        ranges.push_back(std::move(buckets));
+    });
+    
+    ThreadPool::GetGlobal().ParallelFor(kPartitionCount, 1, [&](size_t firstPartition, size_t lastPartition) {
+        for (size_t p = firstPartition; p < lastPartition; ++p) {
+            std::vector<FaceRef>& partition = m_Partitions[p];
+            size_t existing = partition.size();
+            size_t added = 0;
+            for (const Buckets& buckets : ranges) {
+                added += buckets[p].size();
+            }
+            partition.reserve(existing + added);
+            for (const Buckets& buckets : ranges) {
+                partition.insert(partition.end(), buckets[p].begin(), buckets[p].end());
+            }
+            std::sort(partition.begin() + existing, partition.end());
+            std::inplace_merge(partition.begin(), partition.begin() + existing, partition.end());
+        }
+    });
+    m_FacesDirty = true;
+}
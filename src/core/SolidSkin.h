@@ -0,0 +1,92 @@
+#pragma once
+#include "Element.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Outward-facing faces of the solid types, in local node numbers
+struct SolidFaceLayout {
+    int faceCount;
+    int faceSizes[6];
+    int faces[6][4];
+
+    // Layout of TETRA4 and HEXA8, null for types without faces
+    static const SolidFaceLayout* ForType(ElementType type);
+};
+
+// One exterior face: the solid element it belongs to, which of its faces,
+// and how many distinct corners it has (3 or 4; collapsed hexahedra give
+// triangles)
+struct SkinFace {
+    uint32_t element;
+    uint8_t face;
+    uint8_t corners;
+};
+
+// The exterior skin of a model's solid elements: faces that exactly one
+// visible solid refers to. Every face reference is keyed by its sorted
+// node indices and hashed into one of kPartitionCount partitions, which are
+// then sorted in parallel, so equal faces end up next to each other.
+//
+// The sorted partitions are kept, so hiding elements, appending them and
+// compacting removed ones update them in place; only the linear rescan for
+// exterior faces is repeated. Solids with undefined nodes are left out.
+class SolidSkin {
+public:
+    static constexpr size_t kPartitionCount = 64;
+
+    void Build(const Model& model);
+    void Clear();
+    bool IsBuilt() const { return m_Built; }
+    size_t GetElementCount() const { return m_ElementCount; }
+
+    // Incremental updates, mirroring the model's element arrays: elements
+    // appended since the last update, and compaction with the model's
+    // removal mask (elements past its end are kept)
+    void AddElements(const Model& model);
+    void RemoveElements(const std::vector<char>& removed);
+
+    // Hidden solids no longer cover their neighbours' faces. A part is the
+    // elements sharing a part (property) ID.
+    void SetElementsHidden(const std::vector<uint32_t>& elementIndices, bool hidden);
+    void SetPartHidden(const Model& model, int partId, bool hidden);
+    bool IsHidden(size_t elementIndex) const {
+        return elementIndex < m_Hidden.size() && m_Hidden[elementIndex];
+    }
+    // One entry per element once anything was hidden, else empty
+    const std::vector<char>& GetHiddenMask() const { return m_Hidden; }
+
+    // Exterior faces, in no particular order; rescanned after changes
+    const std::vector<SkinFace>& GetFaces() const;
+
+    // Outward-ordered node indices of a face; returns the corner count
+    static int GetFaceNodes(const Model& model, const SkinFace& face, uint32_t* nodes);
+
+    size_t GetMemoryBytes() const;
+
+private:
+    // One face reference, ordered by key and then by owner so a partition's
+    // order does not depend on which thread produced what
+    struct FaceRef {
+        uint32_t key[4];     // Sorted distinct node indices, padded with kNoNode
+        uint32_t element;
+        uint8_t face;
+        uint8_t corners;
+
+        bool operator<(const FaceRef& other) const;
+        bool SameKey(const FaceRef& other) const;
+    };
+
+    void AppendReferences(const Model& model, size_t first, size_t last);
+
+private:
+    bool m_Built = false;
+    size_t m_ElementCount = 0;
+    std::vector<FaceRef> m_Partitions[kPartitionCount];
+    std::vector<char> m_Hidden;
+
+    mutable std::vector<SkinFace> m_Faces;
+    mutable bool m_FacesDirty = false;
+};
@@ -0,0 +1,305 @@
+#include "core/SpatialGrid.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <queue>
+
+namespace {
+
+constexpr size_t kGrainSize = 1u << 14;
+constexpr size_t kCellGrainSize = 1u << 12;
+
+} // namespace
+
+void SpatialGrid::Build(const std::vector<glm::vec3>& points, float cellSize) {
+    Clear();
+    Sort(points, cellSize);
+    LOG_DEBUG("Spatial grid: {} points in {}x{}x{} cells of {}", m_Items.size(), m_Dims.x, m_Dims.y, m_Dims.z,
+              m_CellSize);
+}
+
+void SpatialGrid::Build(const ChunkedColumn<glm::vec3>& points, float cellSize) {
+    Clear();
+    Sort(points, cellSize);
+    LOG_DEBUG("Spatial grid: {} points in {}x{}x{} cells of {}", m_Items.size(), m_Dims.x, m_Dims.y, m_Dims.z,
+              m_CellSize);
+}
+
+void SpatialGrid::BuildBoxes(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs,
+                             float cellSize) {
+    Clear();
+    const size_t count = std::min(mins.size(), maxs.size());
+    std::vector<glm::vec3> centres(count);
+    std::vector<float> reach(count, 0.0f);
+    ThreadPool::GetGlobal().ParallelFor(count, kGrainSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            centres[i] = (mins[i] + maxs[i]) * 0.5f;
+            glm::vec3 half = (maxs[i] - mins[i]) * 0.5f;
+            reach[i] = std::max(half.x, std::max(half.y, half.z));
+        }
+    });
+    m_Reach = count > 0 ? *std::max_element(reach.begin(), reach.end()) : 0.0f;
+    Sort(centres, cellSize);
+    
+    m_BoxMins.resize(count);
+    m_BoxMaxs.resize(count);
+    ThreadPool::GetGlobal().ParallelFor(count, kGrainSize, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            m_BoxMins[s] = mins[m_Items[s]];
+            m_BoxMaxs[s] = maxs[m_Items[s]];
+        }
+    });
+    LOG_DEBUG("Spatial grid: {} boxes in {}x{}x{} cells of {}", count, m_Dims.x, m_Dims.y, m_Dims.z, m_CellSize);
+}
+
+void SpatialGrid::Clear() {
+    m_Origin = glm::vec3(0.0f);
+    m_CellSize = 1.0f;
+    m_Dims = glm::ivec3(0);
+    m_Reach = 0.0f;
+    m_Offsets = std::vector<uint32_t>();
+    m_Items = std::vector<uint32_t>();
+    m_Points = std::vector<glm::vec3>();
+    m_BoxMins = std::vector<glm::vec3>();
+    m_BoxMaxs = std::vector<glm::vec3>();
+}
+
+size_t SpatialGrid::GetMemoryBytes() const {
+    return m_Offsets.capacity() * sizeof(uint32_t) + m_Items.capacity() * sizeof(uint32_t) +
+           (m_Points.capacity() + m_BoxMins.capacity() + m_BoxMaxs.capacity()) * sizeof(glm::vec3);
+}
+
+template<typename Points>
+void SpatialGrid::Sort(const Points& centres, float cellSize) {
+    const size_t count = centres.size();
+    if (count == 0) {
+        return;
+    }
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    
+    // Bounds
+    std::mutex mutex;
+    glm::vec3 lo(centres[0]), hi(centres[0]);
+    pool.ParallelFor(count, kGrainSize, [&](size_t begin, size_t end) {
+        glm::vec3 localLo(centres[begin]), localHi(centres[begin]);
+        for (size_t i = begin; i < end; ++i) {
+            localLo = glm::min(localLo, centres[i]);
+            localHi = glm::max(localHi, centres[i]);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        lo = glm::min(lo, localLo);
+        hi = glm::max(hi, localHi);
+    });
+    
+    // Flat or single-point extents still get cells of some size
+    const glm::vec3 extent = hi - lo;
+    const float longest = std::max(extent.x, std::max(extent.y, extent.z));
+    if (cellSize <= 0.0f) {
+        const float floor = std::max(longest * 1e-3f, 1e-6f);
+        const double volume = static_cast<double>(std::max(extent.x, floor)) * std::max(extent.y, floor) *
+                              std::max(extent.z, floor);
+        cellSize = static_cast<float>(std::cbrt(volume * kItemsPerCell / static_cast<double>(count)));
+    }
+    cellSize = std::max(cellSize, std::max(longest * 1e-6f, 1e-12f));
+    for (;;) {
+        m_Dims = glm::ivec3(extent / cellSize) + glm::ivec3(1);
+        const double cells = static_cast<double>(m_Dims.x) * m_Dims.y * m_Dims.z;
+        if (cells <= static_cast<double>(kMaxCells)) {
+            break;
+        }
+        cellSize *= static_cast<float>(std::cbrt(cells / kMaxCells)) * 1.01f;
+    }
+    m_Origin = lo;
+    m_CellSize = cellSize;
+    const size_t cellCount = static_cast<size_t>(m_Dims.x) * m_Dims.y * m_Dims.z;
+    
+    // Counting sort: count items per cell, turn the counts into offsets,
+    // then scatter through per-cell atomic cursors
+    std::vector<uint32_t> cells(count);
+    std::vector<std::atomic<uint32_t>> cursors(cellCount);
+    pool.ParallelFor(count, kGrainSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const glm::ivec3 c = CellOf(centres[i]);
+            cells[i] = static_cast<uint32_t>(CellIndex(c.x, c.y, c.z));
+            cursors[cells[i]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    m_Offsets.assign(cellCount + 1, 0);
+    for (size_t c = 0; c < cellCount; ++c) {
+        const uint32_t cellItems = cursors[c].load(std::memory_order_relaxed);
+        cursors[c].store(m_Offsets[c], std::memory_order_relaxed);
+        m_Offsets[c + 1] = m_Offsets[c] + cellItems;
+    }
+    m_Items.resize(count);
+    pool.ParallelFor(count, kGrainSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            m_Items[cursors[cells[i]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(i);
+        }
+    });
+    
+    // Scatter order depends on timing; sorting the short cells removes that
+    m_Points.resize(count);
+    pool.ParallelFor(cellCount, kCellGrainSize, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            std::sort(m_Items.begin() + m_Offsets[c], m_Items.begin() + m_Offsets[c + 1]);
+            for (size_t s = m_Offsets[c]; s < m_Offsets[c + 1]; ++s) {
+                m_Points[s] = centres[m_Items[s]];
+            }
+        }
+    });
+}
+
+glm::ivec3 SpatialGrid::CellOf(const glm::vec3& p) const {
+    const glm::ivec3 cell(glm::floor((p - m_Origin) / m_CellSize));
+    return glm::clamp(cell, glm::ivec3(0), m_Dims - glm::ivec3(1));
+}
+
+float SpatialGrid::DistanceSquared(const glm::vec3& p, size_t s) const {
+    glm::vec3 d;
+    if (HasBoxes()) {
+        d = glm::max(glm::max(m_BoxMins[s] - p, p - m_BoxMaxs[s]), glm::vec3(0.0f));
+    } else {
+        d = m_Points[s] - p;
+    }
+    return glm::dot(d, d);
+}
+
+template<typename Fn>
+void SpatialGrid::ForEachInBox(const glm::vec3& min, const glm::vec3& max, Fn&& fn) const {
+    if (m_Items.empty()) {
+        return;
+    }
+    const glm::vec3 reach(m_Reach);
+    const glm::vec3 lo = min - reach;
+    const glm::vec3 hi = max + reach;
+    const glm::vec3 gridHi = m_Origin + glm::vec3(m_Dims) * m_CellSize;
+    if (glm::any(glm::lessThan(hi, m_Origin)) || glm::any(glm::greaterThan(lo, gridHi))) {
+        return;
+    }
+    const glm::ivec3 first = CellOf(lo);
+    const glm::ivec3 last = CellOf(hi);
+    for (int z = first.z; z <= last.z; ++z) {
+        for (int y = first.y; y <= last.y; ++y) {
+            // A row of cells is one run of items
+            const size_t begin = m_Offsets[CellIndex(first.x, y, z)];
+            const size_t end = m_Offsets[CellIndex(last.x, y, z) + 1];
+            for (size_t s = begin; s < end; ++s) {
+                fn(s);
+            }
+        }
+    }
+}
+
+void SpatialGrid::QueryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const {
+    const float limit = radius * radius;
+    ForEachInBox(center - glm::vec3(radius), center + glm::vec3(radius), [&](size_t s) {
+        if (DistanceSquared(center, s) <= limit) {
+            out.push_back(m_Items[s]);
+        }
+    });
+}
+
+void SpatialGrid::QueryBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const {
+    ForEachInBox(min, max, [&](size_t s) {
+        const glm::vec3& itemMin = HasBoxes() ? m_BoxMins[s] : m_Points[s];
+        const glm::vec3& itemMax = HasBoxes() ? m_BoxMaxs[s] : m_Points[s];
+        if (glm::all(glm::lessThanEqual(itemMin, max)) && glm::all(glm::greaterThanEqual(itemMax, min))) {
+            out.push_back(m_Items[s]);
+        }
+    });
+}
+
+void SpatialGrid::QueryNearest(const glm::vec3& point, size_t k, std::vector<uint32_t>& out) const {
+    if (k == 0 || m_Items.empty()) {
+        return;
+    }
+    k = std::min(k, m_Items.size());
+    
+    // Rings of cells outwards from the nearest cell. Anything in ring r is
+    // at least r - 1 cells from the point, less the way to the grid and
+    // the widest box, which bounds the search.
+    using Candidate = std::pair<float, uint32_t>;
+    std::priority_queue<Candidate> best;
+    const glm::ivec3 centre = CellOf(point);
+    const glm::vec3 gridHi = m_Origin + glm::vec3(m_Dims) * m_CellSize;
+    const glm::vec3 outside = glm::max(glm::max(m_Origin - point, point - gridHi), glm::vec3(0.0f));
+    const float offset = glm::length(outside) + m_Reach;
+    const int rings = std::max(m_Dims.x, std::max(m_Dims.y, m_Dims.z));
+    auto visit = [&](int x, int y, int z) {
+        if (x < 0 || y < 0 || z < 0 || x >= m_Dims.x || y >= m_Dims.y || z >= m_Dims.z) {
+            return;
+        }
+        const size_t cell = CellIndex(x, y, z);
+        for (size_t s = m_Offsets[cell]; s < m_Offsets[cell + 1]; ++s) {
+            const Candidate candidate(DistanceSquared(point, s), m_Items[s]);
+            if (best.size() < k) {
+                best.push(candidate);
+            } else if (candidate < best.top()) {
+                best.pop();
+                best.push(candidate);
+            }
+        }
+    };
+    
+    visit(centre.x, centre.y, centre.z);
+    for (int r = 1; r <= rings; ++r) {
+        const float bound = (r - 1) * m_CellSize - offset;
+        if (best.size() == k && bound > 0.0f && best.top().first <= bound * bound) {
+            break;
+        }
+        for (int z = centre.z - r; z <= centre.z + r; ++z) {
+            for (int y = centre.y - r; y <= centre.y + r; ++y) {
+                const bool face = z == centre.z - r || z == centre.z + r || y == centre.y - r || y == centre.y + r;
+                for (int x = centre.x - r; x <= centre.x + r; x += face ? 1 : 2 * r) {
+                    visit(x, y, z);
+                }
+            }
+        }
+    }
+    
+    const size_t first = out.size();
+    out.resize(first + best.size());
+    for (size_t i = out.size(); i > first; --i) {
+        out[i - 1] = best.top().second;
+        best.pop();
+    }
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> SpatialGrid::FindPairs(float tolerance) const {
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    std::mutex mutex;
+    const float limit = tolerance * tolerance;
+    
+    // Each pair is seen from both ends and kept from the lower item
+    ThreadPool::GetGlobal().ParallelFor(m_Items.size(), kGrainSize, [&](size_t begin, size_t end) {
+        std::vector<std::pair<uint32_t, uint32_t>> local;
+        for (size_t s = begin; s < end; ++s) {
+            const uint32_t item = m_Items[s];
+            const glm::vec3 lo = HasBoxes() ? m_BoxMins[s] : m_Points[s];
+            const glm::vec3 hi = HasBoxes() ? m_BoxMaxs[s] : m_Points[s];
+            ForEachInBox(lo - glm::vec3(tolerance), hi + glm::vec3(tolerance), [&](size_t other) {
+                if (m_Items[other] <= item) {
+                    return;
+                }
+                float distance;
+                if (HasBoxes()) {
+                    glm::vec3 gap = glm::max(glm::max(m_BoxMins[other] - hi, lo - m_BoxMaxs[other]), glm::vec3(0.0f));
+                    distance = glm::dot(gap, gap);
+                } else {
+                    glm::vec3 d = m_Points[other] - m_Points[s];
+                    distance = glm::dot(d, d);
+                }
+                if (distance <= limit) {
+                    local.emplace_back(item, m_Items[other]);
+                }
+            });
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        pairs.insert(pairs.end(), local.begin(), local.end());
+    });
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
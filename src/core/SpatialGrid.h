@@ -0,0 +1,72 @@
+#pragma once
+#include "ChunkedColumn.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Uniform grid over points, such as node positions, or over boxes, such
+// as element bounds, for neighbour searches. Items are numbered by the
+// order they were given in and sorted by cell with a parallel counting
+// sort, their positions copied alongside so a cell's items are read
+// contiguously. Boxes go in the cell of their centre and queries widen by
+// the largest half extent, so each box is stored once.
+class SpatialGrid {
+public:
+    static constexpr size_t kItemsPerCell = 4;     // Aimed for with no cell size given
+    static constexpr size_t kMaxCells = 1u << 22;
+    
+    // A zero cell size picks one from the bounds and the item count
+    void Build(const std::vector<glm::vec3>& points, float cellSize = 0.0f);
+    void Build(const ChunkedColumn<glm::vec3>& points, float cellSize = 0.0f);
+    void BuildBoxes(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs,
+                    float cellSize = 0.0f);
+    void Clear();
+    
+    bool IsEmpty() const { return m_Items.empty(); }
+    bool HasBoxes() const { return !m_BoxMins.empty(); }
+    size_t GetItemCount() const { return m_Items.size(); }
+    float GetCellSize() const { return m_CellSize; }
+    size_t GetMemoryBytes() const;
+    
+    // Items within radius of center (boxes: that come that close), and
+    // items touching a box; appended to out in no set order
+    void QueryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const;
+    void QueryBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+    
+    // The k points nearest to point, nearest first; box grids measure to
+    // the box
+    void QueryNearest(const glm::vec3& point, size_t k, std::vector<uint32_t>& out) const;
+    
+    // Every pair of items no farther apart than tolerance, as (lower,
+    // higher) item numbers, sorted. Runs on the global pool.
+    std::vector<std::pair<uint32_t, uint32_t>> FindPairs(float tolerance) const;
+
+private:
+    template<typename Points>
+    void Sort(const Points& centres, float cellSize);
+    glm::ivec3 CellOf(const glm::vec3& p) const;
+    size_t CellIndex(int x, int y, int z) const {
+        return (static_cast<size_t>(z) * m_Dims.y + static_cast<size_t>(y)) * m_Dims.x + static_cast<size_t>(x);
+    }
+    
+    // Squared distance from p to sorted item s
+    float DistanceSquared(const glm::vec3& p, size_t s) const;
+    
+    // Calls fn(sorted) for items in the cells a box covers
+    template<typename Fn>
+    void ForEachInBox(const glm::vec3& min, const glm::vec3& max, Fn&& fn) const;
+
+private:
+    glm::vec3 m_Origin = glm::vec3(0.0f);
+    float m_CellSize = 1.0f;
+    glm::ivec3 m_Dims = glm::ivec3(0);
+    float m_Reach = 0.0f;                 // Largest box half extent
+    
+    std::vector<uint32_t> m_Offsets;      // Per cell, into m_Items; cell count + 1
+    std::vector<uint32_t> m_Items;        // Item numbers, cell by cell
+    std::vector<glm::vec3> m_Points;      // Positions or box centres, as m_Items
+    std::vector<glm::vec3> m_BoxMins;     // Box grids only, as m_Items
+    std::vector<glm::vec3> m_BoxMaxs;
+};
@@ -1,10 +1,23 @@
 #include "gui/GuiManager.h"
 #include "core/Application.h"
 #include "core/Model.h"
+#include "core/ModelLoader.h"
+#include "core/MeshQuality.h"
+#include "core/NodeMerger.h"
+#include "io/ResultCache.h"
+#include "rendering/Renderer.h"
+#include "solver/DomainPartitioner.h"
+#include "solver/JobManager.h"
+#include "solver/TimeStepEstimator.h"
+#include "utils/Logger.h"
+#include "utils/Profiler.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
 
 GuiManager::GuiManager(GLFWwindow* window, Application* app)
     : m_Window(window), m_Application(app) {
@@ -23,6 +36,10 @@ void GuiManager::Initialize() {
     ImGui_ImplOpenGL3_Init("#version 330");
 }
 
+bool GuiManager::WantsMouse() const {
+    return ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse;
+}
+
 void GuiManager::DrawMenuBar() {
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
@@ -57,6 +74,8 @@ void GuiManager::DrawMenuBar() {
             ImGui::Separator();
             if (ImGui::MenuItem("Select All", "Ctrl+A")) {}
             if (ImGui::MenuItem("Delete", "Del")) {}
+            ImGui::Separator();
+            ImGui::MenuItem("Merge Nodes...", nullptr, &m_ShowMergeNodes);
             ImGui::EndMenu();
         }
         
@@ -64,7 +83,15 @@ void GuiManager::DrawMenuBar() {
             if (ImGui::MenuItem("Wireframe", "W")) {}
             if (ImGui::MenuItem("Solid", "S")) {}
             if (ImGui::MenuItem("Nodes", "N")) {}
+            if (Renderer* renderer = m_Application->GetRenderer()) {
+                RenderSettings& settings = renderer->GetSettings();
+                ImGui::MenuItem("Smooth Shading", nullptr, &settings.smoothShading);
+                ImGui::SliderFloat("Feature Angle", &settings.featureAngle, 0.0f, 90.0f, "%.0f deg");
+            }
             ImGui::Separator();
+            ImGui::MenuItem("Mesh Quality...", nullptr, &m_ShowMeshQuality);
+            ImGui::MenuItem("Application Log", nullptr, &m_ShowApplicationLog);
+            ImGui::MenuItem("Statistics", nullptr, &m_ShowStatistics);
             if (ImGui::MenuItem("Property Panel", nullptr, m_ShowPropertyPanel)) {
                 m_ShowPropertyPanel = !m_ShowPropertyPanel;
             }
@@ -76,7 +103,11 @@ void GuiManager::DrawMenuBar() {
                 m_ShowSolverDialog = true;
             }
             if (ImGui::MenuItem("Solver Settings...")) {}
-            if (ImGui::MenuItem("Job Manager...")) {}
+            ImGui::MenuItem("Solver Output", nullptr, &m_ShowSolverLog);
+            ImGui::MenuItem("Solver Progress", nullptr, &m_ShowSolverProgress);
+            ImGui::MenuItem("Job Manager...", nullptr, &m_ShowJobManager);
+            ImGui::MenuItem("Decomposition Preview...", nullptr, &m_ShowDecomposition);
+            ImGui::MenuItem("Time Step Check...", nullptr, &m_ShowTimeStep);
             ImGui::EndMenu();
         }
         
@@ -114,7 +145,7 @@ void GuiManager::DrawToolBar() {
     }
     ImGui::SameLine();
     if (ImGui::Button("Stop")) {
-        // Stop current job
+        m_Application->GetJobManager()->Cancel(m_Application->GetShownJob());
     }
     
     ImGui::End();
@@ -131,19 +162,61 @@ void GuiManager::DrawSolverDialog() {
     static int numCPUs = 4;
     ImGui::SliderInt("Number of CPUs", &numCPUs, 1, 16);
     
+    static int numThreads = 1;
+    ImGui::SliderInt("Threads per CPU", &numThreads, 1, 16);
+    
     static bool useMPI = false;
     ImGui::Checkbox("Use MPI", &useMPI);
     
     static float endTime = 1.0f;
     ImGui::InputFloat("End Time", &endTime);
     
+    // Queue settings; the run waits until the budget has its cores
+    static int priority = 0;
+    ImGui::InputInt("Priority", &priority);
+    
+    static int retries = 0;
+    ImGui::SliderInt("Retries", &retries, 0, 5);
+    
+    static float memoryGB = 0.0f;
+    ImGui::InputFloat("Memory (GB)", &memoryGB);
+    
+    // Cost of the run at the step the model's elements allow
+    ImGui::Separator();
+    const TimeStepReport* timeSteps = m_Application->GetTimeStepReport();
+    if (!timeSteps) {
+        if (ImGui::Button("Estimate Time Step")) {
+            m_Application->EstimateTimeSteps();
+        }
+    } else if (timeSteps->minimum > 0.0) {
+        ImGui::Text("Stable step %.3g at element %d", timeSteps->minimum * TimeStepReport::kScaleFactor,
+                    timeSteps->minimumElementId);
+        ImGui::Text("About %.0f cycles to end time", timeSteps->GetCycleCount(endTime));
+    } else if (timeSteps->estimated > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Element %d is collapsed, the run cannot step",
+                           timeSteps->minimumElementId);
+    } else {
+        ImGui::TextDisabled("No element has a time step");
+    }
+    
     ImGui::Separator();
     
     if (ImGui::Button("Run")) {
         if (m_SolverRunCallback) {
-            m_SolverRunCallback();
+            JobSpec spec;
+            spec.config.solverPath = solverPath;
+            spec.config.numProcessors = numCPUs;
+            spec.config.numThreads = numThreads;
+            spec.config.useMPI = useMPI;
+            spec.config.endTime = endTime;
+            spec.priority = priority;
+            spec.maxRetries = retries;
+            spec.memoryGB = std::max(memoryGB, 0.0f);
+            m_SolverRunCallback(spec);
         }
         m_ShowSolverDialog = false;
+        m_ShowSolverLog = true;
+        m_ShowSolverProgress = true;
     }
     ImGui::SameLine();
     if (ImGui::Button("Cancel")) {
@@ -151,4 +224,741 @@ void GuiManager::DrawSolverDialog() {
     }
     
     ImGui::End();
-}
\ No newline at end of file
+}
+
+void GuiManager::DrawLoadingDialog() {
+    ModelLoader* loader = m_Application->GetModelLoader();
+    if (!loader || !loader->IsLoading()) return;
+    
+    ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_AlwaysAutoResize |
+                                     ImGuiWindowFlags_NoCollapse);
+    
+    ImGui::Text("%s", loader->GetFilePath().c_str());
+    ImGui::ProgressBar(loader->GetProgress(), ImVec2(300.0f, 0.0f));
+    ImGui::Text("%.1f / %.1f MB", loader->GetBytesParsed() / (1024.0 * 1024.0),
+                loader->GetBytesTotal() / (1024.0 * 1024.0));
+    ImGui::Text("Nodes: %zu  Elements: %zu", loader->GetNodesParsed(),
+                loader->GetElementsParsed());
+    
+    if (ImGui::Button("Cancel")) {
+        loader->Cancel();
+    }
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawContourPanel() {
+    ResultCache* results = m_Application->GetResults();
+    Renderer* renderer = m_Application->GetRenderer();
+    if (!results || !renderer) return;
+    const std::vector<std::string>& fields = results->GetReader().GetElementScalarNames();
+    if (fields.empty()) return;
+    
+    RenderSettings& settings = renderer->GetSettings();
+    ContourSettings& contour = settings.contour;
+    const ContourPlot& plot = renderer->GetContour();
+    
+    ImGui::Begin("Contours", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    
+    bool enabled = settings.colorMode == ColorMode::CONTOUR;
+    if (ImGui::Checkbox("Show fringes", &enabled)) {
+        settings.colorMode = enabled ? ColorMode::CONTOUR : ColorMode::PART;
+        settings.showSolid = settings.showSolid || enabled;
+    }
+    contour.field = std::clamp(contour.field, 0, static_cast<int>(fields.size()) - 1);
+    if (ImGui::BeginCombo("Field", fields[contour.field].c_str())) {
+        for (int i = 0; i < static_cast<int>(fields.size()); ++i) {
+            if (ImGui::Selectable(fields[i].c_str(), i == contour.field)) {
+                contour.field = i;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::Checkbox("Average to nodes", &contour.nodal);
+    ImGui::SliderInt("Bands", &contour.bands, 0, 24, contour.bands == 0 ? "Continuous" : "%d");
+    static const char* kColormaps[] = {"Rainbow", "Viridis", "Cool to warm", "Grayscale"};
+    int colormap = static_cast<int>(contour.colormap);
+    if (ImGui::Combo("Colormap", &colormap, kColormaps, IM_ARRAYSIZE(kColormaps))) {
+        contour.colormap = static_cast<Colormap>(colormap);
+    }
+    
+    // The manual range starts from the state's
+    ImGui::Checkbox("Automatic range", &contour.autoRange);
+    if (contour.autoRange) {
+        if (plot.HasRange()) {
+            contour.rangeMin = plot.GetMin();
+            contour.rangeMax = plot.GetMax();
+        }
+    } else {
+        float speed = std::max(contour.rangeMax - contour.rangeMin, 1e-6f) * 0.005f;
+        ImGui::DragFloatRange2("Range", &contour.rangeMin, &contour.rangeMax, speed);
+    }
+    
+    // Legend: the scale as drawn, and how the values spread over it
+    if (!contour.autoRange || plot.HasRange()) {
+        const float width = 300.0f, height = 16.0f;
+        const int segments = contour.bands > 0 ? contour.bands : 64;
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        for (int i = 0; i < segments; ++i) {
+            glm::vec3 color = ContourPlot::SampleColormap(contour.colormap, (i + 0.5f) / segments);
+            drawList->AddRectFilled(ImVec2(origin.x + width * i / segments, origin.y),
+                                    ImVec2(origin.x + width * (i + 1) / segments, origin.y + height),
+                                    ImGui::GetColorU32(ImVec4(color.r, color.g, color.b, 1.0f)));
+        }
+        ImGui::Dummy(ImVec2(width, height));
+        ImGui::Text("%.4g", contour.rangeMin);
+        ImGui::SameLine(width - ImGui::CalcTextSize("0.0000e+00").x);
+        ImGui::Text("%.4g", contour.rangeMax);
+        if (plot.HasRange()) {
+            ImGui::PlotHistogram("##Histogram", plot.GetHistogram().data(), ContourPlot::kHistogramBins,
+                                 0, "State histogram", 0.0f, FLT_MAX, ImVec2(width, 60.0f));
+        }
+    }
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawSectionPanel() {
+    Model* model = m_Application->GetModel();
+    Renderer* renderer = m_Application->GetRenderer();
+    if (!model || !renderer || model->GetNodeCount() == 0) return;
+    
+    RenderSettings& settings = renderer->GetSettings();
+    
+    ImGui::Begin("Sections", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    
+    // Offsets range over the model's extent along each normal
+    const glm::vec3 minBounds = model->GetMinBounds();
+    const glm::vec3 maxBounds = model->GetMaxBounds();
+    for (int i = 0; i < kMaxClipPlanes; ++i) {
+        ClipPlane& plane = settings.clipPlanes[i];
+        ImGui::PushID(i);
+        ImGui::Checkbox("##Enabled", &plane.enabled);
+        ImGui::SameLine();
+        if (ImGui::TreeNode("Plane", "Plane %d", i + 1)) {
+            ImGui::DragFloat3("Normal", &plane.normal.x, 0.01f, -1.0f, 1.0f);
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Flip")) {
+                plane.normal = -plane.normal;
+                plane.offset = -plane.offset;
+            }
+            float low = 0.0f, high = 0.0f;
+            float length = glm::length(plane.normal);
+            if (length > 0.0f) {
+                glm::vec3 normal = plane.normal / length;
+                for (int axis = 0; axis < 3; ++axis) {
+                    low += normal[axis] * (normal[axis] > 0.0f ? minBounds[axis] : maxBounds[axis]);
+                    high += normal[axis] * (normal[axis] > 0.0f ? maxBounds[axis] : minBounds[axis]);
+                }
+            }
+            ImGui::SliderFloat("Offset", &plane.offset, low, high);
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+    }
+    
+    ImGui::Separator();
+    ImGui::Checkbox("Cap Solids", &settings.capSections);
+    ImGui::ColorEdit3("Cap Color", &settings.capColor.x);
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawSolverLog() {
+    SolverInterface* solver = m_Application->GetSolverInterface();
+    if (!m_ShowSolverLog || !solver) return;
+    const SolverLog& log = solver->GetLog();
+    
+    ImGui::SetNextWindowSize(ImVec2(700.0f, 400.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Solver Output", &m_ShowSolverLog);
+    
+    ImGui::Text("%zu lines", log.GetLineCount());
+    if (log.GetFirstLineNumber() > 0) {
+        ImGui::SameLine();
+        ImGui::Text("(%llu older trimmed)", static_cast<unsigned long long>(log.GetFirstLineNumber()));
+    }
+    if (log.GetDroppedCount() > 0) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%llu dropped",
+                           static_cast<unsigned long long>(log.GetDroppedCount()));
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Follow", &m_FollowSolverLog);
+    ImGui::Separator();
+    
+    // Only the lines in view are laid out, however long the run
+    ImGui::BeginChild("##SolverLines", ImVec2(0.0f, 0.0f), false, ImGuiWindowFlags_HorizontalScrollbar);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(log.GetLineCount()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const std::string& line = log.GetLine(static_cast<size_t>(i));
+            ImGui::TextUnformatted(line.data(), line.data() + line.size());
+        }
+    }
+    clipper.End();
+    if (m_FollowSolverLog && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
+        ImGui::SetScrollHereY(1.0f);
+    }
+    ImGui::EndChild();
+    
+    ImGui::End();
+}
+
+namespace {
+
+// "3 d 04:12:09" and the like, for ETAs
+std::string FormatDuration(double seconds) {
+    char text[64];
+    long long total = static_cast<long long>(seconds + 0.5);
+    long long days = total / 86400;
+    int hours = static_cast<int>(total / 3600 % 24);
+    int minutes = static_cast<int>(total / 60 % 60);
+    int rest = static_cast<int>(total % 60);
+    if (days > 0) {
+        std::snprintf(text, sizeof(text), "%lld d %02d:%02d:%02d", days, hours, minutes, rest);
+    } else {
+        std::snprintf(text, sizeof(text), "%02d:%02d:%02d", hours, minutes, rest);
+    }
+    return text;
+}
+
+} // namespace
+
+void GuiManager::DrawSolverProgress() {
+    SolverInterface* solver = m_Application->GetSolverInterface();
+    if (!m_ShowSolverProgress || !solver) return;
+    const SolverTelemetry& telemetry = solver->GetTelemetry();
+    
+    ImGui::SetNextWindowSize(ImVec2(520.0f, 460.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Solver Progress", &m_ShowSolverProgress);
+    
+    if (!telemetry.HasSamples()) {
+        ImGui::Text("No cycles yet");
+        ImGui::End();
+        return;
+    }
+    
+    const TelemetrySample& latest = telemetry.GetLatest();
+    double progress = telemetry.GetProgress();
+    if (progress >= 0.0) {
+        char overlay[32];
+        std::snprintf(overlay, sizeof(overlay), "%.1f%%", progress * 100.0);
+        ImGui::ProgressBar(static_cast<float>(progress), ImVec2(-1.0f, 0.0f), overlay);
+    }
+    double eta = telemetry.GetEta();
+    ImGui::Text("Time %.4g / %.4g   ETA %s", latest.time, telemetry.GetEndTime(),
+                eta >= 0.0 ? FormatDuration(eta).c_str() : "--");
+    ImGui::Text("Cycle %lld   %.0f cycles/s   %.4g sim ms per wall hour", static_cast<long long>(latest.cycle),
+                std::max(telemetry.GetCyclesPerSecond(), 0.0), std::max(telemetry.GetSimMsPerWallHour(), 0.0));
+    ImGui::Text("Time step %.4g   Energy error %.2f%%   Mass error %.3g", latest.timeStep,
+                latest.energyError, latest.massError);
+    ImGui::Text("Elapsed %s", FormatDuration(latest.wallTime).c_str());
+    if (telemetry.IsTimeStepCollapsing()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "Time step has collapsed below %.0f%% of the first",
+                           SolverTelemetry::kCollapseRatio * 100.0);
+    }
+    if (telemetry.GetDroppedCount() > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%llu rows dropped",
+                           static_cast<unsigned long long>(telemetry.GetDroppedCount()));
+    }
+    if (solver->GetStatus() == SolverStatus::RUNNING) {
+        ImGui::SameLine();
+        if (ImGui::Button("Stop Run")) {
+            solver->CancelSolver();
+        }
+    }
+    
+    // The whole run, oldest on the left
+    ImGui::Separator();
+    const ImVec2 chartSize(-1.0f, 90.0f);
+    const std::vector<float>& timeSteps = telemetry.GetTimeSteps();
+    const std::vector<float>& errors = telemetry.GetEnergyErrors();
+    const std::vector<float>& rates = telemetry.GetSimRates();
+    ImGui::PlotLines("##TimeStep", timeSteps.data(), static_cast<int>(timeSteps.size()), 0, "Time step",
+                     0.0f, FLT_MAX, chartSize);
+    ImGui::PlotLines("##EnergyError", errors.data(), static_cast<int>(errors.size()), 0, "Energy error (%)",
+                     FLT_MAX, FLT_MAX, chartSize);
+    ImGui::PlotLines("##SimRate", rates.data(), static_cast<int>(rates.size()), 0, "Sim ms per wall hour",
+                     0.0f, FLT_MAX, chartSize);
+    
+    ImGui::End();
+}
+
+namespace {
+
+const char* GetStateName(JobState state) {
+    switch (state) {
+        case JobState::QUEUED: return "Queued";
+        case JobState::RUNNING: return "Running";
+        case JobState::COMPLETED: return "Completed";
+        case JobState::FAILED: return "Failed";
+        case JobState::CANCELLED: return "Cancelled";
+    }
+    return "";
+}
+
+} // namespace
+
+void GuiManager::DrawJobManager() {
+    if (!m_ShowJobManager) return;
+    JobManager* jobs = m_Application->GetJobManager();
+    
+    ImGui::SetNextWindowSize(ImVec2(640.0f, 400.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Job Manager", &m_ShowJobManager);
+    
+    JobBudget budget = jobs->GetBudget();
+    bool budgetChanged = ImGui::InputInt("Cores", &budget.cores);
+    budgetChanged |= ImGui::InputDouble("Memory (GB, 0 = unlimited)", &budget.memoryGB, 1.0, 16.0, "%.1f");
+    if (budgetChanged) {
+        jobs->SetBudget(budget);
+    }
+    ImGui::Text("Cores in use %d / %d   %zu running, %zu queued, %zu completed, %zu failed",
+                jobs->GetCoresInUse(), jobs->GetBudget().cores, jobs->GetCount(JobState::RUNNING),
+                jobs->GetCount(JobState::QUEUED), jobs->GetCount(JobState::COMPLETED),
+                jobs->GetCount(JobState::FAILED));
+    ImGui::Text("Throughput %.1f jobs/hour", jobs->GetThroughput());
+    if (ImGui::Button("Cancel All")) {
+        jobs->CancelAll();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Finished")) {
+        jobs->ClearFinished();
+    }
+    
+    // Choosing a row shows its run in the output and progress windows
+    ImGui::Separator();
+    const auto now = std::chrono::steady_clock::now();
+    if (ImGui::BeginTable("Jobs", 7)) {
+        ImGui::TableSetupColumn("Job");
+        ImGui::TableSetupColumn("State");
+        ImGui::TableSetupColumn("Priority");
+        ImGui::TableSetupColumn("Cores");
+        ImGui::TableSetupColumn("Attempt");
+        ImGui::TableSetupColumn("Progress");
+        ImGui::TableSetupColumn("");
+        ImGui::TableHeadersRow();
+        for (const Job& job : jobs->GetJobs()) {
+            ImGui::PushID(static_cast<int>(job.id));
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            char label[300];
+            std::snprintf(label, sizeof(label), "%llu %s", static_cast<unsigned long long>(job.id),
+                          job.spec.name.c_str());
+            if (ImGui::Selectable(label, job.id == m_Application->GetShownJob())) {
+                m_Application->ShowJob(job.id);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", GetStateName(job.state));
+            if (!job.reason.empty() && ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s", job.reason.c_str());
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", job.spec.priority);
+            ImGui::TableNextColumn();
+            if (job.state == JobState::RUNNING) {
+                ImGui::Text("%d x %d", job.ranks, job.cores / std::max(job.ranks, 1));
+            } else {
+                ImGui::TextDisabled("-");
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%d / %d", job.attempts, job.spec.maxRetries + 1);
+            ImGui::TableNextColumn();
+            if (job.attempts > 0) {
+                const auto end = job.state == JobState::RUNNING ? now : job.finished;
+                const std::string elapsed = FormatDuration(std::chrono::duration<double>(end - job.started).count());
+                ImGui::ProgressBar(job.progress, ImVec2(-1.0f, 0.0f), elapsed.c_str());
+            }
+            ImGui::TableNextColumn();
+            if (job.state == JobState::QUEUED || job.state == JobState::RUNNING) {
+                if (ImGui::SmallButton("Cancel")) {
+                    jobs->Cancel(job.id);
+                }
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawDecompositionPreview() {
+    if (!m_ShowDecomposition) return;
+    Model* model = m_Application->GetModel();
+    DecompositionPreview* preview = m_Application->GetDecompositionPreview();
+    
+    ImGui::SetNextWindowSize(ImVec2(560.0f, 420.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Decomposition Preview", &m_ShowDecomposition);
+    
+    ImGui::InputInt("From ranks", &m_SweepMinRanks);
+    ImGui::InputInt("To ranks", &m_SweepMaxRanks);
+    ImGui::InputInt("Also ranks", &m_SweepExtraRanks);
+    m_SweepMinRanks = std::clamp(m_SweepMinRanks, 1, DomainPartitioner::kMaxRanks);
+    m_SweepMaxRanks = std::clamp(m_SweepMaxRanks, m_SweepMinRanks, DomainPartitioner::kMaxRanks);
+    m_SweepExtraRanks = std::clamp(m_SweepExtraRanks, 0, DomainPartitioner::kMaxRanks);
+    
+    if (preview->IsRunning()) {
+        ImGui::Text("Partitioning %zu elements...", preview->GetElementCount());
+    } else if (!model || model->GetElementCount() == 0) {
+        ImGui::Text("No elements to partition");
+    } else if (ImGui::Button("Analyze")) {
+        // Powers of two over the range, and whatever else was asked for
+        std::vector<int> rankCounts;
+        for (int ranks = 1; ranks <= m_SweepMaxRanks; ranks *= 2) {
+            if (ranks >= m_SweepMinRanks) {
+                rankCounts.push_back(ranks);
+            }
+        }
+        if (m_SweepExtraRanks > 0) {
+            rankCounts.push_back(m_SweepExtraRanks);
+        }
+        m_Application->StartDecompositionPreview(rankCounts);
+        m_SweepSelected = -1;
+    }
+    
+    const std::vector<Decomposition>& results = preview->GetResults();
+    if (results.empty()) {
+        ImGui::End();
+        return;
+    }
+    ImGui::SameLine();
+    ImGui::Text("%zu elements in %.2f s", preview->GetElementCount(), preview->GetSeconds());
+    
+    ImGui::Separator();
+    if (ImGui::BeginTable("Sweep", 6)) {
+        ImGui::TableSetupColumn("Ranks");
+        ImGui::TableSetupColumn("Imbalance");
+        ImGui::TableSetupColumn("Interface nodes");
+        ImGui::TableSetupColumn("Most per domain");
+        ImGui::TableSetupColumn("Speedup");
+        ImGui::TableSetupColumn("Efficiency");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Decomposition& result = results[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            char label[32];
+            std::snprintf(label, sizeof(label), "%d", result.rankCount);
+            if (ImGui::Selectable(label, static_cast<int>(i) == m_SweepSelected)) {
+                m_SweepSelected = static_cast<int>(i);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f%%", result.imbalance * 100.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", result.interfaceNodes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", result.maxInterfaceNodes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", result.predictedSpeedup);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f%%", result.efficiency * 100.0);
+        }
+        ImGui::EndTable();
+    }
+    
+    // Load and interfaces of each domain of the chosen count
+    if (m_SweepSelected >= 0 && m_SweepSelected < static_cast<int>(results.size())) {
+        const Decomposition& result = results[m_SweepSelected];
+        std::vector<float> loads, interfaces;
+        size_t fewest = SIZE_MAX, most = 0;
+        for (const DomainLoad& domain : result.domains) {
+            loads.push_back(static_cast<float>(domain.load));
+            interfaces.push_back(static_cast<float>(domain.interfaceNodes));
+            fewest = std::min(fewest, domain.elements);
+            most = std::max(most, domain.elements);
+        }
+        ImGui::Separator();
+        ImGui::Text("%d domains of %zu to %zu elements", result.rankCount, fewest, most);
+        const ImVec2 chartSize(-1.0f, 90.0f);
+        ImGui::PlotHistogram("##Loads", loads.data(), static_cast<int>(loads.size()), 0, "Load per domain",
+                             0.0f, FLT_MAX, chartSize);
+        ImGui::PlotHistogram("##Interfaces", interfaces.data(), static_cast<int>(interfaces.size()), 0,
+                             "Interface nodes per domain", 0.0f, FLT_MAX, chartSize);
+    }
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawTimeStepCheck() {
+    if (!m_ShowTimeStep) return;
+    Model* model = m_Application->GetModel();
+    const TimeStepReport* report = m_Application->GetTimeStepReport();
+    
+    ImGui::SetNextWindowSize(ImVec2(480.0f, 460.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Time Step Check", &m_ShowTimeStep);
+    
+    if (!model || model->GetElementCount() == 0) {
+        ImGui::Text("No elements to check");
+        ImGui::End();
+        return;
+    }
+    if (ImGui::Button(report ? "Check Again" : "Check")) {
+        m_Application->EstimateTimeSteps();
+        report = m_Application->GetTimeStepReport();
+    }
+    if (!report) {
+        ImGui::End();
+        return;
+    }
+    ImGui::SameLine();
+    ImGui::Text("%zu elements in %.3f s", report->timeSteps.size(), report->seconds);
+    
+    ImGui::Separator();
+    if (report->estimated == 0) {
+        ImGui::TextDisabled("No element has a time step");
+        ImGui::End();
+        return;
+    }
+    ImGui::Text("Smallest step %.4g at element %d", report->minimum, report->minimumElementId);
+    ImGui::Text("Engine step %.4g (scale %.2f)", report->minimum * TimeStepReport::kScaleFactor,
+                TimeStepReport::kScaleFactor);
+    ImGui::Text("%zu elements estimated", report->estimated);
+    if (report->unresolved > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "%zu skipped for undefined nodes", report->unresolved);
+    }
+    
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "log10 step, %.0f to %.0f", report->histogramLow, report->histogramHigh);
+    ImGui::PlotHistogram("##Steps", report->histogram.data(), static_cast<int>(report->histogram.size()), 0,
+                         overlay, 0.0f, FLT_MAX, ImVec2(-1.0f, 100.0f));
+    
+    if (ImGui::Button("Highlight Worst")) {
+        m_Application->SelectElements(report->worstIds);
+    }
+    ImGui::SameLine();
+    ImGui::Text("The %zu smallest steps", report->worstIds.size());
+    if (ImGui::BeginTable("Worst", 3)) {
+        ImGui::TableSetupColumn("Element");
+        ImGui::TableSetupColumn("Step");
+        ImGui::TableSetupColumn("Over smallest");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < report->worstIds.size(); ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            char label[32];
+            std::snprintf(label, sizeof(label), "%d", report->worstIds[i]);
+            if (ImGui::Selectable(label, false)) {
+                m_Application->SelectElements({report->worstIds[i]});
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.4g", report->worstSteps[i]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", report->minimum > 0.0 ? report->worstSteps[i] / report->minimum : 0.0);
+        }
+        ImGui::EndTable();
+    }
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawMeshQuality() {
+    if (!m_ShowMeshQuality) return;
+    Model* model = m_Application->GetModel();
+    MeshQuality* quality = m_Application->GetMeshQuality();
+    
+    ImGui::SetNextWindowSize(ImVec2(520.0f, 480.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Mesh Quality", &m_ShowMeshQuality);
+    
+    if (!model || model->GetElementCount() == 0) {
+        ImGui::Text("No elements to check");
+        ImGui::End();
+        return;
+    }
+    if (ImGui::Button(quality->IsEmpty() ? "Evaluate" : "Evaluate All")) {
+        quality->Evaluate(*model);
+    }
+    if (quality->IsEmpty()) {
+        ImGui::End();
+        return;
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80.0f);
+    ImGui::InputInt("##Part", &m_QualityPart);
+    ImGui::SameLine();
+    if (ImGui::Button("Evaluate Part")) {
+        quality->EvaluatePart(*model, m_QualityPart);
+    }
+    ImGui::Text("%zu of %zu elements in %.3f s", quality->GetEvaluatedCount(), quality->GetElementCount(),
+                quality->GetSeconds());
+    
+    // Limits and failing counts, one row per metric
+    ImGui::Separator();
+    QualityThresholds thresholds = quality->GetThresholds();
+    bool thresholdsChanged = false;
+    if (ImGui::BeginTable("Metrics", 5)) {
+        ImGui::TableSetupColumn("Metric");
+        ImGui::TableSetupColumn("Range");
+        ImGui::TableSetupColumn("Limit");
+        ImGui::TableSetupColumn("Failing");
+        ImGui::TableSetupColumn("");
+        ImGui::TableHeadersRow();
+        for (size_t m = 0; m < MeshQuality::kMetricCount; ++m) {
+            const QualityMetric metric = static_cast<QualityMetric>(m);
+            const QualityHistogram& histogram = quality->GetHistogram(metric);
+            ImGui::PushID(static_cast<int>(m));
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(MeshQuality::GetName(metric), m_QualityMetric == static_cast<int>(m))) {
+                m_QualityMetric = static_cast<int>(m);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3g to %.3g", histogram.low, histogram.high);
+            ImGui::TableNextColumn();
+            float limit = thresholds.Get(metric);
+            ImGui::SetNextItemWidth(80.0f);
+            if (ImGui::InputFloat("##Limit", &limit)) {
+                thresholds.Set(metric, limit);
+                thresholdsChanged = true;
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", histogram.failing);
+            ImGui::TableNextColumn();
+            if (ImGui::Button("Select")) {
+                m_Application->SelectElements(quality->Select(*model, metric));
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    if (thresholdsChanged) {
+        quality->SetThresholds(thresholds);
+    }
+    if (ImGui::Button("Select All Failing")) {
+        m_Application->SelectElements(quality->SelectFailing(*model));
+    }
+    
+    const QualityMetric shown = static_cast<QualityMetric>(m_QualityMetric);
+    const QualityHistogram& histogram = quality->GetHistogram(shown);
+    char overlay[96];
+    if (histogram.unbounded > 0) {
+        std::snprintf(overlay, sizeof(overlay), "%s, %.3g to %.3g, %zu unbounded", MeshQuality::GetName(shown),
+                      histogram.low, histogram.high, histogram.unbounded);
+    } else {
+        std::snprintf(overlay, sizeof(overlay), "%s, %.3g to %.3g", MeshQuality::GetName(shown), histogram.low,
+                      histogram.high);
+    }
+    ImGui::PlotHistogram("##Quality", histogram.bins.data(), static_cast<int>(histogram.bins.size()), 0, overlay,
+                         0.0f, FLT_MAX, ImVec2(-1.0f, 120.0f));
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawMergeNodes() {
+    if (!m_ShowMergeNodes) return;
+    Model* model = m_Application->GetModel();
+    
+    ImGui::Begin("Merge Nodes", &m_ShowMergeNodes, ImGuiWindowFlags_AlwaysAutoResize);
+    
+    if (!model || model->GetNodeCount() == 0) {
+        ImGui::Text("No nodes to merge");
+        ImGui::End();
+        return;
+    }
+    if (ImGui::InputFloat("Tolerance", &m_MergeTolerance, 0.0f, 0.0f, "%.6g")) {
+        m_MergeTolerance = std::max(m_MergeTolerance, 0.0f);
+        m_MergeFound = -1;
+    }
+    
+    if (ImGui::Button("Check")) {
+        size_t pairs = 0;
+        std::vector<uint32_t> targets = NodeMerger::FindTargets(*model, m_MergeTolerance, &pairs);
+        m_MergeFound = 0;
+        for (size_t n = 0; n < targets.size(); ++n) {
+            m_MergeFound += targets[n] != n ? 1 : 0;
+        }
+        m_MergeStatus = std::to_string(pairs) + " pairs within the tolerance";
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Merge")) {
+        NodeMergeResult result = m_Application->MergeNodes(m_MergeTolerance);
+        m_MergeFound = -1;
+        char status[128];
+        std::snprintf(status, sizeof(status), "Merged %zu nodes, %zu references rewritten in %.2f s",
+                      result.removedNodes, result.references, result.seconds);
+        m_MergeStatus = status;
+    }
+    
+    if (m_MergeFound >= 0) {
+        ImGui::Text("%lld of %zu nodes would be merged", m_MergeFound, model->GetNodeCount());
+    }
+    if (!m_MergeStatus.empty()) {
+        ImGui::TextDisabled("%s", m_MergeStatus.c_str());
+    }
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawApplicationLog() {
+    if (!m_ShowApplicationLog) return;
+    std::shared_ptr<RingLogSink> ring = Logger::GetRingSink();
+    
+    ImGui::SetNextWindowSize(ImVec2(700.0f, 300.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Application Log", &m_ShowApplicationLog);
+    
+    static const char* kLevels[] = {"Trace", "Debug", "Info", "Warn", "Error", "Critical"};
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::Combo("Level", &m_LogLevel, kLevels, IM_ARRAYSIZE(kLevels))) {
+        m_LogSeen = 0;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) {
+        ring->Clear();
+        m_LogSeen = 0;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Follow", &m_FollowApplicationLog);
+    ImGui::Separator();
+    
+    const uint64_t written = ring->GetWrittenCount();
+    if (m_LogSeen == 0 || written != m_LogSeen) {
+        m_LogEntries = ring->GetEntries();
+        m_LogEntries.erase(std::remove_if(m_LogEntries.begin(), m_LogEntries.end(),
+            [this](const LogEntry& entry) { return static_cast<int>(entry.level) < m_LogLevel; }),
+            m_LogEntries.end());
+        m_LogSeen = written;
+    }
+    
+    static const ImVec4 kColors[] = {
+        ImVec4(0.6f, 0.6f, 0.6f, 1.0f), ImVec4(0.4f, 0.8f, 0.9f, 1.0f), ImVec4(0.8f, 0.9f, 0.8f, 1.0f),
+        ImVec4(1.0f, 0.8f, 0.3f, 1.0f), ImVec4(1.0f, 0.4f, 0.4f, 1.0f), ImVec4(1.0f, 0.4f, 1.0f, 1.0f)
+    };
+    ImGui::BeginChild("##LogLines", ImVec2(0.0f, 0.0f), false, ImGuiWindowFlags_HorizontalScrollbar);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(m_LogEntries.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const LogEntry& entry = m_LogEntries[static_cast<size_t>(i)];
+            const std::string line = LogSink::FormatLine(entry);
+            ImGui::TextColored(kColors[static_cast<int>(entry.level)], "%s", line.c_str());
+        }
+    }
+    clipper.End();
+    if (m_FollowApplicationLog && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
+        ImGui::SetScrollHereY(1.0f);
+    }
+    ImGui::EndChild();
+    
+    ImGui::End();
+}
+
+void GuiManager::DrawStatistics() {
+    if (!m_ShowStatistics) return;
+    PROFILE_SCOPE("GuiManager::DrawStatistics");
+    
+    ImGui::SetNextWindowSize(ImVec2(520.0f, 600.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Statistics", &m_ShowStatistics);
+    
+    if (Model* model = m_Application->GetModel()) {
+        ImGui::Text("Nodes: %zu", model->GetNodeCount());
+        ImGui::SameLine();
+        ImGui::Text("Elements: %zu", model->GetElementCount());
+        ImGui::SameLine();
+        ImGui::Text("Materials: %zu", model->GetMaterialCount());
+        ImGui::Separator();
+    }
+    m_ProfilerPanel.Draw();
+    
+    ImGui::End();
+}
@@ -1,9 +1,14 @@
 #pragma once
+#include "gui/ProfilerPanel.h"
 #include <memory>
 #include <functional>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 struct GLFWwindow;
+struct JobSpec;
+struct LogEntry;
 class Application;
 
 class GuiManager {
@@ -23,11 +28,27 @@ public:
     void DrawPropertyPanel();
     void DrawStatusBar();
     void DrawSolverDialog();
+    void DrawLoadingDialog();
+    void DrawContourPanel();     // Fringe settings and legend, once results are open
+    void DrawSectionPanel();     // Clipping planes and caps, with a model open
+    void DrawSolverLog();        // Output of the current or last solver run
+    void DrawSolverProgress();   // Progress, ETA and charts of the engine's cycle rows
+    void ShowSolverProgress() { m_ShowSolverProgress = true; }
+    void DrawJobManager();       // Queued and running jobs, the core budget and throughput
+    void DrawDecompositionPreview();   // Balance of the model over a sweep of rank counts
+    void DrawTimeStepCheck();          // Stable step of the elements and the ones that set it
+    void DrawMeshQuality();            // Metric histograms, thresholds and failing elements
+    void DrawMergeNodes();             // Equivalencing of coincident nodes
+    void DrawApplicationLog();         // Recent messages of the application's own logger
+    void DrawStatistics();             // Model counts and the profiler's frame and pass timings
+    
+    // Whether the mouse is over a window, so the viewport should ignore it
+    bool WantsMouse() const;
     
     // Callbacks
     void SetFileOpenCallback(std::function<void(const std::string&)> callback);
     void SetFileSaveCallback(std::function<void(const std::string&)> callback);
-    void SetSolverRunCallback(std::function<void()> callback);
+    void SetSolverRunCallback(std::function<void(const JobSpec&)> callback);   // The dialog's settings
     
 private:
     void DrawFileDialog();
@@ -41,12 +62,46 @@ private:
     bool m_ShowFileDialog = false;
     bool m_ShowAboutDialog = false;
     bool m_ShowSolverDialog = false;
+    bool m_ShowSolverLog = false;
+    bool m_ShowSolverProgress = false;
+    bool m_ShowJobManager = false;
+    bool m_ShowDecomposition = false;
+    bool m_ShowTimeStep = false;
+    bool m_ShowMeshQuality = false;
+    bool m_ShowMergeNodes = false;
+    bool m_ShowApplicationLog = false;
+    bool m_ShowStatistics = false;
+    bool m_FollowSolverLog = true;   // Keeps the newest line in view
+    bool m_FollowApplicationLog = true;
     bool m_ShowPropertyPanel = true;
     
     // Callbacks
     std::function<void(const std::string&)> m_FileOpenCallback;
     std::function<void(const std::string&)> m_FileSaveCallback;
-    std::function<void()> m_SolverRunCallback;
+    std::function<void(const JobSpec&)> m_SolverRunCallback;
+    
+    // Decomposition sweep: powers of two in a range, and one more count
+    int m_SweepMinRanks = 8;
+    int m_SweepMaxRanks = 256;
+    int m_SweepExtraRanks = 0;
+    int m_SweepSelected = -1;   // Row shown domain by domain
+    
+    // Mesh quality: metric charted, and part evaluated again on its own
+    int m_QualityMetric = 0;
+    int m_QualityPart = 0;
+    
+    // Node merge: tolerance, and what the last check or merge found
+    float m_MergeTolerance = 1e-3f;
+    long long m_MergeFound = -1;   // Nodes that would go; -1 before a check
+    std::string m_MergeStatus;
+    
+    // Application log: entries at or above the level shown, copied from
+    // the logger's ring when it has written more
+    std::vector<LogEntry> m_LogEntries;
+    uint64_t m_LogSeen = 0;
+    int m_LogLevel = 0;
+    
+    ProfilerPanel m_ProfilerPanel;
     
     // File dialog
     std::string m_CurrentPath;
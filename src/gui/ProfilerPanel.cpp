@@ -0,0 +1,91 @@
+#include "gui/ProfilerPanel.h"
+#include "utils/Profiler.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const float kGraphHeight = 36.0f;
+
+void DrawSeries(const ProfileSeries& series, const char* unit) {
+    if (series.history.empty()) return;
+    char overlay[96];
+    std::snprintf(overlay, sizeof(overlay), "%.3g %s (avg %.3g, peak %.3g)",
+                  series.last, unit, series.average, series.peak);
+    ImGui::PushID(series.name.c_str());
+    ImGui::PlotLines("##Graph", series.history.data(), static_cast<int>(series.history.size()), 0, overlay,
+                     0.0f, std::max(series.peak * 1.1f, 1e-6f), ImVec2(-160.0f, kGraphHeight));
+    ImGui::SameLine();
+    ImGui::TextUnformatted(series.name.c_str());
+    ImGui::PopID();
+}
+
+} // namespace
+
+void ProfilerPanel::Draw() {
+    Profiler& profiler = Profiler::Get();
+    bool enabled = Profiler::IsEnabled();
+    if (ImGui::Checkbox("Profile", &enabled)) {
+        Profiler::SetEnabled(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        profiler.Reset();
+    }
+    
+    const std::vector<ProfileSeries> series = profiler.GetSeries();
+    for (const ProfileSeries& s : series) {
+        if (s.kind == ProfileSeries::Kind::CPU && s.name == "Frame" && s.average > 0.0f) {
+            ImGui::SameLine();
+            ImGui::Text("%.2f ms a frame (%.0f fps)", s.average, 1000.0f / s.average);
+        }
+    }
+    
+    const struct {
+        const char* title;
+        ProfileSeries::Kind kind;
+        const char* unit;
+    } kGroups[] = {
+        {"CPU", ProfileSeries::Kind::CPU, "ms"},
+        {"GPU", ProfileSeries::Kind::GPU, "ms"},
+        {"Counters", ProfileSeries::Kind::COUNTER, ""},
+    };
+    for (const auto& group : kGroups) {
+        if (!ImGui::CollapsingHeader(group.title, ImGuiTreeNodeFlags_DefaultOpen)) continue;
+        for (const ProfileSeries& s : series) {
+            if (s.kind == group.kind) {
+                DrawSeries(s, group.unit);
+            }
+        }
+    }
+    
+    // A whole load-and-render session, for chrome://tracing or Perfetto
+    if (ImGui::CollapsingHeader("Trace Capture")) {
+        ImGui::InputText("File", m_TracePath, sizeof(m_TracePath));
+        if (!profiler.IsCapturing()) {
+            if (ImGui::Button("Start Capture")) {
+                profiler.StartCapture();
+                m_Status.clear();
+            }
+        } else {
+            if (ImGui::Button("Stop and Save")) {
+                profiler.StopCapture();
+                char status[320];
+                if (profiler.WriteChromeTrace(m_TracePath)) {
+                    std::snprintf(status, sizeof(status), "%zu events written to %s",
+                                  profiler.GetCapturedEventCount(), m_TracePath);
+                } else {
+                    std::snprintf(status, sizeof(status), "Cannot write %s", m_TracePath);
+                }
+                m_Status = status;
+            }
+            ImGui::SameLine();
+            ImGui::Text("%zu events", profiler.GetCapturedEventCount());
+        }
+        if (!m_Status.empty()) {
+            ImGui::TextDisabled("%s", m_Status.c_str());
+        }
+    }
+}
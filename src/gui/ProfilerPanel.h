@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+// Rolling graphs of the Profiler's CPU scopes, GPU passes and counters,
+// and a trace capture to Chrome's JSON format, for a Statistics window.
+// Draws into the current ImGui window.
+class ProfilerPanel {
+public:
+    void Draw();
+
+private:
+    char m_TracePath[256] = "profile_trace.json";
+    std::string m_Status;
+};
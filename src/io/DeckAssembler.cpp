@@ -0,0 +1,318 @@
+#include "io/DeckAssembler.h"
+#include "io/FileManager.h"
+#include "io/MappedFile.h"
+#include "io/ModelCache.h"
+#include "io/RadFileReader.h"
+#include "core/Model.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <limits>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string CanonicalPath(const fs::path& path) {
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    return (ec ? path.lexically_normal() : canonical).string();
+}
+
+bool StartsWithInclude(std::string_view line) {
+    static const char kDirective[] = "#include";
+    const size_t length = sizeof(kDirective) - 1;
+    if (line.size() < length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) != kDirective[i]) {
+            return false;
+        }
+    }
+    return line.size() == length || std::isspace(static_cast<unsigned char>(line[length]));
+}
+
+bool VisitDeck(const std::string& path, int parent, std::vector<DeckFile>& files,
+               std::vector<std::string>& chain, std::string& error) {
+    if (std::find(chain.begin(), chain.end(), path) != chain.end()) {
+        error = "Include cycle through " + path;
+        return false;
+    }
+    for (const DeckFile& file : files) {
+        if (file.path == path) {
+            LOG_WARN("Ignoring repeated include of {}", path);
+            return true;
+        }
+    }
+
+    MappedFile mapped;
+    if (!mapped.Open(path)) {
+        error = parent < 0 ? "Cannot open file: " + path
+                           : "Cannot open included file: " + path + " (from " + files[parent].path + ")";
+        return false;
+    }
+
+    int index = static_cast<int>(files.size());
+    files.push_back({path, parent});
+
+    std::vector<std::string> includes = DeckAssembler::FindIncludeLines(mapped.View());
+    mapped.Close();
+
+    // Include paths are relative to the file that names them
+    fs::path directory = fs::path(path).parent_path();
+    chain.push_back(path);
+    for (const std::string& include : includes) {
+        fs::path target = fs::path(include);
+        if (target.is_relative()) {
+            target = directory / target;
+        }
+        if (!VisitDeck(CanonicalPath(target), index, files, chain, error)) {
+            return false;
+        }
+    }
+    chain.pop_back();
+    return true;
+}
+
+// Highest ID of each kind merged so far, for renumbering on conflict
+struct IdCeiling {
+    int node = 0;
+    int element = 0;
+    int material = 0;
+};
+
+IdOffsets FindConflictOffsets(const Model& fragment, const Model& merged, const IdCeiling& ceiling) {
+    IdOffsets offsets;
+
+    auto shiftFor = [](size_t count, auto idOf, int highest, auto existsInMerged) {
+        if (count == 0) {
+            return 0;
+        }
+        int lowest = std::numeric_limits<int>::max();
+        bool conflict = false;
+        for (size_t i = 0; i < count; ++i) {
+            int id = idOf(i);
+            lowest = std::min(lowest, id);
+            conflict = conflict || existsInMerged(id);
+        }
+        return conflict ? std::max(0, highest - lowest + 1) : 0;
+    };
+
+    const auto& nodeIds = fragment.GetNodeIds();
+    const auto& elementIds = fragment.GetElementIds();
+    const auto& materials = fragment.GetMaterials();
+    offsets.node = shiftFor(nodeIds.size(), [&](size_t i) { return nodeIds[i]; }, ceiling.node,
+                            [&](int id) { return merged.HasNode(id); });
+    offsets.element = shiftFor(elementIds.size(), [&](size_t i) { return elementIds[i]; }, ceiling.element,
+                               [&](int id) { return merged.HasElement(id); });
+    offsets.material = shiftFor(materials.size(), [&](size_t i) { return materials[i].id; }, ceiling.material,
+                                [&](int id) { return merged.GetMaterial(id) != nullptr; });
+    return offsets;
+}
+
+// Appends a fragment to the model. References to entities of the fragment
+// itself are shifted with them; references to other files are kept.
+size_t MergeFragment(const Model& fragment, const IdOffsets& offsets, Model& model, IdCeiling& ceiling) {
+    size_t duplicates = 0;
+
+    model.ReserveNodes(model.GetNodeCount() + fragment.GetNodeCount());
+    const auto& nodeIds = fragment.GetNodeIds();
+    const auto& positions = fragment.GetNodePositions();
+    const auto& fixity = fragment.GetNodeFixity();
+    for (size_t i = 0; i < nodeIds.size(); ++i) {
+        int id = nodeIds[i] + offsets.node;
+        duplicates += model.HasNode(id);
+        ceiling.node = std::max(ceiling.node, id);
+        model.AddNode(id, positions[i], fixity[i]);
+    }
+
+    for (Material material : fragment.GetMaterials()) {
+        material.id += offsets.material;
+        duplicates += model.GetMaterial(material.id) != nullptr;
+        ceiling.material = std::max(ceiling.material, material.id);
+        model.AddMaterial(material);
+    }
+
+    model.ReserveElements(model.GetElementCount() + fragment.GetElementCount(),
+                          model.GetElementArrays().nodeIds.size() +
+                          fragment.GetElementArrays().nodeIds.size());
+    std::vector<int> shiftedNodes;
+    fragment.ForEachElement([&](size_t, ElementView element) {
+        element.id += offsets.element;
+        if (offsets.node != 0) {
+            shiftedNodes.assign(element.nodeIds.begin(), element.nodeIds.end());
+            for (int& nodeId : shiftedNodes) {
+                if (fragment.HasNode(nodeId)) {
+                    nodeId += offsets.node;
+                }
+            }
+            element.nodeIds = NodeIdSpan(shiftedNodes);
+        }
+        if (offsets.material != 0 && fragment.GetMaterial(element.materialId)) {
+            element.materialId += offsets.material;
+        }
+        duplicates += model.HasElement(element.id);
+        ceiling.element = std::max(ceiling.element, element.id);
+        model.AddElement(element);
+    });
+
+    return duplicates;
+}
+
+} // namespace
+
+std::vector<std::string> DeckAssembler::FindIncludeLines(std::string_view data) {
+    std::vector<std::string> includes;
+
+    for (size_t pos = data.find('#'); pos != std::string_view::npos; pos = data.find('#', pos + 1)) {
+        if (pos > 0 && data[pos - 1] != '\n') {
+            continue;
+        }
+
+        size_t end = data.find('\n', pos);
+        std::string_view line = data.substr(pos, end == std::string_view::npos ? end : end - pos);
+        if (!StartsWithInclude(line)) {
+            continue;
+        }
+
+        std::string_view name = line.substr(8);
+        while (!name.empty() && std::isspace(static_cast<unsigned char>(name.front()))) {
+            name.remove_prefix(1);
+        }
+        while (!name.empty() && std::isspace(static_cast<unsigned char>(name.back()))) {
+            name.remove_suffix(1);
+        }
+        if (name.size() >= 2 && (name.front() == '"' || name.front() == '\'') &&
+            name.back() == name.front()) {
+            name = name.substr(1, name.size() - 2);
+        }
+        if (!name.empty()) {
+            includes.emplace_back(name);
+        }
+    }
+
+    return includes;
+}
+
+bool DeckAssembler::FindIncludeTree(const std::string& masterPath, std::vector<DeckFile>& files,
+                                    std::string& error) {
+    files.clear();
+    std::vector<std::string> chain;
+    return VisitDeck(CanonicalPath(masterPath), -1, files, chain, error);
+}
+
+void DeckAssembler::SetOffsets(const std::string& path, const IdOffsets& offsets) {
+    m_Offsets[CanonicalPath(path)] = offsets;
+}
+
+bool DeckAssembler::IsCancelled() const {
+    return m_Progress && m_Progress->cancelRequested.load();
+}
+
+bool DeckAssembler::LoadFile(const std::string& path, Model& fragment, std::string& error) const {
+    if (ModelCache::Load(path, fragment, ModelCache::Kind::FRAGMENT)) {
+        return true;
+    }
+
+    OpenRadiossGUI::RadFileReader reader;
+    if (!reader.loadFragment(path)) {
+        error = path + ": " + reader.getLastError();
+        return false;
+    }
+
+    FileManager::AddNodes(reader.getNodes(), fragment);
+    FileManager::AddElements(reader.getElements(), 0, reader.getElementCount(), fragment);
+    FileManager::AddMaterials(reader, fragment);
+    ModelCache::Save(path, fragment, ModelCache::Kind::FRAGMENT);
+    return true;
+}
+
+bool DeckAssembler::Load(const std::vector<DeckFile>& files, Model& model) {
+    m_Error.clear();
+
+    if (m_Progress) {
+        size_t total = 0;
+        for (const DeckFile& file : files) {
+            std::error_code ec;
+            uintmax_t size = fs::file_size(file.path, ec);
+            total += ec ? 0 : static_cast<size_t>(size);
+        }
+        m_Progress->bytesTotal = total;
+    }
+
+    // Every file is parsed independently; each parse spreads over the pool
+    // itself, so large and small files mix without idle workers
+    std::vector<Model> fragments(files.size());
+    std::vector<std::string> errors(files.size());
+    std::vector<char> loaded(files.size(), 0);
+
+    ThreadPool::GetGlobal().ParallelFor(files.size(), 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            if (IsCancelled()) {
+                continue;
+            }
+            loaded[i] = LoadFile(files[i].path, fragments[i], errors[i]);
+
+            if (m_Progress) {
+                std::error_code ec;
+                uintmax_t size = fs::file_size(files[i].path, ec);
+                m_Progress->bytesParsed += ec ? 0 : static_cast<size_t>(size);
+                m_Progress->nodesParsed += fragments[i].GetNodeCount();
+                m_Progress->elementsParsed += fragments[i].GetElementCount();
+            }
+        }
+    });
+
+    if (IsCancelled()) {
+        m_Error = "Loading cancelled";
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!loaded[i]) {
+            m_Error = errors[i];
+            return false;
+        }
+    }
+
+    // Merge in tree order
+    model.Clear();
+    IdCeiling ceiling;
+    size_t duplicates = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        IdOffsets offsets;
+        auto it = m_Offsets.find(files[i].path);
+        if (it != m_Offsets.end()) {
+            offsets = it->second;
+        } else if (m_RenumberOnConflict) {
+            offsets = FindConflictOffsets(fragments[i], model, ceiling);
+        }
+        if (offsets.node || offsets.element || offsets.material) {
+            LOG_INFO("Renumbering {}: nodes +{}, elements +{}, materials +{}",
+                     files[i].path, offsets.node, offsets.element, offsets.material);
+        }
+
+        duplicates += MergeFragment(fragments[i], offsets, model, ceiling);
+        fragments[i] = Model();
+    }
+
+    if (duplicates > 0) {
+        LOG_WARN("{} IDs are defined in more than one file; later files win", duplicates);
+    }
+
+    // Node references could only be checked once every file is merged
+    size_t missing = model.BuildLookups();
+    if (missing > 0) {
+        m_Error = "File validation failed: " + std::to_string(missing) +
+                  " element node references are not defined in any file";
+        model.Clear();
+        return false;
+    }
+
+    model.CalculateBounds();
+    LOG_INFO("Assembled {} files: {} nodes, {} elements", files.size(),
+             model.GetNodeCount(), model.GetElementCount());
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Model;
+
+namespace OpenRadiossGUI {
+struct LoadProgress;
+}
+
+// One file of an include tree
+struct DeckFile {
+    std::string path;   // Canonical path
+    int parent = -1;    // Index of the including file, -1 for the master deck
+};
+
+// Shift applied to the IDs a sub-deck defines, and to its references to them
+struct IdOffsets {
+    int node = 0;
+    int element = 0;
+    int material = 0;
+};
+
+// Loads a master deck together with the files it pulls in through
+// "#include" lines. The include tree is resolved first; every file is then
+// parsed on its own, concurrently, and reuses its own .radc snapshot when
+// unchanged, so editing one part only re-parses that part. Files merge into
+// the model in tree order, which does not depend on parse timing.
+class DeckAssembler {
+public:
+    // Lists masterPath and everything it includes, depth-first: each file
+    // comes before the files it includes, those in the order they appear.
+    static bool FindIncludeTree(const std::string& masterPath, std::vector<DeckFile>& files,
+                                std::string& error);
+    static std::vector<std::string> FindIncludeLines(std::string_view data);
+
+    void SetProgress(OpenRadiossGUI::LoadProgress* progress) { m_Progress = progress; }
+
+    // Fixed offsets for one file of the tree
+    void SetOffsets(const std::string& path, const IdOffsets& offsets);
+
+    // Moves the IDs of a file whose nodes, elements or materials collide with
+    // ones already merged to just above the highest ID merged so far
+    void SetRenumberOnConflict(bool enabled) { m_RenumberOnConflict = enabled; }
+
+    bool Load(const std::vector<DeckFile>& files, Model& model);
+    const std::string& GetError() const { return m_Error; }
+
+private:
+    bool LoadFile(const std::string& path, Model& fragment, std::string& error) const;
+    bool IsCancelled() const;
+
+private:
+    OpenRadiossGUI::LoadProgress* m_Progress = nullptr;
+    std::unordered_map<std::string, IdOffsets> m_Offsets;
+    bool m_RenumberOnConflict = false;
+    std::string m_Error;
+};
@@ -1,23 +1,74 @@
 #include "io/FileManager.h"
 #include "io/RadFileReader.h"
 #include "io/RadFileWriter.h"
+#include "io/ModelCache.h"
+#include "io/DeckAssembler.h"
+#include "io/MeshExporter.h"
 #include "core/Model.h"
 #include "utils/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace {
+
+ElementType ConvertElementType(OpenRadiossGUI::Element::Type type) {
+    switch (type) {
+        case OpenRadiossGUI::Element::TRIA3:  return ElementType::SHELL3;
+        case OpenRadiossGUI::Element::QUAD4:  return ElementType::SHELL4;
+        case OpenRadiossGUI::Element::TETRA4: return ElementType::TETRA4;
+        case OpenRadiossGUI::Element::HEXA8:  return ElementType::HEXA8;
+        default:                              return ElementType::UNKNOWN;
+    }
+}
+
+} // namespace
 
 FileManager::FileManager(Model* model) 
     : m_Model(model) {
 }
 
 bool FileManager::LoadRadFile(const std::string& filepath) {
-    RadFileReader reader(m_Model);
+    std::vector<DeckFile> files;
+    std::string error;
+    if (!DeckAssembler::FindIncludeTree(filepath, files, error)) {
+        LOG_ERROR("Failed to read {}: {}", filepath, error);
+        return false;
+    }
     
-    if (reader.Read(filepath)) {
+    // Snapshots are per file, so a deck with includes is always assembled
+    if (files.size() > 1) {
+        DeckAssembler assembler;
+        if (!assembler.Load(files, *m_Model)) {
+            LOG_ERROR("Failed to read {}: {}", filepath, assembler.GetError());
+            return false;
+        }
         m_CurrentFile = filepath;
-        m_Model->CalculateBounds();
         return true;
     }
     
-    return false;
+    if (ModelCache::Load(filepath, *m_Model)) {
+        m_CurrentFile = filepath;
+        return true;
+    }
+    
+    OpenRadiossGUI::RadFileReader reader;
+    
+    if (!reader.loadFile(filepath)) {
+        LOG_ERROR("Failed to read {}: {}", filepath, reader.getLastError());
+        return false;
+    }
+    
+    m_Model->Clear();
+    AddNodes(reader.getNodes(), *m_Model);
+    AddElements(reader.getElements(), 0, reader.getElementCount(), *m_Model);
+    AddMaterials(reader, *m_Model);
+    m_Model->BuildLookups();
+    m_Model->CalculateBounds();
+    ModelCache::Save(filepath, *m_Model);
+    
+    m_CurrentFile = filepath;
+    return true;
 }
 
 bool FileManager::SaveRadFile(const std::string& filepath) {
@@ -32,15 +83,66 @@ bool FileManager::SaveRadFile(const std::string& filepath) {
 }
 
 bool FileManager::ExportToSTL(const std::string& filepath) {
-    // Implementation for STL export
     LOG_INFO("Exporting to STL: {}", filepath);
-    // TODO: Implement STL export
-    return false;
+    return MeshExporter::WriteSTL(*m_Model, filepath);
 }
 
 bool FileManager::ExportToVTK(const std::string& filepath) {
-    // Implementation for VTK export
     LOG_INFO("Exporting to VTK: {}", filepath);
-    // TODO: Implement VTK export
-    return false;
+    
+    // .vtu gets the XML format, anything else the legacy binary one
+    std::string extension = std::filesystem::path(filepath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == ".vtu") {
+        auto compression = MeshExporter::IsCompressionAvailable()
+            ? MeshExporter::Compression::ZLIB : MeshExporter::Compression::NONE;
+        return MeshExporter::WriteVTU(*m_Model, filepath, compression);
+    }
+    return MeshExporter::WriteLegacyVTK(*m_Model, filepath);
+}
+
+void FileManager::AddNodes(const std::vector<OpenRadiossGUI::Node>& nodes, Model& model) {
+    model.ReserveNodes(model.GetNodeCount() + nodes.size());
+    for (const auto& source : nodes) {
+        model.AddNode(source.id, source.position);
+    }
+}
+
+void FileManager::AddElements(const std::vector<OpenRadiossGUI::Element>& elements,
+                              size_t first, size_t count, Model& model) {
+    size_t nodeIdCount = 0;
+    for (size_t i = first; i < first + count; ++i) {
+        nodeIdCount += elements[i].nodeIds.size();
+    }
+    model.ReserveElements(model.GetElementCount() + count,
+                          model.GetElementArrays().nodeIds.size() + nodeIdCount);
+    
+    // The view borrows the reader's connectivity; AddElement copies it once
+    for (size_t i = first; i < first + count; ++i) {
+        const auto& source = elements[i];
+        
+        ElementView element;
+        element.id = source.id;
+        element.type = ConvertElementType(source.type);
+        element.nodeIds = NodeIdSpan(source.nodeIds.data(), source.nodeIds.size());
+        element.materialId = source.materialId;
+        element.propertyId = source.propertyId;
+        model.AddElement(element);
+    }
+}
+
+void FileManager::AddMaterials(const OpenRadiossGUI::RadFileReader& reader, Model& model) {
+    for (const auto& source : reader.getMaterials()) {
+        Material material;
+        material.id = source.id;
+        material.name = source.name;
+        material.SetType(Material::TypeFromLaw(source.type));
+        
+        // Keys are interned process-wide, so values carry over by key
+        source.properties.ForEach([&](ParameterKey key, double value) {
+            material.parameters.Set(key, value);
+        });
+        model.AddMaterial(material);
+    }
 }
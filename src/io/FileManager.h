@@ -1,9 +1,16 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
 
 class Model;
 
+namespace OpenRadiossGUI {
+class RadFileReader;
+struct Node;
+struct Element;
+}
+
 class FileManager {
 public:
     FileManager(Model* model);
@@ -22,6 +29,14 @@ public:
     bool ImportFromAbaqus(const std::string& filepath);
     
     std::string GetCurrentFile() const { return m_CurrentFile; }
+    void SetCurrentFile(const std::string& filepath) { m_CurrentFile = filepath; }
+    
+    // Conversion from reader entities into a model. Shared with ModelLoader,
+    // which calls them from its worker thread while a file streams in.
+    static void AddNodes(const std::vector<OpenRadiossGUI::Node>& nodes, Model& model);
+    static void AddElements(const std::vector<OpenRadiossGUI::Element>& elements,
+                            size_t first, size_t count, Model& model);
+    static void AddMaterials(const OpenRadiossGUI::RadFileReader& reader, Model& model);
     
 private:
     Model* m_Model;
@@ -0,0 +1,134 @@
+#include "io/FixedFieldDecoder.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define RADFILE_HAS_SSE2 1
+#endif
+
+namespace OpenRadiossGUI {
+
+namespace {
+
+bool isIntegerChar(char c) {
+    return (c >= '0' && c <= '9') || c == ' ' || c == '-' || c == '+';
+}
+
+bool isNumericChar(char c) {
+    return isIntegerChar(c) || c == '.' || c == 'e' || c == 'E';
+}
+
+#ifdef RADFILE_HAS_SSE2
+// Mask of bytes that are ASCII digits, blanks or signs
+__m128i integerMask(__m128i bytes) {
+    __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+    __m128i digits = _mm_cmpeq_epi8(_mm_max_epu8(offset, _mm_set1_epi8(9)), _mm_set1_epi8(9));
+    __m128i mask = _mm_or_si128(digits, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('-')));
+    return _mm_or_si128(mask, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('+')));
+}
+
+__m128i numericMask(__m128i bytes) {
+    __m128i mask = _mm_or_si128(integerMask(bytes), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('e')));
+    return _mm_or_si128(mask, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('E')));
+}
+#endif
+
+template<bool Numeric>
+bool allCharsIn(std::string_view line) {
+    const char* data = line.data();
+    size_t size = line.size();
+    size_t i = 0;
+    
+#ifdef RADFILE_HAS_SSE2
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i mask = Numeric ? numericMask(bytes) : integerMask(bytes);
+        if (_mm_movemask_epi8(mask) != 0xFFFF) {
+            return false;
+        }
+    }
+#endif
+    
+    for (; i < size; ++i) {
+        if (!(Numeric ? isNumericChar(data[i]) : isIntegerChar(data[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Trims blanks; false when blanks remain inside, i.e. the field holds two values
+bool trimField(std::string_view field, std::string_view& value) {
+    size_t begin = 0;
+    size_t end = field.size();
+    while (begin < end && field[begin] == ' ') ++begin;
+    while (end > begin && field[end - 1] == ' ') --end;
+    
+    value = field.substr(begin, end - begin);
+    return value.find(' ') == std::string_view::npos;
+}
+
+} // namespace
+
+bool isIntegerLine(std::string_view line) {
+    return allCharsIn<false>(line);
+}
+
+bool isNumericLine(std::string_view line) {
+    return allCharsIn<true>(line);
+}
+
+bool splitFixedFields(std::string_view line, const FieldLayout& layout,
+                      std::vector<std::string_view>& fields) {
+    fields.clear();
+    
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.remove_suffix(1);
+    }
+    if (line.size() <= layout.minimumWidth() - layout.widths[layout.count - 1]) {
+        return false; // Last fixed field would be missing
+    }
+    
+    bool wellFormed = layout.integersOnly ? isIntegerLine(line) : isNumericLine(line);
+    if (!wellFormed) {
+        return false;
+    }
+    
+    size_t offset = 0;
+    size_t index = 0;
+    size_t lastValue = 0;
+    while (offset < line.size()) {
+        size_t width;
+        if (index < layout.count) {
+            width = layout.widths[index];
+        } else if (layout.repeatWidth != 0) {
+            width = layout.repeatWidth;
+        } else {
+            return false; // Text past the last field
+        }
+        
+        std::string_view value;
+        if (!trimField(line.substr(offset, width), value)) {
+            return false;
+        }
+        fields.push_back(value);
+        if (!value.empty()) {
+            lastValue = fields.size();
+        }
+        
+        offset += width;
+        ++index;
+    }
+    
+    // Interior blank fields have no whitespace-format equivalent
+    fields.resize(lastValue);
+    for (const auto& field : fields) {
+        if (field.empty()) {
+            return false;
+        }
+    }
+    return fields.size() >= layout.count;
+}
+
+} // namespace OpenRadiossGUI
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace OpenRadiossGUI {
+
+// Column layout of a fixed-format Radioss data card. The first count fields
+// use widths[]; when repeatWidth is non-zero the rest of the line is split
+// into further fields of that width (e.g. element connectivity).
+struct FieldLayout {
+    uint8_t widths[8];
+    size_t count;
+    uint8_t repeatWidth;
+    bool integersOnly;
+    
+    // Narrowest line that holds every fixed field
+    size_t minimumWidth() const {
+        size_t width = 0;
+        for (size_t i = 0; i < count; ++i) width += widths[i];
+        return width;
+    }
+};
+
+// /NODE: I10 node ID followed by three F20 coordinates
+constexpr FieldLayout kNodeLayout = {{10, 20, 20, 20}, 4, 0, false};
+
+// Element cards (/SHELL, /SH3N, /BRICK, /TETRA4, ...): I10 integers
+constexpr FieldLayout kElementLayout = {{10}, 1, 10, true};
+
+// Character-class checks over a whole line, 16 bytes at a time where SSE2 is
+// available. Integer lines hold only digits, signs and blanks; numeric lines
+// may also contain '.', 'e' and 'E'.
+bool isIntegerLine(std::string_view line);
+bool isNumericLine(std::string_view line);
+
+// Splits line at the layout's column boundaries into trimmed views of the
+// fields. Succeeds only when the line is numeric, long enough for the fixed
+// fields, and every field holds exactly one value; callers fall back to
+// whitespace tokenization otherwise. Trailing blank fields are dropped.
+bool splitFixedFields(std::string_view line, const FieldLayout& layout,
+                      std::vector<std::string_view>& fields);
+
+} // namespace OpenRadiossGUI
@@ -0,0 +1,150 @@
+#include "io/ImageWriter.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+#ifdef HAS_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace {
+
+constexpr size_t kStoredBlock = 65535;   // Largest uncompressed deflate block
+
+const std::array<uint32_t, 256>& CrcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    return table;
+}
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    const std::array<uint32_t, 256>& table = CrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void AppendBigEndian(std::string& out, uint32_t value) {
+    out += static_cast<char>(value >> 24);
+    out += static_cast<char>(value >> 16);
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value);
+}
+
+void AppendChunk(std::string& out, const char* type, const uint8_t* data, size_t size) {
+    AppendBigEndian(out, static_cast<uint32_t>(size));
+    const size_t typeOffset = out.size();
+    out.append(type, 4);
+    if (size) {
+        out.append(reinterpret_cast<const char*>(data), size);
+    }
+    AppendBigEndian(out, Crc32(reinterpret_cast<const uint8_t*>(out.data() + typeOffset), size + 4));
+}
+
+// zlib stream of stored blocks, for builds without zlib
+std::vector<uint8_t> StoreUncompressed(const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> out;
+    out.reserve(raw.size() + raw.size() / kStoredBlock * 5 + 16);
+    out.push_back(0x78);
+    out.push_back(0x01);
+    uint32_t a = 1, b = 0;
+    size_t offset = 0;
+    do {
+        const size_t size = std::min(kStoredBlock, raw.size() - offset);
+        const bool last = offset + size == raw.size();
+        out.push_back(last ? 1 : 0);
+        out.push_back(static_cast<uint8_t>(size));
+        out.push_back(static_cast<uint8_t>(size >> 8));
+        out.push_back(static_cast<uint8_t>(~size));
+        out.push_back(static_cast<uint8_t>(~size >> 8));
+        out.insert(out.end(), raw.begin() + offset, raw.begin() + offset + size);
+        for (size_t i = offset; i < offset + size; ++i) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        offset += size;
+    } while (offset < raw.size());
+    const uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(adler >> shift));
+    }
+    return out;
+}
+
+} // namespace
+
+std::string ImageWriter::EncodePNG(int width, int height, const uint8_t* rgba, bool bottomUp) {
+    // Rows of RGB, each after the Up filter's type byte: rendered images
+    // are mostly flat, so differences to the row above deflate well
+    const size_t rowBytes = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw(static_cast<size_t>(height) * (rowBytes + 1));
+    std::vector<uint8_t> previous(rowBytes, 0), current(rowBytes);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* source = rgba + static_cast<size_t>(bottomUp ? height - 1 - y : y) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            current[x * 3] = source[x * 4];
+            current[x * 3 + 1] = source[x * 4 + 1];
+            current[x * 3 + 2] = source[x * 4 + 2];
+        }
+        uint8_t* row = raw.data() + static_cast<size_t>(y) * (rowBytes + 1);
+        row[0] = 2;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            row[i + 1] = static_cast<uint8_t>(current[i] - previous[i]);
+        }
+        previous.swap(current);
+    }
+
+#ifdef HAS_ZLIB
+    uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, raw.data(), static_cast<uLong>(raw.size()),
+                  Z_DEFAULT_COMPRESSION) == Z_OK) {
+        compressed.resize(compressedSize);
+    } else {
+        compressed = StoreUncompressed(raw);
+    }
+#else
+    std::vector<uint8_t> compressed = StoreUncompressed(raw);
+#endif
+
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+    uint8_t header[13] = {};
+    for (int i = 0; i < 4; ++i) {
+        header[i] = static_cast<uint8_t>(static_cast<uint32_t>(width) >> (24 - 8 * i));
+        header[4 + i] = static_cast<uint8_t>(static_cast<uint32_t>(height) >> (24 - 8 * i));
+    }
+    header[8] = 8;    // Bits per channel
+    header[9] = 2;    // RGB
+    AppendChunk(png, "IHDR", header, sizeof(header));
+    AppendChunk(png, "IDAT", compressed.data(), compressed.size());
+    AppendChunk(png, "IEND", nullptr, 0);
+    return png;
+}
+
+bool ImageWriter::WritePNG(const std::string& filepath, int width, int height,
+                           const uint8_t* rgba, bool bottomUp) {
+    if (width <= 0 || height <= 0 || !rgba) {
+        LOG_ERROR("Cannot write an empty image to {}", filepath);
+        return false;
+    }
+    const std::string png = EncodePNG(width, height, rgba, bottomUp);
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file || !file.write(png.data(), static_cast<std::streamsize>(png.size()))) {
+        LOG_ERROR("Failed to write {}", filepath);
+        return false;
+    }
+    return true;
+}
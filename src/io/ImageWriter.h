@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Image files for reports. Encoding is self-contained and thread-safe, so
+// several images can be written from the thread pool at once.
+class ImageWriter {
+public:
+    // 8-bit RGB PNG from tightly packed RGBA pixels, alpha dropped. Rows
+    // may come bottom up, as glReadPixels returns them. Deflated with zlib
+    // when built with it, otherwise stored uncompressed.
+    static bool WritePNG(const std::string& filepath, int width, int height,
+                         const uint8_t* rgba, bool bottomUp);
+    
+    // The PNG file contents, for callers that write elsewhere
+    static std::string EncodePNG(int width, int height, const uint8_t* rgba, bool bottomUp);
+};
@@ -0,0 +1,138 @@
+#include "io/MappedFile.h"
+#include <fstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filepath) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_Size == 0) {
+        CloseHandle(file);
+        m_Data = "";
+        m_IsOpen = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        m_MappedData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_MappedData) {
+            m_FileHandle = file;
+            m_MappingHandle = mapping;
+            m_Data = static_cast<const char*>(m_MappedData);
+            m_IsOpen = true;
+            return true;
+        }
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_Size = static_cast<size_t>(st.st_size);
+    if (m_Size == 0) {
+        ::close(fd);
+        m_Data = "";
+        m_IsOpen = true;
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps its own reference to the file
+
+    if (mapped != MAP_FAILED) {
+        m_MappedData = mapped;
+        m_Data = static_cast<const char*>(mapped);
+        m_IsOpen = true;
+        return true;
+    }
+#endif
+
+    // Mapping not possible (pipes, some network file systems): read it instead
+    return ReadIntoBuffer(filepath);
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (m_MappedData) UnmapViewOfFile(m_MappedData);
+    if (m_MappingHandle) CloseHandle(m_MappingHandle);
+    if (m_FileHandle) CloseHandle(m_FileHandle);
+    m_MappingHandle = nullptr;
+    m_FileHandle = nullptr;
+#else
+    if (m_MappedData) munmap(m_MappedData, m_Size);
+#endif
+
+    m_MappedData = nullptr;
+    m_Data = nullptr;
+    m_Size = 0;
+    m_IsOpen = false;
+    m_Buffer.clear();
+    m_Buffer.shrink_to_fit();
+}
+
+void MappedFile::AdviseSequential() const {
+#ifndef _WIN32
+    if (m_MappedData) {
+        madvise(m_MappedData, m_Size, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+bool MappedFile::ReadIntoBuffer(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::streamsize size = file.tellg();
+    if (size < 0) {
+        return false;
+    }
+    file.seekg(0, std::ios::beg);
+
+    m_Buffer.resize(static_cast<size_t>(size));
+    if (size > 0 && !file.read(&m_Buffer[0], size)) {
+        m_Buffer.clear();
+        return false;
+    }
+
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+    m_IsOpen = true;
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. Uses mmap/MapViewOfFile when possible and
+// falls back to reading the file into memory, so callers always get one
+// contiguous buffer regardless of platform.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filepath);
+    void Close();
+
+    bool IsOpen() const { return m_IsOpen; }
+    bool IsMapped() const { return m_MappedData != nullptr; }
+
+    const char* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+    std::string_view View() const { return std::string_view(m_Data, m_Size); }
+
+    // Hint that the view will be walked front to back
+    void AdviseSequential() const;
+
+private:
+    bool ReadIntoBuffer(const std::string& filepath);
+
+private:
+    const char* m_Data = nullptr;
+    size_t m_Size = 0;
+    bool m_IsOpen = false;
+
+    void* m_MappedData = nullptr;
+#ifdef _WIN32
+    void* m_FileHandle = nullptr;
+    void* m_MappingHandle = nullptr;
+#endif
+    std::string m_Buffer;  // Fallback storage when mapping is unavailable
+};
@@ -0,0 +1,658 @@
+#include "io/MeshExporter.h"
+#include "core/Model.h"
+#include "core/SolidSkin.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#ifdef HAS_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace {
+
+constexpr size_t kChunkValues = 1u << 16;        // Values gathered before each write
+constexpr size_t kCompressionBlock = 1u << 20;   // Uncompressed bytes per zlib block
+constexpr size_t kStlTriangleBytes = 50;
+
+enum VtkCellType : uint8_t {
+    VTK_EMPTY_CELL = 0,
+    VTK_VERTEX = 1,
+    VTK_LINE = 3,
+    VTK_TRIANGLE = 5,
+    VTK_QUAD = 9,
+    VTK_TETRA = 10,
+    VTK_HEXAHEDRON = 12
+};
+
+uint8_t GetVtkCellType(ElementType type) {
+    switch (type) {
+        case ElementType::SHELL3: return VTK_TRIANGLE;
+        case ElementType::SHELL4: return VTK_QUAD;
+        case ElementType::TETRA4: return VTK_TETRA;
+        case ElementType::HEXA8: return VTK_HEXAHEDRON;
+        case ElementType::BEAM2: return VTK_LINE;
+        case ElementType::SPRING1: return VTK_VERTEX;
+        default: return VTK_EMPTY_CELL;
+    }
+}
+
+bool IsLittleEndianHost() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+const bool kLittleEndianHost = IsLittleEndianHost();
+
+template<typename T>
+T SwapBytes(T value) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+template<typename T>
+T ToBigEndian(T value) { return kLittleEndianHost ? SwapBytes(value) : value; }
+
+template<typename T>
+T ToLittleEndian(T value) { return kLittleEndianHost ? value : SwapBytes(value); }
+
+// Looks up the node indices of an element; false if any node is missing
+bool ResolveNodes(const Model& model, const ElementView& element, uint32_t* indices) {
+    if (element.nodeIndices) {
+        for (size_t i = 0; i < element.nodeIds.size(); ++i) {
+            indices[i] = element.nodeIndices[i];
+            if (indices[i] == ElementArrays::kMissingNode) {
+                return false;
+            }
+        }
+        return true;
+    }
+    for (size_t i = 0; i < element.nodeIds.size(); ++i) {
+        size_t index = model.FindNodeIndex(element.nodeIds[i]);
+        if (index == Model::kInvalidIndex) {
+            return false;
+        }
+        indices[i] = static_cast<uint32_t>(index);
+    }
+    return true;
+}
+
+// Elements that map onto a VTK cell and whose nodes all exist. Worked out
+// once (one bit per element) so the per-array passes skip the validation.
+struct CellSelection {
+    std::vector<bool> exported;
+    size_t cellCount = 0;
+    size_t connectivityCount = 0;
+};
+
+CellSelection SelectCells(const Model& model) {
+    CellSelection selection;
+    selection.exported.resize(model.GetElementCount(), false);
+
+    uint32_t indices[8];
+    size_t skipped = 0;
+    model.ForEachElement([&](size_t i, const ElementView& element) {
+        int nodeCount = Element::GetNodeCount(element.type);
+        bool usable = GetVtkCellType(element.type) != VTK_EMPTY_CELL &&
+                      static_cast<int>(element.nodeIds.size()) == nodeCount &&
+                      ResolveNodes(model, element, indices);
+        if (!usable) {
+            ++skipped;
+            return;
+        }
+        selection.exported[i] = true;
+        selection.cellCount++;
+        selection.connectivityCount += element.nodeIds.size();
+    });
+
+    if (skipped > 0) {
+        LOG_WARN("Skipped {} elements with unsupported types or missing nodes", skipped);
+    }
+    return selection;
+}
+
+template<typename F>
+void ForEachCell(const Model& model, const CellSelection& selection, F&& visit) {
+    model.ForEachElement([&](size_t i, const ElementView& element) {
+        if (selection.exported[i]) {
+            visit(element);
+        }
+    });
+}
+
+// Gathers values into a fixed-size chunk and hands full chunks to a sink
+template<typename T, typename Sink>
+class ChunkStream {
+public:
+    explicit ChunkStream(Sink& sink) : m_Sink(sink) { m_Values.reserve(kChunkValues); }
+
+    void Push(T value) {
+        m_Values.push_back(value);
+        if (m_Values.size() == kChunkValues) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        if (!m_Values.empty()) {
+            m_Sink.Write(m_Values.data(), m_Values.size() * sizeof(T));
+            m_Values.clear();
+        }
+    }
+
+private:
+    Sink& m_Sink;
+    std::vector<T> m_Values;
+};
+
+struct FileSink {
+    std::ofstream& file;
+    void Write(const void* data, size_t size) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+};
+
+// Writes the arrays of a VTU <AppendedData> block. Raw arrays are prefixed
+// with their byte count; compressed arrays get a block header that is
+// patched once all blocks are written.
+class AppendedArrayWriter {
+public:
+    AppendedArrayWriter(std::ofstream& file, MeshExporter::Compression compression)
+        : m_File(file), m_Compression(compression) {}
+
+    // Marks the first byte after the '_' that opens the appended data
+    void Start() { m_Start = m_File.tellp(); }
+
+    // Starts an array of byteCount bytes and returns its offset attribute
+    uint64_t BeginArray(uint64_t byteCount) {
+        uint64_t offset = static_cast<uint64_t>(m_File.tellp() - m_Start);
+        m_ArrayBytes = byteCount;
+        m_Written = 0;
+
+        if (m_Compression == MeshExporter::Compression::NONE) {
+            uint64_t header = ToLittleEndian(byteCount);
+            m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        } else {
+            size_t blockCount = static_cast<size_t>((byteCount + kCompressionBlock - 1) / kCompressionBlock);
+            m_HeaderPos = m_File.tellp();
+            m_BlockSizes.clear();
+            std::vector<uint64_t> placeholder(3 + blockCount, 0);
+            m_File.write(reinterpret_cast<const char*>(placeholder.data()),
+                         static_cast<std::streamsize>(placeholder.size() * sizeof(uint64_t)));
+            m_Block.clear();
+            m_Block.reserve(kCompressionBlock);
+        }
+        return offset;
+    }
+
+    void Write(const void* data, size_t size) {
+        m_Written += size;
+        if (m_Compression == MeshExporter::Compression::NONE) {
+            m_File.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return;
+        }
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            size_t take = std::min(size, kCompressionBlock - m_Block.size());
+            m_Block.insert(m_Block.end(), bytes, bytes + take);
+            bytes += take;
+            size -= take;
+            if (m_Block.size() == kCompressionBlock) {
+                CompressBlock();
+            }
+        }
+    }
+
+    void EndArray() {
+        if (m_Written != m_ArrayBytes) {
+            m_Good = false;
+        }
+        if (m_Compression == MeshExporter::Compression::NONE) {
+            return;
+        }
+
+        if (!m_Block.empty()) {
+            CompressBlock();
+        }
+
+        uint64_t lastBlock = m_ArrayBytes % kCompressionBlock;
+        std::vector<uint64_t> header;
+        header.reserve(3 + m_BlockSizes.size());
+        header.push_back(ToLittleEndian<uint64_t>(m_BlockSizes.size()));
+        header.push_back(ToLittleEndian<uint64_t>(kCompressionBlock));
+        header.push_back(ToLittleEndian<uint64_t>(lastBlock));
+        for (uint64_t size : m_BlockSizes) {
+            header.push_back(ToLittleEndian(size));
+        }
+
+        std::streampos end = m_File.tellp();
+        m_File.seekp(m_HeaderPos);
+        m_File.write(reinterpret_cast<const char*>(header.data()),
+                     static_cast<std::streamsize>(header.size() * sizeof(uint64_t)));
+        m_File.seekp(end);
+    }
+
+    bool Good() const { return m_Good && m_File.good(); }
+
+private:
+    void CompressBlock() {
+#ifdef HAS_ZLIB
+        uLongf compressedSize = compressBound(static_cast<uLong>(m_Block.size()));
+        m_Compressed.resize(compressedSize);
+        if (compress2(m_Compressed.data(), &compressedSize, m_Block.data(),
+                      static_cast<uLong>(m_Block.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            m_Good = false;
+            compressedSize = 0;
+        }
+        m_File.write(reinterpret_cast<const char*>(m_Compressed.data()),
+                     static_cast<std::streamsize>(compressedSize));
+        m_BlockSizes.push_back(compressedSize);
+#else
+        m_Good = false;
+#endif
+        m_Block.clear();
+    }
+
+private:
+    std::ofstream& m_File;
+    MeshExporter::Compression m_Compression;
+    std::streampos m_Start;
+    std::streampos m_HeaderPos;
+    uint64_t m_ArrayBytes = 0;
+    uint64_t m_Written = 0;
+    std::vector<uint8_t> m_Block;
+    std::vector<uint8_t> m_Compressed;
+    std::vector<uint64_t> m_BlockSizes;
+    bool m_Good = true;
+};
+
+// Buffers binary STL triangles and writes them in large blocks
+class StlTriangleWriter {
+public:
+    explicit StlTriangleWriter(std::ofstream& file) : m_File(file) {
+        m_Buffer.reserve(kChunkValues * kStlTriangleBytes);
+    }
+
+    void Add(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+
+        const glm::vec3* vectors[4] = {&normal, &a, &b, &c};
+        for (const glm::vec3* v : vectors) {
+            for (int i = 0; i < 3; ++i) {
+                AppendValue(ToLittleEndian((*v)[i]));
+            }
+        }
+        AppendValue<uint16_t>(0);  // Attribute byte count
+
+        ++m_Count;
+        if (m_Buffer.size() >= kChunkValues * kStlTriangleBytes) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        m_File.write(m_Buffer.data(), static_cast<std::streamsize>(m_Buffer.size()));
+        m_Buffer.clear();
+    }
+
+    uint64_t GetCount() const { return m_Count; }
+
+private:
+    template<typename T>
+    void AppendValue(T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        m_Buffer.insert(m_Buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+private:
+    std::ofstream& m_File;
+    std::vector<char> m_Buffer;
+    uint64_t m_Count = 0;
+};
+
+// Emits a polygon given as node indices as a fan, skipping collapsed corners
+void AddPolygon(StlTriangleWriter& writer, const ChunkedColumn<glm::vec3>& positions,
+                const uint32_t* indices, int count) {
+    for (int i = 1; i + 1 < count; ++i) {
+        uint32_t a = indices[0], b = indices[i], c = indices[i + 1];
+        if (a == b || b == c || a == c) {
+            continue;
+        }
+        writer.Add(positions[a], positions[b], positions[c]);
+    }
+}
+
+} // namespace
+
+bool MeshExporter::IsCompressionAvailable() {
+#ifdef HAS_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MeshExporter::WriteVTU(const Model& model, const std::string& filepath,
+                            Compression compression) {
+    if (compression == Compression::ZLIB && !IsCompressionAvailable()) {
+        LOG_WARN("Built without zlib, writing uncompressed VTU");
+        compression = Compression::NONE;
+    }
+    if (model.GetNodeCount() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        LOG_ERROR("Too many nodes for Int32 connectivity: {}", model.GetNodeCount());
+        return false;
+    }
+
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot create file: {}", filepath);
+        return false;
+    }
+
+    const auto& nodeIds = model.GetNodeIds();
+    const auto& positions = model.GetNodePositions();
+    CellSelection selection = SelectCells(model);
+
+    // Offsets are only known once the arrays are written, so the header
+    // gets fixed-width placeholders that are patched at the end
+    const int kOffsetDigits = 20;
+    std::string header;
+    std::vector<size_t> offsetPositions;
+    auto addArray = [&](const char* indent, const char* type, const char* name, int components) {
+        header += indent;
+        header += "<DataArray type=\"";
+        header += type;
+        header += "\" Name=\"";
+        header += name;
+        header += "\"";
+        if (components > 1) {
+            header += " NumberOfComponents=\"" + std::to_string(components) + "\"";
+        }
+        header += " format=\"appended\" offset=\"";
+        offsetPositions.push_back(header.size());
+        header.append(kOffsetDigits, '0');
+        header += "\"/>\n";
+    };
+
+    header += "<?xml version=\"1.0\"?>\n";
+    header += "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"";
+    header += kLittleEndianHost ? "LittleEndian" : "BigEndian";
+    header += "\" header_type=\"UInt64\"";
+    if (compression == Compression::ZLIB) {
+        header += " compressor=\"vtkZLibDataCompressor\"";
+    }
+    header += ">\n";
+    header += "  <UnstructuredGrid>\n";
+    header += "    <Piece NumberOfPoints=\"" + std::to_string(nodeIds.size()) +
+              "\" NumberOfCells=\"" + std::to_string(selection.cellCount) + "\">\n";
+    header += "      <PointData Scalars=\"NodeID\">\n";
+    addArray("        ", "Int32", "NodeID", 1);
+    header += "      </PointData>\n";
+    header += "      <CellData Scalars=\"ElementID\">\n";
+    addArray("        ", "Int32", "ElementID", 1);
+    addArray("        ", "Int32", "MaterialID", 1);
+    addArray("        ", "Int32", "PropertyID", 1);
+    header += "      </CellData>\n";
+    header += "      <Points>\n";
+    addArray("        ", "Float32", "Points", 3);
+    header += "      </Points>\n";
+    header += "      <Cells>\n";
+    addArray("        ", "Int32", "connectivity", 1);
+    addArray("        ", "Int64", "offsets", 1);
+    addArray("        ", "UInt8", "types", 1);
+    header += "      </Cells>\n";
+    header += "    </Piece>\n";
+    header += "  </UnstructuredGrid>\n";
+    header += "  <AppendedData encoding=\"raw\">\n   _";
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    AppendedArrayWriter writer(file, compression);
+    writer.Start();
+    std::vector<uint64_t> offsets;
+
+    {
+        offsets.push_back(writer.BeginArray(nodeIds.size() * sizeof(int32_t)));
+        ChunkStream<int32_t, AppendedArrayWriter> stream(writer);
+        for (int id : nodeIds) {
+            stream.Push(id);
+        }
+        stream.Flush();
+        writer.EndArray();
+    }
+
+    auto writeCellValues = [&](auto valueOf) {
+        offsets.push_back(writer.BeginArray(selection.cellCount * sizeof(int32_t)));
+        ChunkStream<int32_t, AppendedArrayWriter> stream(writer);
+        ForEachCell(model, selection, [&](const ElementView& element) { stream.Push(valueOf(element)); });
+        stream.Flush();
+        writer.EndArray();
+    };
+    writeCellValues([](const ElementView& element) { return element.id; });
+    writeCellValues([](const ElementView& element) { return element.materialId; });
+    writeCellValues([](const ElementView& element) { return element.propertyId; });
+
+    {
+        offsets.push_back(writer.BeginArray(nodeIds.size() * 3 * sizeof(float)));
+        ChunkStream<float, AppendedArrayWriter> stream(writer);
+        for (const glm::vec3& position : positions) {
+            stream.Push(position.x);
+            stream.Push(position.y);
+            stream.Push(position.z);
+        }
+        stream.Flush();
+        writer.EndArray();
+    }
+
+    {
+        offsets.push_back(writer.BeginArray(selection.connectivityCount * sizeof(int32_t)));
+        ChunkStream<int32_t, AppendedArrayWriter> stream(writer);
+        uint32_t indices[8];
+        ForEachCell(model, selection, [&](const ElementView& element) {
+            ResolveNodes(model, element, indices);
+            for (size_t i = 0; i < element.nodeIds.size(); ++i) {
+                stream.Push(static_cast<int32_t>(indices[i]));
+            }
+        });
+        stream.Flush();
+        writer.EndArray();
+    }
+
+    {
+        offsets.push_back(writer.BeginArray(selection.cellCount * sizeof(int64_t)));
+        ChunkStream<int64_t, AppendedArrayWriter> stream(writer);
+        int64_t end = 0;
+        ForEachCell(model, selection, [&](const ElementView& element) {
+            end += static_cast<int64_t>(element.nodeIds.size());
+            stream.Push(end);
+        });
+        stream.Flush();
+        writer.EndArray();
+    }
+
+    {
+        offsets.push_back(writer.BeginArray(selection.cellCount * sizeof(uint8_t)));
+        ChunkStream<uint8_t, AppendedArrayWriter> stream(writer);
+        ForEachCell(model, selection, [&](const ElementView& element) {
+            stream.Push(GetVtkCellType(element.type));
+        });
+        stream.Flush();
+        writer.EndArray();
+    }
+
+    const char* footer = "\n  </AppendedData>\n</VTKFile>\n";
+    file.write(footer, static_cast<std::streamsize>(std::strlen(footer)));
+
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        char digits[32];
+        std::snprintf(digits, sizeof(digits), "%0*llu", kOffsetDigits,
+                      static_cast<unsigned long long>(offsets[i]));
+        file.seekp(static_cast<std::streamoff>(offsetPositions[i]));
+        file.write(digits, kOffsetDigits);
+    }
+
+    if (!writer.Good() || !file.good()) {
+        LOG_ERROR("Failed while writing: {}", filepath);
+        return false;
+    }
+
+    LOG_INFO("Exported {} points and {} cells to {}", nodeIds.size(), selection.cellCount, filepath);
+    return true;
+}
+
+bool MeshExporter::WriteLegacyVTK(const Model& model, const std::string& filepath) {
+    if (model.GetNodeCount() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        LOG_ERROR("Too many nodes for the legacy VTK format: {}", model.GetNodeCount());
+        return false;
+    }
+
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot create file: {}", filepath);
+        return false;
+    }
+
+    const auto& nodeIds = model.GetNodeIds();
+    const auto& positions = model.GetNodePositions();
+    CellSelection selection = SelectCells(model);
+    FileSink sink{file};
+
+    // Legacy binary data is always big-endian
+    file << "# vtk DataFile Version 3.0\n"
+         << "Model exported from OpenRadioss Pre-Processor\n"
+         << "BINARY\n"
+         << "DATASET UNSTRUCTURED_GRID\n"
+         << "POINTS " << nodeIds.size() << " float\n";
+    {
+        ChunkStream<float, FileSink> stream(sink);
+        for (const glm::vec3& position : positions) {
+            stream.Push(ToBigEndian(position.x));
+            stream.Push(ToBigEndian(position.y));
+            stream.Push(ToBigEndian(position.z));
+        }
+        stream.Flush();
+    }
+
+    file << "\nCELLS " << selection.cellCount << " "
+         << selection.cellCount + selection.connectivityCount << "\n";
+    {
+        ChunkStream<int32_t, FileSink> stream(sink);
+        uint32_t indices[8];
+        ForEachCell(model, selection, [&](const ElementView& element) {
+            ResolveNodes(model, element, indices);
+            stream.Push(ToBigEndian(static_cast<int32_t>(element.nodeIds.size())));
+            for (size_t i = 0; i < element.nodeIds.size(); ++i) {
+                stream.Push(ToBigEndian(static_cast<int32_t>(indices[i])));
+            }
+        });
+        stream.Flush();
+    }
+
+    auto writeCellValues = [&](auto valueOf) {
+        ChunkStream<int32_t, FileSink> stream(sink);
+        ForEachCell(model, selection, [&](const ElementView& element) {
+            stream.Push(ToBigEndian(static_cast<int32_t>(valueOf(element))));
+        });
+        stream.Flush();
+    };
+
+    file << "\nCELL_TYPES " << selection.cellCount << "\n";
+    writeCellValues([](const ElementView& element) { return GetVtkCellType(element.type); });
+
+    file << "\nCELL_DATA " << selection.cellCount << "\n"
+         << "SCALARS ElementID int 1\nLOOKUP_TABLE default\n";
+    writeCellValues([](const ElementView& element) { return element.id; });
+    file << "\nSCALARS MaterialID int 1\nLOOKUP_TABLE default\n";
+    writeCellValues([](const ElementView& element) { return element.materialId; });
+    file << "\nSCALARS PropertyID int 1\nLOOKUP_TABLE default\n";
+    writeCellValues([](const ElementView& element) { return element.propertyId; });
+
+    file << "\nPOINT_DATA " << nodeIds.size() << "\n"
+         << "SCALARS NodeID int 1\nLOOKUP_TABLE default\n";
+    {
+        ChunkStream<int32_t, FileSink> stream(sink);
+        for (int id : nodeIds) {
+            stream.Push(ToBigEndian(static_cast<int32_t>(id)));
+        }
+        stream.Flush();
+    }
+    file << "\n";
+
+    if (!file.good()) {
+        LOG_ERROR("Failed while writing: {}", filepath);
+        return false;
+    }
+
+    LOG_INFO("Exported {} points and {} cells to {}", nodeIds.size(), selection.cellCount, filepath);
+    return true;
+}
+
+bool MeshExporter::WriteSTL(const Model& model, const std::string& filepath) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Cannot create file: {}", filepath);
+        return false;
+    }
+
+    const auto& positions = model.GetNodePositions();
+
+    // The header must not start with "solid", which marks ASCII STL
+    char header[80] = {};
+    std::snprintf(header, sizeof(header), "Binary STL exported from OpenRadioss Pre-Processor");
+    file.write(header, sizeof(header));
+    uint32_t placeholderCount = 0;
+    file.write(reinterpret_cast<const char*>(&placeholderCount), sizeof(placeholderCount));
+
+    StlTriangleWriter writer(file);
+    uint32_t indices[8];
+
+    // Shells are written as they are, solids through their exterior faces
+    model.ForEachElement([&](size_t, const ElementView& element) {
+        if (element.type != ElementType::SHELL3 && element.type != ElementType::SHELL4) {
+            return;
+        }
+        int nodeCount = Element::GetNodeCount(element.type);
+        if (static_cast<int>(element.nodeIds.size()) == nodeCount &&
+            ResolveNodes(model, element, indices)) {
+            AddPolygon(writer, positions, indices, nodeCount);
+        }
+    });
+
+    SolidSkin skin;
+    skin.Build(model);
+    for (const SkinFace& face : skin.GetFaces()) {
+        uint32_t polygon[4];
+        int size = SolidSkin::GetFaceNodes(model, face, polygon);
+        AddPolygon(writer, positions, polygon, size);
+    }
+    writer.Flush();
+
+    if (writer.GetCount() > std::numeric_limits<uint32_t>::max()) {
+        LOG_ERROR("Too many triangles for binary STL: {}", writer.GetCount());
+        return false;
+    }
+    uint32_t count = ToLittleEndian(static_cast<uint32_t>(writer.GetCount()));
+    file.seekp(sizeof(header));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+    if (!file.good()) {
+        LOG_ERROR("Failed while writing: {}", filepath);
+        return false;
+    }
+
+    LOG_INFO("Exported {} triangles to {}", writer.GetCount(), filepath);
+    return true;
+}
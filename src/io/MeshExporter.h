@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+
+class Model;
+
+// Binary mesh exports for post-processing tools such as ParaView. Node and
+// element data are streamed from the model's own arrays in fixed-size
+// chunks, so memory use stays flat regardless of model size. The one
+// exception is the STL skin of solid elements, which needs a table of
+// solid faces to find the unshared ones.
+class MeshExporter {
+public:
+    enum class Compression {
+        NONE,   // Appended raw data
+        ZLIB    // vtkZLibDataCompressor blocks (only when built with zlib)
+    };
+
+    // VTK XML unstructured grid (.vtu) with appended binary arrays
+    static bool WriteVTU(const Model& model, const std::string& filepath,
+                         Compression compression);
+
+    // Legacy binary VTK unstructured grid (.vtk)
+    static bool WriteLegacyVTK(const Model& model, const std::string& filepath);
+
+    // Binary STL of all shells plus the outer faces of solids
+    static bool WriteSTL(const Model& model, const std::string& filepath);
+
+    static bool IsCompressionAvailable();
+};
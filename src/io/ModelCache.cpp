@@ -0,0 +1,488 @@
+#include "io/ModelCache.h"
+#include "io/MappedFile.h"
+#include "core/Model.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Bump whenever the layout below changes; older snapshots are then ignored
+// 2: decks with #include snapshot each file on its own
+// 3: no ID maps; Model rebuilds its own ID indices on load
+// 4: material parameters stored by name instead of as fixed fields
+// 5: fragment snapshots flagged, so unchecked #include files stay out of opens
+constexpr uint32_t kCacheVersion = 5;
+constexpr char kCacheMagic[4] = {'R', 'A', 'D', 'C'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr size_t kSectionAlignment = 8;
+constexpr size_t kHashChunkSize = 8 * 1024 * 1024;
+constexpr uint32_t kFragmentFlag = 1;
+
+// Every section starts at an 8-byte aligned offset from the file start
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t flags;
+    
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t sourceHash;
+    
+    uint64_t nodeCount;
+    uint64_t elementCount;
+    uint64_t connectivityCount;
+    uint64_t materialCount;
+    uint64_t parameterCount;
+    uint64_t nameBytes;
+};
+
+struct NodeRecord {
+    int32_t id;
+    float position[3];
+    uint8_t fixed[3];
+    uint8_t padding;
+};
+
+struct ElementRecord {
+    int32_t id;
+    int32_t type;
+    int32_t materialId;
+    int32_t propertyId;
+    float thickness;
+    uint32_t nodeCount;
+    uint64_t firstNode;  // Offset into the connectivity array
+};
+
+struct MaterialRecord {
+    int32_t id;
+    int32_t type;
+    uint32_t nameLength;
+    uint32_t parameterCount;
+    uint64_t nameOffset;       // Offset into the name blob
+    uint64_t firstParameter;   // Index into the parameter section
+};
+
+// Parameter keys other than the built-in ones only hold within one
+// process, so parameters are stored by name
+struct ParameterRecord {
+    uint64_t nameOffset;
+    uint32_t nameLength;
+    uint32_t padding;
+    double value;
+};
+
+static_assert(std::is_trivially_copyable<CacheHeader>::value, "header must be flat");
+static_assert(sizeof(NodeRecord) == 20, "unexpected NodeRecord padding");
+static_assert(sizeof(ElementRecord) == 32, "unexpected ElementRecord padding");
+static_assert(sizeof(ParameterRecord) == 24, "unexpected ParameterRecord padding");
+
+size_t AlignUp(size_t offset) {
+    return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+// Section sizes follow from the header counts, so both sides agree on the layout
+struct CacheLayout {
+    size_t nodes, elements, connectivity, materials, parameters, names, end;
+    
+    explicit CacheLayout(const CacheHeader& header) {
+        nodes = AlignUp(sizeof(CacheHeader));
+        elements = AlignUp(nodes + header.nodeCount * sizeof(NodeRecord));
+        connectivity = AlignUp(elements + header.elementCount * sizeof(ElementRecord));
+        materials = AlignUp(connectivity + header.connectivityCount * sizeof(int32_t));
+        parameters = AlignUp(materials + header.materialCount * sizeof(MaterialRecord));
+        names = AlignUp(parameters + header.parameterCount * sizeof(ParameterRecord));
+        end = names + header.nameBytes;
+    }
+};
+
+// 64-bit multiply-rotate hash over 8-byte words (xxHash64 style rounds)
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t HashBytes(const char* data, size_t size, uint64_t seed) {
+    uint64_t lanes[4] = {seed + kPrime1, seed + kPrime2, seed, seed - kPrime1};
+    
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, data + offset + lane * 8, sizeof(word));
+            lanes[lane] = RotateLeft(lanes[lane] + word * kPrime2, 31) * kPrime1;
+        }
+    }
+    
+    uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) +
+                    RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18) + size;
+    for (; offset < size; ++offset) {
+        hash = RotateLeft(hash ^ (static_cast<uint8_t>(data[offset]) * kPrime3), 11) * kPrime1;
+    }
+    
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+template<typename T>
+void WriteArray(std::ofstream& file, const std::vector<T>& values) {
+    if (!values.empty()) {
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+}
+
+template<typename T>
+void WriteArray(std::ofstream& file, const ChunkedColumn<T>& values) {
+    values.ForEachSpan([&](const T* data, size_t count, size_t) {
+        file.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+    });
+}
+
+void PadTo(std::ofstream& file, size_t offset) {
+    static const char zeros[kSectionAlignment] = {};
+    size_t position = static_cast<size_t>(file.tellp());
+    if (offset > position) {
+        file.write(zeros, offset - position);
+    }
+}
+
+template<typename T>
+const T* SectionAt(const MappedFile& file, size_t offset) {
+    return reinterpret_cast<const T*>(file.Data() + offset);
+}
+
+} // namespace
+
+std::string ModelCache::GetCachePath(const std::string& deckPath) {
+    std::filesystem::path path(deckPath);
+    path.replace_extension(".radc");
+    return path.string();
+}
+
+bool ModelCache::GetSourceStamp(const std::string& deckPath, SourceKey& key) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(deckPath, error);
+    if (error) return false;
+    auto mtime = std::filesystem::last_write_time(deckPath, error);
+    if (error) return false;
+    
+    key.size = static_cast<uint64_t>(size);
+    key.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+bool ModelCache::HashSource(const std::string& deckPath, SourceKey& key) {
+    MappedFile source;
+    if (!source.Open(deckPath) || source.Size() != key.size) {
+        return false;
+    }
+    source.AdviseSequential();
+    
+    // Fixed-size chunks hashed in parallel; the result does not depend on
+    // the number of threads
+    size_t chunkCount = (source.Size() + kHashChunkSize - 1) / kHashChunkSize;
+    std::vector<uint64_t> chunkHashes(chunkCount);
+    ThreadPool::GetGlobal().ParallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t offset = i * kHashChunkSize;
+            size_t size = std::min(kHashChunkSize, source.Size() - offset);
+            chunkHashes[i] = HashBytes(source.Data() + offset, size, i);
+        }
+    });
+    
+    key.hash = HashBytes(reinterpret_cast<const char*>(chunkHashes.data()),
+                         chunkHashes.size() * sizeof(uint64_t), key.size);
+    return true;
+}
+
+bool ModelCache::Load(const std::string& deckPath, Model& model, Kind kind) {
+    std::string cachePath = GetCachePath(deckPath);
+    
+    MappedFile file;
+    if (!file.Open(cachePath)) {
+        return false;
+    }
+    
+    CacheHeader header;
+    if (file.Size() < sizeof(header)) {
+        LOG_WARN("Ignoring truncated model cache: {}", cachePath);
+        return false;
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+    
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.version != kCacheVersion || header.byteOrder != kByteOrderMark) {
+        LOG_INFO("Model cache version mismatch, reparsing: {}", cachePath);
+        return false;
+    }
+    if (kind == Kind::DECK && (header.flags & kFragmentFlag)) {
+        LOG_INFO("Model cache holds an unchecked include file, reparsing: {}", cachePath);
+        return false;
+    }
+    
+    // Cheap checks first; the content hash only runs when size and mtime match
+    SourceKey key;
+    if (!GetSourceStamp(deckPath, key) || key.size != header.sourceSize ||
+        key.mtime != header.sourceMtime) {
+        LOG_INFO("Deck changed since it was cached: {}", deckPath);
+        return false;
+    }
+    if (!HashSource(deckPath, key) || key.hash != header.sourceHash) {
+        LOG_INFO("Deck content changed since it was cached: {}", deckPath);
+        return false;
+    }
+    
+    // Guard every count against the file size before touching the sections.
+    // The bound on each count also keeps the layout arithmetic from overflowing.
+    uint64_t limit = file.Size();
+    if (header.nodeCount > limit || header.elementCount > limit ||
+        header.connectivityCount > limit || header.materialCount > limit ||
+        header.parameterCount > limit || header.nameBytes > limit) {
+        LOG_WARN("Ignoring corrupt model cache: {}", cachePath);
+        return false;
+    }
+    CacheLayout layout(header);
+    if (layout.end > file.Size()) {
+        LOG_WARN("Ignoring truncated model cache: {}", cachePath);
+        return false;
+    }
+    
+    NodeArrays nodes;
+    nodes.ids.reserve(header.nodeCount);
+    nodes.positions.reserve(header.nodeCount);
+    nodes.fixity.reserve(header.nodeCount);
+    const NodeRecord* nodeRecords = SectionAt<NodeRecord>(file, layout.nodes);
+    for (size_t i = 0; i < header.nodeCount; ++i) {
+        NodeRecord record;
+        std::memcpy(&record, nodeRecords + i, sizeof(record));
+        
+        nodes.PushBack(record.id, glm::vec3(record.position[0], record.position[1], record.position[2]),
+                       static_cast<uint8_t>((record.fixed[0] ? FIXED_X : 0) |
+                                            (record.fixed[1] ? FIXED_Y : 0) |
+                                            (record.fixed[2] ? FIXED_Z : 0)));
+    }
+    
+    // One copy of the connectivity section; elements then reference slices
+    std::vector<int> connectivity(header.connectivityCount);
+    if (!connectivity.empty()) {
+        std::memcpy(connectivity.data(), file.Data() + layout.connectivity,
+                    connectivity.size() * sizeof(int32_t));
+    }
+    
+    ElementArrays elements;
+    elements.Reserve(header.elementCount, header.connectivityCount);
+    const ElementRecord* elementRecords = SectionAt<ElementRecord>(file, layout.elements);
+    for (size_t i = 0; i < header.elementCount; ++i) {
+        ElementRecord record;
+        std::memcpy(&record, elementRecords + i, sizeof(record));
+        if (record.firstNode > header.connectivityCount ||
+            record.nodeCount > header.connectivityCount - record.firstNode ||
+            record.type < static_cast<int32_t>(ElementType::UNKNOWN) ||
+            record.type > static_cast<int32_t>(ElementType::SPRING1)) {
+            LOG_WARN("Ignoring corrupt model cache: {}", cachePath);
+            return false;
+        }
+        
+        ElementView element;
+        element.id = record.id;
+        element.type = static_cast<ElementType>(record.type);
+        element.materialId = record.materialId;
+        element.propertyId = record.propertyId;
+        element.thickness = record.thickness;
+        element.nodeIds = NodeIdSpan(connectivity.data() + record.firstNode, record.nodeCount);
+        elements.Append(element);
+    }
+    
+    std::vector<Material> materials(header.materialCount);
+    const MaterialRecord* materialRecords = SectionAt<MaterialRecord>(file, layout.materials);
+    const ParameterRecord* parameterRecords = SectionAt<ParameterRecord>(file, layout.parameters);
+    const char* names = file.Data() + layout.names;
+    auto nameInBounds = [&](uint64_t offset, uint32_t length) {
+        return offset <= header.nameBytes && length <= header.nameBytes - offset;
+    };
+    for (size_t i = 0; i < materials.size(); ++i) {
+        MaterialRecord record;
+        std::memcpy(&record, materialRecords + i, sizeof(record));
+        if (!nameInBounds(record.nameOffset, record.nameLength) ||
+            record.firstParameter > header.parameterCount ||
+            record.parameterCount > header.parameterCount - record.firstParameter ||
+            record.type < static_cast<int32_t>(MaterialType::ELASTIC) ||
+            record.type > static_cast<int32_t>(MaterialType::HYPERELASTIC)) {
+            LOG_WARN("Ignoring corrupt model cache: {}", cachePath);
+            return false;
+        }
+        
+        Material& material = materials[i];
+        material.id = record.id;
+        material.SetType(static_cast<MaterialType>(record.type));
+        material.name.assign(names + record.nameOffset, record.nameLength);
+        for (uint32_t p = 0; p < record.parameterCount; ++p) {
+            ParameterRecord parameter;
+            std::memcpy(&parameter, parameterRecords + record.firstParameter + p, sizeof(parameter));
+            if (!nameInBounds(parameter.nameOffset, parameter.nameLength)) {
+                LOG_WARN("Ignoring corrupt model cache: {}", cachePath);
+                return false;
+            }
+            std::string_view name(names + parameter.nameOffset, parameter.nameLength);
+            material.parameters.Set(ParameterSymbols::Intern(name), parameter.value);
+        }
+    }
+    
+    model.Assign(std::move(nodes), std::move(elements), std::move(materials));
+    
+    LOG_INFO("Loaded {} from model cache", deckPath);
+    return true;
+}
+
+bool ModelCache::Save(const std::string& deckPath, const Model& model, Kind kind) {
+    SourceKey key;
+    if (!GetSourceStamp(deckPath, key) || !HashSource(deckPath, key)) {
+        return false;
+    }
+    
+    const NodeArrays& nodes = model.GetNodeArrays();
+    const ElementArrays& elements = model.GetElementArrays();
+    const auto& materials = model.GetMaterials();
+    
+    // The node columns are chunked in step, so one chunk index reads all three
+    std::vector<NodeRecord> nodeRecords(nodes.Size());
+    for (size_t chunk = 0; chunk < nodes.ids.GetChunkCount(); ++chunk) {
+        const size_t first = nodes.ids.GetChunkOffset(chunk);
+        const int* ids = nodes.ids.GetChunkData(chunk);
+        const glm::vec3* positions = nodes.positions.GetChunkData(chunk);
+        const uint8_t* fixity = nodes.fixity.GetChunkData(chunk);
+        for (size_t k = 0; k < nodes.ids.GetChunkSize(chunk); ++k) {
+            NodeRecord& record = nodeRecords[first + k];
+            record.id = ids[k];
+            record.position[0] = positions[k].x;
+            record.position[1] = positions[k].y;
+            record.position[2] = positions[k].z;
+            record.fixed[0] = (fixity[k] & FIXED_X) != 0;
+            record.fixed[1] = (fixity[k] & FIXED_Y) != 0;
+            record.fixed[2] = (fixity[k] & FIXED_Z) != 0;
+            record.padding = 0;
+        }
+    }
+    
+    // The model's connectivity is written as it is, chunk after chunk, so
+    // each element's slice starts where the previous one ended
+    const ChunkedColumn<int>& connectivity = elements.nodeIds;
+    std::vector<ElementRecord> elementRecords(elements.Size());
+    uint64_t firstNode = 0;
+    elements.ForEach(0, elements.Size(), [&](size_t i, const ElementView& element) {
+        ElementRecord& record = elementRecords[i];
+        record.id = element.id;
+        record.type = static_cast<int32_t>(element.type);
+        record.materialId = element.materialId;
+        record.propertyId = element.propertyId;
+        record.thickness = element.thickness;
+        record.nodeCount = static_cast<uint32_t>(element.nodeIds.size());
+        record.firstNode = firstNode;
+        firstNode += record.nodeCount;
+    });
+    
+    std::vector<MaterialRecord> materialRecords(materials.size());
+    std::vector<ParameterRecord> parameterRecords;
+    std::vector<char> names;
+    std::unordered_map<ParameterKey, uint64_t> parameterNames;  // Each name stored once
+    for (size_t i = 0; i < materials.size(); ++i) {
+        const Material& material = materials[i];
+        MaterialRecord& record = materialRecords[i];
+        std::memset(&record, 0, sizeof(record));
+        record.id = material.id;
+        record.type = static_cast<int32_t>(material.type);
+        record.nameLength = static_cast<uint32_t>(material.name.size());
+        record.nameOffset = names.size();
+        names.insert(names.end(), material.name.begin(), material.name.end());
+        
+        record.firstParameter = parameterRecords.size();
+        material.parameters.ForEach([&](ParameterKey key, double value) {
+            std::string_view name = ParameterSymbols::Name(key);
+            auto inserted = parameterNames.emplace(key, names.size());
+            if (inserted.second) {
+                names.insert(names.end(), name.begin(), name.end());
+            }
+            ParameterRecord parameter;
+            std::memset(&parameter, 0, sizeof(parameter));
+            parameter.nameOffset = inserted.first->second;
+            parameter.nameLength = static_cast<uint32_t>(name.size());
+            parameter.value = value;
+            parameterRecords.push_back(parameter);
+        });
+        record.parameterCount = static_cast<uint32_t>(parameterRecords.size() - record.firstParameter);
+    }
+    
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.byteOrder = kByteOrderMark;
+    header.flags = kind == Kind::FRAGMENT ? kFragmentFlag : 0;
+    header.sourceSize = key.size;
+    header.sourceMtime = key.mtime;
+    header.sourceHash = key.hash;
+    header.nodeCount = nodeRecords.size();
+    header.elementCount = elementRecords.size();
+    header.connectivityCount = connectivity.size();
+    header.materialCount = materialRecords.size();
+    header.parameterCount = parameterRecords.size();
+    header.nameBytes = names.size();
+    CacheLayout layout(header);
+    
+    // Write beside the final name and rename, so readers never see half a file
+    std::string cachePath = GetCachePath(deckPath);
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_WARN("Cannot write model cache: {}", cachePath);
+            return false;
+        }
+        
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        PadTo(file, layout.nodes);
+        WriteArray(file, nodeRecords);
+        PadTo(file, layout.elements);
+        WriteArray(file, elementRecords);
+        PadTo(file, layout.connectivity);
+        WriteArray(file, connectivity);
+        PadTo(file, layout.materials);
+        WriteArray(file, materialRecords);
+        PadTo(file, layout.parameters);
+        WriteArray(file, parameterRecords);
+        PadTo(file, layout.names);
+        WriteArray(file, names);
+        
+        if (!file) {
+            LOG_WARN("Failed writing model cache: {}", cachePath);
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        LOG_WARN("Cannot replace model cache {}: {}", cachePath, error.message());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+class Model;
+
+// Binary snapshot of a parsed model stored next to its deck (model.rad ->
+// model.radc). The snapshot is keyed on the deck's size, modification time
+// and content hash, and holds flat arrays that are copied straight out of a
+// mapped file, so re-opening an unchanged deck skips text parsing entirely.
+class ModelCache {
+public:
+    // A DECK snapshot passed the reader's reference checks; a FRAGMENT one
+    // is an #include file whose references may resolve in other files
+    enum class Kind {
+        DECK,
+        FRAGMENT
+    };
+    
+    // Fills model from the snapshot of deckPath. Returns false, leaving the
+    // model untouched, when there is no snapshot or it does not match the
+    // deck. A DECK load ignores FRAGMENT snapshots; a FRAGMENT load takes both.
+    static bool Load(const std::string& deckPath, Model& model, Kind kind = Kind::DECK);
+    
+    // Writes the snapshot for a model just parsed from deckPath
+    static bool Save(const std::string& deckPath, const Model& model, Kind kind = Kind::DECK);
+    
+    static std::string GetCachePath(const std::string& deckPath);
+    
+private:
+    struct SourceKey {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        uint64_t hash = 0;
+    };
+    
+    static bool GetSourceStamp(const std::string& deckPath, SourceKey& key);
+    static bool HashSource(const std::string& deckPath, SourceKey& key);
+};
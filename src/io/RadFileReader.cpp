@@ -1,10 +1,85 @@
 #include "RadFileReader.h"
+#include "io/FixedFieldDecoder.h"
+#include "io/MappedFile.h"
+#include "io/RadKeywords.h"
+#include "io/RecordWriter.h"
+#include "utils/Profiler.h"
+#include "utils/ThreadPool.h"
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <regex>
 #include <iomanip>
+#include <iterator>
 #include <limits>
 
 namespace OpenRadiossGUI {
 
+namespace {
+
+// Number conversion without exceptions or temporary strings. Mirrors the
+// prefix semantics of std::stoi/std::stof: leading '+' is accepted and
+// trailing characters after a valid number are ignored.
+bool parseInt(std::string_view token, int& value) {
+    const char* first = token.data();
+    const char* last = token.data() + token.size();
+    if (first != last && *first == '+') {
+        ++first;
+    }
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr != first;
+}
+
+template<typename T>
+bool parseReal(std::string_view token, T& value) {
+    const char* first = token.data();
+    const char* last = token.data() + token.size();
+    if (first != last && *first == '+') {
+        ++first;
+    }
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr != first;
+#else
+    // Standard libraries without floating-point from_chars: strtod on a
+    // bounded stack copy (tokens are short numeric fields)
+    char buffer[64];
+    size_t length = std::min(static_cast<size_t>(last - first), sizeof(buffer) - 1);
+    std::memcpy(buffer, first, length);
+    buffer[length] = '\0';
+    char* end = nullptr;
+    double parsed = std::strtod(buffer, &end);
+    if (end == buffer) {
+        return false;
+    }
+    value = static_cast<T>(parsed);
+    return true;
+#endif
+}
+
+bool parseFloat(std::string_view token, float& value) { return parseReal(token, value); }
+bool parseDouble(std::string_view token, double& value) { return parseReal(token, value); }
+
+} // namespace
+
+std::string ValidationIssue::describe() const {
+    switch (kind) {
+        case DUPLICATE_NODE_ID:
+            return "node " + std::to_string(entityId) + " is defined more than once";
+        case DUPLICATE_ELEMENT_ID:
+            return "element " + std::to_string(entityId) + " is defined more than once";
+        case WRONG_NODE_COUNT:
+            return "element " + std::to_string(entityId) + " has " + std::to_string(detail) +
+                   " nodes, which does not match its type";
+        case MISSING_NODE:
+            return "element " + std::to_string(entityId) + " references missing node " +
+                   std::to_string(detail);
+    }
+    return "unknown issue";
+}
+
 RadFileReader::RadFileReader() 
     : isValid_(false) {
     clearError();
@@ -15,23 +90,41 @@ RadFileReader::~RadFileReader() {
 }
 
 bool RadFileReader::loadFile(const std::string& filename) {
+    return load(filename, true);
+}
+
+bool RadFileReader::loadFragment(const std::string& filename) {
+    return load(filename, false);
+}
+
+bool RadFileReader::load(const std::string& filename, bool checkReferences) {
     clear();
     filename_ = filename;
     
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.Open(filename)) {
         setError("Cannot open file: " + filename);
         return false;
     }
+    file.AdviseSequential();
     
-    bool success = parseFile(file);
-    file.close();
+    bool success = false;
+    {
+        PROFILE_SCOPE("RadFileReader::parseFile");
+        success = parseFile(file.View());
+    }
+    file.Close();
     
     if (success) {
-        buildLookupTables();
-        isValid_ = validateData();
+        {
+            PROFILE_SCOPE("RadFileReader::buildLookupTables");
+            buildLookupTables();
+        }
+        PROFILE_SCOPE("RadFileReader::validateData");
+        isValid_ = validateData(checkReferences);
         if (!isValid_) {
-            setError("File validation failed");
+            setError("File validation failed: " + std::to_string(validationIssueCount_) +
+                     " issue(s), first: " + validationIssues_.front().describe());
         }
     }
     
@@ -43,21 +136,21 @@ bool RadFileReader::saveFile(const std::string& filename) const {
         return false;
     }
     
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+    RecordWriter writer;
+    if (!writer.Open(filename)) {
         return false;
     }
     
     bool success = true;
-    success &= writeHeader(file);
-    success &= writeNodes(file);
-    success &= writeElements(file);
-    success &= writeMaterials(file);
-    success &= writeProperties(file);
-    success &= writeLoadCases(file);
-    success &= writeBoundaryConditions(file);
-    
-    file.close();
+    success &= writeHeader(writer);
+    success &= writeNodes(writer);
+    success &= writeElements(writer);
+    success &= writeMaterials(writer);
+    success &= writeProperties(writer);
+    success &= writeLoadCases(writer);
+    success &= writeBoundaryConditions(writer);
+    
+    success &= writer.Close();
     return success;
 }
 
@@ -73,46 +166,319 @@ void RadFileReader::clear() {
     version_.clear();
     filename_.clear();
     isValid_ = false;
+    validationIssues_.clear();
+    validationIssueCount_ = 0;
     
     clearLookupTables();
     clearError();
+    
+    // Every parsed element is gone, so their node IDs go in one release
+    connectivityArenas_.clear();
 }
 
-bool RadFileReader::parseFile(std::ifstream& file) {
-    std::string line;
+bool RadFileReader::parseFile(std::string_view data) {
+    if (progress_) {
+        progress_->bytesTotal = data.size();
+    }
+    
+    std::vector<ParseChunk> chunks = scanChunks(data);
+    std::vector<ChunkResult> results(chunks.size());
+    
+    // Node and element chunks are independent once their section is known.
+    // Their line counts bound the entity counts, so the final arrays are
+    // allocated once up front instead of regrowing with every merge.
+    std::vector<size_t> nodeChunks;
+    std::vector<size_t> elementChunks;
+    size_t nodeLines = 0;
+    size_t elementLines = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (chunks[i].state == STATE_NODES) {
+            nodeChunks.push_back(i);
+            nodeLines += chunks[i].lineCount;
+        } else if (chunks[i].state == STATE_ELEMENTS) {
+            elementChunks.push_back(i);
+            elementLines += chunks[i].lineCount;
+        }
+    }
+    nodes_.reserve(nodes_.size() + nodeLines);
+    elements_.reserve(elements_.size() + elementLines);
+    
+    // One arena per element chunk, sized for the node count its keyword
+    // declares so a chunk normally takes a single block
+    for (size_t index : elementChunks) {
+        const ParseChunk& chunk = chunks[index];
+        int nodesPerElement = RadFileUtils::getElementNodeCount(chunk.elementType);
+        size_t bytes = static_cast<size_t>(chunk.lineCount) *
+                       (nodesPerElement > 0 ? nodesPerElement : 4) * sizeof(int);
+        connectivityArenas_.push_back(
+            std::make_unique<std::pmr::monotonic_buffer_resource>(std::max<size_t>(bytes, 256)));
+        results[index].connectivity = connectivityArenas_.back().get();
+    }
+    
+    // Nodes go first so a viewer can show them while elements are parsed
+    if (!parseDataChunks(data, chunks, nodeChunks, results)) {
+        return false;
+    }
+    if (nodesReadyCallback_) {
+        nodesReadyCallback_(nodes_);
+    }
+    if (!parseDataChunks(data, chunks, elementChunks, results)) {
+        return false;
+    }
+    
+    // The first failing data line bounds how far the serial sections may go
+    int errorLine = 0;
+    for (const auto& result : results) {
+        if (result.errorLine != 0 && (errorLine == 0 || result.errorLine < errorLine)) {
+            errorLine = result.errorLine;
+        }
+    }
+    
+    // Everything else is small and order dependent (title, cards with names)
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (errorLine != 0 && chunks[i].firstLine > errorLine) {
+            break;
+        }
+        if (chunks[i].state != STATE_NODES && chunks[i].state != STATE_ELEMENTS) {
+            parseSerialChunk(data, chunks[i], errorLine, results[i]);
+            if (results[i].errorLine != 0) {
+                break; // Later chunks cannot hold an earlier error
+            }
+            if (progress_) {
+                progress_->bytesParsed += chunks[i].end - chunks[i].begin;
+            }
+        }
+    }
+    
+    // Keep what a serial parse would have produced up to the first failure
+    size_t keptNodes = 0;
+    size_t keptElements = 0;
+    for (const auto& result : results) {
+        keptNodes += result.nodeCount;
+        keptElements += result.elementCount;
+        
+        if (result.errorLine != 0) {
+            setError("Parse error at line " + std::to_string(result.errorLine) + ": " +
+                     result.errorText);
+            nodes_.resize(std::min(nodes_.size(), keptNodes));
+            elements_.resize(std::min(elements_.size(), keptElements));
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool RadFileReader::parseDataChunks(std::string_view data, const std::vector<ParseChunk>& chunks,
+                                    const std::vector<size_t>& indices,
+                                    std::vector<ChunkResult>& results) {
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const size_t batchSize = std::max<size_t>(2, pool.GetThreadCount() * 2);
+    
+    // Batches keep merges (and element callbacks) flowing during long loads
+    for (size_t batchBegin = 0; batchBegin < indices.size(); batchBegin += batchSize) {
+        if (isCancelled()) {
+            setError("Loading cancelled");
+            return false;
+        }
+        
+        size_t batchEnd = std::min(indices.size(), batchBegin + batchSize);
+        pool.ParallelFor(batchEnd - batchBegin, 1, [&](size_t begin, size_t end) {
+            for (size_t i = batchBegin + begin; i < batchBegin + end; ++i) {
+                size_t index = indices[i];
+                parseDataChunk(data, chunks[index], results[index]);
+                if (progress_) {
+                    progress_->bytesParsed += chunks[index].end - chunks[index].begin;
+                    progress_->nodesParsed += results[index].nodes.size();
+                    progress_->elementsParsed += results[index].elements.size();
+                }
+            }
+        });
+        
+        // Merge in file order, stopping after the first chunk that failed
+        size_t firstNewElement = elements_.size();
+        bool failed = false;
+        for (size_t i = batchBegin; i < batchEnd && !failed; ++i) {
+            ChunkResult& result = results[indices[i]];
+            result.nodeCount = result.nodes.size();
+            result.elementCount = result.elements.size();
+            
+            std::move(result.nodes.begin(), result.nodes.end(), std::back_inserter(nodes_));
+            std::move(result.elements.begin(), result.elements.end(),
+                      std::back_inserter(elements_));
+            result.nodes = std::vector<Node>();
+            result.elements = std::vector<Element>();
+            
+            failed = result.errorLine != 0;
+        }
+        
+        if (elementsReadyCallback_ && elements_.size() > firstNewElement) {
+            elementsReadyCallback_(elements_, firstNewElement, elements_.size() - firstNewElement);
+        }
+        if (failed) {
+            break;
+        }
+    }
+    
+    return true;
+}
+
+bool RadFileReader::isCancelled() const {
+    return progress_ && progress_->cancelRequested.load();
+}
+
+std::vector<RadFileReader::ParseChunk> RadFileReader::scanChunks(std::string_view data) const {
+    // Keyword recognition only depends on the line itself, so the file is cut
+    // into line-aligned ranges that are scanned concurrently. Each range
+    // reports its line count and keyword lines; a serial merge then turns
+    // those into chunks with absolute line numbers.
+    struct KeywordLine {
+        size_t lineBegin;
+        size_t nextLine;
+        int relativeLine;
+        ParseState state;
+        Element::Type elementType;
+    };
+    struct ScanRange {
+        size_t begin = 0;
+        size_t end = 0;
+        int lineCount = 0;
+        std::vector<KeywordLine> keywords;
+    };
+    
+    const size_t rangeBytes = 4u << 20;
+    size_t rangeCount = std::max<size_t>(1, (data.size() + rangeBytes - 1) / rangeBytes);
+    
+    std::vector<ScanRange> ranges(rangeCount);
+    size_t previousEnd = 0;
+    for (size_t i = 0; i < rangeCount; ++i) {
+        size_t end = data.size();
+        if (i + 1 < rangeCount) {
+            size_t target = std::max(previousEnd, (i + 1) * rangeBytes);
+            size_t newline = data.find('\n', target);
+            end = newline == std::string_view::npos ? data.size() : newline + 1;
+        }
+        ranges[i].begin = previousEnd;
+        ranges[i].end = end;
+        previousEnd = end;
+    }
+    
+    ThreadPool::GetGlobal().ParallelFor(rangeCount, 1, [&](size_t first, size_t last) {
+        for (size_t r = first; r < last; ++r) {
+            ScanRange& range = ranges[r];
+            size_t pos = range.begin;
+            while (pos < range.end) {
+                const void* newline = std::memchr(data.data() + pos, '\n', range.end - pos);
+                size_t lineEnd = newline ? static_cast<const char*>(newline) - data.data()
+                                         : range.end;
+                std::string_view line = data.substr(pos, lineEnd - pos);
+                
+                ParseState state;
+                Element::Type elementType;
+                if (!isEmpty(line) && !isComment(line) &&
+                    determineSection(line, state, elementType)) {
+                    range.keywords.push_back({pos, lineEnd + 1, range.lineCount, state,
+                                              elementType});
+                }
+                
+                range.lineCount++;
+                pos = lineEnd + 1;
+            }
+        }
+    });
+    
+    std::vector<ParseChunk> chunks;
     ParseState currentState = STATE_HEADER;
-    int lineNumber = 0;
+    Element::Type currentType = Element::UNKNOWN;
+    int lineBase = 1;
     
-    while (std::getline(file, line)) {
+    for (const auto& range : ranges) {
+        ParseChunk chunk{currentState, range.begin, range.end, lineBase, currentType};
+        
+        for (const auto& keyword : range.keywords) {
+            chunk.end = keyword.lineBegin;
+            chunk.lineCount = lineBase + keyword.relativeLine - chunk.firstLine;
+            if (chunk.begin < chunk.end) {
+                chunks.push_back(chunk);
+            }
+            
+            currentState = keyword.state;
+            currentType = keyword.elementType;
+            chunk = ParseChunk{currentState, std::min(keyword.nextLine, range.end), range.end,
+                               lineBase + keyword.relativeLine + 1, currentType};
+        }
+        
+        chunk.end = range.end;
+        chunk.lineCount = lineBase + range.lineCount - chunk.firstLine;
+        if (chunk.begin < chunk.end) {
+            chunks.push_back(chunk);
+        }
+        lineBase += range.lineCount;
+    }
+    
+    return chunks;
+}
+
+void RadFileReader::parseDataChunk(std::string_view data, const ParseChunk& chunk,
+                                   ChunkResult& result) const {
+    std::vector<std::string_view> tokens;
+    int lineNumber = chunk.firstLine;
+    
+    if (chunk.state == STATE_NODES) {
+        result.nodes.reserve(chunk.lineCount);
+    } else {
+        result.elements.reserve(chunk.lineCount);
+    }
+    
+    size_t pos = chunk.begin;
+    while (pos < chunk.end) {
+        const void* newline = std::memchr(data.data() + pos, '\n', chunk.end - pos);
+        size_t end = newline ? static_cast<const char*>(newline) - data.data() : chunk.end;
+        std::string_view line = data.substr(pos, end - pos);
+        pos = end + 1;
+        
+        if (!isEmpty(line) && !isComment(line)) {
+            bool parseSuccess = chunk.state == STATE_NODES
+                ? parseNode(line, tokens, result.nodes)
+                : parseElement(line, tokens, chunk.elementType, result.connectivity,
+                               result.elements);
+            
+            if (!parseSuccess) {
+                result.errorLine = lineNumber;
+                result.errorText = std::string(line);
+                return;
+            }
+        }
         lineNumber++;
+    }
+}
+
+void RadFileReader::parseSerialChunk(std::string_view data, const ParseChunk& chunk,
+                                     int stopLine, ChunkResult& result) {
+    int lineNumber = chunk.firstLine;
+    
+    size_t pos = chunk.begin;
+    while (pos < chunk.end && (stopLine == 0 || lineNumber < stopLine)) {
+        const void* newline = std::memchr(data.data() + pos, '\n', chunk.end - pos);
+        size_t end = newline ? static_cast<const char*>(newline) - data.data() : chunk.end;
+        std::string_view line = data.substr(pos, end - pos);
+        pos = end + 1;
         
         // Skip empty lines and comments
         if (isEmpty(line) || isComment(line)) {
+            lineNumber++;
             continue;
         }
         
-        // Determine section based on keywords
-        ParseState newState = determineSection(line);
-        if (newState != STATE_UNKNOWN) {
-            currentState = newState;
-            continue; // Skip the keyword line itself
-        }
-        
         // Parse content based on current state
         bool parseSuccess = false;
-        switch (currentState) {
+        switch (chunk.state) {
             case STATE_HEADER:
                 parseSuccess = parseHeader(line);
                 break;
             case STATE_TITLE:
                 parseSuccess = parseTitle(line);
                 break;
-            case STATE_NODES:
-                parseSuccess = parseNode(line);
-                break;
-            case STATE_ELEMENTS:
-                parseSuccess = parseElement(line);
-                break;
             case STATE_MATERIALS:
                 parseSuccess = parseMaterial(line);
                 break;
@@ -131,314 +497,337 @@ bool RadFileReader::parseFile(std::ifstream& file) {
         }
         
         if (!parseSuccess) {
-            setError("Parse error at line " + std::to_string(lineNumber) + ": " + line);
-            return false;
+            result.errorLine = lineNumber;
+            result.errorText = std::string(line);
+            return;
         }
+        lineNumber++;
+    }
+}
+
+bool RadFileReader::determineSection(std::string_view line, ParseState& state,
+                                     Element::Type& elementType) const {
+    // Only lines starting with '/' are keywords; data lines cost one compare
+    size_t start = 0;
+    while (start < line.size() && (line[start] == ' ' || line[start] == '\t')) {
+        ++start;
     }
     
+    KeywordPath path;
+    if (!parseKeywordPath(line.substr(start), path)) {
+        return false;
+    }
+    
+    // Keywords outside the table (/END, /ANIM, ...) open a section that is skipped
+    state = STATE_UNKNOWN;
+    elementType = Element::UNKNOWN;
+    if (!path.info) {
+        return true;
+    }
+    
+    switch (path.info->section) {
+        case KeywordSection::HEADER:              state = STATE_HEADER; break;
+        case KeywordSection::TITLE:               state = STATE_TITLE; break;
+        case KeywordSection::NODES:               state = STATE_NODES; break;
+        case KeywordSection::ELEMENTS:            state = STATE_ELEMENTS; break;
+        case KeywordSection::MATERIALS:           state = STATE_MATERIALS; break;
+        case KeywordSection::PROPERTIES:          state = STATE_PROPERTIES; break;
+        case KeywordSection::LOADS:               state = STATE_LOADS; break;
+        case KeywordSection::BOUNDARY_CONDITIONS: state = STATE_BOUNDARY_CONDITIONS; break;
+    }
+    elementType = path.info->elementType;
     return true;
 }
 
-RadFileReader::ParseState RadFileReader::determineSection(const std::string& line) {
-    std::string upperLine = line;
-    std::transform(upperLine.begin(), upperLine.end(), upperLine.begin(), ::toupper);
-    
-    if (upperLine.find("/TITLE") != std::string::npos) return STATE_TITLE;
-    if (upperLine.find("/NODE") != std::string::npos) return STATE_NODES;
-    if (upperLine.find("/CNODE") != std::string::npos) return STATE_NODES;
-    if (upperLine.find("/BRICK") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/HEXA") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/TETRA4") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/TETRA10") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/SHELL") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/SH3N") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/QUAD") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/TRIA") != std::string::npos) return STATE_ELEMENTS;
-    if (upperLine.find("/MAT") != std::string::npos) return STATE_MATERIALS;
-    if (upperLine.find("/PROP") != std::string::npos) return STATE_PROPERTIES;
-    if (upperLine.find("/PART") != std::string::npos) return STATE_PROPERTIES;
-    if (upperLine.find("/LOAD") != std::string::npos) return STATE_LOADS;
-    if (upperLine.find("/CLOAD") != std::string::npos) return STATE_LOADS;
-    if (upperLine.find("/PLOAD") != std::string::npos) return STATE_LOADS;
-    if (upperLine.find("/BCS") != std::string::npos) return STATE_BOUNDARY_CONDITIONS;
-    if (upperLine.find("/SPC") != std::string::npos) return STATE_BOUNDARY_CONDITIONS;
-    if (upperLine.find("/IMPVEL") != std::string::npos) return STATE_BOUNDARY_CONDITIONS;
-    
-    return STATE_UNKNOWN;
-}
-
-bool RadFileReader::parseHeader(const std::string& line) {
-    if (line.find("#RADIOSS") != std::string::npos) {
+bool RadFileReader::parseHeader(std::string_view line) {
+    if (line.find("#RADIOSS") != std::string_view::npos) {
         // Extract version if present
         std::regex versionRegex(R"(version\s*(\d+(?:\.\d+)?))");
-        std::smatch match;
-        if (std::regex_search(line, match, versionRegex)) {
+        std::cmatch match;
+        if (std::regex_search(line.data(), line.data() + line.size(), match, versionRegex)) {
             version_ = match[1].str();
         }
         return true;
     }
-    if (line.find("/BEGIN") != std::string::npos) {
+    if (line.find("/BEGIN") != std::string_view::npos) {
         return true;
     }
     return true; // Accept any header content
 }
 
-bool RadFileReader::parseTitle(const std::string& line) {
+bool RadFileReader::parseTitle(std::string_view line) {
     if (title_.empty()) {
-        title_ = trim(line);
+        title_ = std::string(trim(line));
     } else {
-        title_ += " " + trim(line);
+        title_ += " ";
+        title_ += trim(line);
     }
     return true;
 }
 
-bool RadFileReader::parseNode(const std::string& line) {
-    auto tokens = tokenizeLine(line);
+bool RadFileReader::parseNode(std::string_view line, std::vector<std::string_view>& tokens,
+                              std::vector<Node>& nodes) const {
+    // Column decoding handles I10/F20 fields that run together
+    if (!splitFixedFields(line, kNodeLayout, tokens)) {
+        tokenizeLine(line, tokens);
+    }
     if (tokens.size() < 4) {
         return false;
     }
     
-    try {
-        Node node;
-        node.id = std::stoi(tokens[0]);
-        node.position.x = std::stof(tokens[1]);
-        node.position.y = std::stof(tokens[2]);
-        node.position.z = std::stof(tokens[3]);
-        
-        nodes_.push_back(node);
-        return true;
-    } catch (const std::exception&) {
+    Node node;
+    if (!parseInt(tokens[0], node.id) ||
+        !parseFloat(tokens[1], node.position.x) ||
+        !parseFloat(tokens[2], node.position.y) ||
+        !parseFloat(tokens[3], node.position.z)) {
         return false;
     }
+    
+    nodes.push_back(std::move(node));
+    return true;
 }
 
-bool RadFileReader::parseElement(const std::string& line) {
-    auto tokens = tokenizeLine(line);
+bool RadFileReader::parseElement(std::string_view line, std::vector<std::string_view>& tokens,
+                                 Element::Type declaredType,
+                                 std::pmr::memory_resource* connectivity,
+                                 std::vector<Element>& elements) const {
+    if (!splitFixedFields(line, kElementLayout, tokens)) {
+        tokenizeLine(line, tokens);
+    }
     if (tokens.size() < 3) {
         return false;
     }
     
-    try {
-        Element element;
-        element.id = std::stoi(tokens[0]);
+    Element element(connectivity ? connectivity : std::pmr::get_default_resource());
+    if (!parseInt(tokens[0], element.id)) {
+        return false;
+    }
+    
+    // Try to determine element type from context or node count
+    size_t nodeCount = tokens.size() - 3; // Subtract ID, material, property
+    if (nodeCount >= 2) {
+        if (!parseInt(tokens[1], element.materialId) ||
+            !parseInt(tokens[2], element.propertyId)) {
+            return false;
+        }
         
-        // Try to determine element type from context or node count
-        size_t nodeCount = tokens.size() - 3; // Subtract ID, material, property
-        if (nodeCount >= 2) {
-            element.materialId = std::stoi(tokens[1]);
-            element.propertyId = std::stoi(tokens[2]);
-            
-            // Determine element type based on node count
+        // The keyword names the type (/SHELL vs /TETRA4 both have four nodes).
+        // Cards that don't match it, e.g. triangles in a /SHELL block, and
+        // keywords without a fixed type fall back to the node count.
+        if (declaredType != Element::UNKNOWN &&
+            RadFileUtils::getElementNodeCount(declaredType) == static_cast<int>(nodeCount)) {
+            element.type = declaredType;
+        } else {
             switch (nodeCount) {
                 case 3: element.type = Element::TRIA3; break;
-                case 4: 
-                    // Could be QUAD4 or TETRA4 - need more context
-                    element.type = Element::QUAD4; 
-                    break;
+                case 4: element.type = Element::QUAD4; break;
                 case 5: element.type = Element::PYRAM5; break;
                 case 6: element.type = Element::PENTA6; break;
                 case 8: element.type = Element::HEXA8; break;
                 default: element.type = Element::UNKNOWN; break;
             }
-            
-            // Extract node IDs
-            for (size_t i = 3; i < tokens.size(); ++i) {
-                element.nodeIds.push_back(std::stoi(tokens[i]));
-            }
         }
         
-        elements_.push_back(element);
-        return true;
-    } catch (const std::exception&) {
-        return false;
+        // Extract node IDs
+        element.nodeIds.reserve(nodeCount);
+        for (size_t i = 3; i < tokens.size(); ++i) {
+            int nodeId;
+            if (!parseInt(tokens[i], nodeId)) {
+                return false;
+            }
+            element.nodeIds.push_back(nodeId);
+        }
     }
+    
+    elements.push_back(std::move(element));
+    return true;
 }
 
-bool RadFileReader::parseMaterial(const std::string& line) {
-    auto tokens = tokenizeLine(line);
-    if (tokens.size() < 2) {
+bool RadFileReader::parseMaterial(std::string_view line) {
+    tokenizeLine(line, tokens_);
+    if (tokens_.size() < 2) {
         return false;
     }
     
-    try {
-        Material material;
-        material.id = std::stoi(tokens[0]);
-        
-        // Extract material type if present
-        if (tokens.size() > 1) {
-            material.type = tokens[1];
-        }
-        
-        // Parse material properties (density, young's modulus, etc.)
-        for (size_t i = 2; i < tokens.size(); i += 2) {
-            if (i + 1 < tokens.size()) {
-                std::string propName = tokens[i];
-                double propValue = std::stod(tokens[i + 1]);
-                material.properties[propName] = propValue;
+    Material material;
+    if (!parseInt(tokens_[0], material.id)) {
+        return false;
+    }
+    
+    // Extract material type if present
+    if (tokens_.size() > 1) {
+        material.type = std::string(tokens_[1]);
+    }
+    material.properties = ParameterTable(ParameterSchema::ForType(material.type));
+    
+    // Parse material properties (density, young's modulus, etc.)
+    for (size_t i = 2; i < tokens_.size(); i += 2) {
+        if (i + 1 < tokens_.size()) {
+            double propValue;
+            if (!parseDouble(tokens_[i + 1], propValue)) {
+                return false;
             }
+            material.properties.Set(tokens_[i], propValue);
         }
-        
-        materials_.push_back(material);
-        return true;
-    } catch (const std::exception&) {
-        return false;
     }
+    
+    materials_.push_back(std::move(material));
+    return true;
 }
 
-bool RadFileReader::parseProperty(const std::string& line) {
-    auto tokens = tokenizeLine(line);
-    if (tokens.size() < 2) {
+bool RadFileReader::parseProperty(std::string_view line) {
+    tokenizeLine(line, tokens_);
+    if (tokens_.size() < 2) {
         return false;
     }
     
-    try {
-        Property property;
-        property.id = std::stoi(tokens[0]);
-        
-        if (tokens.size() > 1) {
-            property.type = tokens[1];
-        }
-        
-        // Parse property values
-        for (size_t i = 2; i < tokens.size(); i += 2) {
-            if (i + 1 < tokens.size()) {
-                std::string propName = tokens[i];
-                double propValue = std::stod(tokens[i + 1]);
-                property.values[propName] = propValue;
+    Property property;
+    if (!parseInt(tokens_[0], property.id)) {
+        return false;
+    }
+    
+    if (tokens_.size() > 1) {
+        property.type = std::string(tokens_[1]);
+    }
+    property.values = ParameterTable(ParameterSchema::ForType(property.type));
+    
+    // Parse property values
+    for (size_t i = 2; i < tokens_.size(); i += 2) {
+        if (i + 1 < tokens_.size()) {
+            double propValue;
+            if (!parseDouble(tokens_[i + 1], propValue)) {
+                return false;
             }
+            property.values.Set(tokens_[i], propValue);
         }
-        
-        properties_.push_back(property);
-        return true;
-    } catch (const std::exception&) {
-        return false;
     }
+    
+    properties_.push_back(std::move(property));
+    return true;
 }
 
-bool RadFileReader::parseLoadCase(const std::string& line) {
-    auto tokens = tokenizeLine(line);
-    if (tokens.size() < 5) {
+bool RadFileReader::parseLoadCase(std::string_view line) {
+    tokenizeLine(line, tokens_);
+    if (tokens_.size() < 5) {
         return false;
     }
     
-    try {
-        LoadCase loadCase;
-        loadCase.id = std::stoi(tokens[0]);
-        loadCase.type = tokens[1];
-        loadCase.magnitude = std::stod(tokens[2]);
-        loadCase.vector.x = std::stof(tokens[3]);
-        loadCase.vector.y = std::stof(tokens[4]);
-        if (tokens.size() > 5) {
-            loadCase.vector.z = std::stof(tokens[5]);
-        }
-        
-        // Extract affected node IDs
-        for (size_t i = 6; i < tokens.size(); ++i) {
-            loadCase.nodeIds.push_back(std::stoi(tokens[i]));
-        }
-        
-        loadCases_.push_back(loadCase);
-        return true;
-    } catch (const std::exception&) {
+    LoadCase loadCase;
+    if (!parseInt(tokens_[0], loadCase.id)) {
+        return false;
+    }
+    loadCase.type = std::string(tokens_[1]);
+    if (!parseDouble(tokens_[2], loadCase.magnitude) ||
+        !parseFloat(tokens_[3], loadCase.vector.x) ||
+        !parseFloat(tokens_[4], loadCase.vector.y)) {
         return false;
     }
+    if (tokens_.size() > 5 && !parseFloat(tokens_[5], loadCase.vector.z)) {
+        return false;
+    }
+    
+    // Extract affected node IDs
+    for (size_t i = 6; i < tokens_.size(); ++i) {
+        int nodeId;
+        if (!parseInt(tokens_[i], nodeId)) {
+            return false;
+        }
+        loadCase.nodeIds.push_back(nodeId);
+    }
+    
+    loadCases_.push_back(std::move(loadCase));
+    return true;
 }
 
-bool RadFileReader::parseBoundaryCondition(const std::string& line) {
-    auto tokens = tokenizeLine(line);
-    if (tokens.size() < 3) {
+bool RadFileReader::parseBoundaryCondition(std::string_view line) {
+    tokenizeLine(line, tokens_);
+    if (tokens_.size() < 3) {
         return false;
     }
     
-    try {
-        BoundaryCondition bc;
-        bc.id = std::stoi(tokens[0]);
-        bc.type = tokens[1];
-        
-        // Parse DOF constraints
-        for (size_t i = 2; i < tokens.size(); ++i) {
-            if (tokens[i].find_first_of("123456") != std::string::npos) {
-                // DOF specification
-                for (char c : tokens[i]) {
-                    if (c >= '1' && c <= '6') {
-                        bc.dofs.push_back(c - '0');
-                    }
+    BoundaryCondition bc;
+    if (!parseInt(tokens_[0], bc.id)) {
+        return false;
+    }
+    bc.type = std::string(tokens_[1]);
+    
+    // Parse DOF constraints
+    for (size_t i = 2; i < tokens_.size(); ++i) {
+        if (tokens_[i].find_first_of("123456") != std::string_view::npos) {
+            // DOF specification
+            for (char c : tokens_[i]) {
+                if (c >= '1' && c <= '6') {
+                    bc.dofs.push_back(c - '0');
                 }
-            } else {
-                // Node ID
-                bc.nodeIds.push_back(std::stoi(tokens[i]));
             }
+        } else {
+            // Node ID
+            int nodeId;
+            if (!parseInt(tokens_[i], nodeId)) {
+                return false;
+            }
+            bc.nodeIds.push_back(nodeId);
         }
-        
-        boundaryConditions_.push_back(bc);
-        return true;
-    } catch (const std::exception&) {
-        return false;
     }
+    
+    boundaryConditions_.push_back(std::move(bc));
+    return true;
 }
 
-std::vector<std::string> RadFileReader::tokenizeLine(const std::string& line, char delimiter) const {
-    std::vector<std::string> tokens;
-    std::stringstream ss(line);
-    std::string token;
+void RadFileReader::tokenizeLine(std::string_view line, std::vector<std::string_view>& tokens,
+                                 char delimiter) const {
+    // Tokens point into the mapped file; the vector keeps its capacity between lines
+    tokens.clear();
     
-    while (std::getline(ss, token, delimiter)) {
-        token = trim(token);
+    size_t start = 0;
+    while (start <= line.size()) {
+        size_t end = line.find(delimiter, start);
+        if (end == std::string_view::npos) {
+            end = line.size();
+        }
+        std::string_view token = trim(line.substr(start, end - start));
         if (!token.empty()) {
             tokens.push_back(token);
         }
+        start = end + 1;
     }
-    
-    return tokens;
 }
 
-std::string RadFileReader::trim(const std::string& str) const {
+std::string_view RadFileReader::trim(std::string_view str) const {
     size_t start = str.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) return "";
+    if (start == std::string_view::npos) return std::string_view();
     
     size_t end = str.find_last_not_of(" \t\r\n");
     return str.substr(start, end - start + 1);
 }
 
-bool RadFileReader::isComment(const std::string& line) const {
-    std::string trimmed = trim(line);
+bool RadFileReader::isComment(std::string_view line) const {
+    std::string_view trimmed = trim(line);
     return trimmed.empty() || trimmed[0] == '#' || trimmed[0] == 'C' || trimmed[0] == 'c';
 }
 
-bool RadFileReader::isEmpty(const std::string& line) const {
+bool RadFileReader::isEmpty(std::string_view line) const {
     return trim(line).empty();
 }
 
 const Node* RadFileReader::findNode(int id) const {
-    auto it = nodeIdToIndex_.find(id);
-    if (it != nodeIdToIndex_.end() && it->second < nodes_.size()) {
-        return &nodes_[it->second];
-    }
-    return nullptr;
+    const IdEntry* entry = lookupId(nodeIdToIndex_, id);
+    return entry ? &nodes_[entry->index] : nullptr;
 }
 
 const Element* RadFileReader::findElement(int id) const {
-    auto it = elementIdToIndex_.find(id);
-    if (it != elementIdToIndex_.end() && it->second < elements_.size()) {
-        return &elements_[it->second];
-    }
-    return nullptr;
+    const IdEntry* entry = lookupId(elementIdToIndex_, id);
+    return entry ? &elements_[entry->index] : nullptr;
 }
 
 const Material* RadFileReader::findMaterial(int id) const {
-    auto it = materialIdToIndex_.find(id);
-    if (it != materialIdToIndex_.end() && it->second < materials_.size()) {
-        return &materials_[it->second];
-    }
-    return nullptr;
+    const IdEntry* entry = lookupId(materialIdToIndex_, id);
+    return entry ? &materials_[entry->index] : nullptr;
 }
 
 const Property* RadFileReader::findProperty(int id) const {
-    auto it = propertyIdToIndex_.find(id);
-    if (it != propertyIdToIndex_.end() && it->second < properties_.size()) {
-        return &properties_[it->second];
-    }
-    return nullptr;
+    const IdEntry* entry = lookupId(propertyIdToIndex_, id);
+    return entry ? &properties_[entry->index] : nullptr;
 }
 
 std::pair<glm::vec3, glm::vec3> RadFileReader::getBoundingBox() const {
@@ -477,68 +866,183 @@ void RadFileReader::addProperty(const Property& property) {
     buildLookupTables();
 }
 
-bool RadFileReader::validateData() const {
-    return validateNodes() && validateElements() && validateReferences();
-}
-
-bool RadFileReader::validateNodes() const {
-    std::unordered_set<int> nodeIds;
-    for (const auto& node : nodes_) {
-        if (nodeIds.count(node.id)) {
-            return false; // Duplicate node ID
+// Issues collected by one range of the validation pass. Ranges keep at most
+// kMaxStoredIssues each, which is enough for the merged list to be full.
+struct RadFileReader::IssueList {
+    std::vector<ValidationIssue> issues;
+    size_t count = 0;
+    
+    void add(ValidationIssue::Kind kind, int entityId, size_t index, int detail) {
+        ++count;
+        if (issues.size() < kMaxStoredIssues) {
+            issues.push_back({kind, entityId, index, detail});
         }
-        nodeIds.insert(node.id);
     }
-    return true;
-}
+};
 
-bool RadFileReader::validateElements() const {
-    std::unordered_set<int> elementIds;
-    for (const auto& element : elements_) {
-        if (elementIds.count(element.id)) {
-            return false; // Duplicate element ID
+bool RadFileReader::validateData(bool checkReferences) {
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const size_t grainSize = 1u << 16;
+    
+    // Duplicates are neighbours in the sorted tables; the later one is reported
+    auto findDuplicates = [&](const IdTable& table, ValidationIssue::Kind kind) {
+        size_t rangeCount = (table.size() + grainSize - 1) / grainSize;
+        std::vector<IssueList> lists(rangeCount);
+        pool.ParallelFor(rangeCount, 1, [&](size_t first, size_t last) {
+            for (size_t range = first; range < last; ++range) {
+                size_t begin = std::max<size_t>(1, range * grainSize);
+                size_t end = std::min(table.size(), (range + 1) * grainSize);
+                for (size_t i = begin; i < end; ++i) {
+                    if (table[i].id != table[i - 1].id) {
+                        continue;
+                    }
+                    size_t firstIndex = i - 1;
+                    while (firstIndex > 0 && table[firstIndex - 1].id == table[i].id) {
+                        --firstIndex;
+                    }
+                    lists[range].add(kind, table[i].id, table[i].index,
+                                     static_cast<int>(table[firstIndex].index));
+                }
+            }
+        });
+        return lists;
+    };
+    
+    std::vector<IssueList> nodeLists = findDuplicates(nodeIdToIndex_, ValidationIssue::DUPLICATE_NODE_ID);
+    std::vector<IssueList> elementIdLists = findDuplicates(elementIdToIndex_, ValidationIssue::DUPLICATE_ELEMENT_ID);
+    
+    // Node counts and node references, one pass over element ranges
+    size_t rangeCount = (elements_.size() + grainSize - 1) / grainSize;
+    std::vector<IssueList> elementLists(rangeCount);
+    pool.ParallelFor(rangeCount, 1, [&](size_t first, size_t last) {
+        for (size_t range = first; range < last; ++range) {
+            IssueList& list = elementLists[range];
+            size_t end = std::min(elements_.size(), (range + 1) * grainSize);
+            for (size_t i = range * grainSize; i < end; ++i) {
+                const Element& element = elements_[i];
+                
+                int expectedNodes = RadFileUtils::getElementNodeCount(element.type);
+                int nodeCount = static_cast<int>(element.nodeIds.size());
+                if (expectedNodes > 0 && nodeCount != expectedNodes) {
+                    list.add(ValidationIssue::WRONG_NODE_COUNT, element.id, i, nodeCount);
+                }
+                
+                if (!checkReferences) {
+                    continue;
+                }
+                for (int nodeId : element.nodeIds) {
+                    if (!lookupId(nodeIdToIndex_, nodeId)) {
+                        list.add(ValidationIssue::MISSING_NODE, element.id, i, nodeId);
+                    }
+                }
+            }
         }
-        elementIds.insert(element.id);
-        
-        // Validate node count for element type
-        int expectedNodes = RadFileUtils::getElementNodeCount(element.type);
-        if (expectedNodes > 0 && static_cast<int>(element.nodeIds.size()) != expectedNodes) {
-            return false;
+    });
+    
+    // Merge in report order: node IDs, element IDs, then element contents
+    validationIssues_.clear();
+    validationIssueCount_ = 0;
+    for (auto* lists : {&nodeLists, &elementIdLists, &elementLists}) {
+        for (IssueList& list : *lists) {
+            validationIssueCount_ += list.count;
+            size_t room = kMaxStoredIssues - validationIssues_.size();
+            size_t take = std::min(room, list.issues.size());
+            validationIssues_.insert(validationIssues_.end(), list.issues.begin(),
+                                     list.issues.begin() + take);
         }
     }
-    return true;
+    
+    return validationIssueCount_ == 0;
 }
 
-bool RadFileReader::validateReferences() const {
-    // Check that all element node references are valid
-    for (const auto& element : elements_) {
-        for (int nodeId : element.nodeIds) {
-            if (!findNode(nodeId)) {
-                return false; // Invalid node reference
-            }
+template<typename T>
+void RadFileReader::buildIdTable(const std::vector<T>& items, IdTable& table) {
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    const size_t grainSize = 1u << 16;
+    
+    table.resize(items.size());
+    pool.ParallelFor(items.size(), grainSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            table[i] = {items[i].id, i};
         }
+    });
+    
+    auto less = [](const IdEntry& a, const IdEntry& b) {
+        return a.id < b.id || (a.id == b.id && a.index < b.index);
+    };
+    
+    // Decks are usually written in ID order already
+    if (std::is_sorted(table.begin(), table.end(), less)) {
+        return;
     }
-    return true;
-}
-
-void RadFileReader::buildLookupTables() {
-    clearLookupTables();
     
-    for (size_t i = 0; i < nodes_.size(); ++i) {
-        nodeIdToIndex_[nodes_[i].id] = i;
+    size_t runCount = std::min(pool.GetThreadCount() + 1, (table.size() + grainSize - 1) / grainSize);
+    if (runCount < 2) {
+        std::sort(table.begin(), table.end(), less);
+        return;
     }
     
-    for (size_t i = 0; i < elements_.size(); ++i) {
-        elementIdToIndex_[elements_[i].id] = i;
+    // Sort runs concurrently, then merge neighbouring runs pairwise
+    size_t runSize = (table.size() + runCount - 1) / runCount;
+    pool.ParallelFor(runCount, 1, [&](size_t first, size_t last) {
+        for (size_t run = first; run < last; ++run) {
+            size_t begin = std::min(table.size(), run * runSize);
+            size_t end = std::min(table.size(), begin + runSize);
+            std::sort(table.begin() + begin, table.begin() + end, less);
+        }
+    });
+    
+    IdTable buffer(table.size());
+    IdTable* source = &table;
+    IdTable* target = &buffer;
+    for (size_t width = runSize; width < table.size(); width *= 2) {
+        size_t pairCount = (table.size() + 2 * width - 1) / (2 * width);
+        pool.ParallelFor(pairCount, 1, [&](size_t first, size_t last) {
+            for (size_t pair = first; pair < last; ++pair) {
+                size_t begin = pair * 2 * width;
+                size_t middle = std::min(table.size(), begin + width);
+                size_t end = std::min(table.size(), begin + 2 * width);
+                std::merge(source->begin() + begin, source->begin() + middle,
+                           source->begin() + middle, source->begin() + end,
+                           target->begin() + begin, less);
+            }
+        });
+        std::swap(source, target);
+    }
+    
+    if (source != &table) {
+        table.swap(buffer);
+    }
+}
+
+const RadFileReader::IdEntry* RadFileReader::lookupId(const IdTable& table, int id) {
+    if (table.empty()) {
+        return nullptr;
     }
     
-    for (size_t i = 0; i < materials_.size(); ++i) {
-        materialIdToIndex_[materials_[i].id] = i;
+    // Contiguous IDs put every entry at id - firstId; try that before searching
+    int64_t offset = static_cast<int64_t>(id) - table.front().id;
+    if (offset >= 0 && offset < static_cast<int64_t>(table.size())) {
+        size_t slot = static_cast<size_t>(offset);
+        if (table[slot].id == id && (slot + 1 == table.size() || table[slot + 1].id != id)) {
+            return &table[slot];
+        }
     }
     
-    for (size_t i = 0; i < properties_.size(); ++i) {
-        propertyIdToIndex_[properties_[i].id] = i;
+    // Last entry with this ID, matching the old overwrite-on-insert behaviour
+    auto it = std::upper_bound(table.begin(), table.end(), id,
+                               [](int value, const IdEntry& entry) { return value < entry.id; });
+    if (it == table.begin() || (it - 1)->id != id) {
+        return nullptr;
     }
+    return &*(it - 1);
+}
+
+void RadFileReader::buildLookupTables() {
+    buildIdTable(nodes_, nodeIdToIndex_);
+    buildIdTable(elements_, elementIdToIndex_);
+    buildIdTable(materials_, materialIdToIndex_);
+    buildIdTable(properties_, propertyIdToIndex_);
 }
 
 void RadFileReader::clearLookupTables() {
@@ -556,30 +1060,34 @@ void RadFileReader::clearError() {
     lastError_.clear();
 }
 
-bool RadFileReader::writeHeader(std::ofstream& file) const {
-    file << "#RADIOSS STARTER\n";
-    file << "/BEGIN\n";
+bool RadFileReader::writeHeader(RecordWriter& writer) const {
+    RecordBuffer& text = writer.Text();
+    text.Append("#RADIOSS STARTER\n");
+    text.Append("/BEGIN\n");
     if (!title_.empty()) {
-        file << "/TITLE\n" << title_ << "\n";
+        text.Append("/TITLE\n");
+        text.Append(title_);
+        text.Append('\n');
     }
-    return file.good();
+    return writer.Good();
 }
 
-bool RadFileReader::writeNodes(std::ofstream& file) const {
+bool RadFileReader::writeNodes(RecordWriter& writer) const {
     if (!nodes_.empty()) {
-        file << "/NODE\n";
-        for (const auto& node : nodes_) {
-            file << std::setw(10) << node.id 
-                 << std::setw(20) << std::scientific << std::setprecision(6) << node.position.x
-                 << std::setw(20) << std::scientific << std::setprecision(6) << node.position.y
-                 << std::setw(20) << std::scientific << std::setprecision(6) << node.position.z
-                 << "\n";
-        }
+        writer.Text().Append("/NODE\n");
+        writer.WriteRecords(nodes_.size(), [this](size_t i, RecordBuffer& out) {
+            const Node& node = nodes_[i];
+            out.AppendInt(node.id, 10);
+            out.AppendScientific(node.position.x, 6, 20);
+            out.AppendScientific(node.position.y, 6, 20);
+            out.AppendScientific(node.position.z, 6, 20);
+            out.Append('\n');
+        });
     }
-    return file.good();
+    return writer.Good();
 }
 
-bool RadFileReader::writeElements(std::ofstream& file) const {
+bool RadFileReader::writeElements(RecordWriter& writer) const {
     if (!elements_.empty()) {
         // Group elements by type and write appropriate headers
         std::unordered_map<Element::Type, std::vector<const Element*>> elementsByType;
@@ -592,115 +1100,125 @@ bool RadFileReader::writeElements(std::ofstream& file) const {
             const auto& elements = pair.second;
             
             // Write appropriate header for element type
+            RecordBuffer& text = writer.Text();
             switch (type) {
                 case Element::TRIA3:
-                    file << "/SH3N\n";
+                    text.Append("/SH3N\n");
                     break;
                 case Element::QUAD4:
-                    file << "/SHELL\n";
+                    text.Append("/SHELL\n");
                     break;
                 case Element::TETRA4:
-                    file << "/TETRA4\n";
+                    text.Append("/TETRA4\n");
                     break;
                 case Element::HEXA8:
-                    file << "/BRICK\n";
+                    text.Append("/BRICK\n");
                     break;
                 case Element::PENTA6:
-                    file << "/PENTA6\n";
+                    text.Append("/PENTA6\n");
                     break;
                 case Element::PYRAM5:
-                    file << "/PYRAM5\n";
+                    text.Append("/PYRAM5\n");
                     break;
                 default:
-                    file << "/SHELL\n"; // Default to shell
+                    text.Append("/SHELL\n"); // Default to shell
                     break;
             }
             
-            for (const Element* element : elements) {
-                file << std::setw(10) << element->id
-                     << std::setw(10) << element->materialId
-                     << std::setw(10) << element->propertyId;
+            writer.WriteRecords(elements.size(), [&elements](size_t i, RecordBuffer& out) {
+                const Element* element = elements[i];
+                out.AppendInt(element->id, 10);
+                out.AppendInt(element->materialId, 10);
+                out.AppendInt(element->propertyId, 10);
                 
                 for (int nodeId : element->nodeIds) {
-                    file << std::setw(10) << nodeId;
+                    out.AppendInt(nodeId, 10);
                 }
-                file << "\n";
-            }
+                out.Append('\n');
+            });
         }
     }
-    return file.good();
+    return writer.Good();
 }
 
-bool RadFileReader::writeMaterials(std::ofstream& file) const {
+bool RadFileReader::writeMaterials(RecordWriter& writer) const {
     if (!materials_.empty()) {
         for (const auto& material : materials_) {
-            file << "/MAT/" << material.type << "\n";
-            file << std::setw(10) << material.id;
+            RecordBuffer& text = writer.Text();
+            text.Append("/MAT/");
+            text.Append(material.type);
+            text.Append('\n');
+            text.AppendInt(material.id, 10);
             
             // Write material properties
-            for (const auto& prop : material.properties) {
-                file << std::setw(20) << std::scientific << std::setprecision(6) << prop.second;
-            }
-            file << "\n";
+            material.properties.ForEach([&](ParameterKey, double value) {
+                text.AppendScientific(value, 6, 20);
+            });
+            text.Append('\n');
         }
     }
-    return file.good();
+    return writer.Good();
 }
 
-bool RadFileReader::writeProperties(std::ofstream& file) const {
+bool RadFileReader::writeProperties(RecordWriter& writer) const {
     if (!properties_.empty()) {
         for (const auto& property : properties_) {
-            file << "/PROP/" << property.type << "\n";
-            file << std::setw(10) << property.id;
+            RecordBuffer& text = writer.Text();
+            text.Append("/PROP/");
+            text.Append(property.type);
+            text.Append('\n');
+            text.AppendInt(property.id, 10);
             
             // Write property values
-            for (const auto& val : property.values) {
-                file << std::setw(20) << std::scientific << std::setprecision(6) << val.second;
-            }
-            file << "\n";
+            property.values.ForEach([&](ParameterKey, double value) {
+                text.AppendScientific(value, 6, 20);
+            });
+            text.Append('\n');
         }
     }
-    return file.good();
+    return writer.Good();
 }
 
-bool RadFileReader::writeLoadCases(std::ofstream& file) const {
+bool RadFileReader::writeLoadCases(RecordWriter& writer) const {
     if (!loadCases_.empty()) {
         for (const auto& loadCase : loadCases_) {
-            file << "/CLOAD\n";
-            file << std::setw(10) << loadCase.id
-                 << std::setw(20) << std::scientific << std::setprecision(6) << loadCase.magnitude
-                 << std::setw(20) << std::scientific << std::setprecision(6) << loadCase.vector.x
-                 << std::setw(20) << std::scientific << std::setprecision(6) << loadCase.vector.y
-                 << std::setw(20) << std::scientific << std::setprecision(6) << loadCase.vector.z;
+            RecordBuffer& text = writer.Text();
+            text.Append("/CLOAD\n");
+            text.AppendInt(loadCase.id, 10);
+            text.AppendScientific(loadCase.magnitude, 6, 20);
+            text.AppendScientific(loadCase.vector.x, 6, 20);
+            text.AppendScientific(loadCase.vector.y, 6, 20);
+            text.AppendScientific(loadCase.vector.z, 6, 20);
             
             for (int nodeId : loadCase.nodeIds) {
-                file << std::setw(10) << nodeId;
+                text.AppendInt(nodeId, 10);
             }
-            file << "\n";
+            text.Append('\n');
         }
     }
-    return file.good();
+    return writer.Good();
 }
 
-bool RadFileReader::writeBoundaryConditions(std::ofstream& file) const {
+bool RadFileReader::writeBoundaryConditions(RecordWriter& writer) const {
     if (!boundaryConditions_.empty()) {
         for (const auto& bc : boundaryConditions_) {
-            file << "/BCS\n";
-            file << std::setw(10) << bc.id;
+            RecordBuffer& text = writer.Text();
+            text.Append("/BCS\n");
+            text.AppendInt(bc.id, 10);
             
             // Write DOF constraints
             for (int dof : bc.dofs) {
-                file << dof;
+                text.AppendInt(dof);
             }
-            file << std::setw(10) << "";
+            text.AppendPadding(10);
             
             for (int nodeId : bc.nodeIds) {
-                file << std::setw(10) << nodeId;
+                text.AppendInt(nodeId, 10);
             }
-            file << "\n";
+            text.Append('\n');
         }
     }
-    return file.good();
+    return writer.Good();
 }
 
 // RadFileUtils implementation
@@ -1,14 +1,21 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <glm/glm.hpp>
+#include "core/ParameterTable.h"
+
+class RecordWriter;
 
 namespace OpenRadiossGUI {
 
@@ -46,16 +53,21 @@ struct Element {
     Type type;
     int materialId;
     int propertyId;
-    std::vector<int> nodeIds;
+    
+    // Parsed elements keep their node IDs in the reader's arena; copies
+    // allocate from the default heap and may outlive the reader
+    std::pmr::vector<int> nodeIds;
     
     Element() : id(0), type(UNKNOWN), materialId(0), propertyId(0) {}
+    explicit Element(std::pmr::memory_resource* resource)
+        : id(0), type(UNKNOWN), materialId(0), propertyId(0), nodeIds(resource) {}
 };
 
 struct Material {
     int id;
     std::string name;
     std::string type; // LAW1, LAW2, etc.
-    std::unordered_map<std::string, double> properties;
+    ParameterTable properties; // Schema of the LAW named by type
     
     Material() : id(0) {}
 };
@@ -64,7 +76,7 @@ struct Property {
     int id;
     std::string name;
     std::string type; // SHELL, SOLID, etc.
-    std::unordered_map<std::string, double> values;
+    ParameterTable values;     // Schema of the property type
     
     Property() : id(0) {}
 };
@@ -89,6 +101,34 @@ struct BoundaryCondition {
     BoundaryCondition() : id(0) {}
 };
 
+// Load progress shared with a loading thread. Counters are updated while
+// parsing; cancelRequested is polled between batches of chunks.
+struct LoadProgress {
+    std::atomic<size_t> bytesTotal{0};
+    std::atomic<size_t> bytesParsed{0};
+    std::atomic<size_t> nodesParsed{0};
+    std::atomic<size_t> elementsParsed{0};
+    std::atomic<bool> cancelRequested{false};
+};
+
+// Problem found while validating a loaded deck. Validation keeps going after
+// the first issue so that a whole list can be reported at once.
+struct ValidationIssue {
+    enum Kind {
+        DUPLICATE_NODE_ID,     // detail: index of the first node with this ID
+        DUPLICATE_ELEMENT_ID,  // detail: index of the first element with this ID
+        WRONG_NODE_COUNT,      // detail: number of nodes the element has
+        MISSING_NODE           // detail: ID of the node that does not exist
+    };
+    
+    Kind kind;
+    int entityId;   // Node or element the issue belongs to
+    size_t index;   // Position of that entity in getNodes()/getElements()
+    int detail;
+    
+    std::string describe() const;
+};
+
 // Main RAD file reader class
 class RadFileReader {
 public:
@@ -97,6 +137,9 @@ public:
     
     // Main interface methods
     bool loadFile(const std::string& filename);
+    // Loads an included sub-deck. Its elements may use nodes defined in other
+    // files, so missing node references are not reported.
+    bool loadFragment(const std::string& filename);
     bool saveFile(const std::string& filename) const;
     void clear();
     
@@ -114,6 +157,12 @@ public:
     bool isValid() const { return isValid_; }
     std::string getLastError() const { return lastError_; }
     
+    // Issues found by the last load, in node then element order. At most
+    // kMaxStoredIssues are kept; getValidationIssueCount() has the total.
+    static constexpr size_t kMaxStoredIssues = 1000;
+    const std::vector<ValidationIssue>& getValidationIssues() const { return validationIssues_; }
+    size_t getValidationIssueCount() const { return validationIssueCount_; }
+    
     // Statistics
     size_t getNodeCount() const { return nodes_.size(); }
     size_t getElementCount() const { return elements_.size(); }
@@ -133,9 +182,22 @@ public:
     void addElement(const Element& element);
     void addMaterial(const Material& material);
     void addProperty(const Property& property);
+    
+    // Background loading support. Callbacks run on the loading thread: the
+    // nodes callback fires once every node block is parsed, the elements
+    // callback for each batch appended to getElements() (first index, count).
+    using NodesReadyCallback = std::function<void(const std::vector<Node>&)>;
+    using ElementsReadyCallback = std::function<void(const std::vector<Element>&, size_t, size_t)>;
+    
+    void setProgress(LoadProgress* progress) { progress_ = progress; }
+    void setNodesReadyCallback(NodesReadyCallback callback) { nodesReadyCallback_ = std::move(callback); }
+    void setElementsReadyCallback(ElementsReadyCallback callback) { elementsReadyCallback_ = std::move(callback); }
 
 private:
-    // Internal data storage
+    // Internal data storage. The arenas hold the node IDs of parsed
+    // elements, one per element chunk so chunks can fill them concurrently;
+    // they are declared first so they outlive elements_.
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> connectivityArenas_;
     std::vector<Node> nodes_;
     std::vector<Element> elements_;
     std::vector<Material> materials_;
@@ -149,6 +211,8 @@ private:
     std::string filename_;
     bool isValid_;
     std::string lastError_;
+    std::vector<ValidationIssue> validationIssues_;
+    size_t validationIssueCount_ = 0;
     
     // Parsing state
     enum ParseState {
@@ -163,51 +227,103 @@ private:
         STATE_UNKNOWN
     };
     
+    // Two-phase parsing: a scan splits the file into line-aligned chunks that
+    // each lie inside one keyword section, then node and element chunks are
+    // parsed concurrently and merged back in file order.
+    struct ParseChunk {
+        ParseState state;
+        size_t begin;      // Byte range inside the file
+        size_t end;
+        int firstLine;     // 1-based line number of the first line in the chunk
+        Element::Type elementType = Element::UNKNOWN;  // Declared by the element keyword
+        int lineCount = 0; // Lines in the chunk, an upper bound for its entities
+    };
+    
+    struct ChunkResult {
+        std::vector<Node> nodes;
+        std::vector<Element> elements;
+        std::pmr::memory_resource* connectivity = nullptr;  // Arena for element node IDs
+        size_t nodeCount = 0;          // Entities merged into nodes_/elements_
+        size_t elementCount = 0;
+        int errorLine = 0;             // 0 when the chunk parsed cleanly
+        std::string errorText;
+    };
+    
     // Internal parsing methods
-    bool parseFile(std::ifstream& file);
-    ParseState determineSection(const std::string& line);
-    bool parseHeader(const std::string& line);
-    bool parseTitle(const std::string& line);
-    bool parseNode(const std::string& line);
-    bool parseElement(const std::string& line);
-    bool parseMaterial(const std::string& line);
-    bool parseProperty(const std::string& line);
-    bool parseLoadCase(const std::string& line);
-    bool parseBoundaryCondition(const std::string& line);
+    bool load(const std::string& filename, bool checkReferences);
+    bool parseFile(std::string_view data);
+    std::vector<ParseChunk> scanChunks(std::string_view data) const;
+    bool parseDataChunks(std::string_view data, const std::vector<ParseChunk>& chunks,
+                         const std::vector<size_t>& indices, std::vector<ChunkResult>& results);
+    bool isCancelled() const;
+    void parseDataChunk(std::string_view data, const ParseChunk& chunk, ChunkResult& result) const;
+    void parseSerialChunk(std::string_view data, const ParseChunk& chunk, int stopLine,
+                          ChunkResult& result);
+    bool determineSection(std::string_view line, ParseState& state,
+                          Element::Type& elementType) const;
+    bool parseHeader(std::string_view line);
+    bool parseTitle(std::string_view line);
+    bool parseNode(std::string_view line, std::vector<std::string_view>& tokens,
+                   std::vector<Node>& nodes) const;
+    bool parseElement(std::string_view line, std::vector<std::string_view>& tokens,
+                      Element::Type declaredType, std::pmr::memory_resource* connectivity,
+                      std::vector<Element>& elements) const;
+    bool parseMaterial(std::string_view line);
+    bool parseProperty(std::string_view line);
+    bool parseLoadCase(std::string_view line);
+    bool parseBoundaryCondition(std::string_view line);
     
     // Utility parsing methods
-    std::vector<std::string> tokenizeLine(const std::string& line, char delimiter = ' ') const;
-    std::string trim(const std::string& str) const;
-    bool isComment(const std::string& line) const;
-    bool isEmpty(const std::string& line) const;
+    void tokenizeLine(std::string_view line, std::vector<std::string_view>& tokens,
+                      char delimiter = ' ') const;
+    std::string_view trim(std::string_view str) const;
+    bool isComment(std::string_view line) const;
+    bool isEmpty(std::string_view line) const;
     Element::Type parseElementType(const std::string& typeStr) const;
     
-    // Validation methods
-    bool validateData() const;
-    bool validateNodes() const;
-    bool validateElements() const;
-    bool validateReferences() const;
-    
-    // File writing methods
-    bool writeHeader(std::ofstream& file) const;
-    bool writeNodes(std::ofstream& file) const;
-    bool writeElements(std::ofstream& file) const;
-    bool writeMaterials(std::ofstream& file) const;
-    bool writeProperties(std::ofstream& file) const;
-    bool writeLoadCases(std::ofstream& file) const;
-    bool writeBoundaryConditions(std::ofstream& file) const;
+    // Validation: duplicate IDs come from the sorted lookup tables, element
+    // node counts and node references are checked in one parallel pass
+    struct IssueList;
+    bool validateData(bool checkReferences);
+    
+    // File writing methods, formatted through the shared RecordWriter
+    bool writeHeader(RecordWriter& writer) const;
+    bool writeNodes(RecordWriter& writer) const;
+    bool writeElements(RecordWriter& writer) const;
+    bool writeMaterials(RecordWriter& writer) const;
+    bool writeProperties(RecordWriter& writer) const;
+    bool writeLoadCases(RecordWriter& writer) const;
+    bool writeBoundaryConditions(RecordWriter& writer) const;
     
     // Error handling
     void setError(const std::string& error);
     void clearError();
     
-    // Internal maps for fast lookup
-    std::unordered_map<int, size_t> nodeIdToIndex_;
-    std::unordered_map<int, size_t> elementIdToIndex_;
-    std::unordered_map<int, size_t> materialIdToIndex_;
-    std::unordered_map<int, size_t> propertyIdToIndex_;
+    // Background loading hooks
+    LoadProgress* progress_ = nullptr;
+    NodesReadyCallback nodesReadyCallback_;
+    ElementsReadyCallback elementsReadyCallback_;
+    
+    // Scratch token storage reused across lines to avoid per-line allocation
+    std::vector<std::string_view> tokens_;
+    
+    // Lookup tables: (id, index) pairs sorted by id, then index, so
+    // duplicates sit next to each other and lookups are binary searches
+    struct IdEntry {
+        int id;
+        size_t index;
+    };
+    using IdTable = std::vector<IdEntry>;
+    
+    IdTable nodeIdToIndex_;
+    IdTable elementIdToIndex_;
+    IdTable materialIdToIndex_;
+    IdTable propertyIdToIndex_;
     
     // Build lookup tables
+    template<typename T>
+    static void buildIdTable(const std::vector<T>& items, IdTable& table);
+    static const IdEntry* lookupId(const IdTable& table, int id);
     void buildLookupTables();
     void clearLookupTables();
 };
@@ -229,7 +345,8 @@ namespace RadFileUtils {
     Element::Type stringToElementType(const std::string& typeStr);
     int getElementNodeCount(Element::Type type);
     
-    // Mesh quality utilities
+    // Mesh quality utilities, one reader element at a time with the nodes
+    // searched by ID; MeshQuality evaluates a whole Model
     double calculateElementQuality(const Element& element, const std::vector<Node>& nodes);
     bool isElementDegenerate(const Element& element, const std::vector<Node>& nodes);
 }
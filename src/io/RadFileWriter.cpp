@@ -4,16 +4,16 @@
 #include "core/Element.h"
 #include "core/Material.h"
 #include "utils/Logger.h"
-#include <iomanip>
+#include <algorithm>
 #include <ctime>
+#include <vector>
 
 RadFileWriter::RadFileWriter(Model* model) 
     : m_Model(model) {
 }
 
 bool RadFileWriter::Write(const std::string& filepath) {
-    m_File.open(filepath);
-    if (!m_File.is_open()) {
+    if (!m_Writer.Open(filepath)) {
         LOG_ERROR("Cannot create file: {}", filepath);
         return false;
     }
@@ -24,12 +24,14 @@ bool RadFileWriter::Write(const std::string& filepath) {
     WriteNodes();
     WriteElements();
     WriteMaterials();
-    WriteProperties();
     WriteBoundaryConditions();
     WriteLoads();
     
-    m_File << "/END" << std::endl;
-    m_File.close();
+    m_Writer.Text().Append("/END\n");
+    if (!m_Writer.Close()) {
+        LOG_ERROR("Failed while writing: {}", filepath);
+        return false;
+    }
     
     LOG_INFO("Successfully wrote {} nodes, {} elements", 
              m_Model->GetNodeCount(), m_Model->GetElementCount());
@@ -40,53 +42,73 @@ bool RadFileWriter::Write(const std::string& filepath) {
 void RadFileWriter::WriteHeader() {
     auto t = std::time(nullptr);
     auto tm = *std::localtime(&t);
+    char timestamp[64];
+    size_t length = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm);
     
     WriteComment("OpenRadioss Input Deck");
     WriteComment("Generated by OpenRadioss Pre-Processor");
-    m_File << "#" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << std::endl;
-    m_File << "#" << std::endl;
     
-    m_File << "/TITLE" << std::endl;
-    m_File << "Model exported from OpenRadioss Pre-Processor" << std::endl;
+    RecordBuffer& text = m_Writer.Text();
+    text.Append('#');
+    text.Append(std::string_view(timestamp, length));
+    text.Append("\n#\n");
+    
+    text.Append("/TITLE\n");
+    text.Append("Model exported from OpenRadioss Pre-Processor\n");
 }
 
 void RadFileWriter::WriteNodes() {
     if (m_Model->GetNodeCount() == 0) return;
     
     WriteComment("NODES");
-    m_File << "/NODE" << std::endl;
+    m_Writer.Text().Append("/NODE\n");
     
-    for (const auto& node : m_Model->GetNodes()) {
-        m_File << std::setw(10) << node.id
-               << std::setw(20) << std::scientific << std::setprecision(10) << node.position.x
-               << std::setw(20) << std::scientific << std::setprecision(10) << node.position.y
-               << std::setw(20) << std::scientific << std::setprecision(10) << node.position.z
-               << std::endl;
-    }
+    const auto& ids = m_Model->GetNodeIds();
+    const auto& positions = m_Model->GetNodePositions();
+    m_Writer.WriteRecords(ids.size(), [&ids, &positions](size_t i, RecordBuffer& out) {
+        out.AppendInt(ids[i], 10);
+        out.AppendScientific(positions[i].x, 10, 20);
+        out.AppendScientific(positions[i].y, 10, 20);
+        out.AppendScientific(positions[i].z, 10, 20);
+        out.Append('\n');
+    });
 }
 
 void RadFileWriter::WriteElements() {
     if (m_Model->GetElementCount() == 0) return;
     
-    // Group elements by type
-    std::unordered_map<ElementType, std::vector<const Element*>> elementsByType;
-    
-    for (const auto& element : m_Model->GetElements()) {
-        elementsByType[element.type].push_back(&element);
+    // Elements are already stored in per-type blocks; each type gets one
+    // section, in the order the type first appears, holding all its blocks
+    const ElementArrays& elements = m_Model->GetElementArrays();
+    std::vector<ElementType> types;
+    for (const ElementBlock& block : elements.blocks) {
+        if (std::find(types.begin(), types.end(), block.type) == types.end()) {
+            types.push_back(block.type);
+        }
     }
     
-    // Write each element type
-    for (const auto& [type, elements] : elementsByType) {
+    for (ElementType type : types) {
         std::string typeStr = Element::TypeToString(type);
         WriteComment(typeStr + " ELEMENTS");
-        m_File << "/" << typeStr << "/" << std::endl;
+        RecordBuffer& text = m_Writer.Text();
+        text.Append('/');
+        text.Append(typeStr);
+        text.Append("/\n");
         
-        for (const auto* element : elements) {
-            m_File << std::setw(10) << element->id;
-            for (int nodeId : element->nodeIds) {
-                m_File << std::setw(10) << nodeId;
+        for (const ElementBlock& block : elements.blocks) {
+            if (block.type != type) {
+                continue;
             }
-            m_File << std::endl;
+            size_t stride = static_cast<size_t>(block.nodesPerElement);
+            m_Writer.WriteRecords(block.elementCount, [&elements, block, stride](size_t i, RecordBuffer& out) {
+                size_t index = block.firstElement + i;
+                const int* connectivity = elements.GetNodeIdData(index, block.firstNodeId + i * stride);
+                out.AppendInt(elements.ids[index], 10);
+                for (size_t k = 0; k < stride; ++k) {
+                    out.AppendInt(connectivity[k], 10);
+                }
+                out.Append('\n');
+            });
         }
     }
 }
@@ -96,20 +118,31 @@ void RadFileWriter::WriteMaterials() {
     
     WriteComment("MATERIALS");
     
+    // Material values never set a precision of their own, so the stream
+    // based writer printed them with whatever the node section left behind
+    int precision = m_Model->GetNodeCount() > 0 ? 10 : 6;
+    
     // Write elastic materials
     for (const auto& material : m_Model->GetMaterials()) {
+        RecordBuffer& text = m_Writer.Text();
         if (material.type == MaterialType::ELASTIC) {
-            m_File << "/MAT/ELAST/1/" << material.id << std::endl;
-            m_File << material.name << std::endl;
-            m_File << std::setw(20) << std::scientific << material.density
-                   << std::setw(20) << std::scientific << material.youngModulus
-                   << std::endl;
-            m_File << std::setw(20) << std::scientific << material.poissonRatio
-                   << std::endl;
+            text.Append("/MAT/ELAST/1/");
+            text.AppendInt(material.id);
+            text.Append('\n');
+            text.Append(material.name);
+            text.Append('\n');
+            text.AppendScientific(material.parameters.Get(Param::RHO), precision, 20);
+            text.AppendScientific(material.parameters.Get(Param::E), precision, 20);
+            text.Append('\n');
+            text.AppendScientific(material.parameters.Get(Param::NU), precision, 20);
+            text.Append('\n');
         }
         else if (material.type == MaterialType::JOHNSON_COOK) {
-            m_File << "/MAT/JOHN_COOK/2/" << material.id << std::endl;
-            m_File << material.name << std::endl;
+            text.Append("/MAT/JOHN_COOK/2/");
+            text.AppendInt(material.id);
+            text.Append('\n');
+            text.Append(material.name);
+            text.Append('\n');
             // Write Johnson-Cook parameters...
         }
     }
@@ -126,7 +159,8 @@ void RadFileWriter::WriteLoads() {
 }
 
 void RadFileWriter::WriteComment(const std::string& comment) {
-    m_File << "#" << std::endl;
-    m_File << "# " << comment << std::endl;
-    m_File << "#" << std::endl;
-}
\ No newline at end of file
+    RecordBuffer& text = m_Writer.Text();
+    text.Append("#\n# ");
+    text.Append(comment);
+    text.Append("\n#\n");
+}
@@ -1,6 +1,6 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include "io/RecordWriter.h"
 
 class Model;
 
@@ -16,7 +16,6 @@ private:
     void WriteNodes();
     void WriteElements();
     void WriteMaterials();
-    void WriteProperties();
     void WriteBoundaryConditions();
     void WriteLoads();
     
@@ -24,5 +23,5 @@ private:
     
 private:
     Model* m_Model;
-    std::ofstream m_File;
+    RecordWriter m_Writer;
 };
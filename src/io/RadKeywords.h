@@ -0,0 +1,168 @@
+#pragma once
+#include "io/RadFileReader.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace OpenRadiossGUI {
+
+// Which part of the reader consumes the data lines under a keyword
+enum class KeywordSection : uint8_t {
+    HEADER,
+    TITLE,
+    NODES,
+    ELEMENTS,
+    MATERIALS,
+    PROPERTIES,
+    LOADS,
+    BOUNDARY_CONDITIONS
+};
+
+struct KeywordInfo {
+    std::string_view name;       // First path component, upper case
+    KeywordSection section;
+    Element::Type elementType;   // Element cards only, UNKNOWN otherwise
+};
+
+// Every keyword the reader understands. Lookup matches the first path
+// component exactly: /PROP/SHELL is a property card, not a shell block.
+constexpr KeywordInfo kKeywords[] = {
+    {"BEGIN",   KeywordSection::HEADER,              Element::UNKNOWN},
+    {"TITLE",   KeywordSection::TITLE,               Element::UNKNOWN},
+    {"NODE",    KeywordSection::NODES,               Element::UNKNOWN},
+    {"CNODE",   KeywordSection::NODES,               Element::UNKNOWN},
+    {"SHELL",   KeywordSection::ELEMENTS,            Element::QUAD4},
+    {"SH3N",    KeywordSection::ELEMENTS,            Element::TRIA3},
+    {"QUAD",    KeywordSection::ELEMENTS,            Element::QUAD4},
+    {"TRIA",    KeywordSection::ELEMENTS,            Element::TRIA3},
+    {"BRICK",   KeywordSection::ELEMENTS,            Element::HEXA8},
+    {"HEXA",    KeywordSection::ELEMENTS,            Element::HEXA8},
+    {"HEXA8",   KeywordSection::ELEMENTS,            Element::HEXA8},
+    {"PENTA6",  KeywordSection::ELEMENTS,            Element::PENTA6},
+    {"TETRA4",  KeywordSection::ELEMENTS,            Element::TETRA4},
+    {"TETRA10", KeywordSection::ELEMENTS,            Element::UNKNOWN},
+    {"MAT",     KeywordSection::MATERIALS,           Element::UNKNOWN},
+    {"PROP",    KeywordSection::PROPERTIES,          Element::UNKNOWN},
+    {"PART",    KeywordSection::PROPERTIES,          Element::UNKNOWN},
+    {"LOAD",    KeywordSection::LOADS,               Element::UNKNOWN},
+    {"CLOAD",   KeywordSection::LOADS,               Element::UNKNOWN},
+    {"PLOAD",   KeywordSection::LOADS,               Element::UNKNOWN},
+    {"BCS",     KeywordSection::BOUNDARY_CONDITIONS, Element::UNKNOWN},
+    {"SPC",     KeywordSection::BOUNDARY_CONDITIONS, Element::UNKNOWN},
+    {"IMPVEL",  KeywordSection::BOUNDARY_CONDITIONS, Element::UNKNOWN},
+};
+
+constexpr size_t kKeywordCount = sizeof(kKeywords) / sizeof(kKeywords[0]);
+
+namespace detail {
+
+constexpr size_t kKeywordTableSize = 64;
+constexpr uint32_t kKeywordHashSeed = 263;  // First seed without collisions
+
+constexpr char toUpper(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+// Case-insensitive hash, identical at compile time and at run time
+constexpr size_t keywordHash(std::string_view name) {
+    uint32_t hash = kKeywordHashSeed;
+    for (char c : name) {
+        hash = hash * 31u + static_cast<uint8_t>(toUpper(c));
+    }
+    return (hash ^ (hash >> 7)) % kKeywordTableSize;
+}
+
+// Slot -> index into kKeywords, -1 for empty slots
+constexpr std::array<int8_t, kKeywordTableSize> buildKeywordTable() {
+    std::array<int8_t, kKeywordTableSize> table{};
+    for (auto& slot : table) slot = -1;
+    for (size_t i = 0; i < kKeywordCount; ++i) {
+        table[keywordHash(kKeywords[i].name)] = static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+constexpr std::array<int8_t, kKeywordTableSize> kKeywordTable = buildKeywordTable();
+
+// A later keyword overwriting an earlier slot would make the earlier one
+// unreachable; adjust the seed or table size if this fires
+constexpr bool keywordTableIsPerfect() {
+    for (size_t i = 0; i < kKeywordCount; ++i) {
+        if (kKeywordTable[keywordHash(kKeywords[i].name)] != static_cast<int8_t>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(keywordTableIsPerfect(), "keyword hash has collisions");
+
+} // namespace detail
+
+// Returns the table entry for a keyword name (any case), or nullptr
+inline const KeywordInfo* findKeyword(std::string_view name) {
+    if (name.empty()) return nullptr;
+    
+    int8_t index = detail::kKeywordTable[detail::keywordHash(name)];
+    if (index < 0) return nullptr;
+    
+    const KeywordInfo& info = kKeywords[index];
+    if (info.name.size() != name.size()) return nullptr;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (detail::toUpper(name[i]) != info.name[i]) return nullptr;
+    }
+    return &info;
+}
+
+// A keyword line split at '/', e.g. /MAT/LAW2/3 -> {"MAT", "LAW2", "3"}
+struct KeywordPath {
+    static constexpr size_t kMaxComponents = 6;
+    
+    std::string_view components[kMaxComponents];
+    size_t count = 0;
+    const KeywordInfo* info = nullptr;  // nullptr for keywords outside the table
+    int id = 0;                         // Trailing numeric component, 0 if absent
+    
+    std::string_view keyword() const { return count > 0 ? components[0] : std::string_view(); }
+};
+
+// Splits a line that starts with '/'. Returns false for any other line,
+// which is how data lines are told apart without scanning them.
+inline bool parseKeywordPath(std::string_view line, KeywordPath& path) {
+    if (line.empty() || line[0] != '/') return false;
+    path = KeywordPath();
+    
+    size_t end = line.size();
+    while (end > 0 && (line[end - 1] == ' ' || line[end - 1] == '\t' || line[end - 1] == '\r')) {
+        --end;
+    }
+    
+    size_t pos = 1;
+    while (pos < end && path.count < KeywordPath::kMaxComponents) {
+        size_t next = line.find('/', pos);
+        if (next == std::string_view::npos || next > end) next = end;
+        if (next > pos) {
+            path.components[path.count++] = line.substr(pos, next - pos);
+        }
+        pos = next + 1;
+    }
+    
+    path.info = findKeyword(path.keyword());
+    
+    if (path.count > 1) {
+        int id = 0;
+        bool numeric = true;
+        for (char c : path.components[path.count - 1]) {
+            if (c < '0' || c > '9') {
+                numeric = false;
+                break;
+            }
+            id = id * 10 + (c - '0');
+        }
+        if (numeric) path.id = id;
+    }
+    return true;
+}
+
+} // namespace OpenRadiossGUI
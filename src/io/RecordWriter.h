@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Growable text buffer with fixed-width field formatting. The Append*
+// methods produce the same bytes as the equivalent iostream manipulators
+// (std::setw, std::scientific, std::setprecision) without locale or
+// stream-state overhead.
+class RecordBuffer {
+public:
+    void Clear() { m_Data.clear(); }
+    void Reserve(size_t bytes) { m_Data.reserve(bytes); }
+
+    const char* Data() const { return m_Data.data(); }
+    size_t Size() const { return m_Data.size(); }
+    bool Empty() const { return m_Data.empty(); }
+
+    void Append(std::string_view text) { m_Data.append(text.data(), text.size()); }
+    void Append(char c) { m_Data.push_back(c); }
+
+    // `<< std::setw(width) << value`; wider values are not truncated
+    void AppendInt(long long value, int width = 0);
+
+    // `<< std::setw(width) << std::scientific << std::setprecision(precision) << value`
+    void AppendScientific(double value, int precision, int width = 0);
+
+    // `<< std::setw(width) << ""`
+    void AppendPadding(int width) { m_Data.append(static_cast<size_t>(width), ' '); }
+
+private:
+    void AppendField(const char* text, size_t length, int width);
+
+private:
+    std::string m_Data;
+};
+
+// Buffered text file writer shared by RadFileWriter and the
+// OpenRadiossGUI::RadFileReader exporter. Small text goes through Text();
+// bulk sections are formatted record by record in parallel chunks and
+// written in order with large sequential writes.
+class RecordWriter {
+public:
+    RecordWriter() = default;
+    ~RecordWriter();
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    bool Open(const std::string& filepath);
+    // Flushes pending text; false if any write failed since Open
+    bool Close();
+
+    bool IsOpen() const { return m_File != nullptr; }
+    bool Good() const { return m_Good; }
+
+    // Buffer for headers and other serial text. Flushed automatically once
+    // it grows past kFlushBytes.
+    RecordBuffer& Text();
+
+    // Calls format(index, buffer) for every index in [0, count), each call
+    // appending one record. Chunks of records are formatted concurrently on
+    // the global thread pool and written in index order.
+    template<typename F>
+    void WriteRecords(size_t count, const F& format);
+
+    static constexpr size_t kFlushBytes = 4u << 20;
+    static constexpr size_t kRecordsPerChunk = 1u << 15;
+
+private:
+    void Flush();
+    void WriteBytes(const char* data, size_t size);
+    void FormatChunks(size_t count, void (*formatRange)(const void*, size_t, size_t, RecordBuffer&),
+                      const void* context);
+
+private:
+    std::FILE* m_File = nullptr;
+    bool m_Good = false;
+    RecordBuffer m_Text;
+    std::vector<RecordBuffer> m_ChunkBuffers;  // Reused across WriteRecords calls
+};
+
+template<typename F>
+void RecordWriter::WriteRecords(size_t count, const F& format) {
+    FormatChunks(count,
+                 [](const void* context, size_t begin, size_t end, RecordBuffer& buffer) {
+                     const F& fn = *static_cast<const F*>(context);
+                     for (size_t i = begin; i < end; ++i) {
+                         fn(i, buffer);
+                     }
+                 },
+                 &format);
+}
@@ -0,0 +1,167 @@
+#include "io/ResultCache.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+} // namespace
+
+ResultCache::ResultCache(std::shared_ptr<const ResultReader> reader, size_t budgetBytes)
+    : m_Reader(std::move(reader)), m_Budget(budgetBytes), m_ReadAhead(0), m_Bytes(0),
+      m_InFlight(kNone), m_HasLast(false), m_Last(0), m_Direction(1), m_Stopping(false) {
+    const size_t stateBytes = m_Reader->GetStateBytes();
+    const size_t stateCount = m_Reader->GetStateCount();
+    if (stateBytes > 0 && stateCount > 1) {
+        m_ReadAhead = std::min({kMaxReadAhead, m_Budget / 2 / stateBytes, stateCount - 1});
+    }
+    LOG_INFO("Results: {} MB per state, cache of {} MB, reading {} states ahead",
+             stateBytes >> 20, m_Budget >> 20, m_ReadAhead);
+    
+    if (m_ReadAhead > 0) {
+        m_Thread = std::thread(&ResultCache::ReadAheadLoop, this);
+    }
+}
+
+ResultCache::~ResultCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+}
+
+std::shared_ptr<const ResultState> ResultCache::Get(size_t state) {
+    if (state >= m_Reader->GetStateCount()) {
+        return nullptr;
+    }
+    
+    std::shared_ptr<const ResultState> found;
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        auto it = m_Entries.find(state);
+        if (it != m_Entries.end()) {
+            Touch(it->second);
+            found = it->second.state;
+            break;
+        }
+        if (m_InFlight != state) {
+            break;
+        }
+        m_Condition.wait(lock);
+    }
+    QueueReadAhead(state);
+    if (found) {
+        return found;
+    }
+    
+    lock.unlock();
+    std::shared_ptr<const ResultState> decoded = Decode(state);
+    lock.lock();
+    if (decoded && m_Entries.find(state) == m_Entries.end()) {
+        Insert(state, decoded);
+    }
+    return decoded;
+}
+
+std::shared_ptr<const ResultState> ResultCache::Find(size_t state) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(state);
+    if (it == m_Entries.end()) {
+        return nullptr;
+    }
+    Touch(it->second);
+    return it->second.state;
+}
+
+size_t ResultCache::GetMemoryBytes() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Bytes;
+}
+
+size_t ResultCache::GetCachedCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries.size();
+}
+
+std::shared_ptr<const ResultState> ResultCache::Decode(size_t state) const {
+    auto decoded = std::make_shared<ResultState>();
+    if (!m_Reader->ReadState(state, *decoded)) {
+        return nullptr;
+    }
+    return decoded;
+}
+
+void ResultCache::Insert(size_t state, std::shared_ptr<const ResultState> decoded) {
+    m_Recent.push_front(state);
+    m_Bytes += decoded->GetMemoryBytes();
+    m_Entries[state] = {std::move(decoded), m_Recent.begin()};
+    
+    // The newest state is kept even when it alone exceeds the budget
+    while (m_Bytes > m_Budget && m_Recent.size() > 1) {
+        auto victim = m_Entries.find(m_Recent.back());
+        m_Bytes -= victim->second.state->GetMemoryBytes();
+        m_Entries.erase(victim);
+        m_Recent.pop_back();
+    }
+}
+
+void ResultCache::Touch(Entry& entry) {
+    m_Recent.splice(m_Recent.begin(), m_Recent, entry.position);
+}
+
+void ResultCache::QueueReadAhead(size_t state) {
+    if (m_ReadAhead == 0) {
+        return;
+    }
+    
+    // Playback loops, so the direction is that of the shorter way round
+    const size_t count = m_Reader->GetStateCount();
+    if (m_HasLast && state != m_Last) {
+        size_t forward = (state + count - m_Last) % count;
+        m_Direction = forward <= count / 2 ? 1 : -1;
+    }
+    m_HasLast = true;
+    m_Last = state;
+    
+    m_Wanted.clear();
+    for (size_t k = 1; k <= m_ReadAhead; ++k) {
+        size_t next = m_Direction > 0 ? (state + k) % count : (state + count - k) % count;
+        if (next != state && m_Entries.find(next) == m_Entries.end() && next != m_InFlight) {
+            m_Wanted.push_back(next);
+        }
+    }
+    m_Condition.notify_all();
+}
+
+void ResultCache::ReadAheadLoop() {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        m_Condition.wait(lock, [&]() { return m_Stopping || !m_Wanted.empty(); });
+        if (m_Stopping) {
+            return;
+        }
+        
+        const size_t state = m_Wanted.front();
+        m_Wanted.erase(m_Wanted.begin());
+        if (m_Entries.find(state) != m_Entries.end()) {
+            continue;
+        }
+        m_InFlight = state;
+        
+        lock.unlock();
+        std::shared_ptr<const ResultState> decoded = Decode(state);
+        lock.lock();
+        
+        m_InFlight = kNone;
+        if (decoded && m_Entries.find(state) == m_Entries.end()) {
+            Insert(state, std::move(decoded));
+        }
+        m_Condition.notify_all();
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "io/ResultReader.h"
+#include <condition_variable>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Decoded states of a result, kept within a byte budget. The least recently
+// used state is evicted first, so memory stays bounded however many states
+// the run has. Every Get also queues a read-ahead of the next few states in
+// the direction playback is moving, which a background thread decodes while
+// the current state is shown; read-ahead is capped at half the budget so it
+// never evicts what is being looked at.
+//
+// Get may be called from any thread. States are handed out as shared
+// pointers, so an evicted state stays valid for whoever still holds it.
+class ResultCache {
+public:
+    static constexpr size_t kDefaultBudget = size_t(512) << 20;
+    static constexpr size_t kMaxReadAhead = 4;
+    
+    explicit ResultCache(std::shared_ptr<const ResultReader> reader, size_t budgetBytes = kDefaultBudget);
+    ~ResultCache();
+    
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+    
+    const ResultReader& GetReader() const { return *m_Reader; }
+    size_t GetStateCount() const { return m_Reader->GetStateCount(); }
+    
+    // Decodes the state unless it is cached or being read ahead, which is
+    // waited for; null when it cannot be read
+    std::shared_ptr<const ResultState> Get(size_t state);
+    
+    // Cached states only, never decodes
+    std::shared_ptr<const ResultState> Find(size_t state);
+    
+    size_t GetMemoryBytes() const;
+    size_t GetCachedCount() const;
+    size_t GetReadAheadCount() const { return m_ReadAhead; }
+
+private:
+    struct Entry {
+        std::shared_ptr<const ResultState> state;
+        std::list<size_t>::iterator position;   // In m_Recent
+    };
+    
+    std::shared_ptr<const ResultState> Decode(size_t state) const;
+    void Insert(size_t state, std::shared_ptr<const ResultState> decoded);
+    void Touch(Entry& entry);
+    void QueueReadAhead(size_t state);
+    void ReadAheadLoop();
+
+private:
+    std::shared_ptr<const ResultReader> m_Reader;
+    size_t m_Budget;
+    size_t m_ReadAhead;
+    
+    // Guarded by m_Mutex
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::unordered_map<size_t, Entry> m_Entries;
+    std::list<size_t> m_Recent;            // Most recently used first
+    size_t m_Bytes;
+    std::vector<size_t> m_Wanted;          // Read-ahead, nearest first
+    size_t m_InFlight;                     // State being read ahead, or kNone
+    bool m_HasLast;
+    size_t m_Last;                         // Last state asked for
+    int m_Direction;                       // +1 or -1
+    bool m_Stopping;
+    
+    std::thread m_Thread;
+};
@@ -0,0 +1,355 @@
+#include "io/ResultReader.h"
+#include "io/MappedFile.h"
+#include "core/Model.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+namespace {
+
+// Engine animation layout (see OpenRadioss' anim_to_vtk): big-endian 32-bit
+// words, fixed-width text records, then the 2D geometry section whose
+// arrays follow from the counts in its header
+constexpr int32_t kAnimMagic = 0x542c;
+constexpr size_t kTextLength = 81;
+constexpr size_t kPartTextLength = 50;
+constexpr int kFlagCount = 10;
+constexpr int kMassFlag = 0;
+constexpr int kNumberingFlag = 1;
+
+uint32_t LoadWord(const char* data) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+int32_t LoadInt(const char* data) {
+    return static_cast<int32_t>(LoadWord(data));
+}
+
+float LoadFloat(const char* data) {
+    uint32_t word = LoadWord(data);
+    float value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+// Bounds-checked walk over a state file; any overrun clears ok
+struct Cursor {
+    const char* data;
+    uint64_t size;
+    uint64_t offset = 0;
+    bool ok = true;
+    
+    bool Skip(uint64_t bytes) {
+        if (!ok || bytes > size - offset) {
+            ok = false;
+            return false;
+        }
+        offset += bytes;
+        return true;
+    }
+    
+    int32_t Int() {
+        uint64_t at = offset;
+        return Skip(4) ? LoadInt(data + at) : 0;
+    }
+    
+    float Float() {
+        uint64_t at = offset;
+        return Skip(4) ? LoadFloat(data + at) : 0.0f;
+    }
+    
+    uint64_t Count() {
+        int32_t value = Int();
+        if (value < 0) {
+            ok = false;
+        }
+        return ok ? static_cast<uint64_t>(value) : 0;
+    }
+    
+    std::string Text(size_t length) {
+        uint64_t at = offset;
+        if (!Skip(length)) {
+            return std::string();
+        }
+        std::string text(data + at, length);
+        text.erase(std::find(text.begin(), text.end(), '\0'), text.end());
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+            text.pop_back();
+        }
+        return text;
+    }
+};
+
+struct StateLayout {
+    float time = 0.0f;
+    uint64_t nodeCount = 0;
+    uint64_t facetCount = 0;
+    uint64_t coordinates = 0;
+    uint64_t elementScalars = 0;
+    uint64_t nodeIds = 0;       // 0 when the run saved no numbering
+    uint64_t facetIds = 0;
+    std::vector<std::string> elementScalarNames;
+};
+
+// Reads the header and steps over the arrays up to the numbering, without
+// touching the arrays themselves
+bool ParseLayout(const MappedFile& file, StateLayout& layout, std::string& error) {
+    Cursor cursor{file.Data(), file.Size()};
+    if (cursor.Int() != kAnimMagic || !cursor.ok) {
+        error = "not an OpenRadioss animation file";
+        return false;
+    }
+    layout.time = cursor.Float();
+    cursor.Skip(3 * kTextLength);   // Time, title and run texts
+    
+    int32_t flags[kFlagCount];
+    for (int32_t& flag : flags) {
+        flag = cursor.Int();
+    }
+    
+    layout.nodeCount = cursor.Count();
+    layout.facetCount = cursor.Count();
+    uint64_t partCount = cursor.Count();
+    uint64_t nodeScalarCount = cursor.Count();
+    uint64_t elementScalarCount = cursor.Count();
+    uint64_t vectorCount = cursor.Count();
+    uint64_t tensorCount = cursor.Count();
+    uint64_t skewCount = cursor.Count();
+    
+    cursor.Skip(skewCount * 6 * sizeof(uint16_t));
+    layout.coordinates = cursor.offset;
+    cursor.Skip(layout.nodeCount * 3 * sizeof(float));
+    cursor.Skip(layout.facetCount * (4 * sizeof(int32_t) + 1));    // Connectivity, deleted flags
+    cursor.Skip(partCount * (sizeof(int32_t) + kPartTextLength));
+    cursor.Skip(layout.nodeCount * 3 * sizeof(uint16_t));          // Packed normals
+    
+    cursor.Skip(nodeScalarCount * kTextLength);
+    layout.elementScalarNames.clear();
+    for (uint64_t f = 0; f < elementScalarCount && cursor.ok; ++f) {
+        layout.elementScalarNames.push_back(cursor.Text(kTextLength));
+    }
+    cursor.Skip(nodeScalarCount * layout.nodeCount * sizeof(float));
+    layout.elementScalars = cursor.offset;
+    cursor.Skip(elementScalarCount * layout.facetCount * sizeof(float));
+    
+    cursor.Skip(vectorCount * (kTextLength + layout.nodeCount * 3 * sizeof(float)));
+    cursor.Skip(tensorCount * (kTextLength + layout.facetCount * 3 * sizeof(float)));
+    if (flags[kMassFlag] == 1) {
+        cursor.Skip((layout.facetCount + layout.nodeCount) * sizeof(float));
+    }
+    if (flags[kNumberingFlag]) {
+        layout.nodeIds = cursor.offset;
+        cursor.Skip(layout.nodeCount * sizeof(int32_t));
+        layout.facetIds = cursor.offset;
+        cursor.Skip(layout.facetCount * sizeof(int32_t));
+    }
+    
+    if (!cursor.ok) {
+        error = "truncated animation file";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+size_t ResultState::GetMemoryBytes() const {
+    size_t bytes = displacements.capacity() * sizeof(glm::vec3);
+    for (const std::vector<float>& scalars : elementScalars) {
+        bytes += scalars.capacity() * sizeof(float);
+    }
+    return bytes;
+}
+
+bool ResultReader::ParseStateName(const std::string& filename, std::string& root, int& number) {
+    size_t digits = filename.size();
+    while (digits > 0 && std::isdigit(static_cast<unsigned char>(filename[digits - 1]))) {
+        --digits;
+    }
+    const size_t digitCount = filename.size() - digits;
+    if (digitCount < 3 || digitCount > 9 || digits == 0 || filename[digits - 1] != 'A') {
+        return false;
+    }
+    root = filename.substr(0, digits - 1);
+    number = std::stoi(filename.substr(digits));
+    return true;
+}
+
+bool ResultReader::Open(const std::string& path, const Model& model) {
+    namespace fs = std::filesystem;
+    Close();
+    m_Error.clear();
+    
+    // Every "<root>A<number>" next to the given file or root, in state order
+    fs::path given(path);
+    std::string root;
+    int number = 0;
+    if (!ParseStateName(given.filename().string(), root, number)) {
+        root = given.filename().string();
+    }
+    fs::path directory = given.has_parent_path() ? given.parent_path() : fs::path(".");
+    
+    std::vector<std::pair<int, std::string>> files;
+    std::error_code error;
+    for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        std::string fileRoot;
+        if (it->is_regular_file(error) &&
+            ParseStateName(it->path().filename().string(), fileRoot, number) && fileRoot == root) {
+            files.emplace_back(number, it->path().string());
+        }
+    }
+    if (files.empty()) {
+        m_Error = "no animation states found for " + path;
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+    
+    for (const auto& entry : files) {
+        MappedFile file;
+        StateLayout layout;
+        std::string reason = "cannot open";
+        if (!file.Open(entry.second) || !ParseLayout(file, layout, reason)) {
+            if (!m_States.empty()) {
+                // Most likely the state the engine is still writing
+                LOG_WARN("Results: {}: {}, stopping there", entry.second, reason);
+                break;
+            }
+            m_Error = entry.second + ": " + reason;
+            return false;
+        }
+        if (m_States.empty()) {
+            m_FileNodeCount = layout.nodeCount;
+            m_FileFacetCount = layout.facetCount;
+            m_ElementScalarNames = layout.elementScalarNames;
+        } else if (layout.nodeCount != m_FileNodeCount || layout.facetCount != m_FileFacetCount ||
+                   layout.elementScalarNames != m_ElementScalarNames) {
+            // Element deletion keeps the counts, so a change means another run
+            LOG_WARN("Results: {} does not match the earlier states, stopping there", entry.second);
+            break;
+        }
+        
+        StateInfo info;
+        info.path = entry.second;
+        info.fileSize = file.Size();
+        info.time = layout.time;
+        info.coordinates = layout.coordinates;
+        info.elementScalars = layout.elementScalars;
+        m_States.push_back(std::move(info));
+    }
+    
+    if (!MapEntities(files.front().second, model)) {
+        Close();
+        return false;
+    }
+    LOG_INFO("Results: {} states of {} nodes and {} facets, t = {} .. {}", m_States.size(),
+             m_FileNodeCount, m_FileFacetCount, m_States.front().time, m_States.back().time);
+    return true;
+}
+
+void ResultReader::Close() {
+    m_States.clear();
+    m_FileNodeCount = 0;
+    m_FileFacetCount = 0;
+    m_ElementScalarNames.clear();
+    m_NodeMap = std::vector<uint32_t>();
+    m_FacetMap = std::vector<uint32_t>();
+    m_Reference = std::vector<glm::vec3>();
+    m_NodeCount = 0;
+    m_ElementCount = 0;
+}
+
+bool ResultReader::MapEntities(const std::string& path, const Model& model) {
+    MappedFile file;
+    StateLayout layout;
+    std::string reason = "cannot open";
+    if (!file.Open(path) || !ParseLayout(file, layout, reason)) {
+        m_Error = path + ": " + reason;
+        return false;
+    }
+    m_NodeCount = model.GetNodeCount();
+    m_ElementCount = model.GetElementCount();
+    
+    // Without numbering the file lists the model's nodes in order
+    m_NodeMap.assign(m_FileNodeCount, kUnmapped);
+    size_t mapped = 0;
+    for (size_t i = 0; i < m_FileNodeCount; ++i) {
+        size_t index = i;
+        if (layout.nodeIds) {
+            index = model.FindNodeIndex(LoadInt(file.Data() + layout.nodeIds + i * sizeof(int32_t)));
+        }
+        if (index < m_NodeCount) {
+            m_NodeMap[i] = static_cast<uint32_t>(index);
+            ++mapped;
+        }
+    }
+    if (mapped == 0 || (!layout.nodeIds && m_FileNodeCount != m_NodeCount)) {
+        m_Error = "the results do not belong to the open model";
+        return false;
+    }
+    if (mapped < m_FileNodeCount) {
+        LOG_WARN("Results: {} of {} nodes are not in the model", m_FileNodeCount - mapped, m_FileNodeCount);
+    }
+    
+    m_FacetMap.assign(m_FileFacetCount, kUnmapped);
+    for (size_t i = 0; i < m_FileFacetCount && layout.facetIds; ++i) {
+        size_t index = model.FindElementIndex(LoadInt(file.Data() + layout.facetIds + i * sizeof(int32_t)));
+        if (index < m_ElementCount) {
+            m_FacetMap[i] = static_cast<uint32_t>(index);
+        }
+    }
+    
+    const ChunkedColumn<glm::vec3>& positions = model.GetNodePositions();
+    m_Reference.resize(m_FileNodeCount);
+    for (size_t i = 0; i < m_FileNodeCount; ++i) {
+        m_Reference[i] = m_NodeMap[i] != kUnmapped ? positions[m_NodeMap[i]] : glm::vec3(0.0f);
+    }
+    return true;
+}
+
+size_t ResultReader::GetStateBytes() const {
+    return m_NodeCount * sizeof(glm::vec3) + m_ElementScalarNames.size() * m_ElementCount * sizeof(float);
+}
+
+bool ResultReader::ReadState(size_t state, ResultState& out) const {
+    if (state >= m_States.size()) {
+        return false;
+    }
+    const StateInfo& info = m_States[state];
+    MappedFile file;
+    if (!file.Open(info.path) || file.Size() != info.fileSize) {
+        LOG_WARN("Results: {} is missing or changed since it was indexed", info.path);
+        return false;
+    }
+    file.AdviseSequential();
+    
+    out.time = info.time;
+    out.displacements.assign(m_NodeCount, glm::vec3(0.0f));
+    const char* coordinates = file.Data() + info.coordinates;
+    for (size_t i = 0; i < m_FileNodeCount; ++i) {
+        if (m_NodeMap[i] == kUnmapped) {
+            continue;
+        }
+        const char* xyz = coordinates + i * 3 * sizeof(float);
+        glm::vec3 position(LoadFloat(xyz), LoadFloat(xyz + 4), LoadFloat(xyz + 8));
+        out.displacements[m_NodeMap[i]] = position - m_Reference[i];
+    }
+    
+    // Field-major, one value per facet
+    out.elementScalars.resize(m_ElementScalarNames.size());
+    for (size_t f = 0; f < m_ElementScalarNames.size(); ++f) {
+        std::vector<float>& scalars = out.elementScalars[f];
+        scalars.assign(m_ElementCount, std::numeric_limits<float>::quiet_NaN());
+        const char* values = file.Data() + info.elementScalars + f * m_FileFacetCount * sizeof(float);
+        for (size_t i = 0; i < m_FileFacetCount; ++i) {
+            if (m_FacetMap[i] != kUnmapped) {
+                scalars[m_FacetMap[i]] = LoadFloat(values + i * sizeof(float));
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Model;
+
+// One decoded state, in the model's node and element order: node
+// displacements from the model's positions, and one array per element
+// scalar field (NaN for elements the state has no value for)
+struct ResultState {
+    float time = 0.0f;
+    std::vector<glm::vec3> displacements;
+    std::vector<std::vector<float>> elementScalars;
+    
+    size_t GetMemoryBytes() const;
+};
+
+// Reader for the animation states an OpenRadioss engine run writes next to
+// its deck (<run>A001, <run>A002, ...), one state per file in the engine's
+// big-endian animation layout. Open indexes every state from its header
+// alone, recording where the coordinates and facet scalars sit, so opening
+// a long run touches a few kilobytes per file; ReadState decodes one state
+// on demand. States are matched to the model by node and element IDs when
+// the run saved them, by order otherwise.
+//
+// After Open the reader is read-only and ReadState may be called from any
+// number of threads at once.
+class ResultReader {
+public:
+    // path is any state file of the run or the run's root name
+    bool Open(const std::string& path, const Model& model);
+    void Close();
+    bool IsOpen() const { return !m_States.empty(); }
+    
+    size_t GetStateCount() const { return m_States.size(); }
+    float GetStateTime(size_t state) const { return m_States[state].time; }
+    const std::string& GetStatePath(size_t state) const { return m_States[state].path; }
+    
+    // Sizes of a decoded state, which follow the model it was opened with
+    size_t GetNodeCount() const { return m_NodeCount; }
+    size_t GetElementCount() const { return m_ElementCount; }
+    const std::vector<std::string>& GetElementScalarNames() const { return m_ElementScalarNames; }
+    size_t GetStateBytes() const;
+    
+    bool ReadState(size_t state, ResultState& out) const;
+    
+    const std::string& GetError() const { return m_Error; }
+    
+    // Splits "<root>A<number>" into its parts; false for other names
+    static bool ParseStateName(const std::string& filename, std::string& root, int& number);
+
+private:
+    // Byte offsets of the arrays a state is decoded from
+    struct StateInfo {
+        std::string path;
+        uint64_t fileSize = 0;
+        float time = 0.0f;
+        uint64_t coordinates = 0;
+        uint64_t elementScalars = 0;
+    };
+    
+    static constexpr uint32_t kUnmapped = 0xFFFFFFFFu;
+    
+    bool MapEntities(const std::string& path, const Model& model);
+
+private:
+    std::vector<StateInfo> m_States;
+    
+    // Shared by every state of the run
+    size_t m_FileNodeCount = 0;
+    size_t m_FileFacetCount = 0;
+    std::vector<std::string> m_ElementScalarNames;
+    
+    // File node/facet -> model node/element, and the model positions the
+    // displacements are measured from
+    std::vector<uint32_t> m_NodeMap;
+    std::vector<uint32_t> m_FacetMap;
+    std::vector<glm::vec3> m_Reference;
+    size_t m_NodeCount = 0;
+    size_t m_ElementCount = 0;
+    
+    std::string m_Error;
+};
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <algorithm>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <imgui.h>
@@ -10,6 +14,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "utils/Config.h"
+#include "rendering/ProgramCache.h"
+#include "rendering/GpuTimer.h"
+#include "gui/ProfilerPanel.h"
+#include "utils/Profiler.h"
+
 #if __has_include("../include/radfilereader.h")
 #include "../include/radfilereader.h"
 #elif __has_include("radfilereader.h")
@@ -41,20 +51,48 @@ struct AppState {
     std::string current_file;
     
     // Model data
-    OpenRadiossGUI::RadFileReader rad_reader;
+    std::shared_ptr<OpenRadiossGUI::RadFileReader> rad_reader =
+        std::make_shared<OpenRadiossGUI::RadFileReader>();
     bool model_loaded = false;
     glm::vec3 model_min = glm::vec3(0.0f);
     glm::vec3 model_max = glm::vec3(0.0f);
     
     // OpenGL objects
     GLuint shader_program = 0;
+    GLint model_location = -1, view_location = -1, projection_location = -1;   // Looked up once
     GLuint node_vao = 0, node_vbo = 0;
     GLuint element_vao = 0, element_vbo = 0, element_ebo = 0;
     GLuint axis_vao = 0, axis_vbo = 0;
     size_t element_index_count = 0;
     size_t node_count = 0;
+    
+    // Background loading: the reader parses on a worker thread and the node
+    // buffer is filled a slice per frame once it finishes
+    struct LoadResult {
+        bool ok = false;
+        std::vector<float> node_data;
+    };
+    std::shared_ptr<OpenRadiossGUI::RadFileReader> loading_reader;
+    std::future<LoadResult> load_result;
+    std::string loading_file;
+    bool loading = false;
+    bool loading_cancelled = false;
+    double loading_start = 0.0;
+    std::vector<float> node_upload_data;
+    size_t node_upload_offset = 0;
+    
+    // Frames are drawn only after input or while loading; ImGui settles a
+    // change over a few frames
+    int redraw_frames = 3;
 };
 
+// Bytes of vertex data sent to the GPU per frame while a model streams in
+const size_t kUploadBudgetPerFrame = 4 * 1024 * 1024;
+
+// Frame pacing while nothing changes
+const int kSettleFrames = 3;
+const double kIdleTimeout = 0.5;
+
 const char* vertex_shader_source = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
@@ -79,6 +117,14 @@ void main() {
 )";
 
 GLuint createShaderProgram() {
+    // Linked binaries from an earlier run spare the compile
+    const uint64_t key = ProgramCache::MakeKey({vertex_shader_source, fragment_shader_source});
+    GLuint program = glCreateProgram();
+    if (ProgramCache::Load(key, program)) {
+        return program;
+    }
+    glDeleteProgram(program);
+    
     GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex_shader, 1, &vertex_shader_source, nullptr);
     glCompileShader(vertex_shader);
@@ -87,10 +133,12 @@ GLuint createShaderProgram() {
     glShaderSource(fragment_shader, 1, &fragment_shader_source, nullptr);
     glCompileShader(fragment_shader);
     
-    GLuint program = glCreateProgram();
+    program = glCreateProgram();
     glAttachShader(program, vertex_shader);
     glAttachShader(program, fragment_shader);
+    ProgramCache::PrepareProgram(program);
     glLinkProgram(program);
+    ProgramCache::Store(key, program);
     
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
@@ -117,46 +165,112 @@ void createAxisGeometry(AppState& app) {
 }
 
 void loadRADFile(AppState& app, const std::string& filename) {
-    if (app.rad_reader.loadFile(filename)) {
-        app.current_file = filename;
-        app.model_loaded = true;
-        
-        if (app.rad_reader.getNodeCount() > 0) {
-            auto bbox = app.rad_reader.getBoundingBox();
-            app.model_min = bbox.first;
-            app.model_max = bbox.second;
-            glm::vec3 center = (app.model_min + app.model_max) * 0.5f;
-            glm::vec3 size = app.model_max - app.model_min;
-            float max_size = glm::max(glm::max(size.x, size.y), size.z);
-            app.camera_target = center;
-            app.camera_distance = max_size * 2.0f;
-        }
-        
-        // Create geometry buffers (simplified)
-        const auto& nodes = app.rad_reader.getNodes();
-        if (!nodes.empty()) {
-            std::vector<float> node_data;
+    if (app.loading) return;
+    
+    auto reader = std::make_shared<OpenRadiossGUI::RadFileReader>();
+    app.loading_reader = reader;
+    app.loading_file = filename;
+    app.loading = true;
+    app.loading_cancelled = false;
+    app.loading_start = glfwGetTime();
+    
+    // Parse and build the node vertex data off the render thread
+    app.load_result = std::async(std::launch::async, [reader, filename]() {
+        PROFILE_SCOPE("Load");
+        AppState::LoadResult result;
+        result.ok = reader->loadFile(filename);
+        if (result.ok) {
+            const auto& nodes = reader->getNodes();
+            result.node_data.reserve(nodes.size() * 6);
             for (const auto& node : nodes) {
-                node_data.insert(node_data.end(), {node.position.x, node.position.y, node.position.z, 1.0f, 1.0f, 0.0f});
+                result.node_data.insert(result.node_data.end(), {node.position.x, node.position.y, node.position.z, 1.0f, 1.0f, 0.0f});
             }
-            
-            glGenVertexArrays(1, &app.node_vao);
-            glGenBuffers(1, &app.node_vbo);
-            glBindVertexArray(app.node_vao);
-            glBindBuffer(GL_ARRAY_BUFFER, app.node_vbo);
-            glBufferData(GL_ARRAY_BUFFER, node_data.size() * sizeof(float), node_data.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-            glEnableVertexAttribArray(1);
-            glBindVertexArray(0);
-            app.node_count = nodes.size();
         }
-        
-        std::cout << "Loaded: " << filename << " (" << app.rad_reader.getNodeCount() << " nodes)" << std::endl;
-    } else {
+        return result;
+    });
+}
+
+void finishLoading(AppState& app, AppState::LoadResult result) {
+    auto reader = std::move(app.loading_reader);
+    const std::string filename = app.loading_file;
+    
+    if (app.loading_cancelled) {
+        std::cout << "Loading cancelled: " << filename << std::endl;
+        return;
+    }
+    if (!result.ok) {
         std::cerr << "Failed to load: " << filename << std::endl;
+        return;
+    }
+    
+    app.rad_reader = reader;
+    app.current_file = filename;
+    app.model_loaded = true;
+    
+    if (app.rad_reader->getNodeCount() > 0) {
+        auto bbox = app.rad_reader->getBoundingBox();
+        app.model_min = bbox.first;
+        app.model_max = bbox.second;
+        glm::vec3 center = (app.model_min + app.model_max) * 0.5f;
+        glm::vec3 size = app.model_max - app.model_min;
+        float max_size = glm::max(glm::max(size.x, size.y), size.z);
+        app.camera_target = center;
+        app.camera_distance = max_size * 2.0f;
+    }
+    
+    // Allocate the node buffer now; uploadNodeSlice fills it over the next frames
+    if (app.node_vao) glDeleteVertexArrays(1, &app.node_vao);
+    if (app.node_vbo) glDeleteBuffers(1, &app.node_vbo);
+    app.node_vao = app.node_vbo = 0;
+    app.node_count = 0;
+    app.node_upload_data = std::move(result.node_data);
+    app.node_upload_offset = 0;
+    
+    if (!app.node_upload_data.empty()) {
+        glGenVertexArrays(1, &app.node_vao);
+        glGenBuffers(1, &app.node_vbo);
+        glBindVertexArray(app.node_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, app.node_vbo);
+        glBufferData(GL_ARRAY_BUFFER, app.node_upload_data.size() * sizeof(float), nullptr, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
     }
+    
+    std::cout << "Loaded: " << filename << " (" << app.rad_reader->getNodeCount() << " nodes)" << std::endl;
+}
+
+void uploadNodeSlice(AppState& app) {
+    if (app.node_upload_offset >= app.node_upload_data.size()) return;
+    
+    // Whole vertices only, so node_count always covers uploaded data
+    const size_t floats_per_node = 6;
+    size_t budget = std::max<size_t>(1, kUploadBudgetPerFrame / (floats_per_node * sizeof(float))) * floats_per_node;
+    size_t count = std::min(budget, app.node_upload_data.size() - app.node_upload_offset);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, app.node_vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, app.node_upload_offset * sizeof(float), count * sizeof(float),
+                    app.node_upload_data.data() + app.node_upload_offset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    app.node_upload_offset += count;
+    app.node_count = app.node_upload_offset / floats_per_node;
+    
+    if (app.node_upload_offset >= app.node_upload_data.size()) {
+        app.node_upload_data = std::vector<float>();
+        app.node_upload_offset = 0;
+    }
+}
+
+void updateLoading(AppState& app) {
+    if (app.loading &&
+        app.load_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        app.loading = false;
+        finishLoading(app, app.load_result.get());
+    }
+    uploadNodeSlice(app);
 }
 
 void updateCamera(AppState& app) {
@@ -166,8 +280,17 @@ void updateCamera(AppState& app) {
     app.camera_pos = app.camera_target + glm::vec3(x, y, z);
 }
 
+bool needsFrame(const AppState& app) {
+    return app.redraw_frames > 0 || app.loading || !app.node_upload_data.empty();
+}
+
+void requestRedraw(GLFWwindow* window) {
+    static_cast<AppState*>(glfwGetWindowUserPointer(window))->redraw_frames = kSettleFrames;
+}
+
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     AppState* app = static_cast<AppState*>(glfwGetWindowUserPointer(window));
+    requestRedraw(window);
     if (action == GLFW_PRESS) {
         switch (key) {
             case GLFW_KEY_ESCAPE: glfwSetWindowShouldClose(window, GLFW_TRUE); break;
@@ -183,6 +306,7 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     AppState* app = static_cast<AppState*>(glfwGetWindowUserPointer(window));
+    requestRedraw(window);
     app->camera_distance *= (1.0f - static_cast<float>(yoffset) * 0.1f);
     app->camera_distance = glm::clamp(app->camera_distance, 0.1f, 1000.0f);
 }
@@ -192,6 +316,11 @@ int main() {
     
     if (!glfwInit()) return -1;
     
+    Config config;
+    if (!config.Load("resources/config/default_settings.json")) {
+        std::cerr << "Using default settings: " << config.GetError() << std::endl;
+    }
+    
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -200,10 +329,19 @@ int main() {
     if (!app.window) { glfwTerminate(); return -1; }
     
     glfwMakeContextCurrent(app.window);
+    glfwSwapInterval(config.GetBool("application.window.vsync", true) ? 1 : 0);
     glfwSetWindowUserPointer(app.window, &app);
     glfwSetKeyCallback(app.window, keyCallback);
     glfwSetScrollCallback(app.window, scrollCallback);
     
+    // Any other input may change what ImGui shows
+    glfwSetCharCallback(app.window, [](GLFWwindow* w, unsigned int) { requestRedraw(w); });
+    glfwSetMouseButtonCallback(app.window, [](GLFWwindow* w, int, int, int) { requestRedraw(w); });
+    glfwSetCursorPosCallback(app.window, [](GLFWwindow* w, double, double) { requestRedraw(w); });
+    glfwSetWindowFocusCallback(app.window, [](GLFWwindow* w, int) { requestRedraw(w); });
+    glfwSetFramebufferSizeCallback(app.window, [](GLFWwindow* w, int, int) { requestRedraw(w); });
+    glfwSetWindowRefreshCallback(app.window, [](GLFWwindow* w) { requestRedraw(w); });
+    
     if (glewInit() != GLEW_OK) return -1;
     
     glEnable(GL_DEPTH_TEST);
@@ -218,14 +356,30 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(app.window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
     
+    ProgramCache::SetDirectory(config.GetString("renderer.shaderCache", ProgramCache::GetDirectory()));
     app.shader_program = createShaderProgram();
+    app.model_location = glGetUniformLocation(app.shader_program, "model");
+    app.view_location = glGetUniformLocation(app.shader_program, "view");
+    app.projection_location = glGetUniformLocation(app.shader_program, "projection");
     createAxisGeometry(app);
+    auto gpu_timer = std::make_unique<GpuTimer>();
+    ProfilerPanel profiler_panel;
     
     std::cout << "OpenRadioss GUI Started!" << std::endl;
     std::cout << "Press Ctrl+O to open a file, or drag mouse to rotate camera" << std::endl;
     
     while (!glfwWindowShouldClose(app.window)) {
-        glfwPollEvents();
+        // Sleeps until input while nothing changes
+        if (needsFrame(app)) {
+            glfwPollEvents();
+        } else {
+            glfwWaitEventsTimeout(kIdleTimeout);
+        }
+        if (!needsFrame(app)) continue;
+        if (app.redraw_frames > 0) --app.redraw_frames;
+        Profiler::Get().BeginFrame();
+        gpu_timer->BeginFrame();
+        updateLoading(app);
         updateCamera(app);
         
         glClearColor(app.background_color.r, app.background_color.g, app.background_color.b, 1.0f);
@@ -274,9 +428,9 @@ int main() {
             ImGui::Checkbox("Axes", &app.show_axes);
         }
         if (app.model_loaded && ImGui::CollapsingHeader("Model", ImGuiTreeNodeFlags_DefaultOpen)) {
-            ImGui::Text("Nodes: %zu", app.rad_reader.getNodeCount());
-            ImGui::Text("Elements: %zu", app.rad_reader.getElementCount());
-            ImGui::Text("Materials: %zu", app.rad_reader.getMaterialCount());
+            ImGui::Text("Nodes: %zu", app.rad_reader->getNodeCount());
+            ImGui::Text("Elements: %zu", app.rad_reader->getElementCount());
+            ImGui::Text("Materials: %zu", app.rad_reader->getMaterialCount());
         }
         ImGui::End();
         
@@ -286,15 +440,16 @@ int main() {
         
         if (viewport_size.x > 0 && viewport_size.y > 0) {
             // Render 3D scene
+            GpuTimer::Pass scene_pass(*gpu_timer, "Scene");
             float aspect = viewport_size.x / viewport_size.y;
             glm::mat4 projection = glm::perspective(glm::radians(app.camera_fov), aspect, 0.1f, 1000.0f);
             glm::mat4 view = glm::lookAt(app.camera_pos, app.camera_target, app.camera_up);
             glm::mat4 model = glm::mat4(1.0f);
             
             glUseProgram(app.shader_program);
-            glUniformMatrix4fv(glGetUniformLocation(app.shader_program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniformMatrix4fv(glGetUniformLocation(app.shader_program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(glGetUniformLocation(app.shader_program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(app.model_location, 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix4fv(app.view_location, 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(app.projection_location, 1, GL_FALSE, glm::value_ptr(projection));
             
             // Render axes
             if (app.show_axes) {
@@ -335,7 +490,7 @@ int main() {
             static char filename[256] = "examples/test.rad";
             ImGui::Begin("Open File", &app.show_file_dialog);
             ImGui::InputText("File", filename, sizeof(filename));
-            if (ImGui::Button("Load")) {
+            if (ImGui::Button("Load") && !app.loading) {
                 loadRADFile(app, filename);
                 app.show_file_dialog = false;
             }
@@ -344,6 +499,19 @@ int main() {
             ImGui::End();
         }
         
+        if (app.loading) {
+            // The reader has no progress hooks, so show elapsed time instead
+            ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+            ImGui::Text("%s", app.loading_file.c_str());
+            if (app.loading_cancelled) {
+                ImGui::Text("Cancelling...");
+            } else {
+                ImGui::Text("Parsing... %.1f s", glfwGetTime() - app.loading_start);
+                if (ImGui::Button("Cancel")) app.loading_cancelled = true;
+            }
+            ImGui::End();
+        }
+        
         if (app.show_about) {
             ImGui::Begin("About", &app.show_about);
             ImGui::Text("OpenRadioss GUI v1.0");
@@ -356,18 +524,29 @@ int main() {
             ImGui::Text("OpenGL: %s", glGetString(GL_VERSION));
             if (app.model_loaded) {
                 ImGui::Text("File: %s", app.current_file.c_str());
-                ImGui::Text("Nodes: %zu", app.rad_reader.getNodeCount());
-                ImGui::Text("Elements: %zu", app.rad_reader.getElementCount());
+                ImGui::Text("Nodes: %zu", app.rad_reader->getNodeCount());
+                ImGui::Text("Elements: %zu", app.rad_reader->getElementCount());
             }
+            ImGui::Separator();
+            profiler_panel.Draw();
             ImGui::End();
         }
         
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(app.window);
+        {
+            GpuTimer::Pass gui_pass(*gpu_timer, "GUI");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        gpu_timer->EndFrame();
+        {
+            PROFILE_SCOPE("SwapBuffers");
+            glfwSwapBuffers(app.window);
+        }
+        Profiler::Get().EndFrame();
     }
     
     // Cleanup
+    gpu_timer.reset();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,273 @@
+#include "rendering/AnimationStream.h"
+#include "io/ResultCache.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool StaticDisplacementSource::Decode(size_t frame, glm::vec3* displacements) {
+    if (frame != 0) {
+        return false;
+    }
+    std::copy(m_Displacements.begin(), m_Displacements.end(), displacements);
+    return true;
+}
+
+size_t ResultDisplacementSource::GetFrameCount() const {
+    return m_Cache->GetStateCount();
+}
+
+size_t ResultDisplacementSource::GetNodeCount() const {
+    return m_Cache->GetReader().GetNodeCount();
+}
+
+bool ResultDisplacementSource::Decode(size_t frame, glm::vec3* displacements) {
+    std::shared_ptr<const ResultState> state = m_Cache->Get(frame);
+    if (!state) {
+        return false;
+    }
+    std::copy(state->displacements.begin(), state->displacements.end(), displacements);
+    return true;
+}
+
+AnimationStream::AnimationStream(std::unique_ptr<DisplacementSource> source)
+    : m_Source(std::move(source)), m_FrameCount(0), m_NodeCount(0), m_SlotBytes(0),
+      m_Buffer(0), m_Mapped(nullptr),
+      m_Playing(false), m_FrameRate(30.0f), m_Clock(0.0), m_Current(-1),
+      m_NextDecode(0), m_Generation(0), m_Stopping(false) {
+    if (!m_Source || m_Source->GetFrameCount() == 0 || m_Source->GetNodeCount() == 0) {
+        return;
+    }
+    m_FrameCount = m_Source->GetFrameCount();
+    m_NodeCount = m_Source->GetNodeCount();
+    m_SlotBytes = m_NodeCount * sizeof(glm::vec3);
+    const size_t totalBytes = m_SlotBytes * kSlotCount;
+    
+    glGenBuffers(1, &m_Buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, totalBytes, nullptr, flags);
+        m_Mapped = static_cast<glm::vec3*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, totalBytes, flags));
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    for (int s = 0; s < kSlotCount; ++s) {
+        Slot& slot = m_Slots[s];
+        if (m_Mapped) {
+            slot.data = m_Mapped + s * m_NodeCount;
+        } else {
+            slot.staging.resize(m_NodeCount);
+            slot.data = slot.staging.data();
+        }
+    }
+    LOG_INFO("Animation: {} states of {} nodes, {} ring of {} MB", m_FrameCount, m_NodeCount,
+             m_Mapped ? "persistent" : "staged", totalBytes >> 20);
+    
+    m_Thread = std::thread(&AnimationStream::DecodeLoop, this);
+}
+
+AnimationStream::~AnimationStream() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+    
+    for (Slot& slot : m_Slots) {
+        if (slot.fence) glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+    }
+    if (m_Mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if (m_Buffer) glDeleteBuffers(1, &m_Buffer);
+}
+
+void AnimationStream::Seek(size_t frame) {
+    if (m_FrameCount == 0) {
+        return;
+    }
+    frame %= m_FrameCount;
+    m_Clock = static_cast<double>(frame);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Generation;
+        m_NextDecode = frame;
+        for (Slot& slot : m_Slots) {
+            if (slot.state == SlotState::READY) {
+                slot.state = SlotState::FREE;
+            }
+        }
+    }
+    m_Condition.notify_all();
+}
+
+bool AnimationStream::Update(float deltaTime) {
+    if (m_FrameCount == 0) {
+        return false;
+    }
+    ReleaseRetired();
+    if (m_Playing) {
+        m_Clock = std::fmod(m_Clock + deltaTime * m_FrameRate, static_cast<double>(m_FrameCount));
+    }
+    const size_t target = std::min(static_cast<size_t>(m_Clock), m_FrameCount - 1);
+    
+    // States are decoded in playback order from the clock on; the one
+    // closest behind the clock is shown, older ones are dropped and newer
+    // ones wait for their turn
+    auto behind = [&](size_t frame) { return (target + m_FrameCount - frame) % m_FrameCount; };
+    const size_t window = std::max<size_t>(1, m_FrameCount / 2);
+    
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        int best = -1;
+        for (int s = 0; s < kSlotCount; ++s) {
+            const Slot& slot = m_Slots[s];
+            if (slot.state == SlotState::READY && behind(slot.frame) < window &&
+                (best < 0 || behind(slot.frame) < behind(m_Slots[best].frame))) {
+                best = s;
+            }
+        }
+        if (best >= 0 && m_Current >= 0 && behind(m_Slots[m_Current].frame) < window &&
+            behind(m_Slots[m_Current].frame) <= behind(m_Slots[best].frame)) {
+            best = -1;   // Already showing something at least as recent
+        }
+        for (int s = 0; s < kSlotCount; ++s) {
+            Slot& slot = m_Slots[s];
+            if (s != best && slot.state == SlotState::READY && behind(slot.frame) < window &&
+                (best >= 0 || m_Current >= 0)) {
+                size_t shown = best >= 0 ? m_Slots[best].frame : m_Slots[m_Current].frame;
+                if (behind(slot.frame) > behind(shown)) {
+                    slot.state = SlotState::FREE;
+                    changed = true;
+                }
+            }
+        }
+        if (best >= 0) {
+            if (m_Current >= 0) {
+                m_Slots[m_Current].state = SlotState::RETIRED;
+            }
+            m_Slots[best].state = SlotState::CURRENT;
+            m_Current = best;
+            changed = true;
+        }
+    }
+    if (changed) {
+        m_Condition.notify_all();
+    }
+    
+    // The slot's region is not in use by the GPU: it was either never drawn
+    // or retired and fenced before being decoded into again
+    if (changed && m_Current >= 0 && !m_Mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, m_Current * m_SlotBytes, m_SlotBytes,
+                        m_Slots[m_Current].staging.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    return m_Current >= 0;
+}
+
+size_t AnimationStream::GetCurrentFrame() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Current >= 0 ? m_Slots[m_Current].frame : 0;
+}
+
+size_t AnimationStream::GetOffset() const {
+    return m_Current >= 0 ? m_Current * m_SlotBytes : 0;
+}
+
+float AnimationStream::GetMaxDisplacement() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Current >= 0 ? m_Slots[m_Current].maxDisplacement : 0.0f;
+}
+
+void AnimationStream::EndFrame() {
+    if (m_Current < 0) {
+        return;
+    }
+    Slot& slot = m_Slots[m_Current];
+    if (slot.fence) glDeleteSync(static_cast<GLsync>(slot.fence));
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void AnimationStream::ReleaseRetired() {
+    bool released = false;
+    for (Slot& slot : m_Slots) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (slot.state != SlotState::RETIRED) {
+            continue;
+        }
+        if (slot.fence) {
+            GLenum status = glClientWaitSync(static_cast<GLsync>(slot.fence), 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                continue;
+            }
+            glDeleteSync(static_cast<GLsync>(slot.fence));
+            slot.fence = nullptr;
+        }
+        slot.state = SlotState::FREE;
+        released = true;
+    }
+    if (released) {
+        m_Condition.notify_all();
+    }
+}
+
+void AnimationStream::DecodeLoop() {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (true) {
+        // Decode the next frame into a free slot unless a slot has it already
+        Slot* slot = nullptr;
+        m_Condition.wait(lock, [&]() {
+            if (m_Stopping) {
+                return true;
+            }
+            slot = nullptr;
+            for (Slot& candidate : m_Slots) {
+                if (candidate.state != SlotState::FREE && candidate.state != SlotState::RETIRED &&
+                    candidate.frame == m_NextDecode) {
+                    return false;
+                }
+                if (!slot && candidate.state == SlotState::FREE) {
+                    slot = &candidate;
+                }
+            }
+            return slot != nullptr;
+        });
+        if (m_Stopping) {
+            return;
+        }
+        
+        const size_t frame = m_NextDecode;
+        const size_t generation = m_Generation;
+        m_NextDecode = (frame + 1) % m_FrameCount;
+        slot->state = SlotState::DECODING;
+        slot->frame = frame;
+        
+        lock.unlock();
+        bool decoded = m_Source->Decode(frame, slot->data);
+        float maxSquared = 0.0f;
+        if (decoded) {
+            for (size_t n = 0; n < m_NodeCount; ++n) {
+                maxSquared = std::max(maxSquared, glm::dot(slot->data[n], slot->data[n]));
+            }
+        } else {
+            LOG_WARN("Animation: state {} could not be decoded", frame);
+            std::memset(static_cast<void*>(slot->data), 0, m_SlotBytes);
+        }
+        lock.lock();
+        
+        slot->maxDisplacement = std::sqrt(maxSquared);
+        slot->state = generation == m_Generation ? SlotState::READY : SlotState::FREE;
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ResultCache;
+
+// Per-node displacements of every state of a result, in the model's node
+// order. Decode is called on the animation thread only.
+class DisplacementSource {
+public:
+    virtual ~DisplacementSource() = default;
+    
+    virtual size_t GetFrameCount() const = 0;
+    virtual size_t GetNodeCount() const = 0;
+    virtual bool Decode(size_t frame, glm::vec3* displacements) = 0;
+};
+
+// A single state, e.g. the displacements stored in the model's nodes
+class StaticDisplacementSource : public DisplacementSource {
+public:
+    explicit StaticDisplacementSource(std::vector<glm::vec3> displacements)
+        : m_Displacements(std::move(displacements)) {}
+    
+    size_t GetFrameCount() const override { return 1; }
+    size_t GetNodeCount() const override { return m_Displacements.size(); }
+    bool Decode(size_t frame, glm::vec3* displacements) override;
+
+private:
+    std::vector<glm::vec3> m_Displacements;
+};
+
+// The states of a solver run, decoded through a result cache that reads
+// ahead of playback
+class ResultDisplacementSource : public DisplacementSource {
+public:
+    explicit ResultDisplacementSource(std::shared_ptr<ResultCache> cache)
+        : m_Cache(std::move(cache)) {}
+    
+    size_t GetFrameCount() const override;
+    size_t GetNodeCount() const override;
+    bool Decode(size_t frame, glm::vec3* displacements) override;
+
+private:
+    std::shared_ptr<ResultCache> m_Cache;
+};
+
+// Plays a result's displacement states through a ring of kSlotCount GPU
+// slots, one frame of node displacements each. A background thread
+// decodes states ahead of playback straight into free slots; the render
+// thread only picks up decoded ones, so playback never waits for a decode
+// and drops frames instead when decoding falls behind.
+//
+// With GL 4.4 or ARB_buffer_storage the ring is persistently mapped and the
+// decoder writes into GPU-visible memory; slots are handed back once the
+// fence placed after their last draw has passed. Otherwise each slot has a
+// staging copy that glBufferSubData uploads when it becomes current.
+// Create, update and destroy on the render thread.
+class AnimationStream {
+public:
+    static constexpr int kSlotCount = 3;
+    
+    explicit AnimationStream(std::unique_ptr<DisplacementSource> source);
+    ~AnimationStream();
+    
+    AnimationStream(const AnimationStream&) = delete;
+    AnimationStream& operator=(const AnimationStream&) = delete;
+    
+    // Playback, looping at the end
+    void Play() { m_Playing = true; }
+    void Pause() { m_Playing = false; }
+    bool IsPlaying() const { return m_Playing; }
+    void Seek(size_t frame);
+    void SetFrameRate(float framesPerSecond) { m_FrameRate = framesPerSecond; }
+    float GetFrameRate() const { return m_FrameRate; }
+    size_t GetFrameCount() const { return m_FrameCount; }
+    size_t GetNodeCount() const { return m_NodeCount; }
+    bool IsPersistent() const { return m_Mapped != nullptr; }
+    
+    // Once per frame before drawing: advances the clock and makes the
+    // decoded state closest to it current. Returns whether one is current.
+    bool Update(float deltaTime);
+    
+    // Current state: the buffer, its byte offset and the largest
+    // displacement in it, for growing bounds
+    size_t GetCurrentFrame() const;
+    unsigned int GetBuffer() const { return m_Buffer; }
+    size_t GetOffset() const;
+    float GetMaxDisplacement() const;
+    
+    // After the last draw reading the current state
+    void EndFrame();
+
+private:
+    enum class SlotState {
+        FREE,
+        DECODING,
+        READY,
+        CURRENT,
+        RETIRED     // Replaced, waiting for the GPU to finish with it
+    };
+    
+    struct Slot {
+        SlotState state = SlotState::FREE;
+        size_t frame = 0;
+        float maxDisplacement = 0.0f;
+        void* fence = nullptr;              // GLsync of the slot's last draw
+        glm::vec3* data = nullptr;          // Mapped memory or staging
+        std::vector<glm::vec3> staging;
+    };
+    
+    void DecodeLoop();
+    void ReleaseRetired();
+
+private:
+    std::unique_ptr<DisplacementSource> m_Source;
+    size_t m_FrameCount;
+    size_t m_NodeCount;
+    size_t m_SlotBytes;
+    
+    unsigned int m_Buffer;
+    glm::vec3* m_Mapped;
+    
+    // Render thread only
+    bool m_Playing;
+    float m_FrameRate;
+    double m_Clock;        // In frames
+    int m_Current;         // Slot index, or -1
+    
+    // Guarded by m_Mutex
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    Slot m_Slots[kSlotCount];
+    size_t m_NextDecode;
+    size_t m_Generation;   // Bumped by Seek so stale decodes are dropped
+    bool m_Stopping;
+    
+    std::thread m_Thread;
+};
@@ -47,8 +47,18 @@ void Camera::FitToModel(Model* model) {
     if (!model || model->GetNodeCount() == 0) return;
     
     model->CalculateBounds();
-    m_Target = model->GetCenter();
-    m_Distance = model->GetBoundingRadius() * 2.5f;
+    FitToBounds(model->GetCenter(), model->GetBoundingRadius());
+}
+
+void Camera::FitToBounds(const glm::vec3& center, float radius) {
+    m_Target = center;
+    m_Distance = radius * 2.5f;
+    
+    // Depth range follows the model, so decks in millimetres are not clipped
+    if (radius > 0.0f) {
+        m_NearPlane = radius * 0.01f;
+        m_FarPlane = radius * 100.0f;
+    }
     
     UpdateCameraVectors();
 }
@@ -63,6 +73,14 @@ void Camera::Reset() {
     UpdateCameraVectors();
 }
 
+void Camera::SetOrbit(float yaw, float pitch, float distance) {
+    m_Yaw = yaw;
+    m_Pitch = std::max(-89.0f, std::min(pitch, 89.0f));
+    m_Distance = std::max(distance, 0.001f);
+    
+    UpdateCameraVectors();
+}
+
 glm::mat4 Camera::GetViewMatrix() const {
     return glm::lookAt(m_Position, m_Target, m_Up);
 }
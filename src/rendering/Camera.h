@@ -15,8 +15,13 @@ public:
     void ProcessMouseScroll(float yoffset);
     
     void FitToModel(Model* model);
+    void FitToBounds(const glm::vec3& center, float radius);
     void Reset();
     
+    // Looks at the target from yaw and pitch in degrees, at a distance
+    void SetOrbit(float yaw, float pitch, float distance);
+    float GetDistance() const { return m_Distance; }
+    
     // Getters
     glm::mat4 GetViewMatrix() const;
     glm::mat4 GetProjectionMatrix() const;
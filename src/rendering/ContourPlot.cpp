@@ -0,0 +1,394 @@
+#include "rendering/ContourPlot.h"
+#include "rendering/Shader.h"
+#include "core/Model.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// Pass inputs that the drawing shaders do not read
+constexpr unsigned int kOffsetUnit = 8;      // usamplerBuffer, R32UI
+constexpr unsigned int kEntryUnit = 9;       // usamplerBuffer, R32UI
+constexpr unsigned int kPassValueUnit = 10;  // samplerBuffer, R32F
+constexpr unsigned int kPreviousUnit = 11;   // sampler2D, RG32F
+
+constexpr size_t kRowLength = 4096;          // Texels per row of the node target
+constexpr size_t kValuesPerTexel = 64;       // First reduction step, then 8x8 blocks
+constexpr int kBlockSize = 8;
+
+// GL state the passes change, put back for the frame being drawn
+struct SavedState {
+    GLint drawFramebuffer = 0, readFramebuffer = 0;
+    GLint viewport[4] = {};
+    GLint program = 0, vertexArray = 0;
+    GLint blendSrcRgb = 0, blendDstRgb = 0, blendSrcAlpha = 0, blendDstAlpha = 0;
+    GLboolean depthTest = GL_FALSE, blend = GL_FALSE;
+    
+    SavedState() {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRgb);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRgb);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+        depthTest = glIsEnabled(GL_DEPTH_TEST);
+        blend = glIsEnabled(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+    }
+    
+    ~SavedState() {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glUseProgram(program);
+        glBindVertexArray(vertexArray);
+        glBlendFuncSeparate(blendSrcRgb, blendDstRgb, blendSrcAlpha, blendDstAlpha);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+        glActiveTexture(GL_TEXTURE0);
+    }
+};
+
+void BindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, texture);
+}
+
+size_t CeilDivide(size_t value, size_t divisor) {
+    return (value + divisor - 1) / divisor;
+}
+
+} // namespace
+
+ContourPlot::ContourPlot() : m_Histogram(kHistogramBins, 0.0f) {
+}
+
+ContourPlot::~ContourPlot() {
+    if (m_Fence) glDeleteSync(static_cast<GLsync>(m_Fence));
+    for (unsigned int buffer : {m_OffsetBuffer, m_EntryBuffer, m_ElementBuffer, m_NodeBuffer, m_ReadbackBuffer}) {
+        if (buffer) glDeleteBuffers(1, &buffer);
+    }
+    for (unsigned int texture : {m_OffsetTexture, m_EntryTexture, m_ElementTexture, m_NodeTexture,
+                                 m_ColormapTexture}) {
+        if (texture) glDeleteTextures(1, &texture);
+    }
+    DeleteTarget(m_NodeTarget);
+    DeleteTarget(m_HistogramTarget);
+    for (Target& level : m_Reduction) {
+        DeleteTarget(level);
+    }
+    if (m_EmptyVAO) glDeleteVertexArrays(1, &m_EmptyVAO);
+}
+
+void ContourPlot::SetModel(const Model& model) {
+    // Offsets narrow to 32 bits, as element indices already are
+    const NodeAdjacency& adjacency = model.GetNodeAdjacency();
+    const std::vector<uint32_t>& entries = adjacency.GetEntries();
+    std::vector<uint32_t> offsets(adjacency.GetOffsets().begin(), adjacency.GetOffsets().end());
+    m_NodeCount = adjacency.GetNodeCount();
+    UploadBuffer(m_OffsetBuffer, m_OffsetTexture, GL_R32UI, offsets.data(), offsets.size() * sizeof(uint32_t));
+    UploadBuffer(m_EntryBuffer, m_EntryTexture, GL_R32UI, entries.data(), entries.size() * sizeof(uint32_t));
+    Clear();
+}
+
+void ContourPlot::Clear() {
+    m_ElementCount = 0;
+    m_HasRange = false;
+    std::fill(m_Histogram.begin(), m_Histogram.end(), 0.0f);
+    if (m_Fence) {
+        glDeleteSync(static_cast<GLsync>(m_Fence));
+        m_Fence = nullptr;
+    }
+}
+
+void ContourPlot::SetValues(const std::vector<float>& elementValues) {
+    if (elementValues.empty()) {
+        Clear();
+        return;
+    }
+    EnsureShaders();
+    UploadBuffer(m_ElementBuffer, m_ElementTexture, GL_R32F, elementValues.data(),
+                 elementValues.size() * sizeof(float));
+    m_ElementCount = elementValues.size();
+    
+    SavedState saved;
+    glBindVertexArray(m_EmptyVAO);
+    AverageToNodes();
+    Analyse();
+}
+
+void ContourPlot::SetNodal(bool nodal) {
+    if (nodal == m_Nodal) {
+        return;
+    }
+    m_Nodal = nodal;
+    if (HasValues()) {
+        SavedState saved;
+        glBindVertexArray(m_EmptyVAO);
+        Analyse();
+    }
+}
+
+void ContourPlot::EnsureShaders() {
+    if (m_AverageShader) {
+        return;
+    }
+    m_AverageShader = std::make_unique<Shader>("shaders/contour_pass.vert", "shaders/contour_average.frag");
+    m_ReduceShader = std::make_unique<Shader>("shaders/contour_pass.vert", "shaders/contour_reduce.frag");
+    m_HistogramShader = std::make_unique<Shader>("shaders/contour_histogram.vert", "shaders/contour_histogram.frag");
+    
+    // Samplers keep their texture units for good
+    m_AverageShader->Use();
+    m_AverageShader->Set(m_AverageShader->GetUniform<int>("elementValues"), static_cast<int>(kElementValueUnit));
+    m_AverageShader->Set(m_AverageShader->GetUniform<int>("adjacencyOffsets"), static_cast<int>(kOffsetUnit));
+    m_AverageShader->Set(m_AverageShader->GetUniform<int>("adjacencyEntries"), static_cast<int>(kEntryUnit));
+    m_ReduceShader->Use();
+    m_ReduceShader->Set(m_ReduceShader->GetUniform<int>("values"), static_cast<int>(kPassValueUnit));
+    m_ReduceShader->Set(m_ReduceShader->GetUniform<int>("previous"), static_cast<int>(kPreviousUnit));
+    m_HistogramShader->Use();
+    m_HistogramShader->Set(m_HistogramShader->GetUniform<int>("values"), static_cast<int>(kPassValueUnit));
+    m_HistogramShader->Set(m_HistogramShader->GetUniform<int>("range"), static_cast<int>(kRangeUnit));
+    m_HistogramShader->Set(m_HistogramShader->GetUniform<int>("binCount"), kHistogramBins);
+    glUseProgram(0);
+    
+    glGenVertexArrays(1, &m_EmptyVAO);
+}
+
+void ContourPlot::EnsureTarget(Target& target, unsigned int format, int width, int height) {
+    if (target.framebuffer && target.width == width && target.height == height) {
+        return;
+    }
+    if (!target.framebuffer) glGenFramebuffers(1, &target.framebuffer);
+    if (!target.texture) glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format == GL_RG32F ? GL_RG : GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    target.width = width;
+    target.height = height;
+}
+
+void ContourPlot::DeleteTarget(Target& target) {
+    if (target.framebuffer) glDeleteFramebuffers(1, &target.framebuffer);
+    if (target.texture) glDeleteTextures(1, &target.texture);
+    target = Target();
+}
+
+void ContourPlot::UploadBuffer(unsigned int& buffer, unsigned int& texture, unsigned int format,
+                               const void* data, size_t bytes) {
+    if (!buffer) glGenBuffers(1, &buffer);
+    if (!texture) glGenTextures(1, &texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    
+    // Without storage the texture reads as size zero, which shaders take as no values
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, bytes ? buffer : 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void ContourPlot::AverageToNodes() {
+    if (m_NodeCount == 0) {
+        return;
+    }
+    
+    // One fragment per node gathers over its elements; the rows are then
+    // packed into the node buffer, so its index is the node's
+    const int width = static_cast<int>(std::min(m_NodeCount, kRowLength));
+    const int height = static_cast<int>(CeilDivide(m_NodeCount, kRowLength));
+    EnsureTarget(m_NodeTarget, GL_R32F, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_NodeTarget.framebuffer);
+    glViewport(0, 0, width, height);
+    
+    m_AverageShader->Use();
+    m_AverageShader->SetInt("nodeCount", static_cast<int>(m_NodeCount));
+    m_AverageShader->SetInt("rowLength", width);
+    BindTexture(kElementValueUnit, GL_TEXTURE_BUFFER, m_ElementTexture);
+    BindTexture(kOffsetUnit, GL_TEXTURE_BUFFER, m_OffsetTexture);
+    BindTexture(kEntryUnit, GL_TEXTURE_BUFFER, m_EntryTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    
+    const size_t bytes = static_cast<size_t>(width) * height * sizeof(float);
+    if (bytes != m_NodeBufferBytes) {
+        UploadBuffer(m_NodeBuffer, m_NodeTexture, GL_R32F, nullptr, bytes);
+        m_NodeBufferBytes = bytes;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_NodeBuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ContourPlot::Analyse() {
+    const bool nodal = m_Nodal && m_NodeCount > 0;
+    const unsigned int values = nodal ? m_NodeTexture : m_ElementTexture;
+    const size_t count = nodal ? m_NodeCount : m_ElementCount;
+    ReduceRange(values, count);
+    BuildHistogram(values, count);
+    StartReadback();
+}
+
+void ContourPlot::ReduceRange(unsigned int values, size_t count) {
+    // Level sizes: the first holds kValuesPerTexel values per texel, each
+    // later one 8x8 texels of the one before, down to a single texel
+    const size_t groups = std::max<size_t>(CeilDivide(count, kValuesPerTexel), 1);
+    std::vector<glm::ivec2> sizes;
+    glm::ivec2 size(static_cast<int>(std::min(groups, kRowLength)), static_cast<int>(CeilDivide(groups, kRowLength)));
+    sizes.push_back(size);
+    while (size.x > 1 || size.y > 1) {
+        size = glm::ivec2((size.x + kBlockSize - 1) / kBlockSize, (size.y + kBlockSize - 1) / kBlockSize);
+        sizes.push_back(size);
+    }
+    while (m_Reduction.size() > sizes.size()) {
+        DeleteTarget(m_Reduction.back());
+        m_Reduction.pop_back();
+    }
+    m_Reduction.resize(sizes.size());
+    
+    m_ReduceShader->Use();
+    m_ReduceShader->SetInt("valueCount", static_cast<int>(count));
+    m_ReduceShader->SetInt("rowLength", sizes[0].x);
+    BindTexture(kPassValueUnit, GL_TEXTURE_BUFFER, values);
+    for (size_t level = 0; level < sizes.size(); ++level) {
+        Target& target = m_Reduction[level];
+        EnsureTarget(target, GL_RG32F, sizes[level].x, sizes[level].y);
+        BindTexture(kPreviousUnit, GL_TEXTURE_2D, level > 0 ? m_Reduction[level - 1].texture : 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        glViewport(0, 0, target.width, target.height);
+        m_ReduceShader->SetBool("firstStep", level == 0);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    BindTexture(kPreviousUnit, GL_TEXTURE_2D, 0);
+}
+
+void ContourPlot::BuildHistogram(unsigned int values, size_t count) {
+    // A point per value lands on its bin and blending adds it up
+    EnsureTarget(m_HistogramTarget, GL_R32F, kHistogramBins, 1);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_HistogramTarget.framebuffer);
+    glViewport(0, 0, kHistogramBins, 1);
+    const float zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glClearBufferfv(GL_COLOR, 0, zero);
+    
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+    m_HistogramShader->Use();
+    BindTexture(kPassValueUnit, GL_TEXTURE_BUFFER, values);
+    BindTexture(kRangeUnit, GL_TEXTURE_2D, m_Reduction.back().texture);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+    glDisable(GL_BLEND);
+}
+
+void ContourPlot::StartReadback() {
+    // A newer state replaces a readback still in flight
+    if (m_Fence) {
+        glDeleteSync(static_cast<GLsync>(m_Fence));
+        m_Fence = nullptr;
+    }
+    if (!m_ReadbackBuffer) {
+        glGenBuffers(1, &m_ReadbackBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_ReadbackBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (2 + kHistogramBins) * sizeof(float), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_ReadbackBuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Reduction.back().framebuffer);
+    glReadPixels(0, 0, 1, 1, GL_RG, GL_FLOAT, nullptr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_HistogramTarget.framebuffer);
+    glReadPixels(0, 0, kHistogramBins, 1, GL_RED, GL_FLOAT, reinterpret_cast<void*>(2 * sizeof(float)));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool ContourPlot::Poll() {
+    if (!m_Fence) {
+        return false;
+    }
+    GLenum status = glClientWaitSync(static_cast<GLsync>(m_Fence), 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(static_cast<GLsync>(m_Fence));
+    m_Fence = nullptr;
+    
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_ReadbackBuffer);
+    const float* data = static_cast<const float*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (2 + kHistogramBins) * sizeof(float), GL_MAP_READ_BIT));
+    if (data) {
+        m_Min = data[0];
+        m_Max = data[1];
+        m_HasRange = m_Min <= m_Max;
+        m_Histogram.assign(data + 2, data + 2 + kHistogramBins);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return data != nullptr;
+}
+
+void ContourPlot::Bind(Colormap colormap) {
+    if (static_cast<int>(colormap) != m_Colormap) {
+        std::vector<uint8_t> texels(kColormapSize * 4);
+        for (int i = 0; i < kColormapSize; ++i) {
+            glm::vec3 color = SampleColormap(colormap, static_cast<float>(i) / (kColormapSize - 1));
+            for (int c = 0; c < 3; ++c) {
+                texels[i * 4 + c] = static_cast<uint8_t>(std::lround(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f));
+            }
+            texels[i * 4 + 3] = 255;
+        }
+        if (!m_ColormapTexture) glGenTextures(1, &m_ColormapTexture);
+        glBindTexture(GL_TEXTURE_1D, m_ColormapTexture);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, kColormapSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_1D, 0);
+        m_Colormap = static_cast<int>(colormap);
+    }
+    
+    // Without values both value textures are unbound, which reads as size zero
+    const bool values = HasValues();
+    BindTexture(kElementValueUnit, GL_TEXTURE_BUFFER, values ? m_ElementTexture : 0);
+    BindTexture(kNodeValueUnit, GL_TEXTURE_BUFFER, values && m_NodeCount > 0 ? m_NodeTexture : 0);
+    BindTexture(kRangeUnit, GL_TEXTURE_2D, values && !m_Reduction.empty() ? m_Reduction.back().texture : 0);
+    BindTexture(kColormapUnit, GL_TEXTURE_1D, m_ColormapTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+glm::vec3 ContourPlot::SampleColormap(Colormap colormap, float t) {
+    static const glm::vec3 kRainbow[] = {
+        {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}
+    };
+    static const glm::vec3 kViridis[] = {
+        {0.267f, 0.005f, 0.329f}, {0.283f, 0.141f, 0.458f}, {0.254f, 0.265f, 0.530f},
+        {0.207f, 0.372f, 0.553f}, {0.164f, 0.471f, 0.558f}, {0.128f, 0.567f, 0.551f},
+        {0.135f, 0.659f, 0.518f}, {0.267f, 0.749f, 0.441f}, {0.478f, 0.821f, 0.318f},
+        {0.741f, 0.873f, 0.150f}, {0.993f, 0.906f, 0.144f}
+    };
+    static const glm::vec3 kCoolWarm[] = {
+        {0.230f, 0.299f, 0.754f}, {0.865f, 0.865f, 0.865f}, {0.706f, 0.016f, 0.150f}
+    };
+    static const glm::vec3 kGrayscale[] = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+    
+    const glm::vec3* points = kRainbow;
+    size_t count = 5;
+    switch (colormap) {
+        case Colormap::VIRIDIS: points = kViridis; count = 11; break;
+        case Colormap::COOL_WARM: points = kCoolWarm; count = 3; break;
+        case Colormap::GRAYSCALE: points = kGrayscale; count = 2; break;
+        default: break;
+    }
+    
+    // Linear between evenly spaced control points
+    const float position = glm::clamp(t, 0.0f, 1.0f) * static_cast<float>(count - 1);
+    const size_t index = std::min(static_cast<size_t>(position), count - 2);
+    return glm::mix(points[index], points[index + 1], position - static_cast<float>(index));
+}
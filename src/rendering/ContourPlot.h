@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Model;
+class Shader;
+
+// Colour scales for fringe plots
+enum class Colormap {
+    RAINBOW,     // Blue to red through cyan, green and yellow
+    VIRIDIS,
+    COOL_WARM,   // Diverging, blue through grey to red
+    GRAYSCALE
+};
+
+// Fringe plots of element scalars (von Mises, plastic strain, thickness)
+// on the GPU. A state's field is uploaded once into a buffer texture of
+// per-element values; everything after that runs as GPU passes over it:
+// averaging to nodes through the node adjacency, a min/max reduction into
+// a 1x1 texture and a histogram over that range. The shaders colour
+// through a 1D colormap texture and take the range from the reduction or
+// from uniforms, so range, bands and colormap changes never touch the
+// values, and a new state costs one upload. Range and histogram are also
+// read back behind a fence for the legend, a frame or two later.
+//
+// GL 3.3 has no compute shaders, so the passes are fragment passes into
+// float targets, like the picker's ID pass. Render thread only.
+class ContourPlot {
+public:
+    static constexpr unsigned int kElementValueUnit = 4;   // samplerBuffer, R32F
+    static constexpr unsigned int kNodeValueUnit = 5;      // samplerBuffer, R32F
+    static constexpr unsigned int kRangeUnit = 6;          // sampler2D, RG32F: min, max
+    static constexpr unsigned int kColormapUnit = 7;       // sampler1D, RGBA8
+    static constexpr int kHistogramBins = 64;
+    static constexpr int kColormapSize = 256;
+    
+    ContourPlot();
+    ~ContourPlot();
+    
+    ContourPlot(const ContourPlot&) = delete;
+    ContourPlot& operator=(const ContourPlot&) = delete;
+    
+    // Adjacency for averaging, once per model and after edits; clears the values
+    void SetModel(const Model& model);
+    void Clear();
+    
+    // Element values in the model's element order, NaN where there is
+    // none; uploads them and queues the passes and their readback
+    void SetValues(const std::vector<float>& elementValues);
+    bool HasValues() const { return m_ElementCount > 0; }
+    
+    // Whether range and histogram are of the node averages or the element
+    // values; changing it reruns the passes without an upload
+    void SetNodal(bool nodal);
+    bool IsNodal() const { return m_Nodal; }
+    
+    // Uploads the colormap when it changed and binds every texture to its unit
+    void Bind(Colormap colormap);
+    
+    // Takes a finished readback; false while none is waiting
+    bool Poll();
+    bool IsBusy() const { return m_Fence != nullptr; }
+    
+    // Last range and histogram read back; min > max when no element has a value
+    bool HasRange() const { return m_HasRange; }
+    float GetMin() const { return m_Min; }
+    float GetMax() const { return m_Max; }
+    const std::vector<float>& GetHistogram() const { return m_Histogram; }   // kHistogramBins counts
+    
+    static glm::vec3 SampleColormap(Colormap colormap, float t);   // t in [0, 1]
+
+private:
+    // Float render target of a pass
+    struct Target {
+        unsigned int framebuffer = 0;
+        unsigned int texture = 0;
+        int width = 0;
+        int height = 0;
+    };
+    
+    void EnsureShaders();
+    static void EnsureTarget(Target& target, unsigned int format, int width, int height);
+    static void DeleteTarget(Target& target);
+    static void UploadBuffer(unsigned int& buffer, unsigned int& texture, unsigned int format,
+                             const void* data, size_t bytes);
+    void AverageToNodes();
+    void Analyse();   // Range, histogram and readback of the shown values
+    void ReduceRange(unsigned int values, size_t count);
+    void BuildHistogram(unsigned int values, size_t count);
+    void StartReadback();
+
+private:
+    std::unique_ptr<Shader> m_AverageShader;
+    std::unique_ptr<Shader> m_ReduceShader;
+    std::unique_ptr<Shader> m_HistogramShader;
+    unsigned int m_EmptyVAO = 0;   // Passes draw without attributes
+    
+    // Adjacency (CSR, like NodeAdjacency) and values, as buffer textures
+    unsigned int m_OffsetBuffer = 0, m_OffsetTexture = 0;
+    unsigned int m_EntryBuffer = 0, m_EntryTexture = 0;
+    unsigned int m_ElementBuffer = 0, m_ElementTexture = 0;
+    unsigned int m_NodeBuffer = 0, m_NodeTexture = 0;
+    size_t m_NodeBufferBytes = 0;
+    size_t m_NodeCount = 0;
+    size_t m_ElementCount = 0;   // Of the values, 0 without
+    bool m_Nodal = true;
+    
+    Target m_NodeTarget;               // One texel per node, copied into m_NodeBuffer
+    std::vector<Target> m_Reduction;   // Each level 8x8 smaller; the last is 1x1
+    Target m_HistogramTarget;
+    
+    unsigned int m_ColormapTexture = 0;
+    int m_Colormap = -1;               // Uploaded, or -1
+    
+    unsigned int m_ReadbackBuffer = 0;
+    void* m_Fence = nullptr;           // GLsync of the pending readback
+    bool m_HasRange = false;
+    float m_Min = 0.0f;
+    float m_Max = 0.0f;
+    std::vector<float> m_Histogram;
+};
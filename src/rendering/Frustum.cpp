@@ -0,0 +1,49 @@
+#include "rendering/Frustum.h"
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection) {
+    // Gribb-Hartmann: each plane is the fourth row plus or minus another
+    const glm::mat4& m = viewProjection;
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r) {
+        rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+    }
+    
+    Frustum frustum;
+    frustum.m_Planes[0] = rows[3] + rows[0];   // Left
+    frustum.m_Planes[1] = rows[3] - rows[0];   // Right
+    frustum.m_Planes[2] = rows[3] + rows[1];   // Bottom
+    frustum.m_Planes[3] = rows[3] - rows[1];   // Top
+    frustum.m_Planes[4] = rows[3] + rows[2];   // Near
+    frustum.m_Planes[5] = rows[3] - rows[2];   // Far
+    for (glm::vec4& plane : frustum.m_Planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+Frustum::Containment Frustum::Classify(const glm::vec3& minBounds, const glm::vec3& maxBounds) const {
+    Containment result = Containment::INSIDE;
+    for (const glm::vec4& plane : m_Planes) {
+        glm::vec3 normal(plane);
+        
+        // Box corners furthest along and against the plane normal
+        glm::vec3 positive = minBounds;
+        glm::vec3 negative = maxBounds;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (normal[axis] >= 0.0f) {
+                positive[axis] = maxBounds[axis];
+                negative[axis] = minBounds[axis];
+            }
+        }
+        if (glm::dot(normal, positive) + plane.w < 0.0f) {
+            return Containment::OUTSIDE;
+        }
+        if (glm::dot(normal, negative) + plane.w < 0.0f) {
+            result = Containment::INTERSECTS;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes, for culling bounding boxes
+class Frustum {
+public:
+    enum class Containment {
+        OUTSIDE,
+        INTERSECTS,
+        INSIDE
+    };
+    
+    // Planes of a combined projection * view matrix
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+    
+    Containment Classify(const glm::vec3& minBounds, const glm::vec3& maxBounds) const;
+    
+private:
+    glm::vec4 m_Planes[6];   // xyz normal, w offset
+};
@@ -0,0 +1,61 @@
+#include "rendering/GpuTimer.h"
+#include "utils/Profiler.h"
+#include <GL/glew.h>
+
+GpuTimer::~GpuTimer() {
+    for (Slot& slot : m_Slots) {
+        for (unsigned int& query : slot.queries) {
+            if (query) glDeleteQueries(1, &query);
+        }
+    }
+}
+
+void GpuTimer::BeginFrame() {
+    EndFrame();
+    m_Frame = (m_Frame + 1) % kLatency;
+    Slot& slot = m_Slots[m_Frame];
+    Collect(slot);
+    m_InFrame = Profiler::IsEnabled();
+}
+
+void GpuTimer::EndFrame() {
+    End();
+    m_InFrame = false;
+}
+
+void GpuTimer::Begin(const char* name) {
+    End();
+    Slot& slot = m_Slots[m_Frame];
+    if (!m_InFrame || slot.count >= kMaxPasses) {
+        return;
+    }
+    unsigned int& query = slot.queries[slot.count];
+    if (!query) glGenQueries(1, &query);
+    slot.names[slot.count] = name;
+    slot.issued[slot.count] = Profiler::Now();
+    ++slot.count;
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    m_Open = true;
+}
+
+void GpuTimer::End() {
+    if (m_Open) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_Open = false;
+    }
+}
+
+void GpuTimer::Collect(Slot& slot) {
+    Profiler& profiler = Profiler::Get();
+    for (size_t p = 0; p < slot.count; ++p) {
+        GLint available = 0;
+        glGetQueryObjectiv(slot.queries[p], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(slot.queries[p], GL_QUERY_RESULT, &nanoseconds);
+        profiler.AddGpuTime(slot.names[p], slot.issued[p], static_cast<double>(nanoseconds) * 1e-6);
+    }
+    slot.count = 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// GL_TIME_ELAPSED queries around the passes of a frame, reported to the
+// Profiler. A frame's queries are read back kLatency frames later, by when
+// they have long finished, so reading never waits on the GPU; results
+// still not there by then are dropped. Only one elapsed-time query can
+// run at a time, so passes do not nest: Begin ends the pass before it.
+// Render thread only.
+class GpuTimer {
+public:
+    static constexpr size_t kLatency = 4;      // Frames in flight
+    static constexpr size_t kMaxPasses = 16;   // Timed per frame; later ones are not
+    
+    // Times a block as one pass
+    class Pass {
+    public:
+        Pass(GpuTimer& timer, const char* name) : m_Timer(timer) { m_Timer.Begin(name); }
+        ~Pass() { m_Timer.End(); }
+        
+        Pass(const Pass&) = delete;
+        Pass& operator=(const Pass&) = delete;
+    
+    private:
+        GpuTimer& m_Timer;
+    };
+    
+    GpuTimer() = default;
+    ~GpuTimer();
+    
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+    
+    // Reports the frame kLatency frames back and starts a new one
+    void BeginFrame();
+    void EndFrame();
+    
+    // name must outlive the profiler, as string literals do
+    void Begin(const char* name);
+    void End();
+
+private:
+    struct Slot {
+        unsigned int queries[kMaxPasses] = {};
+        const char* names[kMaxPasses] = {};
+        int64_t issued[kMaxPasses] = {};   // Profiler::Now at Begin
+        size_t count = 0;
+    };
+    
+    void Collect(Slot& slot);
+
+private:
+    Slot m_Slots[kLatency];
+    size_t m_Frame = 0;
+    bool m_InFrame = false;
+    bool m_Open = false;   // A query is running
+};
@@ -0,0 +1,140 @@
+#include "rendering/HeadlessContext.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+
+#ifdef HAS_EGL
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+HeadlessContext::~HeadlessContext() {
+    Destroy();
+}
+
+bool HeadlessContext::IsAvailable() {
+#ifdef HAS_EGL
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool HeadlessContext::Fail(const std::string& message) {
+    m_Error = message;
+    Destroy();
+    return false;
+}
+
+#ifdef HAS_EGL
+
+namespace {
+
+// A display on the first GPU, needing no window system at all
+EGLDisplay GetDeviceDisplay() {
+    auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (!queryDevices || !getPlatformDisplay) {
+        return EGL_NO_DISPLAY;
+    }
+    EGLDeviceEXT devices[8];
+    EGLint count = 0;
+    if (!queryDevices(8, devices, &count) || count == 0) {
+        return EGL_NO_DISPLAY;
+    }
+    return getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[0], nullptr);
+}
+
+} // namespace
+
+bool HeadlessContext::Create() {
+    Destroy();
+    
+    EGLDisplay display = GetDeviceDisplay();
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            return Fail("No EGL display");
+        }
+    }
+    m_Display = display;
+    
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        return Fail("No EGL config for desktop OpenGL");
+    }
+    
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE) {
+        return Fail("Cannot create an EGL pbuffer");
+    }
+    m_Surface = surface;
+    
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        return Fail("EGL has no desktop OpenGL");
+    }
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        return Fail("Cannot create an OpenGL 3.3 core context");
+    }
+    m_Context = context;
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        return Fail("Cannot make the EGL context current");
+    }
+    
+    // GLEW built for GLX loads the core entry points first and only then
+    // misses the X display, which a headless context does not need
+    glewExperimental = GL_TRUE;
+    GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY) {
+        status = GLEW_OK;
+    }
+#endif
+    if (status != GLEW_OK) {
+        return Fail("Failed to initialize GLEW");
+    }
+    
+    LOG_INFO("Headless OpenGL {} on EGL {}.{}",
+             reinterpret_cast<const char*>(glGetString(GL_VERSION)), major, minor);
+    return true;
+}
+
+void HeadlessContext::Destroy() {
+    if (!m_Display) {
+        return;
+    }
+    EGLDisplay display = static_cast<EGLDisplay>(m_Display);
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_Context) eglDestroyContext(display, static_cast<EGLContext>(m_Context));
+    if (m_Surface) eglDestroySurface(display, static_cast<EGLSurface>(m_Surface));
+    eglTerminate(display);
+    m_Display = m_Surface = m_Context = nullptr;
+}
+
+#else
+
+bool HeadlessContext::Create() {
+    return Fail("Built without EGL; configure with -DBUILD_HEADLESS=ON");
+}
+
+void HeadlessContext::Destroy() {
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+// An OpenGL 3.3 core context with no window, for rendering on GPU servers
+// without a display. Built on EGL (HAS_EGL): the first GPU through
+// EGL_EXT_platform_device when the driver offers it, the default display
+// otherwise. Drawing goes to framebuffer objects; the context's own
+// surface is a 1x1 pbuffer.
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+    
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    
+    // Creates the context, makes it current on the calling thread and
+    // initialises GLEW for it
+    bool Create();
+    void Destroy();
+    bool IsCreated() const { return m_Context != nullptr; }
+    const std::string& GetError() const { return m_Error; }
+    
+    static bool IsAvailable();   // Whether this build has EGL
+
+private:
+    bool Fail(const std::string& message);
+
+private:
+    void* m_Display = nullptr;   // EGLDisplay
+    void* m_Surface = nullptr;   // EGLSurface
+    void* m_Context = nullptr;   // EGLContext
+    std::string m_Error;
+};
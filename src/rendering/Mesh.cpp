@@ -2,113 +2,1080 @@
 #include "core/Model.h"
 #include "core/Node.h"
 #include "core/Element.h"
+#include "core/SolidSkin.h"
+#include "rendering/Frustum.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include "utils/Profiler.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+template<typename T>
+void AppendVector(std::vector<T>& target, std::vector<T>& source) {
+    if (target.empty()) {
+        target.swap(source);
+    } else {
+        target.insert(target.end(), source.begin(), source.end());
+    }
+    source.clear();
+}
+
+constexpr size_t kBuildGrainSize = 1u << 14;
+
+// Indirect draws that can carry a base instance, through which each draw
+// passes the number of its first primitive
+bool HasIndirectDraws() {
+    return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_VERSION_4_2);
+}
+
+// Appends hierarchies whose ranges start at indexBase. Indices that came
+// without chunks get one that is never culled.
+void AppendChunks(std::vector<MeshChunk>& target, const std::vector<MeshChunk>& chunks,
+                  size_t indexBase, size_t indexCount) {
+    if (chunks.empty()) {
+        if (indexCount > 0) {
+            const float infinity = std::numeric_limits<float>::infinity();
+            target.push_back({glm::vec3(-infinity), glm::vec3(infinity),
+                              static_cast<uint32_t>(indexBase), static_cast<uint32_t>(indexCount), 1});
+        }
+        return;
+    }
+    for (MeshChunk chunk : chunks) {
+        chunk.firstIndex += static_cast<uint32_t>(indexBase);
+        for (uint32_t level = 0; level < chunk.levelCount; ++level) {
+            chunk.levelFirstIndex[level] += static_cast<uint32_t>(indexBase);
+        }
+        target.push_back(chunk);
+    }
+}
+
+void OffsetIndices(std::vector<unsigned int>& indices, size_t first, size_t offset) {
+    if (offset > 0) {
+        for (size_t i = first; i < indices.size(); ++i) {
+            indices[i] += static_cast<unsigned int>(offset);
+        }
+    }
+}
+
+// Grid cells across a leaf's longest side, per coarse level, and the size
+// on screen a cell may have before a finer level is needed
+constexpr float kLevelCells[MeshChunk::kCoarseLevels] = {32.0f, 8.0f};
+constexpr float kLevelCellPixels = 2.0f;
+
+// Levels only change once the size is this far past the limit, so a
+// leaf near it does not switch back and forth while the camera moves
+constexpr float kLevelHysteresis = 1.25f;
+
+int SelectLevel(const MeshChunk& leaf, int current, const MeshView& view) {
+    if (leaf.levelCount == 0) {
+        return 0;
+    }
+    glm::vec3 center = (leaf.minBounds + leaf.maxBounds) * 0.5f;
+    float w = (view.viewProjection * glm::vec4(center, 1.0f)).w;
+    if (w <= 0.0f) {
+        return 0;
+    }
+    float pixels = glm::length(leaf.maxBounds - leaf.minBounds) * view.pixelScale / w;
+    for (int level = static_cast<int>(leaf.levelCount); level > 0; --level) {
+        float limit = level > current ? kLevelCellPixels / kLevelHysteresis
+                                      : kLevelCellPixels * kLevelHysteresis;
+        if (pixels / kLevelCells[level - 1] <= limit) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+// Vertex clustering: every vertex moves to the one of its grid cell closest
+// to the cell's mean, and primitives that collapse or repeat are dropped.
+// Primitives are rotated to start at their smallest index, which keeps
+// triangle winding. With tags, each output primitive keeps the lowest tag
+// of the input primitives it stands for.
+template<typename Positions>
+void ClusterPrimitives(const Positions& positions, size_t verticesPerPrimitive,
+                       const unsigned int* input, size_t indexCount,
+                       const glm::vec3& low, float cellSize, int cells,
+                       std::vector<unsigned int>& output,
+                       const uint32_t* inputTags = nullptr, std::vector<uint32_t>* outputTags = nullptr) {
+    auto position = [&](unsigned int index) {
+        return index < positions.size() ? positions[index] : glm::vec3(0.0f);
+    };
+    auto cellOf = [&](unsigned int index) {
+        glm::vec3 offset = (position(index) - low) / cellSize;
+        uint32_t cell = 0;
+        for (int axis = 2; axis >= 0; --axis) {
+            int coordinate = std::min(std::max(static_cast<int>(offset[axis]), 0), cells - 1);
+            cell = cell * static_cast<uint32_t>(cells) + static_cast<uint32_t>(coordinate);
+        }
+        return cell;
+    };
+    
+    // Grids are small enough to index densely; a vertex counts once per use
+    struct Cell {
+        glm::vec3 sum = glm::vec3(0.0f);
+        uint32_t count = 0;
+        float distance = std::numeric_limits<float>::max();
+        unsigned int representative = 0;
+    };
+    std::vector<Cell> grid(static_cast<size_t>(cells) * cells * cells);
+    std::vector<uint32_t> cellIndices(indexCount);
+    for (size_t k = 0; k < indexCount; ++k) {
+        cellIndices[k] = cellOf(input[k]);
+        Cell& cell = grid[cellIndices[k]];
+        cell.sum += position(input[k]);
+        ++cell.count;
+    }
+    for (size_t k = 0; k < indexCount; ++k) {
+        Cell& cell = grid[cellIndices[k]];
+        glm::vec3 delta = position(input[k]) - cell.sum / static_cast<float>(cell.count);
+        float distance = glm::dot(delta, delta);
+        if (distance < cell.distance || (distance == cell.distance && input[k] < cell.representative)) {
+            cell.distance = distance;
+            cell.representative = input[k];
+        }
+    }
+    
+    // The tag sorts last, so the first of a run of equal primitives has the lowest
+    std::vector<std::array<unsigned int, 4>> primitives;
+    primitives.reserve(indexCount / verticesPerPrimitive);
+    for (size_t p = 0; p + verticesPerPrimitive <= indexCount; p += verticesPerPrimitive) {
+        std::array<unsigned int, 4> mapped = {0, 0, 0, 0};
+        for (size_t k = 0; k < verticesPerPrimitive; ++k) {
+            mapped[k] = grid[cellIndices[p + k]].representative;
+        }
+        bool collapsed = false;
+        for (size_t a = 0; a < verticesPerPrimitive; ++a) {
+            for (size_t b = a + 1; b < verticesPerPrimitive; ++b) {
+                collapsed = collapsed || mapped[a] == mapped[b];
+            }
+        }
+        if (!collapsed) {
+            std::rotate(mapped.begin(), std::min_element(mapped.begin(), mapped.begin() + verticesPerPrimitive),
+                        mapped.begin() + verticesPerPrimitive);
+            if (verticesPerPrimitive == 2) {
+                mapped[1] = std::max(mapped[0], mapped[1]);   // Lines have no direction
+            }
+            mapped[3] = inputTags ? inputTags[p / verticesPerPrimitive] : 0;
+            primitives.push_back(mapped);
+        }
+    }
+    std::sort(primitives.begin(), primitives.end());
+    primitives.erase(std::unique(primitives.begin(), primitives.end(),
+                                 [](const std::array<unsigned int, 4>& a, const std::array<unsigned int, 4>& b) {
+                                     return std::equal(a.begin(), a.begin() + 3, b.begin());
+                                 }),
+                     primitives.end());
+    
+    output.clear();
+    output.reserve(primitives.size() * verticesPerPrimitive);
+    if (outputTags) {
+        outputTags->clear();
+        outputTags->reserve(primitives.size());
+    }
+    for (const auto& primitive : primitives) {
+        output.insert(output.end(), primitive.begin(), primitive.begin() + verticesPerPrimitive);
+        if (outputTags) {
+            outputTags->push_back(primitive[3]);
+        }
+    }
+}
+
+// Corners a shell type is triangulated from, or 0 for types without faces
+size_t FaceCorners(ElementType type) {
+    switch (type) {
+        case ElementType::SHELL3: return 3;
+        case ElementType::SHELL4: return 4;
+        default:                  return 0;
+    }
+}
+
+size_t TriangleIndexCount(ElementType type) {
+    size_t corners = FaceCorners(type);
+    return corners >= 3 ? (corners - 2) * 3 : 0;
+}
+
+// Outline of every element with at least three nodes; solids are outlined
+// by their skin instead
+size_t WireIndexCount(const ElementBlock& block) {
+    if (SolidFaceLayout::ForType(block.type)) {
+        return 0;
+    }
+    return block.nodesPerElement >= 3 ? static_cast<size_t>(block.nodesPerElement) * 2 : 0;
+}
+
+bool IsHidden(const std::vector<char>* hidden, size_t index) {
+    return hidden && index < hidden->size() && (*hidden)[index];
+}
+
+// Keeps one copy of each edge in wireIndices[first, end) and drops
+// degenerate ones. Neighbouring shells share their edges, so this about
+// halves the lines of a dense mesh. The edges are counting-sorted by their
+// lower node in parallel, the way NodeAdjacency is built, and each node's
+// short row is then sorted and deduplicated; the output is in key order.
+// Rows only span the lower nodes in use, which keeps streamed chunks cheap.
+// Element tags follow their edges; an edge shared by elements of different
+// parts belongs to none of them, so hiding either part keeps it.
+void RemoveDuplicateEdges(std::vector<unsigned int>& wireIndices, size_t first, size_t nodeCount,
+                          std::vector<uint32_t>& wireTags, const ChunkedColumn<int>& partIds) {
+    size_t edgeCount = (wireIndices.size() - first) / 2;
+    wireTags.resize(wireIndices.size() / 2, MeshData::kNoElement);
+    if (edgeCount == 0) {
+        return;
+    }
+    const size_t firstEdge = first / 2;
+    
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    auto edge = [&](size_t e, unsigned int& low, unsigned int& high) {
+        unsigned int a = wireIndices[first + e * 2];
+        unsigned int b = wireIndices[first + e * 2 + 1];
+        low = std::min(a, b);
+        high = std::max(a, b);
+        return a != b && high < nodeCount;
+    };
+    
+    std::mutex rangeMutex;
+    unsigned int lowest = std::numeric_limits<unsigned int>::max();
+    unsigned int highest = 0;
+    pool.ParallelFor(edgeCount, kBuildGrainSize, [&](size_t begin, size_t end) {
+        unsigned int low, high;
+        unsigned int rangeLow = std::numeric_limits<unsigned int>::max();
+        unsigned int rangeHigh = 0;
+        for (size_t e = begin; e < end; ++e) {
+            if (edge(e, low, high)) {
+                rangeLow = std::min(rangeLow, low);
+                rangeHigh = std::max(rangeHigh, low);
+            }
+        }
+        std::lock_guard<std::mutex> lock(rangeMutex);
+        lowest = std::min(lowest, rangeLow);
+        highest = std::max(highest, rangeHigh);
+    });
+    if (lowest > highest) {
+        wireIndices.resize(first);
+        wireTags.resize(firstEdge);
+        return;
+    }
+    const size_t rowCount = highest - lowest + 1;
+    
+    std::vector<std::atomic<size_t>> cursors(rowCount);
+    pool.ParallelFor(edgeCount, kBuildGrainSize, [&](size_t begin, size_t end) {
+        unsigned int low, high;
+        for (size_t e = begin; e < end; ++e) {
+            if (edge(e, low, high)) {
+                cursors[low - lowest].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    std::vector<size_t> offsets(rowCount + 1, 0);
+    for (size_t n = 0; n < rowCount; ++n) {
+        size_t count = cursors[n].load(std::memory_order_relaxed);
+        cursors[n].store(offsets[n], std::memory_order_relaxed);
+        offsets[n + 1] = offsets[n] + count;
+    }
+    
+    struct RowEdge {
+        unsigned int high;
+        uint32_t tag;
+        bool operator<(const RowEdge& other) const {
+            return high != other.high ? high < other.high : tag < other.tag;
+        }
+    };
+    std::vector<RowEdge> rows(offsets[rowCount]);
+    pool.ParallelFor(edgeCount, kBuildGrainSize, [&](size_t begin, size_t end) {
+        unsigned int low, high;
+        for (size_t e = begin; e < end; ++e) {
+            if (edge(e, low, high)) {
+                rows[cursors[low - lowest].fetch_add(1, std::memory_order_relaxed)] =
+                    {high, wireTags[firstEdge + e]};
+            }
+        }
+    });
+    auto partOf = [&](uint32_t element) {
+        return element < partIds.size() ? partIds[element] : std::numeric_limits<int>::min();
+    };
+    
+    // Rows shrink in place; each range counts what it keeps, then the
+    // ranges are written out in node order
+    std::vector<size_t> kept(rowCount, 0);
+    pool.ParallelFor(rowCount, kBuildGrainSize, [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) {
+            auto rowBegin = rows.begin() + offsets[n];
+            auto rowEnd = rows.begin() + offsets[n + 1];
+            std::sort(rowBegin, rowEnd);
+            auto write = rowBegin;
+            for (auto read = rowBegin; read != rowEnd; ++read) {
+                if (write != rowBegin && (write - 1)->high == read->high) {
+                    if ((write - 1)->tag != read->tag && partOf((write - 1)->tag) != partOf(read->tag)) {
+                        (write - 1)->tag = MeshData::kNoElement;
+                    }
+                } else {
+                    *write++ = *read;
+                }
+            }
+            kept[n] = static_cast<size_t>(write - rowBegin);
+        }
+    });
+    
+    size_t write = first;
+    for (size_t n = 0; n < rowCount; ++n) {
+        for (size_t k = 0; k < kept[n]; ++k) {
+            wireTags[write / 2] = rows[offsets[n] + k].tag;
+            wireIndices[write++] = static_cast<unsigned int>(lowest + n);
+            wireIndices[write++] = rows[offsets[n] + k].high;
+        }
+    }
+    wireIndices.resize(write);
+    wireTags.resize(write / 2);
+}
+
+// Where each block's part of an element range goes in the index arrays
+struct BlockOutput {
+    const ElementBlock* block;
+    size_t first;        // First element of the block in the range
+    size_t last;
+    size_t triangleOffset;
+    size_t wireOffset;
+};
+
+} // namespace
+
+void MeshData::Append(MeshData&& other) {
+    AppendChunks(triangleChunks, other.triangleChunks, indices.size(), other.indices.size());
+    AppendChunks(wireChunks, other.wireChunks, wireIndices.size(), other.wireIndices.size());
+    AppendChunks(nodeChunks, other.nodeChunks, nodeIndices.size(), other.nodeIndices.size());
+    other.triangleChunks.clear();
+    other.wireChunks.clear();
+    other.nodeChunks.clear();
+    
+    // Points are numbered within their own data; other's nodes follow ours
+    OffsetIndices(other.nodeIndices, 0, nodePositions.size());
+    AppendVector(nodePositions, other.nodePositions);
+    AppendVector(vertices, other.vertices);
+    
+    // Element tags stay aligned with their primitives
+    triangleElements.resize(indices.size() / 3, kNoElement);
+    other.triangleElements.resize(other.indices.size() / 3, kNoElement);
+    AppendVector(triangleElements, other.triangleElements);
+    wireElements.resize(wireIndices.size() / 2, kNoElement);
+    other.wireElements.resize(other.wireIndices.size() / 2, kNoElement);
+    AppendVector(wireElements, other.wireElements);
+    AppendVector(indices, other.indices);
+    AppendVector(wireIndices, other.wireIndices);
+    AppendVector(nodeIndices, other.nodeIndices);
+}
+
+void MeshData::Clear() {
+    nodePositions.clear();
+    vertices.clear();
+    indices.clear();
+    wireIndices.clear();
+    nodeIndices.clear();
+    triangleElements.clear();
+    wireElements.clear();
+    triangleChunks.clear();
+    wireChunks.clear();
+    nodeChunks.clear();
+}
+
+bool MeshData::Empty() const {
+    return nodePositions.empty() && vertices.empty() && indices.empty() && wireIndices.empty();
+}
+
+size_t MeshData::GetByteSize() const {
+    return nodePositions.size() * sizeof(glm::vec3) + vertices.size() * sizeof(Vertex) +
+           (indices.size() + wireIndices.size() + nodeIndices.size()) * sizeof(unsigned int) +
+           (triangleElements.size() + wireElements.size()) * sizeof(uint32_t);
+}
 
 Mesh::Mesh() 
-    : m_VAO(0), m_VBO(0), m_EBO(0),
-      m_WireVAO(0), m_WireVBO(0), m_WireEBO(0),
-      m_NodeVAO(0), m_NodeVBO(0),
-      m_IsSetup(false) {
+    : m_PendingOffsets{0, 0, 0, 0, 0, 0, 0},
+      m_QueuedNodes(0), m_TriangleElementTexture(0), m_WireElementTexture(0),
+      m_IndirectBuffer(0), m_DrawBaseBuffer(0),
+      m_VAO(0), m_WireVAO(0), m_NodeVAO(0),
+      m_DisplacementBuffer(0), m_DisplacementOffset(0),
+      m_Layout(MeshLayout::SHARED_NODES),
+      m_LayoutDirty(false) {
+    m_NodeBuffer.target = GL_ARRAY_BUFFER;
+    m_VertexBuffer.target = GL_ARRAY_BUFFER;
+    m_IndexBuffer.target = GL_ELEMENT_ARRAY_BUFFER;
+    m_WireIndexBuffer.target = GL_ELEMENT_ARRAY_BUFFER;
+    m_NodeIndexBuffer.target = GL_ELEMENT_ARRAY_BUFFER;
+    m_TriangleElementBuffer.target = GL_TEXTURE_BUFFER;
+    m_WireElementBuffer.target = GL_TEXTURE_BUFFER;
 }
 
 Mesh::~Mesh() {
     Clear();
 }
 
-void Mesh::BuildFromModel(Model* model) {
+void Mesh::BuildFromModel(Model* model, MeshLayout layout, const SolidSkin* skin) {
     if (!model) return;
+    PROFILE_SCOPE("Mesh::BuildFromModel");
     
     Clear();
     
-    // Collect node positions
-    for (const auto& node : model->GetNodes()) {
-        m_NodePositions.push_back(node.position);
+    SolidSkin ownSkin;
+    if (!skin) {
+        ownSkin.Build(*model);
+        skin = &ownSkin;
+    }
+    const std::vector<char>* hidden = skin->GetHiddenMask().empty() ? nullptr : &skin->GetHiddenMask();
+    
+    MeshData data;
+    AppendNodes(*model, data);
+    AppendElements(*model, 0, model->GetElementCount(), 0, data, layout, hidden);
+    if (layout == MeshLayout::SHARED_NODES) {
+        AppendSkin(*model, *skin, data);
+    }
+    
+    Append(std::move(data));
+    ContinueUpload(std::numeric_limits<size_t>::max());
+}
+
+void Mesh::AppendNodes(const Model& model, MeshData& data) {
+    const auto& positions = model.GetNodePositions();
+    size_t firstNode = data.nodePositions.size();
+    size_t firstIndex = data.nodeIndices.size();
+    data.nodePositions.insert(data.nodePositions.end(), positions.begin(), positions.end());
+    
+    // Points are drawn through indices so they can be chunked like the rest
+    data.nodeIndices.resize(firstIndex + positions.size());
+    for (size_t n = 0; n < positions.size(); ++n) {
+        data.nodeIndices[firstIndex + n] = static_cast<unsigned int>(firstNode + n);
     }
+    BuildChunks(data.nodePositions, 1, data.nodeIndices, firstIndex, data.nodeChunks);
+}
+
+void Mesh::AppendElements(const Model& model, size_t first, size_t count,
+                          unsigned int vertexBase, MeshData& data, MeshLayout layout,
+                          const std::vector<char>* hidden) {
+    size_t last = std::min(model.GetElementCount(), first + count);
+    data.layout = layout;
+    if (layout == MeshLayout::SHARED_NODES) {
+        AppendSharedElements(model, first, last, hidden, data);
+        return;
+    }
+    
+    const auto& nodePositions = model.GetNodePositions();
+    data.triangleElements.resize(data.indices.size() / 3, MeshData::kNoElement);
+    data.wireElements.resize(data.wireIndices.size() / 2, MeshData::kNoElement);
     
-    // Build mesh from elements
-    for (const auto& element : model->GetElements()) {
-        std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> positions;
+    model.ForEachElement(first, last, [&](size_t i, const ElementView& element) {
+        if (IsHidden(hidden, i)) {
+            return;
+        }
+        positions.clear();
         
-        // Get positions for this element
-        for (int nodeId : element.nodeIds) {
-            Node* node = model->GetNode(nodeId);
-            if (node) {
-                positions.push_back(node->position);
+        // Get positions for this element, by index once the model resolved them
+        if (element.nodeIndices) {
+            for (size_t k = 0; k < element.nodeIds.size(); ++k) {
+                if (element.nodeIndices[k] != ElementArrays::kMissingNode) {
+                    positions.push_back(nodePositions[element.nodeIndices[k]]);
+                }
+            }
+        } else {
+            for (int nodeId : element.nodeIds) {
+                const glm::vec3* position = model.FindNodePosition(nodeId);
+                if (position) {
+                    positions.push_back(*position);
+                }
             }
         }
         
         if (positions.size() >= 3) {
             // Calculate normal for the face
-            glm::vec3 normal = CalculateNormal(positions[0], positions[1], positions[2]);
+            glm::vec3 normal = CalculateNormal(positions);
             
             // Add vertices
-            unsigned int baseIndex = m_Vertices.size();
+            unsigned int baseIndex = vertexBase + static_cast<unsigned int>(data.vertices.size());
             for (const auto& pos : positions) {
                 Vertex vertex;
                 vertex.position = pos;
                 vertex.normal = normal;
                 vertex.texCoords = glm::vec2(0.0f, 0.0f);
-                m_Vertices.push_back(vertex);
+                data.vertices.push_back(vertex);
             }
             
             // Add indices for triangulation
             if (element.type == ElementType::SHELL3) {
-                m_Indices.push_back(baseIndex);
-                m_Indices.push_back(baseIndex + 1);
-                m_Indices.push_back(baseIndex + 2);
+                data.indices.push_back(baseIndex);
+                data.indices.push_back(baseIndex + 1);
+                data.indices.push_back(baseIndex + 2);
+                data.triangleElements.push_back(static_cast<uint32_t>(i));
             } else if (element.type == ElementType::SHELL4) {
                 // Triangulate quad
-                m_Indices.push_back(baseIndex);
-                m_Indices.push_back(baseIndex + 1);
-                m_Indices.push_back(baseIndex + 2);
-                m_Indices.push_back(baseIndex);
-                m_Indices.push_back(baseIndex + 2);
-                m_Indices.push_back(baseIndex + 3);
+                data.indices.push_back(baseIndex);
+                data.indices.push_back(baseIndex + 1);
+                data.indices.push_back(baseIndex + 2);
+                data.indices.push_back(baseIndex);
+                data.indices.push_back(baseIndex + 2);
+                data.indices.push_back(baseIndex + 3);
+                data.triangleElements.insert(data.triangleElements.end(), 2, static_cast<uint32_t>(i));
             }
             
             // Add wireframe indices
-            for (size_t i = 0; i < positions.size(); ++i) {
-                m_WireIndices.push_back(baseIndex + i);
-                m_WireIndices.push_back(baseIndex + ((i + 1) % positions.size()));
+            for (size_t k = 0; k < positions.size(); ++k) {
+                data.wireIndices.push_back(baseIndex + k);
+                data.wireIndices.push_back(baseIndex + ((k + 1) % positions.size()));
+            }
+            data.wireElements.insert(data.wireElements.end(), positions.size(), static_cast<uint32_t>(i));
+        }
+    });
+}
+
+void Mesh::AppendSharedElements(const Model& model, size_t first, size_t last,
+                                const std::vector<char>* hidden, MeshData& data) {
+    if (first >= last) {
+        return;
+    }
+    
+    // Every element of a block writes the same number of indices, so the
+    // outputs are sized up front and ranges fill them independently
+    const ElementArrays& elements = model.GetElementArrays();
+    std::vector<BlockOutput> outputs;
+    size_t triangleCount = data.indices.size();
+    size_t wireCount = data.wireIndices.size();
+    for (size_t b = elements.FindBlock(first);
+         b < elements.blocks.size() && elements.blocks[b].firstElement < last; ++b) {
+        const ElementBlock& block = elements.blocks[b];
+        BlockOutput output{&block, std::max(first, block.firstElement),
+                           std::min(last, block.EndElement()), triangleCount, wireCount};
+        size_t elementCount = output.last - output.first;
+        triangleCount += elementCount * TriangleIndexCount(block.type);
+        wireCount += elementCount * WireIndexCount(block);
+        outputs.push_back(output);
+    }
+    data.indices.resize(triangleCount);
+    data.wireIndices.resize(wireCount);
+    data.triangleElements.resize(triangleCount / 3, MeshData::kNoElement);
+    data.wireElements.resize(wireCount / 2, MeshData::kNoElement);
+    
+    const bool resolved = elements.HasNodeIndices();
+    ThreadPool::GetGlobal().ParallelFor(last - first, kBuildGrainSize, [&](size_t begin, size_t end) {
+        begin += first;
+        end += first;
+        std::vector<unsigned int> corners;
+        for (const BlockOutput& output : outputs) {
+            if (output.last <= begin || output.first >= end) {
+                continue;
+            }
+            const ElementBlock& block = *output.block;
+            const size_t stride = static_cast<size_t>(block.nodesPerElement);
+            const size_t faceCorners = FaceCorners(block.type);
+            const size_t triangleStride = TriangleIndexCount(block.type);
+            const size_t wireStride = WireIndexCount(block);
+            if (triangleStride == 0 && wireStride == 0) {
+                continue;
+            }
+            
+            for (size_t i = std::max(begin, output.first); i < std::min(end, output.last); ++i) {
+                // Defined nodes only, as in the per-element layout; none
+                // for hidden elements
+                size_t offset = block.firstNodeId + (i - block.firstElement) * stride;
+                size_t used = IsHidden(hidden, i) ? 0 : stride;
+                const int* nodeIds = resolved ? nullptr : elements.GetNodeIdData(i, offset);
+                corners.clear();
+                for (size_t k = 0; k < used; ++k) {
+                    size_t index = resolved ? elements.nodeIndices[offset + k]
+                                            : model.FindNodeIndex(nodeIds[k]);
+                    if (index != ElementArrays::kMissingNode && index != Model::kInvalidIndex) {
+                        corners.push_back(static_cast<unsigned int>(index));
+                    }
+                }
+                
+                // Hidden elements and those missing nodes get degenerate
+                // primitives, which draw nothing and keep the layout fixed
+                unsigned int fallback = corners.empty() ? 0 : corners[0];
+                unsigned int* triangles = data.indices.data() + output.triangleOffset +
+                                          (i - output.first) * triangleStride;
+                if (faceCorners > 0 && corners.size() >= faceCorners) {
+                    for (size_t t = 0; t + 2 < faceCorners; ++t) {
+                        triangles[t * 3] = corners[0];
+                        triangles[t * 3 + 1] = corners[t + 1];
+                        triangles[t * 3 + 2] = corners[t + 2];
+                    }
+                } else {
+                    std::fill(triangles, triangles + triangleStride, fallback);
+                }
+                std::fill_n(data.triangleElements.data() +
+                                (output.triangleOffset + (i - output.first) * triangleStride) / 3,
+                            triangleStride / 3, static_cast<uint32_t>(i));
+                
+                unsigned int* wires = data.wireIndices.data() + output.wireOffset +
+                                      (i - output.first) * wireStride;
+                size_t written = 0;
+                if (wireStride > 0 && corners.size() >= 3) {
+                    for (size_t k = 0; k < corners.size(); ++k) {
+                        wires[written++] = corners[k];
+                        wires[written++] = corners[(k + 1) % corners.size()];
+                    }
+                }
+                std::fill(wires + written, wires + wireStride, fallback);
+                std::fill_n(data.wireElements.data() +
+                                (output.wireOffset + (i - output.first) * wireStride) / 2,
+                            wireStride / 2, static_cast<uint32_t>(i));
             }
         }
+    });
+    
+    RemoveDuplicateEdges(data.wireIndices, outputs.front().wireOffset, model.GetNodeCount(),
+                         data.wireElements, elements.propertyIds);
+    BuildChunks(model.GetNodePositions(), 3, data.indices, outputs.front().triangleOffset,
+                data.triangleChunks, &data.triangleElements);
+    BuildChunks(model.GetNodePositions(), 2, data.wireIndices, outputs.front().wireOffset,
+                data.wireChunks, &data.wireElements);
+}
+
+void Mesh::AppendSkin(const Model& model, const SolidSkin& skin, MeshData& data) {
+    const std::vector<SkinFace>& faces = skin.GetFaces();
+    if (faces.empty()) {
+        return;
     }
+    data.layout = MeshLayout::SHARED_NODES;
     
-    SetupBuffers();
+    // Offsets from the corner counts, then an independent fill per range
+    std::vector<size_t> triangleOffsets(faces.size() + 1);
+    std::vector<size_t> wireOffsets(faces.size() + 1);
+    triangleOffsets[0] = data.indices.size();
+    wireOffsets[0] = data.wireIndices.size();
+    for (size_t f = 0; f < faces.size(); ++f) {
+        triangleOffsets[f + 1] = triangleOffsets[f] + (faces[f].corners - 2) * 3;
+        wireOffsets[f + 1] = wireOffsets[f] + faces[f].corners * 2;
+    }
+    data.indices.resize(triangleOffsets.back());
+    data.wireIndices.resize(wireOffsets.back());
+    data.triangleElements.resize(triangleOffsets.back() / 3, MeshData::kNoElement);
+    data.wireElements.resize(wireOffsets.back() / 2, MeshData::kNoElement);
+    
+    ThreadPool::GetGlobal().ParallelFor(faces.size(), kBuildGrainSize, [&](size_t begin, size_t end) {
+        uint32_t nodes[4];
+        for (size_t f = begin; f < end; ++f) {
+            int corners = SolidSkin::GetFaceNodes(model, faces[f], nodes);
+            if (corners != faces[f].corners) {
+                // Corners that repeat out of order; draw nothing
+                corners = 0;
+                nodes[0] = 0;
+            }
+            
+            unsigned int* triangles = data.indices.data() + triangleOffsets[f];
+            unsigned int* trianglesEnd = data.indices.data() + triangleOffsets[f + 1];
+            for (int t = 0; t + 2 < corners; ++t) {
+                *triangles++ = nodes[0];
+                *triangles++ = nodes[t + 1];
+                *triangles++ = nodes[t + 2];
+            }
+            std::fill(triangles, trianglesEnd, nodes[0]);
+            std::fill(data.triangleElements.data() + triangleOffsets[f] / 3,
+                      data.triangleElements.data() + triangleOffsets[f + 1] / 3, faces[f].element);
+            
+            unsigned int* wires = data.wireIndices.data() + wireOffsets[f];
+            unsigned int* wiresEnd = data.wireIndices.data() + wireOffsets[f + 1];
+            for (int k = 0; k < corners; ++k) {
+                *wires++ = nodes[k];
+                *wires++ = nodes[(k + 1) % corners];
+            }
+            std::fill(wires, wiresEnd, nodes[0]);
+            std::fill(data.wireElements.data() + wireOffsets[f] / 2,
+                      data.wireElements.data() + wireOffsets[f + 1] / 2, faces[f].element);
+        }
+    });
+    
+    // Neighbouring exterior faces share their edges too
+    RemoveDuplicateEdges(data.wireIndices, wireOffsets[0], model.GetNodeCount(), data.wireElements,
+                         model.GetElementArrays().propertyIds);
+    const size_t firstChunk = data.triangleChunks.size();
+    BuildChunks(model.GetNodePositions(), 3, data.indices, triangleOffsets[0], data.triangleChunks,
+                &data.triangleElements);
+    for (size_t c = firstChunk; c < data.triangleChunks.size(); ++c) {
+        data.triangleChunks[c].closed = true;
+    }
+    BuildChunks(model.GetNodePositions(), 2, data.wireIndices, wireOffsets[0], data.wireChunks,
+                &data.wireElements);
 }
 
-void Mesh::SetupBuffers() {
-    if (m_IsSetup) Clear();
+template<typename Positions>
+void Mesh::BuildChunks(const Positions& positions, size_t verticesPerPrimitive,
+                       std::vector<unsigned int>& indices, size_t first,
+                       std::vector<MeshChunk>& chunks, std::vector<uint32_t>* primitiveTags) {
+    const size_t primitiveCount = (indices.size() - first) / verticesPerPrimitive;
+    if (primitiveCount == 0) {
+        return;
+    }
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    
+    auto position = [&](unsigned int index) {
+        return index < positions.size() ? positions[index] : glm::vec3(0.0f);
+    };
+    
+    // Centres travel with their primitive numbers so the splits below
+    // read memory in order
+    struct Centre {
+        glm::vec3 position;
+        uint32_t primitive;
+    };
+    std::vector<Centre> order(primitiveCount > kChunkPrimitives ? primitiveCount : 0);
+    pool.ParallelFor(order.size(), kBuildGrainSize, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            glm::vec3 sum(0.0f);
+            for (size_t k = 0; k < verticesPerPrimitive; ++k) {
+                sum += position(indices[first + p * verticesPerPrimitive + k]);
+            }
+            order[p] = {sum / static_cast<float>(verticesPerPrimitive), static_cast<uint32_t>(p)};
+        }
+    });
+    
+    // Median splits on the longest axis of the centres, depth first, so
+    // the nodes come out in preorder and every subtree is one range
+    const size_t base = chunks.size();
+    std::vector<size_t> leaves;
+    std::function<void(size_t, size_t)> split = [&](size_t begin, size_t end) {
+        size_t node = chunks.size();
+        chunks.push_back({glm::vec3(0.0f), glm::vec3(0.0f),
+                          static_cast<uint32_t>(first + begin * verticesPerPrimitive),
+                          static_cast<uint32_t>((end - begin) * verticesPerPrimitive), 1});
+        if (end - begin <= kChunkPrimitives) {
+            leaves.push_back(node);
+            return;
+        }
+        
+        glm::vec3 low(std::numeric_limits<float>::max());
+        glm::vec3 high(-std::numeric_limits<float>::max());
+        for (size_t p = begin; p < end; ++p) {
+            low = glm::min(low, order[p].position);
+            high = glm::max(high, order[p].position);
+        }
+        glm::vec3 extent = high - low;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                         [axis](const Centre& a, const Centre& b) {
+                             return a.position[axis] < b.position[axis];
+                         });
+        split(begin, middle);
+        split(middle, end);
+        chunks[node].skip = static_cast<uint32_t>(chunks.size() - node);
+    };
+    split(0, primitiveCount);
+    
+    // The chunks' ranges assume the primitives are in that order; a single
+    // chunk keeps the order it was built in
+    const size_t firstPrimitive = first / verticesPerPrimitive;
+    if (!order.empty()) {
+        std::vector<unsigned int> sorted(primitiveCount * verticesPerPrimitive);
+        std::vector<uint32_t> sortedTags(primitiveTags ? primitiveCount : 0);
+        pool.ParallelFor(primitiveCount, kBuildGrainSize, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; ++p) {
+                std::copy_n(indices.data() + first + order[p].primitive * verticesPerPrimitive,
+                            verticesPerPrimitive, sorted.data() + p * verticesPerPrimitive);
+                if (primitiveTags) {
+                    sortedTags[p] = (*primitiveTags)[firstPrimitive + order[p].primitive];
+                }
+            }
+        });
+        std::copy(sorted.begin(), sorted.end(), indices.begin() + first);
+        if (primitiveTags) {
+            std::copy(sortedTags.begin(), sortedTags.end(), primitiveTags->begin() + firstPrimitive);
+        }
+    }
+    
+    // Leaves are bounded by their vertices, and every other node by its
+    // children, which follow it in the array
+    pool.ParallelFor(leaves.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t l = begin; l < end; ++l) {
+            MeshChunk& chunk = chunks[leaves[l]];
+            glm::vec3 low(std::numeric_limits<float>::max());
+            glm::vec3 high(-std::numeric_limits<float>::max());
+            for (size_t k = chunk.firstIndex; k < chunk.firstIndex + chunk.indexCount; ++k) {
+                low = glm::min(low, position(indices[k]));
+                high = glm::max(high, position(indices[k]));
+            }
+            chunk.minBounds = low;
+            chunk.maxBounds = high;
+        }
+    });
+    for (size_t node = chunks.size(); node-- > base;) {
+        MeshChunk& chunk = chunks[node];
+        if (chunk.skip > 1) {
+            const MeshChunk& left = chunks[node + 1];
+            const MeshChunk& right = chunks[node + 1 + left.skip];
+            chunk.minBounds = glm::min(left.minBounds, right.minBounds);
+            chunk.maxBounds = glm::max(left.maxBounds, right.maxBounds);
+        }
+    }
+    if (primitiveTags) {
+        primitiveTags->resize(indices.size() / verticesPerPrimitive, MeshData::kNoElement);
+    }
+    BuildCoarseLevels(positions, verticesPerPrimitive, indices, chunks, base, primitiveTags);
+    LOG_DEBUG("Mesh chunks: {} primitives in {} nodes", primitiveCount, chunks.size() - base);
+}
+
+template<typename Positions>
+void Mesh::BuildCoarseLevels(const Positions& positions, size_t verticesPerPrimitive,
+                             std::vector<unsigned int>& indices, std::vector<MeshChunk>& chunks,
+                             size_t firstChunk, std::vector<uint32_t>* primitiveTags) {
+    std::vector<size_t> leaves;
+    for (size_t node = firstChunk; node < chunks.size(); ++node) {
+        if (chunks[node].skip == 1) {
+            leaves.push_back(node);
+        }
+    }
+    
+    // Each level clusters the one before it. A level stops the chain when
+    // it keeps more than half of its input, as it would save little.
+    std::vector<std::vector<unsigned int>> levels(leaves.size() * MeshChunk::kCoarseLevels);
+    std::vector<std::vector<uint32_t>> levelTags(primitiveTags ? levels.size() : 0);
+    ThreadPool::GetGlobal().ParallelFor(leaves.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t l = begin; l < end; ++l) {
+            MeshChunk& leaf = chunks[leaves[l]];
+            glm::vec3 extent = leaf.maxBounds - leaf.minBounds;
+            float side = std::max(extent.x, std::max(extent.y, extent.z));
+            if (!(side > 0.0f) || !std::isfinite(side)) {
+                continue;
+            }
+            const unsigned int* input = indices.data() + leaf.firstIndex;
+            const uint32_t* inputTags = primitiveTags
+                ? primitiveTags->data() + leaf.firstIndex / verticesPerPrimitive : nullptr;
+            size_t inputCount = leaf.indexCount;
+            for (int level = 0; level < MeshChunk::kCoarseLevels; ++level) {
+                const size_t slot = l * MeshChunk::kCoarseLevels + level;
+                std::vector<unsigned int>& output = levels[slot];
+                std::vector<uint32_t>* outputTags = primitiveTags ? &levelTags[slot] : nullptr;
+                int cells = static_cast<int>(kLevelCells[level]);
+                ClusterPrimitives(positions, verticesPerPrimitive, input, inputCount,
+                                  leaf.minBounds, side / kLevelCells[level], cells, output,
+                                  inputTags, outputTags);
+                if (output.size() * 2 > inputCount) {
+                    output.clear();
+                    break;
+                }
+                leaf.levelCount = static_cast<uint32_t>(level + 1);
+                input = output.data();
+                inputTags = outputTags ? outputTags->data() : nullptr;
+                inputCount = output.size();
+            }
+        }
+    });
+    
+    // Level by level, so neighbouring leaves' coarse ranges can merge too
+    for (int level = 0; level < MeshChunk::kCoarseLevels; ++level) {
+        for (size_t l = 0; l < leaves.size(); ++l) {
+            MeshChunk& leaf = chunks[leaves[l]];
+            if (static_cast<uint32_t>(level) < leaf.levelCount) {
+                const std::vector<unsigned int>& output = levels[l * MeshChunk::kCoarseLevels + level];
+                leaf.levelFirstIndex[level] = static_cast<uint32_t>(indices.size());
+                leaf.levelIndexCount[level] = static_cast<uint32_t>(output.size());
+                indices.insert(indices.end(), output.begin(), output.end());
+                if (primitiveTags) {
+                    const std::vector<uint32_t>& tags = levelTags[l * MeshChunk::kCoarseLevels + level];
+                    primitiveTags->insert(primitiveTags->end(), tags.begin(), tags.end());
+                }
+            }
+        }
+    }
+}
+
+void Mesh::Append(MeshData&& data) {
+    if (data.Empty()) {
+        return;
+    }
+    // Node-only data fits either layout; element data decides it
+    bool hasElements = !data.indices.empty() || !data.wireIndices.empty();
+    if (hasElements && data.layout != m_Layout) {
+        m_Layout = data.layout;
+        m_LayoutDirty = true;
+    }
+    
+    OffsetIndices(data.nodeIndices, 0, m_QueuedNodes);
+    m_QueuedNodes += data.nodePositions.size();
+    
+    // Element tags go to the GPU with their primitives; the triangles' are
+    // also kept here to resolve picks, and their indices for normals
+    m_TriangleElements.resize(m_TriangleChunks.queued / 3, MeshData::kNoElement);
+    m_TriangleIndices.resize(m_TriangleChunks.queued, 0);
+    m_TriangleIndices.insert(m_TriangleIndices.end(), data.indices.begin(), data.indices.end());
+    data.triangleElements.resize(data.indices.size() / 3, MeshData::kNoElement);
+    data.wireElements.resize(data.wireIndices.size() / 2, MeshData::kNoElement);
+    m_TriangleElements.insert(m_TriangleElements.end(), data.triangleElements.begin(),
+                              data.triangleElements.end());
+    QueueChunks(m_TriangleChunks, data.triangleChunks, data.indices.size());
+    QueueChunks(m_WireChunks, data.wireChunks, data.wireIndices.size());
+    QueueChunks(m_NodeChunks, data.nodeChunks, data.nodeIndices.size());
+    m_Pending.push_back(std::move(data));
+}
+
+void Mesh::QueueChunks(ChunkList& list, std::vector<MeshChunk>& chunks, size_t indexCount) {
+    AppendChunks(list.chunks, chunks, list.queued, indexCount);
+    list.levels.resize(list.chunks.size(), 0);
+    list.queued += indexCount;
+    chunks.clear();
+}
+
+void Mesh::ContinueUpload(size_t byteBudget) {
+    while (!m_Pending.empty() && byteBudget > 0) {
+        MeshData& data = m_Pending.front();
+        
+        // Vertices go before the indices that reference them
+        byteBudget -= UploadRange(m_NodeBuffer, data.nodePositions.data(),
+                                  data.nodePositions.size() * sizeof(glm::vec3),
+                                  m_PendingOffsets[0], byteBudget);
+        byteBudget -= UploadRange(m_VertexBuffer, data.vertices.data(),
+                                  data.vertices.size() * sizeof(Vertex),
+                                  m_PendingOffsets[1], byteBudget);
+        byteBudget -= UploadRange(m_IndexBuffer, data.indices.data(),
+                                  data.indices.size() * sizeof(unsigned int),
+                                  m_PendingOffsets[2], byteBudget);
+        byteBudget -= UploadRange(m_TriangleElementBuffer, data.triangleElements.data(),
+                                  data.triangleElements.size() * sizeof(uint32_t),
+                                  m_PendingOffsets[3], byteBudget);
+        byteBudget -= UploadRange(m_WireIndexBuffer, data.wireIndices.data(),
+                                  data.wireIndices.size() * sizeof(unsigned int),
+                                  m_PendingOffsets[4], byteBudget);
+        byteBudget -= UploadRange(m_WireElementBuffer, data.wireElements.data(),
+                                  data.wireElements.size() * sizeof(uint32_t),
+                                  m_PendingOffsets[5], byteBudget);
+        byteBudget -= UploadRange(m_NodeIndexBuffer, data.nodeIndices.data(),
+                                  data.nodeIndices.size() * sizeof(unsigned int),
+                                  m_PendingOffsets[6], byteBudget);
+        
+        if (m_PendingOffsets[6] == data.nodeIndices.size() * sizeof(unsigned int)) {
+            m_Pending.pop_front();
+            std::fill(std::begin(m_PendingOffsets), std::end(m_PendingOffsets), 0);
+        }
+    }
+    
+    if (m_LayoutDirty) {
+        SetupVertexArrays();
+    }
+}
+
+size_t Mesh::UploadRange(StreamBuffer& buffer, const void* data, size_t totalBytes,
+                         size_t& offset, size_t budget) {
+    size_t bytes = std::min(totalBytes - offset, budget);
+    if (bytes == 0) return 0;
+    
+    // Grow geometrically, copying what is already on the GPU
+    if (buffer.used + bytes > buffer.capacity) {
+        size_t capacity = std::max(buffer.used + bytes, buffer.capacity * 2);
+        
+        GLuint grown = 0;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+        
+        if (buffer.id) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, buffer.used);
+            glDeleteBuffers(1, &buffer.id);
+        }
+        
+        buffer.id = grown;
+        buffer.capacity = capacity;
+        m_LayoutDirty = true;
+    }
+    
+    // Upload through the copy target so no VAO's element binding is touched
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, buffer.used, bytes,
+                    static_cast<const char*>(data) + offset);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    
+    buffer.used += bytes;
+    offset += bytes;
+    return bytes;
+}
+
+void Mesh::SetupVertexArrays() {
+    // Element tags are read through buffer textures, which follow their
+    // buffers as they grow
+    for (auto [buffer, texture] : {std::make_pair(&m_TriangleElementBuffer, &m_TriangleElementTexture),
+                                   std::make_pair(&m_WireElementBuffer, &m_WireElementTexture)}) {
+        if (buffer->id) {
+            if (!*texture) glGenTextures(1, texture);
+            glBindTexture(GL_TEXTURE_BUFFER, *texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, buffer->id);
+        }
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    
+    // Each draw's first primitive number, one per instance: indirect draws
+    // select it through their base instance, others set it as a constant
+    auto setupPrimitiveBase = [this]() {
+        if (HasIndirectDraws()) {
+            if (!m_DrawBaseBuffer) glGenBuffers(1, &m_DrawBaseBuffer);
+            glBindBuffer(GL_ARRAY_BUFFER, m_DrawBaseBuffer);
+            glVertexAttribIPointer(kPrimitiveBaseAttribute, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+            glVertexAttribDivisor(kPrimitiveBaseAttribute, 1);
+            glEnableVertexAttribArray(kPrimitiveBaseAttribute);
+        } else {
+            glDisableVertexAttribArray(kPrimitiveBaseAttribute);
+        }
+    };
     
     // Setup node VAO
-    if (!m_NodePositions.empty()) {
-        glGenVertexArrays(1, &m_NodeVAO);
-        glGenBuffers(1, &m_NodeVBO);
+    if (m_NodeBuffer.id) {
+        if (!m_NodeVAO) glGenVertexArrays(1, &m_NodeVAO);
         
         glBindVertexArray(m_NodeVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, m_NodeVBO);
-        glBufferData(GL_ARRAY_BUFFER, m_NodePositions.size() * sizeof(glm::vec3),
-                     m_NodePositions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, m_NodeBuffer.id);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_NodeIndexBuffer.id);
         
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
         glEnableVertexAttribArray(0);
     }
     
-    // Setup solid mesh VAO
-    if (!m_Vertices.empty() && !m_Indices.empty()) {
-        glGenVertexArrays(1, &m_VAO);
-        glGenBuffers(1, &m_VBO);
-        glGenBuffers(1, &m_EBO);
+    // Shared-node meshes draw both passes from the node buffer; without a
+    // normal attribute the solid shader computes flat normals itself
+    if (m_Layout == MeshLayout::SHARED_NODES) {
+        if (m_NodeBuffer.id && m_IndexBuffer.id) {
+            if (!m_VAO) glGenVertexArrays(1, &m_VAO);
+            
+            glBindVertexArray(m_VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, m_NodeBuffer.id);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer.id);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+            glEnableVertexAttribArray(0);
+            glDisableVertexAttribArray(1);
+            glDisableVertexAttribArray(2);
+            setupPrimitiveBase();
+        }
         
-        glBindVertexArray(m_VAO);
+        if (m_NodeBuffer.id && m_WireIndexBuffer.id) {
+            if (!m_WireVAO) glGenVertexArrays(1, &m_WireVAO);
+            
+            glBindVertexArray(m_WireVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, m_NodeBuffer.id);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_WireIndexBuffer.id);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+            glEnableVertexAttribArray(0);
+            setupPrimitiveBase();
+        }
         
-        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-        glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(Vertex),
-                     m_Vertices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_LayoutDirty = false;
+        ApplyDisplacements();
+        return;
+    }
+    
+    // Setup solid mesh VAO
+    if (m_VertexBuffer.id && m_IndexBuffer.id) {
+        if (!m_VAO) glGenVertexArrays(1, &m_VAO);
         
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int),
-                     m_Indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(m_VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer.id);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer.id);
         
         // Position attribute
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -123,74 +1090,302 @@ void Mesh::SetupBuffers() {
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                             (void*)offsetof(Vertex, texCoords));
         glEnableVertexAttribArray(2);
+        setupPrimitiveBase();
     }
     
-    // Setup wireframe VAO
-    if (!m_Vertices.empty() && !m_WireIndices.empty()) {
-        glGenVertexArrays(1, &m_WireVAO);
-        glGenBuffers(1, &m_WireVBO);
-        glGenBuffers(1, &m_WireEBO);
+    // Setup wireframe VAO, sharing the solid vertex buffer
+    if (m_VertexBuffer.id && m_WireIndexBuffer.id) {
+        if (!m_WireVAO) glGenVertexArrays(1, &m_WireVAO);
         
         glBindVertexArray(m_WireVAO);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, m_WireVBO);
-        glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(Vertex),
-                     m_Vertices.data(), GL_STATIC_DRAW);
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_WireEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_WireIndices.size() * sizeof(unsigned int),
-                     m_WireIndices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer.id);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_WireIndexBuffer.id);
         
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
         glEnableVertexAttribArray(0);
+        setupPrimitiveBase();
     }
     
     glBindVertexArray(0);
-    m_IsSetup = true;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_LayoutDirty = false;
+    ApplyDisplacements();
+}
+
+void Mesh::SetDisplacements(unsigned int buffer, size_t offset) {
+    if (buffer == m_DisplacementBuffer && offset == m_DisplacementOffset) {
+        return;
+    }
+    m_DisplacementBuffer = buffer;
+    m_DisplacementOffset = offset;
+    ApplyDisplacements();
+}
+
+void Mesh::ApplyDisplacements() {
+    // A disabled attribute reads as zero, which leaves positions unchanged
+    const bool shared = m_Layout == MeshLayout::SHARED_NODES;
+    for (unsigned int vao : {m_NodeVAO, m_VAO, m_WireVAO}) {
+        if (!vao) continue;
+        glBindVertexArray(vao);
+        if (m_DisplacementBuffer && (shared || vao == m_NodeVAO)) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_DisplacementBuffer);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+                                  reinterpret_cast<const void*>(m_DisplacementOffset));
+            glEnableVertexAttribArray(3);
+        } else {
+            glDisableVertexAttribArray(3);
+        }
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::RenderNodes(const MeshView* view) {
+    if (m_NodeVAO) {
+        glBindVertexArray(m_NodeVAO);
+        if (m_NodeIndexBuffer.id) {
+            DrawChunks(GL_POINTS, m_NodeIndexBuffer.used / sizeof(unsigned int), m_NodeChunks, view);
+        } else {
+            glDrawArrays(GL_POINTS, 0, m_NodeBuffer.used / sizeof(glm::vec3));
+            CountDraw(GL_POINTS, 1, 1, m_NodeBuffer.used / sizeof(glm::vec3));
+        }
+        glBindVertexArray(0);
+    }
 }
 
-void Mesh::RenderNodes() {
+void Mesh::DrawNodeArray() {
     if (m_NodeVAO) {
         glBindVertexArray(m_NodeVAO);
-        glDrawArrays(GL_POINTS, 0, m_NodePositions.size());
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(GetUploadedNodeCount()));
+        CountDraw(GL_POINTS, 1, 1, GetUploadedNodeCount());
         glBindVertexArray(0);
     }
 }
 
-void Mesh::RenderWireframe() {
+void Mesh::RenderWireframe(const MeshView* view) {
     if (m_WireVAO) {
+        glActiveTexture(GL_TEXTURE0 + kPrimitiveElementUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_WireElementTexture);
         glBindVertexArray(m_WireVAO);
-        glDrawElements(GL_LINES, m_WireIndices.size(), GL_UNSIGNED_INT, 0);
+        DrawChunks(GL_LINES, m_WireIndexBuffer.used / sizeof(unsigned int), m_WireChunks, view);
+        glBindVertexArray(0);
+    }
+}
+
+void Mesh::RenderSolid(const MeshView* view) {
+    if (m_VAO) {
+        glActiveTexture(GL_TEXTURE0 + kPrimitiveElementUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_TriangleElementTexture);
+        glBindVertexArray(m_VAO);
+        DrawChunks(GL_TRIANGLES, m_IndexBuffer.used / sizeof(unsigned int), m_TriangleChunks, view);
         glBindVertexArray(0);
     }
 }
 
-void Mesh::RenderSolid() {
+void Mesh::RenderClosedSurfaces(const MeshView* view) {
     if (m_VAO) {
+        MeshView fullDetail = view ? *view : MeshView();
+        fullDetail.pixelScale = 0.0f;
+        glActiveTexture(GL_TEXTURE0 + kPrimitiveElementUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_TriangleElementTexture);
         glBindVertexArray(m_VAO);
-        glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, 0);
+        DrawChunks(GL_TRIANGLES, m_IndexBuffer.used / sizeof(unsigned int), m_TriangleChunks,
+                   &fullDetail, true);
         glBindVertexArray(0);
     }
 }
 
-glm::vec3 Mesh::CalculateNormal(const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3) {
-    return glm::normalize(glm::cross(v2 - v1, v3 - v1));
+void Mesh::RenderPickTriangles(const MeshView* view) {
+    MeshView fullDetail = view ? *view : MeshView();
+    fullDetail.pixelScale = 0.0f;
+    RenderSolid(&fullDetail);
+}
+
+void Mesh::RenderPickNodes(const MeshView* view) {
+    MeshView fullDetail = view ? *view : MeshView();
+    fullDetail.pixelScale = 0.0f;
+    RenderNodes(&fullDetail);
+}
+
+void Mesh::CollectCommands(size_t uploadedIndices, ChunkList& list, const MeshView* view,
+                           bool closedOnly) {
+    // Subtrees entirely out of view are skipped. Without levels of detail,
+    // subtrees entirely in view are drawn as a whole; with them, each leaf
+    // picks its own level. Only the uploaded part of a range is drawn.
+    // Hierarchies come from one builder call, so one of open surfaces is
+    // skipped at its root when only closed ones are wanted.
+    m_Commands.clear();
+    auto submit = [&](uint32_t firstIndex, uint32_t indexCount) {
+        size_t end = std::min<size_t>(static_cast<size_t>(firstIndex) + indexCount, uploadedIndices);
+        if (end <= firstIndex) {
+            return;
+        }
+        uint32_t count = static_cast<uint32_t>(end - firstIndex);
+        if (!m_Commands.empty() &&
+            m_Commands.back().firstIndex + m_Commands.back().count == firstIndex) {
+            m_Commands.back().count += count;
+        } else {
+            m_Commands.push_back({count, 1, firstIndex, 0, 0});
+        }
+    };
+    
+    const Frustum* frustum = view ? view->frustum : nullptr;
+    const bool levels = view && view->pixelScale > 0.0f;
+    for (size_t i = 0; i < list.chunks.size();) {
+        const MeshChunk& chunk = list.chunks[i];
+        if (closedOnly && !chunk.closed) {
+            i += chunk.skip;
+            continue;
+        }
+        Frustum::Containment containment = frustum
+            ? frustum->Classify(chunk.minBounds - glm::vec3(view->boundsMargin),
+                                chunk.maxBounds + glm::vec3(view->boundsMargin))
+            : Frustum::Containment::INSIDE;
+        if (containment == Frustum::Containment::OUTSIDE) {
+            i += chunk.skip;
+        } else if (chunk.skip == 1) {
+            int level = levels ? SelectLevel(chunk, list.levels[i], *view) : 0;
+            
+            // A level still streaming in leaves the leaf at full detail
+            if (level > 0 && chunk.levelFirstIndex[level - 1] + chunk.levelIndexCount[level - 1] >
+                             uploadedIndices) {
+                level = 0;
+            }
+            if (levels) {
+                list.levels[i] = static_cast<uint8_t>(level);
+            }
+            if (level > 0) {
+                submit(chunk.levelFirstIndex[level - 1], chunk.levelIndexCount[level - 1]);
+            } else {
+                submit(chunk.firstIndex, chunk.indexCount);
+            }
+            ++i;
+        } else if (containment == Frustum::Containment::INSIDE && !levels) {
+            submit(chunk.firstIndex, chunk.indexCount);
+            i += chunk.skip;
+        } else {
+            ++i;
+        }
+    }
+}
+
+void Mesh::DrawChunks(unsigned int mode, size_t uploadedIndices, ChunkList& list,
+                      const MeshView* view, bool closedOnly) {
+    CollectCommands(uploadedIndices, list, view, closedOnly);
+    if (m_Commands.empty()) {
+        return;
+    }
+    
+    // gl_PrimitiveID restarts with every draw, so each passes the number
+    // of its first primitive for shaders to look up element tags with
+    const uint32_t verticesPerPrimitive = mode == GL_TRIANGLES ? 3 : (mode == GL_LINES ? 2 : 1);
+    size_t vertices = 0;
+    for (const DrawCommand& command : m_Commands) {
+        vertices += command.count;
+    }
+    if (HasIndirectDraws()) {
+        if (mode != GL_POINTS && m_DrawBaseBuffer) {
+            m_DrawBases.resize(m_Commands.size());
+            for (size_t c = 0; c < m_Commands.size(); ++c) {
+                m_DrawBases[c] = m_Commands[c].firstIndex / verticesPerPrimitive;
+                m_Commands[c].baseInstance = static_cast<uint32_t>(c);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, m_DrawBaseBuffer);
+            glBufferData(GL_ARRAY_BUFFER, m_DrawBases.size() * sizeof(uint32_t),
+                         m_DrawBases.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        if (!m_IndirectBuffer) glGenBuffers(1, &m_IndirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Commands.size() * sizeof(DrawCommand),
+                     m_Commands.data(), GL_STREAM_DRAW);
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, nullptr,
+                                    static_cast<GLsizei>(m_Commands.size()), 0);
+        CountDraw(mode, 1, m_Commands.size(), vertices);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        return;
+    }
+    
+    if (mode != GL_POINTS) {
+        for (const DrawCommand& command : m_Commands) {
+            glVertexAttribI1ui(kPrimitiveBaseAttribute, command.firstIndex / verticesPerPrimitive);
+            glDrawElements(mode, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+                           reinterpret_cast<const void*>(command.firstIndex * sizeof(unsigned int)));
+        }
+        CountDraw(mode, m_Commands.size(), m_Commands.size(), vertices);
+        return;
+    }
+    std::vector<GLsizei> counts(m_Commands.size());
+    std::vector<const void*> offsets(m_Commands.size());
+    for (size_t c = 0; c < m_Commands.size(); ++c) {
+        counts[c] = static_cast<GLsizei>(m_Commands[c].count);
+        offsets[c] = reinterpret_cast<const void*>(m_Commands[c].firstIndex * sizeof(unsigned int));
+    }
+    glMultiDrawElements(mode, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                        static_cast<GLsizei>(m_Commands.size()));
+    CountDraw(mode, 1, m_Commands.size(), vertices);
+}
+
+void Mesh::CountDraw(unsigned int mode, size_t calls, size_t commands, size_t vertices) {
+    m_Stats.calls += calls;
+    m_Stats.commands += commands;
+    if (mode == GL_TRIANGLES) {
+        m_Stats.triangles += vertices / 3;
+    } else if (mode == GL_LINES) {
+        m_Stats.lines += vertices / 2;
+    } else {
+        m_Stats.points += vertices;
+    }
+}
+
+size_t Mesh::GetGpuBytes() const {
+    size_t bytes = 0;
+    for (const StreamBuffer* buffer : {&m_NodeBuffer, &m_VertexBuffer, &m_IndexBuffer,
+                                       &m_WireIndexBuffer, &m_NodeIndexBuffer,
+                                       &m_TriangleElementBuffer, &m_WireElementBuffer}) {
+        bytes += buffer->capacity;
+    }
+    return bytes;
+}
+
+glm::vec3 Mesh::CalculateNormal(const std::vector<glm::vec3>& corners) {
+    glm::vec3 normal = corners.size() >= 4 ? glm::cross(corners[2] - corners[0], corners[3] - corners[1])
+                                           : glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+    float length = glm::length(normal);
+    return length > 0.0f ? normal / length : glm::vec3(0.0f);
 }
 
 void Mesh::Clear() {
     if (m_NodeVAO) glDeleteVertexArrays(1, &m_NodeVAO);
-    if (m_NodeVBO) glDeleteBuffers(1, &m_NodeVBO);
     if (m_VAO) glDeleteVertexArrays(1, &m_VAO);
-    if (m_VBO) glDeleteBuffers(1, &m_VBO);
-    if (m_EBO) glDeleteBuffers(1, &m_EBO);
     if (m_WireVAO) glDeleteVertexArrays(1, &m_WireVAO);
-    if (m_WireVBO) glDeleteBuffers(1, &m_WireVBO);
-    if (m_WireEBO) glDeleteBuffers(1, &m_WireEBO);
+    m_NodeVAO = m_VAO = m_WireVAO = 0;
     
-    m_Vertices.clear();
-    m_Indices.clear();
-    m_WireIndices.clear();
-    m_NodePositions.clear();
+    for (StreamBuffer* buffer : {&m_NodeBuffer, &m_VertexBuffer, &m_IndexBuffer,
+                                 &m_WireIndexBuffer, &m_NodeIndexBuffer,
+                                 &m_TriangleElementBuffer, &m_WireElementBuffer}) {
+        if (buffer->id) glDeleteBuffers(1, &buffer->id);
+        buffer->id = 0;
+        buffer->used = 0;
+        buffer->capacity = 0;
+    }
+    if (m_IndirectBuffer) glDeleteBuffers(1, &m_IndirectBuffer);
+    if (m_DrawBaseBuffer) glDeleteBuffers(1, &m_DrawBaseBuffer);
+    m_IndirectBuffer = m_DrawBaseBuffer = 0;
+    for (unsigned int* texture : {&m_TriangleElementTexture, &m_WireElementTexture}) {
+        if (*texture) glDeleteTextures(1, texture);
+        *texture = 0;
+    }
     
-    m_IsSetup = false;
-}
\ No newline at end of file
+    m_TriangleChunks = ChunkList();
+    m_WireChunks = ChunkList();
+    m_NodeChunks = ChunkList();
+    m_QueuedNodes = 0;
+    m_TriangleElements = std::vector<uint32_t>();
+    m_TriangleIndices = std::vector<unsigned int>();
+    
+    m_Pending.clear();
+    std::fill(std::begin(m_PendingOffsets), std::end(m_PendingOffsets), 0);
+    m_Layout = MeshLayout::SHARED_NODES;
+    m_LayoutDirty = false;
+}
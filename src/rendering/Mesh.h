@@ -1,8 +1,13 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <glm/glm.hpp>
 
 class Model;
+class SolidSkin;
+class Frustum;
 
 struct Vertex {
     glm::vec3 position;
@@ -10,31 +15,251 @@ struct Vertex {
     glm::vec2 texCoords;
 };
 
+// How element geometry references its vertices
+enum class MeshLayout {
+    SHARED_NODES,   // Indices into the node positions, each uploaded once;
+                    // the shader derives face normals
+    PER_ELEMENT     // Own vertices per element, with the face normal
+};
+
+// Node of a bounding volume hierarchy over a mesh's triangles, lines or
+// points. Nodes are stored in preorder, so a subtree is the next skip nodes
+// and covers one contiguous index range; leaves hold up to kChunkPrimitives.
+// Leaves also keep vertex-clustered versions of their primitives, each
+// coarser than the last, in index ranges after the full-detail ones.
+struct MeshChunk {
+    static constexpr int kCoarseLevels = 2;
+    
+    glm::vec3 minBounds;
+    glm::vec3 maxBounds;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t skip;   // Nodes in the subtree, this one included
+    bool closed = false;   // Part of a closed surface (solid skins), which section caps need
+    
+    uint32_t levelCount = 0;   // Coarse levels built, up to kCoarseLevels
+    uint32_t levelFirstIndex[kCoarseLevels] = {};
+    uint32_t levelIndexCount[kCoarseLevels] = {};
+};
+
+// What a frame sees of a mesh. Chunks outside the frustum are skipped, and
+// with a pixel scale, leaves that are small on screen use a coarse level.
+struct MeshView {
+    const Frustum* frustum = nullptr;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    float pixelScale = 0.0f;   // projection[1][1] * viewport height / 2; 0 keeps full detail
+    float boundsMargin = 0.0f; // Grows chunk bounds, e.g. by the largest displacement
+};
+
+// CPU-side geometry. Needs no GL context, so loaders can build it on a
+// worker thread and hand it to Mesh for upload on the render thread.
+struct MeshData {
+    static constexpr uint32_t kNoElement = 0xFFFFFFFFu;
+    
+    std::vector<glm::vec3> nodePositions;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> wireIndices;
+    std::vector<unsigned int> nodeIndices;   // Node positions in spatial order
+    std::vector<uint32_t> triangleElements;  // Model element index of each triangle in indices
+    std::vector<uint32_t> wireElements;      // And of each line in wireIndices, kNoElement
+                                             // for edges between parts
+    MeshLayout layout = MeshLayout::SHARED_NODES;
+    
+    // Spatial chunks of indices, wireIndices and nodeIndices, one hierarchy
+    // per builder call; geometry without chunks is always drawn
+    std::vector<MeshChunk> triangleChunks;
+    std::vector<MeshChunk> wireChunks;
+    std::vector<MeshChunk> nodeChunks;
+    
+    void Append(MeshData&& other);
+    void Clear();
+    bool Empty() const;
+    size_t GetByteSize() const;
+};
+
+// What a mesh drew since its stats were last reset
+struct MeshDrawStats {
+    size_t calls = 0;        // GL draw calls, a multi-draw counting once
+    size_t commands = 0;     // Draws those calls made, one per chunk range
+    size_t triangles = 0;
+    size_t lines = 0;
+    size_t points = 0;
+};
+
 class Mesh {
 public:
+    static constexpr size_t kChunkPrimitives = 1u << 16;
+    
+    // While triangles or lines are drawn, their element tags are bound to
+    // this texture unit as a usamplerBuffer indexed by absolute primitive
+    // number, and the number of each draw's first primitive is the uint
+    // vertex attribute kPrimitiveBaseAttribute; adding gl_PrimitiveID
+    // gives the primitive's.
+    static constexpr unsigned int kPrimitiveElementUnit = 0;
+    static constexpr unsigned int kPrimitiveBaseAttribute = 4;
+    
     Mesh();
     ~Mesh();
     
-    void BuildFromModel(Model* model);
+    // Solids are drawn through their exterior skin; pass one that is kept
+    // up to date to reuse it (and its hidden elements), else one is built
+    void BuildFromModel(Model* model, MeshLayout layout = MeshLayout::SHARED_NODES,
+                        const SolidSkin* skin = nullptr);
     void Clear();
     
-    void RenderNodes();
-    void RenderWireframe();
-    void RenderSolid();
+    // Geometry builders, safe to call off the render thread. With
+    // PER_ELEMENT, element vertices are numbered from vertexBase, the count
+    // of vertices built before data; SHARED_NODES indices are node indices.
+    // AppendElements covers shells; solids come from AppendSkin, which
+    // needs all of them, so it runs once the model is complete. Elements
+    // set in hidden are skipped. Shared-node outlines list each edge of a
+    // call's output once.
+    static void AppendNodes(const Model& model, MeshData& data);
+    static void AppendElements(const Model& model, size_t first, size_t count,
+                               unsigned int vertexBase, MeshData& data,
+                               MeshLayout layout = MeshLayout::SHARED_NODES,
+                               const std::vector<char>* hidden = nullptr);
+    static void AppendSkin(const Model& model, const SolidSkin& skin, MeshData& data);
+    
+    // Streaming upload: Append queues geometry and ContinueUpload copies at
+    // most byteBudget bytes of it to the GPU. Only uploaded geometry is drawn.
+    void Append(MeshData&& data);
+    void ContinueUpload(size_t byteBudget);
+    bool HasPendingUpload() const { return !m_Pending.empty(); }
+    
+    // Without a view everything is drawn at full detail; with one, what it
+    // selects is drawn through one multi-draw call
+    void RenderNodes(const MeshView* view = nullptr);
+    void RenderWireframe(const MeshView* view = nullptr);
+    void RenderSolid(const MeshView* view = nullptr);
+    
+    // Closed surfaces only, at full detail: the stencil pass of section caps
+    void RenderClosedSurfaces(const MeshView* view);
+    
+    // Per-node displacements read from buffer at a byte offset, as vertex
+    // attribute 3; buffer 0 turns them off. Only node-indexed geometry can
+    // use them, so PER_ELEMENT solids and outlines stay undeformed.
+    void SetDisplacements(unsigned int buffer, size_t offset);
+    
+    // Picking pass: triangles at full detail, numbered like for the tags;
+    // and nodes, whose gl_VertexID is their node index
+    void RenderPickTriangles(const MeshView* view);
+    void RenderPickNodes(const MeshView* view);
+    
+    // Model element index of an absolute triangle number, kNoElement for
+    // numbers out of range
+    uint32_t GetTriangleElement(size_t triangle) const {
+        return triangle < m_TriangleElements.size() ? m_TriangleElements[triangle] : MeshData::kNoElement;
+    }
+    
+    // Inputs of NormalGenerator: the queued triangles, numbered like the
+    // tags, with their chunks (which tell coarse levels apart), and what
+    // of them is on the GPU
+    MeshLayout GetLayout() const { return m_Layout; }
+    const std::vector<unsigned int>& GetTriangleIndices() const { return m_TriangleIndices; }
+    const std::vector<MeshChunk>& GetTriangleChunks() const { return m_TriangleChunks.chunks; }
+    unsigned int GetIndexBuffer() const { return m_IndexBuffer.id; }
+    size_t GetUploadedTriangleCount() const { return m_IndexBuffer.used / (3 * sizeof(unsigned int)); }
+    size_t GetUploadedNodeCount() const { return m_NodeBuffer.used / sizeof(glm::vec3); }
+    unsigned int GetDisplacementBuffer() const { return m_DisplacementBuffer; }
+    size_t GetDisplacementOffset() const { return m_DisplacementOffset; }
+    
+    // Every uploaded node once, in node order and displaced, so gl_VertexID
+    // is the node index; for transform feedback passes
+    void DrawNodeArray();
+    
+    const MeshDrawStats& GetDrawStats() const { return m_Stats; }
+    void ResetDrawStats() { m_Stats = MeshDrawStats(); }
+    size_t GetGpuBytes() const;   // Allocated for its buffers
     
 private:
-    void SetupBuffers();
-    glm::vec3 CalculateNormal(const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3);
+    // GPU buffer that grows as streamed geometry arrives
+    struct StreamBuffer {
+        unsigned int id = 0;
+        unsigned int target = 0;
+        size_t used = 0;      // Bytes uploaded
+        size_t capacity = 0;  // Bytes allocated
+    };
+    
+    struct DrawCommand {   // Layout of DrawElementsIndirectCommand
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t baseInstance;
+    };
+    
+    // Chunk hierarchy with absolute index ranges, the level each leaf was
+    // last drawn at, and the indices queued so far, which the ranges of
+    // newly appended data start from
+    struct ChunkList {
+        std::vector<MeshChunk> chunks;
+        std::vector<uint8_t> levels;
+        size_t queued = 0;
+    };
+    
+    // Primitive tags, when given, are reordered with their primitives, and
+    // coarse primitives take a tag of one they replace. Positions are the
+    // model's node column or a vector of the mesh's own.
+    template<typename Positions>
+    static void BuildChunks(const Positions& positions, size_t verticesPerPrimitive,
+                            std::vector<unsigned int>& indices, size_t first,
+                            std::vector<MeshChunk>& chunks,
+                            std::vector<uint32_t>* primitiveTags = nullptr);
+    template<typename Positions>
+    static void BuildCoarseLevels(const Positions& positions,
+                                  size_t verticesPerPrimitive, std::vector<unsigned int>& indices,
+                                  std::vector<MeshChunk>& chunks, size_t firstChunk,
+                                  std::vector<uint32_t>* primitiveTags);
+    void QueueChunks(ChunkList& list, std::vector<MeshChunk>& chunks, size_t indexCount);
+    void CollectCommands(size_t uploadedIndices, ChunkList& list, const MeshView* view,
+                         bool closedOnly);
+    void DrawChunks(unsigned int mode, size_t uploadedIndices, ChunkList& list,
+                    const MeshView* view, bool closedOnly = false);
+    void CountDraw(unsigned int mode, size_t calls, size_t commands, size_t vertices);
+    
+    size_t UploadRange(StreamBuffer& buffer, const void* data, size_t totalBytes,
+                       size_t& offset, size_t budget);
+    static void AppendSharedElements(const Model& model, size_t first, size_t last,
+                                     const std::vector<char>* hidden, MeshData& data);
+    void SetupVertexArrays();
+    void ApplyDisplacements();
+    // Of a triangle, or of a quad from its diagonals, which suits warped ones
+    static glm::vec3 CalculateNormal(const std::vector<glm::vec3>& corners);
     
 private:
-    std::vector<Vertex> m_Vertices;
-    std::vector<unsigned int> m_Indices;
-    std::vector<unsigned int> m_WireIndices;
-    std::vector<glm::vec3> m_NodePositions;
+    std::deque<MeshData> m_Pending;
+    size_t m_PendingOffsets[7];  // Bytes of m_Pending.front() already uploaded, per array
+    
+    StreamBuffer m_NodeBuffer;
+    StreamBuffer m_VertexBuffer;
+    StreamBuffer m_IndexBuffer;
+    StreamBuffer m_WireIndexBuffer;
+    StreamBuffer m_NodeIndexBuffer;
+    StreamBuffer m_TriangleElementBuffer;
+    StreamBuffer m_WireElementBuffer;
+    
+    ChunkList m_TriangleChunks;
+    ChunkList m_WireChunks;
+    ChunkList m_NodeChunks;
+    size_t m_QueuedNodes;
+    std::vector<uint32_t> m_TriangleElements;   // CPU copy, for resolving picks
+    std::vector<unsigned int> m_TriangleIndices; // And for generating normals
+    unsigned int m_TriangleElementTexture;
+    unsigned int m_WireElementTexture;
     
-    unsigned int m_VAO, m_VBO, m_EBO;
-    unsigned int m_WireVAO, m_WireVBO, m_WireEBO;
-    unsigned int m_NodeVAO, m_NodeVBO;
+    // Per-frame draw list, the buffer it is handed to the GPU in, and the
+    // first primitive of each draw
+    std::vector<DrawCommand> m_Commands;
+    unsigned int m_IndirectBuffer;
+    std::vector<uint32_t> m_DrawBases;
+    unsigned int m_DrawBaseBuffer;
     
-    bool m_IsSetup;
+    unsigned int m_VAO, m_WireVAO, m_NodeVAO;
+    unsigned int m_DisplacementBuffer;
+    size_t m_DisplacementOffset;
+    MeshLayout m_Layout;
+    bool m_LayoutDirty;
+    MeshDrawStats m_Stats;
 };
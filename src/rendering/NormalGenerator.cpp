@@ -0,0 +1,414 @@
+#include "rendering/NormalGenerator.h"
+#include "rendering/Mesh.h"
+#include "rendering/Shader.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define NORMALS_HAS_SSE2 1
+#endif
+
+namespace {
+
+constexpr size_t kGrainSize = 1u << 14;
+
+// Pass inputs that the drawing shaders do not read
+constexpr unsigned int kIndexUnit = 13;      // usamplerBuffer, R32UI
+constexpr unsigned int kOffsetUnit = 14;     // usamplerBuffer, R32UI
+constexpr unsigned int kEntryUnit = 15;      // usamplerBuffer, R32UI
+constexpr unsigned int kPassInputUnit = 16;  // samplerBuffer, RGBA32F
+
+void BindTexture(unsigned int unit, unsigned int texture) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
+
+// Runs draw with its vertex outputs captured into buffer
+template<typename Draw>
+void CaptureInto(unsigned int buffer, Draw&& draw) {
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer);
+    glBeginTransformFeedback(GL_POINTS);
+    draw();
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+}
+
+} // namespace
+
+bool TriangleAdjacency::Build(const std::vector<unsigned int>& indices,
+                              const std::vector<MeshChunk>& chunks, size_t nodeCount) {
+    Clear();
+    const size_t triangleCount = indices.size() / 3;
+    
+    // Coarse levels sit in index ranges of their own after the full detail
+    std::vector<char> coarse(triangleCount, 0);
+    for (const MeshChunk& chunk : chunks) {
+        for (uint32_t level = 0; level < chunk.levelCount; ++level) {
+            size_t first = chunk.levelFirstIndex[level] / 3;
+            size_t last = std::min(triangleCount, first + chunk.levelIndexCount[level] / 3);
+            std::fill(coarse.begin() + std::min(first, last), coarse.begin() + last, 1);
+        }
+    }
+    
+    // Counting sort: count the corners per node, turn the counts into row
+    // offsets, then scatter through per-row atomic cursors
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    std::vector<std::atomic<uint32_t>> cursors(nodeCount);
+    std::atomic<bool> outOfRange{false};
+    auto listed = [&](size_t t) {
+        const unsigned int* corners = indices.data() + 3 * t;
+        return !coarse[t] && corners[0] != corners[1] && corners[1] != corners[2] &&
+               corners[0] != corners[2];
+    };
+    pool.ParallelFor(triangleCount, kGrainSize, [&](size_t first, size_t last) {
+        for (size_t t = first; t < last; ++t) {
+            const unsigned int* corners = indices.data() + 3 * t;
+            if (corners[0] >= nodeCount || corners[1] >= nodeCount || corners[2] >= nodeCount) {
+                outOfRange = true;
+                return;
+            }
+            if (listed(t)) {
+                for (int k = 0; k < 3; ++k) {
+                    cursors[corners[k]].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    if (outOfRange) {
+        LOG_WARN("Mesh triangles reference nodes past {}; no smooth normals", nodeCount);
+        return false;
+    }
+    
+    offsets.assign(nodeCount + 1, 0);
+    for (size_t n = 0; n < nodeCount; ++n) {
+        uint32_t count = cursors[n].load(std::memory_order_relaxed);
+        offsets[n + 1] = offsets[n] + count;
+        cursors[n].store(offsets[n], std::memory_order_relaxed);
+    }
+    entries.resize(offsets.back());
+    pool.ParallelFor(triangleCount, kGrainSize, [&](size_t first, size_t last) {
+        for (size_t t = first; t < last; ++t) {
+            if (listed(t)) {
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t slot = cursors[indices[3 * t + k]].fetch_add(1, std::memory_order_relaxed);
+                    entries[slot] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+    });
+    
+    // Rows in a fixed order, so the sums do not depend on the scheduling
+    pool.ParallelFor(nodeCount, kGrainSize, [&](size_t first, size_t last) {
+        for (size_t n = first; n < last; ++n) {
+            std::sort(entries.begin() + offsets[n], entries.begin() + offsets[n + 1]);
+        }
+    });
+    return true;
+}
+
+void TriangleAdjacency::Clear() {
+    offsets = std::vector<uint32_t>();
+    entries = std::vector<uint32_t>();
+}
+
+NormalGenerator::NormalGenerator() = default;
+
+NormalGenerator::~NormalGenerator() {
+    for (FeedbackBuffer* target : {&m_Offsets, &m_Entries, &m_Positions, &m_Faces, &m_Corners}) {
+        DeleteBuffer(*target);
+    }
+    if (m_IndexTexture) glDeleteTextures(1, &m_IndexTexture);
+    if (m_EmptyVAO) glDeleteVertexArrays(1, &m_EmptyVAO);
+}
+
+void NormalGenerator::SetMesh(const Mesh& mesh, size_t nodeCount) {
+    Clear();
+    if (mesh.GetLayout() != MeshLayout::SHARED_NODES) {
+        return;   // Per-element vertices carry their own normals
+    }
+    if (m_Adjacency.Build(mesh.GetTriangleIndices(), mesh.GetTriangleChunks(), nodeCount)) {
+        m_TriangleCount = mesh.GetTriangleIndices().size() / 3;
+    }
+}
+
+void NormalGenerator::Clear() {
+    m_Adjacency.Clear();
+    m_AdjacencyUploaded = false;
+    m_TriangleCount = 0;
+    m_CornerCount = 0;
+}
+
+void NormalGenerator::Update(Mesh& mesh, const ChunkedColumn<glm::vec3>& positions, size_t frame,
+                             float displacementScale, float featureAngle) {
+    if (!m_Adjacency.IsBuilt() || m_TriangleCount == 0) {
+        return;
+    }
+    featureAngle = std::clamp(featureAngle, 0.0f, 90.0f);
+    const bool deformed = mesh.GetDisplacementBuffer() != 0 && displacementScale != 0.0f;
+    if (m_CornerCount > 0 && deformed == m_Deformed && featureAngle == m_FeatureAngle &&
+        (!deformed || (frame == m_Frame && mesh.GetDisplacementBuffer() == m_DisplacementBuffer &&
+                       mesh.GetDisplacementOffset() == m_DisplacementOffset &&
+                       displacementScale == m_DisplacementScale))) {
+        return;
+    }
+    m_Deformed = deformed;
+    m_Frame = frame;
+    m_DisplacementBuffer = mesh.GetDisplacementBuffer();
+    m_DisplacementOffset = mesh.GetDisplacementOffset();
+    m_DisplacementScale = displacementScale;
+    m_FeatureAngle = featureAngle;
+    
+    if (deformed) {
+        ComputeOnGpu(mesh, featureAngle);
+    } else {
+        ComputeOnCpu(mesh, positions, featureAngle);
+    }
+}
+
+void NormalGenerator::Bind(bool smooth) const {
+    BindTexture(kCornerNormalUnit, smooth && m_CornerCount > 0 ? m_Corners.texture : 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void NormalGenerator::ComputeOnCpu(const Mesh& mesh, const ChunkedColumn<glm::vec3>& positions,
+                                   float featureAngle) {
+    const std::vector<unsigned int>& indices = mesh.GetTriangleIndices();
+    const size_t nodeCount = m_Adjacency.GetNodeCount();
+    const size_t triangleCount = indices.size() / 3;
+    if (positions.size() < nodeCount || triangleCount != m_TriangleCount) {
+        m_CornerCount = 0;
+        return;
+    }
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    
+    // Positions into SoA, so the face kernel loads whole lanes per axis
+    m_X.resize(nodeCount);
+    m_Y.resize(nodeCount);
+    m_Z.resize(nodeCount);
+    pool.ParallelFor(nodeCount, kGrainSize, [&](size_t first, size_t last) {
+        positions.ForEachSpan(first, last, [&](const glm::vec3* values, size_t count, size_t offset) {
+            for (size_t k = 0; k < count; ++k) {
+                m_X[offset + k] = values[k].x;
+                m_Y[offset + k] = values[k].y;
+                m_Z[offset + k] = values[k].z;
+            }
+        });
+    });
+    
+    m_NX.resize(triangleCount);
+    m_NY.resize(triangleCount);
+    m_NZ.resize(triangleCount);
+    pool.ParallelFor(triangleCount, kGrainSize, [&](size_t first, size_t last) {
+        ComputeFaceNormals(m_X.data(), m_Y.data(), m_Z.data(), indices.data() + 3 * first,
+                           last - first, m_NX.data() + first, m_NY.data() + first, m_NZ.data() + first);
+    });
+    
+    m_Packed.resize(triangleCount * 6);
+    pool.ParallelFor(triangleCount, kGrainSize, [&](size_t first, size_t last) {
+        ComputeCornerNormals(m_Adjacency, indices.data(), first, last, m_NX.data(), m_NY.data(),
+                             m_NZ.data(), featureAngle, m_Packed.data());
+    });
+    
+    EnsureBuffer(m_Corners, GL_RG32UI, m_Packed.size() * sizeof(uint32_t), m_Packed.data());
+    m_CornerCount = triangleCount * 3;
+}
+
+void NormalGenerator::ComputeOnGpu(Mesh& mesh, float featureAngle) {
+    const size_t triangleCount = mesh.GetUploadedTriangleCount();
+    const size_t nodeCount = mesh.GetUploadedNodeCount();
+    if (triangleCount != m_TriangleCount || nodeCount < m_Adjacency.GetNodeCount()) {
+        m_CornerCount = 0;
+        return;
+    }
+    EnsureShaders();
+    UploadAdjacency();
+    EnsureBuffer(m_Positions, GL_RGBA32F, nodeCount * sizeof(glm::vec4));
+    EnsureBuffer(m_Faces, GL_RGBA32F, triangleCount * sizeof(glm::vec4));
+    EnsureBuffer(m_Corners, GL_RG32UI, triangleCount * 3 * 2 * sizeof(uint32_t));
+    
+    // The index buffer may have been reallocated while streaming
+    if (!m_IndexTexture) glGenTextures(1, &m_IndexTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, mesh.GetIndexBuffer());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    
+    GLint program = 0, vertexArray = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+    glEnable(GL_RASTERIZER_DISCARD);
+    
+    // Displaced nodes, one point each in node order
+    m_PositionShader->Use();
+    m_PositionShader->SetFloat("scale", m_DisplacementScale);
+    CaptureInto(m_Positions.buffer, [&]() { mesh.DrawNodeArray(); });
+    
+    // Then a point per triangle for its face normal, and one per corner
+    // gathering over the corner's node
+    BindTexture(kIndexUnit, m_IndexTexture);
+    BindTexture(kOffsetUnit, m_Offsets.texture);
+    BindTexture(kEntryUnit, m_Entries.texture);
+    glBindVertexArray(m_EmptyVAO);
+    
+    BindTexture(kPassInputUnit, m_Positions.texture);
+    m_FaceShader->Use();
+    CaptureInto(m_Faces.buffer, [&]() {
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(triangleCount));
+    });
+    
+    BindTexture(kPassInputUnit, m_Faces.texture);
+    m_CornerShader->Use();
+    m_CornerShader->SetFloat("cosFeature", std::cos(glm::radians(featureAngle)));
+    CaptureInto(m_Corners.buffer, [&]() {
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(triangleCount * 3));
+    });
+    
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(program);
+    glBindVertexArray(vertexArray);
+    glActiveTexture(GL_TEXTURE0);
+    m_CornerCount = triangleCount * 3;
+}
+
+void NormalGenerator::EnsureShaders() {
+    if (m_CornerShader) {
+        return;
+    }
+    m_PositionShader = std::make_unique<Shader>("shaders/normal_positions.vert",
+                                                std::vector<std::string>{"position"});
+    m_FaceShader = std::make_unique<Shader>("shaders/normal_faces.vert",
+                                            std::vector<std::string>{"faceNormal"});
+    m_CornerShader = std::make_unique<Shader>("shaders/normal_corners.vert",
+                                              std::vector<std::string>{"cornerNormal"});
+    
+    // Samplers keep their texture units for good
+    for (Shader* shader : {m_FaceShader.get(), m_CornerShader.get()}) {
+        shader->Use();
+        shader->Set(shader->GetUniform<int>("triangleIndices"), static_cast<int>(kIndexUnit));
+        shader->Set(shader->GetUniform<int>("adjacencyOffsets"), static_cast<int>(kOffsetUnit));
+        shader->Set(shader->GetUniform<int>("adjacencyEntries"), static_cast<int>(kEntryUnit));
+        shader->Set(shader->GetUniform<int>("nodePositions"), static_cast<int>(kPassInputUnit));
+        shader->Set(shader->GetUniform<int>("faceNormals"), static_cast<int>(kPassInputUnit));
+    }
+    glUseProgram(0);
+    glGenVertexArrays(1, &m_EmptyVAO);
+}
+
+void NormalGenerator::UploadAdjacency() {
+    if (m_AdjacencyUploaded) {
+        return;
+    }
+    EnsureBuffer(m_Offsets, GL_R32UI, m_Adjacency.offsets.size() * sizeof(uint32_t),
+                 m_Adjacency.offsets.data());
+    EnsureBuffer(m_Entries, GL_R32UI, m_Adjacency.entries.size() * sizeof(uint32_t),
+                 m_Adjacency.entries.data());
+    m_AdjacencyUploaded = true;
+}
+
+void NormalGenerator::EnsureBuffer(FeedbackBuffer& target, unsigned int format, size_t bytes,
+                                   const void* data) {
+    if (!target.buffer) glGenBuffers(1, &target.buffer);
+    if (!target.texture) glGenTextures(1, &target.texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+    if (bytes != target.bytes) {
+        glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_DYNAMIC_DRAW);
+        target.bytes = bytes;
+    } else if (data && bytes > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    
+    // Without storage the texture reads as size zero, which shaders take as none
+    glBindTexture(GL_TEXTURE_BUFFER, target.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, bytes ? target.buffer : 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void NormalGenerator::DeleteBuffer(FeedbackBuffer& target) {
+    if (target.buffer) glDeleteBuffers(1, &target.buffer);
+    if (target.texture) glDeleteTextures(1, &target.texture);
+    target = FeedbackBuffer();
+}
+
+void NormalGenerator::ComputeFaceNormals(const float* x, const float* y, const float* z,
+                                         const unsigned int* indices, size_t triangleCount,
+                                         float* nx, float* ny, float* nz) {
+    size_t t = 0;
+#ifdef NORMALS_HAS_SSE2
+    // Four triangles a lane each: the corners are gathered, the edges and
+    // their cross product computed side by side
+    for (; t + 4 <= triangleCount; t += 4) {
+        const unsigned int* i = indices + 3 * t;
+        __m128 ax = _mm_setr_ps(x[i[0]], x[i[3]], x[i[6]], x[i[9]]);
+        __m128 ay = _mm_setr_ps(y[i[0]], y[i[3]], y[i[6]], y[i[9]]);
+        __m128 az = _mm_setr_ps(z[i[0]], z[i[3]], z[i[6]], z[i[9]]);
+        __m128 ux = _mm_sub_ps(_mm_setr_ps(x[i[1]], x[i[4]], x[i[7]], x[i[10]]), ax);
+        __m128 uy = _mm_sub_ps(_mm_setr_ps(y[i[1]], y[i[4]], y[i[7]], y[i[10]]), ay);
+        __m128 uz = _mm_sub_ps(_mm_setr_ps(z[i[1]], z[i[4]], z[i[7]], z[i[10]]), az);
+        __m128 vx = _mm_sub_ps(_mm_setr_ps(x[i[2]], x[i[5]], x[i[8]], x[i[11]]), ax);
+        __m128 vy = _mm_sub_ps(_mm_setr_ps(y[i[2]], y[i[5]], y[i[8]], y[i[11]]), ay);
+        __m128 vz = _mm_sub_ps(_mm_setr_ps(z[i[2]], z[i[5]], z[i[8]], z[i[11]]), az);
+        _mm_storeu_ps(nx + t, _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy)));
+        _mm_storeu_ps(ny + t, _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz)));
+        _mm_storeu_ps(nz + t, _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx)));
+    }
+#endif
+    for (; t < triangleCount; ++t) {
+        const unsigned int* i = indices + 3 * t;
+        float ux = x[i[1]] - x[i[0]], uy = y[i[1]] - y[i[0]], uz = z[i[1]] - z[i[0]];
+        float vx = x[i[2]] - x[i[0]], vy = y[i[2]] - y[i[0]], vz = z[i[2]] - z[i[0]];
+        nx[t] = uy * vz - uz * vy;
+        ny[t] = uz * vx - ux * vz;
+        nz[t] = ux * vy - uy * vx;
+    }
+}
+
+void NormalGenerator::ComputeCornerNormals(const TriangleAdjacency& adjacency, const unsigned int* indices,
+                                           size_t firstTriangle, size_t lastTriangle,
+                                           const float* nx, const float* ny, const float* nz,
+                                           float featureAngle, uint32_t* corners) {
+    const float cosFeature = std::cos(glm::radians(featureAngle));
+    for (size_t t = firstTriangle; t < lastTriangle; ++t) {
+        glm::vec3 own(nx[t], ny[t], nz[t]);
+        float ownLength = glm::length(own);
+        if (ownLength == 0.0f) {
+            std::fill(corners + 6 * t, corners + 6 * t + 6, 0u);
+            continue;
+        }
+        own /= ownLength;
+        
+        for (size_t k = 0; k < 3; ++k) {
+            const size_t node = indices[3 * t + k];
+            glm::vec3 sum(0.0f);
+            for (uint32_t e = adjacency.offsets[node]; e < adjacency.offsets[node + 1]; ++e) {
+                const uint32_t other = adjacency.entries[e];
+                glm::vec3 normal(nx[other], ny[other], nz[other]);
+                float length = glm::length(normal);
+                float cosine = length > 0.0f ? glm::dot(normal, own) / length : 0.0f;
+                if (std::abs(cosine) >= cosFeature) {
+                    sum += cosine >= 0.0f ? normal : -normal;
+                }
+            }
+            
+            // Coarse triangles may meet no full-detail face close enough
+            float length = glm::length(sum);
+            PackNormal(length > 0.0f ? sum / length : own, corners + 6 * t + 2 * k);
+        }
+    }
+}
+
+void NormalGenerator::PackNormal(const glm::vec3& normal, uint32_t* packed) {
+    if (normal == glm::vec3(0.0f)) {
+        packed[0] = packed[1] = 0;
+        return;
+    }
+    auto quantise = [](float value) {
+        return static_cast<uint32_t>(std::lround((std::clamp(value, -1.0f, 1.0f) * 0.5f + 0.5f) * 65535.0f));
+    };
+    packed[0] = quantise(normal.x) | (quantise(normal.y) << 16);
+    packed[1] = quantise(normal.z);
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "core/ChunkedColumn.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Mesh;
+class Shader;
+struct MeshChunk;
+
+// Which triangles of a shared-node mesh use each node: those of node n are
+// entries [offsets[n], offsets[n + 1]) (CSR, like NodeAdjacency), by
+// absolute triangle number. Only full-detail triangles with three distinct
+// nodes are listed; coarse levels and degenerate fill do not smooth.
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets;   // Node count + 1 entries
+    std::vector<uint32_t> entries;   // Triangle numbers, row by row, ascending
+    
+    // Counting sort over the indices, in parallel; false, leaving it
+    // empty, when an index is not below nodeCount
+    bool Build(const std::vector<unsigned int>& indices, const std::vector<MeshChunk>& chunks,
+               size_t nodeCount);
+    void Clear();
+    bool IsBuilt() const { return !offsets.empty(); }
+    size_t GetNodeCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+};
+
+// Smooth normals of a shared-node mesh, one per triangle corner, which the
+// solid shader interpolates. A corner's normal is the area-weighted sum of
+// the face normals around its node that lie within the feature angle of
+// its own face, so warped quads and curved panels shade smoothly while
+// sharper edges stay sharp. Shells come wound either way, so a face
+// pointing away counts reversed.
+//
+// Undeformed geometry is done on the CPU: face normals by an SSE2 kernel
+// over SoA positions, then the corners in parallel. While an animation
+// displaces the mesh the same runs on the GPU for every new frame, as
+// transform feedback passes over the mesh's own buffers. Render thread
+// only, apart from the static kernels.
+class NormalGenerator {
+public:
+    static constexpr unsigned int kCornerNormalUnit = 12;   // usamplerBuffer, RG32UI
+    
+    NormalGenerator();
+    ~NormalGenerator();
+    
+    NormalGenerator(const NormalGenerator&) = delete;
+    NormalGenerator& operator=(const NormalGenerator&) = delete;
+    
+    // Adjacency of the mesh's triangles, after every rebuild; drops the normals
+    void SetMesh(const Mesh& mesh, size_t nodeCount);
+    void Clear();
+    bool HasNormals() const { return m_CornerCount > 0; }
+    
+    // Recomputes when an input changed since the last call. With
+    // displacements bound to the mesh and a scale, frame tells the
+    // animation's states apart and the work is done on the GPU; otherwise
+    // positions are the undeformed nodes. Feature angles go up to 90 degrees.
+    void Update(Mesh& mesh, const ChunkedColumn<glm::vec3>& positions, size_t frame,
+                float displacementScale, float featureAngle);
+    
+    // Binds the corner normals, or none to shade flat
+    void Bind(bool smooth) const;
+    
+    // CPU kernels, safe off the render thread. Face normals are the cross
+    // products of two edges, twice the area long; corner normals come out
+    // packed, two words each
+    static void ComputeFaceNormals(const float* x, const float* y, const float* z,
+                                   const unsigned int* indices, size_t triangleCount,
+                                   float* nx, float* ny, float* nz);
+    static void ComputeCornerNormals(const TriangleAdjacency& adjacency, const unsigned int* indices,
+                                     size_t firstTriangle, size_t lastTriangle,
+                                     const float* nx, const float* ny, const float* nz,
+                                     float featureAngle, uint32_t* corners);
+    
+    // 16-bit fixed point per axis of a unit vector; the zero vector packs
+    // to (0, 0), which the shader reads as no normal
+    static void PackNormal(const glm::vec3& normal, uint32_t* packed);
+
+private:
+    // Buffer texture that passes write through transform feedback
+    struct FeedbackBuffer {
+        unsigned int buffer = 0;
+        unsigned int texture = 0;
+        size_t bytes = 0;
+    };
+    
+    void ComputeOnCpu(const Mesh& mesh, const ChunkedColumn<glm::vec3>& positions, float featureAngle);
+    void ComputeOnGpu(Mesh& mesh, float featureAngle);
+    void EnsureShaders();
+    void UploadAdjacency();
+    static void EnsureBuffer(FeedbackBuffer& target, unsigned int format, size_t bytes,
+                             const void* data = nullptr);
+    static void DeleteBuffer(FeedbackBuffer& target);
+
+private:
+    TriangleAdjacency m_Adjacency;
+    bool m_AdjacencyUploaded = false;
+    size_t m_TriangleCount = 0;   // Of the mesh the adjacency was built from
+    size_t m_CornerCount = 0;   // Of the last computation, 0 without
+    
+    // Inputs of the last computation
+    bool m_Deformed = false;
+    size_t m_Frame = 0;
+    unsigned int m_DisplacementBuffer = 0;
+    size_t m_DisplacementOffset = 0;
+    float m_DisplacementScale = 0.0f;
+    float m_FeatureAngle = 0.0f;
+    
+    // CPU scratch, kept between computations
+    std::vector<float> m_X, m_Y, m_Z;
+    std::vector<float> m_NX, m_NY, m_NZ;
+    std::vector<uint32_t> m_Packed;
+    
+    std::unique_ptr<Shader> m_PositionShader;
+    std::unique_ptr<Shader> m_FaceShader;
+    std::unique_ptr<Shader> m_CornerShader;
+    unsigned int m_EmptyVAO = 0;   // Passes over triangles draw without attributes
+    unsigned int m_IndexTexture = 0;   // Over the mesh's index buffer
+    FeedbackBuffer m_Offsets;
+    FeedbackBuffer m_Entries;
+    FeedbackBuffer m_Positions;        // Displaced nodes, RGBA32F
+    FeedbackBuffer m_Faces;            // Face normals, RGBA32F
+    FeedbackBuffer m_Corners;          // What the shader reads, from either path
+};
@@ -0,0 +1,243 @@
+#include "rendering/PartTable.h"
+#include "core/Model.h"
+#include "core/SolidSkin.h"
+#include "utils/ThreadPool.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr size_t kSlotGrainSize = 1u << 16;
+
+std::vector<int> SortedUnique(const ChunkedColumn<int>& column) {
+    std::vector<int> ids;
+    column.CopyTo(ids);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+} // namespace
+
+PartTable::~PartTable() {
+    for (unsigned int buffer : {m_Parts.buffer, m_Materials.buffer, m_ElementBuffer}) {
+        if (buffer) glDeleteBuffers(1, &buffer);
+    }
+    for (unsigned int texture : {m_Parts.texture, m_Materials.texture, m_ElementTexture}) {
+        if (texture) glDeleteTextures(1, &texture);
+    }
+}
+
+size_t PartTable::Table::Find(int id) const {
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    return it != ids.end() && *it == id ? static_cast<size_t>(it - ids.begin()) : ids.size();
+}
+
+void PartTable::Build(const Model& model) {
+    const ElementArrays& elements = model.GetElementArrays();
+    m_Parts.ids = SortedUnique(elements.propertyIds);
+    m_Materials.ids = SortedUnique(elements.materialIds);
+    
+    m_ElementSlots.resize(elements.Size() * 2);
+    ThreadPool::GetGlobal().ParallelFor(elements.Size(), kSlotGrainSize, [&](size_t begin, size_t end) {
+        elements.propertyIds.ForEachSpan(begin, end, [&](const int* ids, size_t count, size_t first) {
+            for (size_t k = 0; k < count; ++k) {
+                m_ElementSlots[(first + k) * 2] = static_cast<uint32_t>(m_Parts.Find(ids[k]));
+            }
+        });
+        elements.materialIds.ForEachSpan(begin, end, [&](const int* ids, size_t count, size_t first) {
+            for (size_t k = 0; k < count; ++k) {
+                m_ElementSlots[(first + k) * 2 + 1] = static_cast<uint32_t>(m_Materials.Find(ids[k]));
+            }
+        });
+    });
+    
+    m_PartHasSolids.assign(m_Parts.ids.size(), 0);
+    for (const ElementBlock& block : elements.blocks) {
+        if (SolidFaceLayout::ForType(block.type)) {
+            for (size_t e = block.firstElement; e < block.EndElement(); ++e) {
+                m_PartHasSolids[m_ElementSlots[e * 2]] = 1;
+            }
+        }
+    }
+    
+    m_Parts.colors.resize(m_Parts.ids.size());
+    for (size_t slot = 0; slot < m_Parts.ids.size(); ++slot) {
+        UpdatePart(slot);
+    }
+    m_Materials.colors.resize(m_Materials.ids.size());
+    for (size_t slot = 0; slot < m_Materials.ids.size(); ++slot) {
+        UpdateMaterial(slot);
+    }
+    m_Built = true;
+    ApplyHighlight(model);
+    m_ElementsDirty = true;
+    LOG_DEBUG("Part table: {} parts, {} materials", m_Parts.ids.size(), m_Materials.ids.size());
+}
+
+void PartTable::Clear() {
+    m_Parts.ids.clear();
+    m_Parts.colors.clear();
+    m_Parts.dirty = true;
+    m_Materials.ids.clear();
+    m_Materials.colors.clear();
+    m_Materials.dirty = true;
+    m_PartHasSolids.clear();
+    m_ElementSlots = std::vector<uint32_t>();
+    m_ElementsDirty = true;
+    m_Built = false;
+}
+
+void PartTable::Reset() {
+    Clear();
+    m_PartColors.clear();
+    m_MaterialColors.clear();
+    m_Hidden.clear();
+    m_Highlighted.clear();
+}
+
+bool PartTable::HasSolids(int partId) const {
+    size_t slot = m_Parts.Find(partId);
+    return slot < m_PartHasSolids.size() && m_PartHasSolids[slot];
+}
+
+void PartTable::SetPartColor(int partId, const glm::vec3& color) {
+    m_PartColors[partId] = color;
+    size_t slot = m_Parts.Find(partId);
+    if (slot < m_Parts.ids.size()) {
+        UpdatePart(slot);
+    }
+}
+
+glm::vec3 PartTable::GetPartColor(int partId) const {
+    auto it = m_PartColors.find(partId);
+    return it != m_PartColors.end() ? it->second : DefaultColor(partId);
+}
+
+void PartTable::SetMaterialColor(int materialId, const glm::vec3& color) {
+    m_MaterialColors[materialId] = color;
+    size_t slot = m_Materials.Find(materialId);
+    if (slot < m_Materials.ids.size()) {
+        UpdateMaterial(slot);
+    }
+}
+
+void PartTable::SetPartVisible(int partId, bool visible) {
+    if (visible) {
+        m_Hidden.erase(partId);
+    } else {
+        m_Hidden.insert(partId);
+    }
+    size_t slot = m_Parts.Find(partId);
+    if (slot < m_Parts.ids.size()) {
+        UpdatePart(slot);
+    }
+}
+
+void PartTable::SetHighlighted(const Model& model, const std::vector<int>& elementIds) {
+    if (elementIds.empty() && m_Highlighted.empty()) {
+        return;
+    }
+    m_Highlighted = elementIds;
+    if (m_Built) {
+        ApplyHighlight(model);
+    }
+}
+
+void PartTable::ApplyHighlight(const Model& model) {
+    // Clearing is a pass over the table; the highlighted few are then looked up
+    const size_t elementCount = m_ElementSlots.size() / 2;
+    ThreadPool::GetGlobal().ParallelFor(elementCount, kSlotGrainSize, [&](size_t begin, size_t end) {
+        for (size_t e = begin; e < end; ++e) {
+            m_ElementSlots[e * 2 + 1] &= ~kHighlightBit;
+        }
+    });
+    for (int id : m_Highlighted) {
+        size_t index = model.FindElementIndex(id);
+        if (index < elementCount) {
+            m_ElementSlots[index * 2 + 1] |= kHighlightBit;
+        }
+    }
+    m_ElementsDirty = true;
+}
+
+void PartTable::Bind() {
+    if (m_ElementsDirty) {
+        Upload(m_ElementBuffer, m_ElementTexture, GL_RG32UI, m_ElementSlots.data(),
+               m_ElementSlots.size() * sizeof(uint32_t));
+        m_ElementsDirty = false;
+    }
+    for (Table* table : {&m_Parts, &m_Materials}) {
+        if (table->dirty) {
+            Upload(table->buffer, table->texture, GL_RGBA8, table->colors.data(),
+                   table->colors.size() * sizeof(uint32_t));
+            table->dirty = false;
+        }
+    }
+    
+    glActiveTexture(GL_TEXTURE0 + kElementSlotUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_ElementTexture);
+    glActiveTexture(GL_TEXTURE0 + kPartColorUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_Parts.texture);
+    glActiveTexture(GL_TEXTURE0 + kMaterialColorUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_Materials.texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+glm::vec3 PartTable::DefaultColor(int id) {
+    // Golden-ratio steps around the hue circle keep neighbouring IDs apart
+    const uint32_t turn = static_cast<uint32_t>(id) * 2654435769u;
+    float hue = static_cast<float>(turn >> 8) / static_cast<float>(1u << 24) * 6.0f;
+    const float saturation = 0.55f;
+    const float value = 0.9f;
+    float f = hue - std::floor(hue);
+    float p = value * (1.0f - saturation);
+    float q = value * (1.0f - saturation * f);
+    float t = value * (1.0f - saturation * (1.0f - f));
+    switch (static_cast<int>(hue) % 6) {
+        case 0:  return glm::vec3(value, t, p);
+        case 1:  return glm::vec3(q, value, p);
+        case 2:  return glm::vec3(p, value, t);
+        case 3:  return glm::vec3(p, q, value);
+        case 4:  return glm::vec3(t, p, value);
+        default: return glm::vec3(value, p, q);
+    }
+}
+
+uint32_t PartTable::Pack(const glm::vec3& color, bool visible) {
+    auto channel = [](float c) {
+        return static_cast<uint32_t>(std::lround(std::min(std::max(c, 0.0f), 1.0f) * 255.0f));
+    };
+    // Memory order r, g, b, a, as GL_RGBA8 reads it
+    return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) |
+           (visible ? 0xFF000000u : 0u);
+}
+
+void PartTable::UpdatePart(size_t slot) {
+    const int id = m_Parts.ids[slot];
+    m_Parts.colors[slot] = Pack(GetPartColor(id), IsPartVisible(id));
+    m_Parts.dirty = true;
+}
+
+void PartTable::UpdateMaterial(size_t slot) {
+    const int id = m_Materials.ids[slot];
+    auto it = m_MaterialColors.find(id);
+    m_Materials.colors[slot] = Pack(it != m_MaterialColors.end() ? it->second : DefaultColor(id), true);
+    m_Materials.dirty = true;
+}
+
+void PartTable::Upload(unsigned int& buffer, unsigned int& texture, unsigned int format,
+                       const void* data, size_t bytes) {
+    if (!buffer) glGenBuffers(1, &buffer);
+    if (!texture) glGenTextures(1, &texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, bytes ? data : nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    
+    // An empty table is left without storage, which reads as size zero
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, bytes ? buffer : 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
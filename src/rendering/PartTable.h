@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Model;
+
+// How parts (property IDs) and materials look, held on the GPU so that
+// recolouring, hiding or isolating a part rewrites a small table instead of
+// rebuilding the mesh. Every element maps to a part slot and a material
+// slot through a buffer texture built once per model; the slots index two
+// buffer textures of RGBA8 colours, with a part's visibility in alpha.
+// Shaders reach an element through the mesh's primitive tags (see Mesh).
+//
+// Colours and visibility are kept by ID, so they survive rebuilds for an
+// edited model. Render thread only.
+class PartTable {
+public:
+    static constexpr unsigned int kElementSlotUnit = 1;     // usamplerBuffer, RG32UI
+    static constexpr unsigned int kPartColorUnit = 2;       // samplerBuffer, RGBA8
+    static constexpr unsigned int kMaterialColorUnit = 3;   // samplerBuffer, RGBA8
+    static constexpr uint32_t kHighlightBit = 0x80000000u;  // Set in a highlighted element's material slot
+    
+    PartTable() = default;
+    ~PartTable();
+    
+    PartTable(const PartTable&) = delete;
+    PartTable& operator=(const PartTable&) = delete;
+    
+    void Build(const Model& model);
+    
+    // Clear unmaps the elements, e.g. while another model streams in, so
+    // everything draws in the default look; Reset also forgets colours and
+    // visibility, for a new model
+    void Clear();
+    void Reset();
+    bool IsBuilt() const { return m_Built; }
+    
+    const std::vector<int>& GetPartIds() const { return m_Parts.ids; }   // Sorted
+    bool HasSolids(int partId) const;   // Hiding those changes the solid skin
+    
+    void SetPartColor(int partId, const glm::vec3& color);
+    glm::vec3 GetPartColor(int partId) const;
+    void SetMaterialColor(int materialId, const glm::vec3& color);
+    void SetPartVisible(int partId, bool visible);
+    bool IsPartVisible(int partId) const { return m_Hidden.count(partId) == 0; }
+    
+    // Elements drawn in the highlight colour, by ID so they survive
+    // rebuilds; an empty list clears them
+    void SetHighlighted(const Model& model, const std::vector<int>& elementIds);
+    const std::vector<int>& GetHighlighted() const { return m_Highlighted; }
+    
+    // Uploads changed tables and binds the textures to their units
+    void Bind();
+
+private:
+    struct Table {
+        std::vector<int> ids;             // Slot to ID, sorted
+        std::vector<uint32_t> colors;     // Packed RGBA8 per slot
+        unsigned int buffer = 0;
+        unsigned int texture = 0;
+        bool dirty = false;
+        
+        size_t Find(int id) const;        // Slot of an ID, or ids.size()
+    };
+    
+    static glm::vec3 DefaultColor(int id);
+    static uint32_t Pack(const glm::vec3& color, bool visible);
+    void UpdatePart(size_t slot);
+    void UpdateMaterial(size_t slot);
+    void ApplyHighlight(const Model& model);
+    static void Upload(unsigned int& buffer, unsigned int& texture, unsigned int format,
+                       const void* data, size_t bytes);
+
+private:
+    Table m_Parts;
+    Table m_Materials;
+    std::vector<char> m_PartHasSolids;    // Per part slot
+    std::vector<uint32_t> m_ElementSlots; // Part and material slot per element
+    bool m_ElementsDirty = false;
+    unsigned int m_ElementBuffer = 0;
+    unsigned int m_ElementTexture = 0;
+    bool m_Built = false;
+    
+    std::unordered_map<int, glm::vec3> m_PartColors;       // Set by the user
+    std::unordered_map<int, glm::vec3> m_MaterialColors;
+    std::unordered_set<int> m_Hidden;
+    std::vector<int> m_Highlighted;   // Element IDs
+};
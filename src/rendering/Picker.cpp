@@ -0,0 +1,263 @@
+#include "rendering/Picker.h"
+#include "utils/Logger.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+
+Picker::~Picker() {
+    Cancel();
+    for (Slot& slot : m_Slots) {
+        if (slot.buffer) glDeleteBuffers(1, &slot.buffer);
+    }
+    if (m_Framebuffer) glDeleteFramebuffers(1, &m_Framebuffer);
+    if (m_ColorTarget) glDeleteTextures(1, &m_ColorTarget);
+    if (m_DepthTarget) glDeleteRenderbuffers(1, &m_DepthTarget);
+}
+
+uint64_t Picker::Request(const PickRegion& region) {
+    if (region.transient && !m_Waiting.empty() && m_Waiting.back().region.transient) {
+        m_Waiting.pop_back();
+    }
+    uint64_t request = m_NextRequest++;
+    m_Waiting.push_back({request, region});
+    return request;
+}
+
+void Picker::Cancel() {
+    m_Waiting.clear();
+    for (Slot& slot : m_Slots) {
+        if (slot.fence) glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+        slot.busy = false;
+    }
+}
+
+bool Picker::BeginPass(int framebufferWidth, int framebufferHeight, glm::mat4& regionMatrix) {
+    if (m_Waiting.empty()) {
+        return false;
+    }
+    int free = -1;
+    for (int s = 0; s < kReadbackSlots && free < 0; ++s) {
+        if (!m_Slots[s].busy) {
+            free = s;
+        }
+    }
+    if (free < 0) {
+        return false;
+    }
+    
+    Waiting waiting = std::move(m_Waiting.front());
+    m_Waiting.pop_front();
+    Slot& slot = m_Slots[free];
+    slot.busy = true;
+    slot.request = waiting.request;
+    slot.region = std::move(waiting.region);
+    
+    // Only what is on screen can be picked; an empty region finishes with
+    // no hits without drawing
+    PickRegion& region = slot.region;
+    int left = std::clamp(region.x, 0, framebufferWidth);
+    int right = std::clamp(region.x + region.width, 0, framebufferWidth);
+    int top = std::clamp(region.y, 0, framebufferHeight);
+    int bottom = std::clamp(region.y + region.height, 0, framebufferHeight);
+    region.x = left;
+    region.y = top;
+    region.width = std::max(0, right - left);
+    region.height = std::max(0, bottom - top);
+    if (region.width == 0 || region.height == 0) {
+        return false;
+    }
+    
+    glGetIntegerv(GL_VIEWPORT, m_SavedViewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_SavedFramebuffer);
+    EnsureTarget(region.width, region.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+    glViewport(0, 0, region.width, region.height);
+    const GLuint zero[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, zero);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    
+    // Scales the region, centred, onto the whole of clip space
+    const float width = static_cast<float>(region.width);
+    const float height = static_cast<float>(region.height);
+    const float centreX = left + width * 0.5f;
+    const float centreY = (framebufferHeight - bottom) + height * 0.5f;
+    regionMatrix = glm::mat4(1.0f);
+    regionMatrix[0][0] = framebufferWidth / width;
+    regionMatrix[1][1] = framebufferHeight / height;
+    regionMatrix[3][0] = (framebufferWidth - 2.0f * centreX) / width;
+    regionMatrix[3][1] = (framebufferHeight - 2.0f * centreY) / height;
+    
+    m_Drawing = free;
+    return true;
+}
+
+void Picker::EndPass() {
+    if (m_Drawing < 0) {
+        return;
+    }
+    Slot& slot = m_Slots[m_Drawing];
+    m_Drawing = -1;
+    
+    const size_t bytes = static_cast<size_t>(slot.region.width) * slot.region.height * 2 * sizeof(uint32_t);
+    if (!slot.buffer) glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, slot.region.width, slot.region.height, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, m_SavedFramebuffer);
+    glViewport(m_SavedViewport[0], m_SavedViewport[1], m_SavedViewport[2], m_SavedViewport[3]);
+}
+
+bool Picker::Poll(PickHits& hits) {
+    // Picks finish in the order they were requested
+    int oldest = -1;
+    for (int s = 0; s < kReadbackSlots; ++s) {
+        if (m_Slots[s].busy && s != m_Drawing &&
+            (oldest < 0 || m_Slots[s].request < m_Slots[oldest].request)) {
+            oldest = s;
+        }
+    }
+    if (oldest < 0) {
+        return false;
+    }
+    Slot& slot = m_Slots[oldest];
+    if (slot.fence) {
+        GLenum status = glClientWaitSync(static_cast<GLsync>(slot.fence), 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+    }
+    
+    hits = PickHits();
+    hits.request = slot.request;
+    if (slot.region.width > 0 && slot.region.height > 0) {
+        const size_t bytes = static_cast<size_t>(slot.region.width) * slot.region.height * 2 * sizeof(uint32_t);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (pixels) {
+            Resolve(slot, static_cast<const uint32_t*>(pixels), hits);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    slot.busy = false;
+    return true;
+}
+
+bool Picker::IsBusy() const {
+    if (!m_Waiting.empty()) {
+        return true;
+    }
+    for (const Slot& slot : m_Slots) {
+        if (slot.busy) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Picker::EnsureTarget(int width, int height) {
+    if (m_Framebuffer && width <= m_TargetWidth && height <= m_TargetHeight) {
+        return;
+    }
+    m_TargetWidth = std::max(width, m_TargetWidth);
+    m_TargetHeight = std::max(height, m_TargetHeight);
+    
+    if (!m_Framebuffer) glGenFramebuffers(1, &m_Framebuffer);
+    if (!m_ColorTarget) glGenTextures(1, &m_ColorTarget);
+    if (!m_DepthTarget) glGenRenderbuffers(1, &m_DepthTarget);
+    
+    glBindTexture(GL_TEXTURE_2D, m_ColorTarget);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, m_TargetWidth, m_TargetHeight, 0,
+                 GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glBindRenderbuffer(GL_RENDERBUFFER, m_DepthTarget);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_TargetWidth, m_TargetHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorTarget, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthTarget);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR("Pick target {}x{} is incomplete", m_TargetWidth, m_TargetHeight);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, m_SavedFramebuffer);
+}
+
+void Picker::Resolve(const Slot& slot, const uint32_t* pixels, PickHits& hits) {
+    const PickRegion& region = slot.region;
+    const glm::vec2 centre(region.x + region.width * 0.5f, region.y + region.height * 0.5f);
+    float triangleDistance = 0.0f;
+    float nodeDistance = 0.0f;
+    
+    // Rows come bottom up; a lasso is filled span by span with the even-odd rule
+    std::vector<float> crossings;
+    for (int row = 0; row < region.height; ++row) {
+        const float y = region.y + (region.height - 1 - row) + 0.5f;
+        crossings.clear();
+        if (region.lasso.size() >= 3) {
+            for (size_t k = 0; k < region.lasso.size(); ++k) {
+                const glm::vec2& a = region.lasso[k];
+                const glm::vec2& b = region.lasso[(k + 1) % region.lasso.size()];
+                if ((a.y <= y) != (b.y <= y)) {
+                    crossings.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+        } else {
+            crossings = {static_cast<float>(region.x), static_cast<float>(region.x + region.width)};
+        }
+        
+        const uint32_t* line = pixels + static_cast<size_t>(row) * region.width * 2;
+        for (size_t span = 0; span + 1 < crossings.size(); span += 2) {
+            int first = std::max(0, static_cast<int>(std::ceil(crossings[span] - 0.5f)) - region.x);
+            int last = std::min(region.width, static_cast<int>(std::ceil(crossings[span + 1] - 0.5f)) - region.x);
+            for (int column = first; column < last; ++column) {
+                const uint32_t triangle = line[column * 2];
+                const uint32_t node = line[column * 2 + 1];
+                if (triangle == 0 && node == 0) {
+                    continue;
+                }
+                const glm::vec2 offset = glm::vec2(region.x + column + 0.5f, y) - centre;
+                const float distance = offset.x * offset.x + offset.y * offset.y;
+                
+                // Neighbouring pixels mostly repeat the last one
+                if (triangle != 0) {
+                    if (hits.triangles.empty() || hits.triangles.back() != triangle - 1) {
+                        hits.triangles.push_back(triangle - 1);
+                    }
+                    if (hits.centreTriangle == PickHits::kNone || distance < triangleDistance) {
+                        hits.centreTriangle = triangle - 1;
+                        triangleDistance = distance;
+                    }
+                }
+                if (node != 0) {
+                    if (hits.nodes.empty() || hits.nodes.back() != node - 1) {
+                        hits.nodes.push_back(node - 1);
+                    }
+                    if (hits.centreNode == PickHits::kNone || distance < nodeDistance) {
+                        hits.centreNode = node - 1;
+                        nodeDistance = distance;
+                    }
+                }
+            }
+        }
+    }
+    
+    for (std::vector<uint32_t>* list : {&hits.triangles, &hits.nodes}) {
+        std::sort(list->begin(), list->end());
+        list->erase(std::unique(list->begin(), list->end()), list->end());
+    }
+}
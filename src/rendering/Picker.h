@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Part of the framebuffer to pick from, in pixels from its top-left corner
+// like cursor positions. A lasso is a closed polygon in the same pixels
+// that the rectangle bounds; without one the whole rectangle is picked.
+struct PickRegion {
+    int x = 0;
+    int y = 0;
+    int width = 1;
+    int height = 1;
+    std::vector<glm::vec2> lasso;
+    bool transient = false;   // Hovering: a newer transient pick replaces it while it waits
+};
+
+// What a finished pick saw, each index once and sorted: absolute triangle
+// numbers of the mesh and node indices. The centre hits are the ones
+// nearest the region's centre, for hovering.
+struct PickHits {
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+    
+    uint64_t request = 0;
+    std::vector<uint32_t> triangles;
+    std::vector<uint32_t> nodes;
+    uint32_t centreTriangle = kNone;
+    uint32_t centreNode = kNone;
+};
+
+// A pick resolved against the model: IDs of the elements and nodes seen,
+// each once, and of those nearest the region's centre when there are any
+struct PickResult {
+    uint64_t request = 0;
+    std::vector<int> elementIds;
+    std::vector<int> nodeIds;
+    bool hasCentreElement = false;
+    bool hasCentreNode = false;
+    int centreElementId = 0;
+    int centreNodeId = 0;
+};
+
+// On-demand picking through an ID buffer. A requested region is drawn on
+// its own by the caller into a small RG32UI target (triangle number + 1,
+// node index + 1), through a projection that maps just the region onto
+// it, so culling leaves only the chunks under it. The target is copied
+// into a pixel buffer and a fence placed; Poll maps the buffer once the
+// fence has passed, so neither drawing nor reading ever waits on the GPU.
+// Up to kReadbackSlots picks are in flight; further requests wait, and a
+// transient one is replaced by the next. Render thread only.
+class Picker {
+public:
+    static constexpr int kReadbackSlots = 2;
+    
+    Picker() = default;
+    ~Picker();
+    
+    Picker(const Picker&) = delete;
+    Picker& operator=(const Picker&) = delete;
+    
+    // Returns the number the hits will carry
+    uint64_t Request(const PickRegion& region);
+    
+    // Drops waiting and unfinished picks, e.g. once the mesh was rebuilt
+    void Cancel();
+    
+    // Starts drawing the oldest waiting pick when a readback slot is free:
+    // binds and clears the target and sets its viewport. regionMatrix is to
+    // be applied after the projection. Returns false when there is nothing
+    // to draw this frame.
+    bool BeginPass(int framebufferWidth, int framebufferHeight, glm::mat4& regionMatrix);
+    
+    // Starts the readback of what was drawn and restores the framebuffer
+    void EndPass();
+    
+    // Hits of the oldest finished pick; false when none has finished
+    bool Poll(PickHits& hits);
+    
+    // Whether picks are waiting to be drawn or read back
+    bool IsBusy() const;
+
+private:
+    struct Waiting {
+        uint64_t request;
+        PickRegion region;
+    };
+    
+    struct Slot {
+        bool busy = false;
+        uint64_t request = 0;
+        PickRegion region;          // Clamped to the framebuffer
+        unsigned int buffer = 0;    // Pixel pack buffer
+        size_t capacity = 0;        // Bytes allocated
+        void* fence = nullptr;      // GLsync after the readback
+    };
+    
+    void EnsureTarget(int width, int height);
+    static void Resolve(const Slot& slot, const uint32_t* pixels, PickHits& hits);
+
+private:
+    std::deque<Waiting> m_Waiting;
+    uint64_t m_NextRequest = 1;
+    
+    Slot m_Slots[kReadbackSlots];
+    int m_Drawing = -1;   // Slot between BeginPass and EndPass
+    int m_SavedViewport[4] = {};
+    int m_SavedFramebuffer = 0;
+    
+    unsigned int m_Framebuffer = 0;
+    unsigned int m_ColorTarget = 0;
+    unsigned int m_DepthTarget = 0;
+    int m_TargetWidth = 0;
+    int m_TargetHeight = 0;
+};
@@ -0,0 +1,217 @@
+#include "rendering/ProgramCache.h"
+#include <GL/glew.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+namespace {
+
+// Bump whenever the layout below changes; older binaries are then ignored
+constexpr uint32_t kCacheVersion = 1;
+constexpr char kCacheMagic[4] = {'R', 'A', 'D', 'P'};
+
+// Larger blobs are taken as a corrupt file rather than allocated
+constexpr uint64_t kMaxBinarySize = 64 * 1024 * 1024;
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;     // As glGetProgramBinary reported it
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t driverHash;
+    uint64_t length;     // Of the binary that follows
+};
+
+static_assert(std::is_trivially_copyable<BinaryHeader>::value, "header must be flat");
+
+// FNV-1a; keys are short, so speed does not matter
+constexpr uint64_t kOffsetBasis = 0xCBF29CE484222325ull;
+constexpr uint64_t kPrime = 0x100000001B3ull;
+
+uint64_t HashBytes(const char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * kPrime;
+    }
+    return hash;
+}
+
+// Inputs are hashed with their lengths, so moving text from one to the
+// next changes the key
+uint64_t HashString(const std::string& text, uint64_t hash) {
+    uint64_t length = text.size();
+    hash = HashBytes(reinterpret_cast<const char*>(&length), sizeof(length), hash);
+    return HashBytes(text.data(), text.size(), hash);
+}
+
+struct CacheState {
+    std::string directory = "cache/shaders";
+    bool probed = false;
+    bool supported = false;
+    uint64_t driverHash = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+CacheState& GetState() {
+    static CacheState state;
+    return state;
+}
+
+} // namespace
+
+void ProgramCache::SetDirectory(const std::string& directory) {
+    GetState().directory = directory;
+}
+
+const std::string& ProgramCache::GetDirectory() {
+    return GetState().directory;
+}
+
+bool ProgramCache::IsSupported() {
+    CacheState& state = GetState();
+    if (!state.probed) {
+        state.probed = true;
+        GLint formats = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        state.supported = formats > 0;
+    }
+    return state.supported && !state.directory.empty();
+}
+
+uint64_t ProgramCache::GetDriverHash() {
+    // One driver per process: the first context's stands for all
+    CacheState& state = GetState();
+    if (state.driverHash == 0) {
+        uint64_t hash = kOffsetBasis;
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            const char* text = reinterpret_cast<const char*>(glGetString(name));
+            hash = HashString(text ? text : "", hash);
+        }
+        state.driverHash = hash;
+    }
+    return state.driverHash;
+}
+
+uint64_t ProgramCache::MakeKey(const std::vector<std::string>& inputs) {
+    uint64_t hash = HashBytes(reinterpret_cast<const char*>(&kCacheVersion), sizeof(kCacheVersion),
+                              kOffsetBasis);
+    for (const std::string& input : inputs) {
+        hash = HashString(input, hash);
+    }
+    uint64_t driver = GetDriverHash();
+    return HashBytes(reinterpret_cast<const char*>(&driver), sizeof(driver), hash);
+}
+
+std::string ProgramCache::GetPath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(GetState().directory) / name).string();
+}
+
+bool ProgramCache::Load(uint64_t key, unsigned int program) {
+    CacheState& state = GetState();
+    if (!IsSupported()) {
+        return false;
+    }
+    
+    const std::string path = GetPath(key);
+    std::ifstream file(path, std::ios::binary);
+    BinaryHeader header;
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.version != kCacheVersion || header.key != key || header.driverHash != GetDriverHash() ||
+        header.length == 0 || header.length > kMaxBinarySize) {
+        ++state.misses;
+        return false;
+    }
+    std::vector<char> binary(static_cast<size_t>(header.length));
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) {
+        ++state.misses;
+        return false;
+    }
+    file.close();
+    
+    // The driver has the last word; a binary it turns down is not tried again
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        std::remove(path.c_str());
+        ++state.misses;
+        return false;
+    }
+    ++state.hits;
+    return true;
+}
+
+void ProgramCache::PrepareProgram(unsigned int program) {
+    if (IsSupported()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ProgramCache::Store(uint64_t key, unsigned int program) {
+    if (!IsSupported()) {
+        return false;
+    }
+    GLint linked = GL_FALSE, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0) {
+        return false;
+    }
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return false;
+    }
+    
+    BinaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.format = format;
+    header.key = key;
+    header.driverHash = GetDriverHash();
+    header.length = static_cast<uint64_t>(written);
+    
+    // Write beside the final name and rename, so readers never see half a file
+    std::error_code error;
+    std::filesystem::create_directories(GetState().directory, error);
+    const std::string path = GetPath(key);
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) {
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+size_t ProgramCache::GetHitCount() {
+    return GetState().hits;
+}
+
+size_t ProgramCache::GetMissCount() {
+    return GetState().misses;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Linked program binaries kept between runs (glGetProgramBinary), so a
+// start skips compiling and linking. A binary is keyed on everything that
+// went into the program and on the driver that built it, one file each
+// under the directory; a driver that rejects one, say after an update,
+// leaves the caller to compile and store it anew. Without
+// ARB_get_program_binary, or with no binary formats, nothing is cached.
+//
+// Render thread only, with a context current. Logs nothing, so the
+// standalone viewer links it on its own.
+class ProgramCache {
+public:
+    // Created when the first binary is stored; empty turns the cache off
+    static void SetDirectory(const std::string& directory);
+    static const std::string& GetDirectory();
+    
+    static bool IsSupported();
+    
+    // Key of a program from its inputs: stage sources, feedback varyings,
+    // anything else that changes the binary
+    static uint64_t MakeKey(const std::vector<std::string>& inputs);
+    
+    // Loads the binary into a program that has no stages attached; false
+    // when there is none or the driver rejects it, in which case the
+    // program should be deleted and built from source
+    static bool Load(uint64_t key, unsigned int program);
+    
+    // Before linking, so the driver keeps a binary to hand out
+    static void PrepareProgram(unsigned int program);
+    
+    // After a successful link; a failed one is not stored
+    static bool Store(uint64_t key, unsigned int program);
+    
+    // Hits and misses of this run, for the startup log
+    static size_t GetHitCount();
+    static size_t GetMissCount();
+
+private:
+    static std::string GetPath(uint64_t key);
+    static uint64_t GetDriverHash();
+};
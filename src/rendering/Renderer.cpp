@@ -2,17 +2,34 @@
 #include "rendering/Camera.h"
 #include "rendering/Shader.h"
 #include "rendering/Mesh.h"
+#include "rendering/Frustum.h"
+#include "rendering/AnimationStream.h"
+#include "rendering/Picker.h"
+#include "rendering/PartTable.h"
+#include "rendering/NormalGenerator.h"
+#include "rendering/ProgramCache.h"
+#include "rendering/GpuTimer.h"
+#include "io/ResultCache.h"
 #include "core/Model.h"
+#include "core/SolidSkin.h"
+#include <algorithm>
+#include <cmath>
 #include "utils/Logger.h"
+#include "utils/Profiler.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 Renderer::Renderer(GLFWwindow* window) 
-    : m_Window(window), m_NodeVAO(0), m_NodeVBO(0),
+    : m_Window(window), m_FrameUBO(0), m_PartsOutdated(true),
+      m_ContourOutdated(true), m_ContourUploaded(false), m_ContourState(0), m_ContourField(0),
+      m_NormalsOutdated(true), m_NodeVAO(0), m_NodeVBO(0),
       m_WireVAO(0), m_WireVBO(0), m_WireEBO(0),
-      m_SolidVAO(0), m_SolidVBO(0), m_SolidEBO(0) {
+      m_SolidVAO(0), m_SolidVBO(0), m_SolidEBO(0), m_CapVAO(0),
+      m_TargetFramebuffer(0), m_TargetWidth(1), m_TargetHeight(1),
+      m_FramebufferWidth(0), m_FramebufferHeight(0), m_Interactive(false), m_FrameScale(1.0f),
+      m_SceneFBO(0), m_SceneColor(0), m_SceneDepth(0), m_SceneWidth(0), m_SceneHeight(0) {
     Initialize();
 }
 
@@ -22,7 +39,7 @@ Renderer::~Renderer() {
 
 void Renderer::Initialize() {
     // Initialize GLEW
-    if (glewInit() != GLEW_OK) {
+    if (m_Window && glewInit() != GLEW_OK) {
         throw std::runtime_error("Failed to initialize GLEW");
     }
     
@@ -33,15 +50,27 @@ void Renderer::Initialize() {
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
     
     // Create camera
-    int width, height;
-    glfwGetWindowSize(m_Window, &width, &height);
+    int width = m_TargetWidth, height = m_TargetHeight;
+    if (m_Window) {
+        glfwGetWindowSize(m_Window, &width, &height);
+    }
     m_Camera = std::make_unique<Camera>(width, height);
     
     // Setup shaders
     SetupShaders();
+    if (ProgramCache::IsSupported()) {
+        LOG_INFO("Shader programs: {} from the cache, {} compiled",
+                 ProgramCache::GetHitCount(), ProgramCache::GetMissCount());
+    }
     
     // Create mesh object
     m_Mesh = std::make_unique<Mesh>();
+    m_Skin = std::make_unique<SolidSkin>();
+    m_Picker = std::make_unique<Picker>();
+    m_Parts = std::make_unique<PartTable>();
+    m_Contour = std::make_unique<ContourPlot>();
+    m_Normals = std::make_unique<NormalGenerator>();
+    m_GpuTimer = std::make_unique<GpuTimer>();
     
     LOG_INFO("Renderer initialized");
 }
@@ -51,12 +80,123 @@ void Renderer::SetupShaders() {
     m_BasicShader = std::make_unique<Shader>(
         "shaders/basic.vert", "shaders/basic.frag");
     
-    // Phong shader for solid rendering
+    // Phong shader for solid rendering, with smooth normals per triangle corner
     m_PhongShader = std::make_unique<Shader>(
-        "shaders/phong.vert", "shaders/phong.frag");
+        "shaders/phong.vert", "shaders/phong.geom", "shaders/phong.frag");
+    
+    // Picking and section caps are built when first needed, so a start
+    // only waits for the programs of its first frame
+    
+    m_BasicColor = m_BasicShader->GetUniform<glm::vec3>("color");
+    m_BasicUsePartTable = m_BasicShader->GetUniform<bool>("usePartTable");
+    m_BasicHighlightColor = m_BasicShader->GetUniform<glm::vec3>("highlightColor");
+    m_PhongObjectColor = m_PhongShader->GetUniform<glm::vec3>("objectColor");
+    m_PhongColorMode = m_PhongShader->GetUniform<int>("colorMode");
+    m_PhongHighlightColor = m_PhongShader->GetUniform<glm::vec3>("highlightColor");
+    m_PhongContourNodal = m_PhongShader->GetUniform<bool>("contourNodal");
+    m_PhongContourAutoRange = m_PhongShader->GetUniform<bool>("contourAutoRange");
+    m_PhongContourLimits = m_PhongShader->GetUniform<glm::vec2>("contourLimits");
+    m_PhongContourBands = m_PhongShader->GetUniform<int>("contourBands");
+    
+    // Samplers keep their texture units for good
+    SetTableSamplers(*m_BasicShader);
+    SetTableSamplers(*m_PhongShader);
+    m_PhongShader->Use();
+    m_PhongShader->Set(m_PhongShader->GetUniform<int>("elementValues"), static_cast<int>(ContourPlot::kElementValueUnit));
+    m_PhongShader->Set(m_PhongShader->GetUniform<int>("nodeValues"), static_cast<int>(ContourPlot::kNodeValueUnit));
+    m_PhongShader->Set(m_PhongShader->GetUniform<int>("contourRange"), static_cast<int>(ContourPlot::kRangeUnit));
+    m_PhongShader->Set(m_PhongShader->GetUniform<int>("colormap"), static_cast<int>(ContourPlot::kColormapUnit));
+    m_PhongShader->Set(m_PhongShader->GetUniform<int>("cornerNormals"), static_cast<int>(NormalGenerator::kCornerNormalUnit));
+    glUseProgram(0);
+    
+    // Camera and light go to every program through one buffer, once a frame
+    glGenBuffers(1, &m_FrameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_FrameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, Shader::kFrameBinding, m_FrameUBO);
+}
+
+void Renderer::SetTableSamplers(Shader& shader) {
+    shader.Use();
+    shader.Set(shader.GetUniform<int>("primitiveElements"), static_cast<int>(Mesh::kPrimitiveElementUnit));
+    shader.Set(shader.GetUniform<int>("elementSlots"), static_cast<int>(PartTable::kElementSlotUnit));
+    shader.Set(shader.GetUniform<int>("partColors"), static_cast<int>(PartTable::kPartColorUnit));
+    shader.Set(shader.GetUniform<int>("materialColors"), static_cast<int>(PartTable::kMaterialColorUnit));
+}
+
+void Renderer::EnsurePickShader() {
+    if (m_PickShader) {
+        return;
+    }
+    
+    // Integer IDs for picking
+    m_PickShader = std::make_unique<Shader>(
+        "shaders/pick.vert", "shaders/pick.frag");
+    m_PickRegion = m_PickShader->GetUniform<glm::mat4>("region");
+    m_PickNodes = m_PickShader->GetUniform<bool>("pickNodes");
+    SetTableSamplers(*m_PickShader);
+}
+
+void Renderer::EnsureCapShader() {
+    if (m_CapShader) {
+        return;
+    }
+    
+    // Section caps, drawn from no vertex data
+    m_CapShader = std::make_unique<Shader>(
+        "shaders/cap.vert", "shaders/cap.frag");
+    m_CapOrigin = m_CapShader->GetUniform<glm::vec3>("capOrigin");
+    m_CapAxisU = m_CapShader->GetUniform<glm::vec3>("capAxisU");
+    m_CapAxisV = m_CapShader->GetUniform<glm::vec3>("capAxisV");
+    m_CapColor = m_CapShader->GetUniform<glm::vec3>("capColor");
+    m_CapNormal = m_CapShader->GetUniform<glm::vec3>("capNormal");
+    glGenVertexArrays(1, &m_CapVAO);
+}
+
+void Renderer::UploadFrameUniforms() {
+    FrameUniforms frame;
+    frame.view = m_Camera->GetViewMatrix();
+    frame.projection = m_Camera->GetProjectionMatrix();
+    frame.cameraPosition = glm::vec4(m_Camera->GetPosition(), 1.0f);
+    frame.lightColor = glm::vec4(1.0f);
+    frame.displacementScale = GetDisplacementScale();
+    for (int i = 0; i < kMaxClipPlanes; ++i) {
+        const ClipPlane& plane = m_Settings.clipPlanes[i];
+        if (plane.enabled && glm::dot(plane.normal, plane.normal) > 0.0f) {
+            frame.clipPlanes[i] = glm::vec4(glm::normalize(plane.normal), -plane.offset);
+        }
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, m_FrameUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void Renderer::BeginFrame() {
+    m_GpuTimer->BeginFrame();
+    
+    // The projection follows the window; interactive frames draw smaller
+    if (m_Window) {
+        glfwGetFramebufferSize(m_Window, &m_FramebufferWidth, &m_FramebufferHeight);
+    } else {
+        m_FramebufferWidth = m_TargetWidth;
+        m_FramebufferHeight = m_TargetHeight;
+    }
+    if (m_FramebufferWidth > 0 && m_FramebufferHeight > 0) {
+        m_Camera->SetAspectRatio(static_cast<float>(m_FramebufferWidth) / static_cast<float>(m_FramebufferHeight));
+    }
+    m_FrameScale = 1.0f;
+    if (m_Interactive && m_Settings.interactiveScale < 1.0f && m_FramebufferWidth > 0 && m_FramebufferHeight > 0) {
+        m_FrameScale = std::max(m_Settings.interactiveScale, 0.1f);
+        EnsureSceneTarget(std::max(1, static_cast<int>(m_FramebufferWidth * m_FrameScale)),
+                          std::max(1, static_cast<int>(m_FramebufferHeight * m_FrameScale)));
+        glBindFramebuffer(GL_FRAMEBUFFER, m_SceneFBO);
+        glViewport(0, 0, m_SceneWidth, m_SceneHeight);
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_TargetFramebuffer);
+        glViewport(0, 0, m_FramebufferWidth, m_FramebufferHeight);
+    }
+    
     glClearColor(m_Settings.backgroundColor.r, 
                  m_Settings.backgroundColor.g,
                  m_Settings.backgroundColor.b, 1.0f);
@@ -64,20 +204,138 @@ void Renderer::BeginFrame() {
 }
 
 void Renderer::EndFrame() {
-    // Nothing specific needed here
+    m_GpuTimer->EndFrame();
+    Mesh* mesh = GetActiveMesh();
+    if (Profiler::IsEnabled()) {
+        Profiler& profiler = Profiler::Get();
+        const MeshDrawStats& stats = mesh->GetDrawStats();
+        profiler.SetCounter("Draw calls", static_cast<double>(stats.calls));
+        profiler.SetCounter("Draws", static_cast<double>(stats.commands));
+        profiler.SetCounter("Triangles", static_cast<double>(stats.triangles));
+        profiler.SetCounter("Lines", static_cast<double>(stats.lines));
+        profiler.SetCounter("Points", static_cast<double>(stats.points));
+        
+        size_t bytes = m_Mesh->GetGpuBytes() + (m_StreamingMesh ? m_StreamingMesh->GetGpuBytes() : 0);
+        profiler.SetCounter("Mesh buffers (MB)", static_cast<double>(bytes) / (1024.0 * 1024.0));
+#ifdef GL_NVX_gpu_memory_info
+        // All of the device's, where the driver tells
+        if (GLEW_NVX_gpu_memory_info) {
+            GLint total = 0, available = 0;
+            glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+            profiler.SetCounter("VRAM used (MB)", static_cast<double>(total - available) / 1024.0);
+        }
+#endif
+    }
+    mesh->ResetDrawStats();
+}
+
+void Renderer::PresentScene() {
+    if (m_FrameScale >= 1.0f) {
+        return;
+    }
+    GpuTimer::Pass pass(*m_GpuTimer, "Present");
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_SceneFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_TargetFramebuffer);
+    glBlitFramebuffer(0, 0, m_SceneWidth, m_SceneHeight, 0, 0, m_FramebufferWidth, m_FramebufferHeight,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_TargetFramebuffer);
+    glViewport(0, 0, m_FramebufferWidth, m_FramebufferHeight);
+}
+
+void Renderer::SetRenderTarget(unsigned int framebuffer, int width, int height) {
+    m_TargetFramebuffer = framebuffer;
+    m_TargetWidth = std::max(width, 1);
+    m_TargetHeight = std::max(height, 1);
+}
+
+void Renderer::EnsureSceneTarget(int width, int height) {
+    if (m_SceneFBO && width == m_SceneWidth && height == m_SceneHeight) {
+        return;
+    }
+    m_SceneWidth = width;
+    m_SceneHeight = height;
+    
+    if (!m_SceneFBO) glGenFramebuffers(1, &m_SceneFBO);
+    if (!m_SceneColor) glGenRenderbuffers(1, &m_SceneColor);
+    if (!m_SceneDepth) glGenRenderbuffers(1, &m_SceneDepth);
+    
+    glBindRenderbuffer(GL_RENDERBUFFER, m_SceneColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_SceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);   // Stencil for section caps
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, m_SceneFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_SceneColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_SceneDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR("Scene target {}x{} is incomplete", width, height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, m_TargetFramebuffer);
+}
+
+bool Renderer::IsBusy() const {
+    return m_StreamingMesh || m_Mesh->HasPendingUpload() ||
+           (m_Animation && m_Animation->IsPlaying()) || m_Picker->IsBusy() || m_Contour->IsBusy();
 }
 
 void Renderer::Update(float deltaTime) {
     m_Camera->Update(deltaTime);
+    
+    // Rebinding is skipped when the current state did not change
+    bool animated = m_Animation && m_Animation->Update(deltaTime);
+    GetActiveMesh()->SetDisplacements(animated ? m_Animation->GetBuffer() : 0,
+                                      animated ? m_Animation->GetOffset() : 0);
+    m_Contour->Poll();
+}
+
+void Renderer::SetAnimation(std::unique_ptr<DisplacementSource> source) {
+    m_Mesh->SetDisplacements(0, 0);
+    if (m_StreamingMesh) m_StreamingMesh->SetDisplacements(0, 0);
+    m_Animation.reset();
+    if (source) {
+        m_Animation = std::make_unique<AnimationStream>(std::move(source));
+    }
+}
+
+float Renderer::GetDisplacementScale() const {
+    return m_Animation && m_Animation->GetFrameCount() > 0 ? m_Settings.displacementScale : 0.0f;
 }
 
 void Renderer::RenderModel(Model* model) {
-    if (!model || model->GetNodeCount() == 0) {
+    if (!m_StreamingMesh && (!model || model->GetNodeCount() == 0)) {
         return;
     }
+    PROFILE_SCOPE("Renderer::RenderModel");
+    
+    UploadFrameUniforms();
+    if (!m_StreamingMesh && model) {
+        EnsurePartTable(*model);
+    }
+    m_Parts->Bind();
+    if (m_Settings.colorMode == ColorMode::CONTOUR) {
+        if (!m_StreamingMesh && model) {
+            UpdateContour(*model);
+        }
+        m_Contour->Bind(m_Settings.contour.colormap);
+    }
+    
+    if (m_Settings.showSolid) {
+        UpdateNormals(model);
+    }
+    
+    // Every pass is clipped, picking included, so what is cut away cannot be picked
+    const bool clipping = HasClipPlanes();
+    if (clipping) {
+        SetClipping(-1);
+    }
     
     if (m_Settings.showSolid) {
         RenderSolid(model);
+        if (clipping && m_Settings.capSections && !m_StreamingMesh && model) {
+            RenderSectionCaps(model);
+        }
     }
     
     if (m_Settings.showWireframe) {
@@ -87,56 +345,489 @@ void Renderer::RenderModel(Model* model) {
     if (m_Settings.showNodes) {
         RenderNodes(model);
     }
+    
+    RenderPickPass();
+    
+    if (clipping) {
+        for (int i = 0; i < kMaxClipPlanes; ++i) {
+            glDisable(GL_CLIP_DISTANCE0 + i);
+        }
+    }
+    
+    if (m_Animation) {
+        m_Animation->EndFrame();
+    }
 }
 
 void Renderer::UpdateMesh(Model* model) {
     if (!model) return;
     
-    m_Mesh->BuildFromModel(model);
+    RefreshMesh(model);
     
     // Update camera to fit model
     m_Camera->FitToModel(model);
 }
 
+void Renderer::RefreshMesh(Model* model) {
+    if (!model) return;
+    PROFILE_SCOPE("Renderer::RefreshMesh");
+    
+    // Edits may renumber elements, so the skin starts over, keeping what was hidden
+    m_Skin->Build(*model);
+    for (int partId : m_HiddenParts) {
+        m_Skin->SetPartHidden(*model, partId, true);
+    }
+    m_Mesh->BuildFromModel(model, MeshLayout::SHARED_NODES, m_Skin.get());
+    m_Picker->Cancel();   // Triangle numbers changed
+    m_PartsOutdated = true;
+    m_ContourOutdated = true;
+    m_NormalsOutdated = true;
+    
+    // Displacements are per node, so they no longer apply after node edits
+    if (m_Animation && m_Animation->GetNodeCount() != model->GetNodeCount()) {
+        LOG_WARN("Animation stopped: the model now has {} nodes, the result {}",
+                 model->GetNodeCount(), m_Animation->GetNodeCount());
+        SetAnimation(nullptr);
+    }
+}
+
+void Renderer::SetPartVisible(Model* model, int partId, bool visible) {
+    ApplyPartVisibility(model, {partId}, visible);
+}
+
+bool Renderer::IsPartVisible(int partId) const {
+    return std::find(m_HiddenParts.begin(), m_HiddenParts.end(), partId) == m_HiddenParts.end();
+}
+
+void Renderer::IsolatePart(Model* model, int partId) {
+    if (!model || IsStreaming()) return;
+    
+    EnsurePartTable(*model);
+    std::vector<int> others;
+    for (int id : m_Parts->GetPartIds()) {
+        if (id != partId) {
+            others.push_back(id);
+        }
+    }
+    ApplyPartVisibility(model, others, false);
+    ApplyPartVisibility(model, {partId}, true);
+}
+
+void Renderer::ShowAllParts(Model* model) {
+    std::vector<int> hidden = m_HiddenParts;
+    ApplyPartVisibility(model, hidden, true);
+}
+
+void Renderer::SetPartColor(int partId, const glm::vec3& color) {
+    m_Parts->SetPartColor(partId, color);
+}
+
+void Renderer::SetMaterialColor(int materialId, const glm::vec3& color) {
+    m_Parts->SetMaterialColor(materialId, color);
+}
+
+void Renderer::SetHighlightedElements(Model* model, const std::vector<int>& elementIds) {
+    if (model) {
+        m_Parts->SetHighlighted(*model, elementIds);
+    }
+}
+
+void Renderer::EnsurePartTable(const Model& model) {
+    if (m_PartsOutdated) {
+        m_Parts->Build(model);
+        m_PartsOutdated = false;
+    }
+}
+
+void Renderer::SetContourResults(std::shared_ptr<ResultCache> results) {
+    m_ContourResults = std::move(results);
+    m_ContourUploaded = false;
+    m_Contour->Clear();
+}
+
+void Renderer::UpdateContour(const Model& model) {
+    if (m_ContourOutdated) {
+        m_Contour->SetModel(model);
+        m_ContourOutdated = false;
+        m_ContourUploaded = false;
+    }
+    m_Contour->SetNodal(m_Settings.contour.nodal);
+    
+    const size_t state = m_Animation ? m_Animation->GetCurrentFrame() : 0;
+    const int field = m_Settings.contour.field;
+    if (m_ContourUploaded && state == m_ContourState && field == m_ContourField) {
+        return;
+    }
+    m_ContourUploaded = true;
+    m_ContourState = state;
+    m_ContourField = field;
+    
+    // The displacements of the state came through the same cache, so it
+    // is normally there; decoding here only happens after an eviction
+    std::shared_ptr<const ResultState> decoded;
+    if (m_ContourResults && state < m_ContourResults->GetStateCount()) {
+        decoded = m_ContourResults->Find(state);
+        if (!decoded) {
+            decoded = m_ContourResults->Get(state);
+        }
+    }
+    if (!decoded || field < 0 || static_cast<size_t>(field) >= decoded->elementScalars.size() ||
+        decoded->elementScalars[field].size() != model.GetElementCount()) {
+        m_Contour->Clear();
+        return;
+    }
+    m_Contour->SetValues(decoded->elementScalars[field]);
+}
+
+void Renderer::UpdateNormals(Model* model) {
+    // Streamed geometry shades flat until the model is complete
+    if (m_StreamingMesh || !model || !m_Settings.smoothShading) {
+        m_Normals->Bind(false);
+        return;
+    }
+    if (m_NormalsOutdated) {
+        m_Normals->SetMesh(*m_Mesh, model->GetNodeCount());
+        m_NormalsOutdated = false;
+    }
+    
+    // Every animation frame is a new shape, recomputed on the GPU
+    PROFILE_SCOPE("Renderer::UpdateNormals");
+    GpuTimer::Pass pass(*m_GpuTimer, "Normals");
+    const size_t frame = m_Animation ? m_Animation->GetCurrentFrame() : 0;
+    m_Normals->Update(*m_Mesh, model->GetNodePositions(), frame, GetDisplacementScale(),
+                      m_Settings.featureAngle);
+    m_Normals->Bind(true);
+}
+
+void Renderer::ApplyPartVisibility(Model* model, const std::vector<int>& partIds, bool visible) {
+    if (!model || IsStreaming()) return;
+    
+    EnsurePartTable(*model);
+    std::vector<int> solidParts;
+    for (int partId : partIds) {
+        if (IsPartVisible(partId) == visible) {
+            continue;
+        }
+        if (visible) {
+            m_HiddenParts.erase(std::remove(m_HiddenParts.begin(), m_HiddenParts.end(), partId),
+                                m_HiddenParts.end());
+        } else {
+            m_HiddenParts.push_back(partId);
+        }
+        m_Parts->SetPartVisible(partId, visible);
+        if (m_Parts->HasSolids(partId)) {
+            solidParts.push_back(partId);
+        }
+    }
+    
+    // Shells and outlines are hidden by the table alone; the skin changes
+    // with solids, once for all of them
+    if (solidParts.empty()) {
+        return;
+    }
+    if (!m_Skin->IsBuilt() || m_Skin->GetElementCount() != model->GetElementCount()) {
+        RefreshMesh(model);
+        return;
+    }
+    for (int partId : solidParts) {
+        m_Skin->SetPartHidden(*model, partId, !visible);
+    }
+    m_Mesh->BuildFromModel(model, MeshLayout::SHARED_NODES, m_Skin.get());
+    m_Picker->Cancel();
+    m_NormalsOutdated = true;
+}
+
+void Renderer::BeginStreaming() {
+    m_StreamingMesh = std::make_unique<Mesh>();
+    m_Picker->Cancel();
+    m_Parts->Clear();   // Streamed elements are numbered for the new model
+    m_PartsOutdated = true;
+}
+
+void Renderer::AppendMeshData(MeshData&& data) {
+    if (m_StreamingMesh) {
+        m_StreamingMesh->Append(std::move(data));
+    }
+}
+
+void Renderer::ContinueUpload(size_t byteBudget) {
+    if (m_StreamingMesh) {
+        PROFILE_SCOPE("Renderer::ContinueUpload");
+        m_StreamingMesh->ContinueUpload(byteBudget);
+    }
+}
+
+bool Renderer::HasPendingUpload() const {
+    return m_StreamingMesh && m_StreamingMesh->HasPendingUpload();
+}
+
+void Renderer::FinishStreaming() {
+    if (m_StreamingMesh) {
+        m_Mesh = std::move(m_StreamingMesh);
+        
+        // A new model: its skin is built when first needed
+        m_Skin->Clear();
+        m_HiddenParts.clear();
+        m_Parts->Reset();
+        m_PartsOutdated = true;
+        m_ContourOutdated = true;
+        m_NormalsOutdated = true;
+    }
+}
+
+void Renderer::CancelStreaming() {
+    m_StreamingMesh.reset();
+    m_Picker->Cancel();
+    m_PartsOutdated = true;
+}
+
+uint64_t Renderer::RequestPick(const PickRegion& region) {
+    return m_Picker->Request(region);
+}
+
+bool Renderer::TakePick(const Model& model, PickResult& result) {
+    PickHits hits;
+    if (!m_Picker->Poll(hits)) {
+        return false;
+    }
+    
+    // Triangles map to element indices and nodes are drawn by index, both
+    // dense indices into the model's ID arrays
+    const Mesh* mesh = GetActiveMesh();
+    const ChunkedColumn<int>& elementIds = model.GetElementIds();
+    const ChunkedColumn<int>& nodeIds = model.GetNodeIds();
+    result = PickResult();
+    result.request = hits.request;
+    for (uint32_t triangle : hits.triangles) {
+        uint32_t element = mesh->GetTriangleElement(triangle);
+        if (element < elementIds.size()) {
+            result.elementIds.push_back(elementIds[element]);
+        }
+    }
+    for (uint32_t node : hits.nodes) {
+        if (node < nodeIds.size()) {
+            result.nodeIds.push_back(nodeIds[node]);
+        }
+    }
+    std::sort(result.elementIds.begin(), result.elementIds.end());
+    result.elementIds.erase(std::unique(result.elementIds.begin(), result.elementIds.end()),
+                            result.elementIds.end());
+    std::sort(result.nodeIds.begin(), result.nodeIds.end());
+    
+    uint32_t centreElement = mesh->GetTriangleElement(hits.centreTriangle);
+    if (centreElement < elementIds.size()) {
+        result.hasCentreElement = true;
+        result.centreElementId = elementIds[centreElement];
+    }
+    if (hits.centreNode < nodeIds.size()) {
+        result.hasCentreNode = true;
+        result.centreNodeId = nodeIds[hits.centreNode];
+    }
+    return true;
+}
+
 void Renderer::RenderNodes(Model* model) {
+    PROFILE_SCOPE("Renderer::RenderNodes");
+    GpuTimer::Pass pass(*m_GpuTimer, "Nodes");
     m_BasicShader->Use();
-    m_BasicShader->SetMat4("view", m_Camera->GetViewMatrix());
-    m_BasicShader->SetMat4("projection", m_Camera->GetProjectionMatrix());
-    m_BasicShader->SetMat4("model", glm::mat4(1.0f));
-    m_BasicShader->SetVec3("color", m_Settings.nodeColor);
+    m_BasicShader->Set(m_BasicColor, m_Settings.nodeColor);
+    m_BasicShader->Set(m_BasicUsePartTable, false);
     
-    glPointSize(m_Settings.nodeSize);
-    m_Mesh->RenderNodes();
+    glPointSize(std::max(1.0f, m_Settings.nodeSize * m_FrameScale));
+    Frustum frustum;
+    MeshView view = MakeMeshView(frustum);
+    GetActiveMesh()->RenderNodes(&view);
 }
 
 void Renderer::RenderWireframe(Model* model) {
+    PROFILE_SCOPE("Renderer::RenderWireframe");
+    GpuTimer::Pass pass(*m_GpuTimer, "Wireframe");
     m_BasicShader->Use();
-    m_BasicShader->SetMat4("view", m_Camera->GetViewMatrix());
-    m_BasicShader->SetMat4("projection", m_Camera->GetProjectionMatrix());
-    m_BasicShader->SetMat4("model", glm::mat4(1.0f));
-    m_BasicShader->SetVec3("color", m_Settings.wireframeColor);
+    m_BasicShader->Set(m_BasicColor, m_Settings.wireframeColor);
+    m_BasicShader->Set(m_BasicUsePartTable, true);
+    m_BasicShader->Set(m_BasicHighlightColor, m_Settings.highlightColor);
     
-    glLineWidth(m_Settings.lineWidth);
-    m_Mesh->RenderWireframe();
+    glLineWidth(std::max(1.0f, m_Settings.lineWidth * m_FrameScale));
+    Frustum frustum;
+    MeshView view = MakeMeshView(frustum);
+    GetActiveMesh()->RenderWireframe(&view);
 }
 
 void Renderer::RenderSolid(Model* model) {
+    PROFILE_SCOPE("Renderer::RenderSolid");
+    GpuTimer::Pass pass(*m_GpuTimer, "Solid");
     m_PhongShader->Use();
-    m_PhongShader->SetMat4("view", m_Camera->GetViewMatrix());
-    m_PhongShader->SetMat4("projection", m_Camera->GetProjectionMatrix());
-    m_PhongShader->SetMat4("model", glm::mat4(1.0f));
+    m_PhongShader->Set(m_PhongObjectColor, m_Settings.solidColor);
+    m_PhongShader->Set(m_PhongColorMode, static_cast<int>(m_Settings.colorMode));
+    m_PhongShader->Set(m_PhongHighlightColor, m_Settings.highlightColor);
+    
+    const ContourSettings& contour = m_Settings.contour;
+    m_PhongShader->Set(m_PhongContourNodal, contour.nodal);
+    m_PhongShader->Set(m_PhongContourAutoRange, contour.autoRange);
+    m_PhongShader->Set(m_PhongContourLimits, glm::vec2(contour.rangeMin, contour.rangeMax));
+    m_PhongShader->Set(m_PhongContourBands, contour.bands);
+    
+    Frustum frustum;
+    MeshView view = MakeMeshView(frustum);
+    GetActiveMesh()->RenderSolid(&view);
+}
+
+bool Renderer::HasClipPlanes() const {
+    for (const ClipPlane& plane : m_Settings.clipPlanes) {
+        if (plane.enabled) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Renderer::SetClipping(int skippedPlane) {
+    for (int i = 0; i < kMaxClipPlanes; ++i) {
+        if (m_Settings.clipPlanes[i].enabled && i != skippedPlane) {
+            glEnable(GL_CLIP_DISTANCE0 + i);
+        } else {
+            glDisable(GL_CLIP_DISTANCE0 + i);
+        }
+    }
+}
+
+void Renderer::RenderSectionCaps(Model* model) {
+    // Where a plane cuts a closed skin, a ray from the eye crosses its
+    // front part an odd number of times, so inverting the stencil for
+    // every such face leaves the cut's outline set. A quad on the plane,
+    // clipped by the others, is then drawn through it, depth tested
+    // against what the solid pass left.
+    PROFILE_SCOPE("Renderer::RenderSectionCaps");
+    GpuTimer::Pass pass(*m_GpuTimer, "Section caps");
+    EnsureCapShader();
+    Frustum frustum;
+    MeshView view = MakeMeshView(frustum);
+    Mesh* mesh = GetActiveMesh();
+    const glm::vec3 center = model->GetCenter();
+    float extent = model->GetBoundingRadius() * 1.5f + view.boundsMargin;
     
-    // Lighting
-    m_PhongShader->SetVec3("lightPos", m_Camera->GetPosition());
-    m_PhongShader->SetVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-    m_PhongShader->SetVec3("objectColor", m_Settings.solidColor);
-    m_PhongShader->SetVec3("viewPos", m_Camera->GetPosition());
+    glEnable(GL_STENCIL_TEST);
+    for (int i = 0; i < kMaxClipPlanes; ++i) {
+        const ClipPlane& plane = m_Settings.clipPlanes[i];
+        if (!plane.enabled || glm::dot(plane.normal, plane.normal) == 0.0f) {
+            continue;
+        }
+        const glm::vec3 normal = glm::normalize(plane.normal);
+        
+        // Parity of the skin in front of this plane alone
+        glClear(GL_STENCIL_BUFFER_BIT);
+        for (int j = 0; j < kMaxClipPlanes; ++j) {
+            if (j == i) {
+                glEnable(GL_CLIP_DISTANCE0 + j);
+            } else {
+                glDisable(GL_CLIP_DISTANCE0 + j);
+            }
+        }
+        m_BasicShader->Use();
+        m_BasicShader->Set(m_BasicUsePartTable, true);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_DEPTH_TEST);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+        mesh->RenderClosedSurfaces(&view);
+        
+        // The cap, where the count was odd
+        SetClipping(i);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_DEPTH_TEST);
+        glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        
+        const glm::vec3 helper = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const glm::vec3 axisU = glm::normalize(glm::cross(normal, helper));
+        const glm::vec3 axisV = glm::cross(normal, axisU);
+        m_CapShader->Use();
+        m_CapShader->Set(m_CapOrigin, center - (glm::dot(normal, center) - plane.offset) * normal);
+        m_CapShader->Set(m_CapAxisU, axisU * extent);
+        m_CapShader->Set(m_CapAxisV, axisV * extent);
+        m_CapShader->Set(m_CapColor, m_Settings.capColor);
+        m_CapShader->Set(m_CapNormal, normal);
+        glBindVertexArray(m_CapVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+    }
+    glDisable(GL_STENCIL_TEST);
+    SetClipping(-1);
+}
+
+void Renderer::RenderPickPass() {
+    glm::mat4 regionMatrix;
+    if (!m_Picker->BeginPass(m_FramebufferWidth, m_FramebufferHeight, regionMatrix)) {
+        return;
+    }
+    PROFILE_SCOPE("Renderer::RenderPickPass");
+    GpuTimer::Pass pass(*m_GpuTimer, "Pick");
     
-    m_Mesh->RenderSolid();
+    glm::mat4 projection = regionMatrix * m_Camera->GetProjectionMatrix();
+    EnsurePickShader();
+    m_PickShader->Use();
+    m_PickShader->Set(m_PickRegion, regionMatrix);
+    
+    // The region's own frustum, so only the chunks under it are drawn
+    Frustum frustum;
+    MeshView view;
+    view.viewProjection = projection * m_Camera->GetViewMatrix();
+    if (m_Settings.frustumCulling) {
+        frustum = Frustum::FromMatrix(view.viewProjection);
+        view.frustum = &frustum;
+        if (m_Animation) {
+            view.boundsMargin = GetDisplacementScale() * m_Animation->GetMaxDisplacement();
+        }
+    }
+    
+    // Faces always occlude, even in wireframe; they are pushed back a
+    // little so the nodes on them win the depth test
+    Mesh* mesh = GetActiveMesh();
+    m_PickShader->Set(m_PickNodes, false);
+    glColorMaski(0, GL_TRUE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0f, 1.0f);
+    mesh->RenderPickTriangles(&view);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    
+    if (m_Settings.showNodes) {
+        m_PickShader->Set(m_PickNodes, true);
+        glColorMaski(0, GL_FALSE, GL_TRUE, GL_FALSE, GL_FALSE);
+        glPointSize(m_Settings.nodeSize);
+        mesh->RenderPickNodes(&view);
+    }
+    glColorMaski(0, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    m_Picker->EndPass();
+}
+
+MeshView Renderer::MakeMeshView(Frustum& frustum) const {
+    glm::mat4 projection = m_Camera->GetProjectionMatrix();
+    MeshView view;
+    view.viewProjection = projection * m_Camera->GetViewMatrix();
+    if (m_Settings.frustumCulling) {
+        frustum = Frustum::FromMatrix(view.viewProjection);
+        view.frustum = &frustum;
+        if (m_Animation) {
+            view.boundsMargin = GetDisplacementScale() * m_Animation->GetMaxDisplacement();
+        }
+    }
+    if (m_Settings.levelOfDetail) {
+        // In pixels of the scene drawn, so interactive frames coarsen too
+        view.pixelScale = projection[1][1] * static_cast<float>(m_FramebufferHeight) * m_FrameScale * 0.5f;
+    }
+    return view;
 }
 
 void Renderer::Shutdown() {
     // Cleanup OpenGL resources
+    m_Picker.reset();
+    m_Parts.reset();
+    m_Contour.reset();
+    m_Normals.reset();
+    m_GpuTimer.reset();
+    if (m_FrameUBO) glDeleteBuffers(1, &m_FrameUBO);
     if (m_NodeVAO) glDeleteVertexArrays(1, &m_NodeVAO);
     if (m_NodeVBO) glDeleteBuffers(1, &m_NodeVBO);
     if (m_WireVAO) glDeleteVertexArrays(1, &m_WireVAO);
@@ -145,4 +836,10 @@ void Renderer::Shutdown() {
     if (m_SolidVAO) glDeleteVertexArrays(1, &m_SolidVAO);
     if (m_SolidVBO) glDeleteBuffers(1, &m_SolidVBO);
     if (m_SolidEBO) glDeleteBuffers(1, &m_SolidEBO);
+    if (m_CapVAO) glDeleteVertexArrays(1, &m_CapVAO);
+    m_CapVAO = 0;
+    if (m_SceneFBO) glDeleteFramebuffers(1, &m_SceneFBO);
+    if (m_SceneColor) glDeleteRenderbuffers(1, &m_SceneColor);
+    if (m_SceneDepth) glDeleteRenderbuffers(1, &m_SceneDepth);
+    m_SceneFBO = m_SceneColor = m_SceneDepth = 0;
 }
@@ -1,12 +1,53 @@
 #pragma once
+#include "rendering/Shader.h"
+#include "rendering/ContourPlot.h"
 #include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 
 struct GLFWwindow;
 class Model;
 class Camera;
-class Shader;
 class Mesh;
+class SolidSkin;
+class AnimationStream;
+class DisplacementSource;
+struct MeshData;
+struct MeshView;
+class Frustum;
+class Picker;
+class PartTable;
+class NormalGenerator;
+class ResultCache;
+class GpuTimer;
+struct PickRegion;
+struct PickResult;
+
+// What the solid pass colours faces by
+enum class ColorMode {
+    SINGLE,     // RenderSettings::solidColor
+    PART,       // Each part (property ID) its own colour
+    MATERIAL,
+    CONTOUR     // Fringes of an element scalar of the results (ContourSettings)
+};
+
+struct ContourSettings {
+    int field = 0;           // Index into ResultReader::GetElementScalarNames
+    bool nodal = true;       // Averaged to nodes and interpolated, else flat per element
+    int bands = 10;          // Discrete colour bands; 0 for a continuous scale
+    Colormap colormap = Colormap::RAINBOW;
+    bool autoRange = true;   // The shown state's min and max, else the range below
+    float rangeMin = 0.0f;
+    float rangeMax = 1.0f;
+};
+
+// A user section plane: what lies on the side its normal points to stays,
+// where the distance along the normalised normal is at least offset
+struct ClipPlane {
+    bool enabled = false;
+    glm::vec3 normal = glm::vec3(1.0f, 0.0f, 0.0f);
+    float offset = 0.0f;
+};
 
 struct RenderSettings {
     bool showNodes = true;
@@ -14,18 +55,35 @@ struct RenderSettings {
     bool showSolid = false;
     bool showNormals = false;
     bool enableLighting = true;
+    bool frustumCulling = true;     // Skip mesh chunks outside the view
+    bool levelOfDetail = true;      // Draw chunks small on screen simplified
+    bool smoothShading = true;      // Interpolated normals, else flat per triangle
+    ColorMode colorMode = ColorMode::PART;
     
     glm::vec3 backgroundColor = glm::vec3(0.05f, 0.05f, 0.15f);
     glm::vec3 nodeColor = glm::vec3(1.0f, 0.3f, 0.3f);
     glm::vec3 wireframeColor = glm::vec3(0.9f, 0.9f, 0.9f);
     glm::vec3 solidColor = glm::vec3(0.6f, 0.8f, 1.0f);
+    glm::vec3 highlightColor = glm::vec3(1.0f, 0.85f, 0.1f);   // Highlighted elements, solid and wireframe
     
     float nodeSize = 3.0f;
     float lineWidth = 1.0f;
+    float displacementScale = 1.0f;   // Deformation magnification while animating
+    float interactiveScale = 0.5f;    // Resolution of frames drawn during camera drags
+    float featureAngle = 30.0f;       // Degrees between faces beyond which smooth shading keeps an edge
+    ContourSettings contour;
+    
+    // Section cuts: moving a plane only changes uniforms. Caps fill the
+    // cut through solids, one stencil pass per plane.
+    ClipPlane clipPlanes[kMaxClipPlanes];
+    bool capSections = true;
+    glm::vec3 capColor = glm::vec3(0.85f, 0.45f, 0.35f);
 };
 
 class Renderer {
 public:
+    // A null window renders headless into the target set by SetRenderTarget;
+    // GLEW is then initialised by whoever made the context current
     Renderer(GLFWwindow* window);
     ~Renderer();
     
@@ -35,9 +93,63 @@ public:
     void BeginFrame();
     void EndFrame();
     
+    // Interactive frames, drawn while the camera is dragged, render the scene
+    // at RenderSettings::interactiveScale of the window and scale it up;
+    // PresentScene does that after RenderModel, so the GUI stays sharp
+    void SetInteractive(bool interactive) { m_Interactive = interactive; }
+    bool IsInteractive() const { return m_Interactive; }
+    void PresentScene();
+    void SetRenderTarget(unsigned int framebuffer, int width, int height);
+    
+    // Work that takes more frames to finish: uploads, playback and picks
+    bool IsBusy() const;
+    
     void Update(float deltaTime);
     void RenderModel(Model* model);
     void UpdateMesh(Model* model);
+    void RefreshMesh(Model* model);   // Like UpdateMesh, keeping the camera
+    
+    // Hides or shows the elements of a part (property ID), and colours
+    // parts and materials. Both only rewrite the part table; a part with
+    // solids also updates the skin incrementally, so the solids behind it
+    // are uncovered. IsolatePart hides every other part.
+    void SetPartVisible(Model* model, int partId, bool visible);
+    bool IsPartVisible(int partId) const;
+    void IsolatePart(Model* model, int partId);
+    void ShowAllParts(Model* model);
+    void SetPartColor(int partId, const glm::vec3& color);
+    void SetMaterialColor(int materialId, const glm::vec3& color);
+    void SetHighlightedElements(Model* model, const std::vector<int>& elementIds);
+    const PartTable& GetPartTable() const { return *m_Parts; }
+    
+    // Progressive display while a model loads in the background. Streamed
+    // geometry replaces the current mesh on screen and is uploaded in
+    // slices; FinishStreaming keeps it, CancelStreaming restores the old one.
+    void BeginStreaming();
+    void AppendMeshData(MeshData&& data);
+    void ContinueUpload(size_t byteBudget);
+    bool HasPendingUpload() const;
+    void FinishStreaming();
+    void CancelStreaming();
+    bool IsStreaming() const { return m_StreamingMesh != nullptr; }
+    
+    // Deformed-shape playback of per-node displacements, which must be in
+    // the model's node order; null stops it. Update advances it.
+    void SetAnimation(std::unique_ptr<DisplacementSource> source);
+    AnimationStream* GetAnimation() { return m_Animation.get(); }
+    
+    // Fringes of the results while ColorMode::CONTOUR is set: the field of
+    // the state the animation shows (the first without one) is uploaded
+    // when either changes; everything else in ContourSettings only changes
+    // uniforms. The contour plot has the legend's range and histogram.
+    void SetContourResults(std::shared_ptr<ResultCache> results);
+    const ContourPlot& GetContour() const { return *m_Contour; }
+    
+    // Picking through an ID pass drawn only when a pick is waiting. Results
+    // arrive a frame or two later, in request order; TakePick resolves the
+    // next finished one to the model's element and node IDs.
+    uint64_t RequestPick(const PickRegion& region);
+    bool TakePick(const Model& model, PickResult& result);
     
     // Settings
     RenderSettings& GetSettings() { return m_Settings; }
@@ -48,22 +160,93 @@ public:
     
     GLFWwindow* GetWindow() { return m_Window; }
     
+    // Passes of the frame are timed on the GPU; so can be the caller's own,
+    // such as the GUI's, between BeginFrame and EndFrame. EndFrame reports
+    // the draw and triangle counts and the VRAM in use to the Profiler.
+    GpuTimer& GetGpuTimer() { return *m_GpuTimer; }
+    
 private:
     void SetupShaders();
+    static void SetTableSamplers(Shader& shader);   // Element and part tables, at their units
+    void EnsurePickShader();
+    void EnsureCapShader();
+    void EnsureSceneTarget(int width, int height);
+    void UploadFrameUniforms();
+    void EnsurePartTable(const Model& model);
+    void UpdateContour(const Model& model);
+    void UpdateNormals(Model* model);
+    void ApplyPartVisibility(Model* model, const std::vector<int>& partIds, bool visible);
     void RenderNodes(Model* model);
     void RenderWireframe(Model* model);
     void RenderSolid(Model* model);
+    void RenderSectionCaps(Model* model);
+    void SetClipping(int skippedPlane);   // Enables the active planes but one (-1 for none)
+    bool HasClipPlanes() const;
+    void RenderPickPass();
+    MeshView MakeMeshView(Frustum& frustum) const;   // frustum is filled in for the view
+    float GetDisplacementScale() const;
+    Mesh* GetActiveMesh() { return m_StreamingMesh ? m_StreamingMesh.get() : m_Mesh.get(); }
     
 private:
     GLFWwindow* m_Window;
     std::unique_ptr<Camera> m_Camera;
     std::unique_ptr<Shader> m_BasicShader;
     std::unique_ptr<Shader> m_PhongShader;
+    std::unique_ptr<Shader> m_PickShader;
+    std::unique_ptr<Shader> m_CapShader;
+    unsigned int m_FrameUBO;   // FrameUniforms, bound at Shader::kFrameBinding
+    
+    // Per-program uniforms, looked up once
+    ShaderUniform<glm::vec3> m_BasicColor;
+    ShaderUniform<bool> m_BasicUsePartTable;
+    ShaderUniform<glm::vec3> m_BasicHighlightColor;
+    ShaderUniform<glm::vec3> m_PhongObjectColor;
+    ShaderUniform<int> m_PhongColorMode;
+    ShaderUniform<glm::vec3> m_PhongHighlightColor;
+    ShaderUniform<bool> m_PhongContourNodal;
+    ShaderUniform<bool> m_PhongContourAutoRange;
+    ShaderUniform<glm::vec2> m_PhongContourLimits;
+    ShaderUniform<int> m_PhongContourBands;
+    ShaderUniform<glm::mat4> m_PickRegion;
+    ShaderUniform<bool> m_PickNodes;
+    ShaderUniform<glm::vec3> m_CapOrigin;
+    ShaderUniform<glm::vec3> m_CapAxisU;
+    ShaderUniform<glm::vec3> m_CapAxisV;
+    ShaderUniform<glm::vec3> m_CapColor;
+    ShaderUniform<glm::vec3> m_CapNormal;
+    
     std::unique_ptr<Mesh> m_Mesh;
+    std::unique_ptr<Mesh> m_StreamingMesh;
+    std::unique_ptr<SolidSkin> m_Skin;
+    std::vector<int> m_HiddenParts;
+    std::unique_ptr<PartTable> m_Parts;
+    bool m_PartsOutdated;   // Elements changed since the table was built
+    std::unique_ptr<AnimationStream> m_Animation;
+    std::unique_ptr<ContourPlot> m_Contour;
+    std::shared_ptr<ResultCache> m_ContourResults;
+    bool m_ContourOutdated;     // Model changed since the adjacency was uploaded
+    bool m_ContourUploaded;     // Values of the state and field below are on the GPU
+    size_t m_ContourState;
+    int m_ContourField;
+    std::unique_ptr<NormalGenerator> m_Normals;
+    bool m_NormalsOutdated;     // Mesh rebuilt since the adjacency was
+    std::unique_ptr<Picker> m_Picker;
+    std::unique_ptr<GpuTimer> m_GpuTimer;
     
     RenderSettings m_Settings;
     
     unsigned int m_NodeVAO, m_NodeVBO;
     unsigned int m_WireVAO, m_WireVBO, m_WireEBO;
     unsigned int m_SolidVAO, m_SolidVBO, m_SolidEBO;
+    unsigned int m_CapVAO;   // Empty; the cap quad is made in its shader
+    
+    // Window framebuffer size this frame, or the headless target's, and
+    // the reduced scene target
+    unsigned int m_TargetFramebuffer;
+    int m_TargetWidth, m_TargetHeight;
+    int m_FramebufferWidth, m_FramebufferHeight;
+    bool m_Interactive;
+    float m_FrameScale;   // Of the scene being drawn
+    unsigned int m_SceneFBO, m_SceneColor, m_SceneDepth;
+    int m_SceneWidth, m_SceneHeight;
 };
\ No newline at end of file
@@ -1,26 +1,79 @@
 #include "rendering/Shader.h"
+#include "rendering/ProgramCache.h"
 #include "utils/Logger.h"
 #include <GL/glew.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
 Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) {
-    std::string vertexCode = LoadShaderFromFile(vertexPath);
-    std::string fragmentCode = LoadShaderFromFile(fragmentPath);
-    
-    unsigned int vertex = CompileShader(GL_VERTEX_SHADER, vertexCode);
-    unsigned int fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentCode);
+    Build({{GL_VERTEX_SHADER, LoadShaderFromFile(vertexPath)},
+           {GL_FRAGMENT_SHADER, LoadShaderFromFile(fragmentPath)}});
+}
+
+Shader::Shader(const std::string& vertexPath, const std::string& geometryPath,
+               const std::string& fragmentPath) {
+    // Without its file the geometry stage is left out; the other two
+    // stages still link on their own
+    std::vector<StageSource> stages = {{GL_VERTEX_SHADER, LoadShaderFromFile(vertexPath)}};
+    std::string geometryCode = LoadShaderFromFile(geometryPath);
+    if (!geometryCode.empty()) {
+        stages.push_back({GL_GEOMETRY_SHADER, std::move(geometryCode)});
+    }
+    stages.push_back({GL_FRAGMENT_SHADER, LoadShaderFromFile(fragmentPath)});
+    Build(stages);
+}
+
+Shader::Shader(const std::string& vertexPath, const std::vector<std::string>& feedbackVaryings) {
+    Build({{GL_VERTEX_SHADER, LoadShaderFromFile(vertexPath)}}, &feedbackVaryings);
+}
+
+void Shader::Build(const std::vector<StageSource>& stages,
+                   const std::vector<std::string>* feedbackVaryings) {
+    // A cached binary of the same sources skips compiling altogether
+    std::vector<std::string> inputs;
+    for (const StageSource& stage : stages) {
+        inputs.push_back(std::to_string(stage.type));
+        inputs.push_back(stage.code);
+    }
+    if (feedbackVaryings) {
+        inputs.insert(inputs.end(), feedbackVaryings->begin(), feedbackVaryings->end());
+    }
+    const uint64_t key = ProgramCache::MakeKey(inputs);
+    m_ID = glCreateProgram();
+    if (ProgramCache::Load(key, m_ID)) {
+        ReflectUniforms();
+        return;
+    }
+    glDeleteProgram(m_ID);
     
     // Shader Program
+    std::vector<unsigned int> compiled;
+    for (const StageSource& stage : stages) {
+        compiled.push_back(CompileShader(stage.type, stage.code));
+    }
     m_ID = glCreateProgram();
-    glAttachShader(m_ID, vertex);
-    glAttachShader(m_ID, fragment);
+    for (unsigned int stage : compiled) {
+        glAttachShader(m_ID, stage);
+    }
+    if (feedbackVaryings) {
+        std::vector<const char*> names;
+        for (const std::string& name : *feedbackVaryings) {
+            names.push_back(name.c_str());
+        }
+        glTransformFeedbackVaryings(m_ID, static_cast<GLsizei>(names.size()), names.data(),
+                                    GL_INTERLEAVED_ATTRIBS);
+    }
+    ProgramCache::PrepareProgram(m_ID);
     glLinkProgram(m_ID);
     CheckCompileErrors(m_ID, "PROGRAM");
+    ProgramCache::Store(key, m_ID);
+    ReflectUniforms();
     
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (unsigned int stage : compiled) {
+        glDeleteShader(stage);
+    }
 }
 
 Shader::~Shader() {
@@ -31,24 +84,109 @@ void Shader::Use() const {
     glUseProgram(m_ID);
 }
 
+int Shader::GetUniformLocation(const std::string& name) const {
+    auto it = m_Uniforms.find(name);
+    return it != m_Uniforms.end() ? it->second : -1;
+}
+
+void Shader::Set(ShaderUniform<bool> uniform, bool value) const {
+    glUniform1i(uniform.location, (int)value);
+}
+
+void Shader::Set(ShaderUniform<int> uniform, int value) const {
+    glUniform1i(uniform.location, value);
+}
+
+void Shader::Set(ShaderUniform<unsigned int> uniform, unsigned int value) const {
+    glUniform1ui(uniform.location, value);
+}
+
+void Shader::Set(ShaderUniform<float> uniform, float value) const {
+    glUniform1f(uniform.location, value);
+}
+
+void Shader::Set(ShaderUniform<glm::vec2> uniform, const glm::vec2& value) const {
+    glUniform2fv(uniform.location, 1, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::vec3> uniform, const glm::vec3& value) const {
+    glUniform3fv(uniform.location, 1, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::vec4> uniform, const glm::vec4& value) const {
+    glUniform4fv(uniform.location, 1, glm::value_ptr(value));
+}
+
+void Shader::Set(ShaderUniform<glm::mat3> uniform, const glm::mat3& mat) const {
+    glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::Set(ShaderUniform<glm::mat4> uniform, const glm::mat4& mat) const {
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
 void Shader::SetBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(m_ID, name.c_str()), (int)value);
+    Set(GetUniform<bool>(name), value);
 }
 
 void Shader::SetInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(m_ID, name.c_str()), value);
+    Set(GetUniform<int>(name), value);
 }
 
 void Shader::SetFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(m_ID, name.c_str()), value);
+    Set(GetUniform<float>(name), value);
+}
+
+void Shader::SetVec2(const std::string& name, const glm::vec2& value) const {
+    Set(GetUniform<glm::vec2>(name), value);
 }
 
 void Shader::SetVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(m_ID, name.c_str()), 1, glm::value_ptr(value));
+    Set(GetUniform<glm::vec3>(name), value);
+}
+
+void Shader::SetVec4(const std::string& name, const glm::vec4& value) const {
+    Set(GetUniform<glm::vec4>(name), value);
+}
+
+void Shader::SetMat3(const std::string& name, const glm::mat3& mat) const {
+    Set(GetUniform<glm::mat3>(name), mat);
 }
 
 void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(m_ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    Set(GetUniform<glm::mat4>(name), mat);
+}
+
+void Shader::ReflectUniforms() {
+    // Members of uniform blocks have no location and are skipped
+    int count = 0, maxLength = 0;
+    glGetProgramiv(m_ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(static_cast<size_t>(std::max(maxLength, 1)), '\0');
+    for (int i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_ID, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()),
+                           &length, &size, &type, &name[0]);
+        std::string uniformName(name.data(), static_cast<size_t>(length));
+        int location = glGetUniformLocation(m_ID, uniformName.c_str());
+        if (location < 0) {
+            continue;
+        }
+        
+        // Arrays are reported as "name[0]"; both spellings find the first element
+        m_Uniforms[uniformName] = location;
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos) {
+            m_Uniforms[uniformName.substr(0, bracket)] = location;
+        }
+    }
+    
+    GLuint frameBlock = glGetUniformBlockIndex(m_ID, "Frame");
+    if (frameBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_ID, frameBlock, kFrameBinding);
+    }
 }
 
 std::string Shader::LoadShaderFromFile(const std::string& path) {
@@ -66,16 +204,23 @@ std::string Shader::LoadShaderFromFile(const std::string& path) {
     } catch (std::ifstream::failure& e) {
         LOG_ERROR("Failed to read shader file: {}", path);
         
-        // Return default shader if file not found
+        // Return default shader if file not found; geometry stages have none
+        if (path.find(".geom") != std::string::npos) {
+            return std::string();
+        }
         if (path.find(".vert") != std::string::npos) {
             return R"(
                 #version 330 core
                 layout (location = 0) in vec3 aPos;
-                uniform mat4 model;
-                uniform mat4 view;
-                uniform mat4 projection;
+                layout (std140) uniform Frame {
+                    mat4 view;
+                    mat4 projection;
+                    vec4 cameraPosition;
+                    vec4 lightColor;
+                    float displacementScale;
+                };
                 void main() {
-                    gl_Position = projection * view * model * vec4(aPos, 1.0);
+                    gl_Position = projection * view * vec4(aPos, 1.0);
                 }
             )";
         } else {
@@ -98,7 +243,8 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
     const char* src = source.c_str();
     glShaderSource(shader, 1, &src, nullptr);
     glCompileShader(shader);
-    CheckCompileErrors(shader, type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT");
+    CheckCompileErrors(shader, type == GL_VERTEX_SHADER ? "VERTEX"
+                             : type == GL_GEOMETRY_SHADER ? "GEOMETRY" : "FRAGMENT");
     return shader;
 }
 
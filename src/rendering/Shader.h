@@ -1,32 +1,102 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 
+// User clipping planes, one gl_ClipDistance each in every program that
+// draws the model
+constexpr int kMaxClipPlanes = 6;
+
+// Per-frame camera and light data, shared by every program through one
+// uniform buffer. Mirrors the std140 block Frame that the shaders declare;
+// programs that do not clip may leave the planes out.
+struct FrameUniforms {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec4 cameraPosition = glm::vec4(0.0f);   // Also the light's; w unused
+    glm::vec4 lightColor = glm::vec4(1.0f);       // w unused
+    float displacementScale = 0.0f;
+    float padding[3] = {};
+    
+    // Kept where dot(plane.xyz, position) + plane.w >= 0, through
+    // gl_ClipDistance; unused ones are (0, 0, 0, 1) and keep everything
+    glm::vec4 clipPlanes[kMaxClipPlanes];
+    
+    FrameUniforms() {
+        for (glm::vec4& plane : clipPlanes) plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+};
+static_assert(sizeof(FrameUniforms) == 272, "FrameUniforms must match the std140 Frame block");
+
+// Location of a uniform of type T, looked up once; Shader::Set only takes
+// the matching value type. Invalid handles are ignored like by GL.
+template<typename T>
+struct ShaderUniform {
+    int location = -1;
+    bool IsValid() const { return location >= 0; }
+};
+
 class Shader {
 public:
+    // Uniform block binding point of the Frame block in every program
+    static constexpr unsigned int kFrameBinding = 0;
+    
     Shader(const std::string& vertexPath, const std::string& fragmentPath);
+    Shader(const std::string& vertexPath, const std::string& geometryPath,
+           const std::string& fragmentPath);
+    
+    // Vertex-only program whose outputs are captured by transform feedback,
+    // interleaved in the order given
+    Shader(const std::string& vertexPath, const std::vector<std::string>& feedbackVaryings);
     ~Shader();
     
     void Use() const;
     
-    // Utility uniform functions
+    // Uniform locations are reflected when linking, so handles cost a map
+    // lookup once and nothing per draw. The program must be in use to set.
+    template<typename T>
+    ShaderUniform<T> GetUniform(const std::string& name) const { return {GetUniformLocation(name)}; }
+    int GetUniformLocation(const std::string& name) const;
+    
+    void Set(ShaderUniform<bool> uniform, bool value) const;
+    void Set(ShaderUniform<int> uniform, int value) const;
+    void Set(ShaderUniform<unsigned int> uniform, unsigned int value) const;
+    void Set(ShaderUniform<float> uniform, float value) const;
+    void Set(ShaderUniform<glm::vec2> uniform, const glm::vec2& value) const;
+    void Set(ShaderUniform<glm::vec3> uniform, const glm::vec3& value) const;
+    void Set(ShaderUniform<glm::vec4> uniform, const glm::vec4& value) const;
+    void Set(ShaderUniform<glm::mat3> uniform, const glm::mat3& mat) const;
+    void Set(ShaderUniform<glm::mat4> uniform, const glm::mat4& mat) const;
+    
+    // Utility uniform functions, by name through the reflected locations
     void SetBool(const std::string& name, bool value) const;
     void SetInt(const std::string& name, int value) const;
     void SetFloat(const std::string& name, float value) const;
     void SetVec2(const std::string& name, const glm::vec2& value) const;
     void SetVec3(const std::string& name, const glm::vec3& value) const;
     void SetVec4(const std::string& name, const glm::vec4& value) const;
-    void SetMat2(const std::string& name, const glm::mat2& mat) const;
     void SetMat3(const std::string& name, const glm::mat3& mat) const;
     void SetMat4(const std::string& name, const glm::mat4& mat) const;
     
     unsigned int GetID() const { return m_ID; }
-    
+
 private:
+    struct StageSource {
+        unsigned int type;   // GL_VERTEX_SHADER and so on
+        std::string code;
+    };
+    
+    // Links the stages, or loads the program from ProgramCache when it
+    // has a binary of the same sources
+    void Build(const std::vector<StageSource>& stages,
+               const std::vector<std::string>* feedbackVaryings = nullptr);
     unsigned int CompileShader(unsigned int type, const std::string& source);
     std::string LoadShaderFromFile(const std::string& path);
     void CheckCompileErrors(unsigned int shader, const std::string& type);
-    
+    void ReflectUniforms();
+
 private:
     unsigned int m_ID;
-};
\ No newline at end of file
+    std::unordered_map<std::string, int> m_Uniforms;   // Name to location
+};
@@ -0,0 +1,344 @@
+#include "solver/DomainPartitioner.h"
+#include "core/Model.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// Parts smaller than this are cut on the calling thread
+constexpr size_t kParallelGrain = 64 * 1024;
+
+// Histogram bins per cut; the bin the cut falls in is sorted
+constexpr int kBins = 4096;
+
+struct Extent {
+    glm::vec3 minimum = glm::vec3(INFINITY);
+    glm::vec3 maximum = glm::vec3(-INFINITY);
+    double weight = 0.0;
+};
+
+Extent Measure(const DecompositionInput& input, const uint32_t* items, size_t count) {
+    Extent total;
+    std::mutex mutex;
+    ThreadPool::GetGlobal().ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+        Extent part;
+        for (size_t i = begin; i < end; ++i) {
+            const glm::vec3& centroid = input.centroids[items[i]];
+            part.minimum = glm::min(part.minimum, centroid);
+            part.maximum = glm::max(part.maximum, centroid);
+            part.weight += input.costs[items[i]];
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        total.minimum = glm::min(total.minimum, part.minimum);
+        total.maximum = glm::max(total.maximum, part.maximum);
+        total.weight += part.weight;
+    });
+    return total;
+}
+
+// Elements [first, last) go to ranks [firstDomain, firstDomain + ranks)
+void Bisect(const DecompositionInput& input, uint32_t* first, uint32_t* last, int firstDomain, int ranks,
+            uint16_t* domains) {
+    const size_t count = static_cast<size_t>(last - first);
+    if (ranks == 1 || count == 0) {
+        for (uint32_t* it = first; it != last; ++it) {
+            domains[*it] = static_cast<uint16_t>(firstDomain);
+        }
+        return;
+    }
+    
+    const Extent extent = Measure(input, first, count);
+    const glm::vec3 size = extent.maximum - extent.minimum;
+    const int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+    const float low = extent.minimum[axis];
+    const float scale = size[axis] > 0.0f ? kBins / size[axis] : 0.0f;
+    auto binOf = [&](uint32_t item) {
+        return std::min(static_cast<int>((input.centroids[item][axis] - low) * scale), kBins - 1);
+    };
+    
+    // Weight per bin along the axis
+    std::vector<double> bins(kBins, 0.0);
+    std::mutex mutex;
+    ThreadPool::GetGlobal().ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+        std::vector<double> part(kBins, 0.0);
+        for (size_t i = begin; i < end; ++i) {
+            part[binOf(first[i])] += input.costs[first[i]];
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int b = 0; b < kBins; ++b) {
+            bins[b] += part[b];
+        }
+    });
+    
+    // The left part takes its share of ranks in weight
+    const int leftRanks = ranks / 2;
+    const double target = extent.weight * leftRanks / ranks;
+    int splitBin = 0;
+    double below = 0.0;
+    while (splitBin < kBins - 1 && below + bins[splitBin] < target) {
+        below += bins[splitBin++];
+    }
+    
+    // Bins before the cut, the cut's bin in order along the axis, the rest
+    uint32_t* binBegin = std::partition(first, last, [&](uint32_t item) { return binOf(item) < splitBin; });
+    uint32_t* binEnd = std::partition(binBegin, last, [&](uint32_t item) { return binOf(item) == splitBin; });
+    std::sort(binBegin, binEnd, [&](uint32_t a, uint32_t b) {
+        const float ca = input.centroids[a][axis], cb = input.centroids[b][axis];
+        return ca < cb || (ca == cb && a < b);
+    });
+    uint32_t* middle = binBegin;
+    while (middle != binEnd && below + input.costs[*middle] * 0.5 < target) {
+        below += input.costs[*middle++];
+    }
+    
+    auto cutLeft = [&]() { Bisect(input, first, middle, firstDomain, leftRanks, domains); };
+    auto cutRight = [&]() { Bisect(input, middle, last, firstDomain + leftRanks, ranks - leftRanks, domains); };
+    if (count < kParallelGrain) {
+        cutLeft();
+        cutRight();
+        return;
+    }
+    ThreadPool::GetGlobal().ParallelFor(2, 1, [&](size_t begin, size_t end) {
+        for (size_t side = begin; side < end; ++side) {
+            side == 0 ? cutLeft() : cutRight();
+        }
+    });
+}
+
+bool IsPowerOfTwo(int value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+} // namespace
+
+float DomainPartitioner::GetElementCost(ElementType type, MaterialType law) {
+    // Rough per-cycle timings of the engine, reduced integration throughout
+    float cost = 1.0f;
+    switch (type) {
+        case ElementType::SHELL3:  cost = 0.8f; break;
+        case ElementType::SHELL4:  cost = 1.0f; break;
+        case ElementType::TETRA4:  cost = 0.7f; break;
+        case ElementType::HEXA8:   cost = 1.6f; break;
+        case ElementType::BEAM2:   cost = 0.4f; break;
+        case ElementType::SPRING1: cost = 0.1f; break;
+        default:                   break;
+    }
+    switch (law) {
+        case MaterialType::ELASTIC:      break;
+        case MaterialType::PLASTIC:      cost *= 1.3f; break;
+        case MaterialType::JOHNSON_COOK: cost *= 1.4f; break;
+        case MaterialType::COMPOSITE:    cost *= 1.8f; break;
+        case MaterialType::HYPERELASTIC: cost *= 1.6f; break;
+    }
+    return cost;
+}
+
+DecompositionInput DomainPartitioner::Gather(const Model& model) {
+    DecompositionInput input;
+    const size_t count = model.GetElementCount();
+    input.centroids.resize(count);
+    input.costs.resize(count);
+    
+    std::unordered_map<int, MaterialType> laws;
+    for (const Material& material : model.GetMaterials()) {
+        laws[material.id] = material.type;
+    }
+    
+    const ChunkedColumn<glm::vec3>& positions = model.GetNodePositions();
+    ThreadPool::GetGlobal().ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+        model.ForEachElement(begin, end, [&](size_t i, const ElementView& element) {
+            // Defined nodes only
+            glm::vec3 sum(0.0f);
+            int used = 0;
+            for (size_t k = 0; k < element.nodeIds.size(); ++k) {
+                size_t index = element.nodeIndices ? element.nodeIndices[k]
+                                                   : model.FindNodeIndex(element.nodeIds[k]);
+                if (index != ElementArrays::kMissingNode && index != Model::kInvalidIndex) {
+                    sum += positions[index];
+                    ++used;
+                }
+            }
+            input.centroids[i] = used > 0 ? sum / static_cast<float>(used) : glm::vec3(0.0f);
+            auto law = laws.find(element.materialId);
+            input.costs[i] = GetElementCost(element.type, law != laws.end() ? law->second : MaterialType::ELASTIC);
+        });
+    });
+    
+    const NodeAdjacency& adjacency = model.GetNodeAdjacency();
+    input.nodeOffsets = adjacency.GetOffsets();
+    input.nodeElements = adjacency.GetEntries();
+    return input;
+}
+
+std::vector<uint16_t> DomainPartitioner::Partition(const DecompositionInput& input, int rankCount) {
+    const size_t count = input.GetElementCount();
+    std::vector<uint16_t> domains(count, 0);
+    std::vector<uint32_t> items(count);
+    for (size_t i = 0; i < count; ++i) {
+        items[i] = static_cast<uint32_t>(i);
+    }
+    Bisect(input, items.data(), items.data() + count, 0, std::clamp(rankCount, 1, kMaxRanks), domains.data());
+    return domains;
+}
+
+Decomposition DomainPartitioner::Evaluate(const DecompositionInput& input, const std::vector<uint16_t>& domains,
+                                          int rankCount) {
+    Decomposition result;
+    result.rankCount = rankCount;
+    result.domains.resize(rankCount);
+    std::mutex mutex;
+    
+    ThreadPool::GetGlobal().ParallelFor(input.GetElementCount(), kParallelGrain, [&](size_t begin, size_t end) {
+        std::vector<DomainLoad> part(rankCount);
+        for (size_t i = begin; i < end; ++i) {
+            DomainLoad& domain = part[domains[i]];
+            domain.load += input.costs[i];
+            ++domain.elements;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int d = 0; d < rankCount; ++d) {
+            result.domains[d].load += part[d].load;
+            result.domains[d].elements += part[d].elements;
+        }
+    });
+    
+    // A node is on an interface when its elements lie in more than one
+    // domain; each of them exchanges it
+    ThreadPool::GetGlobal().ParallelFor(input.GetNodeCount(), kParallelGrain, [&](size_t begin, size_t end) {
+        std::vector<size_t> part(rankCount, 0);
+        std::vector<uint16_t> seen;
+        size_t shared = 0;
+        for (size_t n = begin; n < end; ++n) {
+            seen.clear();
+            for (size_t k = input.nodeOffsets[n]; k < input.nodeOffsets[n + 1]; ++k) {
+                const uint16_t domain = domains[input.nodeElements[k]];
+                if (std::find(seen.begin(), seen.end(), domain) == seen.end()) {
+                    seen.push_back(domain);
+                }
+            }
+            if (seen.size() > 1) {
+                ++shared;
+                for (uint16_t domain : seen) {
+                    ++part[domain];
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        result.interfaceNodes += shared;
+        for (int d = 0; d < rankCount; ++d) {
+            result.domains[d].interfaceNodes += part[d];
+        }
+    });
+    
+    // A cycle lasts as long as the slowest domain's elements and exchanges
+    double maxLoad = 0.0, slowest = 0.0;
+    for (const DomainLoad& domain : result.domains) {
+        result.totalLoad += domain.load;
+        maxLoad = std::max(maxLoad, domain.load);
+        slowest = std::max(slowest, domain.load + kInterfaceCost * static_cast<double>(domain.interfaceNodes));
+        result.maxInterfaceNodes = std::max(result.maxInterfaceNodes, domain.interfaceNodes);
+    }
+    if (result.totalLoad > 0.0) {
+        result.imbalance = maxLoad * rankCount / result.totalLoad - 1.0;
+        result.predictedSpeedup = result.totalLoad / slowest;
+        result.efficiency = result.predictedSpeedup / rankCount;
+    }
+    return result;
+}
+
+std::vector<Decomposition> DomainPartitioner::Sweep(const DecompositionInput& input, std::vector<int> rankCounts) {
+    for (int& ranks : rankCounts) {
+        ranks = std::clamp(ranks, 1, kMaxRanks);
+    }
+    std::sort(rankCounts.begin(), rankCounts.end());
+    rankCounts.erase(std::unique(rankCounts.begin(), rankCounts.end()), rankCounts.end());
+    
+    // Grouping the largest power of two's domains by 2^k gives each
+    // smaller one's
+    int finest = 0;
+    for (int ranks : rankCounts) {
+        if (IsPowerOfTwo(ranks)) {
+            finest = ranks;
+        }
+    }
+    std::vector<uint16_t> finestDomains;
+    if (finest > 0) {
+        finestDomains = Partition(input, finest);
+    }
+    
+    std::vector<Decomposition> results;
+    std::vector<uint16_t> domains;
+    for (int ranks : rankCounts) {
+        if (IsPowerOfTwo(ranks)) {
+            int shift = 0;
+            while ((ranks << shift) < finest) {
+                ++shift;
+            }
+            domains.resize(finestDomains.size());
+            for (size_t i = 0; i < domains.size(); ++i) {
+                domains[i] = static_cast<uint16_t>(finestDomains[i] >> shift);
+            }
+        } else {
+            domains = Partition(input, ranks);
+        }
+        results.push_back(Evaluate(input, domains, ranks));
+    }
+    return results;
+}
+
+DecompositionPreview::~DecompositionPreview() {
+    // The task calls back into its owner
+    if (m_Worker.valid()) {
+        m_Worker.wait();
+    }
+}
+
+void DecompositionPreview::Start(const Model& model, const std::vector<int>& rankCounts,
+                                 std::function<void()> done) {
+    if (IsRunning()) {
+        return;
+    }
+    if (m_Worker.valid()) {
+        m_Worker.wait();
+    }
+    
+    auto input = std::make_shared<DecompositionInput>(DomainPartitioner::Gather(model));
+    m_ElementCount = input->GetElementCount();
+    auto promise = std::make_shared<std::promise<Outcome>>();
+    m_Task = promise->get_future();
+    m_Worker = ThreadPool::GetGlobal().Submit([input, rankCounts, promise, done]() {
+        try {
+            auto start = std::chrono::steady_clock::now();
+            Outcome outcome;
+            outcome.results = DomainPartitioner::Sweep(*input, rankCounts);
+            outcome.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            promise->set_value(std::move(outcome));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+        if (done) {
+            done();
+        }
+    });
+}
+
+bool DecompositionPreview::Poll() {
+    if (!m_Task.valid() || m_Task.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+    try {
+        Outcome outcome = m_Task.get();
+        m_Results = std::move(outcome.results);
+        m_Seconds = outcome.seconds;
+        LOG_INFO("Decomposition sweep of {} rank counts took {:.2f} s", m_Results.size(), m_Seconds);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Decomposition sweep failed: {}", e.what());
+    }
+    return true;
+}
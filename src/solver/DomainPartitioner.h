@@ -0,0 +1,99 @@
+#pragma once
+#include "core/Element.h"
+#include "core/Material.h"
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Model;
+
+// What the partitioner reads of a model, copied out so a sweep can run on a
+// worker while the model is edited
+struct DecompositionInput {
+    std::vector<glm::vec3> centroids;
+    std::vector<float> costs;           // Per element and cycle, see GetElementCost
+    std::vector<size_t> nodeOffsets;    // Elements of each node, as in NodeAdjacency
+    std::vector<uint32_t> nodeElements;
+    
+    size_t GetElementCount() const { return centroids.size(); }
+    size_t GetNodeCount() const { return nodeOffsets.empty() ? 0 : nodeOffsets.size() - 1; }
+};
+
+struct DomainLoad {
+    double load = 0.0;
+    size_t elements = 0;
+    size_t interfaceNodes = 0;   // Its nodes that other domains share
+};
+
+// One rank count's decomposition, as the figures that decide whether it
+// is worth running
+struct Decomposition {
+    int rankCount = 0;
+    std::vector<DomainLoad> domains;
+    double totalLoad = 0.0;
+    double imbalance = 0.0;           // Heaviest domain over the mean, less one
+    size_t interfaceNodes = 0;        // Nodes in more than one domain
+    size_t maxInterfaceNodes = 0;     // Of any one domain
+    double predictedSpeedup = 0.0;    // Against one rank, exchanges included
+    double efficiency = 0.0;          // Speedup per rank
+};
+
+// Recursive coordinate bisection of element centroids, weighted by the
+// cost model, as a preview of how a rank count would balance. Each cut
+// goes across the longest side of its part, at the weighted split a
+// histogram finds and a sort of the one bin it falls in makes exact.
+// Both halves, and the passes over a large part, run on the global pool.
+// A cut into equal rank counts does not depend on how either half is cut
+// further, so the power-of-two counts of a sweep come from one bisection
+// of the largest.
+class DomainPartitioner {
+public:
+    static constexpr int kMaxRanks = 4096;
+    static constexpr double kInterfaceCost = 0.25;   // Exchange of a node per cycle, in 4-node shells
+    
+    // Relative cost of an element per cycle; a 4-node shell of an elastic
+    // law is 1
+    static float GetElementCost(ElementType type, MaterialType law);
+    
+    // GUI thread; reads the model's node adjacency
+    static DecompositionInput Gather(const Model& model);
+    
+    // Domain of each element, numbered in bisection order
+    static std::vector<uint16_t> Partition(const DecompositionInput& input, int rankCount);
+    static Decomposition Evaluate(const DecompositionInput& input, const std::vector<uint16_t>& domains,
+                                  int rankCount);
+    
+    // Sorted by rank count, one per distinct count in [1, kMaxRanks]
+    static std::vector<Decomposition> Sweep(const DecompositionInput& input, std::vector<int> rankCounts);
+};
+
+// A sweep in the background: Start gathers on the calling thread and hands
+// the rest to the pool, calling done there when it is over
+class DecompositionPreview {
+public:
+    ~DecompositionPreview();
+    
+    void Start(const Model& model, const std::vector<int>& rankCounts, std::function<void()> done);
+    bool IsRunning() const { return m_Task.valid(); }
+    
+    // True once when a sweep's results have arrived
+    bool Poll();
+    
+    const std::vector<Decomposition>& GetResults() const { return m_Results; }
+    double GetSeconds() const { return m_Seconds; }   // Of the last sweep
+    size_t GetElementCount() const { return m_ElementCount; }
+
+private:
+    struct Outcome {
+        std::vector<Decomposition> results;
+        double seconds = 0.0;
+    };
+    
+    std::future<Outcome> m_Task;   // Ready before done is called
+    std::future<void> m_Worker;    // Over once done has returned
+    std::vector<Decomposition> m_Results;
+    double m_Seconds = 0.0;
+    size_t m_ElementCount = 0;
+};
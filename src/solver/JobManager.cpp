@@ -0,0 +1,294 @@
+#include "solver/JobManager.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+int GetThreads(const SolverConfig& config) {
+    return std::max(config.numThreads, 1);
+}
+
+} // namespace
+
+JobManager::JobManager() {
+    m_Budget.cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+JobManager::~JobManager() {
+    // Each solver joins its thread as it goes
+    CancelAll();
+    m_Jobs.clear();
+}
+
+void JobManager::SetBudget(const JobBudget& budget) {
+    // Running jobs keep their cores; queued ones that no longer fit wait
+    // for the budget to grow again
+    m_Budget = budget;
+    m_Budget.cores = std::max(m_Budget.cores, 1);
+    m_Budget.memoryGB = std::max(m_Budget.memoryGB, 0.0);
+}
+
+void JobManager::SetWakeCallback(std::function<void()> callback) {
+    m_WakeCallback = std::move(callback);
+}
+
+JobId JobManager::Submit(const JobSpec& spec) {
+    const int ranks = GetRanks(spec.config);
+    const int threads = GetThreads(spec.config);
+    const int minRanks = spec.config.useMPI && spec.minRanks > 0 ? std::min(spec.minRanks, ranks) : ranks;
+    if (ranks < 1 || minRanks * threads > m_Budget.cores) {
+        LOG_ERROR("Job {} needs {} cores, the budget has {}", spec.name, minRanks * threads, m_Budget.cores);
+        return 0;
+    }
+    if (m_Budget.memoryGB > 0.0 && spec.memoryGB > m_Budget.memoryGB) {
+        LOG_ERROR("Job {} needs {} GB, the budget has {}", spec.name, spec.memoryGB, m_Budget.memoryGB);
+        return 0;
+    }
+    for (JobId dependency : spec.dependencies) {
+        if (!Find(dependency)) {
+            LOG_ERROR("Job {} depends on unknown job {}", spec.name, dependency);
+            return 0;
+        }
+    }
+    
+    Job job;
+    job.id = m_NextId++;
+    job.spec = spec;
+    m_Jobs.push_back(std::move(job));
+    LOG_INFO("Queued job {} ({})", m_Jobs.back().id, spec.name);
+    return m_Jobs.back().id;
+}
+
+bool JobManager::Cancel(JobId id) {
+    Job* job = Find(id);
+    if (!job) {
+        return false;
+    }
+    if (job->state == JobState::QUEUED) {
+        job->state = JobState::CANCELLED;
+        job->reason = "Cancelled";
+        return true;
+    }
+    if (job->state == JobState::RUNNING && !job->cancelRequested) {
+        job->cancelRequested = true;
+        job->solver->CancelSolver();
+        return true;
+    }
+    return false;
+}
+
+void JobManager::CancelAll() {
+    for (Job& job : m_Jobs) {
+        Cancel(job.id);
+    }
+}
+
+void JobManager::ClearFinished() {
+    // Dependents of a failed job go with it; a dependency that is no
+    // longer listed has completed
+    while (CancelDependents()) {
+    }
+    m_Jobs.erase(std::remove_if(m_Jobs.begin(), m_Jobs.end(), [](const Job& job) {
+        return job.state != JobState::QUEUED && job.state != JobState::RUNNING;
+    }), m_Jobs.end());
+}
+
+void JobManager::Update() {
+    // Runs first, so the cores of any that ended are free below
+    for (Job& job : m_Jobs) {
+        if (job.state != JobState::RUNNING) {
+            continue;
+        }
+        job.solver->GetLog().Drain();
+        job.solver->GetTelemetry().Drain();
+        job.progress = job.solver->GetProgress();
+        if (job.solver->GetStatus() != SolverStatus::RUNNING) {
+            Finish(job);
+        }
+    }
+    while (CancelDependents()) {
+    }
+    
+    std::vector<Job*> ready;
+    for (Job& job : m_Jobs) {
+        if (job.state != JobState::QUEUED) {
+            continue;
+        }
+        bool waiting = false;
+        for (JobId dependency : job.spec.dependencies) {
+            const Job* other = Find(dependency);
+            waiting = waiting || (other && other->state != JobState::COMPLETED);
+        }
+        if (!waiting) {
+            ready.push_back(&job);
+        }
+    }
+    std::stable_sort(ready.begin(), ready.end(), [](const Job* a, const Job* b) {
+        return a->spec.priority > b->spec.priority;
+    });
+    
+    // The first job that does not fit is held back for; the ones started
+    // past it count against kMaxBypasses
+    Job* blocked = nullptr;
+    for (Job* job : ready) {
+        if (blocked && blocked->bypasses >= kMaxBypasses) {
+            break;
+        }
+        const SolverConfig& config = job->spec.config;
+        const int threads = GetThreads(config);
+        const int freeCores = m_Budget.cores - m_CoresInUse;
+        int ranks = GetRanks(config);
+        if (ranks * threads > freeCores && config.useMPI && job->spec.minRanks > 0) {
+            ranks = std::max(freeCores / threads, std::min(job->spec.minRanks, ranks));
+        }
+        const bool memoryFits = m_Budget.memoryGB <= 0.0 ||
+                                m_MemoryInUse + job->spec.memoryGB <= m_Budget.memoryGB;
+        if (!memoryFits || ranks * threads > freeCores) {
+            if (!blocked) {
+                blocked = job;
+            }
+            continue;
+        }
+        Start(*job, ranks);
+        if (blocked) {
+            ++blocked->bypasses;
+        }
+    }
+    ReleaseOldSolvers();
+}
+
+const Job* JobManager::FindJob(JobId id) const {
+    auto it = std::find_if(m_Jobs.begin(), m_Jobs.end(), [id](const Job& job) { return job.id == id; });
+    return it != m_Jobs.end() ? &*it : nullptr;
+}
+
+Job* JobManager::Find(JobId id) {
+    return const_cast<Job*>(FindJob(id));
+}
+
+SolverInterface* JobManager::GetSolver(JobId id) {
+    Job* job = Find(id);
+    return job ? job->solver.get() : nullptr;
+}
+
+bool JobManager::IsBusy() const {
+    return GetCount(JobState::QUEUED) > 0 || GetCount(JobState::RUNNING) > 0;
+}
+
+size_t JobManager::GetCount(JobState state) const {
+    return static_cast<size_t>(std::count_if(m_Jobs.begin(), m_Jobs.end(),
+                                             [state](const Job& job) { return job.state == state; }));
+}
+
+double JobManager::GetThroughput() const {
+    if (m_Completed == 0) {
+        return 0.0;
+    }
+    // An idle queue stops the clock at its last completion
+    const auto end = IsBusy() ? std::chrono::steady_clock::now() : m_LastFinish;
+    const double hours = std::chrono::duration<double>(end - m_FirstStart).count() / 3600.0;
+    return hours > 0.0 ? static_cast<double>(m_Completed) / hours : 0.0;
+}
+
+bool JobManager::CancelDependents() {
+    bool changed = false;
+    for (Job& job : m_Jobs) {
+        if (job.state != JobState::QUEUED) {
+            continue;
+        }
+        for (JobId dependency : job.spec.dependencies) {
+            const Job* other = Find(dependency);
+            if (other && (other->state == JobState::FAILED || other->state == JobState::CANCELLED)) {
+                job.state = JobState::CANCELLED;
+                job.reason = "Job " + std::to_string(dependency) + " did not complete";
+                changed = true;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+void JobManager::Start(Job& job, int ranks) {
+    SolverConfig config = job.spec.config;
+    config.numProcessors = ranks;
+    
+    job.ranks = ranks;
+    job.cores = ranks * GetThreads(config);
+    job.state = JobState::RUNNING;
+    job.progress = 0.0f;
+    job.bypasses = 0;
+    job.reason.clear();
+    ++job.attempts;
+    job.started = std::chrono::steady_clock::now();
+    if (!m_HasStarted) {
+        m_HasStarted = true;
+        m_FirstStart = job.started;
+    }
+    m_CoresInUse += job.cores;
+    m_MemoryInUse += job.spec.memoryGB;
+    m_LastStarted = job.id;
+    
+    job.solver = std::make_unique<SolverInterface>();
+    std::function<void()> wake = m_WakeCallback;
+    if (wake) {
+        job.solver->SetLogCallback([wake](const std::string&) { wake(); });
+        job.solver->SetProgressCallback([wake](float) { wake(); });
+        job.solver->SetCompletionCallback([wake](bool) { wake(); });
+    }
+    job.solver->SetConfig(config);
+    LOG_INFO("Starting job {} ({}), attempt {}, on {} ranks of {} threads", job.id, job.spec.name,
+             job.attempts, ranks, GetThreads(config));
+    job.solver->RunSolverAsync();
+}
+
+void JobManager::Finish(Job& job) {
+    m_CoresInUse -= job.cores;
+    m_MemoryInUse = std::max(m_MemoryInUse - job.spec.memoryGB, 0.0);
+    job.finished = std::chrono::steady_clock::now();
+    
+    switch (job.solver->GetStatus()) {
+        case SolverStatus::COMPLETED:
+            job.state = JobState::COMPLETED;
+            job.progress = 1.0f;
+            ++m_Completed;
+            m_LastFinish = job.finished;
+            LOG_INFO("Job {} ({}) completed", job.id, job.spec.name);
+            break;
+        case SolverStatus::CANCELLED:
+            job.state = JobState::CANCELLED;
+            job.reason = "Cancelled";
+            break;
+        default:
+            if (!job.cancelRequested && job.attempts <= job.spec.maxRetries) {
+                job.state = JobState::QUEUED;
+                job.reason = "Attempt " + std::to_string(job.attempts) + " failed";
+                LOG_WARN("Job {} ({}) failed, queued again", job.id, job.spec.name);
+            } else {
+                job.state = JobState::FAILED;
+                job.reason = "Solver failed";
+                LOG_ERROR("Job {} ({}) failed after {} attempts", job.id, job.spec.name, job.attempts);
+            }
+            break;
+    }
+    job.cancelRequested = false;
+}
+
+void JobManager::ReleaseOldSolvers() {
+    std::vector<Job*> finished;
+    for (Job& job : m_Jobs) {
+        if (job.state != JobState::RUNNING && job.solver) {
+            finished.push_back(&job);
+        }
+    }
+    if (finished.size() <= kKeptSolvers) {
+        return;
+    }
+    std::sort(finished.begin(), finished.end(), [](const Job* a, const Job* b) {
+        return a->finished > b->finished;
+    });
+    for (size_t i = kKeptSolvers; i < finished.size(); ++i) {
+        finished[i]->solver.reset();
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "solver/SolverInterface.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using JobId = uint64_t;   // 0 is no job
+
+enum class JobState {
+    QUEUED,
+    RUNNING,
+    COMPLETED,
+    FAILED,
+    CANCELLED
+};
+
+// A run and what it needs. Its cores are its MPI ranks (config.numProcessors,
+// one without MPI) times config.numThreads.
+struct JobSpec {
+    std::string name;
+    SolverConfig config;
+    double memoryGB = 0.0;             // Estimate for the whole run; 0 is not counted
+    int minRanks = 0;                  // May start on fewer ranks, down to this, when cores are short; 0 = fixed
+    int priority = 0;                  // Higher starts first
+    std::vector<JobId> dependencies;   // Must have completed first
+    int maxRetries = 0;                // Further attempts after a failure
+};
+
+struct Job {
+    JobId id = 0;
+    JobSpec spec;
+    JobState state = JobState::QUEUED;
+    int attempts = 0;
+    int ranks = 0;                    // As started
+    int cores = 0;
+    float progress = 0.0f;
+    int bypasses = 0;                 // Jobs started ahead of it while it waited for cores
+    bool cancelRequested = false;
+    std::string reason;               // Why it failed or was cancelled
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point finished;
+    std::unique_ptr<SolverInterface> solver;   // While running and for the last few finished
+};
+
+// Machine share the queue may fill
+struct JobBudget {
+    int cores = 1;
+    double memoryGB = 0.0;   // 0 is unlimited
+};
+
+// Queue of solver runs, for parameter sweeps. Jobs start by priority, then
+// in order of submission, as soon as their dependencies have completed and
+// the budget has their cores and memory; a job that does not fit lets
+// smaller ones start past it, but only kMaxBypasses times before the cores
+// are held for it. Failed runs are tried again up to their retry count,
+// and jobs depending on one that failed or was cancelled are cancelled.
+//
+// GUI thread only; the runs report on their own threads through the wake
+// callback, after which Update should be called.
+class JobManager {
+public:
+    static constexpr int kMaxBypasses = 8;
+    static constexpr size_t kKeptSolvers = 8;   // Finished runs whose output stays viewable
+    
+    JobManager();    // All hardware threads, memory unlimited
+    ~JobManager();   // Cancels the running jobs and waits for them
+    
+    void SetBudget(const JobBudget& budget);
+    const JobBudget& GetBudget() const { return m_Budget; }
+    
+    // Called on the solver threads when a run has new output or ends
+    void SetWakeCallback(std::function<void()> callback);
+    
+    // 0 when the job could never start: more cores or memory than the
+    // budget, or an unknown dependency
+    JobId Submit(const JobSpec& spec);
+    
+    // A queued job is cancelled at once, a running one once it has stopped
+    bool Cancel(JobId id);
+    void CancelAll();
+    void ClearFinished();
+    
+    // Drains the runs' output, collects the finished ones and starts
+    // whatever fits; once a frame
+    void Update();
+    
+    const std::vector<Job>& GetJobs() const { return m_Jobs; }
+    const Job* FindJob(JobId id) const;
+    SolverInterface* GetSolver(JobId id);   // Null once released
+    JobId GetLastStarted() const { return m_LastStarted; }
+    
+    bool IsBusy() const;   // Jobs queued or running
+    size_t GetCount(JobState state) const;
+    int GetCoresInUse() const { return m_CoresInUse; }
+    double GetMemoryInUse() const { return m_MemoryInUse; }
+    
+    // Completed jobs per wall hour since the first started; 0 until one has
+    // completed
+    double GetThroughput() const;
+
+private:
+    static int GetRanks(const SolverConfig& config) { return config.useMPI ? config.numProcessors : 1; }
+    
+    Job* Find(JobId id);
+    bool CancelDependents();   // True when any was cancelled
+    void Start(Job& job, int ranks);
+    void Finish(Job& job);
+    void ReleaseOldSolvers();
+
+private:
+    JobBudget m_Budget;
+    std::function<void()> m_WakeCallback;
+    std::vector<Job> m_Jobs;   // In order of submission
+    JobId m_NextId = 1;
+    JobId m_LastStarted = 0;
+    int m_CoresInUse = 0;
+    double m_MemoryInUse = 0.0;
+    
+    // For throughput
+    size_t m_Completed = 0;
+    bool m_HasStarted = false;
+    std::chrono::steady_clock::time_point m_FirstStart;
+    std::chrono::steady_clock::time_point m_LastFinish;
+};
@@ -1,41 +1,119 @@
 #include "solver/SolverInterface.h"
 #include "utils/Logger.h"
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
 #ifdef _WIN32
     #include <windows.h>
     #include <process.h>
 #else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <poll.h>
     #include <unistd.h>
     #include <sys/wait.h>
 #endif
 
+namespace {
+
+// Engine output is read this much at a time, and the pipe polled this
+// often for a cancel while it is quiet
+constexpr size_t kReadChunkSize = 64 * 1024;
+constexpr int kPollTimeoutMs = 100;
+
+} // namespace
+
 SolverInterface::SolverInterface() 
     : m_Status(SolverStatus::IDLE), m_Progress(0.0f), m_CancelRequested(false) {
 }
 
+SolverInterface::~SolverInterface() {
+    CancelSolver();
+    if (m_SolverThread.joinable()) {
+        m_SolverThread.join();
+    }
+}
+
+void SolverInterface::SetConfig(const SolverConfig& config) {
+    m_Config = config;
+}
+
+void SolverInterface::RunSolver() {
+    if (m_Status == SolverStatus::RUNNING) {
+        LOG_WARN("Solver is already running");
+        return;
+    }
+    if (m_SolverThread.joinable()) {
+        m_SolverThread.join();
+    }
+    
+    m_Status = SolverStatus::RUNNING;
+    m_Progress = 0.0f;
+    m_CancelRequested = false;
+    m_Log.Clear();
+    m_Telemetry.Reset(m_Config.endTime);
+    m_Parser = ListingParser();
+    ExecuteSolver();
+}
+
+void SolverInterface::CancelSolver() {
+    if (m_Status == SolverStatus::RUNNING) {
+        m_CancelRequested = true;
+    }
+}
+
+void SolverInterface::SetProgressCallback(std::function<void(float)> callback) {
+    m_ProgressCallback = std::move(callback);
+}
+
+void SolverInterface::SetCompletionCallback(std::function<void(bool)> callback) {
+    m_CompletionCallback = std::move(callback);
+}
+
+void SolverInterface::SetLogCallback(std::function<void(const std::string&)> callback) {
+    m_LogCallback = std::move(callback);
+}
+
 std::string SolverInterface::BuildCommandLine() const {
     std::stringstream cmd;
     
     // Build starter command
-    cmd << m_Config.solverPath << "/starter_linux64_gf ";
+    cmd << GetCommandPrefix() << m_Config.solverPath << "/starter_linux64_gf ";
     cmd << "-i " << m_Config.inputFile << " ";
     cmd << "-np " << m_Config.numProcessors;
     
     return cmd.str();
 }
 
+std::string SolverInterface::GetCommandPrefix() const {
+    // Runs of a sweep each write their files in their own directory
+    if (m_Config.workingDirectory.empty()) {
+        return std::string();
+    }
+    return "cd \"" + m_Config.workingDirectory + "\" && ";
+}
+
 void SolverInterface::RunSolverAsync() {
     if (m_Status == SolverStatus::RUNNING) {
         LOG_WARN("Solver is already running");
         return;
     }
     
+    // The last run's thread has finished, so the log has no producer
+    if (m_SolverThread.joinable()) {
+        m_SolverThread.join();
+    }
+    
     m_Status = SolverStatus::RUNNING;
     m_Progress = 0.0f;
     m_CancelRequested = false;
+    m_Log.Clear();
+    m_Telemetry.Reset(m_Config.endTime);
+    m_Parser = ListingParser();
     
     m_SolverThread = std::thread(&SolverInterface::ExecuteSolver, this);
 }
@@ -47,107 +125,136 @@ void SolverInterface::ExecuteSolver() {
     LOG_INFO("Executing: {}", starterCmd);
     
     // Execute starter
-    FILE* pipe = popen(starterCmd.c_str(), "r");
-    if (!pipe) {
+    int result = RunProcess(starterCmd);
+    if (result < 0) {
         LOG_ERROR("Failed to execute solver");
+    } else if (result == 0 && !m_CancelRequested) {
+        // Now run engine
+        std::stringstream engineCmd;
+        engineCmd << GetCommandPrefix();
+        if (m_Config.useMPI) {
+            engineCmd << "mpirun -np " << m_Config.numProcessors << " ";
+            engineCmd << m_Config.solverPath << "/engine_linux64_gf_ompi ";
+        } else {
+            engineCmd << m_Config.solverPath << "/engine_linux64_gf ";
+        }
+        engineCmd << "-i " << m_Config.inputFile << "_0001.rad";
+        if (m_Config.numThreads > 1) {
+            engineCmd << " -nt " << m_Config.numThreads;
+        }
+        
+        LOG_INFO("Executing engine: {}", engineCmd.str());
+        m_Parser.StartClock();
+        result = RunProcess(engineCmd.str());
+    }
+    
+    if (m_CancelRequested) {
+        m_Status = SolverStatus::CANCELLED;
+        LOG_INFO("Solver cancelled by user");
+        
+        if (m_CompletionCallback) {
+            m_CompletionCallback(false);
+        }
+    } else if (result == 0) {
+        m_Status = SolverStatus::COMPLETED;
+        m_Progress = 1.0f;
+        LOG_INFO("Solver completed successfully");
+        
+        if (m_CompletionCallback) {
+            m_CompletionCallback(true);
+        }
+    } else {
         m_Status = SolverStatus::ERROR;
+        LOG_ERROR("Solver failed with code: {}", result);
+        
         if (m_CompletionCallback) {
             m_CompletionCallback(false);
         }
-        return;
+    }
+}
+
+int SolverInterface::RunProcess(const std::string& command) {
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        return -1;
     }
     
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        if (m_CancelRequested) {
-            pclose(pipe);
-            m_Status = SolverStatus::CANCELLED;
-            LOG_INFO("Solver cancelled by user");
+    // Output is read in large chunks as it comes and cut into lines here;
+    // the pipe does not block, so a cancel is seen within a poll interval
+    // even while the solver is quiet
+    std::vector<char> chunk(kReadChunkSize);
+    std::string pending;
+#ifdef _WIN32
+    size_t count = 0;
+    while (!m_CancelRequested && (count = fread(chunk.data(), 1, chunk.size(), pipe)) > 0) {
+        ConsumeOutput(chunk.data(), count, pending);
+    }
+#else
+    int fd = fileno(pipe);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    while (!m_CancelRequested) {
+        pollfd request{fd, POLLIN, 0};
+        int ready = poll(&request, 1, kPollTimeoutMs);
+        if (ready < 0 && errno != EINTR) {
             break;
         }
-        
-        std::string line(buffer);
-        m_OutputLog += line;
-        
-        ParseOutput(line);
-        
-        if (m_LogCallback) {
-            m_LogCallback(line);
+        if (ready <= 0) {
+            continue;
+        }
+        ssize_t count = read(fd, chunk.data(), chunk.size());
+        if (count > 0) {
+            ConsumeOutput(chunk.data(), static_cast<size_t>(count), pending);
+        } else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            break;   // End of output
         }
     }
-    
-    int result = pclose(pipe);
-    
-    if (!m_CancelRequested) {
-        if (result == 0) {
-            // Now run engine
-            std::stringstream engineCmd;
-            if (m_Config.useMPI) {
-                engineCmd << "mpirun -np " << m_Config.numProcessors << " ";
-                engineCmd << m_Config.solverPath << "/engine_linux64_gf_ompi ";
-            } else {
-                engineCmd << m_Config.solverPath << "/engine_linux64_gf ";
-            }
-            engineCmd << "-i " << m_Config.inputFile << "_0001.rad";
-            
-            LOG_INFO("Executing engine: {}", engineCmd.str());
-            
-            pipe = popen(engineCmd.str().c_str(), "r");
-            if (pipe) {
-                while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                    if (m_CancelRequested) {
-                        pclose(pipe);
-                        m_Status = SolverStatus::CANCELLED;
-                        break;
-                    }
-                    
-                    std::string line(buffer);
-                    m_OutputLog += line;
-                    ParseOutput(line);
-                    
-                    if (m_LogCallback) {
-                        m_LogCallback(line);
-                    }
-                }
-                
-                result = pclose(pipe);
-                if (result == 0 && !m_CancelRequested) {
-                    m_Status = SolverStatus::COMPLETED;
-                    m_Progress = 1.0f;
-                    LOG_INFO("Solver completed successfully");
-                    
-                    if (m_CompletionCallback) {
-                        m_CompletionCallback(true);
-                    }
-                }
-            }
-        } else {
-            m_Status = SolverStatus::ERROR;
-            LOG_ERROR("Solver failed with code: {}", result);
-            
-            if (m_CompletionCallback) {
-                m_CompletionCallback(false);
-            }
+#endif
+    if (!pending.empty()) {
+        EmitLine(std::move(pending));
+    }
+    return pclose(pipe);
+}
+
+void SolverInterface::ConsumeOutput(const char* data, size_t size, std::string& pending) {
+    // pending holds a line cut off by the end of the previous chunk
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+        if (!newline) {
+            pending.append(data, static_cast<size_t>(end - data));
+            break;
+        }
+        pending.append(data, static_cast<size_t>(newline - data));
+        if (!pending.empty() && pending.back() == '\r') {
+            pending.pop_back();
         }
+        EmitLine(std::move(pending));
+        pending.clear();
+        data = newline + 1;
+    }
+}
+
+void SolverInterface::EmitLine(std::string&& line) {
+    ParseOutput(line);
+    if (m_LogCallback) {
+        m_LogCallback(line);
     }
+    m_Log.Push(std::move(line));
 }
 
 void SolverInterface::ParseOutput(const std::string& line) {
-    // Parse OpenRadioss output for progress
-    if (line.find("CYCLE") != std::string::npos) {
-        // Extract cycle number and calculate progress
-        std::size_t pos = line.find("CYCLE");
-        if (pos != std::string::npos) {
-            std::istringstream iss(line.substr(pos + 5));
-            int cycle;
-            if (iss >> cycle) {
-                // Estimate progress (this is simplified)
-                m_Progress = std::min(1.0f, cycle / 10000.0f);
-                
-                if (m_ProgressCallback) {
-                    m_ProgressCallback(m_Progress);
-                }
-            }
+    // Cycle rows of the engine listing; progress is simulated time
+    // against the end time
+    TelemetrySample sample;
+    if (!m_Parser.ParseLine(line, sample)) {
+        return;
+    }
+    m_Telemetry.Push(sample);
+    if (m_Config.endTime > 0.0f) {
+        m_Progress = static_cast<float>(std::clamp(sample.time / m_Config.endTime, 0.0, 1.0));
+        
+        if (m_ProgressCallback) {
+            m_ProgressCallback(m_Progress);
         }
     }
-}
\ No newline at end of file
+}
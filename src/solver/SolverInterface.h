@@ -1,4 +1,6 @@
 #pragma once
+#include "solver/SolverLog.h"
+#include "solver/SolverTelemetry.h"
 #include <string>
 #include <functional>
 #include <thread>
@@ -8,7 +10,8 @@ struct SolverConfig {
     std::string solverPath;
     std::string workingDirectory;
     std::string inputFile;
-    int numProcessors = 1;
+    int numProcessors = 1;   // Domains, and MPI ranks with useMPI
+    int numThreads = 1;      // OpenMP threads per rank
     bool useMPI = false;
     float endTime = 1.0f;
     float timeStep = 0.0f;  // 0 = auto
@@ -38,23 +41,36 @@ public:
     // Status
     SolverStatus GetStatus() const { return m_Status; }
     float GetProgress() const { return m_Progress; }
-    std::string GetOutputLog() const { return m_OutputLog; }
     
-    // Callbacks
+    // Output of the current or last run, drained by the GUI thread
+    SolverLog& GetLog() { return m_Log; }
+    
+    // Progress, rates and the time series of the engine's cycle rows,
+    // likewise drained by the GUI thread; GetProgress follows its time
+    SolverTelemetry& GetTelemetry() { return m_Telemetry; }
+    
+    // Callbacks, called on the solver's thread; the log callback once per
+    // line, the completion callback when a run ends, true if it succeeded
     void SetProgressCallback(std::function<void(float)> callback);
     void SetCompletionCallback(std::function<void(bool)> callback);
     void SetLogCallback(std::function<void(const std::string&)> callback);
     
 private:
     void ExecuteSolver();
+    int RunProcess(const std::string& command);   // Streams its output; the exit status, -1 without a process
+    void ConsumeOutput(const char* data, size_t size, std::string& pending);
+    void EmitLine(std::string&& line);
     void ParseOutput(const std::string& line);
     std::string BuildCommandLine() const;
+    std::string GetCommandPrefix() const;   // Into the working directory, if any
     
 private:
     SolverConfig m_Config;
     std::atomic<SolverStatus> m_Status;
     std::atomic<float> m_Progress;
-    std::string m_OutputLog;
+    SolverLog m_Log;
+    SolverTelemetry m_Telemetry;
+    ListingParser m_Parser;   // Solver thread's
     
     std::thread m_SolverThread;
     std::atomic<bool> m_CancelRequested;
@@ -0,0 +1,41 @@
+#include "solver/SolverLog.h"
+
+SolverLog::SolverLog()
+    : m_Ring(kRingLines), m_Dropped(0), m_FirstLine(0) {
+}
+
+void SolverLog::Push(std::string&& line) {
+    if (line.size() > kMaxLineLength) {
+        line.resize(kMaxLineLength);
+    }
+    if (!m_Ring.TryPush(std::move(line))) {
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t SolverLog::Drain() {
+    // At most a ring's worth, so a producer as fast as this cannot keep it here
+    size_t count = 0;
+    std::string line;
+    while (count < m_Ring.GetCapacity() && m_Ring.TryPop(line)) {
+        m_History.push_back(std::move(line));
+        ++count;
+    }
+    
+    // Amortised: trimmed once the history overshoots by a tenth
+    if (m_History.size() > kHistoryLines + kHistoryLines / 10) {
+        size_t excess = m_History.size() - kHistoryLines;
+        m_History.erase(m_History.begin(), m_History.begin() + static_cast<std::ptrdiff_t>(excess));
+        m_FirstLine += excess;
+    }
+    return count;
+}
+
+void SolverLog::Clear() {
+    std::string line;
+    while (m_Ring.TryPop(line)) {
+    }
+    m_History.clear();
+    m_FirstLine = 0;
+    m_Dropped.store(0, std::memory_order_relaxed);
+}
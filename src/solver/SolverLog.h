@@ -0,0 +1,45 @@
+#pragma once
+#include "utils/SpscRing.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// Solver output on its way from the solver's thread to the GUI. The
+// solver thread queues whole lines in a bounded lock-free ring; a line
+// that finds the ring full is counted and dropped, so a chatty run never
+// waits on the GUI. Once a frame the GUI thread drains the ring into its
+// history, which keeps the last kHistoryLines and counts what it let go.
+class SolverLog {
+public:
+    static constexpr size_t kRingLines = 16384;
+    static constexpr size_t kHistoryLines = 100000;
+    static constexpr size_t kMaxLineLength = 1024;   // Longer lines are cut there
+    
+    SolverLog();
+    
+    // Solver thread
+    void Push(std::string&& line);
+    
+    // GUI thread. Drain returns the number of lines that arrived; Clear
+    // empties everything and must not overlap a run.
+    size_t Drain();
+    void Clear();
+    
+    // Lines in the history, the oldest first; GetFirstLineNumber is how
+    // many older ones the history has let go
+    size_t GetLineCount() const { return m_History.size(); }
+    const std::string& GetLine(size_t i) const { return m_History[i]; }
+    uint64_t GetFirstLineNumber() const { return m_FirstLine; }
+    
+    // Lines lost to a full ring, since the last Clear; any thread
+    uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+private:
+    SpscRing<std::string> m_Ring;
+    std::atomic<uint64_t> m_Dropped;
+    
+    // GUI thread's
+    std::deque<std::string> m_History;
+    uint64_t m_FirstLine;
+};
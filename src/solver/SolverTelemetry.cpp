@@ -0,0 +1,219 @@
+#include "solver/SolverTelemetry.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// Rates are only taken over at least this much wall time, so rows printed
+// in one burst do not make up a rate of their own
+constexpr double kMinRateInterval = 0.5;
+
+// Next number of a row; false when there is none
+bool ReadNumber(const char*& cursor, double& value) {
+    char* end = nullptr;
+    value = std::strtod(cursor, &end);
+    if (end == cursor) {
+        return false;
+    }
+    cursor = end;
+    return true;
+}
+
+void SkipSpace(const char*& cursor) {
+    while (*cursor == ' ' || *cursor == '\t') {
+        ++cursor;
+    }
+}
+
+} // namespace
+
+void ListingParser::StartClock() {
+    m_HasClock = true;
+    m_Start = std::chrono::steady_clock::now();
+}
+
+bool ListingParser::ParseLine(const std::string& line, TelemetrySample& sample) {
+    const char* cursor = line.c_str();
+    SkipSpace(cursor);
+    
+    // "ELAPSED TIME=    12.34 s  REMAINING TIME= ..."
+    if (!std::isdigit(static_cast<unsigned char>(*cursor))) {
+        const char* elapsed = std::strstr(cursor, "ELAPSED TIME");
+        if (elapsed) {
+            elapsed = std::strchr(elapsed, '=');
+            double value = 0.0;
+            if (elapsed && ReadNumber(++elapsed, value)) {
+                m_Elapsed = value;
+            }
+        }
+        return false;
+    }
+    
+    // "   1200   0.1200E-02 0.1000E-05 SHELL   1234   0.1%  ..." The cycle,
+    // time and step make a row; the energies after the critical element
+    // are read as far as they go
+    char* end = nullptr;
+    long long cycle = std::strtoll(cursor, &end, 10);
+    if (end == cursor || (*end != ' ' && *end != '\t')) {
+        return false;
+    }
+    cursor = end;
+    TelemetrySample row;
+    row.cycle = cycle;
+    if (!ReadNumber(cursor, row.time) || !ReadNumber(cursor, row.timeStep)) {
+        return false;
+    }
+    SkipSpace(cursor);
+    if (!std::isalpha(static_cast<unsigned char>(*cursor))) {
+        return false;
+    }
+    while (*cursor && *cursor != ' ' && *cursor != '\t') {
+        ++cursor;
+    }
+    double element = 0.0;
+    if (ReadNumber(cursor, element) && ReadNumber(cursor, row.energyError)) {
+        if (*cursor == '%') {
+            ++cursor;
+        }
+        double kineticRotational = 0.0;
+        if (ReadNumber(cursor, row.internalEnergy) && ReadNumber(cursor, row.kineticEnergy) &&
+            ReadNumber(cursor, kineticRotational)) {
+            row.kineticEnergy += kineticRotational;
+            if (ReadNumber(cursor, row.externalWork)) {
+                ReadNumber(cursor, row.massError);
+            }
+        }
+    }
+    
+    row.wallTime = m_HasClock
+        ? std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count()
+        : m_Elapsed;
+    sample = row;
+    return true;
+}
+
+SolverTelemetry::SolverTelemetry()
+    : m_Ring(kRingSamples), m_Dropped(0) {
+    Reset(0.0);
+}
+
+void SolverTelemetry::Push(const TelemetrySample& sample) {
+    TelemetrySample copy = sample;
+    if (!m_Ring.TryPush(std::move(copy))) {
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SolverTelemetry::Reset(double endTime) {
+    TelemetrySample sample;
+    while (m_Ring.TryPop(sample)) {
+    }
+    m_Dropped.store(0, std::memory_order_relaxed);
+    m_EndTime = endTime;
+    m_SampleCount = 0;
+    m_Stride = 1;
+    m_First = m_Latest = m_RateAnchor = TelemetrySample();
+    m_SimRate = 0.0;
+    m_CyclesPerSecond = 0.0;
+    m_HasRate = false;
+    m_TimeSteps.clear();
+    m_EnergyErrors.clear();
+    m_SimRates.clear();
+}
+
+size_t SolverTelemetry::Drain() {
+    size_t count = 0;
+    TelemetrySample sample;
+    while (count < m_Ring.GetCapacity() && m_Ring.TryPop(sample)) {
+        Add(sample);
+        ++count;
+    }
+    return count;
+}
+
+bool SolverTelemetry::LoadListing(const std::string& path, double endTime) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    Reset(endTime);
+    ListingParser parser;
+    std::string line;
+    TelemetrySample sample;
+    while (std::getline(file, line)) {
+        if (parser.ParseLine(line, sample)) {
+            Add(sample);
+        }
+    }
+    return true;
+}
+
+void SolverTelemetry::Add(const TelemetrySample& sample) {
+    if (m_SampleCount == 0) {
+        m_First = m_RateAnchor = sample;
+    }
+    
+    // Exponential smoothing over wall time, whatever the printout interval
+    const double wall = sample.wallTime - m_RateAnchor.wallTime;
+    if (wall >= kMinRateInterval) {
+        const double simRate = (sample.time - m_RateAnchor.time) / wall;
+        const double cycleRate = static_cast<double>(sample.cycle - m_RateAnchor.cycle) / wall;
+        const double weight = m_HasRate ? 1.0 - std::exp(-wall / kSmoothingTime) : 1.0;
+        m_SimRate += weight * (simRate - m_SimRate);
+        m_CyclesPerSecond += weight * (cycleRate - m_CyclesPerSecond);
+        m_HasRate = true;
+        m_RateAnchor = sample;
+    }
+    m_Latest = sample;
+    
+    if (m_SampleCount % m_Stride == 0) {
+        m_TimeSteps.push_back(static_cast<float>(sample.timeStep));
+        m_EnergyErrors.push_back(static_cast<float>(sample.energyError));
+        m_SimRates.push_back(m_HasRate ? static_cast<float>(GetSimMsPerWallHour()) : 0.0f);
+        if (m_TimeSteps.size() >= kMaxSamples) {
+            Decimate();
+        }
+    }
+    ++m_SampleCount;
+}
+
+void SolverTelemetry::Decimate() {
+    // Every other point goes, and from now on every other sample
+    for (std::vector<float>* series : {&m_TimeSteps, &m_EnergyErrors, &m_SimRates}) {
+        for (size_t i = 0; 2 * i < series->size(); ++i) {
+            (*series)[i] = (*series)[2 * i];
+        }
+        series->resize((series->size() + 1) / 2);
+    }
+    m_Stride *= 2;
+}
+
+double SolverTelemetry::GetProgress() const {
+    if (m_EndTime <= 0.0) {
+        return -1.0;
+    }
+    return HasSamples() ? std::clamp(m_Latest.time / m_EndTime, 0.0, 1.0) : 0.0;
+}
+
+double SolverTelemetry::GetEta() const {
+    if (m_EndTime <= 0.0 || !m_HasRate || m_SimRate <= 0.0) {
+        return -1.0;
+    }
+    return std::max(m_EndTime - m_Latest.time, 0.0) / m_SimRate;
+}
+
+double SolverTelemetry::GetCyclesPerSecond() const {
+    return m_HasRate ? m_CyclesPerSecond : -1.0;
+}
+
+double SolverTelemetry::GetSimMsPerWallHour() const {
+    return m_HasRate ? m_SimRate * 1000.0 * 3600.0 : -1.0;
+}
+
+bool SolverTelemetry::IsTimeStepCollapsing() const {
+    return HasSamples() && m_First.timeStep > 0.0 && m_Latest.timeStep < kCollapseRatio * m_First.timeStep;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "utils/SpscRing.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One row of the engine's cycle table, with the wall time it was printed at
+struct TelemetrySample {
+    double wallTime = 0.0;        // Seconds since the engine started
+    int64_t cycle = 0;
+    double time = 0.0;            // Simulation time
+    double timeStep = 0.0;
+    double energyError = 0.0;     // Energy balance error, in percent
+    double internalEnergy = 0.0;
+    double kineticEnergy = 0.0;   // Translational and rotational
+    double externalWork = 0.0;
+    double massError = 0.0;       // Added mass, relative
+};
+
+// Reads the engine listing, which its standard output and the run's .out
+// file print alike: cycle rows ("CYCLE TIME TIME-STEP ELEMENT ERROR
+// I-ENERGY ..." under the header) and "ELAPSED TIME=" lines. Wall times
+// come from the clock once StartClock was called, else from the last
+// elapsed time the listing gave.
+class ListingParser {
+public:
+    void StartClock();
+    
+    // True for a cycle row, filling sample
+    bool ParseLine(const std::string& line, TelemetrySample& sample);
+
+private:
+    bool m_HasClock = false;
+    std::chrono::steady_clock::time_point m_Start;
+    double m_Elapsed = 0.0;   // Last ELAPSED TIME of the listing
+};
+
+// Progress of a run from its cycle rows. The solver thread pushes samples
+// through a bounded lock-free ring, dropping them when it is full; the GUI
+// thread drains them into the series and the derived figures below, which
+// are smoothed over about kSmoothingTime of wall time. The series keep
+// the whole run, halving their resolution whenever they reach kMaxSamples.
+class SolverTelemetry {
+public:
+    static constexpr size_t kRingSamples = 4096;
+    static constexpr size_t kMaxSamples = 4096;
+    static constexpr double kSmoothingTime = 30.0;    // Seconds
+    static constexpr double kCollapseRatio = 0.1;     // Of the first time step
+    
+    SolverTelemetry();
+    
+    // Solver thread
+    void Push(const TelemetrySample& sample);
+    
+    // GUI thread. Reset and LoadListing must not overlap a run; an end
+    // time of 0 leaves progress and ETA unknown.
+    void Reset(double endTime);
+    size_t Drain();
+    bool LoadListing(const std::string& path, double endTime);
+    
+    bool HasSamples() const { return m_SampleCount > 0; }
+    const TelemetrySample& GetLatest() const { return m_Latest; }
+    double GetEndTime() const { return m_EndTime; }
+    uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }   // Any thread
+    
+    // Negative when unknown: progress without an end time, the rest
+    // before two samples a wall time apart
+    double GetProgress() const;
+    double GetEta() const;                       // Wall seconds left
+    double GetCyclesPerSecond() const;
+    double GetSimMsPerWallHour() const;         // Taking the model's time unit as seconds
+    
+    // The time step fell below kCollapseRatio of the run's first
+    bool IsTimeStepCollapsing() const;
+    
+    // For charts, one point per kept sample
+    const std::vector<float>& GetTimeSteps() const { return m_TimeSteps; }
+    const std::vector<float>& GetEnergyErrors() const { return m_EnergyErrors; }
+    const std::vector<float>& GetSimRates() const { return m_SimRates; }   // Sim ms per wall hour
+
+private:
+    void Add(const TelemetrySample& sample);
+    void Decimate();
+
+private:
+    SpscRing<TelemetrySample> m_Ring;
+    std::atomic<uint64_t> m_Dropped;
+    
+    // GUI thread's
+    double m_EndTime;
+    size_t m_SampleCount;      // Added since Reset, kept or not
+    size_t m_Stride;           // Samples per kept point
+    TelemetrySample m_First;
+    TelemetrySample m_Latest;
+    TelemetrySample m_RateAnchor;   // Rates are taken over wall time from here
+    double m_SimRate;          // Simulation time per wall second, smoothed
+    double m_CyclesPerSecond;
+    bool m_HasRate;
+    std::vector<float> m_TimeSteps;
+    std::vector<float> m_EnergyErrors;
+    std::vector<float> m_SimRates;
+};
@@ -0,0 +1,331 @@
+#include "solver/TimeStepEstimator.h"
+#include "core/Model.h"
+#include "utils/Lanes.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t kParallelGrain = 1u << 14;
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// Poisson's ratio is kept off the incompressible limit, where the solid
+// wave speed has no bound
+constexpr double kMinPoisson = -0.99;
+constexpr double kMaxPoisson = 0.499;
+
+using Lanes::Vec3;
+
+// Inverse wave speed of a material in each kind of element; zero for none
+struct Slowness {
+    float solid = 0.0f;
+    float shell = 0.0f;
+    float bar = 0.0f;
+};
+
+Slowness GetSlowness(const Material& material) {
+    const double rho = material.parameters.Get(Param::RHO);
+    const double e = material.parameters.Get(Param::E);
+    const double nu = std::clamp(material.parameters.Get(Param::NU), kMinPoisson, kMaxPoisson);
+    Slowness slowness;
+    if (rho <= 0.0 || e <= 0.0) {
+        return slowness;
+    }
+    slowness.solid = static_cast<float>(std::sqrt(rho * (1.0 + nu) * (1.0 - 2.0 * nu) / (e * (1.0 - nu))));
+    slowness.shell = static_cast<float>(std::sqrt(rho * (1.0 - nu * nu) / e));
+    slowness.bar = static_cast<float>(std::sqrt(rho / e));
+    return slowness;
+}
+
+float GetSlowness(const Slowness& slowness, ElementType type) {
+    switch (type) {
+        case ElementType::SHELL3:
+        case ElementType::SHELL4: return slowness.shell;
+        case ElementType::TETRA4:
+        case ElementType::HEXA8:  return slowness.solid;
+        case ElementType::BEAM2:  return slowness.bar;
+        default:                  return 0.0f;
+    }
+}
+
+template<typename T>
+T MaxSquaredSide(const Vec3<T>* corners, size_t count) {
+    T longest = Dot(corners[0] - corners[count - 1], corners[0] - corners[count - 1]);
+    for (size_t k = 1; k < count; ++k) {
+        const Vec3<T> side = corners[k] - corners[k - 1];
+        longest = Lanes::Max(longest, Dot(side, side));
+    }
+    return longest;
+}
+
+// Twice the area of a quad, from its diagonals
+template<typename T>
+T QuadArea2(const Vec3<T>& a, const Vec3<T>& b, const Vec3<T>& c, const Vec3<T>& d) {
+    return Lanes::Length(Cross(c - a, d - b));
+}
+
+// Characteristic length of each lane's element. Collapsed elements come
+// out as zero over zero, which the caller takes for a zero step.
+template<typename T>
+T GetLength(ElementType type, const float* x, const float* y, const float* z, const uint32_t* nodes,
+            size_t stride) {
+    Vec3<T> p[8];
+    const size_t count = static_cast<size_t>(Element::GetNodeCount(type));
+    for (size_t k = 0; k < count && k < 8; ++k) {
+        p[k] = Vec3<T>::Gather(x, y, z, nodes, stride, k);
+    }
+    
+    switch (type) {
+        case ElementType::SHELL3:
+            // Height over the longest side
+            return Lanes::Length(Cross(p[1] - p[0], p[2] - p[0])) / Lanes::Sqrt(MaxSquaredSide(p, 3));
+        case ElementType::SHELL4:
+            return 0.5f * QuadArea2(p[0], p[1], p[2], p[3]) / Lanes::Sqrt(MaxSquaredSide(p, 4));
+        case ElementType::TETRA4: {
+            // Three volumes over the largest face, as six volumes over its
+            // doubled area
+            const Vec3<T> e1 = p[1] - p[0];
+            const Vec3<T> e2 = p[2] - p[0];
+            const Vec3<T> e3 = p[3] - p[0];
+            T face = Lanes::Length(Cross(e1, e2));
+            face = Lanes::Max(face, Lanes::Length(Cross(e2, e3)));
+            face = Lanes::Max(face, Lanes::Length(Cross(e3, e1)));
+            face = Lanes::Max(face, Lanes::Length(Cross(p[2] - p[1], p[3] - p[1])));
+            return Lanes::Abs(Dot(e1, Cross(e2, e3))) / face;
+        }
+        case ElementType::HEXA8: {
+            // Volume from the Jacobian at the centre, over the largest face
+            const Vec3<T> g1 = ((p[1] - p[0]) + (p[2] - p[3]) + (p[5] - p[4]) + (p[6] - p[7])) * 0.25f;
+            const Vec3<T> g2 = ((p[3] - p[0]) + (p[2] - p[1]) + (p[7] - p[4]) + (p[6] - p[5])) * 0.25f;
+            const Vec3<T> g3 = ((p[4] - p[0]) + (p[5] - p[1]) + (p[6] - p[2]) + (p[7] - p[3])) * 0.25f;
+            T face = QuadArea2(p[0], p[1], p[2], p[3]);
+            face = Lanes::Max(face, QuadArea2(p[4], p[5], p[6], p[7]));
+            face = Lanes::Max(face, QuadArea2(p[0], p[1], p[5], p[4]));
+            face = Lanes::Max(face, QuadArea2(p[1], p[2], p[6], p[5]));
+            face = Lanes::Max(face, QuadArea2(p[2], p[3], p[7], p[6]));
+            face = Lanes::Max(face, QuadArea2(p[3], p[0], p[4], p[7]));
+            return Lanes::Abs(Dot(g1, Cross(g2, g3))) / (0.5f * face);
+        }
+        case ElementType::BEAM2:
+            return Lanes::Length(p[1] - p[0]);
+        default:
+            return Lanes::Traits<T>::Splat(0.0f);
+    }
+}
+
+bool HasMissingNode(const uint32_t* nodes, size_t count) {
+    return std::find(nodes, nodes + count, ElementArrays::kMissingNode) != nodes + count;
+}
+
+} // namespace
+
+double TimeStepReport::GetCycleCount(double endTime) const {
+    return minimum > 0.0 ? endTime / (kScaleFactor * minimum) : 0.0;
+}
+
+TimeStepReport TimeStepEstimator::Estimate(const Model& model) {
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool& pool = ThreadPool::GetGlobal();
+    TimeStepReport report;
+    const ElementArrays& arrays = model.GetElementArrays();
+    const size_t count = arrays.Size();
+    report.timeSteps.assign(count, kInfinity);
+    if (count == 0) {
+        return report;
+    }
+    
+    // Coordinate columns, so each lane's corner is one load
+    const ChunkedColumn<glm::vec3>& positions = model.GetNodePositions();
+    std::vector<float> x(positions.size()), y(positions.size()), z(positions.size());
+    pool.ParallelFor(positions.size(), kParallelGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            x[i] = positions[i].x;
+            y[i] = positions[i].y;
+            z[i] = positions[i].z;
+        }
+    });
+    
+    // Unresolved references are looked up once, up front
+    std::vector<uint32_t> resolved;
+    const uint32_t* nodeIndices = arrays.nodeIndices.data();
+    if (!arrays.HasNodeIndices()) {
+        resolved.resize(arrays.nodeIds.size());
+        pool.ParallelFor(resolved.size(), kParallelGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                size_t index = model.FindNodeIndex(arrays.nodeIds[i]);
+                resolved[i] = index != Model::kInvalidIndex ? static_cast<uint32_t>(index)
+                                                            : ElementArrays::kMissingNode;
+            }
+        });
+        nodeIndices = resolved.data();
+    }
+    
+    std::unordered_map<int, Slowness> materials;
+    for (const Material& material : model.GetMaterials()) {
+        materials[material.id] = GetSlowness(material);
+    }
+    
+    std::vector<float> slowness(count, 0.0f);
+    float* steps = report.timeSteps.data();
+    std::atomic<size_t> unresolved{0};
+    for (const ElementBlock& block : arrays.blocks) {
+        const size_t stride = static_cast<size_t>(block.nodesPerElement);
+        if (block.type == ElementType::SPRING1 || block.type == ElementType::UNKNOWN) {
+            continue;   // No wave speed
+        }
+        if (stride < static_cast<size_t>(Element::GetNodeCount(block.type))) {
+            unresolved += block.elementCount;
+            continue;
+        }
+        
+        pool.ParallelFor(block.elementCount, kParallelGrain, [&](size_t begin, size_t end) {
+            const size_t first = block.firstElement;
+            const uint32_t* nodes = nodeIndices + block.firstNodeId;
+            for (size_t i = begin; i < end; ++i) {
+                auto it = materials.find(arrays.materialIds[first + i]);
+                slowness[first + i] = it != materials.end() ? GetSlowness(it->second, block.type) : 0.0f;
+            }
+            
+            size_t skipped = 0;
+            auto estimateOne = [&](size_t i) {
+                const uint32_t* element = nodes + i * stride;
+                if (HasMissingNode(element, stride)) {
+                    skipped += slowness[first + i] > 0.0f ? 1 : 0;
+                    slowness[first + i] = 0.0f;
+                    return;
+                }
+                steps[first + i] = GetLength<float>(block.type, x.data(), y.data(), z.data(), element, stride) *
+                                   slowness[first + i];
+            };
+            
+            size_t i = begin;
+#ifdef LANES_HAS_SSE2
+            using Traits = Lanes::Traits<Lanes::Float4>;
+            for (; i + Traits::kWidth <= end; i += Traits::kWidth) {
+                const uint32_t* batch = nodes + i * stride;
+                if (HasMissingNode(batch, Traits::kWidth * stride)) {
+                    for (size_t k = i; k < i + Traits::kWidth; ++k) {
+                        estimateOne(k);
+                    }
+                    continue;
+                }
+                Lanes::Float4 length = GetLength<Lanes::Float4>(block.type, x.data(), y.data(), z.data(), batch,
+                                                                stride);
+                Traits::Store(steps + first + i, length * Traits::Load(slowness.data() + first + i));
+            }
+#endif
+            for (; i < end; ++i) {
+                estimateOne(i);
+            }
+            
+            // No wave speed, no step; a collapsed element is a zero one
+            for (size_t k = begin; k < end; ++k) {
+                float& step = steps[first + k];
+                if (slowness[first + k] <= 0.0f) {
+                    step = kInfinity;
+                } else if (std::isnan(step)) {
+                    step = 0.0f;
+                }
+            }
+            unresolved += skipped;
+        });
+    }
+    report.unresolved = unresolved;
+    
+    // Range of the finite steps, the smallest nonzero one bounding the
+    // histogram from below
+    std::mutex mutex;
+    size_t minIndex = count;
+    float maxStep = 0.0f;
+    float minPositive = kInfinity;
+    pool.ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+        size_t localMin = count;
+        size_t localEstimated = 0;
+        float localMax = 0.0f;
+        float localPositive = kInfinity;
+        for (size_t i = begin; i < end; ++i) {
+            const float step = steps[i];
+            if (step == kInfinity) {
+                continue;
+            }
+            ++localEstimated;
+            if (localMin == count || step < steps[localMin]) {
+                localMin = i;
+            }
+            localMax = std::max(localMax, step);
+            if (step > 0.0f) {
+                localPositive = std::min(localPositive, step);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        report.estimated += localEstimated;
+        if (localMin != count && (minIndex == count || steps[localMin] < steps[minIndex] ||
+                                  (steps[localMin] == steps[minIndex] && localMin < minIndex))) {
+            minIndex = localMin;
+        }
+        maxStep = std::max(maxStep, localMax);
+        minPositive = std::min(minPositive, localPositive);
+    });
+    
+    if (minIndex != count) {
+        report.minimum = steps[minIndex];
+        report.minimumElementId = arrays.ids[minIndex];
+    }
+    
+    report.histogram.assign(TimeStepReport::kHistogramBins, 0.0f);
+    if (minPositive != kInfinity) {
+        report.histogramLow = std::floor(std::log10(static_cast<double>(minPositive)));
+        report.histogramHigh = std::max(std::ceil(std::log10(static_cast<double>(maxStep))),
+                                        report.histogramLow + 1.0);
+        const double scale = TimeStepReport::kHistogramBins / (report.histogramHigh - report.histogramLow);
+        pool.ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+            std::vector<float> bins(TimeStepReport::kHistogramBins, 0.0f);
+            for (size_t i = begin; i < end; ++i) {
+                const float step = steps[i];
+                if (step == kInfinity) {
+                    continue;
+                }
+                // Zero steps go in the first bin
+                double bin = step > 0.0f ? (std::log10(static_cast<double>(step)) - report.histogramLow) * scale : 0.0;
+                bins[std::clamp(static_cast<size_t>(std::max(bin, 0.0)), size_t(0),
+                                TimeStepReport::kHistogramBins - 1)] += 1.0f;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t b = 0; b < bins.size(); ++b) {
+                report.histogram[b] += bins[b];
+            }
+        });
+    }
+    
+    // Smallest steps, ties by element order
+    const size_t worst = std::min(TimeStepReport::kWorstCount, report.estimated);
+    if (worst > 0) {
+        std::vector<uint32_t> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        auto smaller = [steps](uint32_t a, uint32_t b) {
+            return steps[a] < steps[b] || (steps[a] == steps[b] && a < b);
+        };
+        std::nth_element(order.begin(), order.begin() + (worst - 1), order.end(), smaller);
+        std::sort(order.begin(), order.begin() + worst, smaller);
+        for (size_t i = 0; i < worst; ++i) {
+            report.worstIds.push_back(arrays.ids[order[i]]);
+            report.worstSteps.push_back(steps[order[i]]);
+        }
+    }
+    
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Time step estimate: {} at element {}, {} of {} elements in {:.3f} s", report.minimum,
+             report.minimumElementId, report.estimated, count, report.seconds);
+    if (report.unresolved > 0) {
+        LOG_WARN("Time step estimate skipped {} elements with undefined nodes", report.unresolved);
+    }
+    return report;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class Model;
+
+// Stable explicit time step of each element, the characteristic length
+// over the material's wave speed, as the engine will find it at cycle 0
+struct TimeStepReport {
+    static constexpr size_t kHistogramBins = 64;
+    static constexpr size_t kWorstCount = 100;
+    static constexpr double kScaleFactor = 0.9;   // The engine's default on the smallest step
+    
+    std::vector<float> timeSteps;   // Per element index; infinite where there is none
+    double minimum = 0.0;           // Zero with no element estimated
+    int minimumElementId = 0;
+    size_t estimated = 0;           // Elements with a finite step
+    size_t unresolved = 0;          // Skipped for undefined nodes
+    
+    // Element counts over log10 of the step, from histogramLow to
+    // histogramHigh in even bins
+    std::vector<float> histogram;
+    double histogramLow = 0.0;
+    double histogramHigh = 0.0;
+    
+    // Smallest steps first
+    std::vector<int> worstIds;
+    std::vector<float> worstSteps;
+    
+    double seconds = 0.0;
+    
+    // Cycles to reach endTime at the scaled smallest step
+    double GetCycleCount(double endTime) const;
+};
+
+// Lengths are worked out four elements at a time where SSE2 is there, one
+// block of the model's element arrays after another on the global pool:
+// shells take area over the longest side, tetrahedra and hexahedra volume
+// over the largest face, beams their length. Wave speeds come from each
+// material's RHO, E and NU; springs have none.
+class TimeStepEstimator {
+public:
+    static TimeStepReport Estimate(const Model& model);
+};
@@ -0,0 +1,185 @@
+#include "utils/Config.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// Recursive descent over the JSON grammar, flattening leaves into dotted
+// paths. Nulls are skipped; strings keep only the basic escapes.
+struct Config::Parser {
+    const std::string& text;
+    size_t pos = 0;
+    std::unordered_map<std::string, Value>& values;
+    std::string error;
+    
+    bool Fail(const std::string& message) {
+        if (error.empty()) {
+            size_t line = 1;
+            for (size_t i = 0; i < pos && i < text.size(); ++i) {
+                line += text[i] == '\n';
+            }
+            error = message + " at line " + std::to_string(line);
+        }
+        return false;
+    }
+    
+    void SkipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+                                     text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+    
+    bool Consume(char c) {
+        SkipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    
+    bool ParseString(std::string& out) {
+        if (!Consume('"')) return Fail("Expected string");
+        out.clear();
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c == '\\' && pos < text.size()) {
+                char escaped = text[pos++];
+                switch (escaped) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'u': pos += 4; c = '?'; break;   // Not needed by any setting
+                    default:  c = escaped; break;
+                }
+            }
+            out += c;
+        }
+        if (pos >= text.size()) return Fail("Unterminated string");
+        ++pos;
+        return true;
+    }
+    
+    bool ParseValue(const std::string& key) {
+        SkipSpace();
+        if (pos >= text.size()) return Fail("Unexpected end");
+        const char c = text[pos];
+        if (c == '{') {
+            ++pos;
+            if (Consume('}')) return true;
+            do {
+                std::string name;
+                if (!ParseString(name)) return false;
+                if (!Consume(':')) return Fail("Expected ':'");
+                if (!ParseValue(key.empty() ? name : key + "." + name)) return false;
+            } while (Consume(','));
+            return Consume('}') || Fail("Expected '}'");
+        }
+        if (c == '[') {
+            ++pos;
+            size_t index = 0;
+            if (!Consume(']')) {
+                do {
+                    if (!ParseValue(key + "." + std::to_string(index++))) return false;
+                } while (Consume(','));
+                if (!Consume(']')) return Fail("Expected ']'");
+            }
+            values[key] = Value{Type::ARRAY, static_cast<double>(index), std::string()};
+            return true;
+        }
+        if (c == '"') {
+            Value value{Type::STRING, 0.0, std::string()};
+            if (!ParseString(value.text)) return false;
+            values[key] = std::move(value);
+            return true;
+        }
+        for (const char* word : {"true", "false", "null"}) {
+            if (text.compare(pos, std::char_traits<char>::length(word), word) == 0) {
+                pos += std::char_traits<char>::length(word);
+                if (word[0] != 'n') {
+                    values[key] = Value{Type::BOOL, word[0] == 't' ? 1.0 : 0.0, std::string()};
+                }
+                return true;
+            }
+        }
+        
+        const char* begin = text.c_str() + pos;
+        char* end = nullptr;
+        double number = std::strtod(begin, &end);
+        if (end == begin) return Fail("Unexpected character");
+        pos += static_cast<size_t>(end - begin);
+        values[key] = Value{Type::NUMBER, number, std::string()};
+        return true;
+    }
+};
+
+bool Config::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        m_Values.clear();
+        m_Error = "Cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return Parse(buffer.str());
+}
+
+bool Config::Parse(const std::string& text) {
+    m_Values.clear();
+    m_Error.clear();
+    Parser parser{text, 0, m_Values, std::string()};
+    if (!parser.ParseValue(std::string())) {
+        m_Values.clear();
+        m_Error = parser.error;
+        return false;
+    }
+    parser.SkipSpace();
+    if (parser.pos != text.size()) {
+        parser.Fail("Trailing characters");
+        m_Values.clear();
+        m_Error = parser.error;
+        return false;
+    }
+    return true;
+}
+
+const Config::Value* Config::Find(const std::string& key, Type type) const {
+    auto it = m_Values.find(key);
+    return it != m_Values.end() && it->second.type == type ? &it->second : nullptr;
+}
+
+bool Config::GetBool(const std::string& key, bool fallback) const {
+    const Value* value = Find(key, Type::BOOL);
+    return value ? value->number != 0.0 : fallback;
+}
+
+double Config::GetNumber(const std::string& key, double fallback) const {
+    const Value* value = Find(key, Type::NUMBER);
+    return value ? value->number : fallback;
+}
+
+int Config::GetInt(const std::string& key, int fallback) const {
+    const Value* value = Find(key, Type::NUMBER);
+    return value ? static_cast<int>(value->number) : fallback;
+}
+
+std::string Config::GetString(const std::string& key, const std::string& fallback) const {
+    const Value* value = Find(key, Type::STRING);
+    return value ? value->text : fallback;
+}
+
+size_t Config::GetArraySize(const std::string& key) const {
+    const Value* value = Find(key, Type::ARRAY);
+    return value ? static_cast<size_t>(value->number) : 0;
+}
+
+glm::vec3 Config::GetVec3(const std::string& key, const glm::vec3& fallback) const {
+    glm::vec3 result;
+    for (int i = 0; i < 3; ++i) {
+        const Value* value = Find(key + "." + std::to_string(i), Type::NUMBER);
+        if (!value) return fallback;
+        result[i] = static_cast<float>(value->number);
+    }
+    return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+// Settings read from a JSON file such as resources/config/default_settings.json.
+// Values are looked up by dotted path ("application.window.vsync"), array
+// entries by index ("renderer.backgroundColor.0"); anything missing or of
+// another type gives the fallback, so a partial file is fine.
+class Config {
+public:
+    // Replaces what was loaded; on failure nothing is kept and GetError says why
+    bool Load(const std::string& path);
+    bool Parse(const std::string& text);
+    const std::string& GetError() const { return m_Error; }
+    
+    bool Has(const std::string& key) const { return m_Values.count(key) != 0; }
+    bool GetBool(const std::string& key, bool fallback) const;
+    double GetNumber(const std::string& key, double fallback) const;
+    int GetInt(const std::string& key, int fallback) const;
+    std::string GetString(const std::string& key, const std::string& fallback) const;
+    glm::vec3 GetVec3(const std::string& key, const glm::vec3& fallback) const;   // Array of 3
+    size_t GetArraySize(const std::string& key) const;   // 0 when not an array
+
+private:
+    enum class Type { BOOL, NUMBER, STRING, ARRAY };
+    struct Value {
+        Type type;
+        double number;   // Booleans as 0 or 1, arrays their size
+        std::string text;
+    };
+    
+    struct Parser;
+    
+    const Value* Find(const std::string& key, Type type) const;
+
+private:
+    std::unordered_map<std::string, Value> m_Values;   // Leaves and arrays, by path
+    std::string m_Error;
+};
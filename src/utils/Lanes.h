@@ -0,0 +1,109 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define LANES_HAS_SSE2 1
+#endif
+
+// Element kernels written once over a lane type: float for one element at
+// a time, Float4 for four side by side where SSE2 is there. Traits<T>
+// loads, stores and gathers; the math below is overloaded for both.
+namespace Lanes {
+
+template<typename T>
+struct Traits;
+
+inline float Sqrt(float v) { return std::sqrt(v); }
+inline float Min(float a, float b) { return a < b ? a : b; }
+inline float Max(float a, float b) { return a > b ? a : b; }
+inline float Abs(float v) { return std::fabs(v); }
+
+template<>
+struct Traits<float> {
+    static constexpr size_t kWidth = 1;
+    
+    static float Splat(float v) { return v; }
+    static float Load(const float* p) { return *p; }
+    static void Store(float* p, float v) { *p = v; }
+    
+    // values[indices[k * stride]] for each lane k
+    static float Gather(const float* values, const uint32_t* indices, size_t) { return values[indices[0]]; }
+};
+
+#ifdef LANES_HAS_SSE2
+struct Float4 {
+    __m128 v;
+    
+    Float4() = default;
+    Float4(__m128 value) : v(value) {}
+    explicit Float4(float value) : v(_mm_set1_ps(value)) {}
+    
+    Float4& operator+=(Float4 o) { v = _mm_add_ps(v, o.v); return *this; }
+    Float4& operator-=(Float4 o) { v = _mm_sub_ps(v, o.v); return *this; }
+    Float4& operator*=(Float4 o) { v = _mm_mul_ps(v, o.v); return *this; }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+inline Float4 operator*(Float4 a, float b) { return _mm_mul_ps(a.v, _mm_set1_ps(b)); }
+inline Float4 operator*(float a, Float4 b) { return _mm_mul_ps(_mm_set1_ps(a), b.v); }
+
+inline Float4 Sqrt(Float4 v) { return _mm_sqrt_ps(v.v); }
+inline Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+inline Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+inline Float4 Abs(Float4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v.v); }
+
+template<>
+struct Traits<Float4> {
+    static constexpr size_t kWidth = 4;
+    
+    static Float4 Splat(float v) { return Float4(v); }
+    static Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+    static void Store(float* p, Float4 v) { _mm_storeu_ps(p, v.v); }
+    static Float4 Gather(const float* values, const uint32_t* indices, size_t stride) {
+        return _mm_setr_ps(values[indices[0]], values[indices[stride]],
+                           values[indices[2 * stride]], values[indices[3 * stride]]);
+    }
+};
+
+using Wide = Float4;
+#else
+using Wide = float;
+#endif
+
+template<typename T>
+struct Vec3 {
+    T x, y, z;
+    
+    // Node k of each lane's element, out of coordinate columns
+    static Vec3 Gather(const float* xs, const float* ys, const float* zs, const uint32_t* nodes,
+                       size_t stride, size_t k) {
+        return {Traits<T>::Gather(xs, nodes + k, stride), Traits<T>::Gather(ys, nodes + k, stride),
+                Traits<T>::Gather(zs, nodes + k, stride)};
+    }
+};
+
+template<typename T>
+inline Vec3<T> operator+(const Vec3<T>& a, const Vec3<T>& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+template<typename T>
+inline Vec3<T> operator-(const Vec3<T>& a, const Vec3<T>& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+template<typename T>
+inline Vec3<T> operator*(const Vec3<T>& a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+
+template<typename T>
+inline T Dot(const Vec3<T>& a, const Vec3<T>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+template<typename T>
+inline Vec3<T> Cross(const Vec3<T>& a, const Vec3<T>& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+template<typename T>
+inline T Length(const Vec3<T>& a) { return Sqrt(Dot(a, a)); }
+
+} // namespace Lanes
@@ -1,61 +1,571 @@
 #include "utils/Logger.h"
-#include <iostream>
-#include <chrono>
-#include <iomanip>
+#include "utils/SpscRing.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kThreadBufferRecords = 512;
+constexpr size_t kRingEntries = 1000;
+constexpr auto kDrainInterval = std::chrono::milliseconds(20);
+
+std::mutex s_InitMutex;
+std::atomic<uint64_t> s_Generations{0};
+
+const char* const kLevelNames[] = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "CRITICAL"
+};
+
+// Color codes for terminal
+const char* const kColorCodes[] = {
+    "\033[37m",  // White for TRACE
+    "\033[36m",  // Cyan for DEBUG
+    "\033[32m",  // Green for INFO
+    "\033[33m",  // Yellow for WARN
+    "\033[31m",  // Red for ERROR
+    "\033[35m"   // Magenta for CRITICAL
+};
+
+// An argument as Unpack read it back
+struct Arg {
+    LogDetail::ArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        float f;
+        double d;
+        char c;
+    };
+    std::string_view text;
+};
+
+class Reader {
+public:
+    Reader(const char* data, size_t size) : m_Data(data), m_Size(size) {}
+    
+    bool AtEnd() const { return m_Offset >= m_Size; }
+    
+    template<typename T>
+    T Get() {
+        T value{};
+        if (m_Offset + sizeof(T) <= m_Size) {
+            std::memcpy(&value, m_Data + m_Offset, sizeof(T));
+        }
+        m_Offset += sizeof(T);
+        return value;
+    }
+    
+    std::string_view GetText() {
+        const uint32_t length = Get<uint32_t>();
+        const size_t available = m_Offset < m_Size ? m_Size - m_Offset : 0;
+        std::string_view text(m_Data + std::min(m_Offset, m_Size), std::min<size_t>(length, available));
+        m_Offset += length;
+        return text;
+    }
+
+private:
+    const char* m_Data;
+    size_t m_Size;
+    size_t m_Offset = 0;
+};
+
+void Unpack(Reader& reader, std::vector<Arg>& args) {
+    using LogDetail::ArgType;
+    while (!reader.AtEnd()) {
+        Arg arg;
+        arg.type = reader.Get<ArgType>();
+        arg.u = 0;
+        switch (arg.type) {
+        case ArgType::INT:     arg.i = reader.Get<int64_t>(); break;
+        case ArgType::UINT:    arg.u = reader.Get<uint64_t>(); break;
+        case ArgType::FLOAT:   arg.f = reader.Get<float>(); break;
+        case ArgType::DOUBLE:  arg.d = reader.Get<double>(); break;
+        case ArgType::BOOL:    arg.u = reader.Get<uint8_t>(); break;
+        case ArgType::CHAR:    arg.c = reader.Get<char>(); break;
+        case ArgType::STRING:  arg.text = reader.GetText(); break;
+        case ArgType::POINTER: arg.u = reader.Get<uint64_t>(); break;
+        default: return;
+        }
+        args.push_back(arg);
+    }
+}
+
+// [[fill]align][width][.precision][type]
+struct Spec {
+    char fill = ' ';
+    char align = 0;       // '<', '>', '^', or 0 for the type's own
+    size_t width = 0;
+    int precision = -1;
+    char type = 0;
+};
+
+Spec ParseSpec(std::string_view text) {
+    Spec spec;
+    size_t i = 0;
+    auto isAlign = [](char c) { return c == '<' || c == '>' || c == '^'; };
+    if (text.size() >= 2 && isAlign(text[1])) {
+        spec.fill = text[0];
+        spec.align = text[1];
+        i = 2;
+    } else if (!text.empty() && isAlign(text[0])) {
+        spec.align = text[0];
+        i = 1;
+    }
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+        spec.width = spec.width * 10 + static_cast<size_t>(text[i++] - '0');
+    }
+    if (i < text.size() && text[i] == '.') {
+        spec.precision = 0;
+        while (++i < text.size() && text[i] >= '0' && text[i] <= '9') {
+            spec.precision = spec.precision * 10 + (text[i] - '0');
+        }
+    }
+    if (i < text.size()) {
+        spec.type = text[i];
+    }
+    return spec;
+}
+
+// Shortest text that reads back as the same value, as std::format gives
+template<typename T>
+void AppendShortest(std::string& out, T value) {
+    char text[64];
+    const int start = std::is_same_v<T, float> ? 6 : 15;
+    const int limit = std::is_same_v<T, float> ? 9 : 17;
+    for (int digits = start; digits <= limit; ++digits) {
+        std::snprintf(text, sizeof(text), "%.*g", digits, static_cast<double>(value));
+        if (!std::isfinite(value) || static_cast<T>(std::strtod(text, nullptr)) == value) break;
+    }
+    out += text;
+}
+
+void AppendFloating(std::string& out, double value, bool isFloat, const Spec& spec) {
+    if (spec.precision < 0 && (spec.type == 0 || spec.type == 'g')) {
+        if (isFloat) {
+            AppendShortest(out, static_cast<float>(value));
+        } else {
+            AppendShortest(out, value);
+        }
+        return;
+    }
+    char conversion = 'g';
+    if (spec.type == 'f' || spec.type == 'F' || spec.type == 'e' || spec.type == 'E' ||
+        spec.type == 'G') {
+        conversion = spec.type;
+    }
+    const char format[] = {'%', '.', '*', conversion, '\0'};
+    char text[512];
+    std::snprintf(text, sizeof(text), format, spec.precision < 0 ? 6 : spec.precision, value);
+    out += text;
+}
+
+void AppendArg(std::string& out, const Arg& arg, const Spec& spec) {
+    using LogDetail::ArgType;
+    const size_t start = out.size();
+    char text[32];
+    const bool hex = spec.type == 'x' || spec.type == 'X';
+    bool numeric = true;
+    switch (arg.type) {
+    case ArgType::INT:
+        if (hex) {
+            std::snprintf(text, sizeof(text), spec.type == 'x' ? "%llx" : "%llX",
+                          static_cast<unsigned long long>(arg.i));
+        } else {
+            std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(arg.i));
+        }
+        out += text;
+        break;
+    case ArgType::UINT:
+        std::snprintf(text, sizeof(text), hex ? (spec.type == 'x' ? "%llx" : "%llX") : "%llu",
+                      static_cast<unsigned long long>(arg.u));
+        out += text;
+        break;
+    case ArgType::FLOAT:
+        AppendFloating(out, arg.f, true, spec);
+        break;
+    case ArgType::DOUBLE:
+        AppendFloating(out, arg.d, false, spec);
+        break;
+    case ArgType::BOOL:
+        out += arg.u ? "true" : "false";
+        numeric = false;
+        break;
+    case ArgType::CHAR:
+        out += arg.c;
+        numeric = false;
+        break;
+    case ArgType::STRING:
+        if (spec.precision >= 0) {
+            out.append(arg.text.substr(0, static_cast<size_t>(spec.precision)));
+        } else {
+            out.append(arg.text);
+        }
+        numeric = false;
+        break;
+    case ArgType::POINTER:
+        std::snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(arg.u));
+        out += text;
+        break;
+    }
+    
+    const size_t length = out.size() - start;
+    if (length >= spec.width) return;
+    const size_t pad = spec.width - length;
+    const char align = spec.align ? spec.align : (numeric ? '>' : '<');
+    const size_t before = align == '>' ? pad : (align == '^' ? pad / 2 : 0);
+    out.insert(start, before, spec.fill);
+    out.append(pad - before, spec.fill);
+}
+
+// Local time of day, without localtime's shared buffer. Kept per thread
+// for the last second seen, as batches mostly share it.
+std::string FormatTime(std::chrono::system_clock::time_point time) {
+    thread_local std::time_t lastSeconds = -1;
+    thread_local char text[16];
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    if (seconds != lastSeconds) {
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        std::strftime(text, sizeof(text), "%H:%M:%S", &local);
+        lastSeconds = seconds;
+    }
+    return text;
+}
+
+} // namespace
+
+namespace LogDetail {
+
+struct ThreadBuffer {
+    SpscRing<Record> ring{kThreadBufferRecords};
+    std::atomic<bool> retired{false};   // Its thread has exited
+};
+
+std::string Format(const char* data, size_t size) {
+    Reader reader(data, size);
+    const std::string_view format = reader.GetText();
+    std::vector<Arg> args;
+    Unpack(reader, args);
+    
+    std::string out;
+    out.reserve(format.size() + 16 * args.size());
+    size_t next = 0;
+    for (size_t i = 0; i < format.size(); ++i) {
+        const char c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+            out += c;
+            ++i;
+            continue;
+        }
+        const size_t close = c == '{' ? format.find('}', i) : std::string_view::npos;
+        if (close == std::string_view::npos) {
+            out += c;
+            continue;
+        }
+        
+        // Placeholders past the last argument are left as they are
+        const std::string_view field = format.substr(i + 1, close - i - 1);
+        if (next < args.size() && (field.empty() || field[0] == ':')) {
+            AppendArg(out, args[next++], ParseSpec(field.empty() ? field : field.substr(1)));
+        } else {
+            out.append(format.substr(i, close - i + 1));
+        }
+        i = close;
+    }
+    return out;
+}
+
+} // namespace LogDetail
+
+// Sinks
+
+const char* LogSink::GetLevelName(LogLevel level) {
+    return kLevelNames[static_cast<int>(level)];
+}
+
+std::string LogSink::FormatLine(const LogEntry& entry) {
+    std::string line;
+    line.reserve(entry.message.size() + 24);
+    line += '[';
+    line += FormatTime(entry.time);
+    line += "] [";
+    line += GetLevelName(entry.level);
+    line += "] ";
+    line += entry.message;
+    return line;
+}
+
+void ConsoleLogSink::Write(const LogEntry& entry) {
+    std::cout << kColorCodes[static_cast<int>(entry.level)]
+              << FormatLine(entry)
+              << "\033[0m"  // Reset color
+              << '\n';
+}
+
+void ConsoleLogSink::Flush() {
+    std::cout.flush();
+}
+
+FileLogSink::FileLogSink(const std::string& path)
+    : m_File(path, std::ios::app) {
+}
+
+void FileLogSink::Write(const LogEntry& entry) {
+    m_File << FormatLine(entry) << '\n';
+}
+
+void FileLogSink::Flush() {
+    m_File.flush();
+}
+
+RingLogSink::RingLogSink(size_t capacity)
+    : m_Capacity(std::max<size_t>(capacity, 1)) {
+    m_Entries.reserve(m_Capacity);
+}
+
+void RingLogSink::Write(const LogEntry& entry) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Entries.size() < m_Capacity) {
+        m_Entries.push_back(entry);
+    } else {
+        m_Entries[m_Next] = entry;
+        m_Next = (m_Next + 1) % m_Capacity;
+    }
+    m_Written.fetch_add(1, std::memory_order_release);
+}
+
+std::vector<LogEntry> RingLogSink::GetEntries() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<LogEntry> entries;
+    entries.reserve(m_Entries.size());
+    entries.insert(entries.end(), m_Entries.begin() + static_cast<std::ptrdiff_t>(m_Next), m_Entries.end());
+    entries.insert(entries.end(), m_Entries.begin(), m_Entries.begin() + static_cast<std::ptrdiff_t>(m_Next));
+    return entries;
+}
+
+void RingLogSink::Clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.clear();
+    m_Next = 0;
+}
+
+// Logger
 
 std::unique_ptr<Logger> Logger::s_Instance = nullptr;
+std::atomic<Logger*> Logger::s_Active{nullptr};
+std::atomic<int> Logger::s_Level{static_cast<int>(LogLevel::INFO)};
 
 void Logger::Init() {
+    std::lock_guard<std::mutex> lock(s_InitMutex);
     if (!s_Instance) {
         s_Instance = std::unique_ptr<Logger>(new Logger());
+        s_Active.store(s_Instance.get(), std::memory_order_release);
     }
 }
 
 void Logger::Shutdown() {
+    std::lock_guard<std::mutex> lock(s_InitMutex);
+    s_Active.store(nullptr, std::memory_order_release);
     s_Instance.reset();
 }
 
+LogLevel Logger::ParseLevel(std::string_view name, LogLevel fallback) {
+    for (int level = 0; level <= static_cast<int>(LogLevel::CRITICAL); ++level) {
+        const std::string_view candidate = kLevelNames[level];
+        if (candidate.size() == name.size() &&
+            std::equal(name.begin(), name.end(), candidate.begin(),
+                       [](char a, char b) { return std::toupper(static_cast<unsigned char>(a)) == b; })) {
+            return static_cast<LogLevel>(level);
+        }
+    }
+    return fallback;
+}
+
 Logger* Logger::GetInstance() {
-    if (!s_Instance) {
+    Logger* logger = s_Active.load(std::memory_order_acquire);
+    if (!logger) {
         Init();
+        logger = s_Active.load(std::memory_order_acquire);
     }
-    return s_Instance.get();
+    return logger;
 }
 
-Logger::Logger() : m_Level(LogLevel::INFO) {
+Logger::Logger()
+    : m_Generation(++s_Generations),
+      m_Ring(std::make_shared<RingLogSink>(kRingEntries)) {
+    const auto wall = std::chrono::system_clock::now().time_since_epoch();
+    const auto steady = std::chrono::steady_clock::now().time_since_epoch();
+    m_ClockOffset = wall - std::chrono::duration_cast<std::chrono::system_clock::duration>(steady);
+    m_Sinks.push_back(std::make_shared<ConsoleLogSink>());
+    m_Sinks.push_back(m_Ring);
+    m_Thread = std::thread([this]() { Run(); });
 }
 
 Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_Stop = true;
+    }
+    m_WakeCondition.notify_one();
+    m_Thread.join();
+}
+
+void Logger::AddSink(std::shared_ptr<LogSink> sink) {
+    Logger* logger = GetInstance();
+    std::lock_guard<std::mutex> lock(logger->m_SinksMutex);
+    logger->m_Sinks.push_back(std::move(sink));
+}
+
+bool Logger::AddFileSink(const std::string& path) {
+    auto sink = std::make_shared<FileLogSink>(path);
+    if (!sink->IsOpen()) return false;
+    AddSink(std::move(sink));
+    return true;
+}
+
+std::shared_ptr<RingLogSink> Logger::GetRingSink() {
+    return GetInstance()->m_Ring;
+}
+
+void Logger::Flush() {
+    GetInstance()->WaitDrained();
 }
 
-void Logger::LogMessage(LogLevel level, const std::string& message) {
-    if (level < m_Level) return;
+void Logger::Submit(LogDetail::Record&& record) {
+    Logger* logger = GetInstance();
+    LogDetail::ThreadBuffer& buffer = logger->GetThreadBuffer();
+    const LogLevel level = record.level;
     
-    // Get current time
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
+    // A full buffer waits for the logger rather than losing messages
+    while (!buffer.ring.TryPush(std::move(record))) {
+        logger->Wake();
+        std::this_thread::yield();
+    }
     
-    // Level strings
-    const char* levelStr[] = {
-        "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "CRITICAL"
-    };
+    if (level == LogLevel::CRITICAL) {
+        logger->WaitDrained();
+    } else if (level >= LogLevel::ERROR) {
+        logger->Wake();
+    }
+}
+
+namespace {
+
+// The calling thread's buffer, retired when the thread exits
+struct ThreadSlot {
+    std::shared_ptr<LogDetail::ThreadBuffer> buffer;
+    uint64_t generation = 0;
     
-    // Color codes for terminal
-    const char* colorCodes[] = {
-        "\033[37m",  // White for TRACE
-        "\033[36m",  // Cyan for DEBUG
-        "\033[32m",  // Green for INFO
-        "\033[33m",  // Yellow for WARN
-        "\033[31m",  // Red for ERROR
-        "\033[35m"   // Magenta for CRITICAL
-    };
+    ~ThreadSlot() {
+        if (buffer) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot t_Slot;
+
+} // namespace
+
+LogDetail::ThreadBuffer& Logger::GetThreadBuffer() {
+    if (t_Slot.generation != m_Generation) {
+        if (t_Slot.buffer) {
+            t_Slot.buffer->retired.store(true, std::memory_order_release);
+        }
+        t_Slot.buffer = std::make_shared<LogDetail::ThreadBuffer>();
+        t_Slot.generation = m_Generation;
+        std::lock_guard<std::mutex> lock(m_BuffersMutex);
+        m_Buffers.push_back(t_Slot.buffer);
+    }
+    return *t_Slot.buffer;
+}
+
+void Logger::Wake() {
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_Urgent = true;
+    }
+    m_WakeCondition.notify_one();
+}
+
+void Logger::WaitDrained() {
+    std::unique_lock<std::mutex> lock(m_WakeMutex);
+    const uint64_t ticket = ++m_FlushRequested;
+    m_WakeCondition.notify_one();
+    m_DrainedCondition.wait(lock, [&]() { return m_FlushDone >= ticket || m_Stop; });
+}
+
+void Logger::Run() {
+    std::vector<LogDetail::Record> batch;
+    std::unique_lock<std::mutex> lock(m_WakeMutex);
+    for (;;) {
+        m_WakeCondition.wait_for(lock, kDrainInterval, [&]() {
+            return m_Stop || m_Urgent || m_FlushDone != m_FlushRequested;
+        });
+        const bool stop = m_Stop;
+        const uint64_t requested = m_FlushRequested;
+        m_Urgent = false;
+        
+        lock.unlock();
+        Drain(batch);
+        lock.lock();
+        
+        m_FlushDone = requested;
+        m_DrainedCondition.notify_all();
+        if (stop) break;
+    }
+}
+
+void Logger::Drain(std::vector<LogDetail::Record>& batch) {
+    {
+        std::lock_guard<std::mutex> lock(m_BuffersMutex);
+        for (size_t i = 0; i < m_Buffers.size();) {
+            LogDetail::ThreadBuffer& buffer = *m_Buffers[i];
+            
+            // Read before popping, so nothing pushed before the thread
+            // exited is left behind
+            const bool retired = buffer.retired.load(std::memory_order_acquire);
+            LogDetail::Record record;
+            while (buffer.ring.TryPop(record)) {
+                batch.push_back(std::move(record));
+            }
+            if (retired) {
+                m_Buffers[i] = std::move(m_Buffers.back());
+                m_Buffers.pop_back();
+            } else {
+                ++i;
+            }
+        }
+    }
+    if (batch.empty()) return;
     
-    // Print log message
-    std::cout << colorCodes[static_cast<int>(level)]
-              << "[" << std::put_time(std::localtime(&time_t), "%H:%M:%S") << "] "
-              << "[" << levelStr[static_cast<int>(level)] << "] "
-              << message
-              << "\033[0m"  // Reset color
-              << std::endl;
-}
\ No newline at end of file
+    // Each buffer is in order already; this interleaves the threads
+    std::stable_sort(batch.begin(), batch.end(),
+        [](const LogDetail::Record& a, const LogDetail::Record& b) { return a.ticks < b.ticks; });
+    
+    std::lock_guard<std::mutex> lock(m_SinksMutex);
+    LogEntry entry;
+    for (const LogDetail::Record& record : batch) {
+        entry.level = record.level;
+        entry.time = std::chrono::system_clock::time_point(m_ClockOffset +
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::steady_clock::duration(record.ticks)));
+        entry.message = LogDetail::Format(record.GetData(), record.size);
+        for (const std::shared_ptr<LogSink>& sink : m_Sinks) {
+            sink->Write(entry);
+        }
+    }
+    for (const std::shared_ptr<LogSink>& sink : m_Sinks) {
+        sink->Flush();
+    }
+    batch.clear();
+}
@@ -1,7 +1,19 @@
 #pragma once
-#include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 enum class LogLevel {
     TRACE = 0,
@@ -12,40 +24,280 @@ enum class LogLevel {
     CRITICAL
 };
 
+// Levels below this are compiled out of the LOG_ macros: their arguments
+// are still checked but never evaluated
+#ifndef LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define LOG_ACTIVE_LEVEL 1   // DEBUG
+#else
+#define LOG_ACTIVE_LEVEL 0   // TRACE
+#endif
+#endif
+
+// A message as the sinks get it, formatted
+struct LogEntry {
+    LogLevel level = LogLevel::INFO;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+};
+
+// Where formatted messages go. Sinks are only called from the logger's
+// own thread, one batch of entries and then Flush at a time.
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void Write(const LogEntry& entry) = 0;
+    virtual void Flush() {}
+    
+    static const char* GetLevelName(LogLevel level);
+    
+    // "[HH:MM:SS] [LEVEL] message", local time
+    static std::string FormatLine(const LogEntry& entry);
+};
+
+// Coloured lines on standard output
+class ConsoleLogSink : public LogSink {
+public:
+    void Write(const LogEntry& entry) override;
+    void Flush() override;
+};
+
+// Lines appended to a file
+class FileLogSink : public LogSink {
+public:
+    explicit FileLogSink(const std::string& path);
+    bool IsOpen() const { return m_File.is_open(); }
+    
+    void Write(const LogEntry& entry) override;
+    void Flush() override;
+
+private:
+    std::ofstream m_File;
+};
+
+// The newest entries, for the GUI to show. Readers take copies from any
+// thread.
+class RingLogSink : public LogSink {
+public:
+    explicit RingLogSink(size_t capacity);
+    
+    void Write(const LogEntry& entry) override;
+    
+    // Oldest first
+    std::vector<LogEntry> GetEntries() const;
+    
+    // Entries ever written, so readers can tell when there are new ones
+    uint64_t GetWrittenCount() const { return m_Written.load(std::memory_order_acquire); }
+    void Clear();
+
+private:
+    mutable std::mutex m_Mutex;
+    std::vector<LogEntry> m_Entries;   // Circular once full
+    size_t m_Next = 0;
+    size_t m_Capacity;
+    std::atomic<uint64_t> m_Written{0};
+};
+
+namespace LogDetail {
+
+enum class ArgType : uint8_t { INT, UINT, FLOAT, DOUBLE, BOOL, CHAR, STRING, POINTER };
+
+// A message as its caller left it: the format and arguments packed into
+// payload, or into overflow when they did not fit
+struct Record {
+    static constexpr size_t kPayloadBytes = 224;
+    
+    int64_t ticks = 0;          // steady_clock
+    LogLevel level = LogLevel::INFO;
+    uint32_t size = 0;
+    std::unique_ptr<std::string> overflow;
+    char payload[kPayloadBytes];
+    
+    const char* GetData() const { return overflow ? overflow->data() : payload; }
+};
+
+// Appends to a fixed buffer, counting on past its end so a second pass
+// can be given exactly the room it needs
+class Packer {
+public:
+    Packer(char* data, size_t capacity) : m_Data(data), m_Capacity(capacity) {}
+    
+    bool Fits() const { return m_Size <= m_Capacity; }
+    size_t GetSize() const { return m_Size; }
+    
+    void PutBytes(const void* bytes, size_t count) {
+        if (m_Size <= m_Capacity && count <= m_Capacity - m_Size) {
+            std::memcpy(m_Data + m_Size, bytes, count);
+        }
+        m_Size += count;
+    }
+    
+    template<typename T>
+    void Put(ArgType type, T value) {
+        PutBytes(&type, sizeof(type));
+        PutBytes(&value, sizeof(value));
+    }
+    
+    void PutString(std::string_view text) {
+        const ArgType type = ArgType::STRING;
+        const uint32_t length = static_cast<uint32_t>(text.size());
+        PutBytes(&type, sizeof(type));
+        PutBytes(&length, sizeof(length));
+        PutBytes(text.data(), text.size());
+    }
+
+private:
+    char* m_Data;
+    size_t m_Capacity;
+    size_t m_Size = 0;
+};
+
+template<typename T>
+void PackArg(Packer& packer, const T& value) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) {
+        packer.Put(ArgType::BOOL, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_same_v<D, char>) {
+        packer.Put(ArgType::CHAR, value);
+    } else if constexpr (std::is_enum_v<D>) {
+        PackArg(packer, static_cast<std::underlying_type_t<D>>(value));
+    } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+        packer.Put(ArgType::INT, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<D>) {
+        packer.Put(ArgType::UINT, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_same_v<D, float>) {
+        packer.Put(ArgType::FLOAT, value);
+    } else if constexpr (std::is_floating_point_v<D>) {
+        packer.Put(ArgType::DOUBLE, static_cast<double>(value));
+    } else if constexpr (std::is_array_v<T>) {
+        packer.PutString(std::string_view(value));
+    } else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>) {
+        packer.PutString(value ? std::string_view(value) : std::string_view("(null)"));
+    } else if constexpr (std::is_convertible_v<const D&, std::string_view>) {
+        packer.PutString(std::string_view(value));
+    } else if constexpr (std::is_pointer_v<D>) {
+        packer.Put(ArgType::POINTER, reinterpret_cast<uint64_t>(value));
+    } else {
+        // Anything else streamable is turned to text by the caller
+        std::ostringstream stream;
+        stream << value;
+        packer.PutString(stream.str());
+    }
+}
+
+template<typename... Args>
+void Pack(Packer& packer, std::string_view format, const Args&... args) {
+    const uint32_t length = static_cast<uint32_t>(format.size());
+    packer.PutBytes(&length, sizeof(length));
+    packer.PutBytes(format.data(), format.size());
+    (PackArg(packer, args), ...);
+}
+
+// Formats what Pack left in data: {} takes the next argument, {:spec}
+// with a fill and alignment, width, precision and type (d x X f e g s)
+// as std::format has them; {{ and }} are braces
+std::string Format(const char* data, size_t size);
+
+struct ThreadBuffer;
+
+} // namespace LogDetail
+
+// Messages are packed, arguments in binary form, into a lock-free buffer
+// of the calling thread and formatted on the logger's own thread, which
+// drains every buffer into the sinks a batch at a time. Callers only wait
+// when their buffer is full; ERROR and CRITICAL wake the logger at once,
+// and CRITICAL waits until it is written. Console and ring sinks are
+// always there. Shutdown writes what is left; call it once other threads
+// have stopped logging.
 class Logger {
 public:
     static void Init();
     static void Shutdown();
     
-    template<typename... Args>
-    static void Log(LogLevel level, const std::string& format, Args... args) {
-        GetInstance()->LogMessage(level, FormatString(format, args...));
+    static void SetLevel(LogLevel level) { s_Level.store(static_cast<int>(level), std::memory_order_relaxed); }
+    static LogLevel GetLevel() { return static_cast<LogLevel>(s_Level.load(std::memory_order_relaxed)); }
+    static bool IsEnabled(LogLevel level) {
+        return static_cast<int>(level) >= s_Level.load(std::memory_order_relaxed);
     }
     
+    // "trace" to "critical", any case
+    static LogLevel ParseLevel(std::string_view name, LogLevel fallback);
+    
+    static void AddSink(std::shared_ptr<LogSink> sink);
+    static bool AddFileSink(const std::string& path);   // False when it cannot be opened
+    static std::shared_ptr<RingLogSink> GetRingSink();
+    
+    // Returns once everything logged before it has been written
+    static void Flush();
+    
+    template<typename... Args>
+    static void Log(LogLevel level, std::string_view format, const Args&... args) {
+        if (!IsEnabled(level)) return;
+        
+        LogDetail::Record record;
+        record.level = level;
+        record.ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+        LogDetail::Packer packer(record.payload, LogDetail::Record::kPayloadBytes);
+        LogDetail::Pack(packer, format, args...);
+        if (!packer.Fits()) {
+            record.overflow = std::make_unique<std::string>(packer.GetSize(), '\0');
+            LogDetail::Packer heap(record.overflow->data(), record.overflow->size());
+            LogDetail::Pack(heap, format, args...);
+        }
+        record.size = static_cast<uint32_t>(packer.GetSize());
+        Submit(std::move(record));
+    }
+
 private:
+    friend struct std::default_delete<Logger>;   // Owns s_Instance
     Logger();
     ~Logger();
     
     static Logger* GetInstance();
-    void LogMessage(LogLevel level, const std::string& message);
-    
-    template<typename... Args>
-    static std::string FormatString(const std::string& format, Args... args) {
-        // Simplified formatting - in production use fmt library
-        std::stringstream ss;
-        ss << format;
-        return ss.str();
-    }
+    static void Submit(LogDetail::Record&& record);
     
+    LogDetail::ThreadBuffer& GetThreadBuffer();
+    void Wake();
+    void WaitDrained();
+    void Run();
+    void Drain(std::vector<LogDetail::Record>& batch);
+
 private:
     static std::unique_ptr<Logger> s_Instance;
-    LogLevel m_Level;
+    static std::atomic<Logger*> s_Active;
+    static std::atomic<int> s_Level;
+    
+    const uint64_t m_Generation;   // Tells thread buffers of an earlier Init apart
+    std::chrono::system_clock::duration m_ClockOffset;   // Wall clock less steady clock
+    
+    std::mutex m_BuffersMutex;
+    std::vector<std::shared_ptr<LogDetail::ThreadBuffer>> m_Buffers;
+    
+    std::mutex m_SinksMutex;
+    std::vector<std::shared_ptr<LogSink>> m_Sinks;
+    std::shared_ptr<RingLogSink> m_Ring;
+    
+    std::mutex m_WakeMutex;
+    std::condition_variable m_WakeCondition;
+    std::condition_variable m_DrainedCondition;
+    bool m_Stop = false;
+    bool m_Urgent = false;
+    uint64_t m_FlushRequested = 0;
+    uint64_t m_FlushDone = 0;
+    std::thread m_Thread;
 };
 
 // Macros for easy logging
-#define LOG_TRACE(...)    Logger::Log(LogLevel::TRACE, __VA_ARGS__)
-#define LOG_DEBUG(...)    Logger::Log(LogLevel::DEBUG, __VA_ARGS__)
-#define LOG_INFO(...)     Logger::Log(LogLevel::INFO, __VA_ARGS__)
-#define LOG_WARN(...)     Logger::Log(LogLevel::WARN, __VA_ARGS__)
-#define LOG_ERROR(...)    Logger::Log(LogLevel::ERROR, __VA_ARGS__)
-#define LOG_CRITICAL(...) Logger::Log(LogLevel::CRITICAL, __VA_ARGS__)
\ No newline at end of file
+#define LOG_AT(level, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) >= LOG_ACTIVE_LEVEL) { \
+            Logger::Log(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_TRACE(...)    LOG_AT(LogLevel::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...)    LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)     LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...)     LOG_AT(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...)    LOG_AT(LogLevel::ERROR, __VA_ARGS__)
+#define LOG_CRITICAL(...) LOG_AT(LogLevel::CRITICAL, __VA_ARGS__)
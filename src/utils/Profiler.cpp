@@ -0,0 +1,270 @@
+#include "utils/Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+std::atomic<bool> Profiler::s_Enabled{true};
+
+namespace {
+
+const char kKindTags[] = {'c', 'g', 'n'};
+
+std::string EscapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+Profiler& Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::BeginFrame() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_FrameThread = std::this_thread::get_id();
+    m_FrameBegin = Now();
+    
+    // Left by a frame that never ended
+    for (Series& series : m_Series) {
+        series.pending = 0.0;
+        series.sampled = false;
+    }
+}
+
+void Profiler::EndFrame() {
+    if (m_FrameBegin) {
+        AddCpuTime("Frame", m_FrameBegin, Now());
+    }
+    
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (Series& series : m_Series) {
+        if (series.sampled) {
+            Push(series, series.pending);
+            series.pending = 0.0;
+            series.sampled = false;
+        }
+    }
+    m_FrameBegin = 0;
+}
+
+void Profiler::AddCpuTime(const char* name, int64_t begin, int64_t end) {
+    const double milliseconds = static_cast<double>(end - begin) * 1e-6;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const size_t index = FindSeries(name, ProfileSeries::Kind::CPU);
+    Series& series = m_Series[index];
+    if (std::this_thread::get_id() == m_FrameThread) {
+        series.pending += milliseconds;
+        series.sampled = true;
+    } else {
+        Push(series, milliseconds);
+    }
+    if (IsCapturing()) {
+        Record(index, GetThreadNumber(), begin, end - begin, 0.0);
+    }
+}
+
+void Profiler::AddGpuTime(const char* name, int64_t issued, double milliseconds) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const size_t index = FindSeries(name, ProfileSeries::Kind::GPU);
+    Series& series = m_Series[index];
+    series.pending += milliseconds;
+    series.sampled = true;
+    if (IsCapturing()) {
+        Record(index, kGpuThread, issued, static_cast<int64_t>(milliseconds * 1e6), 0.0);
+    }
+}
+
+void Profiler::SetCounter(const char* name, double value) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const size_t index = FindSeries(name, ProfileSeries::Kind::COUNTER);
+    Series& series = m_Series[index];
+    series.pending = value;
+    series.sampled = true;
+    if (IsCapturing()) {
+        Record(index, 0, Now(), 0, value);
+    }
+}
+
+size_t Profiler::FindSeries(const char* name, ProfileSeries::Kind kind) {
+    std::string key(1, kKindTags[static_cast<int>(kind)]);
+    key += name;
+    auto found = m_SeriesIndex.find(key);
+    if (found != m_SeriesIndex.end()) {
+        return found->second;
+    }
+    
+    Series series;
+    series.data.name = name;
+    series.data.kind = kind;
+    series.data.history.reserve(kHistoryFrames);
+    m_Series.push_back(std::move(series));
+    m_SeriesIndex.emplace(std::move(key), m_Series.size() - 1);
+    return m_Series.size() - 1;
+}
+
+void Profiler::Push(Series& series, double value) {
+    std::vector<float>& history = series.data.history;
+    const float sample = static_cast<float>(value);
+    if (history.size() < kHistoryFrames) {
+        history.push_back(sample);
+    } else {
+        history[series.next] = sample;
+        series.next = (series.next + 1) % kHistoryFrames;
+    }
+    series.data.last = sample;
+    ++series.data.samples;
+}
+
+void Profiler::Record(size_t series, uint32_t thread, int64_t begin, int64_t duration, double number) {
+    if (m_Events.size() >= kMaxTraceEvents) {
+        ++m_DroppedEvents;
+        return;
+    }
+    m_Events.push_back({static_cast<uint32_t>(series), thread, begin, duration, number});
+}
+
+uint32_t Profiler::GetThreadNumber() {
+    const std::thread::id id = std::this_thread::get_id();
+    auto found = std::find(m_Threads.begin(), m_Threads.end(), id);
+    if (found != m_Threads.end()) {
+        return static_cast<uint32_t>(found - m_Threads.begin());
+    }
+    m_Threads.push_back(id);
+    return static_cast<uint32_t>(m_Threads.size() - 1);
+}
+
+std::vector<ProfileSeries> Profiler::GetSeries() const {
+    std::vector<ProfileSeries> result;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        result.reserve(m_Series.size());
+        for (const Series& series : m_Series) {
+            ProfileSeries copy = series.data;
+            std::rotate(copy.history.begin(), copy.history.begin() + static_cast<std::ptrdiff_t>(series.next),
+                        copy.history.end());
+            result.push_back(std::move(copy));
+        }
+    }
+    
+    for (ProfileSeries& series : result) {
+        double sum = 0.0;
+        float peak = 0.0f;
+        for (float value : series.history) {
+            sum += value;
+            peak = std::max(peak, value);
+        }
+        series.average = series.history.empty() ? 0.0f : static_cast<float>(sum / series.history.size());
+        series.peak = peak;
+    }
+    std::stable_sort(result.begin(), result.end(), [](const ProfileSeries& a, const ProfileSeries& b) {
+        return static_cast<int>(a.kind) < static_cast<int>(b.kind);
+    });
+    return result;
+}
+
+void Profiler::Reset() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Series.clear();
+    m_SeriesIndex.clear();
+    m_Events.clear();
+    m_DroppedEvents = 0;
+}
+
+void Profiler::StartCapture() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Events.clear();
+    m_DroppedEvents = 0;
+    m_Threads.clear();
+    if (m_FrameThread != std::thread::id()) {
+        m_Threads.push_back(m_FrameThread);   // Thread 0 in the trace
+    }
+    m_Capturing.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::StopCapture() {
+    m_Capturing.store(false, std::memory_order_relaxed);
+}
+
+size_t Profiler::GetCapturedEventCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Events.size();
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const {
+    std::vector<TraceEvent> events;
+    std::vector<std::string> names;
+    std::vector<ProfileSeries::Kind> kinds;
+    size_t threadCount = 0;
+    size_t dropped = 0;
+    std::thread::id frameThread;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        events = m_Events;
+        for (const Series& series : m_Series) {
+            names.push_back(EscapeJson(series.data.name));
+            kinds.push_back(series.data.kind);
+        }
+        threadCount = m_Threads.size();
+        dropped = m_DroppedEvents;
+        frameThread = m_FrameThread;
+        if (threadCount > 0 && m_Threads[0] != frameThread) {
+            frameThread = std::thread::id();
+        }
+    }
+    
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    
+    // Microseconds from the first event
+    int64_t origin = events.empty() ? 0 : events.front().begin;
+    for (const TraceEvent& event : events) {
+        origin = std::min(origin, event.begin);
+    }
+    char number[64];
+    auto micros = [&](int64_t nanoseconds) {
+        std::snprintf(number, sizeof(number), "%.3f", static_cast<double>(nanoseconds) * 1e-3);
+        return number;
+    };
+    
+    file << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << dropped << "},\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << kGpuThread
+         << ",\"args\":{\"name\":\"GPU\"}}";
+    for (size_t t = 0; t < threadCount; ++t) {
+        const std::string name = t == 0 && frameThread != std::thread::id() ? "Frame" : "Thread " + std::to_string(t);
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+             << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+    for (const TraceEvent& event : events) {
+        const std::string& name = names[event.series];
+        if (kinds[event.series] == ProfileSeries::Kind::COUNTER) {
+            file << ",\n{\"name\":\"" << name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << micros(event.begin - origin);
+            std::snprintf(number, sizeof(number), "%.17g", event.number);
+            file << ",\"args\":{\"value\":" << number << "}}";
+        } else {
+            file << ",\n{\"name\":\"" << name << "\",\"cat\":\""
+                 << (kinds[event.series] == ProfileSeries::Kind::GPU ? "gpu" : "cpu")
+                 << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                 << ",\"ts\":" << micros(event.begin - origin);
+            file << ",\"dur\":" << micros(event.duration) << "}";
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
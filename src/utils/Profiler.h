@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A named timing or count and its recent samples
+struct ProfileSeries {
+    enum class Kind { CPU, GPU, COUNTER };
+    
+    std::string name;
+    Kind kind = Kind::CPU;
+    std::vector<float> history;   // Oldest first; milliseconds for timings
+    float last = 0.0f;
+    float average = 0.0f;         // Over history
+    float peak = 0.0f;
+    uint64_t samples = 0;         // Ever taken
+};
+
+// Where frame time goes. Scopes on the frame thread, the one calling
+// BeginFrame, add up over a frame and give one sample per frame they ran
+// in; scopes on other threads, such as the loader's, are a sample each.
+// GPU pass times arrive from GpuTimer a few frames late, counters are set
+// at most once a frame. While a capture runs, every scope, pass and
+// counter is also kept as a trace event for WriteChromeTrace.
+class Profiler {
+public:
+    static constexpr size_t kHistoryFrames = 240;
+    static constexpr size_t kMaxTraceEvents = 1u << 20;
+    
+    static Profiler& Get();
+    
+    // Scopes cost a relaxed load while disabled
+    static void SetEnabled(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+    
+    // Nanoseconds on the steady clock, the time base of everything here
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // A frame begun again before it ended is dropped
+    void BeginFrame();
+    void EndFrame();   // Also samples "Frame", the CPU time since BeginFrame
+    
+    // name must outlive the profiler, as string literals do
+    void AddCpuTime(const char* name, int64_t begin, int64_t end);
+    void AddGpuTime(const char* name, int64_t issued, double milliseconds);   // issued: CPU time of the pass
+    void SetCounter(const char* name, double value);
+    
+    // Copies, for display; CPU series first, then GPU, then counters
+    std::vector<ProfileSeries> GetSeries() const;
+    void Reset();
+    
+    void StartCapture();
+    void StopCapture();
+    bool IsCapturing() const { return m_Capturing.load(std::memory_order_relaxed); }
+    size_t GetCapturedEventCount() const;
+    
+    // Trace Event Format, for chrome://tracing and Perfetto
+    bool WriteChromeTrace(const std::string& path) const;
+
+private:
+    struct Series {
+        ProfileSeries data;
+        size_t next = 0;          // Into data.history once it is full
+        double pending = 0.0;
+        bool sampled = false;     // This frame
+    };
+    
+    struct TraceEvent {
+        uint32_t series;
+        uint32_t thread;          // kGpuThread for passes
+        int64_t begin;            // ns
+        int64_t duration;         // ns; counters keep their value in number
+        double number;
+    };
+    
+    static constexpr uint32_t kGpuThread = 0xFFFFFFFFu;
+    
+    size_t FindSeries(const char* name, ProfileSeries::Kind kind);   // m_Mutex held
+    void Push(Series& series, double value);
+    void Record(size_t series, uint32_t thread, int64_t begin, int64_t duration, double number);
+    uint32_t GetThreadNumber();   // m_Mutex held
+
+private:
+    static std::atomic<bool> s_Enabled;
+    
+    mutable std::mutex m_Mutex;
+    std::vector<Series> m_Series;
+    std::unordered_map<std::string, size_t> m_SeriesIndex;   // Keyed by kind and name
+    std::thread::id m_FrameThread;
+    int64_t m_FrameBegin = 0;
+    
+    std::atomic<bool> m_Capturing{false};
+    std::vector<TraceEvent> m_Events;
+    size_t m_DroppedEvents = 0;
+    std::vector<std::thread::id> m_Threads;   // Trace thread numbers
+};
+
+// Times a block into the profiler
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : m_Name(name), m_Begin(Profiler::IsEnabled() ? Profiler::Now() : 0) {}
+    ~ProfileScope() {
+        if (m_Begin) {
+            Profiler::Get().AddCpuTime(m_Name, m_Begin, Profiler::Now());
+        }
+    }
+    
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_Name;
+    int64_t m_Begin;
+};
+
+#define PROFILE_JOIN_IMPL(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded queue from one producer thread to one consumer thread, without
+// locks. The capacity is rounded up to a power of two; TryPush fails when
+// the ring is full and TryPop when it is empty, and neither ever blocks.
+// Each side keeps its own copy of the other's index and reloads it only
+// when the ring looks full or empty, so steady traffic does not bounce
+// the shared cache lines.
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_Slots.resize(size);
+        m_Mask = size - 1;
+    }
+    
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    
+    size_t GetCapacity() const { return m_Slots.size(); }
+    
+    // Producer only
+    bool TryPush(T&& value) {
+        const size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail - m_HeadCache == m_Slots.size()) {
+            m_HeadCache = m_Head.load(std::memory_order_acquire);
+            if (tail - m_HeadCache == m_Slots.size()) {
+                return false;
+            }
+        }
+        m_Slots[tail & m_Mask] = std::move(value);
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer only
+    bool TryPop(T& value) {
+        const size_t head = m_Head.load(std::memory_order_relaxed);
+        if (head == m_TailCache) {
+            m_TailCache = m_Tail.load(std::memory_order_acquire);
+            if (head == m_TailCache) {
+                return false;
+            }
+        }
+        value = std::move(m_Slots[head & m_Mask]);
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Either side; may be stale by the time it returns
+    size_t SizeApprox() const {
+        return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+    
+    std::vector<T> m_Slots;
+    size_t m_Mask = 0;
+    
+    // Consumer's
+    alignas(kCacheLine) std::atomic<size_t> m_Head{0};   // Next slot to pop
+    size_t m_TailCache = 0;
+    
+    // Producer's
+    alignas(kCacheLine) std::atomic<size_t> m_Tail{0};   // Next slot to push
+    size_t m_HeadCache = 0;
+};
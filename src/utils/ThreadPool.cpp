@@ -0,0 +1,134 @@
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace {
+
+struct ParallelForState {
+    std::function<void(size_t, size_t)> body;
+    size_t count = 0;
+    size_t grainSize = 1;
+    size_t chunkCount = 0;
+
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<size_t> finishedChunks{0};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+
+    // Claims chunks until none are left. Safe to call from any thread.
+    void Run() {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1)) < chunkCount) {
+            size_t begin = chunk * grainSize;
+            size_t end = std::min(count, begin + grainSize);
+            try {
+                body(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+            }
+            if (finishedChunks.fetch_add(1) + 1 == chunkCount) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_Stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_Workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto& worker : m_Workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+ThreadPool& ThreadPool::GetGlobal() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize,
+                             const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+
+    grainSize = std::max<size_t>(1, grainSize);
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+    if (chunkCount == 1 || m_Workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    // Shared so that helpers that start after the loop finished stay valid
+    auto state = std::make_shared<ParallelForState>();
+    state->body = body;
+    state->count = count;
+    state->grainSize = grainSize;
+    state->chunkCount = chunkCount;
+
+    size_t helpers = std::min(m_Workers.size(), chunkCount - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        Enqueue([state]() { state->Run(); });
+    }
+
+    state->Run();
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state]() {
+            return state->finishedChunks.load() == state->chunkCount;
+        });
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push(std::move(task));
+    }
+    m_Condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Stopping && m_Tasks.empty()) {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+    }
+}
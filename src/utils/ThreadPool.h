@@ -0,0 +1,51 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool shared by the loaders and mesh builders.
+// ParallelFor lets the calling thread take part, so it can also be called
+// from inside a pool task without deadlocking.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool sized to the hardware concurrency
+    static ThreadPool& GetGlobal();
+
+    size_t GetThreadCount() const { return m_Workers.size(); }
+
+    template<typename F>
+    auto Submit(F&& task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        Enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // Calls body(begin, end) for consecutive ranges covering [0, count).
+    // Ranges hold at least grainSize items; exceptions are rethrown here.
+    void ParallelFor(size_t count, size_t grainSize,
+                     const std::function<void(size_t, size_t)>& body);
+
+private:
+    void Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> m_Workers;
+    std::queue<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Stopping;
+};